@@ -0,0 +1,249 @@
+#include <stdio.h>
+#include "access_log.hpp"
+#include "../uplink/uplink.hpp"
+
+#define ACCESS_LOG_TAG "app_access_log"
+
+static AccessLogRing ring;
+static hal_mutex_t ring_mutex = NULL;
+static bool ring_ready = false;
+static uint32_t last_access_ms = 0;
+static uint32_t oldest_waiting_ms = 0; // When the oldest record not uploaded was appended
+
+static AccessRecord records[ACCESS_LOG_CHUNK_RECORDS]; // Used by the MQTT task only
+static uint8_t chunk[ACCESS_LOG_CHUNK_SIZE];
+
+static volatile bool query_pending = false; // Set by the MQTT callback
+static uint32_t query_from = 0, query_to = 0;
+static bool query_active = false;
+static uint32_t query_next = 0; // Next sequence to examine
+
+#if defined(HAL_LINUX)
+static access_log_append_hook_t append_hook = NULL;
+static void *append_hook_ctx = NULL;
+#endif
+
+static void observe_append(const AccessRecord *record, bool appended)
+{
+#if defined(HAL_LINUX)
+    if (append_hook != NULL)
+    {
+        append_hook(append_hook_ctx, record, appended);
+    }
+#endif
+}
+
+static void on_query(const char *payload)
+{
+    unsigned long from, to;
+    if (sscanf(payload, "%lu %lu", &from, &to) != 2 || from > to)
+    {
+        ESP_LOGW(ACCESS_LOG_TAG, "Malformed access log query ignored");
+        return;
+    }
+    query_from = from;
+    query_to = to;
+    query_pending = true;
+}
+
+/* Reads records under the lock, appends may erase a sector meanwhile */
+static size_t read_records(uint32_t *sequence)
+{
+    hal_mutex_take(ring_mutex, HAL_WAIT_FOREVER);
+    size_t count = access_log_ring_read(&ring, sequence, records, ACCESS_LOG_CHUNK_RECORDS);
+    hal_mutex_give(ring_mutex);
+    return count;
+}
+
+/* Sends one chunk of records matching the query, or the empty end marker */
+static void serve_query()
+{
+    uint32_t sequence = query_next;
+    size_t count = read_records(&sequence);
+
+    // Keep the records of the range, in place; the clock only moves forward
+    size_t matching = 0;
+    bool past_end = count == 0;
+    for (size_t i = 0; i < count && !past_end; i++)
+    {
+        if (records[i].flags & ACCESS_FLAG_UPTIME)
+        {
+            continue;
+        }
+        past_end = records[i].time > query_to;
+        if (!past_end && records[i].time >= query_from)
+        {
+            records[matching++] = records[i];
+        }
+    }
+
+    size_t encoded = 0;
+    size_t length = access_log_encode(records, matching, chunk, sizeof(chunk), &encoded);
+    if (length > 0 && !uplink_publish_binary(TOPIC_ACCESS_LOG_RESULT, chunk, length))
+    {
+        return; // Retried on the next call
+    }
+    if (encoded < matching)
+    {
+        query_next = records[encoded].sequence; // The rest did not fit in the chunk
+        return;
+    }
+    query_next = sequence;
+    if (past_end && uplink_publish_binary(TOPIC_ACCESS_LOG_RESULT, chunk, 0))
+    {
+        query_active = false;
+        ESP_LOGI(ACCESS_LOG_TAG, "Access log query answered");
+    }
+}
+
+/* Sends the records not uploaded yet, a mark in flash follows every chunk sent */
+static void upload()
+{
+    for (int sent = 0; sent < ACCESS_LOG_UPLOAD_CHUNKS; sent++)
+    {
+        hal_mutex_take(ring_mutex, HAL_WAIT_FOREVER);
+        uint32_t sequence = ring.upload_next;
+        hal_mutex_give(ring_mutex);
+
+        size_t count = read_records(&sequence);
+        if (count == 0) // Only marks or torn records left, nothing to send
+        {
+            hal_mutex_take(ring_mutex, HAL_WAIT_FOREVER);
+            ring.upload_next = sequence > ring.upload_next ? sequence : ring.upload_next;
+            hal_mutex_give(ring_mutex);
+            return;
+        }
+
+        size_t encoded = 0;
+        size_t length = access_log_encode(records, count, chunk, sizeof(chunk), &encoded);
+        if (!uplink_publish_binary(TOPIC_ACCESS_LOG, chunk, length))
+        {
+            return;
+        }
+
+        uint32_t next = encoded < count ? records[encoded].sequence : sequence;
+        hal_mutex_take(ring_mutex, HAL_WAIT_FOREVER);
+        bool done = next >= ring.next_sequence;
+        bool marked = access_log_ring_mark_uploaded(&ring, next);
+        hal_mutex_give(ring_mutex);
+        if (!marked)
+        {
+            ESP_LOGE(ACCESS_LOG_TAG, "Failed to write the upload mark");
+            return;
+        }
+        ESP_LOGI(ACCESS_LOG_TAG, "Uploaded %u access records in %u bytes", (unsigned)encoded, (unsigned)length);
+        if (done)
+        {
+            return;
+        }
+    }
+    oldest_waiting_ms = hal_millis(); // More left, they wait for the next call
+}
+
+bool init_access_log()
+{
+    ring_mutex = hal_mutex_create();
+    if (ring_mutex == NULL)
+    {
+        ESP_LOGE(ACCESS_LOG_TAG, "Failed to create mutex");
+        return false;
+    }
+
+    hal_partition_t partition = hal_partition_find(ACCESS_LOG_PARTITION);
+    if (partition == NULL || !access_log_ring_open(&ring, partition))
+    {
+        ESP_LOGE(ACCESS_LOG_TAG, "Failed to open the access log partition");
+        return false;
+    }
+    ring_ready = true;
+    oldest_waiting_ms = hal_millis();
+
+    hal_clock_sync(ACCESS_LOG_NTP_SERVER); // Records get Unix times once synchronized
+    uplink_subscribe(TOPIC_ACCESS_LOG_QUERY, on_query);
+    ESP_LOGI(ACCESS_LOG_TAG, "Access log opened at sequence %lu, boot %u, %lu records waiting for upload",
+             (unsigned long)ring.next_sequence, ring.boot, (unsigned long)(ring.next_sequence - ring.upload_next));
+    return true;
+}
+
+void handle_access_log()
+{
+    if (!ring_ready || !uplink_is_connected())
+    {
+        return;
+    }
+
+    if (query_pending)
+    {
+        query_pending = false;
+        hal_mutex_take(ring_mutex, HAL_WAIT_FOREVER);
+        query_next = access_log_ring_seek_time(&ring, query_from);
+        hal_mutex_give(ring_mutex);
+        query_active = true;
+    }
+
+    uint32_t now = hal_millis();
+    if (now - last_access_ms < ACCESS_LOG_IDLE_MS)
+    {
+        return;
+    }
+    if (query_active)
+    {
+        serve_query();
+        return;
+    }
+
+    hal_mutex_take(ring_mutex, HAL_WAIT_FOREVER);
+    uint32_t waiting = ring.next_sequence - ring.upload_next; // Upload marks included
+    hal_mutex_give(ring_mutex);
+    if (waiting >= ACCESS_LOG_BATCH_RECORDS || (waiting > 0 && now - oldest_waiting_ms >= ACCESS_LOG_MAX_DELAY_MS))
+    {
+        upload();
+    }
+}
+
+void access_log_record(AccessReader reader, AccessDecision decision, uint64_t credential)
+{
+    if (!ring_ready)
+    {
+        return;
+    }
+
+    AccessRecord record = {};
+    uint64_t now = hal_unix_ms() / 1000;
+    bool clock_set = now >= ACCESS_LOG_CLOCK_VALID;
+    record.time = clock_set ? (uint32_t)now : hal_millis() / 1000;
+    record.flags = clock_set ? 0 : ACCESS_FLAG_UPTIME;
+    record.credential = credential;
+    record.reader = reader;
+    record.decision = decision;
+
+    observe_append(&record, false);
+    hal_mutex_take(ring_mutex, HAL_WAIT_FOREVER);
+    if (ring.next_sequence == ring.upload_next)
+    {
+        oldest_waiting_ms = hal_millis();
+    }
+    uint32_t dropped = ring.dropped;
+    bool ok = access_log_ring_append(&ring, &record);
+    dropped = ring.dropped - dropped;
+    hal_mutex_give(ring_mutex);
+    observe_append(&record, true);
+    last_access_ms = hal_millis();
+
+    if (!ok)
+    {
+        ESP_LOGE(ACCESS_LOG_TAG, "Failed to append access record");
+    }
+    else if (dropped > 0)
+    {
+        ESP_LOGW(ACCESS_LOG_TAG, "Log full, %lu records erased before their upload", (unsigned long)dropped);
+    }
+}
+
+#if defined(HAL_LINUX)
+void access_log_set_append_hook(access_log_append_hook_t hook, void *ctx)
+{
+    append_hook = hook;
+    append_hook_ctx = ctx;
+}
+#endif
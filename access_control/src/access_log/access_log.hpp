@@ -0,0 +1,60 @@
+#pragma once
+
+#include "hal/hal.hpp"
+#include "access_log_ring.hpp"
+
+/* MQTT topics of the access log */
+#define TOPIC_ACCESS_LOG "smarthome/security/access/log"           // Compressed chunks of new records (see access_log_encode())
+#define TOPIC_ACCESS_LOG_QUERY "smarthome/security/access/query"   // "<from> <to>", Unix times in seconds
+#define TOPIC_ACCESS_LOG_RESULT "smarthome/security/access/result" // Chunks answering a query, an empty payload ends it
+
+#define ACCESS_LOG_PARTITION "accesslog" // Data partition of the log (see partitions.csv)
+#define ACCESS_LOG_NTP_SERVER "pool.ntp.org"
+#define ACCESS_LOG_CLOCK_VALID 1700000000UL // Earlier Unix times mean the clock is not set yet
+#define ACCESS_LOG_IDLE_MS 2000             // Quiet time after an access before uploading
+#define ACCESS_LOG_BATCH_RECORDS 32         // Records waiting that start an upload
+#define ACCESS_LOG_MAX_DELAY_MS 60000       // Longest time a record waits for its upload
+#define ACCESS_LOG_CHUNK_SIZE 1024          // Largest chunk, below NETWORK_MQTT_BUFFER_SIZE
+#define ACCESS_LOG_CHUNK_RECORDS 128        // Records read to fill a chunk
+#define ACCESS_LOG_UPLOAD_CHUNKS 4          // Chunks sent per call of handle_access_log()
+
+/**
+ * @brief Opens the log in flash, starts the clock synchronization and subscribes to queries.
+ *
+ * @return true if initialization was successful, false otherwise.
+ */
+bool init_access_log();
+
+/**
+ * @brief Uploads new records in batches and answers queries, called periodically.
+ *
+ * New records are uploaded once ACCESS_LOG_BATCH_RECORDS are waiting or
+ * the oldest waited ACCESS_LOG_MAX_DELAY_MS, and only after
+ * ACCESS_LOG_IDLE_MS without an access, so uploads never compete with a
+ * user at the door.
+ */
+void handle_access_log();
+
+/**
+ * @brief Appends an access decision to the log.
+ *
+ * Costs one flash write; nothing is sent until the next upload.
+ *
+ * @param reader Reader that took the decision.
+ * @param decision Outcome.
+ * @param credential Card key or PIN salt prefix, 0 if unknown.
+ */
+void access_log_record(AccessReader reader, AccessDecision decision, uint64_t credential);
+
+#if defined(HAL_LINUX)
+/// Called right before an append (appended == false) and right after it (appended == true).
+typedef void (*access_log_append_hook_t)(void *ctx, const AccessRecord *record, bool appended);
+
+/**
+ * @brief Installs a hook observing the appends on the host (NULL to remove it).
+ *
+ * @param hook Function called around every append.
+ * @param ctx Argument passed to the hook.
+ */
+void access_log_set_append_hook(access_log_append_hook_t hook, void *ctx);
+#endif
@@ -0,0 +1,501 @@
+#include <string.h>
+#include "access_log_ring.hpp"
+
+#define ACCESS_LOG_ERASED 0xFFFFFFFFU
+#define ACCESS_LOG_READ_BLOCK 8       // Records read from flash at once
+#define ACCESS_LOG_CHUNK_VERSION 1
+#define ACCESS_LOG_RECENT 6           // Credentials referenced by index in a chunk
+#define ACCESS_LOG_RECORD_MAX_BYTES 24 // Longest encoded record
+
+/* CRC-16/CCITT-FALSE */
+static uint16_t crc16(const uint8_t *data, size_t length)
+{
+    uint16_t crc = 0xFFFF;
+    for (size_t i = 0; i < length; i++)
+    {
+        crc ^= (uint16_t)data[i] << 8;
+        for (int bit = 0; bit < 8; bit++)
+        {
+            crc = crc & 0x8000 ? (crc << 1) ^ 0x1021 : crc << 1;
+        }
+    }
+    return crc;
+}
+
+static uint16_t record_crc(const AccessRecord *record)
+{
+    return crc16((const uint8_t *)record, offsetof(AccessRecord, crc));
+}
+
+static bool is_valid(const AccessRecord *record)
+{
+    return record->sequence != ACCESS_LOG_ERASED && record->crc == record_crc(record);
+}
+
+static bool is_erased(const AccessRecord *record)
+{
+    const uint8_t *bytes = (const uint8_t *)record;
+    for (size_t i = 0; i < sizeof(AccessRecord); i++)
+    {
+        if (bytes[i] != 0xFF)
+        {
+            return false;
+        }
+    }
+    return true;
+}
+
+static uint32_t slot_count(const AccessLogRing *ring)
+{
+    return ring->sectors * ACCESS_LOG_RECORDS_PER_SECTOR;
+}
+
+static size_t slot_offset(uint32_t slot)
+{
+    return (slot / ACCESS_LOG_RECORDS_PER_SECTOR) * HAL_FLASH_SECTOR_SIZE +
+           (slot % ACCESS_LOG_RECORDS_PER_SECTOR) * sizeof(AccessRecord);
+}
+
+/* Slots read at once from a slot, blocks never cross a sector */
+static size_t block_length(uint32_t slot)
+{
+    size_t left = ACCESS_LOG_RECORDS_PER_SECTOR - slot % ACCESS_LOG_RECORDS_PER_SECTOR;
+    return left < ACCESS_LOG_READ_BLOCK ? left : ACCESS_LOG_READ_BLOCK;
+}
+
+/* Reads consecutive slots of one sector */
+static bool read_slots(const AccessLogRing *ring, uint32_t slot, AccessRecord *records, size_t count)
+{
+    return hal_partition_read(ring->partition, slot_offset(slot), records, count * sizeof(AccessRecord));
+}
+
+/* First record of a sector, false if the sector is erased or starts with a torn record */
+static bool sector_first(const AccessLogRing *ring, uint16_t sector, AccessRecord *record)
+{
+    return read_slots(ring, sector * ACCESS_LOG_RECORDS_PER_SECTOR, record, 1) && is_valid(record);
+}
+
+/* Sector holding a sequence, or the oldest sector when the sequence is older than the log */
+static uint16_t find_sector(const AccessLogRing *ring, uint32_t sequence)
+{
+    uint16_t best = ring->sectors;
+    uint32_t best_sequence = 0;
+    uint16_t oldest = 0;
+    uint32_t oldest_sequence = ACCESS_LOG_ERASED;
+    for (uint16_t sector = 0; sector < ring->sectors; sector++)
+    {
+        AccessRecord first;
+        if (!sector_first(ring, sector, &first))
+        {
+            continue;
+        }
+        if (first.sequence <= sequence && (best == ring->sectors || first.sequence > best_sequence))
+        {
+            best = sector;
+            best_sequence = first.sequence;
+        }
+        if (first.sequence < oldest_sequence)
+        {
+            oldest = sector;
+            oldest_sequence = first.sequence;
+        }
+    }
+    return best != ring->sectors ? best : oldest;
+}
+
+bool access_log_ring_open(AccessLogRing *ring, hal_partition_t partition)
+{
+    memset(ring, 0, sizeof(*ring));
+    ring->partition = partition;
+    ring->sectors = hal_partition_size(partition) / HAL_FLASH_SECTOR_SIZE;
+    if (ring->sectors < 2)
+    {
+        return false;
+    }
+
+    // One pass over every slot: newest record, oldest record, last upload mark and last boot
+    bool empty = true;
+    uint32_t newest = 0, oldest = ACCESS_LOG_ERASED, mark_sequence = 0, upload_next = 0;
+    uint32_t head = 0;
+    uint16_t boot = 0;
+    AccessRecord block[ACCESS_LOG_READ_BLOCK];
+    for (uint32_t slot = 0; slot < slot_count(ring);)
+    {
+        size_t count = block_length(slot);
+        if (!read_slots(ring, slot, block, count))
+        {
+            return false;
+        }
+        for (size_t i = 0; i < count; i++)
+        {
+            const AccessRecord &record = block[i];
+            if (!is_valid(&record))
+            {
+                continue;
+            }
+            if (empty || record.sequence > newest)
+            {
+                newest = record.sequence;
+                head = slot + i + 1;
+                boot = record.boot;
+            }
+            oldest = record.sequence < oldest ? record.sequence : oldest;
+            if ((record.flags & ACCESS_FLAG_MARK) && (mark_sequence == 0 || record.sequence > mark_sequence))
+            {
+                mark_sequence = record.sequence;
+                upload_next = (uint32_t)record.credential;
+            }
+            empty = false;
+        }
+        slot += count;
+    }
+
+    if (empty)
+    {
+        ring->head = 0;
+        ring->next_sequence = 0;
+        ring->oldest = 0;
+        ring->upload_next = 0;
+        ring->boot = 0;
+        return true;
+    }
+
+    // Slots after the newest record in its sector may hold torn writes, skip to the first erased one
+    for (; head % ACCESS_LOG_RECORDS_PER_SECTOR != 0; head++)
+    {
+        AccessRecord record;
+        if (!read_slots(ring, head, &record, 1))
+        {
+            return false;
+        }
+        if (is_erased(&record))
+        {
+            break;
+        }
+    }
+    ring->head = head % slot_count(ring);
+    ring->next_sequence = newest + 1;
+    ring->oldest = oldest;
+    ring->upload_next = upload_next > oldest ? upload_next : oldest;
+    ring->boot = boot + 1;
+    return true;
+}
+
+bool access_log_ring_append(AccessLogRing *ring, AccessRecord *record)
+{
+    if (ring->head % ACCESS_LOG_RECORDS_PER_SECTOR == 0)
+    {
+        uint16_t sector = ring->head / ACCESS_LOG_RECORDS_PER_SECTOR;
+        AccessRecord first;
+        bool wrapped = sector_first(ring, sector, &first);
+        if (!hal_partition_erase(ring->partition, sector * HAL_FLASH_SECTOR_SIZE, HAL_FLASH_SECTOR_SIZE))
+        {
+            return false;
+        }
+
+        // The erased sector held the oldest records, the next one now does
+        AccessRecord next;
+        uint16_t next_sector = (sector + 1) % ring->sectors;
+        if (wrapped && sector_first(ring, next_sector, &next))
+        {
+            if (ring->upload_next < next.sequence)
+            {
+                ring->dropped += next.sequence - ring->upload_next;
+                ring->upload_next = next.sequence;
+            }
+            ring->oldest = next.sequence;
+        }
+        else if (wrapped)
+        {
+            ring->oldest = ring->next_sequence;
+        }
+    }
+
+    record->sequence = ring->next_sequence;
+    record->boot = ring->boot;
+    record->reserved = 0xFF;
+    record->crc = record_crc(record);
+    if (!hal_partition_write(ring->partition, slot_offset(ring->head), record, sizeof(*record)))
+    {
+        return false;
+    }
+    ring->next_sequence++;
+    ring->head = (ring->head + 1) % slot_count(ring);
+    return true;
+}
+
+size_t access_log_ring_read(const AccessLogRing *ring, uint32_t *sequence, AccessRecord *records, size_t max)
+{
+    if (*sequence >= ring->next_sequence || max == 0)
+    {
+        return 0;
+    }
+
+    size_t found = 0;
+    uint32_t slot = find_sector(ring, *sequence) * ACCESS_LOG_RECORDS_PER_SECTOR;
+    AccessRecord block[ACCESS_LOG_READ_BLOCK];
+    for (uint32_t scanned = 0; scanned < slot_count(ring) && found < max;)
+    {
+        size_t count = block_length(slot);
+        if (!read_slots(ring, slot, block, count))
+        {
+            break;
+        }
+        for (size_t i = 0; i < count && found < max; i++)
+        {
+            const AccessRecord &record = block[i];
+            if (!is_valid(&record) || record.sequence < *sequence)
+            {
+                continue;
+            }
+            *sequence = record.sequence + 1;
+            if (!(record.flags & ACCESS_FLAG_MARK))
+            {
+                records[found++] = record;
+            }
+        }
+        if (*sequence >= ring->next_sequence)
+        {
+            break;
+        }
+        scanned += count;
+        slot = (slot + count) % slot_count(ring);
+    }
+    return found;
+}
+
+uint32_t access_log_ring_seek_time(const AccessLogRing *ring, uint32_t time)
+{
+    uint32_t start = ring->oldest;
+    uint32_t start_time = 0;
+    for (uint16_t sector = 0; sector < ring->sectors; sector++)
+    {
+        AccessRecord first;
+        if (sector_first(ring, sector, &first) && !(first.flags & ACCESS_FLAG_UPTIME) &&
+            first.time <= time && first.time >= start_time && first.sequence >= start)
+        {
+            start = first.sequence;
+            start_time = first.time;
+        }
+    }
+    return start;
+}
+
+bool access_log_ring_mark_uploaded(AccessLogRing *ring, uint32_t next)
+{
+    AccessRecord mark = {};
+    next = next < ring->next_sequence ? next : ring->next_sequence + 1; // All uploaded: the mark itself is not to upload
+    mark.credential = next;
+    mark.flags = ACCESS_FLAG_MARK;
+    if (!access_log_ring_append(ring, &mark))
+    {
+        return false;
+    }
+    ring->upload_next = next > ring->upload_next ? next : ring->upload_next;
+    return true;
+}
+
+/* Chunk encoding */
+
+static size_t put_varint(uint8_t *out, uint64_t value)
+{
+    size_t length = 0;
+    do
+    {
+        uint8_t byte = value & 0x7F;
+        value >>= 7;
+        out[length++] = byte | (value ? 0x80 : 0);
+    } while (value);
+    return length;
+}
+
+static bool get_varint(const uint8_t *in, size_t length, size_t *at, uint64_t *value)
+{
+    *value = 0;
+    for (int shift = 0; shift < 64 && *at < length; shift += 7)
+    {
+        uint8_t byte = in[(*at)++];
+        *value |= (uint64_t)(byte & 0x7F) << shift;
+        if (!(byte & 0x80))
+        {
+            return true;
+        }
+    }
+    return false;
+}
+
+static void put_u32(uint8_t *out, uint32_t value)
+{
+    for (int i = 0; i < 4; i++)
+    {
+        out[i] = (uint8_t)(value >> (8 * i));
+    }
+}
+
+static uint32_t get_u32(const uint8_t *in)
+{
+    return (uint32_t)in[0] | (uint32_t)in[1] << 8 | (uint32_t)in[2] << 16 | (uint32_t)in[3] << 24;
+}
+
+/* Moves a credential to the front of the recent list, returns its previous index or -1 */
+static int recent_use(uint64_t *recent, uint64_t credential)
+{
+    int index = -1;
+    for (int i = 0; i < ACCESS_LOG_RECENT; i++)
+    {
+        if (recent[i] == credential)
+        {
+            index = i;
+            break;
+        }
+    }
+    int move = index >= 0 ? index : ACCESS_LOG_RECENT - 1;
+    memmove(recent + 1, recent, move * sizeof(uint64_t));
+    recent[0] = credential;
+    return index;
+}
+
+/*
+ * Chunk layout: version, record count, then sequence (4 bytes), time
+ * (4 bytes) and boot (2 bytes) of the first record, little endian.
+ * Every record then takes:
+ *   byte     reader (bits 0-1), decision (bits 2-3), uptime flag (bit 4),
+ *            credential (bits 5-7): 0 none, 1 literal, 2-7 recent credential 0-5
+ *   varint   (sequence gap - 1) << 1 | boot changed
+ *   varint   boot increase, if the boot changed
+ *   varint   time difference, zigzag encoded
+ *   varint   credential, if literal
+ */
+size_t access_log_encode(const AccessRecord *records, size_t count, uint8_t *chunk, size_t size, size_t *encoded)
+{
+    *encoded = 0;
+    if (count == 0 || size < ACCESS_LOG_CHUNK_HEADER)
+    {
+        return 0;
+    }
+
+    chunk[0] = ACCESS_LOG_CHUNK_VERSION;
+    put_u32(chunk + 2, records[0].sequence);
+    put_u32(chunk + 6, records[0].time);
+    chunk[10] = (uint8_t)records[0].boot;
+    chunk[11] = (uint8_t)(records[0].boot >> 8);
+    size_t length = ACCESS_LOG_CHUNK_HEADER;
+
+    uint64_t recent[ACCESS_LOG_RECENT] = {};
+    uint32_t sequence = records[0].sequence - 1;
+    uint32_t time = records[0].time;
+    uint16_t boot = records[0].boot;
+    size_t n = 0;
+    for (; n < count && n < ACCESS_LOG_CHUNK_MAX_RECORDS; n++)
+    {
+        const AccessRecord &record = records[n];
+        uint8_t out[ACCESS_LOG_RECORD_MAX_BYTES];
+        uint64_t next_recent[ACCESS_LOG_RECENT]; // Kept only if the record fits, as the decoder will see it
+        memcpy(next_recent, recent, sizeof(recent));
+        uint8_t mode = 0;
+        if (record.credential != 0)
+        {
+            int index = recent_use(next_recent, record.credential);
+            mode = index >= 0 ? 2 + index : 1;
+        }
+
+        out[0] = (record.reader & 0x03) | (record.decision & 0x03) << 2 |
+                 (record.flags & ACCESS_FLAG_UPTIME ? 0x10 : 0) | mode << 5;
+        size_t used = 1;
+        bool new_boot = record.boot != boot;
+        used += put_varint(out + used, (uint64_t)(record.sequence - sequence - 1) << 1 | new_boot);
+        if (new_boot)
+        {
+            used += put_varint(out + used, (uint16_t)(record.boot - boot));
+        }
+        int32_t delta = (int32_t)(record.time - time);
+        used += put_varint(out + used, (uint32_t)((delta << 1) ^ (delta >> 31)));
+        if (mode == 1)
+        {
+            used += put_varint(out + used, record.credential);
+        }
+
+        if (length + used > size)
+        {
+            break;
+        }
+        memcpy(chunk + length, out, used);
+        memcpy(recent, next_recent, sizeof(recent));
+        length += used;
+        sequence = record.sequence;
+        time = record.time;
+        boot = record.boot;
+    }
+
+    chunk[1] = (uint8_t)n;
+    *encoded = n;
+    return length;
+}
+
+size_t access_log_decode(const uint8_t *chunk, size_t length, AccessRecord *records, size_t max)
+{
+    if (length < ACCESS_LOG_CHUNK_HEADER || chunk[0] != ACCESS_LOG_CHUNK_VERSION || chunk[1] > max)
+    {
+        return 0;
+    }
+
+    size_t count = chunk[1];
+    uint32_t sequence = get_u32(chunk + 2) - 1;
+    uint32_t time = get_u32(chunk + 6);
+    uint16_t boot = chunk[10] | chunk[11] << 8;
+    uint64_t recent[ACCESS_LOG_RECENT] = {};
+    size_t at = ACCESS_LOG_CHUNK_HEADER;
+    for (size_t n = 0; n < count; n++)
+    {
+        if (at >= length)
+        {
+            return 0;
+        }
+        uint8_t head = chunk[at++];
+        uint64_t gap, value;
+        if (!get_varint(chunk, length, &at, &gap))
+        {
+            return 0;
+        }
+        if (gap & 1)
+        {
+            if (!get_varint(chunk, length, &at, &value))
+            {
+                return 0;
+            }
+            boot += (uint16_t)value;
+        }
+        if (!get_varint(chunk, length, &at, &value))
+        {
+            return 0;
+        }
+        int32_t delta = (int32_t)((uint32_t)value >> 1) ^ -(int32_t)(value & 1);
+
+        AccessRecord &record = records[n];
+        memset(&record, 0, sizeof(record));
+        uint8_t mode = head >> 5;
+        if (mode == 1)
+        {
+            if (!get_varint(chunk, length, &at, &record.credential))
+            {
+                return 0;
+            }
+            recent_use(recent, record.credential);
+        }
+        else if (mode >= 2)
+        {
+            record.credential = recent[mode - 2];
+            recent_use(recent, record.credential);
+        }
+
+        sequence += (uint32_t)(gap >> 1) + 1;
+        time += delta;
+        record.sequence = sequence;
+        record.time = time;
+        record.boot = boot;
+        record.reader = head & 0x03;
+        record.decision = (head >> 2) & 0x03;
+        record.flags = head & 0x10 ? ACCESS_FLAG_UPTIME : 0;
+    }
+    return at == length ? count : 0;
+}
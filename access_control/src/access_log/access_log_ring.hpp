@@ -0,0 +1,155 @@
+#pragma once
+
+/*
+ * Append-only log of access decisions in a raw flash partition.
+ *
+ * Records are 24 bytes and fill the sectors of the partition in turn.
+ * A sector is erased only when the log wraps around to it, which drops its
+ * records, the oldest ones: every sector is erased once per pass over the
+ * partition, so wear is spread evenly and grows with the number of
+ * records only. Nothing is ever rewritten in place. Uploads are recorded
+ * by appending a mark record holding the next sequence to upload, so
+ * after a reboot the log resumes both appending and uploading where it
+ * stopped. A record torn by a reset fails its CRC and is skipped.
+ *
+ * Records are sent in chunks compressed with access_log_encode(): small
+ * deltas of sequence and time, and recently seen credentials replaced by
+ * a reference, typically take 3 to 4 bytes per record instead of 24.
+ */
+
+#include <stddef.h>
+#include <stdint.h>
+#include "hal/hal.hpp"
+
+#define ACCESS_LOG_RECORDS_PER_SECTOR (HAL_FLASH_SECTOR_SIZE / sizeof(AccessRecord)) // 170
+#define ACCESS_LOG_CHUNK_MAX_RECORDS 255
+#define ACCESS_LOG_CHUNK_HEADER 12 // Version, count, first sequence, time and boot
+
+/// Reader that took the decision.
+enum AccessReader : uint8_t
+{
+    ACCESS_READER_RFID,
+    ACCESS_READER_PINPAD,
+};
+
+/// Outcome of an access attempt.
+enum AccessDecision : uint8_t
+{
+    ACCESS_GRANTED,
+    ACCESS_DENIED,
+    ACCESS_LOCKED_OUT, ///< Refused without checking the credential.
+};
+
+#define ACCESS_FLAG_UPTIME 0x01 // time counts seconds since boot, the clock was not set yet
+#define ACCESS_FLAG_MARK 0x02   // Upload mark, not an access: credential is the next sequence to upload
+
+/// Stored record, 24 bytes.
+struct AccessRecord
+{
+    uint32_t sequence;   ///< Position in the log, 0xFFFFFFFF in erased flash.
+    uint32_t time;       ///< Unix time in seconds, or seconds since boot with ACCESS_FLAG_UPTIME.
+    uint64_t credential; ///< Card key (see credential_uid_key()), PIN salt prefix, 0 if unknown.
+    uint16_t boot;       ///< Boot number, counted since the log was created.
+    uint8_t reader;      ///< AccessReader.
+    uint8_t decision;    ///< AccessDecision.
+    uint8_t flags;       ///< ACCESS_FLAG_* bits.
+    uint8_t reserved;
+    uint16_t crc;        ///< CRC-16 of the fields above.
+};
+
+static_assert(sizeof(AccessRecord) == 24, "AccessRecord is stored as is");
+
+/// Position and counters of an opened log.
+struct AccessLogRing
+{
+    hal_partition_t partition;
+    uint16_t sectors;
+    uint32_t head;          ///< Slot of the next record.
+    uint32_t next_sequence; ///< Sequence of the next record.
+    uint32_t oldest;        ///< Sequence of the oldest record still stored.
+    uint32_t upload_next;   ///< Sequence of the oldest record not uploaded yet.
+    uint16_t boot;          ///< Boot number given to new records.
+    uint32_t dropped;       ///< Records erased before their upload, since the log was opened.
+};
+
+/**
+ * @brief Scans the partition and recovers the position of the log.
+ *
+ * Counts a new boot. An erased partition gives an empty log.
+ *
+ * @param ring Log to open.
+ * @param partition Data partition of at least two sectors.
+ * @return true if the partition could be read, false otherwise.
+ */
+bool access_log_ring_open(AccessLogRing *ring, hal_partition_t partition);
+
+/**
+ * @brief Appends a record.
+ *
+ * Fills in the sequence, boot and CRC, and erases the next sector first
+ * when the current one is full.
+ *
+ * @param ring Opened log.
+ * @param record Record to append, updated with the stored fields.
+ * @return true if the record was written, false on a flash error.
+ */
+bool access_log_ring_append(AccessLogRing *ring, AccessRecord *record);
+
+/**
+ * @brief Reads access records in sequence order, marks are skipped.
+ *
+ * @param ring Opened log.
+ * @param sequence First sequence to read, updated past the records read.
+ * @param records (Output) Records read.
+ * @param max Maximum number of records.
+ * @return Number of records read, 0 once the head is reached.
+ */
+size_t access_log_ring_read(const AccessLogRing *ring, uint32_t *sequence, AccessRecord *records, size_t max);
+
+/**
+ * @brief Finds where to start reading records from a point in time.
+ *
+ * Assumes the clock only moves forward; records without a clock time are ignored.
+ *
+ * @param ring Opened log.
+ * @param time Unix time in seconds.
+ * @return First sequence of the newest sector starting before that time, the oldest sequence if none does.
+ */
+uint32_t access_log_ring_seek_time(const AccessLogRing *ring, uint32_t time);
+
+/**
+ * @brief Records that the records before a sequence were uploaded, by appending a mark.
+ *
+ * A mark recording that everything was uploaded also covers itself, so an
+ * idle log has nothing waiting.
+ *
+ * @param ring Opened log.
+ * @param next Sequence of the first record not uploaded.
+ * @return true if the mark was written, false on a flash error.
+ */
+bool access_log_ring_mark_uploaded(AccessLogRing *ring, uint32_t next);
+
+/**
+ * @brief Compresses records into a chunk.
+ *
+ * Encodes as many records as fit, at most ACCESS_LOG_CHUNK_MAX_RECORDS.
+ *
+ * @param records Records in sequence order.
+ * @param count Number of records.
+ * @param chunk (Output) Compressed chunk.
+ * @param size Size of the chunk buffer, at least ACCESS_LOG_CHUNK_HEADER + 32.
+ * @param encoded (Output) Number of records encoded.
+ * @return Length of the chunk.
+ */
+size_t access_log_encode(const AccessRecord *records, size_t count, uint8_t *chunk, size_t size, size_t *encoded);
+
+/**
+ * @brief Expands a chunk made by access_log_encode(), e.g. on the broker side.
+ *
+ * @param chunk Compressed chunk.
+ * @param length Length of the chunk.
+ * @param records (Output) Records, with crc and reserved set to 0.
+ * @param max Maximum number of records.
+ * @return Number of records decoded, 0 if the chunk is malformed or does not fit.
+ */
+size_t access_log_decode(const uint8_t *chunk, size_t length, AccessRecord *records, size_t max);
@@ -0,0 +1,545 @@
+#include <stdlib.h>
+#include <string.h>
+#include <algorithm>
+#include "hal/hal_sha.hpp"
+#include "credential_store.hpp"
+
+#define CREDENTIAL_DELTA_MAX_PIN_OPS 8 // PIN changes accepted in one delta
+
+static_assert(CREDENTIAL_HASH_LENGTH == HAL_SHA256_LENGTH, "PIN hashes are SHA-256");
+
+/* splitmix64 finalizer, spreads UID keys over the Bloom filter */
+static uint64_t mix(uint64_t key)
+{
+    key ^= key >> 30;
+    key *= 0xBF58476D1CE4E5B9ULL;
+    key ^= key >> 27;
+    key *= 0x94D049BB133111EBULL;
+    key ^= key >> 31;
+    return key;
+}
+
+static void bloom_add(uint32_t *bloom, uint64_t key)
+{
+    uint64_t hash = mix(key);
+    uint32_t h1 = (uint32_t)hash;
+    uint32_t h2 = (uint32_t)(hash >> 32) | 1;
+    for (int i = 0; i < CREDENTIAL_BLOOM_HASHES; i++)
+    {
+        uint32_t bit = (h1 + i * h2) & (CREDENTIAL_BLOOM_BITS - 1);
+        bloom[bit >> 5] |= 1UL << (bit & 31);
+    }
+}
+
+static bool bloom_test(const uint32_t *bloom, uint64_t key)
+{
+    uint64_t hash = mix(key);
+    uint32_t h1 = (uint32_t)hash;
+    uint32_t h2 = (uint32_t)(hash >> 32) | 1;
+    for (int i = 0; i < CREDENTIAL_BLOOM_HASHES; i++)
+    {
+        uint32_t bit = (h1 + i * h2) & (CREDENTIAL_BLOOM_BITS - 1);
+        if (!(bloom[bit >> 5] & (1UL << (bit & 31))))
+        {
+            return false;
+        }
+    }
+    return true;
+}
+
+static void bloom_rebuild(CredentialStore *store)
+{
+    memset(store->bloom, 0, CREDENTIAL_BLOOM_BITS / 8);
+    for (uint16_t i = 0; i < store->uid_count; i++)
+    {
+        bloom_add(store->bloom, store->uids[i]);
+    }
+}
+
+static bool contains(const uint64_t *keys, uint16_t count, uint64_t key)
+{
+    return std::binary_search(keys, keys + count, key);
+}
+
+bool credential_store_init(CredentialStore *store)
+{
+    memset(store, 0, sizeof(*store));
+    store->uids = (uint64_t *)malloc(CREDENTIAL_MAX_UIDS * sizeof(uint64_t));
+    store->bloom = (uint32_t *)calloc(CREDENTIAL_BLOOM_BITS / 32, sizeof(uint32_t));
+    store->scratch = (uint64_t *)malloc(2 * CREDENTIAL_DELTA_MAX_OPS * sizeof(uint64_t));
+    if (store->uids == NULL || store->bloom == NULL || store->scratch == NULL)
+    {
+        free(store->uids);
+        free(store->bloom);
+        free(store->scratch);
+        memset(store, 0, sizeof(*store));
+        return false;
+    }
+    return true;
+}
+
+void credential_store_clear(CredentialStore *store)
+{
+    store->version = 0;
+    store->uid_count = 0;
+    store->pin_count = 0;
+    memset(store->bloom, 0, CREDENTIAL_BLOOM_BITS / 8);
+}
+
+bool credential_store_load(CredentialStore *store, uint32_t version, const uint64_t *uids, uint16_t uid_count,
+                           const CredentialPin *pins, uint8_t pin_count)
+{
+    if (uid_count > CREDENTIAL_MAX_UIDS || pin_count > CREDENTIAL_MAX_PINS)
+    {
+        return false;
+    }
+    for (uint16_t i = 1; i < uid_count; i++)
+    {
+        if (uids[i - 1] >= uids[i])
+        {
+            return false;
+        }
+    }
+
+    if (uids != store->uids)
+    {
+        memcpy(store->uids, uids, uid_count * sizeof(uint64_t));
+    }
+    if (pins != store->pins)
+    {
+        memcpy(store->pins, pins, pin_count * sizeof(CredentialPin));
+    }
+    store->version = version;
+    store->uid_count = uid_count;
+    store->pin_count = pin_count;
+    bloom_rebuild(store);
+    return true;
+}
+
+uint64_t credential_uid_key(const uint8_t *uid, uint8_t length)
+{
+    uint64_t key = 0;
+    if (length <= 7)
+    {
+        for (uint8_t i = 0; i < length; i++)
+        {
+            key = (key << 8) | uid[i];
+        }
+    }
+    else
+    {
+        key = 0xCBF29CE484222325ULL; // FNV-1a
+        for (uint8_t i = 0; i < length; i++)
+        {
+            key = (key ^ uid[i]) * 0x100000001B3ULL;
+        }
+        key &= 0x00FFFFFFFFFFFFFFULL;
+    }
+    return key | ((uint64_t)length << 56);
+}
+
+bool credential_store_has_uid(const CredentialStore *store, uint64_t key)
+{
+    if (!bloom_test(store->bloom, key))
+    {
+        return false;
+    }
+    return contains(store->uids, store->uid_count, key);
+}
+
+bool credential_store_check_pin(const CredentialStore *store, const char *pin, size_t length, uint8_t *match)
+{
+    // salt || PIN, hashed in one call so it fits a single accelerator run
+    uint8_t message[CREDENTIAL_SALT_LENGTH + CREDENTIAL_PIN_MAX_LENGTH];
+    uint8_t matches = 0;
+    uint8_t index = 0;
+    bool valid = length <= CREDENTIAL_PIN_MAX_LENGTH;
+    length = valid ? length : CREDENTIAL_PIN_MAX_LENGTH; // Hashed anyway, same time as a valid PIN
+    memcpy(message + CREDENTIAL_SALT_LENGTH, pin, length);
+
+    for (uint8_t i = 0; i < store->pin_count; i++)
+    {
+        uint8_t hash[CREDENTIAL_HASH_LENGTH];
+        memcpy(message, store->pins[i].salt, CREDENTIAL_SALT_LENGTH);
+        hal_sha256(message, CREDENTIAL_SALT_LENGTH + length, hash);
+
+        uint8_t difference = 0;
+        for (int j = 0; j < CREDENTIAL_HASH_LENGTH; j++)
+        {
+            difference |= hash[j] ^ store->pins[i].hash[j];
+        }
+        uint8_t hit = -(uint8_t)(difference == 0); // 0xFF on a match, no branch
+        matches |= hit;
+        index |= hit & i; // Salts are unique, at most one entry matches
+    }
+    for (volatile uint8_t *byte = message; byte < message + sizeof(message); byte++) // Not optimized away like memset
+    {
+        *byte = 0;
+    }
+    if (match != NULL)
+    {
+        *match = index;
+    }
+    return valid && matches != 0;
+}
+
+/* Delta parsing */
+
+struct DeltaPinOps
+{
+    CredentialPin adds[CREDENTIAL_DELTA_MAX_PIN_OPS];
+    uint8_t add_count;
+    uint8_t removes[CREDENTIAL_DELTA_MAX_PIN_OPS][CREDENTIAL_SALT_LENGTH];
+    uint8_t remove_count;
+};
+
+static int hex_value(char c)
+{
+    if (c >= '0' && c <= '9')
+        return c - '0';
+    if (c >= 'a' && c <= 'f')
+        return c - 'a' + 10;
+    if (c >= 'A' && c <= 'F')
+        return c - 'A' + 10;
+    return -1;
+}
+
+/* Decodes a hex token of at most max bytes, returns the byte count or -1 */
+static int parse_hex(const char *text, size_t length, uint8_t *out, size_t max)
+{
+    if (length == 0 || length % 2 != 0 || length / 2 > max)
+    {
+        return -1;
+    }
+    for (size_t i = 0; i < length; i += 2)
+    {
+        int high = hex_value(text[i]);
+        int low = hex_value(text[i + 1]);
+        if (high < 0 || low < 0)
+        {
+            return -1;
+        }
+        out[i / 2] = (uint8_t)((high << 4) | low);
+    }
+    return (int)(length / 2);
+}
+
+/* Splits the next space separated token off a line */
+static bool next_token(const char **cursor, const char *end, const char **token, size_t *length)
+{
+    const char *p = *cursor;
+    while (p < end && *p == ' ')
+    {
+        p++;
+    }
+    const char *start = p;
+    while (p < end && *p != ' ')
+    {
+        p++;
+    }
+    *token = start;
+    *length = p - start;
+    *cursor = p;
+    return *length > 0;
+}
+
+static bool parse_version(const char *token, size_t length, uint32_t *out)
+{
+    uint32_t value = 0;
+    if (length == 0 || length > 9)
+    {
+        return false;
+    }
+    for (size_t i = 0; i < length; i++)
+    {
+        if (token[i] < '0' || token[i] > '9')
+        {
+            return false;
+        }
+        value = value * 10 + (token[i] - '0');
+    }
+    *out = value;
+    return true;
+}
+
+static int find_pin(const CredentialPin *pins, uint8_t count, const uint8_t *salt)
+{
+    for (uint8_t i = 0; i < count; i++)
+    {
+        if (memcmp(pins[i].salt, salt, CREDENTIAL_SALT_LENGTH) == 0)
+        {
+            return i;
+        }
+    }
+    return -1;
+}
+
+CredentialDeltaResult credential_store_apply_delta(CredentialStore *store, const char *text, size_t length)
+{
+    uint64_t *adds = store->scratch;
+    uint64_t *removes = store->scratch + CREDENTIAL_DELTA_MAX_OPS;
+    uint16_t add_count = 0;
+    uint16_t remove_count = 0;
+    DeltaPinOps pin_ops;
+    pin_ops.add_count = 0;
+    pin_ops.remove_count = 0;
+    bool have_version = false;
+    bool clear = false;
+    uint32_t items = 0; // Lines after the versions
+    uint32_t from = 0;
+    uint32_t to = 0;
+
+    const char *end = text + length;
+    const char *line = text;
+    while (line < end)
+    {
+        const char *line_end = (const char *)memchr(line, '\n', end - line);
+        if (line_end == NULL)
+        {
+            line_end = end;
+        }
+        const char *stop = line_end;
+        if (stop > line && stop[-1] == '\r')
+        {
+            stop--;
+        }
+
+        const char *cursor = line;
+        const char *token;
+        size_t token_length;
+        line = line_end + 1;
+        if (!next_token(&cursor, stop, &token, &token_length))
+        {
+            continue; // Empty line
+        }
+
+        if (!have_version)
+        {
+            const char *from_token, *to_token;
+            size_t from_length, to_length;
+            if (token_length != 1 || token[0] != 'v' ||
+                !next_token(&cursor, stop, &from_token, &from_length) || !parse_version(from_token, from_length, &from) ||
+                !next_token(&cursor, stop, &to_token, &to_length) || !parse_version(to_token, to_length, &to))
+            {
+                return CREDENTIAL_DELTA_INVALID;
+            }
+            have_version = true;
+            continue;
+        }
+
+        if (token_length == 1 && token[0] == 'c')
+        {
+            if (items++ > 0) // Anywhere else it would silently drop the items before it
+            {
+                return CREDENTIAL_DELTA_INVALID;
+            }
+            clear = true;
+            continue;
+        }
+        items++;
+        if (token_length != 2 || (token[0] != '+' && token[0] != '-'))
+        {
+            return CREDENTIAL_DELTA_INVALID;
+        }
+        bool add = token[0] == '+';
+
+        const char *value;
+        size_t value_length;
+        if (!next_token(&cursor, stop, &value, &value_length))
+        {
+            return CREDENTIAL_DELTA_INVALID;
+        }
+
+        if (token[1] == 'u')
+        {
+            uint8_t uid[CREDENTIAL_UID_MAX_LENGTH];
+            int uid_length = parse_hex(value, value_length, uid, sizeof(uid));
+            if (uid_length < 0 || (add ? add_count : remove_count) >= CREDENTIAL_DELTA_MAX_OPS)
+            {
+                return CREDENTIAL_DELTA_INVALID;
+            }
+            uint64_t key = credential_uid_key(uid, uid_length);
+            if (add)
+            {
+                adds[add_count++] = key;
+            }
+            else
+            {
+                // Removes are applied before adds, so a card added earlier in this delta is dropped here
+                add_count = std::remove(adds, adds + add_count, key) - adds;
+                removes[remove_count++] = key;
+            }
+        }
+        else if (token[1] == 'p')
+        {
+            if ((add ? pin_ops.add_count : pin_ops.remove_count) >= CREDENTIAL_DELTA_MAX_PIN_OPS)
+            {
+                return CREDENTIAL_DELTA_INVALID;
+            }
+            uint8_t *salt = add ? pin_ops.adds[pin_ops.add_count].salt : pin_ops.removes[pin_ops.remove_count];
+            if (parse_hex(value, value_length, salt, CREDENTIAL_SALT_LENGTH) != CREDENTIAL_SALT_LENGTH)
+            {
+                return CREDENTIAL_DELTA_INVALID;
+            }
+            if (add)
+            {
+                if (!next_token(&cursor, stop, &value, &value_length) ||
+                    parse_hex(value, value_length, pin_ops.adds[pin_ops.add_count].hash, CREDENTIAL_HASH_LENGTH) !=
+                        CREDENTIAL_HASH_LENGTH)
+                {
+                    return CREDENTIAL_DELTA_INVALID;
+                }
+                pin_ops.add_count++;
+            }
+            else
+            {
+                for (uint8_t i = 0; i < pin_ops.add_count;)
+                {
+                    if (memcmp(pin_ops.adds[i].salt, salt, CREDENTIAL_SALT_LENGTH) == 0)
+                    {
+                        pin_ops.adds[i] = pin_ops.adds[--pin_ops.add_count];
+                    }
+                    else
+                    {
+                        i++;
+                    }
+                }
+                pin_ops.remove_count++;
+            }
+        }
+        else
+        {
+            return CREDENTIAL_DELTA_INVALID;
+        }
+    }
+
+    if (!have_version)
+    {
+        return CREDENTIAL_DELTA_INVALID;
+    }
+    if (!clear && from != store->version)
+    {
+        return CREDENTIAL_DELTA_STALE;
+    }
+
+    std::sort(adds, adds + add_count);
+    add_count = std::unique(adds, adds + add_count) - adds;
+    std::sort(removes, removes + remove_count);
+    remove_count = std::unique(removes, removes + remove_count) - removes;
+
+    // Check the capacity before changing anything
+    uint16_t base = clear ? 0 : store->uid_count;
+    uint32_t final_count = base;
+    for (uint16_t i = 0; i < remove_count && !clear; i++)
+    {
+        final_count -= contains(store->uids, base, removes[i]);
+    }
+    for (uint16_t i = 0; i < add_count; i++)
+    {
+        bool present = !clear && contains(store->uids, base, adds[i]) && !contains(removes, remove_count, adds[i]);
+        final_count += !present;
+    }
+    if (final_count > CREDENTIAL_MAX_UIDS)
+    {
+        return CREDENTIAL_DELTA_FULL;
+    }
+
+    uint32_t final_pins = clear ? 0 : store->pin_count;
+    for (uint8_t i = 0; i < pin_ops.remove_count && !clear; i++)
+    {
+        final_pins -= find_pin(store->pins, store->pin_count, pin_ops.removes[i]) >= 0;
+    }
+    for (uint8_t i = 0; i < pin_ops.add_count; i++)
+    {
+        bool present = !clear && find_pin(store->pins, store->pin_count, pin_ops.adds[i].salt) >= 0;
+        for (uint8_t j = 0; j < pin_ops.remove_count && present; j++)
+        {
+            present = memcmp(pin_ops.removes[j], pin_ops.adds[i].salt, CREDENTIAL_SALT_LENGTH) != 0;
+        }
+        final_pins += !present;
+    }
+    if (final_pins > CREDENTIAL_MAX_PINS)
+    {
+        return CREDENTIAL_DELTA_FULL;
+    }
+
+    if (clear)
+    {
+        store->uid_count = 0;
+        store->pin_count = 0;
+    }
+
+    // Remove: single compaction pass over both sorted lists
+    uint16_t kept = 0;
+    for (uint16_t i = 0, r = 0; i < store->uid_count; i++)
+    {
+        while (r < remove_count && removes[r] < store->uids[i])
+        {
+            r++;
+        }
+        if (r < remove_count && removes[r] == store->uids[i])
+        {
+            continue;
+        }
+        store->uids[kept++] = store->uids[i];
+    }
+    store->uid_count = kept;
+
+    // Add: drop keys already present, then merge from the end so nothing is overwritten
+    uint16_t new_count = 0;
+    for (uint16_t i = 0; i < add_count; i++)
+    {
+        if (!contains(store->uids, store->uid_count, adds[i]))
+        {
+            adds[new_count++] = adds[i];
+        }
+    }
+    int32_t write = store->uid_count + new_count - 1;
+    int32_t old_index = store->uid_count - 1;
+    int32_t add_index = new_count - 1;
+    while (add_index >= 0)
+    {
+        if (old_index >= 0 && store->uids[old_index] > adds[add_index])
+        {
+            store->uids[write--] = store->uids[old_index--];
+        }
+        else
+        {
+            store->uids[write--] = adds[add_index--];
+        }
+    }
+    store->uid_count += new_count;
+
+    for (uint8_t i = 0; i < pin_ops.remove_count; i++)
+    {
+        int index = find_pin(store->pins, store->pin_count, pin_ops.removes[i]);
+        if (index >= 0)
+        {
+            store->pins[index] = store->pins[--store->pin_count];
+        }
+    }
+    for (uint8_t i = 0; i < pin_ops.add_count; i++)
+    {
+        int index = find_pin(store->pins, store->pin_count, pin_ops.adds[i].salt);
+        store->pins[index >= 0 ? index : store->pin_count++] = pin_ops.adds[i];
+    }
+
+    store->version = to;
+    bloom_rebuild(store);
+    return CREDENTIAL_DELTA_APPLIED;
+}
+
+uint32_t credential_crc32(uint32_t crc, const void *data, size_t length)
+{
+    const uint8_t *bytes = (const uint8_t *)data;
+    crc = ~crc;
+    for (size_t i = 0; i < length; i++)
+    {
+        crc ^= bytes[i];
+        for (int bit = 0; bit < 8; bit++)
+        {
+            crc = (crc >> 1) ^ (0xEDB88320U & (0U - (crc & 1)));
+        }
+    }
+    return ~crc;
+}
@@ -0,0 +1,150 @@
+#pragma once
+
+/*
+ * Local copy of the credentials allowed to open the door.
+ *
+ * Independent of Arduino: the store only needs memory and SHA-256
+ * (hal_sha256()), so lookups can be timed and deltas replayed anywhere.
+ * RFID UIDs are kept as sorted 64-bit keys behind a Bloom filter that
+ * rejects most unknown cards without touching the array. PINs are kept
+ * as salted SHA-256 hashes, never in clear.
+ */
+
+#include <stddef.h>
+#include <stdint.h>
+
+#define CREDENTIAL_MAX_UIDS 10000
+#define CREDENTIAL_MAX_PINS 64
+#define CREDENTIAL_UID_MAX_LENGTH 10     // Longest ISO 14443 UID
+#define CREDENTIAL_SALT_LENGTH 8
+#define CREDENTIAL_PIN_MAX_LENGTH 12     // Longer PINs never match
+#define CREDENTIAL_HASH_LENGTH 32        // SHA-256
+#define CREDENTIAL_BLOOM_BITS (1UL << 17) // 16 KB, about 0.5% false positives with 10k UIDs
+#define CREDENTIAL_BLOOM_HASHES 4
+#define CREDENTIAL_DELTA_MAX_OPS 256     // UID changes accepted in one delta
+
+/// Salted PIN hash: SHA-256(salt || PIN digits).
+struct CredentialPin
+{
+    uint8_t salt[CREDENTIAL_SALT_LENGTH];
+    uint8_t hash[CREDENTIAL_HASH_LENGTH];
+};
+
+/// Credential store, the arrays are allocated by credential_store_init().
+struct CredentialStore
+{
+    uint32_t version;   ///< Version of the last applied delta, 0 when empty.
+    uint64_t *uids;     ///< Sorted UID keys (see credential_uid_key()).
+    uint16_t uid_count;
+    uint32_t *bloom;    ///< CREDENTIAL_BLOOM_BITS bits.
+    uint64_t *scratch;  ///< Work area of credential_store_apply_delta().
+    CredentialPin pins[CREDENTIAL_MAX_PINS];
+    uint8_t pin_count;
+};
+
+/// Outcome of credential_store_apply_delta().
+enum CredentialDeltaResult : uint8_t
+{
+    CREDENTIAL_DELTA_APPLIED, ///< Store updated to the new version.
+    CREDENTIAL_DELTA_STALE,   ///< Delta does not start at the store version, a full sync is needed.
+    CREDENTIAL_DELTA_INVALID, ///< Malformed delta, store unchanged.
+    CREDENTIAL_DELTA_FULL,    ///< Capacity exceeded, store unchanged.
+};
+
+/**
+ * @brief Allocates an empty store.
+ *
+ * @param store Store to initialize.
+ * @return true if the memory could be allocated, false otherwise.
+ */
+bool credential_store_init(CredentialStore *store);
+
+/**
+ * @brief Empties the store, version goes back to 0.
+ *
+ * @param store Initialized store.
+ */
+void credential_store_clear(CredentialStore *store);
+
+/**
+ * @brief Replaces the content of the store, e.g. with a copy read from flash.
+ *
+ * The arrays may be the store's own arrays, filled in place.
+ *
+ * @param store Initialized store.
+ * @param version Version of the content.
+ * @param uids Sorted UID keys without duplicates.
+ * @param uid_count Number of keys.
+ * @param pins PIN hashes.
+ * @param pin_count Number of PIN hashes.
+ * @return true if the content was loaded, false if it is too large or not sorted.
+ */
+bool credential_store_load(CredentialStore *store, uint32_t version, const uint64_t *uids, uint16_t uid_count,
+                           const CredentialPin *pins, uint8_t pin_count);
+
+/**
+ * @brief Builds the key of a card UID.
+ *
+ * UIDs up to 7 bytes are stored exactly, 10-byte UIDs are folded into
+ * the same 56 bits.
+ *
+ * @param uid UID bytes.
+ * @param length UID length in bytes.
+ * @return Key used by the store.
+ */
+uint64_t credential_uid_key(const uint8_t *uid, uint8_t length);
+
+/**
+ * @brief Checks if a card is allowed.
+ *
+ * @param store Store to search.
+ * @param key Key of the card UID.
+ * @return true if the UID is in the store, false otherwise.
+ */
+bool credential_store_has_uid(const CredentialStore *store, uint64_t key);
+
+/**
+ * @brief Checks if a PIN is allowed.
+ *
+ * Every stored hash is computed and compared in full, so the time taken
+ * does not depend on which entry matches, or on whether one does.
+ *
+ * @param store Store to search.
+ * @param pin PIN digits.
+ * @param length Number of digits.
+ * @param match (Output) Index of the matching hash when the PIN is allowed, may be NULL.
+ * @return true if the PIN matches a stored hash, false otherwise.
+ */
+bool credential_store_check_pin(const CredentialStore *store, const char *pin, size_t length, uint8_t *match);
+
+/**
+ * @brief Applies a delta received from the broker.
+ *
+ * Text format, one item per line:
+ *   v <from> <to>          versions, must come first; <from> must match the store
+ *   c                      clear the store first (full sync, <from> may then be anything),
+ *                          only right after the versions
+ *   +u <uid hex>           add a card
+ *   -u <uid hex>           remove a card
+ *   +p <salt hex> <hash hex> add a PIN hash
+ *   -p <salt hex>          remove the PIN hash with this salt
+ *
+ * Lines apply in order, e.g. a card added then removed ends up absent.
+ * The delta is applied completely or not at all.
+ *
+ * @param store Initialized store.
+ * @param text Delta text.
+ * @param length Text length.
+ * @return Outcome of the update.
+ */
+CredentialDeltaResult credential_store_apply_delta(CredentialStore *store, const char *text, size_t length);
+
+/**
+ * @brief Updates a CRC-32 (IEEE) with more data.
+ *
+ * @param crc CRC of the previous data, 0 to start.
+ * @param data Data to add.
+ * @param length Data length.
+ * @return Updated CRC.
+ */
+uint32_t credential_crc32(uint32_t crc, const void *data, size_t length);
@@ -0,0 +1,370 @@
+#include <errno.h>
+#include <stdio.h>
+#include <string.h>
+#include <algorithm>
+#include "credentials.hpp"
+#include "../uplink/uplink.hpp"
+
+#define CREDENTIALS_TAG "app_credentials"
+
+#define CREDENTIALS_FILE_MAGIC 0x31445243U // "CRD1"
+#define CREDENTIALS_TEMP_FILE CREDENTIALS_FILE ".tmp"
+#define CREDENTIALS_SAVE_DELAY_MS 2000 // Quiet time after the last delta before saving
+#define CREDENTIALS_SAVE_CHUNK 1024    // Bytes copied from the store per lock
+
+static_assert(CREDENTIAL_SALT_LENGTH == sizeof(uint64_t), "A PIN is identified by its salt");
+
+/// Header of the copy in flash, followed by the UID keys and the PIN hashes.
+struct CredentialFileHeader
+{
+    uint32_t magic;
+    uint32_t version;
+    uint16_t uid_count;
+    uint8_t pin_count;
+    uint8_t reserved;
+    uint32_t crc; // CRC-32 of the UID keys and PIN hashes
+};
+
+static CredentialStore store;
+static hal_mutex_t store_mutex = NULL;
+static bool store_ready = false;
+static bool dirty = false; // Changed since the last save
+static uint32_t last_change_ms = 0;
+static bool sync_requested = false;
+static uint8_t save_buffer[CREDENTIALS_SAVE_CHUNK];
+static char file_path[HAL_FS_PATH_MAX];
+static char temp_path[HAL_FS_PATH_MAX];
+
+#if defined(HAL_LINUX)
+static credentials_check_hook_t check_hook = NULL;
+static void *check_hook_ctx = NULL;
+#endif
+
+static void observe_check(bool pin, bool done)
+{
+#if defined(HAL_LINUX)
+    if (check_hook != NULL)
+    {
+        check_hook(check_hook_ctx, pin, done);
+    }
+#endif
+}
+
+static bool load_store()
+{
+    FILE *file = fopen(file_path, "rb");
+    if (file == NULL)
+    {
+        ESP_LOGI(CREDENTIALS_TAG, "No credentials in flash, waiting for a sync");
+        return false;
+    }
+
+    CredentialFileHeader header;
+    bool ok = fread(&header, 1, sizeof(header), file) == sizeof(header) &&
+              header.magic == CREDENTIALS_FILE_MAGIC &&
+              header.uid_count <= CREDENTIAL_MAX_UIDS &&
+              header.pin_count <= CREDENTIAL_MAX_PINS;
+
+    size_t uid_bytes = header.uid_count * sizeof(uint64_t);
+    size_t pin_bytes = header.pin_count * sizeof(CredentialPin);
+    ok = ok && fread(store.uids, 1, uid_bytes, file) == uid_bytes && fread(store.pins, 1, pin_bytes, file) == pin_bytes;
+    fclose(file);
+
+    ok = ok && credential_crc32(credential_crc32(0, store.uids, uid_bytes), store.pins, pin_bytes) == header.crc &&
+         credential_store_load(&store, header.version, store.uids, header.uid_count, store.pins, header.pin_count);
+    if (!ok)
+    {
+        ESP_LOGW(CREDENTIALS_TAG, "Credentials in flash are corrupted, waiting for a sync");
+        credential_store_clear(&store);
+        return false;
+    }
+
+    ESP_LOGI(CREDENTIALS_TAG, "Loaded credentials version %lu: %u cards, %u PINs",
+             (unsigned long)store.version, store.uid_count, store.pin_count);
+    return true;
+}
+
+/* Copies part of the store under the lock, fails if a delta changed it since the save started */
+static bool copy_chunk(uint32_t version, const void *source, size_t length)
+{
+    hal_mutex_take(store_mutex, HAL_WAIT_FOREVER);
+    bool unchanged = store.version == version;
+    if (unchanged)
+    {
+        memcpy(save_buffer, source, length);
+    }
+    hal_mutex_give(store_mutex);
+    return unchanged;
+}
+
+/* Writes the store in small chunks so card lookups never wait for the flash */
+static bool write_section(FILE *file, uint32_t version, const uint8_t *data, size_t length, uint32_t *crc)
+{
+    for (size_t offset = 0; offset < length; offset += CREDENTIALS_SAVE_CHUNK)
+    {
+        size_t chunk = std::min((size_t)CREDENTIALS_SAVE_CHUNK, length - offset);
+        if (!copy_chunk(version, data + offset, chunk) || fwrite(save_buffer, 1, chunk, file) != chunk)
+        {
+            return false;
+        }
+        *crc = credential_crc32(*crc, save_buffer, chunk);
+    }
+    return true;
+}
+
+static bool save_store()
+{
+    CredentialFileHeader header = {};
+    hal_mutex_take(store_mutex, HAL_WAIT_FOREVER);
+    header.magic = CREDENTIALS_FILE_MAGIC;
+    header.version = store.version;
+    header.uid_count = store.uid_count;
+    header.pin_count = store.pin_count;
+    hal_mutex_give(store_mutex);
+
+    FILE *file = fopen(temp_path, "wb");
+    if (file == NULL)
+    {
+        return false;
+    }
+
+    // Header rewritten with the CRC once the content is written
+    uint32_t crc = 0;
+    bool ok = fwrite(&header, 1, sizeof(header), file) == sizeof(header) &&
+              write_section(file, header.version, (const uint8_t *)store.uids, header.uid_count * sizeof(uint64_t), &crc) &&
+              write_section(file, header.version, (const uint8_t *)store.pins, header.pin_count * sizeof(CredentialPin), &crc);
+    header.crc = crc;
+    ok = ok && fseek(file, 0, SEEK_SET) == 0 && fwrite(&header, 1, sizeof(header), file) == sizeof(header);
+    ok = fclose(file) == 0 && ok; // Flushes the buffered writes
+
+    // The previous copy stays in place until the new one is complete
+    if (!ok || (remove(file_path) != 0 && errno != ENOENT) || rename(temp_path, file_path) != 0)
+    {
+        remove(temp_path);
+        return false;
+    }
+    ESP_LOGI(CREDENTIALS_TAG, "Saved credentials version %lu", (unsigned long)header.version);
+    return true;
+}
+
+static void on_delta(const char *payload)
+{
+    hal_mutex_take(store_mutex, HAL_WAIT_FOREVER);
+    CredentialDeltaResult result = credential_store_apply_delta(&store, payload, strlen(payload));
+    uint32_t version = store.version;
+    uint16_t uid_count = store.uid_count;
+    uint8_t pin_count = store.pin_count;
+    hal_mutex_give(store_mutex);
+
+    switch (result)
+    {
+    case CREDENTIAL_DELTA_APPLIED:
+        dirty = true;
+        last_change_ms = hal_millis();
+        ESP_LOGI(CREDENTIALS_TAG, "Credentials updated to version %lu: %u cards, %u PINs",
+                 (unsigned long)version, uid_count, pin_count);
+        break;
+    case CREDENTIAL_DELTA_STALE:
+        ESP_LOGW(CREDENTIALS_TAG, "Delta does not apply to version %lu, requesting a sync", (unsigned long)version);
+        sync_requested = false;
+        break;
+    case CREDENTIAL_DELTA_FULL:
+        ESP_LOGE(CREDENTIALS_TAG, "Delta exceeds the capacity of %d cards / %d PINs", CREDENTIAL_MAX_UIDS, CREDENTIAL_MAX_PINS);
+        break;
+    default:
+        ESP_LOGE(CREDENTIALS_TAG, "Malformed credentials delta ignored");
+        break;
+    }
+}
+
+#ifdef CREDENTIAL_BENCHMARK
+static uint32_t benchmark_seed = 1;
+
+/* Spreads the generated cards and PINs, no need for the hardware RNG here */
+static uint32_t benchmark_random()
+{
+    benchmark_seed ^= benchmark_seed << 13;
+    benchmark_seed ^= benchmark_seed >> 17;
+    benchmark_seed ^= benchmark_seed << 5;
+    return benchmark_seed;
+}
+
+static void benchmark_fill(void *data, size_t length)
+{
+    for (size_t i = 0; i < length; i++)
+    {
+        ((uint8_t *)data)[i] = (uint8_t)benchmark_random();
+    }
+}
+
+/* Times lookups in a store filled with CREDENTIAL_MAX_UIDS random cards and CREDENTIAL_MAX_PINS PINs */
+static void run_benchmark()
+{
+    for (uint16_t i = 0; i < CREDENTIAL_MAX_UIDS; i++)
+    {
+        uint8_t uid[7];
+        benchmark_fill(uid, sizeof(uid));
+        store.uids[i] = credential_uid_key(uid, (i & 1) ? 7 : 4);
+    }
+    std::sort(store.uids, store.uids + CREDENTIAL_MAX_UIDS);
+    uint16_t uid_count = std::unique(store.uids, store.uids + CREDENTIAL_MAX_UIDS) - store.uids;
+    benchmark_fill(store.pins, sizeof(store.pins));
+    credential_store_load(&store, 1, store.uids, uid_count, store.pins, CREDENTIAL_MAX_PINS);
+
+    const int rounds = 1000;
+    uint32_t hit_total = 0, hit_max = 0, miss_total = 0, miss_max = 0;
+    for (int i = 0; i < rounds; i++)
+    {
+        uint64_t known = store.uids[benchmark_random() % uid_count];
+        uint8_t uid[7];
+        benchmark_fill(uid, sizeof(uid));
+        uint64_t unknown = credential_uid_key(uid, 7);
+
+        uint32_t start = hal_micros();
+        bool hit = credential_store_has_uid(&store, known);
+        uint32_t hit_us = hal_micros() - start;
+        start = hal_micros();
+        credential_store_has_uid(&store, unknown);
+        uint32_t miss_us = hal_micros() - start;
+
+        if (!hit)
+        {
+            ESP_LOGE(CREDENTIALS_TAG, "Benchmark lookup failed");
+        }
+        hit_total += hit_us;
+        hit_max = std::max(hit_max, hit_us);
+        miss_total += miss_us;
+        miss_max = std::max(miss_max, miss_us);
+    }
+
+    // Wrong PINs, a hit would not take any longer
+    uint32_t pin_total = 0, pin_max = 0;
+    for (int i = 0; i < rounds / 10; i++)
+    {
+        uint32_t start = hal_micros();
+        credential_store_check_pin(&store, "123456", 6, NULL);
+        uint32_t pin_us = hal_micros() - start;
+        pin_total += pin_us;
+        pin_max = std::max(pin_max, pin_us);
+    }
+
+    // Printed on the console so it is still visible when logs are compiled out
+    hal_console_printf("Credential benchmark: %u cards, known card avg %lu us max %lu us, unknown card avg %lu us max %lu us, "
+                       "PIN against %d hashes avg %lu us max %lu us\n",
+                       uid_count, (unsigned long)(hit_total / rounds), (unsigned long)hit_max,
+                       (unsigned long)(miss_total / rounds), (unsigned long)miss_max, CREDENTIAL_MAX_PINS,
+                       (unsigned long)(pin_total / (rounds / 10)), (unsigned long)pin_max);
+    credential_store_clear(&store);
+}
+#endif
+
+bool init_credentials()
+{
+    store_mutex = hal_mutex_create();
+    if (store_mutex == NULL)
+    {
+        ESP_LOGE(CREDENTIALS_TAG, "Failed to create mutex");
+        return false;
+    }
+
+    if (!credential_store_init(&store))
+    {
+        ESP_LOGE(CREDENTIALS_TAG, "Not enough memory for %d cards", CREDENTIAL_MAX_UIDS);
+        return false;
+    }
+
+    if (!hal_fs_mount() || !hal_fs_path(CREDENTIALS_FILE, file_path, sizeof(file_path)) ||
+        !hal_fs_path(CREDENTIALS_TEMP_FILE, temp_path, sizeof(temp_path)))
+    {
+        ESP_LOGE(CREDENTIALS_TAG, "Failed to mount the file system");
+        return false;
+    }
+
+#ifdef CREDENTIAL_BENCHMARK
+    run_benchmark();
+#endif
+
+    load_store();
+    store_ready = true;
+
+    uplink_subscribe(TOPIC_CREDENTIALS_DELTA, on_delta);
+    ESP_LOGI(CREDENTIALS_TAG, "Credential cache initialized");
+    return true;
+}
+
+void handle_credentials()
+{
+    if (!store_ready)
+    {
+        return;
+    }
+
+    if (!uplink_is_connected())
+    {
+        sync_requested = false; // Ask again after reconnecting, deltas may have been missed
+    }
+    else if (!sync_requested)
+    {
+        hal_mutex_take(store_mutex, HAL_WAIT_FOREVER);
+        uint32_t version = store.version;
+        hal_mutex_give(store_mutex);
+        char value[12];
+        snprintf(value, sizeof(value), "%lu", (unsigned long)version);
+        sync_requested = uplink_publish(TOPIC_CREDENTIALS_REQUEST, value);
+    }
+
+    if (dirty && hal_millis() - last_change_ms >= CREDENTIALS_SAVE_DELAY_MS)
+    {
+        dirty = false;
+        if (!save_store())
+        {
+            // Also happens when a delta arrives during the save, which marks the store dirty again
+            ESP_LOGW(CREDENTIALS_TAG, "Credentials not saved, retrying");
+            dirty = true;
+            last_change_ms = hal_millis();
+        }
+    }
+}
+
+bool credentials_check_uid(const uint8_t *uid, uint8_t length)
+{
+    if (!store_ready)
+    {
+        return false;
+    }
+    observe_check(false, false);
+    uint64_t key = credential_uid_key(uid, length);
+    hal_mutex_take(store_mutex, HAL_WAIT_FOREVER);
+    bool allowed = credential_store_has_uid(&store, key);
+    hal_mutex_give(store_mutex);
+    observe_check(false, true);
+    return allowed;
+}
+
+bool credentials_check_pin(const char *pin, uint64_t *credential)
+{
+    *credential = 0;
+    if (!store_ready)
+    {
+        return false;
+    }
+    observe_check(true, false);
+    uint8_t match;
+    hal_mutex_take(store_mutex, HAL_WAIT_FOREVER);
+    bool allowed = credential_store_check_pin(&store, pin, strlen(pin), &match);
+    if (allowed)
+    {
+        memcpy(credential, store.pins[match].salt, sizeof(*credential));
+    }
+    hal_mutex_give(store_mutex);
+    observe_check(true, true);
+    return allowed;
+}
+
+#if defined(HAL_LINUX)
+void credentials_set_check_hook(credentials_check_hook_t hook, void *ctx)
+{
+    check_hook = hook;
+    check_hook_ctx = ctx;
+}
+#endif
@@ -0,0 +1,56 @@
+#pragma once
+
+#include "hal/hal.hpp"
+#include "credential_store.hpp"
+
+/* MQTT topics of the credential cache */
+#define TOPIC_CREDENTIALS_DELTA "smarthome/security/credentials/delta"     // Deltas from the broker (see credential_store_apply_delta())
+#define TOPIC_CREDENTIALS_REQUEST "smarthome/security/credentials/request" // Current version, asks the broker for newer deltas
+
+#define CREDENTIALS_FILE "/credentials.bin" // Copy of the store in the file system (see hal_fs.hpp)
+
+/**
+ * @brief Loads the credential cache from flash and subscribes to updates.
+ *
+ * A missing or corrupted copy in flash leaves the cache empty until the
+ * broker sends a full sync; it is not an error.
+ *
+ * @return true if initialization was successful, false otherwise.
+ */
+bool init_credentials();
+
+/**
+ * @brief Requests updates after (re)connecting and saves changes to flash, called periodically.
+ */
+void handle_credentials();
+
+/**
+ * @brief Checks a card against the local cache.
+ *
+ * @param uid UID bytes.
+ * @param length UID length in bytes.
+ * @return true if the card is allowed, false otherwise.
+ */
+bool credentials_check_uid(const uint8_t *uid, uint8_t length);
+
+/**
+ * @brief Checks a PIN against the local cache.
+ *
+ * @param pin PIN digits, NUL terminated.
+ * @param credential (Output) Salt of the matching PIN hash, identifying it in the access log; 0 if not allowed.
+ * @return true if the PIN is allowed, false otherwise.
+ */
+bool credentials_check_pin(const char *pin, uint64_t *credential);
+
+#if defined(HAL_LINUX)
+/// Called right before a check (done == false) and right after it (done == true), e.g. to time it.
+typedef void (*credentials_check_hook_t)(void *ctx, bool pin, bool done);
+
+/**
+ * @brief Installs a hook observing the card and PIN checks on the host (NULL to remove it).
+ *
+ * @param hook Function called around every check.
+ * @param ctx Argument passed to the hook.
+ */
+void credentials_set_check_hook(credentials_check_hook_t hook, void *ctx);
+#endif
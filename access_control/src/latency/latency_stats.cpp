@@ -0,0 +1,49 @@
+#include <algorithm>
+#include "hal/hal.hpp"
+#include "latency_stats.hpp"
+
+void latency_record(LatencyStage *stage, uint64_t duration_ns)
+{
+    if (stage->count < LATENCY_MAX_SAMPLES)
+    {
+        stage->samples_ns[stage->count] = duration_ns;
+    }
+    stage->count++;
+}
+
+uint64_t latency_percentile(LatencyStage *stage, uint8_t percent)
+{
+    uint32_t kept = std::min<uint32_t>(stage->count, LATENCY_MAX_SAMPLES);
+    if (kept == 0)
+    {
+        return 0;
+    }
+    std::sort(stage->samples_ns, stage->samples_ns + kept);
+    uint32_t rank = (kept * percent + 99) / 100; // Nearest rank, 1-based
+    return stage->samples_ns[rank > 0 ? rank - 1 : 0];
+}
+
+static const char *const clock_names[] = {"sim", "cpu", "sum"};
+
+/* Microseconds with one decimal, wide enough for the table */
+static void print_us(uint64_t ns)
+{
+    hal_console_printf(" %10lu.%01lu", (unsigned long)(ns / 1000), (unsigned long)(ns % 1000 / 100));
+}
+
+void latency_print(const char *title, LatencyStage *stages, size_t count)
+{
+    hal_console_printf("%s latency (us)\n", title);
+    hal_console_printf("  %-22s %-5s %7s %12s %12s %12s %12s\n", "stage", "clock", "samples", "p50", "p95", "p99", "max");
+    for (size_t i = 0; i < count; i++)
+    {
+        LatencyStage *stage = &stages[i];
+        hal_console_printf("  %-22s %-5s %7lu", stage->name, clock_names[stage->clock],
+                           (unsigned long)stage->count);
+        print_us(latency_percentile(stage, 50));
+        print_us(latency_percentile(stage, 95));
+        print_us(latency_percentile(stage, 99));
+        print_us(latency_percentile(stage, 100));
+        hal_console_printf("\n");
+    }
+}
@@ -0,0 +1,62 @@
+#pragma once
+
+/*
+ * Latency samples per stage of a path, reported as percentiles.
+ *
+ * A path (a card tap, a PIN) is split into stages, each one recording a
+ * duration per occurrence. Stages timed by the simulator (radio, SPI,
+ * debounce, scheduling) and stages timed on the CPU running the code are
+ * kept apart, since host CPU time is only comparable between host runs.
+ * A sum stage adds both kinds over the same occurrence, e.g. until the
+ * door opens.
+ * Percentiles use the nearest rank, so p99 of 200 samples is the second
+ * largest one.
+ */
+
+#include <stddef.h>
+#include <stdint.h>
+
+#define LATENCY_MAX_SAMPLES 256 // Per stage, further samples are counted but not kept
+
+/// Clock a stage is timed with.
+enum LatencyClock : uint8_t
+{
+    LATENCY_SIM, ///< Virtual time of the simulator.
+    LATENCY_CPU, ///< Real time of the host CPU.
+    LATENCY_SUM, ///< Sum of earlier stages of the same occurrence, both clocks.
+};
+
+/// Samples of one stage, in nanoseconds.
+struct LatencyStage
+{
+    const char *name;
+    LatencyClock clock;
+    uint32_t count = 0; ///< Samples recorded, may exceed LATENCY_MAX_SAMPLES.
+    uint64_t samples_ns[LATENCY_MAX_SAMPLES] = {};
+};
+
+/**
+ * @brief Records one occurrence of a stage.
+ *
+ * @param stage Stage.
+ * @param duration_ns Duration of the occurrence.
+ */
+void latency_record(LatencyStage *stage, uint64_t duration_ns);
+
+/**
+ * @brief Returns a percentile of the samples kept, sorting them.
+ *
+ * @param stage Stage.
+ * @param percent Percentile, 0 to 100.
+ * @return Duration in nanoseconds, 0 without samples.
+ */
+uint64_t latency_percentile(LatencyStage *stage, uint8_t percent);
+
+/**
+ * @brief Prints a table of p50, p95, p99 and maximum per stage.
+ *
+ * @param title Name of the path.
+ * @param stages Stages in the order they happen.
+ * @param count Number of stages.
+ */
+void latency_print(const char *title, LatencyStage *stages, size_t count);
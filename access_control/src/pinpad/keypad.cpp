@@ -0,0 +1,183 @@
+#include <string.h>
+#include "hal/hal.hpp"
+#include "keypad.hpp"
+
+#define KEYPAD_TAG "app_keypad"
+
+#define KEYPAD_KEYS (KEYPAD_ROWS * KEYPAD_COLUMNS)
+
+static uint8_t row_pins[KEYPAD_ROWS];
+static uint8_t column_pins[KEYPAD_COLUMNS];
+static char keys[KEYPAD_KEYS];
+static hal_queue_t event_queue = NULL;
+static volatile hal_task_t waiting_task = NULL;
+
+static uint16_t pressed = 0;                // Debounced state, one bit per key
+static uint8_t counters[KEYPAD_KEYS];       // Consecutive scans disagreeing with the debounced state
+static uint32_t first_seen_ms[KEYPAD_KEYS]; // Scan that first saw the key down
+static uint32_t press_count = 0;
+static uint32_t drop_count = 0;
+
+static void on_column_fall(void *arg)
+{
+    (void)arg;
+    if (waiting_task != NULL)
+    {
+        hal_task_notify_from_isr(waiting_task);
+    }
+}
+
+static void set_column_interrupts(bool enable)
+{
+    for (uint8_t c = 0; c < KEYPAD_COLUMNS; c++)
+    {
+        if (enable)
+        {
+            hal_gpio_attach_interrupt(column_pins[c], HAL_EDGE_FALLING, on_column_fall, NULL);
+        }
+        else
+        {
+            hal_gpio_detach_interrupt(column_pins[c]);
+        }
+    }
+}
+
+static void set_rows(int level)
+{
+    for (uint8_t r = 0; r < KEYPAD_ROWS; r++)
+    {
+        hal_gpio_write(row_pins[r], level);
+    }
+}
+
+static bool any_column_low()
+{
+    for (uint8_t c = 0; c < KEYPAD_COLUMNS; c++)
+    {
+        if (hal_gpio_read(column_pins[c]) == HAL_LOW)
+        {
+            return true;
+        }
+    }
+    return false;
+}
+
+/* One pass over the matrix: a row at a time is pulled low, the others float */
+static uint16_t scan()
+{
+    uint16_t down = 0;
+    set_rows(HAL_HIGH);
+    for (uint8_t r = 0; r < KEYPAD_ROWS; r++)
+    {
+        hal_gpio_write(row_pins[r], HAL_LOW);
+        for (uint8_t c = 0; c < KEYPAD_COLUMNS; c++)
+        {
+            if (hal_gpio_read(column_pins[c]) == HAL_LOW)
+            {
+                down |= 1 << (r * KEYPAD_COLUMNS + c);
+            }
+        }
+        hal_gpio_write(row_pins[r], HAL_HIGH);
+    }
+    return down;
+}
+
+/* Debounces every key separately and queues the new presses */
+static void debounce(uint16_t down, uint32_t now_ms)
+{
+    for (uint8_t k = 0; k < KEYPAD_KEYS; k++)
+    {
+        uint16_t bit = 1 << k;
+        if ((down & bit) == (pressed & bit))
+        {
+            counters[k] = 0;
+            continue;
+        }
+        if (counters[k]++ == 0 && (down & bit))
+        {
+            first_seen_ms[k] = now_ms;
+        }
+        if (counters[k] < KEYPAD_DEBOUNCE_SCANS)
+        {
+            continue;
+        }
+
+        counters[k] = 0;
+        pressed ^= bit;
+        if (pressed & bit)
+        {
+            KeyEvent event = {keys[k], first_seen_ms[k]};
+            press_count++;
+            if (!hal_queue_send(event_queue, &event, 0))
+            {
+                drop_count++;
+                ESP_LOGW(KEYPAD_TAG, "Key event queue full, '%c' dropped", event.key);
+            }
+        }
+    }
+}
+
+bool keypad_init(const uint8_t rows[KEYPAD_ROWS], const uint8_t columns[KEYPAD_COLUMNS],
+                 const char keymap[KEYPAD_ROWS][KEYPAD_COLUMNS])
+{
+    event_queue = hal_queue_create(KEYPAD_QUEUE_LENGTH, sizeof(KeyEvent));
+    if (event_queue == NULL)
+    {
+        ESP_LOGE(KEYPAD_TAG, "Failed to create event queue");
+        return false;
+    }
+
+    memcpy(row_pins, rows, KEYPAD_ROWS);
+    memcpy(column_pins, columns, KEYPAD_COLUMNS);
+    memcpy(keys, keymap, KEYPAD_KEYS);
+    for (uint8_t r = 0; r < KEYPAD_ROWS; r++)
+    {
+        hal_gpio_mode(row_pins[r], HAL_OUTPUT_OPEN_DRAIN);
+    }
+    for (uint8_t c = 0; c < KEYPAD_COLUMNS; c++)
+    {
+        hal_gpio_mode(column_pins[c], HAL_INPUT_PULLUP);
+    }
+    set_rows(HAL_LOW);
+
+    ESP_LOGI(KEYPAD_TAG, "Keypad initialized, waiting for key interrupts");
+    return true;
+}
+
+void handle_keypad()
+{
+    waiting_task = hal_task_current();
+
+    // Idle: every key pulls its column low, the first press interrupts
+    set_rows(HAL_LOW);
+    hal_task_wait_notify(0);
+    set_column_interrupts(true);
+    if (!any_column_low()) // A key may have gone down before the interrupts were armed
+    {
+        hal_task_wait_notify(HAL_WAIT_FOREVER);
+    }
+    set_column_interrupts(false);
+
+    // Burst scan until every key is released and debounced
+    while (true)
+    {
+        uint16_t down = scan();
+        debounce(down, hal_millis());
+        if (down == 0 && pressed == 0)
+        {
+            return;
+        }
+        hal_delay_ms(KEYPAD_SCAN_MS);
+    }
+}
+
+bool keypad_get_event(KeyEvent *event, uint32_t timeout_ms)
+{
+    return hal_queue_receive(event_queue, event, timeout_ms);
+}
+
+void keypad_get_stats(uint32_t *presses, uint32_t *dropped)
+{
+    *presses = press_count;
+    *dropped = drop_count;
+}
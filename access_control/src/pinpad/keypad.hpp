@@ -0,0 +1,64 @@
+#pragma once
+
+/*
+ * Interrupt-driven 4x4 matrix keypad on the HAL.
+ *
+ * While no key is down, all rows are pulled low and the pulled-up columns
+ * have falling-edge interrupts armed, so nothing runs. A press wakes the
+ * keypad task, which scans the matrix every KEYPAD_SCAN_MS, debounces
+ * every key separately and queues a timestamped event per press. Once all
+ * keys are released it goes back to waiting for an interrupt.
+ */
+
+#include <stdint.h>
+
+#define KEYPAD_ROWS 4
+#define KEYPAD_COLUMNS 4
+#define KEYPAD_SCAN_MS 5        // Scan period while a key is down
+#define KEYPAD_DEBOUNCE_SCANS 3 // Consecutive scans a key must agree on to change state
+#define KEYPAD_QUEUE_LENGTH 32  // Presses buffered for the consumer
+
+/// Debounced key press.
+struct KeyEvent
+{
+    char key;
+    uint32_t time_ms; ///< hal_millis() of the first scan that saw the key down.
+};
+
+/**
+ * @brief Configures the matrix pins and the event queue.
+ *
+ * Rows are driven open-drain, columns are inputs with pull-ups.
+ *
+ * @param rows Row GPIOs.
+ * @param columns Column GPIOs.
+ * @param keymap Character of every key, by row and column.
+ * @return true if initialization was successful, false otherwise.
+ */
+bool keypad_init(const uint8_t rows[KEYPAD_ROWS], const uint8_t columns[KEYPAD_COLUMNS],
+                 const char keymap[KEYPAD_ROWS][KEYPAD_COLUMNS]);
+
+/**
+ * @brief Body of the keypad task, called in a loop.
+ *
+ * Blocks until a key goes down, then scans until every key is released.
+ * Must always be called from the same task, which the interrupt notifies.
+ */
+void handle_keypad();
+
+/**
+ * @brief Takes the next key press from the queue.
+ *
+ * @param event (Output) Key press.
+ * @param timeout_ms How long to wait for a press.
+ * @return true if a press was taken, false on timeout.
+ */
+bool keypad_get_event(KeyEvent *event, uint32_t timeout_ms);
+
+/**
+ * @brief Returns the number of presses detected and lost because the queue was full.
+ *
+ * @param presses (Output) Presses since boot.
+ * @param dropped (Output) Presses dropped since boot.
+ */
+void keypad_get_stats(uint32_t *presses, uint32_t *dropped);
@@ -0,0 +1,63 @@
+#if defined(HAL_LINUX)
+
+#include <string.h>
+#include "hal/hal.hpp"
+#include "hal/linux/hal_fake.hpp"
+#include "keypad_sim.hpp"
+
+static uint8_t row_pins[KEYPAD_ROWS];
+static uint8_t column_pins[KEYPAD_COLUMNS];
+static char keys[KEYPAD_ROWS * KEYPAD_COLUMNS];
+static uint16_t down = 0; // Keys held, one bit per key
+
+static void update_columns()
+{
+    for (uint8_t c = 0; c < KEYPAD_COLUMNS; c++)
+    {
+        int level = HAL_HIGH; // Pull-up
+        for (uint8_t r = 0; r < KEYPAD_ROWS; r++)
+        {
+            if ((down & (1 << (r * KEYPAD_COLUMNS + c))) && hal_fake_gpio_get_output(row_pins[r]) == HAL_LOW)
+            {
+                level = HAL_LOW;
+            }
+        }
+        hal_fake_gpio_set_input(column_pins[c], level);
+    }
+}
+
+void keypad_sim_on_write(uint8_t pin, int level, uint64_t time_us, void *ctx)
+{
+    (void)level;
+    (void)time_us;
+    (void)ctx;
+    if (memchr(row_pins, pin, KEYPAD_ROWS) != NULL)
+    {
+        update_columns();
+    }
+}
+
+void keypad_sim_attach(const uint8_t rows[KEYPAD_ROWS], const uint8_t columns[KEYPAD_COLUMNS],
+                       const char keymap[KEYPAD_ROWS][KEYPAD_COLUMNS])
+{
+    memcpy(row_pins, rows, KEYPAD_ROWS);
+    memcpy(column_pins, columns, KEYPAD_COLUMNS);
+    memcpy(keys, keymap, sizeof(keys));
+    down = 0;
+    hal_fake_gpio_set_write_hook(keypad_sim_on_write, NULL);
+    update_columns();
+}
+
+void keypad_sim_set_key(char key, bool down_now)
+{
+    const char *position = (const char *)memchr(keys, key, sizeof(keys));
+    if (position == NULL)
+    {
+        return;
+    }
+    uint16_t bit = 1 << (position - keys);
+    down = down_now ? down | bit : down & ~bit;
+    update_columns();
+}
+
+#endif // HAL_LINUX
@@ -0,0 +1,42 @@
+#pragma once
+
+/*
+ * Model of a 4x4 matrix keypad wired to the fake GPIOs, for host builds.
+ *
+ * A column reads low while a pressed key connects it to a row pulled low,
+ * and changes level (running the column interrupts) as soon as a row is
+ * written or a key changes state. Installs the fake GPIO write hook.
+ */
+
+#if defined(HAL_LINUX)
+
+#include <stdint.h>
+#include "keypad.hpp"
+
+/**
+ * @brief Wires the model to the matrix pins.
+ *
+ * @param rows Row GPIOs.
+ * @param columns Column GPIOs.
+ * @param keymap Character of every key, by row and column.
+ */
+void keypad_sim_attach(const uint8_t rows[KEYPAD_ROWS], const uint8_t columns[KEYPAD_COLUMNS],
+                       const char keymap[KEYPAD_ROWS][KEYPAD_COLUMNS]);
+
+/**
+ * @brief Presses or releases a key.
+ *
+ * @param key Character of the key.
+ * @param down true to press, false to release.
+ */
+void keypad_sim_set_key(char key, bool down);
+
+/**
+ * @brief Write hook installed by keypad_sim_attach().
+ *
+ * A test observing GPIO writes itself installs its own hook after
+ * attaching the model and calls this one from it.
+ */
+void keypad_sim_on_write(uint8_t pin, int level, uint64_t time_us, void *ctx);
+
+#endif // HAL_LINUX
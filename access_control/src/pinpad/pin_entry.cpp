@@ -0,0 +1,177 @@
+#include <ctype.h>
+#include "pin_entry.hpp"
+
+/// Key classes driving the state machine.
+enum PinInput : uint8_t
+{
+    PIN_INPUT_START,      ///< '*'
+    PIN_INPUT_DIGIT,      ///< Digit with room in the buffer.
+    PIN_INPUT_DIGIT_FULL, ///< Digit with the buffer full.
+    PIN_INPUT_SUBMIT,     ///< '#'
+    PIN_INPUT_CANCEL,     ///< 'D'
+    PIN_INPUT_OTHER,      ///< Any other key.
+    PIN_INPUT_TIMEOUT,    ///< No key for PIN_ENTRY_TIMEOUT_MS.
+    PIN_INPUT_COUNT,
+};
+
+enum PinAction : uint8_t
+{
+    PIN_ACTION_NONE,
+    PIN_ACTION_START,   ///< Wipe the buffer and start a PIN.
+    PIN_ACTION_APPEND,  ///< Append the digit.
+    PIN_ACTION_WIPE,    ///< Wipe the buffer, the PIN is too long.
+    PIN_ACTION_SUBMIT,  ///< Hand the PIN over.
+    PIN_ACTION_REJECT,  ///< Report a too long PIN.
+    PIN_ACTION_CANCEL,  ///< Wipe the buffer and report the cancel.
+    PIN_ACTION_TIMEOUT, ///< Wipe the buffer and report the timeout.
+};
+
+struct PinTransition
+{
+    PinEntryState next;
+    PinAction action;
+};
+
+static const PinTransition transitions[PIN_STATE_COUNT][PIN_INPUT_COUNT] = {
+    // Inputs in PinInput order: START, DIGIT, DIGIT_FULL, SUBMIT, CANCEL, OTHER, TIMEOUT
+    {
+        // PIN_STATE_IDLE
+        {PIN_STATE_ENTERING, PIN_ACTION_START},
+        {PIN_STATE_IDLE, PIN_ACTION_NONE},
+        {PIN_STATE_IDLE, PIN_ACTION_NONE},
+        {PIN_STATE_IDLE, PIN_ACTION_NONE},
+        {PIN_STATE_IDLE, PIN_ACTION_NONE},
+        {PIN_STATE_IDLE, PIN_ACTION_NONE},
+        {PIN_STATE_IDLE, PIN_ACTION_NONE},
+    },
+    {
+        // PIN_STATE_ENTERING
+        {PIN_STATE_ENTERING, PIN_ACTION_START},
+        {PIN_STATE_ENTERING, PIN_ACTION_APPEND},
+        {PIN_STATE_OVERFLOW, PIN_ACTION_WIPE},
+        {PIN_STATE_IDLE, PIN_ACTION_SUBMIT},
+        {PIN_STATE_IDLE, PIN_ACTION_CANCEL},
+        {PIN_STATE_ENTERING, PIN_ACTION_NONE},
+        {PIN_STATE_IDLE, PIN_ACTION_TIMEOUT},
+    },
+    {
+        // PIN_STATE_OVERFLOW
+        {PIN_STATE_ENTERING, PIN_ACTION_START},
+        {PIN_STATE_OVERFLOW, PIN_ACTION_NONE},
+        {PIN_STATE_OVERFLOW, PIN_ACTION_NONE},
+        {PIN_STATE_IDLE, PIN_ACTION_REJECT},
+        {PIN_STATE_IDLE, PIN_ACTION_CANCEL},
+        {PIN_STATE_OVERFLOW, PIN_ACTION_NONE},
+        {PIN_STATE_IDLE, PIN_ACTION_TIMEOUT},
+    },
+};
+
+static PinInput classify(const PinEntry *entry, char key)
+{
+    switch (key)
+    {
+    case '*':
+        return PIN_INPUT_START;
+    case '#':
+        return PIN_INPUT_SUBMIT;
+    case 'D':
+        return PIN_INPUT_CANCEL;
+    default:
+        if (!isdigit((unsigned char)key))
+        {
+            return PIN_INPUT_OTHER;
+        }
+        return entry->length < PIN_ENTRY_MAX_DIGITS ? PIN_INPUT_DIGIT : PIN_INPUT_DIGIT_FULL;
+    }
+}
+
+static PinEntryResult step(PinEntry *entry, PinInput input, char key)
+{
+    const PinTransition &transition = transitions[entry->state][input];
+    entry->state = transition.next;
+
+    switch (transition.action)
+    {
+    case PIN_ACTION_START:
+        pin_entry_clear(entry);
+        return PIN_ENTRY_STARTED;
+    case PIN_ACTION_APPEND:
+        entry->digits[entry->length++] = key;
+        return PIN_ENTRY_NONE;
+    case PIN_ACTION_WIPE:
+        pin_entry_clear(entry);
+        return PIN_ENTRY_NONE;
+    case PIN_ACTION_SUBMIT:
+        return entry->length > 0 ? PIN_ENTRY_SUBMITTED : PIN_ENTRY_CANCELED;
+    case PIN_ACTION_REJECT:
+        return PIN_ENTRY_TOO_LONG;
+    case PIN_ACTION_CANCEL:
+        pin_entry_clear(entry);
+        return PIN_ENTRY_CANCELED;
+    case PIN_ACTION_TIMEOUT:
+        pin_entry_clear(entry);
+        return PIN_ENTRY_TIMED_OUT;
+    default:
+        return PIN_ENTRY_NONE;
+    }
+}
+
+PinEntryResult pin_entry_key(PinEntry *entry, char key, uint32_t now_ms)
+{
+    pin_entry_poll(entry, now_ms);
+    entry->last_key_ms = now_ms;
+    return step(entry, classify(entry, key), key);
+}
+
+PinEntryResult pin_entry_poll(PinEntry *entry, uint32_t now_ms)
+{
+    if (entry->state == PIN_STATE_IDLE || now_ms - entry->last_key_ms < PIN_ENTRY_TIMEOUT_MS)
+    {
+        return PIN_ENTRY_NONE;
+    }
+    return step(entry, PIN_INPUT_TIMEOUT, 0);
+}
+
+void pin_entry_clear(PinEntry *entry)
+{
+    volatile char *digits = entry->digits; // Not optimized away like memset
+    for (uint8_t i = 0; i < sizeof(entry->digits); i++)
+    {
+        digits[i] = 0;
+    }
+    entry->length = 0;
+}
+
+uint32_t pin_lockout_remaining_ms(const PinLockout *lockout, uint32_t now_ms)
+{
+    if (lockout->failures < PIN_LOCKOUT_FREE_ATTEMPTS)
+    {
+        return 0;
+    }
+    int32_t remaining = (int32_t)(lockout->until_ms - now_ms);
+    return remaining > 0 ? (uint32_t)remaining : 0;
+}
+
+void pin_lockout_record(PinLockout *lockout, bool granted, uint32_t now_ms)
+{
+    if (granted)
+    {
+        lockout->failures = 0;
+        return;
+    }
+    if (lockout->failures < UINT8_MAX)
+    {
+        lockout->failures++;
+    }
+    if (lockout->failures < PIN_LOCKOUT_FREE_ATTEMPTS)
+    {
+        return;
+    }
+
+    uint32_t duration = PIN_LOCKOUT_BASE_MS;
+    for (uint8_t i = PIN_LOCKOUT_FREE_ATTEMPTS; i < lockout->failures && duration < PIN_LOCKOUT_MAX_MS; i++)
+    {
+        duration *= 2;
+    }
+    lockout->until_ms = now_ms + (duration < PIN_LOCKOUT_MAX_MS ? duration : PIN_LOCKOUT_MAX_MS);
+}
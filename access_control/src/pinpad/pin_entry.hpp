@@ -0,0 +1,108 @@
+#pragma once
+
+/*
+ * PIN entry and lockout, independent of the hardware.
+ *
+ * Entry is a table-driven state machine over a fixed buffer: '*' starts
+ * a PIN, digits are appended, '#' submits it and 'D' cancels it. A PIN
+ * left unfinished for PIN_ENTRY_TIMEOUT_MS is discarded, and a PIN longer
+ * than the buffer is absorbed and rejected as a whole, never truncated.
+ * The buffer is wiped whenever an entry ends.
+ *
+ * The lockout allows PIN_LOCKOUT_FREE_ATTEMPTS wrong PINs in a row, then
+ * refuses to check PINs for a period that doubles with every further
+ * failure, up to PIN_LOCKOUT_MAX_MS.
+ */
+
+#include <stdint.h>
+
+#define PIN_ENTRY_MAX_DIGITS 12
+#define PIN_ENTRY_TIMEOUT_MS 5000 // Longest pause between two keys
+#define PIN_LOCKOUT_FREE_ATTEMPTS 3
+#define PIN_LOCKOUT_BASE_MS 30000 // First lockout
+#define PIN_LOCKOUT_MAX_MS 900000 // Longest lockout, 15 min
+
+/// State of the entry state machine.
+enum PinEntryState : uint8_t
+{
+    PIN_STATE_IDLE,     ///< Waiting for '*'.
+    PIN_STATE_ENTERING, ///< Collecting digits.
+    PIN_STATE_OVERFLOW, ///< Too many digits, waiting for '#' to reject the PIN.
+    PIN_STATE_COUNT,
+};
+
+/// Outcome of a key or of the timeout.
+enum PinEntryResult : uint8_t
+{
+    PIN_ENTRY_NONE,      ///< Nothing to act on.
+    PIN_ENTRY_STARTED,   ///< A new PIN was started.
+    PIN_ENTRY_SUBMITTED, ///< PIN complete, to be checked (see PinEntry::digits).
+    PIN_ENTRY_TOO_LONG,  ///< PIN submitted with more than PIN_ENTRY_MAX_DIGITS digits, counts as wrong.
+    PIN_ENTRY_CANCELED,  ///< Entry canceled, or submitted empty.
+    PIN_ENTRY_TIMED_OUT, ///< Entry discarded after PIN_ENTRY_TIMEOUT_MS without a key.
+};
+
+/// PIN being entered.
+struct PinEntry
+{
+    PinEntryState state;
+    char digits[PIN_ENTRY_MAX_DIGITS + 1]; ///< NUL terminated, valid after PIN_ENTRY_SUBMITTED until pin_entry_clear().
+    uint8_t length;
+    uint32_t last_key_ms;
+};
+
+/// Consecutive wrong PINs and the lockout they caused.
+struct PinLockout
+{
+    uint8_t failures;
+    uint32_t until_ms; ///< End of the current lockout, valid once failures reaches PIN_LOCKOUT_FREE_ATTEMPTS.
+};
+
+/**
+ * @brief Feeds a key to the state machine.
+ *
+ * An entry whose last key is older than PIN_ENTRY_TIMEOUT_MS is discarded
+ * before the key is handled.
+ *
+ * @param entry Entry, zero-initialized before the first key.
+ * @param key Character of the key.
+ * @param now_ms Time of the key press.
+ * @return Outcome of the key.
+ */
+PinEntryResult pin_entry_key(PinEntry *entry, char key, uint32_t now_ms);
+
+/**
+ * @brief Discards the entry if it timed out, called periodically.
+ *
+ * @param entry Entry.
+ * @param now_ms Current time.
+ * @return PIN_ENTRY_TIMED_OUT if the entry was discarded, PIN_ENTRY_NONE otherwise.
+ */
+PinEntryResult pin_entry_poll(PinEntry *entry, uint32_t now_ms);
+
+/**
+ * @brief Wipes the digits, e.g. once a submitted PIN was checked.
+ *
+ * @param entry Entry.
+ */
+void pin_entry_clear(PinEntry *entry);
+
+/**
+ * @brief Checks if PINs may be checked.
+ *
+ * @param lockout Lockout state.
+ * @param now_ms Current time.
+ * @return Milliseconds until the lockout ends, 0 if PINs may be checked.
+ */
+uint32_t pin_lockout_remaining_ms(const PinLockout *lockout, uint32_t now_ms);
+
+/**
+ * @brief Records the outcome of a PIN check.
+ *
+ * A correct PIN clears the failures, a wrong one may start a lockout.
+ *
+ * @param lockout Lockout state.
+ * @param granted true if the PIN was correct.
+ * @param now_ms Time of the check.
+ */
+void pin_lockout_record(PinLockout *lockout, bool granted, uint32_t now_ms);
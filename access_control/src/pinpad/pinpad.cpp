@@ -1,66 +1,149 @@
 #include "pinpad.hpp"
-#include "../mqtt/mqtt.hpp" // Korzystamy z funkcji do wysyłania kodu po MQTT
-#include "esp_log.h"
+#include "../credentials/credentials.hpp"
+#include "../access_log/access_log.hpp"
 
 #define PINPAD_TAG "app_pinpad"
+#define PINPAD_NVS_NAMESPACE "pinpad"
+#define PINPAD_NVS_KEY "lockout"
 
 // Define the actual row and column pins here (the definitions)
-byte ROW_PINS[ROW_NUM] = {13, 12, 14, 27};    // GPIO pins connected to row pins
-byte COL_PINS[COLUMN_NUM] = {26, 25, 33, 32}; // GPIO pins connected to column pins
+const uint8_t ROW_PINS[ROW_NUM] = {13, 12, 14, 27};    // GPIO pins connected to row pins
+const uint8_t COL_PINS[COLUMN_NUM] = {26, 25, 33, 32}; // GPIO pins connected to column pins
 
-// Initialize the keypad object with row pins, column pins, and keymap
-Keypad pinpad = Keypad(makeKeymap(keys), ROW_PINS, COL_PINS, ROW_NUM, COLUMN_NUM);
+static PinEntry entry = {};     // PIN being entered, never leaves this file
+static PinLockout lockout = {}; // Wrong PINs in a row
+static uint32_t grant_end_ms = 0; // LED stays on until then after an accepted PIN
 
-static String current_pin = "";   // Stores the entered PIN
-static bool entering_pin = false; // Indicates if we're in the process of entering a PIN
+/// Lockout as kept in NVS: millis() restarts at boot, so the end is stored as the time left.
+struct SavedLockout
+{
+    uint8_t failures;
+    uint32_t remaining_ms;
+};
+
+static_assert(PIN_ENTRY_MAX_DIGITS <= CREDENTIAL_PIN_MAX_LENGTH, "Every PIN that can be typed can be checked");
+
+/* Restores the lockout of the previous boot, the time left counts from now */
+static void load_lockout(uint32_t now_ms)
+{
+    SavedLockout saved;
+    lockout = {};
+    if (hal_nvs_get(PINPAD_NVS_NAMESPACE, PINPAD_NVS_KEY, &saved, sizeof(saved)))
+    {
+        lockout.failures = saved.failures;
+        lockout.until_ms = now_ms + (saved.remaining_ms < PIN_LOCKOUT_MAX_MS ? saved.remaining_ms : PIN_LOCKOUT_MAX_MS);
+    }
+}
+
+static void save_lockout(uint32_t now_ms)
+{
+    SavedLockout saved = {lockout.failures, pin_lockout_remaining_ms(&lockout, now_ms)};
+    if (!hal_nvs_set(PINPAD_NVS_NAMESPACE, PINPAD_NVS_KEY, &saved, sizeof(saved)))
+    {
+        ESP_LOGE(PINPAD_TAG, "Failed to save the PIN lockout");
+    }
+}
+
+/* Checks the submitted PIN unless locked out, and logs the decision only */
+static void check_pin(uint32_t now_ms, bool too_long)
+{
+    uint32_t locked_ms = pin_lockout_remaining_ms(&lockout, now_ms);
+    if (locked_ms > 0)
+    {
+        pin_entry_clear(&entry);
+        ESP_LOGW(PINPAD_TAG, "Locked out for %lu s, PIN not checked", (unsigned long)(locked_ms / 1000));
+        access_log_record(ACCESS_READER_PINPAD, ACCESS_LOCKED_OUT, 0);
+        return;
+    }
+
+    // A too long PIN is wrong whatever its digits, it was never stored
+    uint64_t credential = 0;
+    uint64_t start_us = hal_micros();
+    bool granted = !too_long && credentials_check_pin(entry.digits, &credential); // Decided locally, works without the broker
+    uint32_t verify_us = (uint32_t)(hal_micros() - start_us);
+    pin_entry_clear(&entry);
+
+    uint8_t failures = lockout.failures;
+    pin_lockout_record(&lockout, granted, now_ms);
+    if (lockout.failures != failures) // Saved before the door opens, a reboot cannot clear it
+    {
+        save_lockout(now_ms);
+    }
+    if (granted)
+    {
+        hal_gpio_write(LED_PIN, HAL_HIGH);
+        grant_end_ms = hal_millis() + PIN_GRANT_MS;
+    }
+    ESP_LOGI(PINPAD_TAG, "Access %s (verified in %lu us)", granted ? "granted" : "denied", (unsigned long)verify_us);
+    if (lockout.failures >= PIN_LOCKOUT_FREE_ATTEMPTS)
+    {
+        ESP_LOGW(PINPAD_TAG, "%u wrong PINs in a row, locked out for %lu s", lockout.failures,
+                 (unsigned long)(pin_lockout_remaining_ms(&lockout, now_ms) / 1000));
+    }
+    access_log_record(ACCESS_READER_PINPAD, granted ? ACCESS_GRANTED : ACCESS_DENIED, credential);
+}
 
 bool init_pinpad()
 {
+    if (!keypad_init(ROW_PINS, COL_PINS, keys))
+    {
+        ESP_LOGE(PINPAD_TAG, "Failed to initialize keypad");
+        return false;
+    }
+
+    hal_gpio_mode(LED_PIN, HAL_OUTPUT);
+    hal_gpio_write(LED_PIN, HAL_LOW);
+
+    load_lockout(hal_millis());
+    if (lockout.failures > 0)
+    {
+        ESP_LOGW(PINPAD_TAG, "%u wrong PINs in a row before the reboot, locked out for %lu s", lockout.failures,
+                 (unsigned long)(pin_lockout_remaining_ms(&lockout, hal_millis()) / 1000));
+    }
     return true;
 }
 
 void handle_pinpad()
 {
-    char key = pinpad.getKey(); // Read the key pressed
-    if (key)
+    if (grant_end_ms != 0 && (int32_t)(hal_millis() - grant_end_ms) >= 0)
     {
-        ESP_LOGI(PINPAD_TAG, "Key pressed: %c", key);
+        hal_gpio_write(LED_PIN, HAL_LOW);
+        grant_end_ms = 0;
+    }
 
-        // Start entering the PIN when '*' is pressed
-        if (key == '*')
-        {
-            entering_pin = true;
-            current_pin = ""; // Reset the current PIN buffer
-            ESP_LOGI(PINPAD_TAG, "PIN entry started.");
-        }
-        // End of PIN entry when '#' is pressed
-        else if (key == '#')
-        {
-            if (entering_pin && current_pin.length() > 0)
-            {
-                ESP_LOGI(PINPAD_TAG, "PIN entry complete: %s", current_pin.c_str());
-                publish_pinpad_event(current_pin); // Wywołanie funkcji z modułu MQTT do wysłania kodu PIN
-            }
-            reset_pinpad_entry(); // Zawsze resetuj po zakończeniu wpisywania PINu
-        }
-        // Add digit to the PIN if we're in the process of entering it
-        else if (entering_pin && isdigit(key))
-        {
-            current_pin += key; // Add the digit to the current PIN
-            ESP_LOGI(PINPAD_TAG, "Current PIN: %s", current_pin.c_str());
-        }
-        // Cancel/clear entry if 'D' is pressed
-        else if (key == 'D')
+    KeyEvent event;
+    if (!keypad_get_event(&event, PINPAD_READ_FREQ)) // Presses wait in the queue, none is lost between calls
+    {
+        if (pin_entry_poll(&entry, hal_millis()) == PIN_ENTRY_TIMED_OUT)
         {
-            ESP_LOGI(PINPAD_TAG, "PIN entry canceled.");
-            reset_pinpad_entry();
+            ESP_LOGI(PINPAD_TAG, "PIN entry timed out.");
         }
+        return;
+    }
+
+    // Digits are never logged
+    switch (pin_entry_key(&entry, event.key, event.time_ms))
+    {
+    case PIN_ENTRY_STARTED:
+        ESP_LOGI(PINPAD_TAG, "PIN entry started.");
+        break;
+    case PIN_ENTRY_SUBMITTED:
+        check_pin(event.time_ms, false);
+        break;
+    case PIN_ENTRY_TOO_LONG:
+        check_pin(event.time_ms, true);
+        break;
+    case PIN_ENTRY_CANCELED:
+        ESP_LOGI(PINPAD_TAG, "PIN entry canceled.");
+        break;
+    default:
+        break;
     }
 }
 
 void reset_pinpad_entry()
 {
-    current_pin = "";
-    entering_pin = false;
+    pin_entry_clear(&entry);
+    entry.state = PIN_STATE_IDLE;
     ESP_LOGI(PINPAD_TAG, "PIN entry reset.");
-}
\ No newline at end of file
+}
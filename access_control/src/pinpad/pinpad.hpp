@@ -1,18 +1,20 @@
 #pragma once
 
-#include <Arduino.h>
-#include <Keypad.h>
-#include "esp_log.h"
+#include "hal/hal.hpp"
+#include "keypad.hpp"
+#include "pin_entry.hpp"
 
 // Define rows and columns for the keypad
-#define ROW_NUM 4    // Four rows
-#define COLUMN_NUM 4 // Four columns
+#define ROW_NUM KEYPAD_ROWS       // Four rows
+#define COLUMN_NUM KEYPAD_COLUMNS // Four columns
 
 #define LED_PIN 2
+#define PIN_GRANT_MS 3000 // How long the LED signals an accepted PIN
+#define PINPAD_READ_FREQ 100 // Longest wait for a key press, the keypad task queues them
 
 // Declare row and column pins as extern
-extern byte ROW_PINS[ROW_NUM];    // GPIO pins connected to row pins
-extern byte COL_PINS[COLUMN_NUM]; // GPIO pins connected to column pins
+extern const uint8_t ROW_PINS[ROW_NUM];    // GPIO pins connected to row pins
+extern const uint8_t COL_PINS[COLUMN_NUM]; // GPIO pins connected to column pins
 
 // Define the keymap for the keypad
 const char keys[ROW_NUM][COLUMN_NUM] = {
@@ -21,26 +23,29 @@ const char keys[ROW_NUM][COLUMN_NUM] = {
     {'7', '8', '9', 'C'},
     {'*', '0', '#', 'D'}};
 
-// Initialize the keypad object
-extern Keypad pinpad;
-
 /**
  * @brief Initializes the pinpad.
  *
- * Sets up the keypad object to use the defined rows and columns for input.
+ * Sets up the keypad driver (see keypad_init()) on the defined rows and columns
+ * and restores the wrong PIN count and lockout saved in NVS. A lockout is
+ * saved when it starts, so a reboot resumes it at its full length rather
+ * than clearing it.
  */
 bool init_pinpad();
 
 /**
- * @brief Periodically handles pinpad input.
+ * @brief Handles pinpad input, called in a loop by the pinpad task.
  *
- * Reads the key presses and handles the logic of entering a PIN, starting with '*' and ending with '#'.
+ * Waits up to PINPAD_READ_FREQ for key presses queued by the keypad task and
+ * feeds them to the PIN entry state machine (see pin_entry.hpp). A submitted
+ * PIN is checked against the local credential cache unless a lockout is
+ * running; only the decision goes to the access log, never the PIN.
  */
 void handle_pinpad();
 
 /**
  * @brief Resets the current PIN entry.
  *
- * Clears the buffer and resets the PIN entry process.
+ * Wipes the buffer and resets the PIN entry process.
  */
 void reset_pinpad_entry();
\ No newline at end of file
@@ -0,0 +1,256 @@
+#include <string.h>
+#include "hal/hal.hpp"
+#include "mfrc522.hpp"
+#include "mfrc522_registers.hpp"
+
+#define MFRC522_TAG "app_mfrc522"
+
+#define MFRC522_RESET_MS 50           // Oscillator start-up after a hard reset
+#define MFRC522_TIMER_PRESCALER 0xA9  // 25 us timer ticks
+#define MFRC522_TIMER_RELOAD 200      // 5 ms without an answer ends an exchange (TimerIRq)
+#define MFRC522_EXCHANGE_TIMEOUT_MS 20 // Only reached if the IRQ line is broken
+#define MFRC522_FIFO_READ_MAX 5       // Longest answer read: UID part and BCC
+
+/* Interrupts routed to the IRQ pin */
+#define MFRC522_IEN_ARMED (MFRC522_IRQ_INV | MFRC522_IRQ_RX)                                        // Waiting for a card, quiet until it answers
+#define MFRC522_IEN_EXCHANGE (MFRC522_IRQ_INV | MFRC522_IRQ_RX | MFRC522_IRQ_ERR | MFRC522_IRQ_TIMER) // Answer, error or timeout
+#define MFRC522_IEN_SEND (MFRC522_IRQ_INV | MFRC522_IRQ_TX)                                         // Frame sent, no answer expected
+
+static uint8_t cs_pin;
+static volatile hal_task_t waiting_task = NULL;
+static volatile uint64_t irq_us = 0;
+static uint8_t ien = 0; // Last value written to ComIEnReg
+static uint32_t spi_bytes = 0;
+
+static void on_irq(void *arg)
+{
+    (void)arg;
+    irq_us = hal_micros();
+    if (waiting_task != NULL)
+    {
+        hal_task_notify_from_isr(waiting_task);
+    }
+}
+
+static void transfer(const uint8_t *tx, uint8_t *rx, size_t length)
+{
+    hal_spi_transfer(cs_pin, MFRC522_SPI_HZ, tx, rx, length);
+    spi_bytes += length;
+}
+
+static void write_register(uint8_t reg, uint8_t value)
+{
+    uint8_t tx[2] = {MFRC522_SPI_ADDRESS(reg), value};
+    transfer(tx, NULL, sizeof(tx));
+}
+
+static uint8_t read_register(uint8_t reg)
+{
+    uint8_t tx[2] = {(uint8_t)(MFRC522_SPI_READ | MFRC522_SPI_ADDRESS(reg)), 0};
+    uint8_t rx[2];
+    transfer(tx, rx, sizeof(tx));
+    return rx[1];
+}
+
+/* Reads several registers in one transfer: each address byte clocks out the value of the previous one */
+static void read_registers(const uint8_t *regs, uint8_t *values, size_t count)
+{
+    uint8_t tx[MFRC522_FIFO_READ_MAX + 1];
+    uint8_t rx[MFRC522_FIFO_READ_MAX + 1];
+    for (size_t i = 0; i < count; i++)
+    {
+        tx[i] = MFRC522_SPI_READ | MFRC522_SPI_ADDRESS(regs[i]);
+    }
+    tx[count] = 0;
+    transfer(tx, rx, count + 1);
+    memcpy(values, rx + 1, count);
+}
+
+/* Sends a frame with the given interrupts enabled, the IRQ pin signals the end of the exchange */
+static void start_transceive(const uint8_t *frame, size_t length, uint8_t last_bits, uint8_t interrupts)
+{
+    write_register(MFRC522_REG_COMMAND, MFRC522_CMD_IDLE);
+    if (ien != interrupts)
+    {
+        write_register(MFRC522_REG_COM_IEN, interrupts);
+        ien = interrupts;
+    }
+    write_register(MFRC522_REG_COM_IRQ, MFRC522_IRQ_ALL);
+    hal_task_wait_notify(0); // Drops interrupts of the previous exchange
+
+    // FIFO writes keep the address, the whole frame goes in one transfer
+    uint8_t tx[2 + 2 * RFID_UID_MAX_LENGTH];
+    tx[0] = MFRC522_SPI_ADDRESS(MFRC522_REG_FIFO_LEVEL);
+    tx[1] = MFRC522_FIFO_FLUSH;
+    transfer(tx, NULL, 2);
+    tx[0] = MFRC522_SPI_ADDRESS(MFRC522_REG_FIFO_DATA);
+    memcpy(tx + 1, frame, length);
+    transfer(tx, NULL, length + 1);
+
+    write_register(MFRC522_REG_COMMAND, MFRC522_CMD_TRANSCEIVE);
+    write_register(MFRC522_REG_BIT_FRAMING, MFRC522_START_SEND | last_bits);
+}
+
+/* Collects the answer after the interrupt: status in one transfer, FIFO in another */
+static bool read_answer(uint8_t *answer, size_t length)
+{
+    static const uint8_t status_regs[] = {MFRC522_REG_COM_IRQ, MFRC522_REG_ERROR, MFRC522_REG_FIFO_LEVEL, MFRC522_REG_CONTROL};
+    uint8_t status[sizeof(status_regs)];
+    read_registers(status_regs, status, sizeof(status));
+
+    uint8_t irq = status[0], error = status[1], level = status[2], last_bits = status[3] & MFRC522_LAST_BITS;
+    if (!(irq & MFRC522_IRQ_RX) || (error & MFRC522_ERR_FRAME) || level != length || last_bits != 0)
+    {
+        return false; // Timeout, collision or unexpected frame
+    }
+
+    uint8_t regs[MFRC522_FIFO_READ_MAX];
+    memset(regs, MFRC522_REG_FIFO_DATA, length);
+    read_registers(regs, answer, length);
+    return true;
+}
+
+static bool transceive(const uint8_t *frame, size_t length, uint8_t *answer, size_t answer_length)
+{
+    start_transceive(frame, length, 0, MFRC522_IEN_EXCHANGE);
+    return hal_task_wait_notify(MFRC522_EXCHANGE_TIMEOUT_MS) && read_answer(answer, answer_length);
+}
+
+/* Anticollision and select of one cascade level, returns the SAK */
+static bool select_level(uint8_t sel, uint8_t *part, uint8_t *sak)
+{
+    uint8_t frame[9] = {sel, PICC_ANTICOLL};
+    if (!transceive(frame, 2, part, 5) || (part[0] ^ part[1] ^ part[2] ^ part[3]) != part[4])
+    {
+        return false; // No answer, several cards or bad BCC
+    }
+
+    frame[1] = PICC_SELECT;
+    memcpy(frame + 2, part, 5);
+    uint16_t crc = mfrc522_crc_a(frame, 7);
+    frame[7] = crc & 0xFF;
+    frame[8] = crc >> 8;
+
+    uint8_t answer[3];
+    if (!transceive(frame, sizeof(frame), answer, sizeof(answer)))
+    {
+        return false;
+    }
+    crc = mfrc522_crc_a(answer, 1);
+    *sak = answer[0];
+    return answer[1] == (crc & 0xFF) && answer[2] == (crc >> 8);
+}
+
+static bool read_uid(Mfrc522Card *card)
+{
+    static const uint8_t levels[] = {PICC_SEL_CL1, PICC_SEL_CL2, PICC_SEL_CL3};
+    RfidUid &uid = card->uid;
+    uid = RfidUid{};
+    for (uint8_t sel : levels)
+    {
+        uint8_t part[5];
+        if (!select_level(sel, part, &card->sak))
+        {
+            return false;
+        }
+        if (!(card->sak & PICC_SAK_CASCADE))
+        {
+            memcpy(uid.bytes.data() + uid.size, part, 4);
+            uid.size += 4;
+            return true;
+        }
+        if (part[0] != PICC_CASCADE_TAG)
+        {
+            return false;
+        }
+        memcpy(uid.bytes.data() + uid.size, part + 1, 3);
+        uid.size += 3;
+    }
+    return false; // Cascade bit set after the third level
+}
+
+bool mfrc522_init(uint8_t cs, uint8_t rst, uint8_t irq)
+{
+    cs_pin = cs;
+    hal_gpio_mode(cs_pin, HAL_OUTPUT);
+    hal_gpio_write(cs_pin, HAL_HIGH);
+
+    hal_gpio_mode(rst, HAL_OUTPUT);
+    hal_gpio_write(rst, HAL_LOW);
+    hal_delay_ms(1);
+    hal_gpio_write(rst, HAL_HIGH);
+    hal_delay_ms(MFRC522_RESET_MS);
+
+    uint8_t version = read_register(MFRC522_REG_VERSION);
+    if (version == 0x00 || version == 0xFF)
+    {
+        ESP_LOGE(MFRC522_TAG, "No answer from the RC522");
+        return false;
+    }
+
+    write_register(MFRC522_REG_T_MODE, MFRC522_T_AUTO);
+    write_register(MFRC522_REG_T_PRESCALER, MFRC522_TIMER_PRESCALER);
+    write_register(MFRC522_REG_T_RELOAD_H, MFRC522_TIMER_RELOAD >> 8);
+    write_register(MFRC522_REG_T_RELOAD_L, MFRC522_TIMER_RELOAD & 0xFF);
+    write_register(MFRC522_REG_TX_ASK, 0x40); // 100% ASK modulation
+    write_register(MFRC522_REG_MODE, 0x3D);   // CRC preset 0x6363
+    write_register(MFRC522_REG_TX_CONTROL, read_register(MFRC522_REG_TX_CONTROL) | MFRC522_ANTENNA_ON);
+
+    // Push-pull IRQ, no pull-up needed on the pin
+    write_register(MFRC522_REG_DIV_IEN, MFRC522_DIV_IEN_PUSH_PULL);
+    write_register(MFRC522_REG_COM_IEN, MFRC522_IRQ_INV);
+    ien = MFRC522_IRQ_INV;
+    hal_gpio_mode(irq, HAL_INPUT);
+    if (!hal_gpio_attach_interrupt(irq, HAL_EDGE_FALLING, on_irq, NULL))
+    {
+        ESP_LOGE(MFRC522_TAG, "Failed to attach the IRQ pin interrupt");
+        return false;
+    }
+
+    ESP_LOGI(MFRC522_TAG, "RC522 version 0x%02X ready", version);
+    return true;
+}
+
+bool mfrc522_wait_card(Mfrc522Card *card, uint32_t timeout_ms)
+{
+    waiting_task = hal_task_current();
+
+    uint8_t reqa = PICC_REQA;
+    start_transceive(&reqa, 1, 7, MFRC522_IEN_ARMED); // Short frame of 7 bits
+    if (!hal_task_wait_notify(timeout_ms))
+    {
+        return false; // No card in the field
+    }
+    card->answered_us = irq_us;
+
+    uint8_t atqa[2];
+    if (!read_answer(atqa, sizeof(atqa)))
+    {
+        ESP_LOGD(MFRC522_TAG, "Invalid answer to REQA");
+        return false;
+    }
+    if (!read_uid(card))
+    {
+        ESP_LOGD(MFRC522_TAG, "Card left or collided during select");
+        return false;
+    }
+    return true;
+}
+
+void mfrc522_halt()
+{
+    uint8_t frame[4] = {PICC_HLTA, 0};
+    uint16_t crc = mfrc522_crc_a(frame, 2);
+    frame[2] = crc & 0xFF;
+    frame[3] = crc >> 8;
+
+    // The card never answers HLTA, only wait until the frame is out
+    start_transceive(frame, sizeof(frame), 0, MFRC522_IEN_SEND);
+    hal_task_wait_notify(MFRC522_EXCHANGE_TIMEOUT_MS);
+    write_register(MFRC522_REG_COMMAND, MFRC522_CMD_IDLE);
+}
+
+uint32_t mfrc522_spi_bytes()
+{
+    return spi_bytes;
+}
@@ -0,0 +1,63 @@
+#pragma once
+
+/*
+ * Driver of the MFRC522 (RC522) RFID reader, on the HAL SPI bus.
+ *
+ * The reader cannot detect cards on its own: a card only talks after a
+ * REQA. mfrc522_wait_card() sends one REQA with just the receive interrupt
+ * routed to the IRQ pin, then blocks on a task notification, so the CPU and
+ * the SPI bus stay idle until a card answers or the wait times out. The
+ * exchanges reading the UID also end on an interrupt instead of polling
+ * ComIrqReg.
+ */
+
+#include <stdint.h>
+#include "rfid_uid.hpp"
+
+#define MFRC522_SPI_HZ 10000000 // Maximum SPI clock of the chip
+
+/// Selected card.
+struct Mfrc522Card
+{
+    RfidUid uid;
+    uint8_t sak;          ///< Select acknowledge of the last cascade level.
+    uint64_t answered_us; ///< hal_micros() of the interrupt signalling the card's answer to the REQA.
+};
+
+/**
+ * @brief Resets the reader and configures its timer, antenna and IRQ pin.
+ *
+ * The SPI bus must already be started (hal_spi_begin()).
+ *
+ * @param cs GPIO used as chip select.
+ * @param rst GPIO connected to the reset pin.
+ * @param irq GPIO connected to the IRQ pin.
+ * @return true if the chip answered with a known version, false otherwise.
+ */
+bool mfrc522_init(uint8_t cs, uint8_t rst, uint8_t irq);
+
+/**
+ * @brief Waits for a card and selects it.
+ *
+ * Must always be called from the same task, which the interrupt notifies.
+ *
+ * @param card (Output) Card read.
+ * @param timeout_ms How long to wait for an answer to the REQA; sending a new one is up to the caller.
+ * @return true if a card answered and its UID was read, false otherwise.
+ */
+bool mfrc522_wait_card(Mfrc522Card *card, uint32_t timeout_ms);
+
+/**
+ * @brief Puts the selected card to sleep (HLTA).
+ *
+ * A halted card ignores REQA until it leaves the field, so the same tap is
+ * not read twice.
+ */
+void mfrc522_halt();
+
+/**
+ * @brief Returns the SPI traffic of the driver since boot.
+ *
+ * @return Bytes exchanged with the chip.
+ */
+uint32_t mfrc522_spi_bytes();
@@ -0,0 +1,88 @@
+#pragma once
+
+/*
+ * MFRC522 registers, commands and PICC commands used by the driver and by
+ * the simulated chip (see the MFRC522 and ISO/IEC 14443-3 datasheets).
+ */
+
+#include <stddef.h>
+#include <stdint.h>
+
+/* Registers */
+#define MFRC522_REG_COMMAND 0x01
+#define MFRC522_REG_COM_IEN 0x02
+#define MFRC522_REG_DIV_IEN 0x03
+#define MFRC522_REG_COM_IRQ 0x04
+#define MFRC522_REG_DIV_IRQ 0x05
+#define MFRC522_REG_ERROR 0x06
+#define MFRC522_REG_FIFO_DATA 0x09
+#define MFRC522_REG_FIFO_LEVEL 0x0A
+#define MFRC522_REG_CONTROL 0x0C
+#define MFRC522_REG_BIT_FRAMING 0x0D
+#define MFRC522_REG_MODE 0x11
+#define MFRC522_REG_TX_CONTROL 0x14
+#define MFRC522_REG_TX_ASK 0x15
+#define MFRC522_REG_T_MODE 0x2A
+#define MFRC522_REG_T_PRESCALER 0x2B
+#define MFRC522_REG_T_RELOAD_H 0x2C
+#define MFRC522_REG_T_RELOAD_L 0x2D
+#define MFRC522_REG_VERSION 0x37
+
+/* SPI address byte: bit 7 selects a read, bits 6-1 hold the register */
+#define MFRC522_SPI_READ 0x80
+#define MFRC522_SPI_ADDRESS(reg) ((uint8_t)((reg) << 1))
+
+/* Commands (CommandReg) */
+#define MFRC522_CMD_IDLE 0x00
+#define MFRC522_CMD_TRANSCEIVE 0x0C
+#define MFRC522_CMD_SOFT_RESET 0x0F
+
+/* ComIEnReg / ComIrqReg bits */
+#define MFRC522_IRQ_INV 0x80 // ComIEnReg: IRQ pin active low
+#define MFRC522_IRQ_SET 0x80 // ComIrqReg: write sets the marked bits instead of clearing them
+#define MFRC522_IRQ_TX 0x40
+#define MFRC522_IRQ_RX 0x20
+#define MFRC522_IRQ_IDLE 0x10
+#define MFRC522_IRQ_ERR 0x02
+#define MFRC522_IRQ_TIMER 0x01
+#define MFRC522_IRQ_ALL 0x7F
+
+/* Other register bits */
+#define MFRC522_DIV_IEN_PUSH_PULL 0x80  // DivIEnReg: IRQ pin driven in both directions
+#define MFRC522_FIFO_FLUSH 0x80         // FIFOLevelReg
+#define MFRC522_START_SEND 0x80         // BitFramingReg
+#define MFRC522_T_AUTO 0x80             // TModeReg: timer starts at the end of every transmission
+#define MFRC522_ERR_FRAME 0x1B          // ErrorReg: buffer overflow, collision, parity or protocol error
+#define MFRC522_LAST_BITS 0x07          // BitFramingReg / ControlReg: valid bits of the last byte
+#define MFRC522_ANTENNA_ON 0x03         // TxControlReg: Tx1RFEn and Tx2RFEn
+
+/* PICC commands */
+#define PICC_REQA 0x26
+#define PICC_WUPA 0x52
+#define PICC_SEL_CL1 0x93
+#define PICC_SEL_CL2 0x95
+#define PICC_SEL_CL3 0x97
+#define PICC_ANTICOLL 0x20 // NVB of an anticollision frame without UID bits
+#define PICC_SELECT 0x70   // NVB of a select frame with the full UID part
+#define PICC_HLTA 0x50
+#define PICC_CASCADE_TAG 0x88
+#define PICC_SAK_CASCADE 0x04 // UID not complete, next cascade level follows
+
+/**
+ * @brief Computes the ISO/IEC 14443-A CRC of a frame.
+ *
+ * @param data Frame bytes.
+ * @param length Number of bytes.
+ * @return CRC, sent low byte first.
+ */
+static inline uint16_t mfrc522_crc_a(const uint8_t *data, size_t length)
+{
+    uint16_t crc = 0x6363;
+    for (size_t i = 0; i < length; i++)
+    {
+        uint8_t b = data[i] ^ (uint8_t)crc;
+        b ^= (uint8_t)(b << 4);
+        crc = (crc >> 8) ^ ((uint16_t)b << 8) ^ ((uint16_t)b << 3) ^ (b >> 4);
+    }
+    return crc;
+}
@@ -0,0 +1,375 @@
+#if defined(HAL_LINUX)
+
+#include <string.h>
+#include "hal/hal.hpp"
+#include "hal/linux/hal_fake.hpp"
+#include "mfrc522.hpp"
+#include "mfrc522_sim.hpp"
+#include "mfrc522_registers.hpp"
+
+#define SIM_VERSION 0x92     // MFRC522 v2.0
+#define SIM_FIFO_SIZE 64
+#define SIM_BIT_NS 9440      // One bit at 106 kbit/s (128 / 13.56 MHz)
+#define SIM_FRAME_BITS 2     // Start and end of frame
+#define SIM_FDT_US 86        // Delay between the end of a command and the card's answer
+#define SIM_POWER_UP_US 2500 // Card needs the field this long before answering
+
+enum SimCardState : uint8_t
+{
+    CARD_IDLE,   // Answers REQA and WUPA
+    CARD_READY,  // Anticollision in progress
+    CARD_ACTIVE, // Selected
+    CARD_HALT,   // Answers WUPA only
+};
+
+enum SimStage : uint8_t
+{
+    STAGE_NONE,
+    STAGE_SENT,    // Frame being transmitted
+    STAGE_ANSWER,  // Card answer being received
+    STAGE_TIMEOUT, // Timer running without an answer
+};
+
+static uint8_t irq_pin;
+static uint8_t regs[64];
+static uint8_t fifo[SIM_FIFO_SIZE];
+static uint8_t fifo_length = 0;
+static int irq_level = HAL_HIGH;
+
+static hal_timer_t timer = NULL;
+static SimStage stage = STAGE_NONE;
+static uint8_t answer[SIM_FIFO_SIZE];
+static uint8_t answer_length = 0;
+
+static bool card_present = false;
+static uint8_t card_uid[RFID_UID_MAX_LENGTH];
+static uint8_t card_uid_size = 0;
+static uint64_t card_ready_us = 0;
+static SimCardState card_state = CARD_IDLE;
+static uint8_t card_level = 0; // Cascade level of the anticollision
+
+static uint64_t air_time_us(uint32_t bits)
+{
+    return ((uint64_t)(bits + SIM_FRAME_BITS) * SIM_BIT_NS + 999) / 1000;
+}
+
+static uint64_t timer_period_us()
+{
+    uint32_t prescaler = ((regs[MFRC522_REG_T_MODE] & 0x0F) << 8) | regs[MFRC522_REG_T_PRESCALER];
+    uint32_t reload = (regs[MFRC522_REG_T_RELOAD_H] << 8) | regs[MFRC522_REG_T_RELOAD_L];
+    return (uint64_t)(2 * prescaler + 1) * (reload + 1) * 100 / 1356; // 13.56 MHz clock
+}
+
+static void update_irq()
+{
+    bool active = (regs[MFRC522_REG_COM_IEN] & regs[MFRC522_REG_COM_IRQ] & MFRC522_IRQ_ALL) != 0;
+    int level = (regs[MFRC522_REG_COM_IEN] & MFRC522_IRQ_INV) ? !active : active;
+    if (level != irq_level)
+    {
+        irq_level = level;
+        hal_fake_gpio_set_input(irq_pin, level);
+    }
+}
+
+static void set_irq(uint8_t bits)
+{
+    regs[MFRC522_REG_COM_IRQ] |= bits;
+    update_irq();
+}
+
+static void reset_registers()
+{
+    hal_timer_stop(timer);
+    stage = STAGE_NONE;
+    memset(regs, 0, sizeof(regs));
+    regs[MFRC522_REG_COMMAND] = 0x20;
+    regs[MFRC522_REG_COM_IEN] = MFRC522_IRQ_INV;
+    regs[MFRC522_REG_CONTROL] = 0x10;
+    regs[MFRC522_REG_MODE] = 0x3F;
+    regs[MFRC522_REG_TX_CONTROL] = 0x80;
+    fifo_length = 0;
+    update_irq();
+}
+
+static bool card_last_level()
+{
+    uint8_t levels = card_uid_size == 4 ? 1 : card_uid_size == 7 ? 2 : 3;
+    return card_level + 1 == levels;
+}
+
+/* UID part sent at the current cascade level, with the BCC */
+static void card_uid_part(uint8_t *part)
+{
+    const uint8_t *uid = card_uid + 3 * card_level;
+    if (!card_last_level())
+    {
+        part[0] = PICC_CASCADE_TAG;
+        memcpy(part + 1, uid, 3);
+    }
+    else
+    {
+        memcpy(part, uid, 4);
+    }
+    part[4] = part[0] ^ part[1] ^ part[2] ^ part[3];
+}
+
+static bool crc_ok(const uint8_t *frame, size_t length)
+{
+    uint16_t crc = mfrc522_crc_a(frame, length - 2);
+    return frame[length - 2] == (crc & 0xFF) && frame[length - 1] == (crc >> 8);
+}
+
+/* Card side of ISO 14443-3, fills the answer and returns false if the card stays silent */
+static bool card_receive(const uint8_t *frame, uint8_t length, uint8_t last_bits)
+{
+    if (!card_present || hal_micros() < card_ready_us || !(regs[MFRC522_REG_TX_CONTROL] & MFRC522_ANTENNA_ON))
+    {
+        return false;
+    }
+
+    if (length == 1 && last_bits == 7)
+    {
+        if ((frame[0] == PICC_REQA && card_state == CARD_IDLE) ||
+            (frame[0] == PICC_WUPA && (card_state == CARD_IDLE || card_state == CARD_HALT)))
+        {
+            card_state = CARD_READY;
+            card_level = 0;
+            answer[0] = card_uid_size == 4 ? 0x04 : card_uid_size == 7 ? 0x44 : 0x84; // ATQA, UID size in bits 7-6
+            answer[1] = 0x00;
+            answer_length = 2;
+            return true;
+        }
+        return false;
+    }
+
+    uint8_t sel = PICC_SEL_CL1 + 2 * card_level;
+    if (card_state == CARD_READY && last_bits == 0 && length == 2 && frame[0] == sel && frame[1] == PICC_ANTICOLL)
+    {
+        card_uid_part(answer);
+        answer_length = 5;
+        return true;
+    }
+
+    if (card_state == CARD_READY && last_bits == 0 && length == 9 && frame[0] == sel && frame[1] == PICC_SELECT)
+    {
+        uint8_t part[5];
+        card_uid_part(part);
+        if (crc_ok(frame, length) && memcmp(frame + 2, part, 5) == 0)
+        {
+            bool complete = card_last_level();
+            answer[0] = complete ? 0x08 : PICC_SAK_CASCADE; // MIFARE Classic 1K once complete
+            uint16_t crc = mfrc522_crc_a(answer, 1);
+            answer[1] = crc & 0xFF;
+            answer[2] = crc >> 8;
+            answer_length = 3;
+            card_level++;
+            card_state = complete ? CARD_ACTIVE : CARD_READY;
+            return true;
+        }
+    }
+
+    if (card_state == CARD_ACTIVE && last_bits == 0 && length == 4 && frame[0] == PICC_HLTA && frame[1] == 0 &&
+        crc_ok(frame, length))
+    {
+        card_state = CARD_HALT;
+        return false;
+    }
+
+    if (card_state != CARD_HALT)
+    {
+        card_state = CARD_IDLE; // Unexpected frames send the card back
+    }
+    return false;
+}
+
+static void start_send()
+{
+    uint8_t last_bits = regs[MFRC522_REG_BIT_FRAMING] & MFRC522_LAST_BITS;
+    uint32_t bits = last_bits ? (fifo_length - 1) * 9 + last_bits : fifo_length * 9; // Parity bit per byte
+
+    answer_length = 0;
+    card_receive(fifo, fifo_length, last_bits);
+    fifo_length = 0;
+
+    stage = STAGE_SENT;
+    hal_timer_start_once(timer, air_time_us(bits));
+}
+
+static void on_timer(void *arg)
+{
+    (void)arg;
+    switch (stage)
+    {
+    case STAGE_SENT:
+        set_irq(MFRC522_IRQ_TX);
+        if (answer_length > 0)
+        {
+            stage = STAGE_ANSWER;
+            hal_timer_start_once(timer, SIM_FDT_US + air_time_us(answer_length * 9));
+        }
+        else if (regs[MFRC522_REG_T_MODE] & MFRC522_T_AUTO)
+        {
+            stage = STAGE_TIMEOUT;
+            hal_timer_start_once(timer, timer_period_us());
+        }
+        else
+        {
+            stage = STAGE_NONE;
+        }
+        break;
+    case STAGE_ANSWER:
+        stage = STAGE_NONE;
+        memcpy(fifo, answer, answer_length);
+        fifo_length = answer_length;
+        set_irq(MFRC522_IRQ_RX);
+        break;
+    case STAGE_TIMEOUT:
+        stage = STAGE_NONE;
+        set_irq(MFRC522_IRQ_TIMER);
+        break;
+    default:
+        break;
+    }
+}
+
+static void write_register(uint8_t reg, uint8_t value)
+{
+    switch (reg)
+    {
+    case MFRC522_REG_COMMAND:
+        regs[reg] = (regs[reg] & 0xF0) | (value & 0x0F);
+        if ((value & 0x0F) == MFRC522_CMD_SOFT_RESET)
+        {
+            reset_registers();
+        }
+        else if ((value & 0x0F) == MFRC522_CMD_IDLE)
+        {
+            hal_timer_stop(timer);
+            stage = STAGE_NONE;
+        }
+        break;
+    case MFRC522_REG_COM_IRQ:
+        if (value & MFRC522_IRQ_SET)
+        {
+            regs[reg] |= value & MFRC522_IRQ_ALL;
+        }
+        else
+        {
+            regs[reg] &= ~value;
+        }
+        update_irq();
+        break;
+    case MFRC522_REG_COM_IEN:
+        regs[reg] = value;
+        update_irq();
+        break;
+    case MFRC522_REG_FIFO_DATA:
+        if (fifo_length < SIM_FIFO_SIZE)
+        {
+            fifo[fifo_length++] = value;
+        }
+        break;
+    case MFRC522_REG_FIFO_LEVEL:
+        if (value & MFRC522_FIFO_FLUSH)
+        {
+            fifo_length = 0;
+        }
+        break;
+    case MFRC522_REG_BIT_FRAMING:
+        regs[reg] = value & ~MFRC522_START_SEND;
+        if ((value & MFRC522_START_SEND) && (regs[MFRC522_REG_COMMAND] & 0x0F) == MFRC522_CMD_TRANSCEIVE)
+        {
+            start_send();
+        }
+        break;
+    default:
+        regs[reg] = value;
+        break;
+    }
+}
+
+static uint8_t read_register(uint8_t reg)
+{
+    switch (reg)
+    {
+    case MFRC522_REG_FIFO_DATA:
+    {
+        if (fifo_length == 0)
+        {
+            return 0;
+        }
+        uint8_t value = fifo[0];
+        memmove(fifo, fifo + 1, --fifo_length);
+        return value;
+    }
+    case MFRC522_REG_FIFO_LEVEL:
+        return fifo_length;
+    case MFRC522_REG_VERSION:
+        return SIM_VERSION;
+    default:
+        return regs[reg];
+    }
+}
+
+/* One transfer with CS asserted: reads return the previous address' value, writes keep the address */
+static void on_transfer(void *ctx, const uint8_t *tx, uint8_t *rx, size_t length)
+{
+    (void)ctx;
+    if (length == 0)
+    {
+        return;
+    }
+    if (rx != NULL)
+    {
+        memset(rx, 0, length);
+    }
+
+    if (tx[0] & MFRC522_SPI_READ)
+    {
+        for (size_t i = 1; i < length; i++)
+        {
+            uint8_t value = read_register((tx[i - 1] >> 1) & 0x3F);
+            if (rx != NULL)
+            {
+                rx[i] = value;
+            }
+        }
+    }
+    else
+    {
+        for (size_t i = 1; i < length; i++)
+        {
+            write_register((tx[0] >> 1) & 0x3F, tx[i]);
+        }
+    }
+}
+
+void mfrc522_sim_attach(uint8_t cs, uint8_t irq)
+{
+    if (timer == NULL)
+    {
+        timer = hal_timer_create("rc522_sim", on_timer, NULL);
+    }
+    irq_pin = irq;
+    irq_level = HAL_HIGH;
+    hal_fake_gpio_set_input(irq_pin, HAL_HIGH);
+    reset_registers();
+    hal_fake_spi_attach(cs, on_transfer, NULL);
+}
+
+void mfrc522_sim_place_card(const uint8_t *uid, uint8_t size)
+{
+    memcpy(card_uid, uid, size);
+    card_uid_size = size;
+    card_present = true;
+    card_state = CARD_IDLE;
+    card_ready_us = hal_micros() + SIM_POWER_UP_US;
+}
+
+void mfrc522_sim_remove_card()
+{
+    card_present = false;
+    card_state = CARD_IDLE;
+}
+
+#endif // HAL_LINUX
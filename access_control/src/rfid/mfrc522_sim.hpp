@@ -0,0 +1,39 @@
+#pragma once
+
+/*
+ * Register model of the MFRC522 and of one ISO 14443-A card, for host builds.
+ *
+ * Attached to the fake SPI bus of the Linux HAL, the model answers register
+ * reads and writes, runs the Transceive command with RF frame timings at
+ * 106 kbit/s, sets ComIrqReg and drives the IRQ pin. The card answers
+ * REQA/WUPA, anticollision, select and HLTA like a real one, including the
+ * power-up delay after entering the field. Timings only make sense under
+ * the simulator (hal_sim_begin()).
+ */
+
+#if defined(HAL_LINUX)
+
+#include <stdint.h>
+
+/**
+ * @brief Attaches the simulated reader to the fake SPI bus.
+ *
+ * @param cs GPIO used as chip select.
+ * @param irq GPIO connected to the IRQ pin.
+ */
+void mfrc522_sim_attach(uint8_t cs, uint8_t irq);
+
+/**
+ * @brief Brings a card into the field.
+ *
+ * @param uid UID bytes.
+ * @param size UID length: 4, 7 or 10 bytes.
+ */
+void mfrc522_sim_place_card(const uint8_t *uid, uint8_t size);
+
+/**
+ * @brief Takes the card out of the field.
+ */
+void mfrc522_sim_remove_card();
+
+#endif // HAL_LINUX
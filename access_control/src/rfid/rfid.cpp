@@ -1,21 +1,27 @@
 #include "rfid.hpp"
-#include "../mqtt/mqtt.hpp" // Dodaj ten include, aby używać publish_rfid_event
-#include "esp_log.h"
+#include "../credentials/credentials.hpp"
+#include "../access_log/access_log.hpp"
 
 #define RFID_TAG "app_rfid"
 
-MFRC522 rfid(SS_PIN, RST_PIN);
+static Mfrc522Card card;            // Last card read
+static RfidUidCache recent_uids = {}; // Suppresses repeated reads of a card left on the reader
+
+static uint32_t grant_end_ms = 0; // LED stays on until then after an accepted card
 
 bool init_RFID()
 {
-    SPI.begin();
+    hal_spi_begin(SCK_PIN, MISO_PIN, MOSI_PIN);
     ESP_LOGI(RFID_TAG, "SPI initialized");
 
-    rfid.PCD_Init();
-    ESP_LOGI(RFID_TAG, "RFID reader PCD_Init called");
+    if (!mfrc522_init(SS_PIN, RST_PIN, IRQ_PIN))
+    {
+        ESP_LOGE(RFID_TAG, "RFID reader not found");
+        return false;
+    }
 
-    pinMode(LED_RFID, OUTPUT);   // Initialize LED pin as output
-    digitalWrite(LED_RFID, LOW); // Ensure LED is off initially
+    hal_gpio_mode(LED_RFID, HAL_OUTPUT); // Initialize LED pin as output
+    hal_gpio_write(LED_RFID, HAL_LOW);   // Ensure LED is off initially
 
     ESP_LOGI(RFID_TAG, "RFID reader and LED initialized successfully.");
     return true;
@@ -23,23 +29,43 @@ bool init_RFID()
 
 void handle_RFID()
 {
+    if (grant_end_ms != 0 && (int32_t)(hal_millis() - grant_end_ms) >= 0)
+    {
+        hal_gpio_write(LED_RFID, HAL_LOW);
+        grant_end_ms = 0;
+    }
+
     if (read_RFID())
     {
-        String uid = "";
-        for (byte i = 0; i < rfid.uid.size; i++)
+        if (!rfid_uid_cache_seen(&recent_uids, card.uid, hal_millis()))
+        {
+            ESP_LOGD(RFID_TAG, "Card still on the reader, no new event");
+            stop_RFID_communication();
+            return;
+        }
+
+        // Decided locally, works without the broker
+        bool granted = credentials_check_uid(card.uid.bytes.data(), card.uid.size);
+        uint32_t decision_us = (uint32_t)(hal_micros() - card.answered_us);
+        if (granted)
         {
-            uid += String(rfid.uid.uidByte[i], HEX);
+            hal_gpio_write(LED_RFID, HAL_HIGH);
+            grant_end_ms = hal_millis() + ACCESS_GRANT_MS;
         }
+        ESP_LOGI(RFID_TAG, "Access %s, decided %lu us after the card answered", granted ? "granted" : "denied",
+                 (unsigned long)decision_us);
 
-        print_RFID_UID();          // Logowanie UID
-        publish_RFID_UID(uid);     // Publikowanie UID na MQTT
+        RfidUidText uid = rfid_uid_format(card.uid);
+        print_RFID_UID(uid.data()); // Logowanie UID
+        access_log_record(ACCESS_READER_RFID, granted ? ACCESS_GRANTED : ACCESS_DENIED,
+                          credential_uid_key(card.uid.bytes.data(), card.uid.size));
         stop_RFID_communication(); // Zakończenie komunikacji z kartą
     }
 }
 
 bool read_RFID()
 {
-    if (!rfid.PICC_IsNewCardPresent() || !rfid.PICC_ReadCardSerial())
+    if (!mfrc522_wait_card(&card, RFID_READ_FREQ))
     {
         ESP_LOGV(RFID_TAG, "No RFID card detected or failed to read.");
         return false;
@@ -49,32 +75,13 @@ bool read_RFID()
     return true;
 }
 
-void publish_RFID_UID(const String &uid)
+void print_RFID_UID(const char *uid)
 {
-    if (!uid.isEmpty()) // Upewnij się, że UID nie jest pusty
-    {
-        publish_rfid_event(uid); // Wywołanie funkcji publikującej z mqtt.cpp
-        ESP_LOGI(RFID_TAG, "Published RFID UID to MQTT: %s", uid.c_str());
-    }
-    else
-    {
-        ESP_LOGW(RFID_TAG, "Cannot publish empty RFID UID.");
-    }
-}
-
-void print_RFID_UID()
-{
-    String uid = "";
-    for (byte i = 0; i < rfid.uid.size; i++)
-    {
-        uid += String(rfid.uid.uidByte[i], HEX);
-    }
-    ESP_LOGI(RFID_TAG, "RFID Card UID: %s", uid.c_str());
+    ESP_LOGI(RFID_TAG, "RFID Card UID: %s", uid);
 }
 
 void stop_RFID_communication()
 {
-    rfid.PICC_HaltA();
-    rfid.PCD_StopCrypto1();
+    mfrc522_halt();
     ESP_LOGV(RFID_TAG, "Stopped communication with the RFID card.");
 }
@@ -1,19 +1,23 @@
 #pragma once
 
-#include <Arduino.h>
-#include <SPI.h>
-#include <MFRC522.h>
-#include "esp_log.h"
+#include "hal/hal.hpp"
+#include "mfrc522.hpp"
 
 #define RST_PIN 22  // Configurable pin for RC522 reset
 #define SS_PIN 5    // Configurable pin for RC522 SS (Slave Select)
+#define IRQ_PIN 16  // RC522 IRQ, signals a card answer
+#define SCK_PIN 18  // VSPI bus
+#define MISO_PIN 19
+#define MOSI_PIN 23
 #define LED_RFID 15 // GPIO pin where the LED is connected
+#define ACCESS_GRANT_MS 3000 // How long the LED signals an accepted card
+#define RFID_READ_FREQ 50    // REQA repeat, the task sleeps on the reader IRQ in between
 
 /**
  * @brief Initializes the RFID reader (RC522 module).
  *
  * Initializes the SPI bus and the RC522 RFID reader.
- * Performs a self-test to ensure the reader is functioning correctly.
+ * Checks the chip version to ensure the reader is answering.
  * Uses ESP_LOG for logging the status.
  *
  * @return true if initialization was successful, false otherwise.
@@ -21,43 +25,39 @@
 bool init_RFID();
 
 /**
- * @brief Periodically handles RFID card reading.
+ * @brief Handles RFID card reading, called in a loop by the RFID task.
  *
- * This function reads the RFID card and processes it by logging the UID or sending it to the backend.
+ * This function waits up to RFID_READ_FREQ for a card (see mfrc522_wait_card()),
+ * decides locally whether it is allowed (see credentials_check_uid()) and
+ * appends the decision to the access log (see access_log_record()). Reads of a card left on the reader
+ * within RFID_HOLD_OFF_MS are ignored, so a tap produces one event.
  */
 void handle_RFID();
 
 /**
  * @brief Reads an RFID card and retrieves its UID.
  *
- * This function checks if a new RFID card is present and reads its UID.
+ * This function blocks until a card answers the reader's interrupt or the
+ * wait times out, then reads its UID.
  * Errors or successes are logged using ESP_LOG.
  *
  * @return true if a card was successfully read, false otherwise.
  */
 bool read_RFID();
 
-/**
- * @brief Placeholder for publishing or storing the RFID card UID.
- *
- * This function is a placeholder for future integration with MQTT to send the RFID card UID to the backend.
- * Logs the UID using ESP_LOG.
- *
- * @param uid The UID of the RFID card.
- */
-void publish_RFID_UID(const String &uid);
-
 /**
  * @brief Logs the UID of the RFID card using ESP_LOG.
  *
  * This function prints the card's UID in a hexadecimal format for debugging or logging purposes.
+ *
+ * @param uid The UID of the RFID card, formatted with rfid_uid_format().
  */
-void print_RFID_UID();
+void print_RFID_UID(const char *uid);
 
 /**
  * @brief Stops communication with the current RFID card.
  *
- * This function halts the communication with the RFID card and stops the encryption.
+ * This function halts the RFID card, which then ignores the reader until it leaves the field.
  * Logs the stop action using ESP_LOG.
  */
 void stop_RFID_communication();
\ No newline at end of file
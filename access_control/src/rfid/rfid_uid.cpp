@@ -0,0 +1,32 @@
+#include "rfid_uid.hpp"
+
+// Leading zeros are kept, unlike String(byte, HEX)
+static_assert(rfid_uid_format(RfidUid{{0x04, 0xA0, 0x0B, 0xFF}, 4})[0] == '0', "UID formatting drops leading zeros");
+static_assert(rfid_uid_format(RfidUid{{0x04, 0xA0, 0x0B, 0xFF}, 4})[7] == 'f', "UID formatting drops digits");
+static_assert(rfid_uid_format(RfidUid{{0x04, 0xA0, 0x0B, 0xFF}, 4})[8] == '\0', "UID text not terminated");
+
+bool rfid_uid_cache_seen(RfidUidCache *cache, const RfidUid &uid, uint32_t now_ms)
+{
+    uint8_t slot = 0;
+    for (uint8_t i = 0; i < cache->count; i++)
+    {
+        if (cache->uids[i] == uid)
+        {
+            bool repeated = now_ms - cache->seen_ms[i] < RFID_HOLD_OFF_MS;
+            cache->seen_ms[i] = now_ms;
+            return !repeated;
+        }
+        if (now_ms - cache->seen_ms[i] > now_ms - cache->seen_ms[slot])
+        {
+            slot = i; // Oldest so far
+        }
+    }
+
+    if (cache->count < RFID_UID_CACHE_SIZE)
+    {
+        slot = cache->count++;
+    }
+    cache->uids[slot] = uid;
+    cache->seen_ms[slot] = now_ms;
+    return true;
+}
@@ -0,0 +1,84 @@
+#pragma once
+
+/*
+ * Card UIDs as fixed-size values, independent of Arduino.
+ *
+ * A UID never goes through a String: it is kept in a std::array and
+ * formatted into a fixed char array, at compile time for constant UIDs.
+ * The hold-off cache turns repeated reads of a card left on the reader
+ * into a single event.
+ */
+
+#include <array>
+#include <stddef.h>
+#include <stdint.h>
+
+#define RFID_UID_MAX_LENGTH 10 // Triple size UID
+#define RFID_UID_CACHE_SIZE 4  // Cards remembered at the same time
+#define RFID_HOLD_OFF_MS 2000  // A card read again within this time is still the same tap
+
+/// Card UID, bytes past size are zero.
+struct RfidUid
+{
+    std::array<uint8_t, RFID_UID_MAX_LENGTH> bytes;
+    uint8_t size; ///< 4, 7 or 10 bytes.
+};
+
+/// UID as lowercase hex, two digits per byte, NUL terminated.
+using RfidUidText = std::array<char, 2 * RFID_UID_MAX_LENGTH + 1>;
+
+/// Recently read UIDs, zero-initialized before first use.
+struct RfidUidCache
+{
+    RfidUid uids[RFID_UID_CACHE_SIZE];
+    uint32_t seen_ms[RFID_UID_CACHE_SIZE]; ///< Time of the last read of each UID.
+    uint8_t count;
+};
+
+constexpr bool operator==(const RfidUid &a, const RfidUid &b)
+{
+    if (a.size != b.size)
+    {
+        return false;
+    }
+    for (uint8_t i = 0; i < a.size; i++)
+    {
+        if (a.bytes[i] != b.bytes[i])
+        {
+            return false;
+        }
+    }
+    return true;
+}
+
+/**
+ * @brief Formats a UID as hex, keeping leading zeros of every byte.
+ *
+ * @param uid UID to format.
+ * @return Text of the UID.
+ */
+constexpr RfidUidText rfid_uid_format(const RfidUid &uid)
+{
+    constexpr char digits[] = "0123456789abcdef";
+    RfidUidText text = {};
+    for (uint8_t i = 0; i < uid.size && i < RFID_UID_MAX_LENGTH; i++)
+    {
+        text[2 * i] = digits[uid.bytes[i] >> 4];
+        text[2 * i + 1] = digits[uid.bytes[i] & 0x0F];
+    }
+    return text;
+}
+
+/**
+ * @brief Records a read and tells whether it starts a new tap.
+ *
+ * Every read restarts the hold-off of its UID, so a card that keeps being
+ * read produces one event however long it stays on the reader. When the
+ * cache is full, the UID read longest ago is forgotten.
+ *
+ * @param cache Cache of recent UIDs.
+ * @param uid UID just read.
+ * @param now_ms Current time in milliseconds.
+ * @return true for a new tap, false for a repeated read of the same tap.
+ */
+bool rfid_uid_cache_seen(RfidUidCache *cache, const RfidUid &uid, uint32_t now_ms);
@@ -5,13 +5,39 @@
 TaskHandle_t wifiTaskHandle = NULL;
 TaskHandle_t rfidTaskHandle = NULL;
 TaskHandle_t pinpadTaskHandle = NULL;
+TaskHandle_t keypadTaskHandle = NULL;
 TaskHandle_t mqttTaskHandle = NULL;
 TaskHandle_t buttonTaskHandle = NULL;
 
+WiFiManager wifiManager;
+MqttManager mqttManager;
+Button button(BUTTON_PIN);
+
 bool esp_setup()
 {
     ESP_LOGI(SCHEDULING_TAG, "Setting up ESP...");
 
+    if (!button.begin())
+    {
+        ESP_LOGE(SCHEDULING_TAG, "Failed to initialize Button");
+        return false;
+    }
+
+    wifiManager.begin();
+    mqttManager.begin();
+
+    if (!init_credentials())
+    {
+        ESP_LOGE(SCHEDULING_TAG, "Failed to initialize Credential Cache");
+        return false;
+    }
+
+    if (!init_access_log())
+    {
+        ESP_LOGE(SCHEDULING_TAG, "Failed to initialize Access Log");
+        return false;
+    }
+
     if (!init_RFID())
     {
         ESP_LOGE(SCHEDULING_TAG, "Failed to initialize RFID");
@@ -39,6 +65,51 @@ bool init_scheduling()
 
     BaseType_t result;
 
+    result = xTaskCreatePinnedToCore(
+        buttonTask,
+        "Button Task",
+        BUTTON_TASK_STACK_SIZE,
+        NULL,
+        BUTTON_TASK_PRIORITY,
+        &buttonTaskHandle,
+        BUTTON_CORE);
+
+    if (result != pdPASS)
+    {
+        ESP_LOGE(SCHEDULING_TAG, "Failed to create Button Task");
+        return false;
+    }
+
+    result = xTaskCreatePinnedToCore(
+        wifiTask,
+        "WiFi Task",
+        WIFI_TASK_STACK_SIZE,
+        NULL,
+        WIFI_TASK_PRIORITY,
+        &wifiTaskHandle,
+        WIFI_CORE);
+
+    if (result != pdPASS)
+    {
+        ESP_LOGE(SCHEDULING_TAG, "Failed to create WiFi Task");
+        return false;
+    }
+
+    result = xTaskCreatePinnedToCore(
+        mqttTask,
+        "MQTT Task",
+        MQTT_TASK_STACK_SIZE,
+        NULL,
+        MQTT_TASK_PRIORITY,
+        &mqttTaskHandle,
+        MQTT_CORE);
+
+    if (result != pdPASS)
+    {
+        ESP_LOGE(SCHEDULING_TAG, "Failed to create MQTT Task");
+        return false;
+    }
+
     result = xTaskCreatePinnedToCore(
         rfidTask,
         "RFID Task",
@@ -69,6 +140,21 @@ bool init_scheduling()
         return false;
     }
 
+    result = xTaskCreatePinnedToCore(
+        keypadTask,
+        "Keypad Task",
+        KEYPAD_TASK_STACK_SIZE,
+        NULL,
+        KEYPAD_TASK_PRIORITY,
+        &keypadTaskHandle,
+        KEYPAD_CORE);
+
+    if (result != pdPASS)
+    {
+        ESP_LOGE(SCHEDULING_TAG, "Failed to create Keypad Task");
+        return false;
+    }
+
 
     ESP_LOGI(SCHEDULING_TAG, "Scheduling initialized successfully.");
     return true;
@@ -78,7 +164,7 @@ void wifiTask(void *pvParameters)
 {
     while (1)
     {
-        handle_wifi();
+        wifiManager.handle();
         vTaskDelay(WIFI_RECONNECT_FREQ / portTICK_PERIOD_MS);
     }
 }
@@ -87,8 +173,7 @@ void rfidTask(void *pvParameters)
 {
     while (1)
     {
-        handle_RFID();
-        vTaskDelay(RFID_READ_FREQ / portTICK_PERIOD_MS);
+        handle_RFID(); // Waits on the reader IRQ, no delay needed
     }
 }
 
@@ -96,8 +181,24 @@ void pinpadTask(void *pvParameters)
 {
     while (1)
     {
-        handle_pinpad();
-        vTaskDelay(PINPAD_READ_FREQ / portTICK_PERIOD_MS);
+        handle_pinpad(); // Waits on the key event queue, no delay needed
+    }
+}
+
+void keypadTask(void *pvParameters)
+{
+    while (1)
+    {
+        handle_keypad(); // Waits on the key interrupts, no delay needed
+    }
+}
+
+void buttonTask(void *pvParameters)
+{
+    while (1)
+    {
+        button.handle();
+        vTaskDelay(BUTTON_READ_FREQ / portTICK_PERIOD_MS);
     }
 }
 
@@ -105,7 +206,9 @@ void mqttTask(void *pvParameters)
 {
     while (1)
     {
-        handle_mqtt();
+        mqttManager.handle();
+        handle_credentials();
+        handle_access_log();
         vTaskDelay(MQTT_READ_FREQ / portTICK_PERIOD_MS);
     }
 }
\ No newline at end of file
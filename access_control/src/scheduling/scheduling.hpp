@@ -4,13 +4,23 @@
 #include "freertos/FreeRTOS.h"
 #include "freertos/task.h"
 
+#include "network/wifi/wifi.hpp"
+#include "network/mqtt/mqtt.hpp"
+#include "network/button/button.hpp"
+#include "network/access_point/access_point.hpp"
 #include "../rfid/rfid.hpp"
 #include "../pinpad/pinpad.hpp"
+#include "../credentials/credentials.hpp"
+#include "../access_log/access_log.hpp"
+
+/* Configuration button (GPIO 13 is used by the keypad) */
+#define BUTTON_PIN 4
 
 /* Task priorities */
 #define WIFI_TASK_PRIORITY 0
 #define RFID_TASK_PRIORITY 1
 #define PINPAD_TASK_PRIORITY 2
+#define KEYPAD_TASK_PRIORITY 4 // Scans ahead of the consumers so no press is missed
 #define MQTT_TASK_PRIORITY 5
 #define BUTTON_TASK_PRIORITY 3
 
@@ -18,6 +28,7 @@
 #define WIFI_CORE 0
 #define RFID_CORE 1
 #define PINPAD_CORE 0
+#define KEYPAD_CORE 1
 #define MQTT_CORE 0
 #define BUTTON_CORE 1
 
@@ -25,16 +36,20 @@
 #define WIFI_TASK_STACK_SIZE 4096
 #define RFID_TASK_STACK_SIZE 4096
 #define PINPAD_TASK_STACK_SIZE 4096
+#define KEYPAD_TASK_STACK_SIZE 2048
 #define MQTT_TASK_STACK_SIZE 4096
 #define BUTTON_TASK_STACK_SIZE 2048
 
 /* Event frequencies in ms */
 #define WIFI_RECONNECT_FREQ 1000
-#define RFID_READ_FREQ 300
-#define PINPAD_READ_FREQ 100
+// RFID_READ_FREQ and PINPAD_READ_FREQ: see rfid.hpp and pinpad.hpp
 #define MQTT_READ_FREQ 100
 #define BUTTON_READ_FREQ 10
 
+/* Network managers shared with the modules publishing events */
+extern WiFiManager wifiManager;
+extern MqttManager mqttManager;
+
 /**
  * @brief Sets up the ESP32 system, initializes components, and starts scheduling.
  *
@@ -69,7 +84,8 @@ void wifiTask(void *pvParameters);
 /**
  * @brief Task to handle RFID module activities.
  *
- * This task manages RFID card reading and processing.
+ * This task manages RFID card reading and processing. It blocks in
+ * handle_RFID() until the reader signals a card.
  *
  * @param pvParameters Pointer to parameters passed to the task.
  */
@@ -78,12 +94,33 @@ void rfidTask(void *pvParameters);
 /**
  * @brief Task to handle pinpad module activities.
  *
- * This task manages pinpad keypresses and PIN entry.
+ * This task manages pinpad keypresses and PIN entry. It blocks in
+ * handle_pinpad() until the keypad task queues a press.
  *
  * @param pvParameters Pointer to parameters passed to the task.
  */
 void pinpadTask(void *pvParameters);
 
+/**
+ * @brief Task to scan the keypad.
+ *
+ * This task sleeps until a key interrupt, scans the matrix while keys
+ * are down and queues the presses for the pinpad task.
+ *
+ * @param pvParameters Pointer to parameters passed to the task.
+ */
+void keypadTask(void *pvParameters);
+
+/**
+ * @brief Task to handle the configuration button.
+ *
+ * This task debounces the button and launches the configuration
+ * Access Point on a long press.
+ *
+ * @param pvParameters Pointer to parameters passed to the task.
+ */
+void buttonTask(void *pvParameters);
+
 /**
  * @brief Task to handle MQTT module activities.
  *
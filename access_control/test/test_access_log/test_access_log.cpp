@@ -0,0 +1,229 @@
+/*
+ * Access log on a file-backed partition: a long history of accesses
+ * appended with uploads every few accesses, a reboot and a reset in the
+ * middle of a write on the way, then a query of the last day. The
+ * history runs once before the tests, which check what it left.
+ */
+
+#include <unity.h>
+#include <stdio.h>
+#include <unistd.h>
+#include "hal/hal.hpp"
+#include "hal/linux/hal_fake.hpp"
+#include "access_log/access_log_ring.hpp"
+
+#define LOG_FILE "/tmp/access_control_accesslog.bin"
+#define LOG_SIZE 0x20000    // Size in partitions.csv
+#define RECORDS 20000
+#define UPLOAD_EVERY 40     // Accesses between two uploads
+#define CHUNK_SIZE 1024     // ACCESS_LOG_CHUNK_SIZE of the target
+#define REBOOT_AT (RECORDS / 2)
+#define TORN_AT (RECORDS / 2 + 100)
+#define QUERY_MAX 256
+
+static AccessRecord history[RECORDS]; // Every access appended, with its stored fields
+static AccessLogRing ring;
+
+/// What the run left for the tests.
+static struct
+{
+    bool appended;
+    bool uploads_decoded;
+    uint32_t chunks;
+    uint64_t bytes;
+    uint32_t records_sent;
+    bool reopened, reopened_same;
+    bool torn_reopened, torn_skipped;
+    uint32_t last_time;
+} run;
+
+static bool same_access(const AccessRecord &a, const AccessRecord &b)
+{
+    return a.sequence == b.sequence && a.time == b.time && a.credential == b.credential && a.boot == b.boot &&
+           a.reader == b.reader && a.decision == b.decision &&
+           (a.flags & ACCESS_FLAG_UPTIME) == (b.flags & ACCESS_FLAG_UPTIME);
+}
+
+/* Uploads what is waiting in chunks, checking every chunk decodes to the records read */
+static bool upload()
+{
+    static AccessRecord records[128], decoded[ACCESS_LOG_CHUNK_MAX_RECORDS];
+    uint8_t chunk[CHUNK_SIZE];
+    while (true)
+    {
+        uint32_t sequence = ring.upload_next;
+        size_t count = access_log_ring_read(&ring, &sequence, records, 128);
+        if (count == 0)
+        {
+            return true;
+        }
+        size_t encoded;
+        size_t length = access_log_encode(records, count, chunk, sizeof(chunk), &encoded);
+        if (access_log_decode(chunk, length, decoded, ACCESS_LOG_CHUNK_MAX_RECORDS) != encoded)
+        {
+            return false;
+        }
+        for (size_t i = 0; i < encoded; i++)
+        {
+            if (!same_access(decoded[i], records[i]))
+            {
+                return false;
+            }
+        }
+        run.chunks++;
+        run.bytes += length;
+        run.records_sent += encoded;
+        if (!access_log_ring_mark_uploaded(&ring, encoded < count ? records[encoded].sequence : sequence))
+        {
+            return false;
+        }
+    }
+}
+
+/* A few regular cards and PINs, some unknown cards, a clock set after the first accesses */
+static void run_history()
+{
+    uint64_t credentials[8];
+    for (int i = 0; i < 8; i++)
+    {
+        credentials[i] = 0x04A1B2C3D40000ULL + (uint64_t)i * 0x1111;
+    }
+    uint32_t seed = 11, time = 1750000000;
+    run.appended = run.uploads_decoded = true;
+    for (int i = 0; i < RECORDS && run.appended && run.uploads_decoded; i++)
+    {
+        seed = seed * 1664525 + 1013904223;
+        AccessRecord record = {};
+        bool unknown = (seed >> 8) % 10 == 0;
+        record.reader = (seed >> 12) % 3 == 0 ? ACCESS_READER_PINPAD : ACCESS_READER_RFID;
+        record.decision = unknown ? ACCESS_DENIED : ACCESS_GRANTED;
+        record.credential = unknown ? (record.reader == ACCESS_READER_RFID ? 0x0800000000ULL + seed : 0)
+                                    : credentials[(seed >> 16) % 8];
+        time += 5 + (seed >> 20) % 900;
+        record.time = i < 20 ? i * 7 : time;
+        record.flags = i < 20 ? ACCESS_FLAG_UPTIME : 0;
+        run.appended = access_log_ring_append(&ring, &record);
+        history[i] = record;
+
+        if ((i + 1) % UPLOAD_EVERY == 0)
+        {
+            run.uploads_decoded = upload();
+        }
+
+        if (i == REBOOT_AT)
+        {
+            // Reboot: the position, the upload progress and the boot number come back from flash
+            AccessLogRing reopened;
+            run.reopened = access_log_ring_open(&reopened, ring.partition);
+            run.reopened_same = reopened.next_sequence == ring.next_sequence && reopened.upload_next == ring.upload_next &&
+                                reopened.head == ring.head && reopened.boot == ring.boot + 1;
+            ring = reopened;
+        }
+        else if (i == TORN_AT)
+        {
+            // Reset in the middle of a write: half a record in the next slot
+            uint8_t half[sizeof(AccessRecord) / 2] = {0x12, 0x34};
+            size_t offset = (ring.head / ACCESS_LOG_RECORDS_PER_SECTOR) * HAL_FLASH_SECTOR_SIZE +
+                            (ring.head % ACCESS_LOG_RECORDS_PER_SECTOR) * sizeof(AccessRecord);
+            hal_partition_write(ring.partition, offset, half, sizeof(half));
+            AccessLogRing reopened;
+            run.torn_reopened = access_log_ring_open(&reopened, ring.partition);
+            run.torn_skipped = reopened.next_sequence == ring.next_sequence &&
+                               reopened.head == (ring.head + 1) % (reopened.sectors * ACCESS_LOG_RECORDS_PER_SECTOR);
+            ring = reopened;
+        }
+    }
+    run.uploads_decoded = run.uploads_decoded && upload();
+    run.last_time = time;
+}
+
+void setUp()
+{
+}
+
+void tearDown()
+{
+}
+
+static void test_appended_and_uploaded()
+{
+    TEST_ASSERT_TRUE(run.appended);
+    TEST_ASSERT_TRUE(run.uploads_decoded);
+    TEST_ASSERT_EQUAL_UINT32(RECORDS, run.records_sent);
+    TEST_ASSERT_EQUAL_UINT32(0, ring.dropped);
+    TEST_ASSERT_EQUAL_UINT32(ring.next_sequence, ring.upload_next);
+
+    uint32_t passes = ring.next_sequence / (ring.sectors * ACCESS_LOG_RECORDS_PER_SECTOR) + 1;
+    char message[192];
+    snprintf(message, sizeof(message),
+             "%d accesses in %lu chunks, %.1f bytes per record uploaded (%u stored), %lu records kept, "
+             "max %lu erases per sector over %lu passes",
+             RECORDS, (unsigned long)run.chunks, (double)run.bytes / run.records_sent, (unsigned)sizeof(AccessRecord),
+             (unsigned long)(ring.next_sequence - ring.oldest), (unsigned long)hal_fake_flash_max_erases("accesslog"),
+             (unsigned long)passes);
+    TEST_MESSAGE(message);
+}
+
+static void test_reboot()
+{
+    TEST_ASSERT_TRUE(run.reopened);
+    TEST_ASSERT_TRUE(run.reopened_same);
+}
+
+static void test_torn_record()
+{
+    TEST_ASSERT_TRUE(run.torn_reopened);
+    TEST_ASSERT_TRUE(run.torn_skipped);
+}
+
+/* The last day: every access of that day still stored, and nothing else */
+static void test_time_query()
+{
+    uint32_t from = run.last_time - 86400, to = run.last_time;
+    uint32_t sequence = access_log_ring_seek_time(&ring, from);
+    static AccessRecord found[QUERY_MAX];
+    size_t found_count = 0;
+    AccessRecord block[64];
+    for (size_t count; (count = access_log_ring_read(&ring, &sequence, block, 64)) > 0;)
+    {
+        for (size_t i = 0; i < count; i++)
+        {
+            if (!(block[i].flags & ACCESS_FLAG_UPTIME) && block[i].time >= from && block[i].time <= to)
+            {
+                TEST_ASSERT_LESS_THAN_UINT(QUERY_MAX, found_count);
+                found[found_count++] = block[i];
+            }
+        }
+    }
+    TEST_ASSERT_GREATER_THAN_UINT(0, found_count);
+
+    size_t expected_count = 0;
+    for (const AccessRecord &record : history)
+    {
+        if (!(record.flags & ACCESS_FLAG_UPTIME) && record.time >= from && record.time <= to)
+        {
+            TEST_ASSERT_LESS_THAN_UINT(found_count, expected_count);
+            TEST_ASSERT_TRUE(same_access(found[expected_count], record));
+            expected_count++;
+        }
+    }
+    TEST_ASSERT_EQUAL_UINT(expected_count, found_count);
+}
+
+int main()
+{
+    unlink(LOG_FILE);
+    if (!hal_fake_flash_add_partition("accesslog", LOG_SIZE, LOG_FILE) ||
+        !access_log_ring_open(&ring, hal_partition_find("accesslog")))
+    {
+        return 1;
+    }
+    run_history();
+
+    UNITY_BEGIN();
+    RUN_TEST(test_appended_and_uploaded);
+    RUN_TEST(test_reboot);
+    RUN_TEST(test_torn_record);
+    RUN_TEST(test_time_query);
+    return UNITY_END();
+}
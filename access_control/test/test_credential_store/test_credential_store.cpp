@@ -0,0 +1,239 @@
+/*
+ * Credential store on the host: card lookups, deltas, and the PIN check
+ * against a full table of salted hashes, timed for the first entry, the
+ * last one and no entry. Card lookups are timed in a store holding
+ * CREDENTIAL_MAX_UIDS cards, like the CREDENTIAL_BENCHMARK boot check of
+ * the target.
+ */
+
+#include <unity.h>
+#include <stdio.h>
+#include <string.h>
+#include <algorithm>
+#include <chrono>
+#include "hal/hal.hpp"
+#include "credentials/credential_store.hpp"
+#include "latency/latency_stats.hpp"
+
+#define PIN_ROUNDS 2000
+#define LOOKUP_ROUNDS LATENCY_MAX_SAMPLES
+
+static CredentialStore store;
+static CredentialPin pins[CREDENTIAL_MAX_PINS];
+static uint64_t full_uids[CREDENTIAL_MAX_UIDS]; // Sorted, 4- and 7-byte cards alternating
+
+static const uint8_t card_a[4] = {0x04, 0xA0, 0x0B, 0xFF};
+static const uint8_t card_b[7] = {0x04, 0x00, 0x0A, 0xB0, 0x00, 0x00, 0x01};
+
+static uint64_t now_ns()
+{
+    return std::chrono::duration_cast<std::chrono::nanoseconds>(
+               std::chrono::steady_clock::now().time_since_epoch())
+        .count();
+}
+
+/* PIN i of the table: six digits and a salt */
+static void make_pin(int i, char pin[7], CredentialPin *credential)
+{
+    uint8_t message[CREDENTIAL_SALT_LENGTH + 6];
+    snprintf(pin, 7, "%06u", (100000u + (unsigned)i * 7919u) % 1000000u);
+    for (int j = 0; j < CREDENTIAL_SALT_LENGTH; j++)
+    {
+        credential->salt[j] = (uint8_t)(i * 31 + j);
+    }
+    memcpy(message, credential->salt, CREDENTIAL_SALT_LENGTH);
+    memcpy(message + CREDENTIAL_SALT_LENGTH, pin, 6);
+    hal_sha256(message, sizeof(message), credential->hash);
+}
+
+/* Card i of a generated population, 4 bytes for even i and 7 for odd */
+static uint64_t make_uid(uint32_t i)
+{
+    uint8_t uid[7];
+    uint32_t seed = i * 2654435761u + 12345;
+    for (int j = 0; j < 7; j++)
+    {
+        seed = seed * 1664525 + 1013904223;
+        uid[j] = (uint8_t)(seed >> 24);
+    }
+    return credential_uid_key(uid, (i & 1) ? 7 : 4);
+}
+
+static bool apply(const char *delta)
+{
+    return credential_store_apply_delta(&store, delta, strlen(delta)) == CREDENTIAL_DELTA_APPLIED;
+}
+
+void setUp()
+{
+    credential_store_clear(&store);
+}
+
+void tearDown()
+{
+}
+
+static void test_uid_lookup()
+{
+    uint64_t keys[2] = {credential_uid_key(card_a, 4), credential_uid_key(card_b, 7)};
+    if (keys[0] > keys[1])
+    {
+        uint64_t key = keys[0];
+        keys[0] = keys[1];
+        keys[1] = key;
+    }
+    TEST_ASSERT_TRUE(credential_store_load(&store, 1, keys, 2, NULL, 0));
+    TEST_ASSERT_TRUE(credential_store_has_uid(&store, credential_uid_key(card_a, 4)));
+    TEST_ASSERT_TRUE(credential_store_has_uid(&store, credential_uid_key(card_b, 7)));
+    TEST_ASSERT_FALSE(credential_store_has_uid(&store, credential_uid_key(card_b, 4))); // Same first bytes
+
+    // Unsorted content is refused
+    uint64_t unsorted[2] = {keys[1], keys[0]};
+    TEST_ASSERT_FALSE(credential_store_load(&store, 2, unsorted, 2, NULL, 0));
+}
+
+static void test_delta()
+{
+    TEST_ASSERT_TRUE(apply("v 0 1\n+u 04a00bff\n+u 04000ab0000001\n"));
+    TEST_ASSERT_EQUAL_UINT32(1, store.version);
+    TEST_ASSERT_EQUAL_UINT16(2, store.uid_count);
+
+    // Lines apply in order: added then removed ends up absent
+    TEST_ASSERT_TRUE(apply("v 1 2\n-u 04a00bff\n+u 0102030405\n-u 0102030405\n"));
+    TEST_ASSERT_FALSE(credential_store_has_uid(&store, credential_uid_key(card_a, 4)));
+    TEST_ASSERT_TRUE(credential_store_has_uid(&store, credential_uid_key(card_b, 7)));
+    TEST_ASSERT_EQUAL_UINT16(1, store.uid_count);
+
+    TEST_ASSERT_EQUAL_INT(CREDENTIAL_DELTA_STALE, credential_store_apply_delta(&store, "v 1 3\n", 6));
+    TEST_ASSERT_EQUAL_INT(CREDENTIAL_DELTA_INVALID, credential_store_apply_delta(&store, "v 2 3\n+u zz\n", 12));
+    TEST_ASSERT_EQUAL_UINT32(2, store.version); // Unchanged
+
+    // A full sync starts from any version
+    TEST_ASSERT_TRUE(apply("v 7 8\nc\n+u 04a00bff\n"));
+    TEST_ASSERT_EQUAL_UINT32(8, store.version);
+    TEST_ASSERT_EQUAL_UINT16(1, store.uid_count);
+    TEST_ASSERT_TRUE(credential_store_has_uid(&store, credential_uid_key(card_a, 4)));
+
+    // A clear after other items is refused rather than dropping them
+    const char *late_clear = "v 8 9\n+u 04000ab0000001\nc\n";
+    TEST_ASSERT_EQUAL_INT(CREDENTIAL_DELTA_INVALID, credential_store_apply_delta(&store, late_clear, strlen(late_clear)));
+    const char *second_clear = "v 8 9\nc\nc\n";
+    TEST_ASSERT_EQUAL_INT(CREDENTIAL_DELTA_INVALID, credential_store_apply_delta(&store, second_clear, strlen(second_clear)));
+    TEST_ASSERT_EQUAL_UINT32(8, store.version);
+    TEST_ASSERT_EQUAL_UINT16(1, store.uid_count);
+}
+
+static void test_pin_match()
+{
+    TEST_ASSERT_TRUE(credential_store_load(&store, 1, NULL, 0, pins, CREDENTIAL_MAX_PINS));
+    char pin[7];
+    for (int i = 0; i < CREDENTIAL_MAX_PINS; i += 9)
+    {
+        CredentialPin unused;
+        make_pin(i, pin, &unused);
+        uint8_t match = 0xFF;
+        TEST_ASSERT_TRUE(credential_store_check_pin(&store, pin, 6, &match));
+        TEST_ASSERT_EQUAL_UINT8(i, match);
+    }
+    TEST_ASSERT_FALSE(credential_store_check_pin(&store, "000000", 6, NULL));
+    TEST_ASSERT_FALSE(credential_store_check_pin(&store, pin, 5, NULL)); // Prefix of a PIN
+}
+
+static void test_pin_too_long()
+{
+    TEST_ASSERT_TRUE(credential_store_load(&store, 1, NULL, 0, pins, CREDENTIAL_MAX_PINS));
+    TEST_ASSERT_FALSE(credential_store_check_pin(&store, "1000000000000", CREDENTIAL_PIN_MAX_LENGTH + 1, NULL));
+}
+
+/* Every hash is computed whatever matches, so the three cases cost the same */
+static void test_pin_cost()
+{
+    TEST_ASSERT_TRUE(credential_store_load(&store, 1, NULL, 0, pins, CREDENTIAL_MAX_PINS));
+    char first[7], last[7];
+    snprintf(first, sizeof(first), "%06d", 100000);
+    snprintf(last, sizeof(last), "%06d", 100000 + (CREDENTIAL_MAX_PINS - 1) * 7919);
+    const char *cases[] = {first, last, "000000"};
+    uint64_t case_ns[3];
+    for (int c = 0; c < 3; c++)
+    {
+        uint32_t allowed = 0;
+        uint64_t start = now_ns();
+        for (int i = 0; i < PIN_ROUNDS; i++)
+        {
+            allowed += credential_store_check_pin(&store, cases[c], 6, NULL);
+        }
+        case_ns[c] = now_ns() - start;
+        TEST_ASSERT_EQUAL_UINT32(c < 2 ? PIN_ROUNDS : 0, allowed);
+    }
+
+    char message[128];
+    snprintf(message, sizeof(message), "PIN check against %d hashes: first entry %.1f us, last entry %.1f us, no entry %.1f us",
+             CREDENTIAL_MAX_PINS, case_ns[0] / 1e3 / PIN_ROUNDS, case_ns[1] / 1e3 / PIN_ROUNDS,
+             case_ns[2] / 1e3 / PIN_ROUNDS);
+    TEST_MESSAGE(message);
+}
+
+/* Lookups in a full store: every known card found, no card of another population, p50/p95/p99 reported */
+static void test_full_store_lookups()
+{
+    TEST_ASSERT_TRUE(credential_store_load(&store, 1, full_uids, CREDENTIAL_MAX_UIDS, pins, CREDENTIAL_MAX_PINS));
+    TEST_ASSERT_EQUAL_UINT16(CREDENTIAL_MAX_UIDS, store.uid_count);
+
+    LatencyStage lookups[2] = {{"known card", LATENCY_CPU}, {"unknown card", LATENCY_CPU}};
+    uint32_t found = 0, false_hits = 0;
+    for (uint32_t i = 0; i < LOOKUP_ROUNDS; i++)
+    {
+        uint64_t known = full_uids[(i * 7919) % CREDENTIAL_MAX_UIDS];
+        uint64_t unknown = make_uid(CREDENTIAL_MAX_UIDS + i);
+        uint64_t start = now_ns();
+        found += credential_store_has_uid(&store, known);
+        uint64_t middle = now_ns();
+        false_hits += credential_store_has_uid(&store, unknown);
+        uint64_t end = now_ns();
+        latency_record(&lookups[0], middle - start);
+        latency_record(&lookups[1], end - middle);
+    }
+    TEST_ASSERT_EQUAL_UINT32(LOOKUP_ROUNDS, found);
+    TEST_ASSERT_EQUAL_UINT32(0, false_hits);
+
+    for (LatencyStage &stage : lookups)
+    {
+        char message[128];
+        snprintf(message, sizeof(message), "%-12s lookup in %d cards: p50 %lu ns, p95 %lu ns, p99 %lu ns, max %lu ns",
+                 stage.name, CREDENTIAL_MAX_UIDS, (unsigned long)latency_percentile(&stage, 50),
+                 (unsigned long)latency_percentile(&stage, 95), (unsigned long)latency_percentile(&stage, 99),
+                 (unsigned long)latency_percentile(&stage, 100));
+        TEST_MESSAGE(message);
+    }
+}
+
+int main()
+{
+    if (!credential_store_init(&store))
+    {
+        return 1;
+    }
+    for (int i = 0; i < CREDENTIAL_MAX_PINS; i++)
+    {
+        char pin[7];
+        make_pin(i, pin, &pins[i]);
+    }
+    for (uint32_t i = 0; i < CREDENTIAL_MAX_UIDS; i++)
+    {
+        full_uids[i] = make_uid(i);
+    }
+    std::sort(full_uids, full_uids + CREDENTIAL_MAX_UIDS);
+    if (std::unique(full_uids, full_uids + CREDENTIAL_MAX_UIDS) != full_uids + CREDENTIAL_MAX_UIDS)
+    {
+        return 1;
+    }
+
+    UNITY_BEGIN();
+    RUN_TEST(test_uid_lookup);
+    RUN_TEST(test_delta);
+    RUN_TEST(test_pin_match);
+    RUN_TEST(test_pin_too_long);
+    RUN_TEST(test_pin_cost);
+    RUN_TEST(test_full_store_lookups);
+    return UNITY_END();
+}
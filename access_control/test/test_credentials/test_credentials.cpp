@@ -0,0 +1,148 @@
+/*
+ * Credential cache against the uplink fake in virtual time: the version
+ * requested from the broker, deltas delivered on the delta topic, the
+ * copy saved to the file system once deltas stop, and what a reboot
+ * (init_credentials() again) finds there. The tests run in order, each
+ * one continuing from the state the previous one left.
+ */
+
+#include <unity.h>
+#include <stdio.h>
+#include <string.h>
+#include "hal/hal.hpp"
+#include "hal/linux/hal_fake.hpp"
+#include "hal/linux/hal_sim.hpp"
+#include "credentials/credentials.hpp"
+#include "uplink/uplink.hpp"
+
+#define SAVE_WAIT_MS 3000 // Past the quiet time before a save
+
+static const uint8_t card_a[4] = {0xDE, 0xAD, 0xBE, 0xEF};
+static const uint8_t card_b[7] = {0x04, 0x11, 0x22, 0x33, 0x44, 0x55, 0x66};
+
+static char request[16]; // Last version published on TOPIC_CREDENTIALS_REQUEST
+static uint32_t request_count = 0;
+
+static void on_publish(const char *topic, const uint8_t *payload, size_t length, void *ctx)
+{
+    (void)ctx;
+    if (strcmp(topic, TOPIC_CREDENTIALS_REQUEST) == 0 && length < sizeof(request))
+    {
+        memcpy(request, payload, length);
+        request[length] = '\0';
+        request_count++;
+    }
+}
+
+/* One pass of the MQTT task, then the virtual time to the next */
+static void run_ms(uint32_t ms)
+{
+    for (uint32_t elapsed = 0; elapsed < ms; elapsed += 100)
+    {
+        handle_credentials();
+        hal_delay_ms(100); // MQTT_READ_FREQ
+    }
+}
+
+void setUp()
+{
+}
+
+void tearDown()
+{
+}
+
+static void test_requests_version_when_connected()
+{
+    TEST_ASSERT_TRUE(init_credentials());
+    run_ms(200);
+    TEST_ASSERT_EQUAL_UINT32(1, request_count); // Once per connection
+    TEST_ASSERT_EQUAL_STRING("0", request);
+    TEST_ASSERT_FALSE(credentials_check_uid(card_a, sizeof(card_a)));
+}
+
+static void test_full_sync_then_delta()
+{
+    uplink_fake_deliver(TOPIC_CREDENTIALS_DELTA, "v 0 5\nc\n+u deadbeef\n");
+    TEST_ASSERT_TRUE(credentials_check_uid(card_a, sizeof(card_a)));
+    TEST_ASSERT_FALSE(credentials_check_uid(card_b, sizeof(card_b)));
+
+    uplink_fake_deliver(TOPIC_CREDENTIALS_DELTA, "v 5 6\n+u 04112233445566\n");
+    TEST_ASSERT_TRUE(credentials_check_uid(card_b, sizeof(card_b)));
+}
+
+/* A delta from another version is not applied and the version is asked again */
+static void test_stale_delta_requests_again()
+{
+    uint32_t before = request_count;
+    uplink_fake_deliver(TOPIC_CREDENTIALS_DELTA, "v 9 10\n-u deadbeef\n");
+    TEST_ASSERT_TRUE(credentials_check_uid(card_a, sizeof(card_a)));
+    run_ms(200);
+    TEST_ASSERT_EQUAL_UINT32(before + 1, request_count);
+    TEST_ASSERT_EQUAL_STRING("6", request);
+}
+
+/* Deltas are lost while disconnected, reconnecting asks for them */
+static void test_reconnect_requests_again()
+{
+    uint32_t before = request_count;
+    uplink_fake_set_connected(false);
+    uplink_fake_deliver(TOPIC_CREDENTIALS_DELTA, "v 6 7\n-u deadbeef\n");
+    run_ms(200);
+    uplink_fake_set_connected(true);
+    run_ms(200);
+    TEST_ASSERT_TRUE(credentials_check_uid(card_a, sizeof(card_a)));
+    TEST_ASSERT_EQUAL_UINT32(before + 1, request_count);
+    TEST_ASSERT_EQUAL_STRING("6", request);
+}
+
+/* Saved once deltas stop; a delta not saved yet is lost by a reboot */
+static void test_reboot_reloads_saved_copy()
+{
+    run_ms(SAVE_WAIT_MS);
+    uplink_fake_deliver(TOPIC_CREDENTIALS_DELTA, "v 6 7\n-u deadbeef\n");
+    TEST_ASSERT_FALSE(credentials_check_uid(card_a, sizeof(card_a)));
+
+    TEST_ASSERT_TRUE(init_credentials()); // Reboot before the save
+    TEST_ASSERT_TRUE(credentials_check_uid(card_a, sizeof(card_a)));
+    TEST_ASSERT_TRUE(credentials_check_uid(card_b, sizeof(card_b)));
+
+    uplink_fake_set_connected(false); // Announces the version read back from flash
+    run_ms(200);
+    uplink_fake_set_connected(true);
+    run_ms(200);
+    TEST_ASSERT_EQUAL_STRING("6", request);
+}
+
+/* A damaged copy is dropped, the cache waits for a full sync */
+static void test_corrupted_copy_ignored()
+{
+    char path[HAL_FS_PATH_MAX];
+    TEST_ASSERT_TRUE(hal_fs_path(CREDENTIALS_FILE, path, sizeof(path)));
+    FILE *file = fopen(path, "r+b");
+    TEST_ASSERT_NOT_NULL(file);
+    fseek(file, -1, SEEK_END);
+    int last = fgetc(file);
+    fseek(file, -1, SEEK_END);
+    fputc(last ^ 0x01, file);
+    fclose(file);
+
+    TEST_ASSERT_TRUE(init_credentials());
+    TEST_ASSERT_FALSE(credentials_check_uid(card_a, sizeof(card_a)));
+    TEST_ASSERT_FALSE(credentials_check_uid(card_b, sizeof(card_b)));
+}
+
+int main()
+{
+    hal_sim_begin();
+    uplink_fake_set_publish_hook(on_publish, NULL);
+
+    UNITY_BEGIN();
+    RUN_TEST(test_requests_version_when_connected);
+    RUN_TEST(test_full_sync_then_delta);
+    RUN_TEST(test_stale_delta_requests_again);
+    RUN_TEST(test_reconnect_requests_again);
+    RUN_TEST(test_reboot_reloads_saved_copy);
+    RUN_TEST(test_corrupted_copy_ignored);
+    return UNITY_END();
+}
@@ -0,0 +1,538 @@
+/*
+ * Door latency in virtual time: card taps on the simulated RC522 and PINs
+ * typed on the simulated keypad, decided by handle_RFID() and
+ * handle_pinpad() in their tasks. The store is full, CREDENTIAL_MAX_UIDS
+ * cards. Each path prints a latency table per stage and fails when the
+ * door opens later than its budget at p99.
+ *
+ * The store reaches credentials.cpp as deltas from the broker, through
+ * the uplink fake, and the MQTT task keeps running handle_credentials()
+ * and handle_access_log() meanwhile. The broker is out of the door path:
+ * decisions are local and the access log is uploaded later in batches,
+ * so no MQTT stage is timed. The check and append hooks of
+ * credentials.cpp and access_log.cpp time the lookups and appends.
+ */
+
+#include <unity.h>
+#include <stdio.h>
+#include <string.h>
+#include <time.h>
+#include <algorithm>
+#include "hal/hal.hpp"
+#include "hal/linux/hal_fake.hpp"
+#include "hal/linux/hal_sim.hpp"
+#include "rfid/rfid.hpp"
+#include "rfid/mfrc522_sim.hpp"
+#include "pinpad/pinpad.hpp"
+#include "pinpad/keypad_sim.hpp"
+#include "credentials/credentials.hpp"
+#include "access_log/access_log.hpp"
+#include "uplink/uplink.hpp"
+#include "latency/latency_stats.hpp"
+
+#define LOG_SIZE 0x20000 // Size in partitions.csv
+#define DELTA_UIDS 180   // Cards per delta, with the PINs below NETWORK_MQTT_BUFFER_SIZE
+#define DELTA_PINS 8     // PINs accepted per delta
+
+#define TAPS 200
+#define TAP_INTERVAL_US 3000000 // A tap lands at a random point of each interval
+#define TAP_LENGTH_US 300000    // Card held on the reader
+#define WOBBLE_US 150000        // The card briefly leaves the field this long into the tap
+#define UNKNOWN_EVERY 10        // Every 10th card and PIN is refused
+#define PINS 100
+#define TOO_LONG_EVERY 20 // Of the refused PINs, these get one digit too many instead of a wrong one
+#define PIN_MAX_KEYS (PIN_ENTRY_MAX_DIGITS + 3) // '*', the digits, '#'
+#define PIN_KEY_INTERVAL_US 300000
+#define PIN_KEY_HOLD_US 80000
+#define PIN_PAUSE_US 2000000 // Between two PINs
+#define KEY_BOUNCE_US 400    // Contact bounce after a press
+#define RFID_BUDGET_US 80000 // Card in the field to LED on, p99
+#define PIN_BUDGET_US 40000  // '#' pressed to LED on, p99
+
+struct Tap
+{
+    uint8_t uid[7];
+    uint8_t size;
+    uint64_t time_us;
+};
+
+struct KeyEdge
+{
+    char key;
+    bool down;
+};
+
+static Tap taps[TAPS];
+static volatile int current_tap = -1;
+static uint32_t event_count = 0, wrong_uid_count = 0, wrong_decision_count = 0;
+
+static char pins[PINS][7];
+static char pin_keys[PINS][PIN_MAX_KEYS + 1];
+static uint64_t pin_submit_us[PINS]; // '#' pressed
+static KeyEdge pin_edges[PINS][PIN_MAX_KEYS][4]; // Press, bounce up, bounce down, release
+static uint32_t pin_count = 0, pin_check_count = 0, too_long_count = 0, wrong_pin_decision_count = 0;
+
+static uint32_t delta_count = 0;
+static char request[16]; // Last version requested on TOPIC_CREDENTIALS_REQUEST
+static uint32_t log_chunks = 0;
+
+/* Decision in progress, the LED write closes it */
+static uint64_t to_task_ns = 0, decision_start_ns = 0, decided_ns = 0;
+static bool pin_checked = false;
+
+enum RfidStage
+{
+    RFID_TO_LOOKUP, // Card in the field to the lookup: REQA answer, UID read over SPI, repeat check
+    RFID_DECISION,  // Credential lookup
+    RFID_TAP_TO_DECISION,
+    RFID_ACTUATION,
+    RFID_DOOR_OPEN,
+    RFID_LOG_APPEND,
+    RFID_STAGES
+};
+
+static LatencyStage rfid_stages[RFID_STAGES] = {
+    {"card to lookup", LATENCY_SIM},
+    {"decision", LATENCY_CPU},
+    {"tap to decision", LATENCY_SUM},
+    {"actuation", LATENCY_CPU},
+    {"door open", LATENCY_SUM},
+    {"log append", LATENCY_CPU}};
+
+enum PinStage
+{
+    PIN_TO_CHECK, // '#' pressed to the check: interrupt, debounce, key queue, PIN entry and lockout
+    PIN_VERIFY,   // Hash comparison
+    PIN_ACTUATION,
+    PIN_DOOR_OPEN,
+    PIN_LOG_APPEND,
+    PIN_STAGES
+};
+
+static LatencyStage pin_stages[PIN_STAGES] = {
+    {"'#' to PIN check", LATENCY_SIM},
+    {"PIN verify", LATENCY_CPU},
+    {"actuation", LATENCY_CPU},
+    {"door open", LATENCY_SUM},
+    {"log append", LATENCY_CPU}};
+
+/* Real time, for the code that takes no virtual time */
+static uint64_t cpu_ns()
+{
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (uint64_t)ts.tv_sec * 1000000000ULL + (uint64_t)ts.tv_nsec;
+}
+
+/* PIN i of the store: six digits and a salt */
+static void make_pin(int i, char pin[7], CredentialPin *credential)
+{
+    uint8_t message[CREDENTIAL_SALT_LENGTH + 6];
+    snprintf(pin, 7, "%06d", 100000 + i * 7919);
+    for (int j = 0; j < CREDENTIAL_SALT_LENGTH; j++)
+    {
+        credential->salt[j] = (uint8_t)(i * 31 + j);
+    }
+    memcpy(message, credential->salt, CREDENTIAL_SALT_LENGTH);
+    memcpy(message + CREDENTIAL_SALT_LENGTH, pin, 6);
+    hal_sha256(message, sizeof(message), credential->hash);
+}
+
+static bool pin_refused(uint32_t i)
+{
+    return (i + 1) % UNKNOWN_EVERY == 0;
+}
+
+static bool pin_too_long(uint32_t i)
+{
+    return (i + 1) % TOO_LONG_EVERY == 0;
+}
+
+/* Times the lookups of credentials.cpp, the wait before them in virtual time */
+static void on_check(void *ctx, bool pin, bool done)
+{
+    (void)ctx;
+    if (!done)
+    {
+        uint64_t since_us = pin ? pin_submit_us[pin_count < PINS ? pin_count : PINS - 1] : taps[current_tap].time_us;
+        to_task_ns = (hal_micros() - since_us) * 1000;
+        decision_start_ns = cpu_ns();
+        return;
+    }
+    decided_ns = cpu_ns();
+    if (!pin)
+    {
+        latency_record(&rfid_stages[RFID_TO_LOOKUP], to_task_ns);
+        latency_record(&rfid_stages[RFID_DECISION], decided_ns - decision_start_ns);
+        latency_record(&rfid_stages[RFID_TAP_TO_DECISION], to_task_ns + decided_ns - decision_start_ns);
+    }
+    else if (pin_count < PINS)
+    {
+        latency_record(&pin_stages[PIN_TO_CHECK], to_task_ns);
+        latency_record(&pin_stages[PIN_VERIFY], decided_ns - decision_start_ns);
+        pin_checked = true;
+        pin_check_count++;
+    }
+}
+
+/* Times the appends of access_log.cpp, checking every decision against its tap or PIN */
+static void on_record(void *ctx, const AccessRecord *record, bool appended)
+{
+    (void)ctx;
+    static uint64_t append_start_ns = 0;
+    if (!appended)
+    {
+        append_start_ns = cpu_ns();
+        return;
+    }
+    uint64_t logged_ns = cpu_ns() - append_start_ns;
+
+    bool granted = record->decision == ACCESS_GRANTED;
+    if (record->reader == ACCESS_READER_RFID)
+    {
+        const Tap &tap = taps[current_tap];
+        wrong_uid_count += record->credential != credential_uid_key(tap.uid, tap.size);
+        wrong_decision_count += granted != ((current_tap + 1) % UNKNOWN_EVERY != 0);
+        latency_record(&rfid_stages[RFID_LOG_APPEND], logged_ns);
+        event_count++;
+    }
+    else if (pin_count < PINS)
+    {
+        if (!pin_checked) // Too long, refused before any check
+        {
+            latency_record(&pin_stages[PIN_TO_CHECK], (hal_micros() - pin_submit_us[pin_count]) * 1000);
+            too_long_count++;
+        }
+        wrong_pin_decision_count += granted == pin_refused(pin_count);
+        latency_record(&pin_stages[PIN_LOG_APPEND], logged_ns);
+        pin_checked = false;
+        pin_count++;
+    }
+}
+
+/* The door opens when a LED goes on */
+static void on_write(uint8_t pin, int level, uint64_t time_us, void *ctx)
+{
+    keypad_sim_on_write(pin, level, time_us, ctx);
+    if (level != HAL_HIGH || (pin != LED_RFID && pin != LED_PIN))
+    {
+        return;
+    }
+    uint64_t actuated_ns = cpu_ns();
+    LatencyStage *stages = pin == LED_RFID ? &rfid_stages[RFID_ACTUATION] : &pin_stages[PIN_ACTUATION];
+    latency_record(&stages[0], actuated_ns - decided_ns); // Actuation, then door open
+    latency_record(&stages[1], to_task_ns + actuated_ns - decision_start_ns);
+}
+
+static void place_card(void *ctx)
+{
+    Tap *tap = (Tap *)ctx;
+    current_tap = tap - taps;
+    mfrc522_sim_place_card(tap->uid, tap->size);
+}
+
+static void remove_card(void *ctx)
+{
+    (void)ctx;
+    mfrc522_sim_remove_card();
+}
+
+static void set_key(void *ctx)
+{
+    const KeyEdge *edge = (const KeyEdge *)ctx;
+    keypad_sim_set_key(edge->key, edge->down);
+}
+
+/* Task loops of scheduling.cpp */
+static void rfidTask(void *arg)
+{
+    (void)arg;
+    while (true)
+    {
+        handle_RFID();
+    }
+}
+
+static void keypadTask(void *arg)
+{
+    (void)arg;
+    while (true)
+    {
+        handle_keypad();
+    }
+}
+
+static void pinpadTask(void *arg)
+{
+    (void)arg;
+    while (true)
+    {
+        handle_pinpad();
+    }
+}
+
+static void mqttTask(void *arg)
+{
+    (void)arg;
+    while (true)
+    {
+        handle_credentials();
+        handle_access_log();
+        hal_delay_ms(100); // MQTT_READ_FREQ
+    }
+}
+
+/* Random 4- and 7-byte cards, each one tapped once with a wobble out of the field */
+static uint64_t schedule_taps(uint64_t start_us)
+{
+    uint32_t seed = 1;
+    for (int i = 0; i < TAPS; i++)
+    {
+        seed = seed * 1664525 + 1013904223;
+        taps[i].size = (i & 1) ? 7 : 4;
+        for (uint8_t j = 0; j < taps[i].size; j++)
+        {
+            taps[i].uid[j] = (uint8_t)(seed >> (4 * j));
+        }
+        // The cascade tag is not a valid first byte of the last UID part
+        uint8_t &first = taps[i].uid[taps[i].size - 4];
+        first = first == 0x88 ? 0x08 : first;
+        taps[i].time_us = start_us + (uint64_t)i * TAP_INTERVAL_US + seed % (TAP_INTERVAL_US - TAP_LENGTH_US);
+        hal_sim_at(taps[i].time_us, place_card, &taps[i]);
+        hal_sim_at(taps[i].time_us + WOBBLE_US, remove_card, NULL);
+        hal_sim_at(taps[i].time_us + WOBBLE_US + 5000, place_card, &taps[i]); // Back after 5 ms, woken from HALT
+        hal_sim_at(taps[i].time_us + TAP_LENGTH_US, remove_card, NULL);
+    }
+    return start_us + (uint64_t)TAPS * TAP_INTERVAL_US;
+}
+
+/*
+ * Types '*', a PIN and '#' on the simulated keypad, with bounce on every
+ * press. Every TOO_LONG_EVERY-th PIN gets 13 digits.
+ */
+static uint64_t schedule_pins(uint64_t time_us)
+{
+    for (int i = 0; i < PINS; i++)
+    {
+        if (pin_too_long(i))
+        {
+            snprintf(pin_keys[i], sizeof(pin_keys[i]), "*%.6s%.6s0#", pins[i], pins[i]);
+        }
+        else
+        {
+            snprintf(pin_keys[i], sizeof(pin_keys[i]), "*%.6s#", pins[i]);
+        }
+        for (int k = 0; pin_keys[i][k] != '\0'; k++)
+        {
+            KeyEdge *edges = pin_edges[i][k];
+            edges[0] = {pin_keys[i][k], true};
+            edges[1] = {pin_keys[i][k], false};
+            edges[2] = {pin_keys[i][k], true};
+            edges[3] = {pin_keys[i][k], false};
+            hal_sim_at(time_us, set_key, &edges[0]);
+            hal_sim_at(time_us + KEY_BOUNCE_US / 2, set_key, &edges[1]);
+            hal_sim_at(time_us + KEY_BOUNCE_US, set_key, &edges[2]);
+            hal_sim_at(time_us + PIN_KEY_HOLD_US, set_key, &edges[3]);
+            time_us += PIN_KEY_INTERVAL_US;
+        }
+        pin_submit_us[i] = time_us - PIN_KEY_INTERVAL_US;
+        time_us += PIN_PAUSE_US;
+    }
+    return time_us;
+}
+
+/* Writes bytes in hex, returns the number of characters */
+static size_t append_hex(char *text, const uint8_t *bytes, size_t length)
+{
+    for (size_t i = 0; i < length; i++)
+    {
+        sprintf(text + 2 * i, "%02x", bytes[i]);
+    }
+    return 2 * length;
+}
+
+/*
+ * Sends the store shared by both paths from the broker, as a full sync in
+ * deltas: every tap's card and the PINs, but every UNKNOWN_EVERY-th one,
+ * and generated 7-byte cards up to CREDENTIAL_MAX_UIDS.
+ */
+static bool send_door_credentials()
+{
+    static uint8_t uids[CREDENTIAL_MAX_UIDS][7];
+    static uint8_t sizes[CREDENTIAL_MAX_UIDS];
+    static uint64_t keys[CREDENTIAL_MAX_UIDS];
+    static CredentialPin credentials[CREDENTIAL_MAX_PINS];
+    static char delta[4096];
+    uint16_t uid_count = 0;
+    for (int i = 0; i < TAPS; i++)
+    {
+        if ((i + 1) % UNKNOWN_EVERY != 0)
+        {
+            memcpy(uids[uid_count], taps[i].uid, taps[i].size);
+            sizes[uid_count++] = taps[i].size;
+        }
+    }
+    uint32_t seed = 99;
+    while (uid_count < CREDENTIAL_MAX_UIDS)
+    {
+        for (uint8_t &byte : uids[uid_count])
+        {
+            seed = seed * 1664525 + 1013904223;
+            byte = (uint8_t)(seed >> 24);
+        }
+        sizes[uid_count++] = 7;
+    }
+    for (uint16_t i = 0; i < uid_count; i++)
+    {
+        keys[i] = credential_uid_key(uids[i], sizes[i]);
+    }
+    std::sort(keys, keys + uid_count);
+    if (std::unique(keys, keys + uid_count) - keys != CREDENTIAL_MAX_UIDS)
+    {
+        return false; // A duplicate would leave the store short of a full one
+    }
+    // PINs past the table reuse its entries, the refused ones are typed wrong instead
+    for (int i = 0; i < PINS; i++)
+    {
+        make_pin(i % CREDENTIAL_MAX_PINS, pins[i], &credentials[i % CREDENTIAL_MAX_PINS]);
+        if (pin_refused(i))
+        {
+            pins[i][0] = '0';
+        }
+    }
+
+    uint16_t next_uid = 0;
+    uint8_t next_pin = 0;
+    while (next_uid < uid_count || next_pin < CREDENTIAL_MAX_PINS)
+    {
+        size_t length = sprintf(delta, "v %lu %lu\n%s", (unsigned long)delta_count, (unsigned long)delta_count + 1,
+                                delta_count == 0 ? "c\n" : "");
+        for (int p = 0; p < DELTA_PINS && next_pin < CREDENTIAL_MAX_PINS; p++, next_pin++)
+        {
+            length += sprintf(delta + length, "+p ");
+            length += append_hex(delta + length, credentials[next_pin].salt, CREDENTIAL_SALT_LENGTH);
+            delta[length++] = ' ';
+            length += append_hex(delta + length, credentials[next_pin].hash, CREDENTIAL_HASH_LENGTH);
+            delta[length++] = '\n';
+        }
+        for (int u = 0; u < DELTA_UIDS && next_uid < uid_count; u++, next_uid++)
+        {
+            length += sprintf(delta + length, "+u ");
+            length += append_hex(delta + length, uids[next_uid], sizes[next_uid]);
+            delta[length++] = '\n';
+        }
+        delta[length] = '\0';
+        uplink_fake_deliver(TOPIC_CREDENTIALS_DELTA, delta);
+        delta_count++;
+    }
+    return true;
+}
+
+/* Keeps what the node sends to the broker */
+static void on_publish(const char *topic, const uint8_t *payload, size_t length, void *ctx)
+{
+    (void)ctx;
+    if (strcmp(topic, TOPIC_CREDENTIALS_REQUEST) == 0 && length < sizeof(request))
+    {
+        memcpy(request, payload, length);
+        request[length] = '\0';
+    }
+    else if (strcmp(topic, TOPIC_ACCESS_LOG) == 0)
+    {
+        log_chunks++;
+    }
+}
+
+void setUp()
+{
+}
+
+void tearDown()
+{
+}
+
+static void test_rfid_decisions()
+{
+    TEST_ASSERT_EQUAL_UINT32(TAPS, event_count);
+    TEST_ASSERT_EQUAL_UINT32(0, wrong_uid_count);
+    TEST_ASSERT_EQUAL_UINT32(0, wrong_decision_count);
+    TEST_ASSERT_EQUAL_UINT32(TAPS - TAPS / UNKNOWN_EVERY, rfid_stages[RFID_DOOR_OPEN].count);
+}
+
+static void test_rfid_budget()
+{
+    latency_print("RFID, card in the field", rfid_stages, RFID_STAGES);
+    uint64_t door_p99_ns = latency_percentile(&rfid_stages[RFID_DOOR_OPEN], 99);
+    TEST_ASSERT_LESS_OR_EQUAL_UINT32(RFID_BUDGET_US, (uint32_t)(door_p99_ns / 1000));
+
+    char message[192];
+    snprintf(message, sizeof(message), "%d taps, %d cards stored, tap to decision p50 %lu us p99 %lu us, "
+             "door open p99 %lu us",
+             TAPS, CREDENTIAL_MAX_UIDS,
+             (unsigned long)(latency_percentile(&rfid_stages[RFID_TAP_TO_DECISION], 50) / 1000),
+             (unsigned long)(latency_percentile(&rfid_stages[RFID_TAP_TO_DECISION], 99) / 1000),
+             (unsigned long)(door_p99_ns / 1000));
+    TEST_MESSAGE(message);
+}
+
+/* Too long PINs are refused by handle_pinpad() without a check */
+static void test_pin_decisions()
+{
+    TEST_ASSERT_EQUAL_UINT32(PINS, pin_count);
+    TEST_ASSERT_EQUAL_UINT32(0, wrong_pin_decision_count);
+    TEST_ASSERT_EQUAL_UINT32(PINS / TOO_LONG_EVERY, too_long_count);
+    TEST_ASSERT_EQUAL_UINT32(PINS - PINS / TOO_LONG_EVERY, pin_check_count);
+    TEST_ASSERT_EQUAL_UINT32(PINS - PINS / UNKNOWN_EVERY, pin_stages[PIN_DOOR_OPEN].count);
+}
+
+static void test_pin_budget()
+{
+    latency_print("PIN, '#' pressed", pin_stages, PIN_STAGES);
+    uint64_t door_p99_ns = latency_percentile(&pin_stages[PIN_DOOR_OPEN], 99);
+    TEST_ASSERT_LESS_OR_EQUAL_UINT32(PIN_BUDGET_US, (uint32_t)(door_p99_ns / 1000));
+}
+
+/* The node reached the last delta and uploaded its log in the background */
+static void test_broker()
+{
+    // After reconnecting handle_credentials() asks for the deltas after its version
+    uplink_fake_set_connected(false);
+    hal_sim_run_for(1000000);
+    uplink_fake_set_connected(true);
+    hal_sim_run_for(1000000);
+    char version[16];
+    snprintf(version, sizeof(version), "%lu", (unsigned long)delta_count);
+    TEST_ASSERT_EQUAL_STRING(version, request);
+    TEST_ASSERT_GREATER_THAN_UINT32(0, log_chunks);
+}
+
+int main()
+{
+    hal_sim_begin();
+    mfrc522_sim_attach(SS_PIN, IRQ_PIN);
+    keypad_sim_attach(ROW_PINS, COL_PINS, keys);
+    hal_fake_gpio_set_write_hook(on_write, NULL);
+    uplink_fake_set_publish_hook(on_publish, NULL);
+    uint64_t taps_end_us = schedule_taps(hal_sim_now_us() + 1000000);
+    if (!hal_fake_flash_add_partition(ACCESS_LOG_PARTITION, LOG_SIZE, NULL) || !init_credentials() ||
+        !init_access_log() || !send_door_credentials() || !init_RFID() || !init_pinpad() ||
+        !hal_task_create(rfidTask, "RFID Task", 4096, NULL, 1, NULL, 1) || // Priorities and cores of scheduling.hpp
+        !hal_task_create(keypadTask, "Keypad Task", 2048, NULL, 4, NULL, 1) ||
+        !hal_task_create(pinpadTask, "Pinpad Task", 4096, NULL, 2, NULL, 0) ||
+        !hal_task_create(mqttTask, "MQTT Task", 4096, NULL, 5, NULL, 0))
+    {
+        return 1;
+    }
+    credentials_set_check_hook(on_check, NULL);
+    access_log_set_append_hook(on_record, NULL);
+    hal_sim_run_until(taps_end_us);
+    hal_sim_run_until(schedule_pins(hal_sim_now_us() + PIN_PAUSE_US));
+
+    UNITY_BEGIN();
+    RUN_TEST(test_rfid_decisions);
+    RUN_TEST(test_rfid_budget);
+    RUN_TEST(test_pin_decisions);
+    RUN_TEST(test_pin_budget);
+    RUN_TEST(test_broker);
+    return UNITY_END();
+}
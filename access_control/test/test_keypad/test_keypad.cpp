@@ -0,0 +1,156 @@
+/*
+ * Keypad against the simulated matrix in virtual time: bursts of fast
+ * key presses, every other one held over the next press and all of them
+ * bouncing, have to reach the consumer of the key queue complete and in
+ * order. The keypad runs in its own task like on the target.
+ */
+
+#include <unity.h>
+#include <stdio.h>
+#include "hal/hal.hpp"
+#include "hal/linux/hal_sim.hpp"
+#include "pinpad/keypad.hpp"
+#include "pinpad/keypad_sim.hpp"
+
+#define BURSTS 30
+#define KEYS_PER_BURST 12     // A PIN and its confirmation typed without pause
+#define KEY_INTERVAL_US 40000 // Between two presses of a burst
+#define KEY_SHORT_US 25000    // Hold of a tapped key
+#define KEY_ROLLOVER_US 55000 // Hold overlapping the next press
+#define KEY_BOUNCE_US 400     // Contact bounce after a press
+#define BURST_PAUSE_US 1000000
+#define KEYS (BURSTS * KEYS_PER_BURST)
+
+static const uint8_t ROW_PINS[KEYPAD_ROWS] = {13, 12, 14, 27}; // Wiring of the target (see pinpad.cpp)
+static const uint8_t COL_PINS[KEYPAD_COLUMNS] = {26, 25, 33, 32};
+static const char KEYMAP[KEYPAD_ROWS][KEYPAD_COLUMNS] = {
+    {'1', '2', '3', 'A'},
+    {'4', '5', '6', 'B'},
+    {'7', '8', '9', 'C'},
+    {'*', '0', '#', 'D'}};
+
+struct KeyEdge
+{
+    char key;
+    bool down;
+};
+
+static char typed[KEYS];
+static uint64_t typed_us[KEYS];
+static KeyEdge key_edges[KEYS][4]; // Press, bounce up, bounce down, release
+static char received[KEYS];
+static volatile uint32_t received_count = 0;
+static uint64_t latency_total_us = 0, latency_max_us = 0;
+
+static void set_key(void *ctx)
+{
+    const KeyEdge *edge = (const KeyEdge *)ctx;
+    keypad_sim_set_key(edge->key, edge->down);
+}
+
+static void keypadTask(void *arg)
+{
+    (void)arg;
+    while (true)
+    {
+        handle_keypad();
+    }
+}
+
+/* Same wait as handle_pinpad(), keeping the keys instead of entering a PIN */
+static void pinpadTask(void *arg)
+{
+    (void)arg;
+    KeyEvent event;
+    while (true)
+    {
+        if (!keypad_get_event(&event, 100) || received_count == KEYS)
+        {
+            continue;
+        }
+        uint64_t latency_us = hal_micros() - typed_us[received_count];
+        latency_total_us += latency_us;
+        latency_max_us = latency_us > latency_max_us ? latency_us : latency_max_us;
+        received[received_count++] = event.key;
+    }
+}
+
+/* Schedules the bursts, a key is never typed twice in a row: the rollover hold would overlap itself */
+static uint64_t type_bursts()
+{
+    uint32_t seed = 7;
+    uint64_t time_us = hal_sim_now_us() + BURST_PAUSE_US;
+    for (int i = 0; i < KEYS; i++)
+    {
+        do
+        {
+            seed = seed * 1664525 + 1013904223;
+            typed[i] = KEYMAP[(seed >> 16) % KEYPAD_ROWS][(seed >> 20) % KEYPAD_COLUMNS];
+        } while (i > 0 && typed[i] == typed[i - 1]);
+
+        uint64_t hold_us = (i & 1) ? KEY_ROLLOVER_US : KEY_SHORT_US;
+        KeyEdge *edges = key_edges[i];
+        edges[0] = {typed[i], true};
+        edges[1] = {typed[i], false};
+        edges[2] = {typed[i], true};
+        edges[3] = {typed[i], false};
+        typed_us[i] = time_us;
+        hal_sim_at(time_us, set_key, &edges[0]);
+        hal_sim_at(time_us + KEY_BOUNCE_US / 2, set_key, &edges[1]);
+        hal_sim_at(time_us + KEY_BOUNCE_US, set_key, &edges[2]);
+        hal_sim_at(time_us + hold_us, set_key, &edges[3]);
+
+        time_us += (i + 1) % KEYS_PER_BURST ? KEY_INTERVAL_US : BURST_PAUSE_US;
+    }
+    return time_us + BURST_PAUSE_US;
+}
+
+void setUp()
+{
+}
+
+void tearDown()
+{
+}
+
+static void test_every_press_counted()
+{
+    uint32_t presses, dropped;
+    keypad_get_stats(&presses, &dropped);
+    TEST_ASSERT_EQUAL_UINT32(KEYS, presses);
+    TEST_ASSERT_EQUAL_UINT32(0, dropped);
+}
+
+static void test_keys_in_order()
+{
+    TEST_ASSERT_EQUAL_UINT32(KEYS, received_count);
+    for (uint32_t i = 0; i < KEYS; i++)
+    {
+        char message[32];
+        snprintf(message, sizeof(message), "key %lu", (unsigned long)i);
+        TEST_ASSERT_EQUAL_INT_MESSAGE(typed[i], received[i], message);
+    }
+
+    char message[64];
+    snprintf(message, sizeof(message), "press to consumer avg %lu us, max %lu us",
+             (unsigned long)(latency_total_us / received_count), (unsigned long)latency_max_us);
+    TEST_MESSAGE(message);
+}
+
+int main()
+{
+    hal_sim_begin();
+    keypad_sim_attach(ROW_PINS, COL_PINS, KEYMAP);
+    if (!keypad_init(ROW_PINS, COL_PINS, KEYMAP) ||
+        !hal_task_create(keypadTask, "Keypad Task", 2048, NULL, 4, NULL, 1) ||
+        !hal_task_create(pinpadTask, "Pinpad Task", 4096, NULL, 2, NULL, 0))
+    {
+        return 1;
+    }
+    hal_sim_run_until(type_bursts());
+
+    UNITY_BEGIN();
+    RUN_TEST(test_every_press_counted);
+    RUN_TEST(test_keys_in_order);
+    return UNITY_END();
+}
@@ -0,0 +1,130 @@
+/*
+ * PIN entry state machine and lockout through their edge cases, keys
+ * typed straight into pin_entry_key() with their timestamps.
+ */
+
+#include <unity.h>
+#include <string.h>
+#include "pinpad/pin_entry.hpp"
+
+#define KEY_INTERVAL_MS 300
+
+static PinEntry entry;
+static PinLockout lockout;
+static uint32_t time_ms;
+
+/* Types keys one KEY_INTERVAL_MS apart, returns the result of the last one */
+static PinEntryResult type_keys(const char *keys)
+{
+    PinEntryResult result = PIN_ENTRY_NONE;
+    for (; *keys; keys++, time_ms += KEY_INTERVAL_MS)
+    {
+        result = pin_entry_key(&entry, *keys, time_ms);
+    }
+    return result;
+}
+
+void setUp()
+{
+    memset(&entry, 0, sizeof(entry));
+    memset(&lockout, 0, sizeof(lockout));
+    time_ms = 1000;
+}
+
+void tearDown()
+{
+}
+
+static void test_submit()
+{
+    TEST_ASSERT_EQUAL_INT(PIN_ENTRY_STARTED, type_keys("*"));
+    TEST_ASSERT_EQUAL_INT(PIN_ENTRY_SUBMITTED, type_keys("1234#"));
+    TEST_ASSERT_EQUAL_STRING("1234", entry.digits);
+    pin_entry_clear(&entry);
+    TEST_ASSERT_EQUAL_INT(0, entry.digits[0]);
+    TEST_ASSERT_EQUAL_INT(PIN_STATE_IDLE, entry.state);
+}
+
+static void test_letters_ignored()
+{
+    TEST_ASSERT_EQUAL_INT(PIN_ENTRY_SUBMITTED, type_keys("*12A3B4#"));
+    TEST_ASSERT_EQUAL_STRING("1234", entry.digits);
+}
+
+static void test_cancel()
+{
+    TEST_ASSERT_EQUAL_INT(PIN_ENTRY_CANCELED, type_keys("*12D"));
+    TEST_ASSERT_EQUAL_UINT8(0, entry.length);
+    TEST_ASSERT_EQUAL_INT(PIN_ENTRY_CANCELED, type_keys("*#")); // Empty PIN
+}
+
+static void test_needs_start()
+{
+    TEST_ASSERT_EQUAL_INT(PIN_ENTRY_NONE, type_keys("1234#"));
+}
+
+static void test_too_long()
+{
+    TEST_ASSERT_EQUAL_INT(PIN_ENTRY_TOO_LONG, type_keys("*1234567890123#"));
+    TEST_ASSERT_EQUAL_UINT8(0, entry.length);
+
+    // Exactly PIN_ENTRY_MAX_DIGITS digits still go through
+    TEST_ASSERT_EQUAL_INT(PIN_ENTRY_SUBMITTED, type_keys("*123456789012#"));
+    TEST_ASSERT_EQUAL_UINT8(PIN_ENTRY_MAX_DIGITS, entry.length);
+}
+
+static void test_restart()
+{
+    TEST_ASSERT_EQUAL_INT(PIN_ENTRY_SUBMITTED, type_keys("*99*42#"));
+    TEST_ASSERT_EQUAL_STRING("42", entry.digits);
+}
+
+static void test_timeout()
+{
+    // A pause longer than the timeout discards the digits typed before it
+    type_keys("*12");
+    TEST_ASSERT_EQUAL_INT(PIN_ENTRY_NONE, pin_entry_poll(&entry, time_ms));
+    TEST_ASSERT_EQUAL_INT(PIN_ENTRY_TIMED_OUT, pin_entry_poll(&entry, time_ms + PIN_ENTRY_TIMEOUT_MS));
+    TEST_ASSERT_EQUAL_UINT8(0, entry.length);
+
+    // Same pause noticed on the next key rather than on a poll
+    type_keys("*12");
+    time_ms += PIN_ENTRY_TIMEOUT_MS;
+    TEST_ASSERT_EQUAL_INT(PIN_ENTRY_NONE, type_keys("34#"));
+}
+
+static void test_lockout()
+{
+    // Free attempts, then lockouts doubling up to the maximum
+    const uint32_t expected_ms[] = {0, 0, PIN_LOCKOUT_BASE_MS, 2 * PIN_LOCKOUT_BASE_MS, 4 * PIN_LOCKOUT_BASE_MS};
+    for (uint32_t expected : expected_ms)
+    {
+        pin_lockout_record(&lockout, false, time_ms);
+        TEST_ASSERT_EQUAL_UINT32(expected, pin_lockout_remaining_ms(&lockout, time_ms));
+    }
+    for (int i = 0; i < 20; i++)
+    {
+        pin_lockout_record(&lockout, false, time_ms);
+    }
+    TEST_ASSERT_EQUAL_UINT32(PIN_LOCKOUT_MAX_MS, pin_lockout_remaining_ms(&lockout, time_ms));
+    TEST_ASSERT_EQUAL_UINT32(0, pin_lockout_remaining_ms(&lockout, time_ms + PIN_LOCKOUT_MAX_MS));
+
+    // A correct PIN clears them
+    pin_lockout_record(&lockout, true, time_ms);
+    TEST_ASSERT_EQUAL_UINT32(0, pin_lockout_remaining_ms(&lockout, time_ms));
+    TEST_ASSERT_EQUAL_UINT8(0, lockout.failures);
+}
+
+int main()
+{
+    UNITY_BEGIN();
+    RUN_TEST(test_submit);
+    RUN_TEST(test_letters_ignored);
+    RUN_TEST(test_cancel);
+    RUN_TEST(test_needs_start);
+    RUN_TEST(test_too_long);
+    RUN_TEST(test_restart);
+    RUN_TEST(test_timeout);
+    RUN_TEST(test_lockout);
+    return UNITY_END();
+}
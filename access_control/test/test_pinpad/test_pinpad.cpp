@@ -0,0 +1,154 @@
+/*
+ * Pinpad lockout across reboots in virtual time: wrong PINs typed on the
+ * simulated keypad lock the pinpad out, and a reboot (init_pinpad()
+ * again) has to find the lockout saved in NVS rather than start clear.
+ * The store is empty, so every PIN checked is wrong. The tests run in
+ * order, each one continuing from the state the previous one left.
+ */
+
+#include <unity.h>
+#include <string.h>
+#include "hal/hal.hpp"
+#include "hal/linux/hal_fake.hpp"
+#include "hal/linux/hal_sim.hpp"
+#include "pinpad/pinpad.hpp"
+#include "pinpad/keypad_sim.hpp"
+#include "credentials/credentials.hpp"
+#include "access_log/access_log.hpp"
+
+#define LOG_SIZE 0x20000 // Size in partitions.csv
+#define WRONG_PIN "*1234#"
+#define KEY_INTERVAL_US 300000
+#define KEY_HOLD_US 80000
+
+struct KeyEdge
+{
+    char key;
+    bool down;
+};
+
+static KeyEdge edges[sizeof(WRONG_PIN)][2]; // Press, release
+static uint32_t decisions[3];               // Per AccessDecision, PINs only
+
+static void on_record(void *ctx, const AccessRecord *record, bool appended)
+{
+    (void)ctx;
+    if (appended && record->reader == ACCESS_READER_PINPAD && record->decision < 3)
+    {
+        decisions[record->decision]++;
+    }
+}
+
+static void set_key(void *ctx)
+{
+    const KeyEdge *edge = (const KeyEdge *)ctx;
+    keypad_sim_set_key(edge->key, edge->down);
+}
+
+/* Task loops of scheduling.cpp */
+static void keypadTask(void *arg)
+{
+    (void)arg;
+    while (true)
+    {
+        handle_keypad();
+    }
+}
+
+static void pinpadTask(void *arg)
+{
+    (void)arg;
+    while (true)
+    {
+        handle_pinpad();
+    }
+}
+
+/* Types the wrong PIN and waits for its decision */
+static void type_wrong_pin()
+{
+    uint64_t time_us = hal_sim_now_us() + KEY_INTERVAL_US;
+    for (size_t i = 0; i < strlen(WRONG_PIN); i++)
+    {
+        edges[i][0] = {WRONG_PIN[i], true};
+        edges[i][1] = {WRONG_PIN[i], false};
+        hal_sim_at(time_us, set_key, &edges[i][0]);
+        hal_sim_at(time_us + KEY_HOLD_US, set_key, &edges[i][1]);
+        time_us += KEY_INTERVAL_US;
+    }
+    hal_sim_run_until(time_us);
+}
+
+void setUp()
+{
+    memset(decisions, 0, sizeof(decisions));
+}
+
+void tearDown()
+{
+}
+
+static void test_locked_out_after_free_attempts()
+{
+    for (int i = 0; i < PIN_LOCKOUT_FREE_ATTEMPTS; i++)
+    {
+        type_wrong_pin();
+    }
+    TEST_ASSERT_EQUAL_UINT32(PIN_LOCKOUT_FREE_ATTEMPTS, decisions[ACCESS_DENIED]);
+
+    type_wrong_pin();
+    TEST_ASSERT_EQUAL_UINT32(1, decisions[ACCESS_LOCKED_OUT]);
+}
+
+/* A reboot during the lockout does not clear it */
+static void test_reboot_keeps_lockout()
+{
+    TEST_ASSERT_TRUE(init_pinpad());
+    type_wrong_pin();
+    TEST_ASSERT_EQUAL_UINT32(1, decisions[ACCESS_LOCKED_OUT]);
+    TEST_ASSERT_EQUAL_UINT32(0, decisions[ACCESS_DENIED]);
+}
+
+/* Once it ends one PIN is checked, the next failure locks out for twice as long */
+static void test_lockout_ends_and_doubles()
+{
+    hal_sim_run_for(PIN_LOCKOUT_BASE_MS * 1000ULL);
+    type_wrong_pin();
+    TEST_ASSERT_EQUAL_UINT32(1, decisions[ACCESS_DENIED]);
+
+    TEST_ASSERT_TRUE(init_pinpad());
+    hal_sim_run_for(PIN_LOCKOUT_BASE_MS * 1000ULL);
+    type_wrong_pin();
+    TEST_ASSERT_EQUAL_UINT32(1, decisions[ACCESS_LOCKED_OUT]);
+}
+
+/* The state comes from NVS: with it erased a reboot starts clear */
+static void test_erased_nvs_starts_clear()
+{
+    hal_fake_nvs_erase();
+    TEST_ASSERT_TRUE(init_pinpad());
+    type_wrong_pin();
+    TEST_ASSERT_EQUAL_UINT32(1, decisions[ACCESS_DENIED]);
+    TEST_ASSERT_EQUAL_UINT32(0, decisions[ACCESS_LOCKED_OUT]);
+}
+
+int main()
+{
+    hal_sim_begin();
+    keypad_sim_attach(ROW_PINS, COL_PINS, keys);
+    if (!hal_fake_flash_add_partition(ACCESS_LOG_PARTITION, LOG_SIZE, NULL) || !init_credentials() ||
+        !init_access_log() || !init_pinpad() ||
+        !hal_task_create(keypadTask, "Keypad Task", 2048, NULL, 4, NULL, 1) || // Priorities and cores of scheduling.hpp
+        !hal_task_create(pinpadTask, "Pinpad Task", 4096, NULL, 2, NULL, 0))
+    {
+        return 1;
+    }
+    access_log_set_append_hook(on_record, NULL);
+
+    UNITY_BEGIN();
+    RUN_TEST(test_locked_out_after_free_attempts);
+    RUN_TEST(test_reboot_keeps_lockout);
+    RUN_TEST(test_lockout_ends_and_doubles);
+    RUN_TEST(test_erased_nvs_starts_clear);
+    return UNITY_END();
+}
@@ -0,0 +1,141 @@
+/*
+ * Card UIDs without String: formatting into the fixed array, its cost
+ * against snprintf(), and the hold-off cache turning the reads of a card
+ * left on the reader into one tap.
+ */
+
+#include <unity.h>
+#include <stdio.h>
+#include <chrono>
+#include "rfid/rfid_uid.hpp"
+
+#define BENCH_ROUNDS 1000000
+
+static const RfidUid card_a = {{0x04, 0xA0, 0x0B, 0xFF}, 4};
+static const RfidUid card_b = {{0x04, 0x00, 0x0A, 0xB0, 0x00, 0x00, 0x01}, 7};
+
+static uint64_t now_ns()
+{
+    return std::chrono::duration_cast<std::chrono::nanoseconds>(
+               std::chrono::steady_clock::now().time_since_epoch())
+        .count();
+}
+
+void setUp()
+{
+}
+
+void tearDown()
+{
+}
+
+static void test_format()
+{
+    TEST_ASSERT_EQUAL_STRING("04a00bff", rfid_uid_format(card_a).data());
+    TEST_ASSERT_EQUAL_STRING("04000ab0000001", rfid_uid_format(card_b).data());
+
+    RfidUid triple = {{0x01, 0x02, 0x03, 0x04, 0x05, 0x06, 0x07, 0x08, 0x09, 0x0A}, 10};
+    TEST_ASSERT_EQUAL_STRING("0102030405060708090a", rfid_uid_format(triple).data());
+}
+
+static void test_compare()
+{
+    RfidUid same_bytes_shorter = card_b;
+    same_bytes_shorter.size = 4;
+    TEST_ASSERT_TRUE(card_a == card_a);
+    TEST_ASSERT_FALSE(card_a == card_b);
+    TEST_ASSERT_FALSE(card_b == same_bytes_shorter);
+}
+
+static void test_hold_off()
+{
+    RfidUidCache cache = {};
+    TEST_ASSERT_TRUE(rfid_uid_cache_seen(&cache, card_a, 1000));
+    TEST_ASSERT_FALSE(rfid_uid_cache_seen(&cache, card_a, 1050));
+
+    // Left on the reader: every read restarts the hold-off
+    for (uint32_t time_ms = 1050; time_ms < 10000; time_ms += RFID_HOLD_OFF_MS / 2)
+    {
+        TEST_ASSERT_FALSE(rfid_uid_cache_seen(&cache, card_a, time_ms));
+    }
+
+    // Another card in between is a tap of its own and does not end the first one
+    TEST_ASSERT_TRUE(rfid_uid_cache_seen(&cache, card_b, 10100));
+    TEST_ASSERT_FALSE(rfid_uid_cache_seen(&cache, card_a, 10200));
+
+    TEST_ASSERT_TRUE(rfid_uid_cache_seen(&cache, card_a, 10200 + RFID_HOLD_OFF_MS));
+}
+
+static void test_hold_off_across_wrap()
+{
+    RfidUidCache cache = {};
+    TEST_ASSERT_TRUE(rfid_uid_cache_seen(&cache, card_a, 0xFFFFFF00));
+    TEST_ASSERT_FALSE(rfid_uid_cache_seen(&cache, card_a, 0x00000100)); // 512 ms later
+}
+
+static void test_cache_full()
+{
+    RfidUidCache cache = {};
+    RfidUid cards[RFID_UID_CACHE_SIZE + 1];
+    for (uint8_t i = 0; i < RFID_UID_CACHE_SIZE + 1; i++)
+    {
+        cards[i] = card_a;
+        cards[i].bytes[3] = i;
+        TEST_ASSERT_TRUE(rfid_uid_cache_seen(&cache, cards[i], 1000 + i * 100));
+    }
+    TEST_ASSERT_EQUAL_UINT8(RFID_UID_CACHE_SIZE, cache.count);
+
+    // The card read longest ago was forgotten, the others are still held off
+    TEST_ASSERT_TRUE(rfid_uid_cache_seen(&cache, cards[0], 1600));
+    for (uint8_t i = 2; i < RFID_UID_CACHE_SIZE + 1; i++)
+    {
+        TEST_ASSERT_FALSE(rfid_uid_cache_seen(&cache, cards[i], 1600));
+    }
+}
+
+/* Formats 7-byte UIDs with rfid_uid_format() and with snprintf(), in real time */
+static void test_format_cost()
+{
+    RfidUid uid = card_b;
+    unsigned checksum = 0;
+
+    uint64_t start = now_ns();
+    for (uint32_t i = 0; i < BENCH_ROUNDS; i++)
+    {
+        uid.bytes[6] = (uint8_t)i;
+        RfidUidText text = rfid_uid_format(uid);
+        checksum += text[13];
+    }
+    uint64_t format_ns = now_ns() - start;
+
+    start = now_ns();
+    for (uint32_t i = 0; i < BENCH_ROUNDS; i++)
+    {
+        uid.bytes[6] = (uint8_t)i;
+        char text[2 * RFID_UID_MAX_LENGTH + 1];
+        for (uint8_t j = 0; j < uid.size; j++)
+        {
+            snprintf(text + 2 * j, 3, "%02x", uid.bytes[j]);
+        }
+        checksum -= text[13];
+    }
+    uint64_t snprintf_ns = now_ns() - start;
+    TEST_ASSERT_EQUAL_UINT(0, checksum); // Same text both ways
+
+    char message[96];
+    snprintf(message, sizeof(message), "rfid_uid_format %.1f ns, snprintf %.1f ns per 7-byte UID",
+             (double)format_ns / BENCH_ROUNDS, (double)snprintf_ns / BENCH_ROUNDS);
+    TEST_MESSAGE(message);
+}
+
+int main()
+{
+    UNITY_BEGIN();
+    RUN_TEST(test_format);
+    RUN_TEST(test_compare);
+    RUN_TEST(test_hold_off);
+    RUN_TEST(test_hold_off_across_wrap);
+    RUN_TEST(test_cache_full);
+    RUN_TEST(test_format_cost);
+    return UNITY_END();
+}
@@ -0,0 +1,70 @@
+#include <string.h>
+#include "energy_meter.hpp"
+
+#define MS_PER_HOUR 3600000ULL
+
+void energy_meter_init(EnergyMeter *meter, const EnergyTotals *totals)
+{
+    memset(meter, 0, sizeof(*meter));
+    if (totals != NULL)
+    {
+        meter->totals = *totals;
+    }
+}
+
+void energy_meter_add(EnergyMeter *meter, uint32_t now_ms, uint16_t bus_mv, int32_t current_ua)
+{
+    uint32_t ua = current_ua > 0 ? (uint32_t)current_ua : 0;
+    uint32_t uw = (uint32_t)((uint64_t)bus_mv * ua / 1000);
+
+    if (meter->primed)
+    {
+        uint32_t elapsed_ms = now_ms - meter->last_ms;
+        if (meter->broken || elapsed_ms > ENERGY_MAX_GAP_MS)
+        {
+            meter->gap_ms += elapsed_ms;
+        }
+        else
+        {
+            // Trapezoids, kept doubled so the halves are not rounded away
+            uint64_t energy = ((uint64_t)meter->last_uw + uw) * elapsed_ms;
+            meter->energy_rest += energy;
+            meter->charge_rest += ((uint64_t)meter->last_ua + ua) * elapsed_ms;
+            meter->period_uwms += energy / 2;
+            meter->period_ms += elapsed_ms;
+
+            meter->totals.uwh += meter->energy_rest / (2 * MS_PER_HOUR);
+            meter->energy_rest %= 2 * MS_PER_HOUR;
+            meter->totals.uah += meter->charge_rest / (2 * MS_PER_HOUR);
+            meter->charge_rest %= 2 * MS_PER_HOUR;
+        }
+    }
+
+    meter->primed = true;
+    meter->broken = false;
+    meter->last_ms = now_ms;
+    meter->last_uw = uw;
+    meter->last_ua = ua;
+    meter->last_mv = bus_mv;
+    meter->peak_uw = uw > meter->peak_uw ? uw : meter->peak_uw;
+}
+
+void energy_meter_break(EnergyMeter *meter)
+{
+    meter->broken = true;
+}
+
+void energy_meter_summary(EnergyMeter *meter, EnergySummary *summary)
+{
+    summary->totals = meter->totals;
+    summary->average_mw = meter->period_ms > 0 ? (uint32_t)(meter->period_uwms / meter->period_ms / 1000) : 0;
+    summary->peak_mw = meter->peak_uw / 1000;
+    summary->bus_mv = meter->last_mv;
+    summary->period_ms = meter->period_ms;
+    summary->gap_ms = meter->gap_ms;
+
+    meter->period_uwms = 0;
+    meter->period_ms = 0;
+    meter->gap_ms = 0;
+    meter->peak_uw = 0;
+}
@@ -0,0 +1,93 @@
+#pragma once
+
+/*
+ * Energy and charge integration of one power channel, independent of the
+ * hardware.
+ *
+ * Samples of bus voltage and current are integrated with the trapezoidal
+ * rule in integer arithmetic: whole uWh and uAh go to the totals, the
+ * remainders below one unit are carried to the next sample, so nothing is
+ * lost to rounding however long the meter runs. Time comes with every
+ * sample; two samples further apart than ENERGY_MAX_GAP_MS are not
+ * bridged, the gap is counted instead. Reverse current counts as zero.
+ *
+ * Totals are meant to be persisted and given back to energy_meter_init()
+ * after a reboot; summaries cover the time since the previous summary.
+ */
+
+#include <stdint.h>
+
+#define ENERGY_MAX_GAP_MS 5000 // Longer without a sample and the gap is not integrated
+
+/// Counters that survive reboots.
+struct EnergyTotals
+{
+    uint64_t uwh; ///< Energy.
+    uint64_t uah; ///< Charge.
+};
+
+/// Integration state of one channel.
+struct EnergyMeter
+{
+    EnergyTotals totals;
+    uint64_t energy_rest; ///< Twice the uW*ms below 1 uWh.
+    uint64_t charge_rest; ///< Twice the uA*ms below 1 uAh.
+    bool primed;          ///< A previous sample exists.
+    bool broken;          ///< A sample was lost since the previous one.
+    uint32_t last_ms;
+    uint32_t last_uw;
+    uint32_t last_ua;
+    uint16_t last_mv;
+
+    // Since the last summary
+    uint64_t period_uwms; ///< Energy integrated, uW*ms.
+    uint32_t period_ms;   ///< Time integrated.
+    uint32_t gap_ms;      ///< Time not integrated.
+    uint32_t peak_uw;
+};
+
+/// Summary of a period.
+struct EnergySummary
+{
+    EnergyTotals totals;
+    uint32_t average_mw; ///< Over the integrated time.
+    uint32_t peak_mw;
+    uint16_t bus_mv;     ///< Latest bus voltage.
+    uint32_t period_ms;  ///< Integrated time.
+    uint32_t gap_ms;     ///< Time without samples.
+};
+
+/**
+ * @brief Resets a meter, keeping given totals.
+ *
+ * @param meter Meter.
+ * @param totals Totals restored after a reboot, NULL to start from zero.
+ */
+void energy_meter_init(EnergyMeter *meter, const EnergyTotals *totals);
+
+/**
+ * @brief Integrates a sample.
+ *
+ * @param meter Meter.
+ * @param now_ms Time of the sample.
+ * @param bus_mv Bus voltage.
+ * @param current_ua Current.
+ */
+void energy_meter_add(EnergyMeter *meter, uint32_t now_ms, uint16_t bus_mv, int32_t current_ua);
+
+/**
+ * @brief Marks a lost sample, e.g. after a failed read.
+ *
+ * The time until the next sample counts as a gap.
+ *
+ * @param meter Meter.
+ */
+void energy_meter_break(EnergyMeter *meter);
+
+/**
+ * @brief Summarizes the period since the previous summary and starts a new one.
+ *
+ * @param meter Meter.
+ * @param summary (Output) Summary.
+ */
+void energy_meter_summary(EnergyMeter *meter, EnergySummary *summary);
@@ -0,0 +1,207 @@
+#include <stdio.h>
+#include "energy_monitor.hpp"
+#include "../uplink/uplink.hpp"
+#include "../telemetry/telemetry.hpp"
+#include "../i2c_bus/i2c_bus.hpp"
+
+#define ENERGY_MONITOR_TAG "app_energy_monitor"
+#define ENERGY_NVS_NAMESPACE "energy"
+
+static const uint8_t addresses[ENERGY_CHANNELS] = {INA219_PRODUCTION_ADDRESS, INA219_CONSUMPTION_ADDRESS};
+static const char *const topics[ENERGY_CHANNELS] = {TOPIC_ENERGY_PRODUCTION, TOPIC_ENERGY_CONSUMPTION};
+static const TelemetryChannel power_channels[ENERGY_CHANNELS] = {TELEMETRY_PRODUCTION_POWER,
+                                                                  TELEMETRY_CONSUMPTION_POWER};
+static const char *const nvs_keys[ENERGY_CHANNELS][2] = {{"prod_uwh", "prod_uah"}, {"cons_uwh", "cons_uah"}};
+static const char *const names[ENERGY_CHANNELS] = {"Production INA219", "Consumption INA219"};
+
+static Ina219 monitors[ENERGY_CHANNELS];
+static uint8_t devices[ENERGY_CHANNELS]; // Handles on the I2C bus
+static EnergyMeter meters[ENERGY_CHANNELS];
+static hal_mutex_t meters_mutex = NULL; // Sampled in the bus task, summarized in the MQTT task
+static uint8_t registers[ENERGY_CHANNELS][2][2]; // Bus voltage and current of each monitor, filled by the bus task
+static volatile bool read_pending = false;       // A batch is queued or running
+static uint32_t saved_ms = 0;
+static uint32_t published_ms = 0;
+
+static void load_totals(EnergyTotals totals[ENERGY_CHANNELS])
+{
+    for (uint8_t c = 0; c < ENERGY_CHANNELS; c++)
+    {
+        totals[c].uwh = 0;
+        totals[c].uah = 0;
+        hal_nvs_get_u64(ENERGY_NVS_NAMESPACE, nvs_keys[c][0], &totals[c].uwh);
+        hal_nvs_get_u64(ENERGY_NVS_NAMESPACE, nvs_keys[c][1], &totals[c].uah);
+    }
+}
+
+static void save_totals(const EnergyTotals totals[ENERGY_CHANNELS])
+{
+    for (uint8_t c = 0; c < ENERGY_CHANNELS; c++)
+    {
+        if (!hal_nvs_set_u64(ENERGY_NVS_NAMESPACE, nvs_keys[c][0], totals[c].uwh) ||
+            !hal_nvs_set_u64(ENERGY_NVS_NAMESPACE, nvs_keys[c][1], totals[c].uah))
+        {
+            ESP_LOGE(ENERGY_MONITOR_TAG, "Failed to save the %s totals", names[c]);
+        }
+    }
+}
+
+bool init_energy_monitor()
+{
+    ESP_LOGI(ENERGY_MONITOR_TAG, "Initializing energy monitors...");
+
+    meters_mutex = hal_mutex_create();
+    if (meters_mutex == NULL)
+    {
+        ESP_LOGE(ENERGY_MONITOR_TAG, "Failed to create mutex");
+        return false;
+    }
+
+    EnergyTotals totals[ENERGY_CHANNELS];
+    load_totals(totals);
+    for (uint8_t c = 0; c < ENERGY_CHANNELS; c++)
+    {
+        if (!ina219_init(&monitors[c], addresses[c]))
+        {
+            ESP_LOGE(ENERGY_MONITOR_TAG, "%s sensor not found! Check connections.", names[c]);
+            return false;
+        }
+        devices[c] = i2c_bus_add_device(addresses[c], INA219_TIMEOUT_MS, names[c]);
+        if (devices[c] == I2C_BUS_NO_DEVICE)
+        {
+            return false;
+        }
+        energy_meter_init(&meters[c], &totals[c]);
+    }
+    saved_ms = published_ms = hal_millis();
+
+    ESP_LOGI(ENERGY_MONITOR_TAG, "Both energy monitors initialized, production %.3f Wh, consumption %.3f Wh so far",
+             totals[ENERGY_PRODUCTION].uwh / 1e6, totals[ENERGY_CONSUMPTION].uwh / 1e6);
+    return true;
+}
+
+/* Integrates the readings of a batch, in the bus task */
+static void on_registers(void *ctx, uint8_t failed)
+{
+    (void)ctx;
+    Ina219Sample samples[ENERGY_CHANNELS];
+    bool valid[ENERGY_CHANNELS];
+    for (uint8_t c = 0; c < ENERGY_CHANNELS; c++)
+    {
+        bool read = (failed & (3 << (2 * c))) == 0; // Both registers of the monitor
+        if (read)
+        {
+            ina219_parse(registers[c][0], registers[c][1], &samples[c]);
+        }
+        else
+        {
+            monitors[c].errors++;
+        }
+        valid[c] = read && !samples[c].overflow;
+    }
+    uint32_t now_ms = hal_millis();
+
+    hal_mutex_take(meters_mutex, HAL_WAIT_FOREVER);
+    for (uint8_t c = 0; c < ENERGY_CHANNELS; c++)
+    {
+        if (valid[c])
+        {
+            energy_meter_add(&meters[c], now_ms, samples[c].bus_mv, samples[c].current_ua);
+        }
+        else
+        {
+            energy_meter_break(&meters[c]);
+        }
+    }
+    hal_mutex_give(meters_mutex);
+    read_pending = false;
+
+    for (uint8_t c = 0; c < ENERGY_CHANNELS; c++)
+    {
+        if (valid[c])
+        {
+            telemetry_add(power_channels[c], (float)samples[c].bus_mv * samples[c].current_ua / 1e6f); // mW
+        }
+        else
+        {
+            ESP_LOGW(ENERGY_MONITOR_TAG, "INA219 at 0x%02x: %s", addresses[c],
+                     (failed & (3 << (2 * c))) == 0 ? "current out of range" : "read failed");
+        }
+    }
+}
+
+void handle_energy_monitor()
+{
+    if (read_pending)
+    {
+        ESP_LOGW(ENERGY_MONITOR_TAG, "Previous INA219 read still queued, period skipped");
+    }
+    else
+    {
+        I2cRequest request = {};
+        for (uint8_t c = 0; c < ENERGY_CHANNELS; c++)
+        {
+            for (uint8_t r = 0; r < 2; r++)
+            {
+                I2cOp &op = request.ops[request.count++];
+                op.device = devices[c];
+                op.tx[0] = r == 0 ? INA219_REG_BUS : INA219_REG_CURRENT;
+                op.tx_length = 1;
+                op.rx = registers[c][r];
+                op.rx_length = 2;
+            }
+        }
+        request.callback = on_registers;
+        read_pending = true;
+        if (!i2c_bus_submit(&request))
+        {
+            read_pending = false;
+            ESP_LOGW(ENERGY_MONITOR_TAG, "I2C bus queue full, INA219 read dropped");
+        }
+    }
+
+    uint32_t now_ms = hal_millis();
+    if (now_ms - saved_ms >= ENERGY_SAVE_MS)
+    {
+        EnergyTotals totals[ENERGY_CHANNELS];
+        hal_mutex_take(meters_mutex, HAL_WAIT_FOREVER);
+        for (uint8_t c = 0; c < ENERGY_CHANNELS; c++)
+        {
+            totals[c] = meters[c].totals;
+        }
+        hal_mutex_give(meters_mutex);
+        save_totals(totals);
+        saved_ms = now_ms;
+    }
+}
+
+void publish_energy_summary()
+{
+    uint32_t now_ms = hal_millis();
+    if (now_ms - published_ms < ENERGY_PUBLISH_MS || !uplink_is_connected())
+    {
+        return;
+    }
+    published_ms = now_ms;
+
+    EnergySummary summaries[ENERGY_CHANNELS];
+    hal_mutex_take(meters_mutex, HAL_WAIT_FOREVER);
+    for (uint8_t c = 0; c < ENERGY_CHANNELS; c++)
+    {
+        energy_meter_summary(&meters[c], &summaries[c]);
+    }
+    hal_mutex_give(meters_mutex);
+
+    for (uint8_t c = 0; c < ENERGY_CHANNELS; c++)
+    {
+        const EnergySummary &summary = summaries[c];
+        char payload[128];
+        snprintf(payload, sizeof(payload), "{\"wh\":%.3f,\"mah\":%.1f,\"mw\":%lu,\"peak_mw\":%lu,\"v\":%.2f,\"gap_s\":%lu}",
+                 summary.totals.uwh / 1e6, summary.totals.uah / 1e3, (unsigned long)summary.average_mw,
+                 (unsigned long)summary.peak_mw, summary.bus_mv / 1e3, (unsigned long)(summary.gap_ms / 1000));
+        if (!uplink_publish(topics[c], payload))
+        {
+            ESP_LOGW(ENERGY_MONITOR_TAG, "Failed to publish the %s summary", topics[c]);
+        }
+    }
+}
@@ -0,0 +1,56 @@
+#pragma once
+
+#include "hal/hal.hpp"
+#include "ina219.hpp"
+#include "energy_meter.hpp"
+
+#define INA219_PRODUCTION_ADDRESS 0x45  // A0 and A1 bridged
+#define INA219_CONSUMPTION_ADDRESS 0x41 // A0 bridged
+#define INA219_TIMEOUT_MS 10            // The INA219 does not stretch the clock
+
+#define ENERGY_PUBLISH_MS 60000 // Summary period
+#define ENERGY_SAVE_MS 900000   // Totals written to NVS every 15 min, at most that much is lost on power loss
+
+#define TOPIC_ENERGY_PRODUCTION "smarthome/environment/energy/production"
+#define TOPIC_ENERGY_CONSUMPTION "smarthome/environment/energy/consumption"
+
+/// Monitored lines.
+enum EnergyChannel : uint8_t
+{
+    ENERGY_PRODUCTION,
+    ENERGY_CONSUMPTION,
+    ENERGY_CHANNELS,
+};
+
+/**
+ * @brief Initializes the energy monitors.
+ *
+ * Configures both INA219s for continuous averaged conversions on the
+ * shared I2C bus (init_i2c_bus() first) and restores the energy and
+ * charge totals saved in NVS.
+ *
+ * @return true if both sensors initialized successfully, false otherwise.
+ */
+bool init_energy_monitor();
+
+/**
+ * @brief Samples both monitors, called at a steady rate.
+ *
+ * Queues one batch reading the bus voltage and current of both monitors
+ * on the I2C bus; the readings are integrated when the batch completes,
+ * in the bus task. A failed read leaves a gap in the integration instead
+ * of bridging it. Saves the totals every ENERGY_SAVE_MS.
+ */
+void handle_energy_monitor();
+
+/**
+ * @brief Publishes a summary per channel every ENERGY_PUBLISH_MS, called from the MQTT task.
+ *
+ * The payload is compact JSON, e.g.
+ * {"wh":1234.567,"mah":98765.4,"mw":512,"peak_mw":2048,"v":12.04,"gap_s":0}:
+ * totals since the counters were created, average and peak power and
+ * seconds without samples since the previous summary, latest bus voltage.
+ * While the broker is unreachable nothing is lost: the next summary
+ * covers the whole period.
+ */
+void publish_energy_summary();
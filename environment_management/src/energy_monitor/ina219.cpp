@@ -0,0 +1,92 @@
+#include "hal/hal.hpp"
+#include "ina219.hpp"
+
+#define INA219_TAG "app_ina219"
+
+#define INA219_CONFIG_BRNG_32V 0x2000
+#define INA219_CONFIG_PGA_320MV 0x1800
+#define INA219_CONFIG_MODE_CONTINUOUS 0x0007 // Shunt and bus
+#define INA219_BUS_OVF 0x0001
+
+#define INA219_CALIBRATION (40960000UL / (INA219_CURRENT_LSB_UA * INA219_SHUNT_MILLIOHM)) // 0.04096 / (LSB * R)
+
+/* ADC setting (BADC/SADC): one 12-bit conversion, or 0x8 | log2(samples) averaged */
+static constexpr uint16_t adc_setting(uint16_t samples, uint16_t log2 = 0)
+{
+    return samples <= 1 ? (log2 == 0 ? 0x3 : 0x8 | log2) : adc_setting(samples / 2, log2 + 1);
+}
+
+static_assert(adc_setting(1) == 0x3 && adc_setting(2) == 0x9 && adc_setting(128) == 0xF, "Averaging setting");
+static_assert((INA219_AVERAGING & (INA219_AVERAGING - 1)) == 0 && INA219_AVERAGING <= 128,
+              "INA219_AVERAGING must be a power of two up to 128");
+static_assert(INA219_CALIBRATION < 0x10000 && (INA219_CALIBRATION & 1) == 0, "Calibration does not fit the register");
+
+uint16_t ina219_config()
+{
+    uint16_t adc = adc_setting(INA219_AVERAGING);
+    return INA219_CONFIG_BRNG_32V | INA219_CONFIG_PGA_320MV | adc << 7 | adc << 3 | INA219_CONFIG_MODE_CONTINUOUS;
+}
+
+uint32_t ina219_conversion_us()
+{
+    return 532UL * INA219_AVERAGING; // 532 us per 12-bit conversion
+}
+
+static bool write_register(Ina219 *device, uint8_t reg, uint16_t value)
+{
+    uint8_t tx[3] = {reg, (uint8_t)(value >> 8), (uint8_t)value};
+    if (!hal_i2c_write(device->address, tx, sizeof(tx)))
+    {
+        device->errors++;
+        return false;
+    }
+    return true;
+}
+
+static bool read_register(Ina219 *device, uint8_t reg, uint8_t rx[2])
+{
+    if (!hal_i2c_write_read(device->address, &reg, 1, rx, 2))
+    {
+        device->errors++;
+        return false;
+    }
+    return true;
+}
+
+bool ina219_init(Ina219 *device, uint8_t address)
+{
+    device->address = address;
+    device->errors = 0;
+
+    uint8_t config[2] = {0, 0};
+    if (!write_register(device, INA219_REG_CONFIG, ina219_config()) ||
+        !write_register(device, INA219_REG_CALIBRATION, INA219_CALIBRATION) ||
+        !read_register(device, INA219_REG_CONFIG, config) || (config[0] << 8 | config[1]) != ina219_config())
+    {
+        ESP_LOGE(INA219_TAG, "INA219 at 0x%02x not answering", address);
+        return false;
+    }
+
+    ESP_LOGI(INA219_TAG, "INA219 at 0x%02x: %d samples averaged, results every %lu us", address, INA219_AVERAGING,
+             (unsigned long)(2 * ina219_conversion_us()));
+    return true;
+}
+
+bool ina219_read(Ina219 *device, Ina219Sample *sample)
+{
+    uint8_t bus[2], current[2];
+    if (!read_register(device, INA219_REG_BUS, bus) || !read_register(device, INA219_REG_CURRENT, current))
+    {
+        return false;
+    }
+    ina219_parse(bus, current, sample);
+    return true;
+}
+
+void ina219_parse(const uint8_t bus[2], const uint8_t current[2], Ina219Sample *sample)
+{
+    uint16_t bus_value = (uint16_t)(bus[0] << 8 | bus[1]);
+    sample->bus_mv = (bus_value >> 3) * INA219_BUS_LSB_MV;
+    sample->current_ua = (int16_t)(current[0] << 8 | current[1]) * INA219_CURRENT_LSB_UA;
+    sample->overflow = (bus_value & INA219_BUS_OVF) != 0;
+}
@@ -0,0 +1,94 @@
+#pragma once
+
+/*
+ * Driver of the INA219 current/power monitor, on the HAL I2C bus.
+ *
+ * The chip is configured once for continuous shunt and bus conversions
+ * with hardware averaging over INA219_AVERAGING samples, and calibrated so
+ * the current register reads directly in INA219_CURRENT_LSB_UA steps. A
+ * read then only fetches the latest results: two register reads, bus
+ * voltage and current. Power is computed from them instead of reading the
+ * power register. Once the shared bus task runs, the registers are read
+ * through it and decoded with ina219_parse().
+ */
+
+#include <stdint.h>
+
+#define INA219_SHUNT_MILLIOHM 100 // R100 shunt of the module
+#define INA219_CURRENT_LSB_UA 100 // 3.2 A full scale with the 320 mV range
+#define INA219_BUS_LSB_MV 4
+
+/* Hardware averaging: 1, 2, 4, 8, 16, 32, 64 or 128 conversions per result */
+#ifndef INA219_AVERAGING
+#define INA219_AVERAGING 64
+#endif
+
+/// Registers of the chip.
+enum Ina219Register : uint8_t
+{
+    INA219_REG_CONFIG = 0x00,
+    INA219_REG_SHUNT = 0x01,
+    INA219_REG_BUS = 0x02,
+    INA219_REG_POWER = 0x03,
+    INA219_REG_CURRENT = 0x04,
+    INA219_REG_CALIBRATION = 0x05,
+};
+
+/// One monitor on the bus.
+struct Ina219
+{
+    uint8_t address;
+    uint32_t errors; ///< Transfers not acknowledged since init.
+};
+
+/// Latest result of the chip.
+struct Ina219Sample
+{
+    uint16_t bus_mv;
+    int32_t current_ua; ///< Negative when current flows from IN- to IN+.
+    bool overflow;      ///< Current out of range, the value is not usable.
+};
+
+/**
+ * @brief Returns the configuration register value for the build settings.
+ *
+ * 32 V bus range, 320 mV shunt range, INA219_AVERAGING samples for both
+ * ADCs, continuous shunt and bus conversions.
+ */
+uint16_t ina219_config();
+
+/**
+ * @brief Returns the time of one averaged conversion, shunt or bus.
+ *
+ * Shunt and bus alternate, so a new pair of results is ready twice as often.
+ */
+uint32_t ina219_conversion_us();
+
+/**
+ * @brief Configures and calibrates a monitor.
+ *
+ * The I2C bus must already be started (hal_i2c_begin()).
+ *
+ * @param device (Output) Monitor state.
+ * @param address 7-bit address of the chip.
+ * @return true if the chip acknowledged both writes and reads the configuration back, false otherwise.
+ */
+bool ina219_init(Ina219 *device, uint8_t address);
+
+/**
+ * @brief Reads the latest bus voltage and current.
+ *
+ * @param device Monitor.
+ * @param sample (Output) Latest result.
+ * @return true if both registers were read, false otherwise.
+ */
+bool ina219_read(Ina219 *device, Ina219Sample *sample);
+
+/**
+ * @brief Decodes the bus voltage and current registers.
+ *
+ * @param bus Bus voltage register, MSB first as read.
+ * @param current Current register, MSB first as read.
+ * @param sample (Output) Result.
+ */
+void ina219_parse(const uint8_t bus[2], const uint8_t current[2], Ina219Sample *sample);
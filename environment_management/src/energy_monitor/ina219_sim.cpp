@@ -0,0 +1,159 @@
+#if defined(HAL_LINUX)
+
+#include <string.h>
+#include "hal/hal.hpp"
+#include "hal/linux/hal_fake.hpp"
+#include "ina219.hpp"
+#include "ina219_sim.hpp"
+
+#define SIM_DEVICES 4
+#define SIM_SAMPLE_US 532       // One 12-bit conversion
+#define SIM_SHUNT_LSB_NV 10000  // 10 uV
+#define SIM_SHUNT_MAX_UV 320000 // 320 mV range
+
+struct SimDevice
+{
+    uint8_t address;
+    ina219_sim_load_t load;
+    void *ctx;
+    uint8_t pointer;
+    uint16_t config;
+    uint16_t calibration;
+    uint64_t start_us; // Conversions restart on every configuration write
+    uint32_t reads;
+};
+
+static SimDevice devices[SIM_DEVICES];
+static uint8_t device_count = 0;
+
+static uint32_t averaged_samples(uint16_t adc)
+{
+    return adc & 0x8 ? 1U << (adc & 0x7) : 1;
+}
+
+/* Average of the load over one averaged conversion starting at start_us */
+static void convert(SimDevice *device, uint64_t start_us, uint32_t samples, int64_t *mv, int64_t *ua)
+{
+    int64_t mv_sum = 0, ua_sum = 0;
+    for (uint32_t i = 0; i < samples; i++)
+    {
+        uint16_t bus_mv;
+        int32_t current_ua;
+        device->load(device->ctx, start_us + i * SIM_SAMPLE_US + SIM_SAMPLE_US / 2, &bus_mv, &current_ua);
+        mv_sum += bus_mv;
+        ua_sum += current_ua;
+    }
+    *mv = mv_sum / samples;
+    *ua = ua_sum / samples;
+}
+
+static uint16_t read_register(SimDevice *device, uint8_t reg)
+{
+    uint32_t shunt_samples = averaged_samples(device->config >> 3 & 0xF);
+    uint32_t bus_samples = averaged_samples(device->config >> 7 & 0xF);
+    uint64_t shunt_us = (uint64_t)shunt_samples * SIM_SAMPLE_US;
+    uint64_t cycle_us = shunt_us + (uint64_t)bus_samples * SIM_SAMPLE_US;
+    uint64_t elapsed_us = hal_micros() - device->start_us;
+    bool running = (device->config & 0x7) == 0x7;
+
+    switch (reg)
+    {
+    case INA219_REG_CONFIG:
+        return device->config;
+    case INA219_REG_CALIBRATION:
+        return device->calibration;
+    case INA219_REG_BUS:
+    {
+        if (!running || elapsed_us < cycle_us)
+        {
+            return 0;
+        }
+        uint64_t cycle = elapsed_us / cycle_us - 1; // Last one with both conversions done
+        int64_t mv, ua, unused;
+        convert(device, device->start_us + cycle * cycle_us + shunt_us, bus_samples, &mv, &unused);
+        convert(device, device->start_us + cycle * cycle_us, shunt_samples, &unused, &ua);
+        bool overflow = ua * (int64_t)INA219_SHUNT_MILLIOHM / 1000 > SIM_SHUNT_MAX_UV;
+        return (uint16_t)(mv / INA219_BUS_LSB_MV << 3 | 0x2 | (overflow ? 0x1 : 0));
+    }
+    case INA219_REG_SHUNT:
+    case INA219_REG_CURRENT:
+    {
+        if (!running || elapsed_us < shunt_us)
+        {
+            return 0;
+        }
+        uint64_t cycle = (elapsed_us - shunt_us) / cycle_us;
+        int64_t mv, ua;
+        convert(device, device->start_us + cycle * cycle_us, shunt_samples, &mv, &ua);
+        int64_t shunt_nv = ua * INA219_SHUNT_MILLIOHM;
+        int64_t shunt = (shunt_nv + (shunt_nv >= 0 ? SIM_SHUNT_LSB_NV / 2 : -SIM_SHUNT_LSB_NV / 2)) / SIM_SHUNT_LSB_NV;
+        shunt = shunt > 32000 ? 32000 : shunt < -32000 ? -32000 : shunt;
+        return (uint16_t)(int16_t)(reg == INA219_REG_SHUNT ? shunt : shunt * device->calibration / 4096);
+    }
+    case INA219_REG_POWER:
+    default:
+        return 0;
+    }
+}
+
+static bool on_transfer(void *ctx, const uint8_t *tx, size_t tx_length, uint8_t *rx, size_t rx_length)
+{
+    SimDevice *device = (SimDevice *)ctx;
+    if (tx_length > 0)
+    {
+        device->pointer = tx[0];
+    }
+    if (tx_length == 3)
+    {
+        uint16_t value = (uint16_t)(tx[1] << 8 | tx[2]);
+        if (device->pointer == INA219_REG_CONFIG)
+        {
+            device->config = value;
+            device->start_us = hal_micros();
+        }
+        else if (device->pointer == INA219_REG_CALIBRATION)
+        {
+            device->calibration = value & 0xFFFE; // Bit 0 is not used
+        }
+    }
+    if (rx_length > 0)
+    {
+        uint16_t value = read_register(device, device->pointer);
+        rx[0] = (uint8_t)(value >> 8);
+        if (rx_length > 1)
+        {
+            rx[1] = (uint8_t)value;
+        }
+        device->reads++;
+    }
+    return true;
+}
+
+void ina219_sim_attach(uint8_t address, ina219_sim_load_t load, void *ctx)
+{
+    if (device_count == SIM_DEVICES)
+    {
+        return;
+    }
+    SimDevice *device = &devices[device_count++];
+    memset(device, 0, sizeof(*device));
+    device->address = address;
+    device->load = load;
+    device->ctx = ctx;
+    device->config = 0x399F; // Power-on default
+    hal_fake_i2c_attach(address, on_transfer, device);
+}
+
+uint32_t ina219_sim_reads(uint8_t address)
+{
+    for (uint8_t i = 0; i < device_count; i++)
+    {
+        if (devices[i].address == address)
+        {
+            return devices[i].reads;
+        }
+    }
+    return 0;
+}
+
+#endif // HAL_LINUX
@@ -0,0 +1,37 @@
+#pragma once
+
+/*
+ * Register model of the INA219 on the fake I2C bus, for host builds.
+ *
+ * Once configured, the model converts continuously like the chip: a
+ * shunt conversion, then a bus conversion, each averaging the configured
+ * number of 532 us samples of the load. Registers return the last
+ * completed results, quantized to the register LSBs and scaled by the
+ * calibration register. The load is a function of virtual time, so
+ * results only make sense under the simulator (hal_sim_begin()).
+ */
+
+#if defined(HAL_LINUX)
+
+#include <stdint.h>
+
+/// Load seen by a monitor at a virtual time.
+typedef void (*ina219_sim_load_t)(void *ctx, uint64_t time_us, uint16_t *bus_mv, int32_t *current_ua);
+
+/**
+ * @brief Attaches a simulated monitor to the fake I2C bus.
+ *
+ * @param address 7-bit address of the chip.
+ * @param load Load on the monitored line.
+ * @param ctx Argument passed to the load.
+ */
+void ina219_sim_attach(uint8_t address, ina219_sim_load_t load, void *ctx);
+
+/**
+ * @brief Returns the number of register reads of a monitor since it was attached.
+ *
+ * @param address 7-bit address of the chip.
+ */
+uint32_t ina219_sim_reads(uint8_t address);
+
+#endif // HAL_LINUX
@@ -0,0 +1,201 @@
+#include "hal/hal.hpp"
+#include "bme280.hpp"
+
+#define BME280_TAG "app_bme280"
+
+#define BME280_RESET_WORD 0xB6
+#define BME280_STARTUP_MS 2      // Trimming parameters copied after a reset
+#define BME280_MODE_FORCED 0x01
+#define BME280_SKIPPED_20 0x80000 // Value of a skipped 20-bit measurement
+#define BME280_SKIPPED_16 0x8000  // Value of a skipped humidity measurement
+
+static constexpr uint8_t log2_of(uint16_t n, uint8_t log2 = 0)
+{
+    return n <= 1 ? log2 : log2_of(n / 2, log2 + 1);
+}
+
+/* osrs_x field: 0 skipped, 1 + log2(samples) otherwise */
+static constexpr uint8_t oversampling_setting(uint16_t samples)
+{
+    return samples == 0 ? 0 : log2_of(samples) + 1;
+}
+
+/* Measurement time of one oversampled value, datasheet maximum */
+static constexpr uint32_t measure_us(uint16_t samples, uint32_t setup_us)
+{
+    return samples == 0 ? 0 : 2300UL * samples + setup_us;
+}
+
+static_assert(oversampling_setting(0) == 0 && oversampling_setting(1) == 1 && oversampling_setting(16) == 5,
+              "Oversampling setting");
+static_assert((BME280_OVERSAMPLING_T & (BME280_OVERSAMPLING_T - 1)) == 0 && BME280_OVERSAMPLING_T <= 16 &&
+                  (BME280_OVERSAMPLING_P & (BME280_OVERSAMPLING_P - 1)) == 0 && BME280_OVERSAMPLING_P <= 16 &&
+                  (BME280_OVERSAMPLING_H & (BME280_OVERSAMPLING_H - 1)) == 0 && BME280_OVERSAMPLING_H <= 16,
+              "BME280 oversampling must be 0, 1, 2, 4, 8 or 16");
+static_assert(BME280_OVERSAMPLING_T > 0, "Pressure and humidity are compensated with the temperature");
+static_assert(BME280_FILTER == 0 || ((BME280_FILTER & (BME280_FILTER - 1)) == 0 && BME280_FILTER >= 2 &&
+                                     BME280_FILTER <= 16),
+              "BME280_FILTER must be 0, 2, 4, 8 or 16");
+
+static uint8_t ctrl_meas(uint8_t mode)
+{
+    return oversampling_setting(BME280_OVERSAMPLING_T) << 5 | oversampling_setting(BME280_OVERSAMPLING_P) << 2 | mode;
+}
+
+uint8_t bme280_forced_ctrl_meas()
+{
+    return ctrl_meas(BME280_MODE_FORCED);
+}
+
+uint32_t bme280_measurement_us()
+{
+    return 1250 + measure_us(BME280_OVERSAMPLING_T, 0) + measure_us(BME280_OVERSAMPLING_P, 575) +
+           measure_us(BME280_OVERSAMPLING_H, 575);
+}
+
+static bool write_register(uint8_t address, uint8_t reg, uint8_t value)
+{
+    uint8_t tx[2] = {reg, value};
+    return hal_i2c_write(address, tx, sizeof(tx));
+}
+
+static bool read_registers(uint8_t address, uint8_t reg, uint8_t *rx, size_t length)
+{
+    return hal_i2c_write_read(address, &reg, 1, rx, length);
+}
+
+bool bme280_init(Bme280 *device, uint8_t address)
+{
+    device->address = address;
+
+    uint8_t id = 0;
+    if (!read_registers(address, BME280_REG_CHIP_ID, &id, 1) || id != BME280_CHIP_ID)
+    {
+        ESP_LOGE(BME280_TAG, "No BME280 at 0x%02x (chip id 0x%02x)", address, id);
+        return false;
+    }
+
+    uint8_t t1_to_h1[26], h2_to_h6[7], meas = 0;
+    bool ok = write_register(address, BME280_REG_RESET, BME280_RESET_WORD);
+    hal_delay_ms(BME280_STARTUP_MS);
+    ok = ok && read_registers(address, BME280_REG_CALIB_T1, t1_to_h1, sizeof(t1_to_h1)) &&
+         read_registers(address, BME280_REG_CALIB_H2, h2_to_h6, sizeof(h2_to_h6)) &&
+         // ctrl_hum only takes effect with the next ctrl_meas write
+         write_register(address, BME280_REG_CTRL_HUM, oversampling_setting(BME280_OVERSAMPLING_H)) &&
+         write_register(address, BME280_REG_CONFIG, log2_of(BME280_FILTER) << 2) &&
+         write_register(address, BME280_REG_CTRL_MEAS, ctrl_meas(0)) &&
+         read_registers(address, BME280_REG_CTRL_MEAS, &meas, 1) && meas == ctrl_meas(0);
+    if (!ok)
+    {
+        ESP_LOGE(BME280_TAG, "BME280 at 0x%02x not answering", address);
+        return false;
+    }
+    bme280_parse_calibration(t1_to_h1, h2_to_h6, &device->calibration);
+
+    ESP_LOGI(BME280_TAG, "BME280 at 0x%02x: oversampling T x%d P x%d H x%d, filter %d, %lu us per measurement",
+             address, BME280_OVERSAMPLING_T, BME280_OVERSAMPLING_P, BME280_OVERSAMPLING_H, BME280_FILTER,
+             (unsigned long)bme280_measurement_us());
+    return true;
+}
+
+bool bme280_read_forced(Bme280 *device, Bme280Sample *sample)
+{
+    uint8_t burst[BME280_BURST_LENGTH];
+    if (!write_register(device->address, BME280_REG_CTRL_MEAS, bme280_forced_ctrl_meas()))
+    {
+        return false;
+    }
+    hal_delay_ms((bme280_measurement_us() + 999) / 1000);
+    return read_registers(device->address, BME280_REG_DATA, burst, sizeof(burst)) &&
+           bme280_compensate(&device->calibration, burst, sample);
+}
+
+/* Little-endian 16-bit trimming parameter */
+static uint16_t le16(const uint8_t *bytes)
+{
+    return (uint16_t)(bytes[1] << 8 | bytes[0]);
+}
+
+void bme280_parse_calibration(const uint8_t t1_to_h1[26], const uint8_t h2_to_h6[7], Bme280Calibration *calibration)
+{
+    const uint8_t *b = t1_to_h1;
+    calibration->t1 = le16(b);
+    calibration->t2 = (int16_t)le16(b + 2);
+    calibration->t3 = (int16_t)le16(b + 4);
+    calibration->p1 = le16(b + 6);
+    calibration->p2 = (int16_t)le16(b + 8);
+    calibration->p3 = (int16_t)le16(b + 10);
+    calibration->p4 = (int16_t)le16(b + 12);
+    calibration->p5 = (int16_t)le16(b + 14);
+    calibration->p6 = (int16_t)le16(b + 16);
+    calibration->p7 = (int16_t)le16(b + 18);
+    calibration->p8 = (int16_t)le16(b + 20);
+    calibration->p9 = (int16_t)le16(b + 22);
+    calibration->h1 = b[25]; // 0xA1, after a reserved byte
+
+    const uint8_t *h = h2_to_h6;
+    calibration->h2 = (int16_t)le16(h);
+    calibration->h3 = h[2];
+    calibration->h4 = (int16_t)((int8_t)h[3] * 16 | (h[4] & 0x0F)); // 12 bits, E4 holds the signed MSB
+    calibration->h5 = (int16_t)((int8_t)h[5] * 16 | h[4] >> 4);
+    calibration->h6 = (int8_t)h[6];
+}
+
+/* Temperature in 0.01 °C, and t_fine for the other two */
+static int32_t compensate_temperature(const Bme280Calibration *c, int32_t adc, int32_t *t_fine)
+{
+    int32_t var1 = ((adc >> 3) - ((int32_t)c->t1 << 1)) * c->t2 >> 11;
+    int32_t var2 = (((adc >> 4) - (int32_t)c->t1) * ((adc >> 4) - (int32_t)c->t1) >> 12) * c->t3 >> 14;
+    *t_fine = var1 + var2;
+    return (*t_fine * 5 + 128) >> 8;
+}
+
+/* Pressure in Pa, Q24.8 */
+static uint32_t compensate_pressure(const Bme280Calibration *c, int32_t adc, int32_t t_fine)
+{
+    int64_t var1 = (int64_t)t_fine - 128000;
+    int64_t var2 = var1 * var1 * c->p6;
+    var2 += (var1 * c->p5) * 131072;
+    var2 += (int64_t)c->p4 * 34359738368LL;
+    var1 = (var1 * var1 * c->p3 >> 8) + (var1 * c->p2) * 4096;
+    var1 = (140737488355328LL + var1) * c->p1 >> 33;
+    if (var1 == 0)
+    {
+        return 0; // Avoids a division by zero with an erased calibration
+    }
+    int64_t p = 1048576 - adc;
+    p = ((p * 2147483648LL - var2) * 3125) / var1;
+    var1 = ((int64_t)c->p9 * (p >> 13) * (p >> 13)) >> 25;
+    var2 = ((int64_t)c->p8 * p) >> 19;
+    return (uint32_t)(((p + var1 + var2) >> 8) + (int64_t)c->p7 * 16);
+}
+
+/* Relative humidity in %, Q22.10 */
+static uint32_t compensate_humidity(const Bme280Calibration *c, int32_t adc, int32_t t_fine)
+{
+    int32_t v = t_fine - 76800;
+    int32_t x = ((adc << 14) - c->h4 * 1048576 - c->h5 * v + 16384) >> 15;
+    int32_t y = ((((v * c->h6 >> 10) * ((v * c->h3 >> 11) + 32768) >> 10) + 2097152) * c->h2 + 8192) >> 14;
+    x *= y;
+    x -= (((x >> 15) * (x >> 15) >> 7) * c->h1) >> 4;
+    x = x < 0 ? 0 : x > 419430400 ? 419430400 : x; // 0 to 100 %
+    return (uint32_t)(x >> 12);
+}
+
+bool bme280_compensate(const Bme280Calibration *calibration, const uint8_t burst[BME280_BURST_LENGTH],
+                       Bme280Sample *sample)
+{
+    int32_t adc_p = (int32_t)burst[0] << 12 | burst[1] << 4 | burst[2] >> 4;
+    int32_t adc_t = (int32_t)burst[3] << 12 | burst[4] << 4 | burst[5] >> 4;
+    int32_t adc_h = (int32_t)burst[6] << 8 | burst[7];
+    if (adc_t == BME280_SKIPPED_20)
+    {
+        return false;
+    }
+
+    int32_t t_fine;
+    sample->temperature_centi = compensate_temperature(calibration, adc_t, &t_fine);
+    sample->pressure_q8 = adc_p == BME280_SKIPPED_20 ? 0 : compensate_pressure(calibration, adc_p, t_fine);
+    sample->humidity_q10 = adc_h == BME280_SKIPPED_16 ? 0 : compensate_humidity(calibration, adc_h, t_fine);
+    return true;
+}
@@ -0,0 +1,133 @@
+#pragma once
+
+/*
+ * Driver of the BME280 temperature, humidity and pressure sensor, on the
+ * HAL I2C bus.
+ *
+ * The chip sleeps between measurements: a forced conversion is triggered
+ * by writing ctrl_meas, and once it is done, pressure, temperature and
+ * humidity are fetched in one 8-byte burst from 0xF7. The datasheet
+ * fixed-point compensation then runs once for the three values, the
+ * temperature term (t_fine) shared by pressure and humidity.
+ *
+ * Oversampling of each measurement and the IIR filter are set at build
+ * time, per deployment. An oversampling of 0 skips the measurement.
+ */
+
+#include <stdint.h>
+
+#define BME280_CHIP_ID 0x60
+#define BME280_BURST_LENGTH 8 // press_msb (0xF7) to hum_lsb (0xFE)
+
+/* Oversampling of each measurement: 0 (skipped), 1, 2, 4, 8 or 16 */
+#ifndef BME280_OVERSAMPLING_T
+#define BME280_OVERSAMPLING_T 1
+#endif
+#ifndef BME280_OVERSAMPLING_P
+#define BME280_OVERSAMPLING_P 1
+#endif
+#ifndef BME280_OVERSAMPLING_H
+#define BME280_OVERSAMPLING_H 1
+#endif
+
+/* IIR filter coefficient: 0 (off), 2, 4, 8 or 16 */
+#ifndef BME280_FILTER
+#define BME280_FILTER 0
+#endif
+
+/// Registers of the chip.
+enum Bme280Register : uint8_t
+{
+    BME280_REG_CALIB_T1 = 0x88, ///< dig_T1 to dig_H1, 26 bytes.
+    BME280_REG_CHIP_ID = 0xD0,
+    BME280_REG_RESET = 0xE0,
+    BME280_REG_CALIB_H2 = 0xE1, ///< dig_H2 to dig_H6, 7 bytes.
+    BME280_REG_CTRL_HUM = 0xF2,
+    BME280_REG_STATUS = 0xF3,
+    BME280_REG_CTRL_MEAS = 0xF4,
+    BME280_REG_CONFIG = 0xF5,
+    BME280_REG_DATA = 0xF7,
+};
+
+/// Trimming parameters stored in the chip.
+struct Bme280Calibration
+{
+    uint16_t t1;
+    int16_t t2, t3;
+    uint16_t p1;
+    int16_t p2, p3, p4, p5, p6, p7, p8, p9;
+    uint8_t h1;
+    int16_t h2;
+    uint8_t h3;
+    int16_t h4, h5;
+    int8_t h6;
+};
+
+/// One sensor on the bus.
+struct Bme280
+{
+    uint8_t address;
+    Bme280Calibration calibration;
+};
+
+/// Compensated measurement.
+struct Bme280Sample
+{
+    int32_t temperature_centi; ///< 0.01 °C.
+    uint32_t pressure_q8;      ///< Pa in Q24.8, 0 if skipped.
+    uint32_t humidity_q10;     ///< %RH in Q22.10, 0 if skipped.
+};
+
+/**
+ * @brief Returns the ctrl_meas value starting a forced conversion with the build settings.
+ */
+uint8_t bme280_forced_ctrl_meas();
+
+/**
+ * @brief Returns the longest time of a forced conversion with the build settings (datasheet maximum).
+ */
+uint32_t bme280_measurement_us();
+
+/**
+ * @brief Checks the chip, reads its trimming parameters and applies the build settings.
+ *
+ * The I2C bus must already be started (hal_i2c_begin()). The chip is
+ * left asleep.
+ *
+ * @param device (Output) Sensor state.
+ * @param address 7-bit address of the chip.
+ * @return true if the chip answered with the BME280 chip id and took the settings, false otherwise.
+ */
+bool bme280_init(Bme280 *device, uint8_t address);
+
+/**
+ * @brief Triggers a forced conversion, waits for it and reads the result.
+ *
+ * Blocks the calling task for bme280_measurement_us(). Once the shared
+ * bus task runs, the same transfers are queued instead.
+ *
+ * @param device Sensor.
+ * @param sample (Output) Compensated measurement.
+ * @return true if the measurement was read, false otherwise.
+ */
+bool bme280_read_forced(Bme280 *device, Bme280Sample *sample);
+
+/**
+ * @brief Decodes the trimming parameters.
+ *
+ * @param t1_to_h1 26 bytes read from BME280_REG_CALIB_T1.
+ * @param h2_to_h6 7 bytes read from BME280_REG_CALIB_H2.
+ * @param calibration (Output) Trimming parameters.
+ */
+void bme280_parse_calibration(const uint8_t t1_to_h1[26], const uint8_t h2_to_h6[7], Bme280Calibration *calibration);
+
+/**
+ * @brief Compensates a burst with the datasheet integer formulas.
+ *
+ * @param calibration Trimming parameters of the chip.
+ * @param burst BME280_BURST_LENGTH bytes read from BME280_REG_DATA.
+ * @param sample (Output) Compensated measurement.
+ * @return true if the burst holds a conversion, false if the temperature was not measured yet.
+ */
+bool bme280_compensate(const Bme280Calibration *calibration, const uint8_t burst[BME280_BURST_LENGTH],
+                       Bme280Sample *sample);
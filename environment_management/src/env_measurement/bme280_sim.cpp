@@ -0,0 +1,214 @@
+#if defined(HAL_LINUX)
+
+#include <string.h>
+#include "hal/hal.hpp"
+#include "hal/linux/hal_fake.hpp"
+#include "bme280.hpp"
+#include "bme280_sim.hpp"
+
+#define SIM_DEVICES 2
+#define SIM_STATUS_MEASURING 0x08
+
+/* Trimming parameters of a typical chip: the datasheet example for T and P */
+static const Bme280Calibration sim_calibration = {27504, 26435, -1000, 36477, -10685, 3024, 2855, 140, -7,
+                                                  15500, -14600, 6000, 75, 362, 0, 313, 50, 30};
+
+struct SimDevice
+{
+    uint8_t address;
+    bme280_sim_climate_t climate;
+    void *ctx;
+    uint8_t pointer;
+    uint8_t registers[256];
+    uint64_t done_us; // End of the conversion under way
+    uint8_t pending[BME280_BURST_LENGTH];
+    uint32_t conversions;
+};
+
+static SimDevice devices[SIM_DEVICES];
+static uint8_t device_count = 0;
+
+static void put_le16(uint8_t *bytes, uint16_t value)
+{
+    bytes[0] = (uint8_t)value;
+    bytes[1] = (uint8_t)(value >> 8);
+}
+
+static void reset(SimDevice *device)
+{
+    uint8_t *r = device->registers;
+    memset(r, 0, sizeof(device->registers));
+    r[BME280_REG_CHIP_ID] = BME280_CHIP_ID;
+
+    const Bme280Calibration &c = sim_calibration;
+    const uint16_t words[12] = {c.t1, (uint16_t)c.t2, (uint16_t)c.t3, c.p1, (uint16_t)c.p2, (uint16_t)c.p3,
+                                (uint16_t)c.p4, (uint16_t)c.p5, (uint16_t)c.p6, (uint16_t)c.p7, (uint16_t)c.p8,
+                                (uint16_t)c.p9};
+    for (int i = 0; i < 12; i++)
+    {
+        put_le16(&r[BME280_REG_CALIB_T1 + 2 * i], words[i]);
+    }
+    r[0xA1] = c.h1;
+    put_le16(&r[BME280_REG_CALIB_H2], (uint16_t)c.h2);
+    r[0xE3] = c.h3;
+    r[0xE4] = (uint8_t)(c.h4 >> 4);
+    r[0xE5] = (uint8_t)((c.h4 & 0x0F) | (c.h5 & 0x0F) << 4);
+    r[0xE6] = (uint8_t)(c.h5 >> 4);
+    r[0xE7] = (uint8_t)c.h6;
+
+    // Data registers read as skipped until the first conversion
+    r[BME280_REG_DATA] = r[BME280_REG_DATA + 3] = 0x80;
+    r[BME280_REG_DATA + 6] = 0x80;
+    device->done_us = 0;
+}
+
+static void put_raw(uint8_t burst[BME280_BURST_LENGTH], int32_t adc_p, int32_t adc_t, int32_t adc_h)
+{
+    burst[0] = (uint8_t)(adc_p >> 12);
+    burst[1] = (uint8_t)(adc_p >> 4);
+    burst[2] = (uint8_t)(adc_p << 4);
+    burst[3] = (uint8_t)(adc_t >> 12);
+    burst[4] = (uint8_t)(adc_t >> 4);
+    burst[5] = (uint8_t)(adc_t << 4);
+    burst[6] = (uint8_t)(adc_h >> 8);
+    burst[7] = (uint8_t)adc_h;
+}
+
+/* Value of a channel for a raw value, pressure negated to rise with it like the others */
+static double compensated(int channel, int32_t adc_t, int32_t adc_p, int32_t raw)
+{
+    uint8_t burst[BME280_BURST_LENGTH];
+    Bme280Sample sample;
+    put_raw(burst, channel == 1 ? raw : adc_p, channel == 0 ? raw : adc_t, channel == 2 ? raw : 0);
+    bme280_compensate(&sim_calibration, burst, &sample);
+    return channel == 0 ? sample.temperature_centi / 100.0
+           : channel == 1 ? -(sample.pressure_q8 / 256.0)
+                          : sample.humidity_q10 / 1024.0;
+}
+
+/* Raw value giving the nearest value to the target, the compensation being monotonic in every raw value */
+static int32_t invert(int channel, int32_t adc_t, int32_t adc_p, double target, int32_t limit)
+{
+    int32_t low = 0, high = limit;
+    while (low < high)
+    {
+        int32_t middle = low + (high - low) / 2;
+        if (compensated(channel, adc_t, adc_p, middle) < target)
+        {
+            low = middle + 1;
+        }
+        else
+        {
+            high = middle;
+        }
+    }
+    if (low > 0 && target - compensated(channel, adc_t, adc_p, low - 1) <
+                       compensated(channel, adc_t, adc_p, low) - target)
+    {
+        low--;
+    }
+    return low;
+}
+
+/* Starts a forced conversion of the climate now */
+static void convert(SimDevice *device)
+{
+    uint8_t meas = device->registers[BME280_REG_CTRL_MEAS];
+    uint8_t osrs[3] = {(uint8_t)(meas >> 5), (uint8_t)(meas >> 2 & 0x7),
+                       (uint8_t)(device->registers[BME280_REG_CTRL_HUM] & 0x7)};
+    uint32_t typical_us = 1000;
+    for (int i = 0; i < 3; i++)
+    {
+        if (osrs[i] > 0)
+        {
+            typical_us += 2000 * (1 << (osrs[i] > 5 ? 4 : osrs[i] - 1)) + (i > 0 ? 500 : 0); // Datasheet typical
+        }
+    }
+
+    uint64_t now_us = hal_micros();
+    float celsius, pascal, percent;
+    device->climate(device->ctx, now_us, &celsius, &pascal, &percent);
+    int32_t adc_t = osrs[0] > 0 ? invert(0, 0, 0, celsius, 0xFFFFF) : 0x80000;
+    int32_t adc_p = osrs[1] > 0 ? invert(1, adc_t, 0, -pascal, 0xFFFFF) : 0x80000;
+    int32_t adc_h = osrs[2] > 0 ? invert(2, adc_t, adc_p, percent, 0xFFFF) : 0x8000;
+    put_raw(device->pending, adc_p, adc_t, adc_h);
+    device->done_us = now_us + typical_us;
+    device->conversions++;
+}
+
+/* Completes the conversion if its time has come */
+static void update(SimDevice *device)
+{
+    if (device->done_us != 0 && hal_micros() >= device->done_us)
+    {
+        memcpy(&device->registers[BME280_REG_DATA], device->pending, BME280_BURST_LENGTH);
+        device->registers[BME280_REG_CTRL_MEAS] &= ~0x3; // Back to sleep
+        device->done_us = 0;
+    }
+    device->registers[BME280_REG_STATUS] = device->done_us != 0 ? SIM_STATUS_MEASURING : 0;
+}
+
+static bool on_transfer(void *ctx, const uint8_t *tx, size_t tx_length, uint8_t *rx, size_t rx_length)
+{
+    SimDevice *device = (SimDevice *)ctx;
+    update(device);
+    if (tx_length > 0)
+    {
+        device->pointer = tx[0];
+    }
+    for (size_t i = 0; i + 1 < tx_length; i += 2) // Register and value pairs
+    {
+        uint8_t reg = tx[i], value = tx[i + 1];
+        if (reg == BME280_REG_RESET && value == 0xB6)
+        {
+            reset(device);
+        }
+        else if (reg == BME280_REG_CTRL_HUM || reg == BME280_REG_CONFIG)
+        {
+            device->registers[reg] = value;
+        }
+        else if (reg == BME280_REG_CTRL_MEAS)
+        {
+            device->registers[reg] = value;
+            uint8_t mode = value & 0x3;
+            if (mode == 0x1 || mode == 0x2)
+            {
+                convert(device);
+            }
+        }
+    }
+    for (size_t i = 0; i < rx_length; i++)
+    {
+        rx[i] = device->registers[(uint8_t)(device->pointer + i)];
+    }
+    return true;
+}
+
+void bme280_sim_attach(uint8_t address, bme280_sim_climate_t climate, void *ctx)
+{
+    if (device_count == SIM_DEVICES)
+    {
+        return;
+    }
+    SimDevice *device = &devices[device_count++];
+    memset(device, 0, sizeof(*device));
+    device->address = address;
+    device->climate = climate;
+    device->ctx = ctx;
+    reset(device);
+    hal_fake_i2c_attach(address, on_transfer, device);
+}
+
+uint32_t bme280_sim_conversions(uint8_t address)
+{
+    for (uint8_t i = 0; i < device_count; i++)
+    {
+        if (devices[i].address == address)
+        {
+            return devices[i].conversions;
+        }
+    }
+    return 0;
+}
+
+#endif // HAL_LINUX
@@ -0,0 +1,38 @@
+#pragma once
+
+/*
+ * Register model of the BME280 on the fake I2C bus, for host builds.
+ *
+ * The model holds the trimming parameters of a typical chip and converts
+ * on a forced-mode write of ctrl_meas like the chip: the conversion takes
+ * its typical time for the oversampling set, then the data registers hold
+ * the raw values of the climate at the start of the conversion, found by
+ * inverting the compensation of the driver. Oversampling noise and the IIR
+ * filter are not modelled. The climate is a function of virtual time, so
+ * results only make sense under the simulator (hal_sim_begin()).
+ */
+
+#if defined(HAL_LINUX)
+
+#include <stdint.h>
+
+/// Climate around a sensor at a virtual time.
+typedef void (*bme280_sim_climate_t)(void *ctx, uint64_t time_us, float *celsius, float *pascal, float *percent);
+
+/**
+ * @brief Attaches a simulated sensor to the fake I2C bus.
+ *
+ * @param address 7-bit address of the chip.
+ * @param climate Climate around the sensor.
+ * @param ctx Argument passed to the climate.
+ */
+void bme280_sim_attach(uint8_t address, bme280_sim_climate_t climate, void *ctx);
+
+/**
+ * @brief Returns the number of forced conversions of a sensor since it was attached.
+ *
+ * @param address 7-bit address of the chip.
+ */
+uint32_t bme280_sim_conversions(uint8_t address);
+
+#endif // HAL_LINUX
@@ -1,29 +1,123 @@
 #include "env_measurement.hpp"
-#include <Adafruit_BME280.h>
-#include <Wire.h>
+#include "../telemetry/telemetry.hpp"
+#include "../i2c_bus/i2c_bus.hpp"
 
 #define ENV_MEASUREMENT_TAG "app_env_measurement"
-#define BME280_I2C_ADDRESS  0x76  // Adres BME280 (może być 0x77)
 
-Adafruit_BME280 bme;
+static Bme280 sensor;
+static uint8_t device = I2C_BUS_NO_DEVICE; // Handle on the I2C bus
+static uint8_t burst[BME280_BURST_LENGTH];  // Filled by the bus task
+static volatile bool read_pending = false;  // A batch is queued or running
+static bool converted = false;              // The previous batch started a conversion
+static EnvReading latest;
+static bool latest_valid = false;
+static hal_mutex_t latest_mutex = NULL; // Written in the bus task, read by the fan control
 
-bool init_env_measurement() {
+bool init_env_measurement()
+{
     ESP_LOGI(ENV_MEASUREMENT_TAG, "Initializing BME280 sensor...");
-    
-    if (!bme.begin(BME280_I2C_ADDRESS)) {
+
+    latest_mutex = hal_mutex_create();
+    if (latest_mutex == NULL)
+    {
+        ESP_LOGE(ENV_MEASUREMENT_TAG, "Failed to create mutex");
+        return false;
+    }
+
+    if (!bme280_init(&sensor, BME280_I2C_ADDRESS))
+    {
         ESP_LOGE(ENV_MEASUREMENT_TAG, "BME280 not found! Check wiring.");
         return false;
     }
-    
+    device = i2c_bus_add_device(BME280_I2C_ADDRESS, BME280_TIMEOUT_MS, "BME280");
+    if (device == I2C_BUS_NO_DEVICE)
+    {
+        return false;
+    }
+
     ESP_LOGI(ENV_MEASUREMENT_TAG, "BME280 initialized successfully.");
     return true;
 }
 
-void handle_env_measurement() {
-    float temperature = bme.readTemperature();
-    float humidity = bme.readHumidity();
-    float pressure = bme.readPressure() / 100.0F;
+/* Compensates the burst of a batch, in the bus task */
+static void on_burst(void *ctx, uint8_t failed)
+{
+    (void)ctx;
+    bool fresh = converted && (failed & 0x1) == 0; // A burst after a failed start holds the older conversion
+    converted = (failed & 0x2) == 0;
+    Bme280Sample sample;
+    bool valid = fresh && bme280_compensate(&sensor.calibration, burst, &sample);
+    read_pending = false;
+    if (!valid)
+    {
+        if (failed != 0)
+        {
+            ESP_LOGW(ENV_MEASUREMENT_TAG, "BME280 read failed");
+        }
+        return;
+    }
+
+    float temperature = sample.temperature_centi / 100.0f;
+    telemetry_add(TELEMETRY_TEMPERATURE, temperature);
+    float humidity = sample.humidity_q10 / 1024.0f;
+    if (BME280_OVERSAMPLING_H > 0)
+    {
+        telemetry_add(TELEMETRY_HUMIDITY, humidity);
+    }
+    float pressure = sample.pressure_q8 / 25600.0f; // hPa
+    if (BME280_OVERSAMPLING_P > 0)
+    {
+        telemetry_add(TELEMETRY_PRESSURE, pressure);
+    }
+
+    hal_mutex_take(latest_mutex, HAL_WAIT_FOREVER);
+    latest.temperature = temperature;
+    latest.humidity = BME280_OVERSAMPLING_H > 0 ? humidity : 0;
+    latest.pressure = BME280_OVERSAMPLING_P > 0 ? pressure : 0;
+    latest.time_ms = hal_millis();
+    latest_valid = true;
+    hal_mutex_give(latest_mutex);
 
-    ESP_LOGI(ENV_MEASUREMENT_TAG, "Temperature: %.2f °C, Humidity: %.2f %%, Pressure: %.2f hPa",
+    ESP_LOGD(ENV_MEASUREMENT_TAG, "Temperature: %.2f °C, Humidity: %.2f %%, Pressure: %.2f hPa",
              temperature, humidity, pressure);
 }
+
+void handle_env_measurement()
+{
+    if (read_pending)
+    {
+        ESP_LOGW(ENV_MEASUREMENT_TAG, "Previous BME280 read still queued, measurement skipped");
+        return;
+    }
+
+    I2cRequest request = {};
+    I2cOp &read = request.ops[0];
+    read.device = device;
+    read.tx[0] = BME280_REG_DATA;
+    read.tx_length = 1;
+    read.rx = burst;
+    read.rx_length = BME280_BURST_LENGTH;
+    I2cOp &start = request.ops[1];
+    start.device = device;
+    start.tx[0] = BME280_REG_CTRL_MEAS;
+    start.tx[1] = bme280_forced_ctrl_meas();
+    start.tx_length = 2;
+    request.count = 2;
+    request.callback = on_burst;
+
+    read_pending = true;
+    if (!i2c_bus_submit(&request))
+    {
+        read_pending = false;
+        ESP_LOGW(ENV_MEASUREMENT_TAG, "I2C bus queue full, BME280 read dropped");
+    }
+}
+
+bool env_measurement_latest(EnvReading *reading)
+{
+    hal_mutex_take(latest_mutex, HAL_WAIT_FOREVER);
+    bool valid = latest_valid;
+    *reading = latest;
+    hal_mutex_give(latest_mutex);
+    return valid;
+}
@@ -1,11 +1,45 @@
 #pragma once
 
-#include <Arduino.h>
-#include "esp_log.h"
-#include <Adafruit_BME280.h>
+#include "hal/hal.hpp"
+#include "bme280.hpp"
 
-// Inicjalizacja czujnika BME280
+#define BME280_I2C_ADDRESS 0x76 // SDO to GND (0x77 to VDDIO)
+#define BME280_TIMEOUT_MS 10    // The BME280 does not stretch the clock
+
+/// Latest compensated measurement.
+struct EnvReading
+{
+    float temperature; ///< °C.
+    float humidity;    ///< %RH, 0 if not measured (BME280_OVERSAMPLING_H).
+    float pressure;    ///< hPa, 0 if not measured (BME280_OVERSAMPLING_P).
+    uint32_t time_ms;  ///< hal_millis() when it was read.
+};
+
+/**
+ * @brief Initializes the BME280 sensor.
+ *
+ * Reads the trimming parameters and applies the oversampling and filter
+ * settings of the build (see bme280.hpp), on the shared I2C bus
+ * (init_i2c_bus() first).
+ *
+ * @return true if initialization was successful, false otherwise.
+ */
 bool init_env_measurement();
 
-// Funkcja do obsługi pomiarów środowiskowych
+/**
+ * @brief Measures temperature, humidity and pressure, called every second.
+ *
+ * Queues one batch on the I2C bus: the burst read of the conversion
+ * started by the previous call, then the start of the next forced
+ * conversion, which is long done by the next call. The readings go to the
+ * telemetry when the batch completes, in the bus task.
+ */
 void handle_env_measurement();
+
+/**
+ * @brief Returns the latest measurement, from any task.
+ *
+ * @param reading (Output) Latest measurement.
+ * @return true if a measurement was read since boot, false otherwise.
+ */
+bool env_measurement_latest(EnvReading *reading);
@@ -1,63 +1,268 @@
+#include <stdio.h>
+#include <string.h>
 #include "fan_control.hpp"
+#include "../uplink/uplink.hpp"
+#include "../env_measurement/env_measurement.hpp"
 
 #define FAN_CONTROL_TAG "app_fan_control"
+#define FAN_NVS_NAMESPACE "fan"
 
-// Fan state variables
-bool state1;
-bool state2;
+static const int pins[FANS] = {RELAY_FAN_1_PIN, RELAY_FAN_2_PIN};
+static const char *const nvs_keys[FANS] = {"fan1", "fan2"};
+static const char *const mode_names[] = {"hysteresis", "pi"};
+
+static FanController controllers[FANS];
+static float values[FANS];                  // Value of the latest update
+static bool changed[FANS];                  // State to publish
+static hal_mutex_t fans_mutex = NULL; // Controlled in the fan task, published in the MQTT task
+
+static FanControlConfig pending[FANS]; // Received over MQTT, applied in the fan task
+static bool pending_valid[FANS];
+static hal_mutex_t pending_mutex = NULL;
+
+static uint32_t reading_ms = 0; // Time of the latest reading used
+static bool stale = false;
+
+static FanControlConfig default_config(uint8_t fan)
+{
+    FanControlConfig config;
+    config.mode = FAN_MODE_HYSTERESIS;
+    config.setpoint = fan == FAN_TEMPERATURE ? FAN_1_SETPOINT : FAN_2_SETPOINT;
+    config.band = fan == FAN_TEMPERATURE ? FAN_1_BAND : FAN_2_BAND;
+    config.kp = fan == FAN_TEMPERATURE ? FAN_1_KP : FAN_2_KP;
+    config.ti_s = fan == FAN_TEMPERATURE ? FAN_1_TI_S : FAN_2_TI_S;
+    config.period_ms = FAN_PI_PERIOD_MS;
+    config.min_on_ms = FAN_MIN_ON_MS;
+    config.min_off_ms = FAN_MIN_OFF_MS;
+    return config;
+}
+
+static FanControlConfig load_config(uint8_t fan)
+{
+    FanControlConfig config;
+    bool found = hal_nvs_get(FAN_NVS_NAMESPACE, nvs_keys[fan], &config, sizeof(config));
+
+    // Relay protection is not a setting
+    config.min_on_ms = FAN_MIN_ON_MS;
+    config.min_off_ms = FAN_MIN_OFF_MS;
+    config.period_ms = FAN_PI_PERIOD_MS;
+    if (!found || !fan_config_valid(&config))
+    {
+        return default_config(fan);
+    }
+    return config;
+}
+
+static void save_config(uint8_t fan, const FanControlConfig *config)
+{
+    if (!hal_nvs_set(FAN_NVS_NAMESPACE, nvs_keys[fan], config, sizeof(*config)))
+    {
+        ESP_LOGE(FAN_CONTROL_TAG, "Failed to save the fan %d setting", fan + 1);
+    }
+}
+
+static void on_config(const char *payload)
+{
+    unsigned int fan;
+    char mode[12];
+    float setpoint, first, second = 0;
+    int fields = sscanf(payload, "%u %11s %f %f %f", &fan, mode, &setpoint, &first, &second);
+    if (fields < 4 || fan < 1 || fan > FANS)
+    {
+        ESP_LOGW(FAN_CONTROL_TAG, "Malformed fan setting ignored");
+        return;
+    }
+
+    FanControlConfig config = default_config(fan - 1);
+    config.setpoint = setpoint;
+    if (strcmp(mode, mode_names[FAN_MODE_HYSTERESIS]) == 0 && fields == 4)
+    {
+        config.mode = FAN_MODE_HYSTERESIS;
+        config.band = first;
+    }
+    else if (strcmp(mode, mode_names[FAN_MODE_PI]) == 0 && fields == 5)
+    {
+        config.mode = FAN_MODE_PI;
+        config.kp = first;
+        config.ti_s = second;
+    }
+    else
+    {
+        ESP_LOGW(FAN_CONTROL_TAG, "Unknown fan mode %s ignored", mode);
+        return;
+    }
+    if (!fan_config_valid(&config))
+    {
+        ESP_LOGW(FAN_CONTROL_TAG, "Invalid fan %u setting ignored", fan);
+        return;
+    }
+
+    hal_mutex_take(pending_mutex, HAL_WAIT_FOREVER);
+    pending[fan - 1] = config;
+    pending_valid[fan - 1] = true;
+    hal_mutex_give(pending_mutex);
+}
 
 /**
  * @brief Initializes the fan control module.
- * 
- * Configures the GPIO pins as outputs and ensures both fans are initially turned off.
- * 
+ *
+ * Configures the GPIO pins as outputs, ensures both fans are initially turned off
+ * and starts their controllers with the saved settings.
+ *
  * @return true if initialization is successful, false otherwise.
  */
 bool init_fan_control()
 {
     ESP_LOGI(FAN_CONTROL_TAG, "Initializing fan control...");
 
-    pinMode(RELAY_FAN_1_PIN, OUTPUT);  // Set fan 1 relay pin as output
-    pinMode(RELAY_FAN_2_PIN, OUTPUT);  // Set fan 2 relay pin as output
+    fans_mutex = hal_mutex_create();
+    pending_mutex = hal_mutex_create();
+    if (fans_mutex == NULL || pending_mutex == NULL)
+    {
+        ESP_LOGE(FAN_CONTROL_TAG, "Failed to create mutex");
+        return false;
+    }
+
+    hal_gpio_mode(RELAY_FAN_1_PIN, HAL_OUTPUT);  // Set fan 1 relay pin as output
+    hal_gpio_mode(RELAY_FAN_2_PIN, HAL_OUTPUT);  // Set fan 2 relay pin as output
 
     // Ensure both fans are off initially
-    digitalWrite(RELAY_FAN_1_PIN, LOW);
-    digitalWrite(RELAY_FAN_2_PIN, LOW);
+    hal_gpio_write(RELAY_FAN_1_PIN, HAL_LOW);
+    hal_gpio_write(RELAY_FAN_2_PIN, HAL_LOW);
+
+    uint32_t now_ms = hal_millis();
+    for (uint8_t f = 0; f < FANS; f++)
+    {
+        FanControlConfig config = load_config(f);
+        fan_controller_init(&controllers[f], &config, now_ms);
+        changed[f] = true; // Settings published once connected
+        ESP_LOGI(FAN_CONTROL_TAG, "Fan %d: %s, setpoint %.2f", f + 1, mode_names[config.mode], config.setpoint);
+    }
 
+    uplink_subscribe(TOPIC_FAN_CONFIG, on_config);
     return true;
 }
 
 /**
  * @brief Controls the state of a specific fan.
- * 
+ *
  * Turns the fan on or off based on the given state.
- * 
+ *
  * @param state Desired fan state (true = ON, false = OFF).
  * @param pin GPIO pin connected to the relay controlling the fan.
  */
 void control_fan(bool state, int pin)
 {
-    if (state) {
-        digitalWrite(pin, HIGH);  // Turn fan ON
-        ESP_LOGI(FAN_CONTROL_TAG, "Fan ON (Pin %d)", pin);
-    } else {
-        digitalWrite(pin, LOW);   // Turn fan OFF
-        ESP_LOGI(FAN_CONTROL_TAG, "Fan OFF (Pin %d)", pin);
+    hal_gpio_write(pin, state ? HAL_HIGH : HAL_LOW);
+}
+
+/* Applies the settings received since the previous call */
+static void apply_pending(uint32_t now_ms)
+{
+    FanControlConfig configs[FANS];
+    bool valid[FANS];
+    hal_mutex_take(pending_mutex, HAL_WAIT_FOREVER);
+    for (uint8_t f = 0; f < FANS; f++)
+    {
+        configs[f] = pending[f];
+        valid[f] = pending_valid[f];
+        pending_valid[f] = false;
+    }
+    hal_mutex_give(pending_mutex);
+
+    for (uint8_t f = 0; f < FANS; f++)
+    {
+        if (!valid[f])
+        {
+            continue;
+        }
+        hal_mutex_take(fans_mutex, HAL_WAIT_FOREVER);
+        fan_controller_configure(&controllers[f], &configs[f], now_ms);
+        changed[f] = true;
+        hal_mutex_give(fans_mutex);
+        save_config(f, &configs[f]);
+        ESP_LOGI(FAN_CONTROL_TAG, "Fan %d: %s, setpoint %.2f", f + 1, mode_names[configs[f].mode],
+                 configs[f].setpoint);
     }
 }
 
 /**
  * @brief Handles fan control logic.
- * 
- * Alternates fan states at a defined interval.
+ *
+ * Runs both controllers on each new environment reading.
  */
 void handle_fan_control()
 {
-    state1 = false;  // Turn off fan 1
-    state2 = true;   // Turn on fan 2
-    
-    control_fan(state1, RELAY_FAN_1_PIN);
-    control_fan(state2, RELAY_FAN_2_PIN);
+    uint32_t now_ms = hal_millis();
+    apply_pending(now_ms);
 
-    ESP_LOGI(FAN_CONTROL_TAG, "Handling fan control...");
+    EnvReading reading;
+    if (!env_measurement_latest(&reading) || now_ms - reading.time_ms > FAN_STALE_MS)
+    {
+        if (!stale)
+        {
+            ESP_LOGW(FAN_CONTROL_TAG, "No recent environment reading, fans kept as they are");
+            stale = true;
+        }
+        return;
+    }
+    stale = false;
+    if (reading.time_ms == reading_ms)
+    {
+        return; // Already used
+    }
+    reading_ms = reading.time_ms;
+
+    const float readings[FANS] = {reading.temperature, reading.humidity};
+    for (uint8_t f = 0; f < FANS; f++)
+    {
+        hal_mutex_take(fans_mutex, HAL_WAIT_FOREVER);
+        bool was_on = controllers[f].on;
+        bool on = fan_controller_update(&controllers[f], readings[f], reading.time_ms);
+        values[f] = readings[f];
+        changed[f] |= on != was_on;
+        hal_mutex_give(fans_mutex);
+
+        if (on != was_on)
+        {
+            control_fan(on, pins[f]);
+            ESP_LOGI(FAN_CONTROL_TAG, "Fan %d %s at %.2f (Pin %d)", f + 1, on ? "ON" : "OFF", readings[f], pins[f]);
+        }
+    }
+}
+
+void publish_fan_control()
+{
+    if (!uplink_is_connected())
+    {
+        return;
+    }
+
+    for (uint8_t f = 0; f < FANS; f++)
+    {
+        hal_mutex_take(fans_mutex, HAL_WAIT_FOREVER);
+        bool publish = changed[f];
+        changed[f] = false;
+        FanController controller = controllers[f];
+        float value = values[f];
+        hal_mutex_give(fans_mutex);
+        if (!publish)
+        {
+            continue;
+        }
+
+        char topic[48], payload[128];
+        snprintf(topic, sizeof(topic), "%s/%d", TOPIC_FAN_STATE, f + 1);
+        snprintf(payload, sizeof(payload),
+                 "{\"on\":%s,\"mode\":\"%s\",\"setpoint\":%.2f,\"value\":%.2f,\"duty\":%.2f,\"switches\":%lu}",
+                 controller.on ? "true" : "false", mode_names[controller.config.mode], controller.config.setpoint,
+                 value, controller.duty, (unsigned long)controller.switches);
+        if (!uplink_publish(topic, payload))
+        {
+            ESP_LOGW(FAN_CONTROL_TAG, "Failed to publish the state of fan %d", f + 1);
+            hal_mutex_take(fans_mutex, HAL_WAIT_FOREVER);
+            changed[f] = true;
+            hal_mutex_give(fans_mutex);
+        }
+    }
 }
@@ -1,34 +1,74 @@
 #pragma once
 
-#include <Arduino.h>
-#include "esp_log.h"
+#include "hal/hal.hpp"
+#include "fan_controller.hpp"
 
 // GPIO pin definitions for relay-controlled fans
 #define RELAY_FAN_1_PIN 16  // Control pin for fan 1
 #define RELAY_FAN_2_PIN 17  // Control pin for fan 2
 
+#define FAN_MIN_ON_MS 120000  // Relay protection: at most 15 on/off cycles per hour
+#define FAN_MIN_OFF_MS 120000
+#define FAN_STALE_MS 10000    // Without a newer environment reading, the fans keep their state
+
+/* Settings until others are received over MQTT, fan 1 on temperature, fan 2 on humidity */
+#define FAN_1_SETPOINT 26.0f  // °C
+#define FAN_1_BAND 1.0f       // °C
+#define FAN_1_KP 1.0f         // Duty per °C
+#define FAN_1_TI_S 1800.0f
+#define FAN_2_SETPOINT 65.0f  // %RH
+#define FAN_2_BAND 6.0f       // %RH
+#define FAN_2_KP 0.2f         // Duty per %RH
+#define FAN_2_TI_S 600.0f
+#define FAN_PI_PERIOD_MS 300000 // Time-proportioning window of the PI, at least FAN_MIN_ON_MS + FAN_MIN_OFF_MS
+
+/* MQTT topics of the fan control */
+#define TOPIC_FAN_CONFIG "smarthome/environment/fan/config" // "<fan> hysteresis <setpoint> <band>" or "<fan> pi <setpoint> <kp> <ti_s>"
+#define TOPIC_FAN_STATE "smarthome/environment/fan"         // Followed by /<fan>, JSON state after every change
+
+/// Controlled fans.
+enum FanId : uint8_t
+{
+    FAN_TEMPERATURE, ///< Fan 1, driven by the temperature.
+    FAN_HUMIDITY,    ///< Fan 2, driven by the humidity.
+    FANS,
+};
+
 /**
  * @brief Initializes fan control module.
- * 
- * Sets up the GPIO pins for the relay modules controlling the fans.
- * Initially turns off both fans.
- * 
+ *
+ * Sets up the GPIO pins for the relay modules controlling the fans and
+ * turns both fans off, restores the settings saved in NVS and subscribes
+ * to TOPIC_FAN_CONFIG.
+ *
  * @return true if initialization is successful, false otherwise.
  */
 bool init_fan_control();
 
 /**
  * @brief Controls the state of a specific fan.
- * 
+ *
  * @param state Desired state of the fan (true = ON, false = OFF).
  * @param pin GPIO pin connected to the relay controlling the fan.
  */
 void control_fan(bool state, int pin);
 
 /**
- * @brief Handles fan control logic.
- * 
- * Alternates fan states at a defined interval.
+ * @brief Handles fan control logic, called every second.
+ *
+ * Applies settings received over MQTT, then runs the controller of each
+ * fan on the latest environment reading (see fan_controller.hpp). A relay
+ * is only written when its state changes. Readings older than
+ * FAN_STALE_MS are not used and the fans keep their state.
  */
 void handle_fan_control();
 
+/**
+ * @brief Publishes the state of the fans that changed, called from the MQTT task.
+ *
+ * One message per fan on TOPIC_FAN_STATE/<fan>, e.g.
+ * smarthome/environment/fan/1 with
+ * {"on":true,"mode":"pi","setpoint":26.00,"value":26.41,"duty":0.42,"switches":12}.
+ * A change waits while the broker is unreachable.
+ */
+void publish_fan_control();
@@ -0,0 +1,111 @@
+#include <math.h>
+#include <string.h>
+#include "fan_controller.hpp"
+
+static float clamp_unit(float value)
+{
+    return value < 0 ? 0 : value > 1 ? 1 : value;
+}
+
+bool fan_config_valid(const FanControlConfig *config)
+{
+    if (!isfinite(config->setpoint))
+    {
+        return false;
+    }
+    switch (config->mode)
+    {
+    case FAN_MODE_HYSTERESIS:
+        return config->band >= 0 && isfinite(config->band);
+    case FAN_MODE_PI:
+        return config->kp > 0 && isfinite(config->kp) && config->ti_s > 0 && isfinite(config->ti_s) &&
+               config->period_ms >= config->min_on_ms + config->min_off_ms && config->period_ms > 0;
+    default:
+        return false;
+    }
+}
+
+/* Starts a new PI window at the next update */
+static void restart_window(FanController *controller, uint32_t now_ms)
+{
+    controller->window_ms = now_ms - controller->config.period_ms;
+    controller->pulse_ms = 0;
+}
+
+void fan_controller_init(FanController *controller, const FanControlConfig *config, uint32_t now_ms)
+{
+    memset(controller, 0, sizeof(*controller));
+    controller->config = *config;
+    controller->changed_ms = now_ms - config->min_off_ms; // Free to start
+    controller->updated_ms = now_ms;
+    restart_window(controller, now_ms);
+}
+
+void fan_controller_configure(FanController *controller, const FanControlConfig *config, uint32_t now_ms)
+{
+    bool restart = config->mode != controller->config.mode || config->period_ms != controller->config.period_ms;
+    controller->config = *config;
+    if (restart)
+    {
+        // The integral takes over the current state, so the fan does not toggle on the change
+        controller->integral = controller->on ? 1 : 0;
+        restart_window(controller, now_ms);
+    }
+}
+
+/* Relay state asked for by the PI, one pulse per window */
+static bool update_pi(FanController *controller, float value, uint32_t now_ms, uint32_t elapsed_ms)
+{
+    const FanControlConfig &config = controller->config;
+    float proportional = config.kp * (value - config.setpoint);
+    float step = proportional * elapsed_ms / (config.ti_s * 1000);
+    float output = proportional + controller->integral;
+    if (!(output >= 1 && step > 0) && !(output <= 0 && step < 0)) // No windup while saturated
+    {
+        controller->integral = clamp_unit(controller->integral + step);
+    }
+    controller->duty = clamp_unit(proportional + controller->integral);
+
+    if (now_ms - controller->window_ms >= config.period_ms)
+    {
+        controller->window_ms = now_ms;
+        controller->pulse_ms = (uint32_t)(controller->duty * config.period_ms);
+        if (controller->pulse_ms < config.min_on_ms)
+        {
+            controller->pulse_ms = 0;
+        }
+        else if (config.period_ms - controller->pulse_ms < config.min_off_ms)
+        {
+            controller->pulse_ms = config.period_ms;
+        }
+    }
+    return now_ms - controller->window_ms < controller->pulse_ms;
+}
+
+bool fan_controller_update(FanController *controller, float value, uint32_t now_ms)
+{
+    const FanControlConfig &config = controller->config;
+    uint32_t elapsed_ms = now_ms - controller->updated_ms;
+    controller->updated_ms = now_ms;
+
+    bool wanted;
+    if (config.mode == FAN_MODE_PI)
+    {
+        wanted = update_pi(controller, value, now_ms, elapsed_ms);
+    }
+    else
+    {
+        float half = config.band / 2;
+        wanted = controller->on ? value > config.setpoint - half : value >= config.setpoint + half;
+        controller->duty = wanted ? 1 : 0;
+    }
+
+    uint32_t held_ms = controller->on ? config.min_on_ms : config.min_off_ms;
+    if (wanted != controller->on && now_ms - controller->changed_ms >= held_ms)
+    {
+        controller->on = wanted;
+        controller->changed_ms = now_ms;
+        controller->switches++;
+    }
+    return controller->on;
+}
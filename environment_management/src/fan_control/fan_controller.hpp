@@ -0,0 +1,94 @@
+#pragma once
+
+/*
+ * On/off control of one relay-driven fan from a measured value,
+ * independent of the hardware.
+ *
+ * The fan lowers the value it is given (temperature or humidity), so it
+ * runs above the setpoint. Two modes:
+ *  - hysteresis: on at setpoint + band / 2, off at setpoint - band / 2;
+ *  - PI: the PI output is a duty cycle, run as one on pulse at the start of
+ *    each FanControlConfig::period_ms window (time-proportioning). Pulses
+ *    shorter than the minimum on time are dropped and gaps shorter than
+ *    the minimum off time are filled, the integral clamps to 0..1.
+ * Whatever the mode, the relay never changes before it has been on for
+ * min_on_ms or off for min_off_ms, which bounds its switching frequency.
+ *
+ * Times are millisecond counters that may wrap (millis()).
+ */
+
+#include <stdint.h>
+
+/// Control law.
+enum FanMode : uint8_t
+{
+    FAN_MODE_HYSTERESIS,
+    FAN_MODE_PI,
+};
+
+/// Settings of a controller, the setpoints updatable at run time.
+struct FanControlConfig
+{
+    FanMode mode;
+    float setpoint;      ///< Value above which the fan runs.
+    float band;          ///< Hysteresis width, hysteresis mode.
+    float kp;            ///< Duty per unit above the setpoint, PI mode.
+    float ti_s;          ///< Integral time, PI mode.
+    uint32_t period_ms;  ///< Time-proportioning window, PI mode.
+    uint32_t min_on_ms;  ///< Shortest run of the fan.
+    uint32_t min_off_ms; ///< Shortest stop of the fan.
+};
+
+/// State of one controller.
+struct FanController
+{
+    FanControlConfig config;
+    bool on;             ///< Relay state asked for.
+    uint32_t changed_ms; ///< Last change of the relay.
+    uint32_t updated_ms; ///< Previous update.
+    float integral;      ///< Integral term of the PI, as a duty.
+    float duty;          ///< PI output of the latest update.
+    uint32_t window_ms;  ///< Start of the PI window under way.
+    uint32_t pulse_ms;   ///< On time of the PI window under way.
+    uint32_t switches;   ///< Relay changes since init.
+};
+
+/**
+ * @brief Checks settings, e.g. received over MQTT.
+ *
+ * @return true if the band, gains and times are usable, false otherwise.
+ */
+bool fan_config_valid(const FanControlConfig *config);
+
+/**
+ * @brief Starts a controller with the fan off.
+ *
+ * The fan may start at the first update.
+ *
+ * @param controller (Output) Controller.
+ * @param config Settings.
+ * @param now_ms Current time.
+ */
+void fan_controller_init(FanController *controller, const FanControlConfig *config, uint32_t now_ms);
+
+/**
+ * @brief Changes the settings of a running controller.
+ *
+ * The relay keeps its state and its minimum times; a change of mode
+ * restarts the PI from the current state of the fan.
+ *
+ * @param controller Controller.
+ * @param config Settings.
+ * @param now_ms Current time.
+ */
+void fan_controller_configure(FanController *controller, const FanControlConfig *config, uint32_t now_ms);
+
+/**
+ * @brief Runs the control law on a new measurement.
+ *
+ * @param controller Controller.
+ * @param value Measured value, in the unit of the setpoint.
+ * @param now_ms Time of the measurement.
+ * @return the relay state, true for on.
+ */
+bool fan_controller_update(FanController *controller, float value, uint32_t now_ms);
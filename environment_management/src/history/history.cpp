@@ -0,0 +1,226 @@
+#include <math.h>
+#include <stdio.h>
+#include <string.h>
+#include "history.hpp"
+#include "../uplink/uplink.hpp"
+
+#define HISTORY_TAG "app_history"
+
+/* Resolution of each channel as a power of two, close to the resolution of the sensor */
+static const int8_t resolutions_log2[TELEMETRY_CHANNELS] = {
+    -7, // Temperature, 1/128 °C
+    -6, // Humidity, 1/64 %RH
+    -6, // Pressure, 1/64 hPa
+    0,  // Production power, 1 mW
+    0,  // Consumption power, 1 mW
+};
+
+/// Samples of a channel in the period under way.
+struct HistoryPeriod
+{
+    double sum;
+    uint32_t count;
+};
+
+static HistoryRing ring;
+static HistoryBlock blocks[TELEMETRY_CHANNELS]; // Blocks filling in RAM
+static SeriesEncoder encoders[TELEMETRY_CHANNELS];
+static hal_mutex_t ring_mutex = NULL; // Recorded in the history task, queried in the MQTT task
+static bool ring_ready = false;
+
+static HistoryPeriod periods[TELEMETRY_CHANNELS];
+static hal_mutex_t periods_mutex = NULL; // Sensor tasks add samples concurrently
+static uint64_t period_ms = 0;                 // Start of the period under way, 0 before the clock is set
+
+static HistoryQuery query; // Used by the MQTT task only
+static float steps[HISTORY_RESULT_STEPS];
+static char payload[HISTORY_RESULT_STEPS * 12 + 96];
+
+static volatile bool query_pending = false; // Set by the MQTT callback
+static uint8_t query_channel = 0;
+static uint32_t query_from = 0, query_to = 0, query_step = 0;
+static bool query_active = false;
+static size_t result_count = 0;     // Steps waiting to be sent, kept while publishing fails
+static uint64_t result_from_ms = 0; // Start of the first step waiting
+
+static void on_query(const char *payload)
+{
+    char name[24];
+    unsigned long from, to, step;
+    if (sscanf(payload, "%23s %lu %lu %lu", name, &from, &to, &step) != 4 || from > to || step == 0 ||
+        (to - from) / step >= HISTORY_QUERY_MAX_STEPS)
+    {
+        ESP_LOGW(HISTORY_TAG, "Malformed history query ignored");
+        return;
+    }
+    for (uint8_t c = 0; c < TELEMETRY_CHANNELS; c++)
+    {
+        if (strcmp(name, telemetry_channel_name((TelemetryChannel)c)) == 0)
+        {
+            query_channel = c;
+            query_from = from;
+            query_to = to;
+            query_step = step;
+            query_pending = true;
+            return;
+        }
+    }
+    ESP_LOGW(HISTORY_TAG, "History query for unknown channel %s ignored", name);
+}
+
+/* Compresses a history sample, writing the block of the channel to flash when full */
+static void record(uint8_t channel, uint64_t time_ms, float value)
+{
+    hal_mutex_take(ring_mutex, HAL_WAIT_FOREVER);
+    bool ok = true;
+    if (!history_block_add(&blocks[channel], &encoders[channel], time_ms, value))
+    {
+        ok = history_ring_append(&ring, &blocks[channel]);
+        history_block_start(&blocks[channel], &encoders[channel], channel);
+        history_block_add(&blocks[channel], &encoders[channel], time_ms, value);
+    }
+    hal_mutex_give(ring_mutex);
+    if (!ok)
+    {
+        ESP_LOGE(HISTORY_TAG, "Failed to write a %s history block", telemetry_channel_name((TelemetryChannel)channel));
+    }
+}
+
+bool init_history()
+{
+    ring_mutex = hal_mutex_create();
+    periods_mutex = hal_mutex_create();
+    if (ring_mutex == NULL || periods_mutex == NULL)
+    {
+        ESP_LOGE(HISTORY_TAG, "Failed to create mutex");
+        return false;
+    }
+
+    hal_partition_t partition = hal_partition_find(HISTORY_PARTITION);
+    if (partition == NULL || !history_ring_open(&ring, partition))
+    {
+        ESP_LOGE(HISTORY_TAG, "Failed to open the history partition");
+        return false;
+    }
+    for (uint8_t c = 0; c < TELEMETRY_CHANNELS; c++)
+    {
+        history_block_start(&blocks[c], &encoders[c], c);
+    }
+    ring_ready = true;
+
+    hal_clock_sync(HISTORY_NTP_SERVER); // History samples need Unix times
+    uplink_subscribe(TOPIC_HISTORY_QUERY, on_query);
+    ESP_LOGI(HISTORY_TAG, "History opened at block %lu of %lu", (unsigned long)ring.head,
+             (unsigned long)(ring.sectors * HISTORY_BLOCKS_PER_SECTOR));
+    return true;
+}
+
+void history_add(TelemetryChannel channel, float value)
+{
+    hal_mutex_take(periods_mutex, HAL_WAIT_FOREVER);
+    periods[channel].sum += value;
+    periods[channel].count++;
+    hal_mutex_give(periods_mutex);
+}
+
+void handle_history()
+{
+    if (!ring_ready)
+    {
+        return;
+    }
+
+    uint64_t now_ms = hal_unix_ms();
+    uint64_t current_ms = now_ms / 1000 >= HISTORY_CLOCK_VALID ? now_ms - now_ms % HISTORY_PERIOD_MS : 0;
+    if (current_ms == period_ms)
+    {
+        return;
+    }
+
+    HistoryPeriod closed[TELEMETRY_CHANNELS];
+    hal_mutex_take(periods_mutex, HAL_WAIT_FOREVER);
+    memcpy(closed, periods, sizeof(closed));
+    memset(periods, 0, sizeof(periods));
+    hal_mutex_give(periods_mutex);
+
+    if (period_ms != 0 && current_ms > period_ms) // Periods before the clock was set, or across a clock jump back, are dropped
+    {
+        for (uint8_t c = 0; c < TELEMETRY_CHANNELS; c++)
+        {
+            if (closed[c].count > 0)
+            {
+                record(c, period_ms, series_quantize((float)(closed[c].sum / closed[c].count), resolutions_log2[c]));
+            }
+        }
+    }
+    period_ms = current_ms;
+}
+
+/* Sends one message of steps, or the empty end marker */
+static void serve_query()
+{
+    if (result_count == 0 && query.done)
+    {
+        if (uplink_publish(TOPIC_HISTORY_RESULT, ""))
+        {
+            query_active = false;
+            ESP_LOGI(HISTORY_TAG, "History query answered, %lu blocks read", (unsigned long)query.blocks_read);
+        }
+        return;
+    }
+
+    if (result_count == 0)
+    {
+        result_from_ms = query.bucket_ms;
+        hal_mutex_take(ring_mutex, HAL_WAIT_FOREVER);
+        result_count = history_query_next(&ring, &query, &blocks[query.channel], steps, HISTORY_RESULT_STEPS,
+                                          HISTORY_QUERY_SLOTS);
+        hal_mutex_give(ring_mutex);
+        if (result_count == 0)
+        {
+            return; // Out of slots before the first step, continued on the next call
+        }
+    }
+
+    size_t length = snprintf(payload, sizeof(payload), "{\"channel\":\"%s\",\"from\":%lu,\"step\":%lu,\"values\":[",
+                             telemetry_channel_name((TelemetryChannel)query.channel),
+                             (unsigned long)(result_from_ms / 1000), (unsigned long)query_step);
+    for (size_t i = 0; i < result_count; i++)
+    {
+        const char *separator = i > 0 ? "," : "";
+        if (isnan(steps[i]))
+        {
+            length += snprintf(payload + length, sizeof(payload) - length, "%snull", separator);
+        }
+        else
+        {
+            length += snprintf(payload + length, sizeof(payload) - length, "%s%.2f", separator, steps[i]);
+        }
+    }
+    snprintf(payload + length, sizeof(payload) - length, "]}");
+    if (uplink_publish(TOPIC_HISTORY_RESULT, payload))
+    {
+        result_count = 0;
+    }
+}
+
+void publish_history()
+{
+    if (!ring_ready || !uplink_is_connected())
+    {
+        return;
+    }
+
+    if (query_pending)
+    {
+        query_pending = false;
+        history_query_start(&ring, &query, query_channel, (uint64_t)query_from * 1000,
+                            (uint64_t)query_to * 1000 + 999, (uint64_t)query_step * 1000);
+        result_count = 0;
+        query_active = true;
+    }
+    if (query_active)
+    {
+        serve_query();
+    }
+}
@@ -0,0 +1,53 @@
+#pragma once
+
+#include "hal/hal.hpp"
+#include "history_ring.hpp"
+#include "../telemetry/telemetry.hpp"
+
+/* MQTT topics of the history */
+#define TOPIC_HISTORY_QUERY "smarthome/environment/history/query"   // "<channel> <from> <to> <step>", Unix times and step in seconds
+#define TOPIC_HISTORY_RESULT "smarthome/environment/history/result" // JSON steps answering a query, an empty payload ends it
+
+#define HISTORY_PARTITION "history" // Data partition of the history (see partitions.csv)
+#define HISTORY_NTP_SERVER "pool.ntp.org"
+#define HISTORY_CLOCK_VALID 1700000000ULL // Earlier Unix times mean the clock is not set yet
+#define HISTORY_PERIOD_MS 10000           // Samples of a channel averaged into one history sample
+#define HISTORY_QUERY_MAX_STEPS 8640      // Longest answer, a day of 10 s steps
+#define HISTORY_RESULT_STEPS 96           // Steps per result message, below NETWORK_MQTT_BUFFER_SIZE
+#define HISTORY_QUERY_SLOTS 1024          // Slots examined per call of publish_history()
+
+/**
+ * @brief Opens the history in flash, starts the clock synchronization and subscribes to queries.
+ *
+ * @return true if initialization was successful, false otherwise.
+ */
+bool init_history();
+
+/**
+ * @brief Adds a sample of a channel to the history period under way, from any task.
+ *
+ * @param channel Channel.
+ * @param value Sample.
+ */
+void history_add(TelemetryChannel channel, float value);
+
+/**
+ * @brief Records the averages of the last period, called every second.
+ *
+ * Every HISTORY_PERIOD_MS, the mean of the samples of each channel is
+ * rounded to the resolution of the channel and compressed into its block
+ * in RAM; a full block is written to flash. Nothing is recorded until
+ * the clock is set: history samples are stamped with Unix times.
+ */
+void handle_history();
+
+/**
+ * @brief Answers queries, called from the MQTT task.
+ *
+ * A query is answered in steps of at most HISTORY_RESULT_STEPS, e.g.
+ * {"channel":"temperature","from":1718000000,"step":60,"values":[21.52,21.55,null]}
+ * where from is the start of the first step and null a step without
+ * samples, then an empty payload. Nothing is sent while the broker is
+ * unreachable.
+ */
+void publish_history();
@@ -0,0 +1,278 @@
+#include <math.h>
+#include <string.h>
+#include "history_ring.hpp"
+
+#define HISTORY_ERASED 0xFFFFFFFFU
+
+/* CRC-16/CCITT-FALSE, continued from a previous value */
+static uint16_t crc16(uint16_t crc, const uint8_t *data, size_t length)
+{
+    for (size_t i = 0; i < length; i++)
+    {
+        crc ^= (uint16_t)data[i] << 8;
+        for (int bit = 0; bit < 8; bit++)
+        {
+            crc = crc & 0x8000 ? (crc << 1) ^ 0x1021 : crc << 1;
+        }
+    }
+    return crc;
+}
+
+static uint16_t block_crc(const HistoryBlock *block)
+{
+    uint16_t crc = crc16(0xFFFF, (const uint8_t *)block, offsetof(HistoryBlock, crc));
+    return crc16(crc, block->data, sizeof(block->data));
+}
+
+static bool is_valid(const HistoryBlock *block)
+{
+    return block->sequence != HISTORY_ERASED && block->crc == block_crc(block);
+}
+
+static bool is_erased(const HistoryBlock *block)
+{
+    const uint8_t *bytes = (const uint8_t *)block;
+    for (size_t i = 0; i < sizeof(HistoryBlock); i++)
+    {
+        if (bytes[i] != 0xFF)
+        {
+            return false;
+        }
+    }
+    return true;
+}
+
+static uint32_t slot_count(const HistoryRing *ring)
+{
+    return ring->sectors * HISTORY_BLOCKS_PER_SECTOR;
+}
+
+static bool read_block(const HistoryRing *ring, uint32_t slot, HistoryBlock *block, size_t length)
+{
+    return hal_partition_read(ring->partition, (size_t)slot * HISTORY_BLOCK_SIZE, block, length);
+}
+
+bool history_ring_open(HistoryRing *ring, hal_partition_t partition)
+{
+    memset(ring, 0, sizeof(*ring));
+    ring->partition = partition;
+    ring->sectors = hal_partition_size(partition) / HAL_FLASH_SECTOR_SIZE;
+    if (ring->sectors < 2)
+    {
+        return false;
+    }
+
+    bool empty = true;
+    uint32_t newest = 0, head = 0;
+    HistoryBlock block;
+    for (uint32_t slot = 0; slot < slot_count(ring); slot++)
+    {
+        if (!read_block(ring, slot, &block, sizeof(block)))
+        {
+            return false;
+        }
+        if (is_valid(&block) && (empty || block.sequence > newest))
+        {
+            newest = block.sequence;
+            head = slot + 1;
+            empty = false;
+        }
+    }
+    if (empty)
+    {
+        return true;
+    }
+
+    // Slots after the newest block in its sector may hold torn writes, skip to the first erased one
+    for (; head % HISTORY_BLOCKS_PER_SECTOR != 0; head++)
+    {
+        if (!read_block(ring, head, &block, sizeof(block)))
+        {
+            return false;
+        }
+        if (is_erased(&block))
+        {
+            break;
+        }
+    }
+    ring->head = head % slot_count(ring);
+    ring->next_sequence = newest + 1;
+    return true;
+}
+
+bool history_ring_append(HistoryRing *ring, HistoryBlock *block)
+{
+    if (ring->head % HISTORY_BLOCKS_PER_SECTOR == 0 &&
+        !hal_partition_erase(ring->partition, (ring->head / HISTORY_BLOCKS_PER_SECTOR) * HAL_FLASH_SECTOR_SIZE,
+                             HAL_FLASH_SECTOR_SIZE))
+    {
+        return false;
+    }
+
+    block->sequence = ring->next_sequence;
+    memset(block->reserved, 0xFF, sizeof(block->reserved));
+    block->crc = block_crc(block);
+    if (!hal_partition_write(ring->partition, (size_t)ring->head * HISTORY_BLOCK_SIZE, block, sizeof(*block)))
+    {
+        return false;
+    }
+    ring->next_sequence++;
+    ring->head = (ring->head + 1) % slot_count(ring);
+    return true;
+}
+
+void history_block_start(HistoryBlock *block, SeriesEncoder *encoder, uint8_t channel)
+{
+    memset(block, 0xFF, sizeof(*block));
+    block->channel = channel;
+    block->count = 0;
+    block->bits = 0;
+    series_encoder_init(encoder, block->data, sizeof(block->data));
+}
+
+bool history_block_add(HistoryBlock *block, SeriesEncoder *encoder, uint64_t time_ms, float value)
+{
+    if (!series_encoder_add(encoder, time_ms, value))
+    {
+        return false;
+    }
+    block->first_ms = encoder->first_ms;
+    block->last_ms = encoder->last_ms;
+    block->count = encoder->count;
+    block->bits = encoder->bits;
+    return true;
+}
+
+void history_query_start(const HistoryRing *ring, HistoryQuery *query, uint8_t channel, uint64_t from_ms,
+                         uint64_t to_ms, uint64_t step_ms)
+{
+    memset(query, 0, sizeof(*query));
+    query->channel = channel;
+    query->to_ms = to_ms;
+    query->step_ms = step_ms;
+    query->bucket_ms = from_ms;
+
+    // Oldest blocks: the head itself at the start of a sector, the next sector otherwise
+    uint32_t sector = ring->head / HISTORY_BLOCKS_PER_SECTOR;
+    if (ring->head % HISTORY_BLOCKS_PER_SECTOR != 0)
+    {
+        sector = (sector + 1) % ring->sectors;
+    }
+    query->slot = sector * HISTORY_BLOCKS_PER_SECTOR;
+}
+
+/* Reads the next block of the query from flash, false once no slot is left to examine */
+static bool next_flash_block(const HistoryRing *ring, HistoryQuery *query, uint32_t *slots, uint32_t max_slots)
+{
+    while (*slots < max_slots)
+    {
+        if ((query->slot == ring->head && query->scanned > 0) || query->scanned >= slot_count(ring))
+        {
+            query->flash_done = true;
+            return false;
+        }
+        HistoryBlock &block = query->block;
+        uint32_t slot = query->slot;
+        query->slot = (query->slot + 1) % slot_count(ring);
+        query->scanned++;
+        (*slots)++;
+
+        // The header first, most blocks are of another channel or out of the range
+        if (!read_block(ring, slot, &block, HISTORY_BLOCK_HEADER) || block.sequence == HISTORY_ERASED ||
+            block.channel != query->channel || block.last_ms < query->bucket_ms)
+        {
+            continue;
+        }
+        if (block.first_ms > query->to_ms)
+        {
+            query->flash_done = true; // Later blocks of the channel are newer still
+            return false;
+        }
+        if (!read_block(ring, slot, &block, sizeof(block)) || !is_valid(&block))
+        {
+            continue;
+        }
+        series_decoder_init(&query->decoder, block.data, block.bits, block.count, block.first_ms);
+        query->blocks_read++;
+        return true;
+    }
+    return false;
+}
+
+/* Closes the step being averaged */
+static float close_step(HistoryQuery *query)
+{
+    float mean = query->count > 0 ? (float)(query->sum / query->count) : NAN;
+    query->sum = 0;
+    query->count = 0;
+    query->bucket_ms += query->step_ms;
+    query->done = query->bucket_ms > query->to_ms;
+    return mean;
+}
+
+size_t history_query_next(const HistoryRing *ring, HistoryQuery *query, const HistoryBlock *open, float *values,
+                          size_t max, uint32_t max_slots)
+{
+    size_t steps = 0;
+    uint32_t slots = 0;
+    while (!query->done && steps < max)
+    {
+        uint64_t time_ms;
+        float value;
+        if (query->pending)
+        {
+            time_ms = query->pending_ms;
+            value = query->pending_value;
+            query->pending = false;
+        }
+        else if (query->in_block)
+        {
+            query->in_block = series_decoder_next(&query->decoder, &time_ms, &value);
+            if (!query->in_block)
+            {
+                continue;
+            }
+        }
+        else if (!query->flash_done)
+        {
+            query->in_block = next_flash_block(ring, query, &slots, max_slots);
+            if (!query->in_block && !query->flash_done)
+            {
+                break; // Out of slots for this call
+            }
+            continue;
+        }
+        else if (!query->open_done)
+        {
+            query->open_done = true;
+            if (open != NULL && open->count > 0 && open->last_ms >= query->bucket_ms)
+            {
+                query->block = *open;
+                series_decoder_init(&query->decoder, query->block.data, open->bits, open->count, open->first_ms);
+                query->in_block = true;
+            }
+            continue;
+        }
+        else
+        {
+            values[steps++] = close_step(query); // No samples left, the remaining steps are empty
+            continue;
+        }
+
+        if (time_ms < query->bucket_ms)
+        {
+            continue;
+        }
+        if (time_ms - query->bucket_ms >= query->step_ms)
+        {
+            values[steps++] = close_step(query);
+            query->pending = true; // Belongs to a later step
+            query->pending_ms = time_ms;
+            query->pending_value = value;
+            continue;
+        }
+        query->sum += value;
+        query->count++;
+    }
+    return steps;
+}
@@ -0,0 +1,145 @@
+#pragma once
+
+/*
+ * Sensor history in a raw flash partition.
+ *
+ * Every channel fills a 256-byte block in RAM with a Gorilla-compressed
+ * series (see series_codec.hpp); full blocks are appended to the
+ * partition, 16 per sector, and the sectors are reused in turn like the
+ * access log: a sector is erased only when the history wraps around to
+ * it, dropping its blocks, the oldest ones. Blocks of every channel are
+ * interleaved in the order they filled, so the blocks of a channel are in
+ * time order. A block torn by a reset fails its CRC and is skipped; the
+ * blocks still in RAM are lost.
+ *
+ * Queries read the blocks of a channel overlapping a time range, then the
+ * block in RAM, and return the mean of every step of the range.
+ */
+
+#include <stddef.h>
+#include <stdint.h>
+#include "hal/hal.hpp"
+#include "series_codec.hpp"
+
+#define HISTORY_BLOCK_SIZE 256
+#define HISTORY_BLOCK_HEADER 32
+#define HISTORY_BLOCKS_PER_SECTOR (HAL_FLASH_SECTOR_SIZE / HISTORY_BLOCK_SIZE) // 16
+
+/// Stored block, one series of one channel.
+struct HistoryBlock
+{
+    uint64_t first_ms; ///< Unix time of the first sample in milliseconds.
+    uint64_t last_ms;  ///< Unix time of the last sample in milliseconds.
+    uint32_t sequence; ///< Position in the history, 0xFFFFFFFF in erased flash.
+    uint16_t count;    ///< Samples.
+    uint16_t bits;     ///< Bits of the series.
+    uint8_t channel;
+    uint8_t reserved[5];
+    uint16_t crc; ///< CRC-16 of the header above and the data.
+    uint8_t data[HISTORY_BLOCK_SIZE - HISTORY_BLOCK_HEADER];
+};
+
+static_assert(sizeof(HistoryBlock) == HISTORY_BLOCK_SIZE, "HistoryBlock is stored as is");
+
+/// Position of an opened history.
+struct HistoryRing
+{
+    hal_partition_t partition;
+    uint16_t sectors;
+    uint32_t head;          ///< Slot of the next block.
+    uint32_t next_sequence; ///< Sequence of the next block.
+};
+
+/// Downsampling query being answered, resumed call after call.
+struct HistoryQuery
+{
+    uint8_t channel;
+    uint64_t to_ms;
+    uint64_t step_ms;
+    uint64_t bucket_ms; ///< Start of the step being averaged.
+    double sum;
+    uint32_t count;
+    uint32_t slot;       ///< Next slot to read.
+    uint32_t scanned;    ///< Slots read.
+    bool flash_done;     ///< Every slot up to the head was read.
+    bool open_done;      ///< The block in RAM was read.
+    bool in_block;       ///< block is being decoded.
+    bool pending;        ///< A sample read is waiting for the next steps.
+    bool done;
+    uint64_t pending_ms;
+    float pending_value;
+    uint32_t blocks_read; ///< Blocks decoded, for the statistics.
+    HistoryBlock block;
+    SeriesDecoder decoder;
+};
+
+/**
+ * @brief Scans the partition and recovers the position of the history.
+ *
+ * @param ring History to open.
+ * @param partition Data partition of at least two sectors.
+ * @return true if the partition could be read, false otherwise.
+ */
+bool history_ring_open(HistoryRing *ring, hal_partition_t partition);
+
+/**
+ * @brief Appends a full block.
+ *
+ * Fills in the sequence and CRC, and erases the next sector first when
+ * the current one is full.
+ *
+ * @param ring Opened history.
+ * @param block Block to append, updated with the stored fields.
+ * @return true if the block was written, false on a flash error.
+ */
+bool history_ring_append(HistoryRing *ring, HistoryBlock *block);
+
+/**
+ * @brief Starts an empty block in RAM.
+ *
+ * @param block Block.
+ * @param encoder (Output) Encoder writing the block.
+ * @param channel Channel of the block.
+ */
+void history_block_start(HistoryBlock *block, SeriesEncoder *encoder, uint8_t channel);
+
+/**
+ * @brief Adds a sample to a block in RAM.
+ *
+ * @param block Block started with history_block_start().
+ * @param encoder Encoder of the block.
+ * @param time_ms Unix time of the sample in milliseconds.
+ * @param value Value.
+ * @return true if the sample was added, false if the block is full and must be appended first.
+ */
+bool history_block_add(HistoryBlock *block, SeriesEncoder *encoder, uint64_t time_ms, float value);
+
+/**
+ * @brief Starts a query.
+ *
+ * @param ring Opened history.
+ * @param query (Output) Query.
+ * @param channel Channel.
+ * @param from_ms Start of the range, Unix time in milliseconds.
+ * @param to_ms End of the range, included.
+ * @param step_ms Length of a step, not 0.
+ */
+void history_query_start(const HistoryRing *ring, HistoryQuery *query, uint8_t channel, uint64_t from_ms,
+                         uint64_t to_ms, uint64_t step_ms);
+
+/**
+ * @brief Answers the next steps of a query.
+ *
+ * Examines at most max_slots slots of the partition, so a long query can
+ * be spread over several calls. Blocks appended meanwhile are read too.
+ *
+ * @param ring Opened history.
+ * @param query Query started with history_query_start().
+ * @param open Block of the channel in RAM, NULL if none.
+ * @param values (Output) Mean of every step, in order, NAN for a step without samples.
+ * @param max Maximum number of steps.
+ * @param max_slots Maximum number of slots examined.
+ * @return Number of steps answered; query->done is set after the last step of the range.
+ */
+size_t history_query_next(const HistoryRing *ring, HistoryQuery *query, const HistoryBlock *open, float *values,
+                          size_t max, uint32_t max_slots);
@@ -0,0 +1,280 @@
+#include <math.h>
+#include <string.h>
+#include "series_codec.hpp"
+
+#define SERIES_NO_WINDOW 0xFF // No XOR window stored yet
+
+/* Ranges of a delta of delta: prefix, prefix length and bits of the signed value */
+struct DeltaBucket
+{
+    uint8_t prefix;
+    uint8_t prefix_bits;
+    uint8_t value_bits;
+};
+
+static const DeltaBucket buckets[] = {
+    {0x2, 2, 7},  // 10: -64 to 63 ms
+    {0x6, 3, 9},  // 110: -256 to 255 ms
+    {0xE, 4, 12}, // 1110: -2048 to 2047 ms
+    {0xF, 4, 32}, // 1111: anything in 32 bits
+};
+
+static uint32_t float_bits(float value)
+{
+    uint32_t bits;
+    memcpy(&bits, &value, sizeof(bits));
+    return bits;
+}
+
+static float bits_float(uint32_t bits)
+{
+    float value;
+    memcpy(&value, &bits, sizeof(value));
+    return value;
+}
+
+/* Writes the low n bits of a value, false if they do not fit */
+static bool put_bits(SeriesEncoder *encoder, uint64_t value, uint8_t n)
+{
+    if (encoder->bits + n > encoder->capacity_bits)
+    {
+        return false;
+    }
+    uint16_t position = encoder->bits;
+    while (n > 0)
+    {
+        uint8_t offset = position % 8;
+        uint8_t take = 8 - offset < n ? 8 - offset : n;
+        uint8_t shift = 8 - offset - take;
+        uint8_t mask = (uint8_t)(((1u << take) - 1) << shift);
+        uint8_t chunk = (uint8_t)((value >> (n - take)) << shift) & mask;
+        uint8_t *byte = &encoder->data[position / 8];
+        *byte = (*byte & ~mask) | chunk;
+        position += take;
+        n -= take;
+    }
+    encoder->bits = position;
+    return true;
+}
+
+/* Reads n bits, false past the end of the series */
+static bool get_bits(SeriesDecoder *decoder, uint8_t n, uint64_t *value)
+{
+    if (decoder->position + n > decoder->bits)
+    {
+        return false;
+    }
+    uint64_t result = 0;
+    uint16_t position = decoder->position;
+    while (n > 0)
+    {
+        uint8_t offset = position % 8;
+        uint8_t take = 8 - offset < n ? 8 - offset : n;
+        uint8_t chunk = (uint8_t)(decoder->data[position / 8] << offset) >> (8 - take);
+        result = result << take | chunk;
+        position += take;
+        n -= take;
+    }
+    decoder->position = position;
+    *value = result;
+    return true;
+}
+
+static bool put_delta(SeriesEncoder *encoder, int64_t dod)
+{
+    if (dod == 0)
+    {
+        return put_bits(encoder, 0, 1);
+    }
+    for (const DeltaBucket &bucket : buckets)
+    {
+        int64_t limit = (int64_t)1 << (bucket.value_bits - 1);
+        if (dod >= -limit && dod < limit)
+        {
+            uint64_t value = (uint64_t)dod & (((uint64_t)1 << bucket.value_bits) - 1);
+            return put_bits(encoder, bucket.prefix, bucket.prefix_bits) && put_bits(encoder, value, bucket.value_bits);
+        }
+    }
+    return false; // More than 24 days off the previous delta, starts another series
+}
+
+static bool put_value(SeriesEncoder *encoder, uint32_t value)
+{
+    uint32_t xored = value ^ encoder->value;
+    if (xored == 0)
+    {
+        return put_bits(encoder, 0, 1);
+    }
+    uint8_t leading = (uint8_t)__builtin_clz(xored);
+    uint8_t trailing = (uint8_t)__builtin_ctz(xored);
+    if (encoder->leading != SERIES_NO_WINDOW && leading >= encoder->leading && trailing >= encoder->trailing)
+    {
+        uint8_t length = 32 - encoder->leading - encoder->trailing;
+        return put_bits(encoder, 0x2, 2) && put_bits(encoder, xored >> encoder->trailing, length);
+    }
+    uint8_t length = 32 - leading - trailing;
+    encoder->leading = leading;
+    encoder->trailing = trailing;
+    return put_bits(encoder, 0x3, 2) && put_bits(encoder, leading, 5) && put_bits(encoder, length - 1, 5) &&
+           put_bits(encoder, xored >> trailing, length);
+}
+
+void series_encoder_init(SeriesEncoder *encoder, uint8_t *data, size_t capacity)
+{
+    memset(encoder, 0, sizeof(*encoder));
+    encoder->data = data;
+    encoder->capacity_bits = (uint16_t)(capacity * 8);
+    encoder->leading = SERIES_NO_WINDOW;
+}
+
+bool series_encoder_add(SeriesEncoder *encoder, uint64_t time_ms, float value)
+{
+    SeriesEncoder saved = *encoder; // Restored if the sample does not fit
+    uint32_t bits = float_bits(value);
+    bool stored;
+    if (encoder->count == 0)
+    {
+        encoder->first_ms = time_ms;
+        stored = put_bits(encoder, bits, 32);
+    }
+    else
+    {
+        int64_t delta = (int64_t)(time_ms - encoder->last_ms);
+        stored = time_ms >= encoder->last_ms && put_delta(encoder, delta - encoder->delta_ms) && put_value(encoder, bits);
+        encoder->delta_ms = delta;
+    }
+    if (!stored)
+    {
+        *encoder = saved;
+        return false;
+    }
+    encoder->last_ms = time_ms;
+    encoder->value = bits;
+    encoder->count++;
+    return true;
+}
+
+void series_decoder_init(SeriesDecoder *decoder, const uint8_t *data, uint16_t bits, uint16_t count, uint64_t first_ms)
+{
+    memset(decoder, 0, sizeof(*decoder));
+    decoder->data = data;
+    decoder->bits = bits;
+    decoder->remaining = count;
+    decoder->first = true;
+    decoder->time_ms = first_ms;
+    decoder->leading = SERIES_NO_WINDOW;
+}
+
+static bool get_delta(SeriesDecoder *decoder, int64_t *dod)
+{
+    uint64_t bit;
+    if (!get_bits(decoder, 1, &bit))
+    {
+        return false;
+    }
+    if (bit == 0)
+    {
+        *dod = 0;
+        return true;
+    }
+    // Count the ones of the prefix, up to the longest one
+    uint8_t ones = 1;
+    for (; ones < 4; ones++)
+    {
+        if (!get_bits(decoder, 1, &bit))
+        {
+            return false;
+        }
+        if (bit == 0)
+        {
+            break;
+        }
+    }
+    const DeltaBucket &bucket = buckets[ones - 1];
+    uint64_t value;
+    if (!get_bits(decoder, bucket.value_bits, &value))
+    {
+        return false;
+    }
+    uint64_t sign = (uint64_t)1 << (bucket.value_bits - 1);
+    *dod = (int64_t)(value ^ sign) - (int64_t)sign; // Sign extension
+    return true;
+}
+
+static bool get_value(SeriesDecoder *decoder)
+{
+    uint64_t control, field;
+    if (!get_bits(decoder, 1, &control))
+    {
+        return false;
+    }
+    if (control == 0)
+    {
+        return true; // Same value
+    }
+    if (!get_bits(decoder, 1, &control))
+    {
+        return false;
+    }
+    if (control == 1)
+    {
+        if (!get_bits(decoder, 5, &field))
+        {
+            return false;
+        }
+        decoder->leading = (uint8_t)field;
+        if (!get_bits(decoder, 5, &field))
+        {
+            return false;
+        }
+        decoder->trailing = (uint8_t)(32 - decoder->leading - (field + 1));
+    }
+    else if (decoder->leading == SERIES_NO_WINDOW)
+    {
+        return false;
+    }
+    uint8_t length = 32 - decoder->leading - decoder->trailing;
+    if (length == 0 || length > 32 || !get_bits(decoder, length, &field))
+    {
+        return false;
+    }
+    decoder->value ^= (uint32_t)field << decoder->trailing;
+    return true;
+}
+
+bool series_decoder_next(SeriesDecoder *decoder, uint64_t *time_ms, float *value)
+{
+    if (decoder->remaining == 0)
+    {
+        return false;
+    }
+    if (decoder->first)
+    {
+        uint64_t bits;
+        if (!get_bits(decoder, 32, &bits))
+        {
+            return false;
+        }
+        decoder->value = (uint32_t)bits;
+        decoder->first = false;
+    }
+    else
+    {
+        int64_t dod;
+        if (!get_delta(decoder, &dod) || !get_value(decoder))
+        {
+            return false;
+        }
+        decoder->delta_ms += dod;
+        decoder->time_ms += decoder->delta_ms;
+    }
+    decoder->remaining--;
+    *time_ms = decoder->time_ms;
+    *value = bits_float(decoder->value);
+    return true;
+}
+
+float series_quantize(float value, int8_t resolution_log2)
+{
+    return ldexpf(roundf(ldexpf(value, -resolution_log2)), resolution_log2);
+}
@@ -0,0 +1,105 @@
+#pragma once
+
+/*
+ * Gorilla compression of a time series into a fixed buffer, independent
+ * of the hardware.
+ *
+ * Timestamps are stored as the difference between consecutive deltas: a
+ * series sampled at a steady period costs one bit per timestamp, jitter
+ * of a few milliseconds 9 bits. Values are 32-bit floats XORed with the
+ * previous one: a repeated value costs one bit, otherwise only the bits
+ * between the leading and trailing zeros of the XOR are stored, reusing
+ * the previous window when it still fits. Values rounded to a power of two
+ * (see series_quantize()) share their low mantissa bits and compress
+ * best.
+ *
+ * Bits are written MSB first. The encoder never writes past its buffer:
+ * a sample that does not fit is refused and the buffer is left as it was,
+ * so a full buffer is a complete series.
+ */
+
+#include <stddef.h>
+#include <stdint.h>
+
+/// Encoder of one series.
+struct SeriesEncoder
+{
+    uint8_t *data;
+    uint16_t capacity_bits;
+    uint16_t bits;     ///< Bits written.
+    uint16_t count;    ///< Samples written.
+    uint64_t first_ms; ///< Time of the first sample.
+    uint64_t last_ms;  ///< Time of the last sample.
+    int64_t delta_ms;  ///< Last time delta.
+    uint32_t value;    ///< Bits of the last value.
+    uint8_t leading;   ///< Leading zeros of the last stored XOR window.
+    uint8_t trailing;  ///< Trailing zeros of the last stored XOR window.
+};
+
+/// Decoder of one series.
+struct SeriesDecoder
+{
+    const uint8_t *data;
+    uint16_t bits;      ///< Bits of the series.
+    uint16_t position;  ///< Next bit to read.
+    uint16_t remaining; ///< Samples left.
+    bool first;
+    uint64_t time_ms;
+    int64_t delta_ms;
+    uint32_t value;
+    uint8_t leading;
+    uint8_t trailing;
+};
+
+/**
+ * @brief Starts an empty series in a buffer.
+ *
+ * @param encoder Encoder.
+ * @param data Buffer, at most 8191 bytes.
+ * @param capacity Size of the buffer in bytes.
+ */
+void series_encoder_init(SeriesEncoder *encoder, uint8_t *data, size_t capacity);
+
+/**
+ * @brief Appends a sample.
+ *
+ * @param encoder Encoder.
+ * @param time_ms Time of the sample.
+ * @param value Value.
+ * @return true if the sample was stored, false if it does not fit, is
+ * earlier than the previous one or more than 24 days off its period, and
+ * the series is complete.
+ */
+bool series_encoder_add(SeriesEncoder *encoder, uint64_t time_ms, float value);
+
+/**
+ * @brief Starts reading a series written by a SeriesEncoder.
+ *
+ * @param decoder Decoder.
+ * @param data Buffer of the series.
+ * @param bits Bits written (SeriesEncoder::bits).
+ * @param count Samples written (SeriesEncoder::count).
+ * @param first_ms Time of the first sample (SeriesEncoder::first_ms).
+ */
+void series_decoder_init(SeriesDecoder *decoder, const uint8_t *data, uint16_t bits, uint16_t count, uint64_t first_ms);
+
+/**
+ * @brief Reads the next sample.
+ *
+ * @param decoder Decoder.
+ * @param time_ms (Output) Time of the sample.
+ * @param value (Output) Value.
+ * @return true if a sample was read, false at the end of the series or if it is malformed.
+ */
+bool series_decoder_next(SeriesDecoder *decoder, uint64_t *time_ms, float *value);
+
+/**
+ * @brief Rounds a value to a multiple of a power of two.
+ *
+ * The result keeps at most the mantissa bits the resolution needs, so
+ * consecutive values differ in few bits.
+ *
+ * @param value Value.
+ * @param resolution_log2 Exponent of the resolution, e.g. -6 for 1/64.
+ */
+float series_quantize(float value, int8_t resolution_log2);
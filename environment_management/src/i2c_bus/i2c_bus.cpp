@@ -0,0 +1,200 @@
+#include "hal/hal.hpp"
+#include "i2c_bus.hpp"
+
+#define I2C_BUS_TAG "app_i2c_bus"
+
+/// Registered device.
+struct I2cDevice
+{
+    uint8_t address;
+    uint16_t timeout_ms;
+};
+
+static I2cDevice devices[I2C_BUS_MAX_DEVICES];
+static I2cBusStats stats;
+static hal_mutex_t stats_mutex = NULL; // Counted in the bus task, read from any task
+static hal_queue_t request_queue = NULL;
+static uint64_t start_us = 0;
+static uint64_t logged_us = 0;
+static uint16_t current_timeout_ms = 0; // Timeout currently set in the master
+
+bool init_i2c_bus()
+{
+    stats_mutex = hal_mutex_create();
+    request_queue = hal_queue_create(I2C_BUS_QUEUE_LENGTH, sizeof(I2cRequest));
+    if (stats_mutex == NULL || request_queue == NULL)
+    {
+        ESP_LOGE(I2C_BUS_TAG, "Failed to create the bus mutex or queue");
+        return false;
+    }
+    if (!hal_i2c_begin(I2C_BUS_SDA_PIN, I2C_BUS_SCL_PIN, I2C_BUS_HZ))
+    {
+        ESP_LOGE(I2C_BUS_TAG, "Failed to start the I2C bus");
+        return false;
+    }
+    start_us = logged_us = hal_micros();
+    current_timeout_ms = 0;
+    return true;
+}
+
+uint8_t i2c_bus_add_device(uint8_t address, uint16_t timeout_ms, const char *name)
+{
+    hal_mutex_take(stats_mutex, HAL_WAIT_FOREVER);
+    uint8_t device = stats.devices;
+    if (device < I2C_BUS_MAX_DEVICES)
+    {
+        devices[device].address = address;
+        devices[device].timeout_ms = timeout_ms;
+        stats.device[device].name = name;
+        stats.device[device].address = address;
+        stats.devices++;
+    }
+    hal_mutex_give(stats_mutex);
+
+    if (device >= I2C_BUS_MAX_DEVICES)
+    {
+        ESP_LOGE(I2C_BUS_TAG, "No room for %s at 0x%02x", name, address);
+        return I2C_BUS_NO_DEVICE;
+    }
+    return device;
+}
+
+bool i2c_bus_submit(const I2cRequest *request)
+{
+    if (hal_queue_send(request_queue, request, 0))
+    {
+        return true;
+    }
+    hal_mutex_take(stats_mutex, HAL_WAIT_FOREVER);
+    stats.queue_full++;
+    hal_mutex_give(stats_mutex);
+    return false;
+}
+
+/* Clocks a device holding SDA out of its transfer, then restarts the master */
+static void recover()
+{
+    hal_i2c_end();
+    hal_gpio_mode(I2C_BUS_SDA_PIN, HAL_INPUT); // Released, the pull-up shows whether a device still holds it
+    hal_gpio_mode(I2C_BUS_SCL_PIN, HAL_OUTPUT_OPEN_DRAIN);
+    hal_gpio_write(I2C_BUS_SCL_PIN, HAL_HIGH);
+
+    // Up to 9 clocks: the rest of a byte and its acknowledge
+    int pulses = 0;
+    for (; pulses < 9 && hal_gpio_read(I2C_BUS_SDA_PIN) == HAL_LOW; pulses++)
+    {
+        hal_gpio_write(I2C_BUS_SCL_PIN, HAL_LOW);
+        hal_delay_us(I2C_BUS_RECOVERY_US);
+        hal_gpio_write(I2C_BUS_SCL_PIN, HAL_HIGH);
+        hal_delay_us(I2C_BUS_RECOVERY_US);
+    }
+    bool released = hal_gpio_read(I2C_BUS_SDA_PIN) == HAL_HIGH;
+
+    // STOP: SDA rises while SCL is high
+    hal_gpio_write(I2C_BUS_SCL_PIN, HAL_LOW);
+    hal_gpio_mode(I2C_BUS_SDA_PIN, HAL_OUTPUT_OPEN_DRAIN);
+    hal_gpio_write(I2C_BUS_SDA_PIN, HAL_LOW);
+    hal_delay_us(I2C_BUS_RECOVERY_US);
+    hal_gpio_write(I2C_BUS_SCL_PIN, HAL_HIGH);
+    hal_delay_us(I2C_BUS_RECOVERY_US);
+    hal_gpio_write(I2C_BUS_SDA_PIN, HAL_HIGH);
+    hal_delay_us(I2C_BUS_RECOVERY_US);
+
+    hal_i2c_begin(I2C_BUS_SDA_PIN, I2C_BUS_SCL_PIN, I2C_BUS_HZ);
+    current_timeout_ms = 0;
+    if (released)
+    {
+        ESP_LOGW(I2C_BUS_TAG, "SDA was stuck low, released after %d clocks", pulses);
+    }
+    else
+    {
+        ESP_LOGE(I2C_BUS_TAG, "SDA still stuck low after %d clocks", pulses);
+    }
+}
+
+/* Runs one operation, recovering the bus if it is left stuck */
+static bool run(const I2cOp *op)
+{
+    const I2cDevice &device = devices[op->device];
+    if (device.timeout_ms != current_timeout_ms)
+    {
+        current_timeout_ms = device.timeout_ms;
+        hal_i2c_set_timeout(current_timeout_ms);
+    }
+
+    uint64_t begin_us = hal_micros();
+    bool ok = op->rx != NULL ? hal_i2c_write_read(device.address, op->tx, op->tx_length, op->rx, op->rx_length)
+                             : hal_i2c_write(device.address, op->tx, op->tx_length);
+    uint64_t end_us = hal_micros();
+    bool timeout = !ok && end_us - begin_us >= device.timeout_ms * 1000ULL;
+    bool stuck = !ok && hal_gpio_read(I2C_BUS_SDA_PIN) == HAL_LOW;
+    if (stuck)
+    {
+        recover();
+    }
+    uint64_t recovered_us = hal_micros();
+
+    hal_mutex_take(stats_mutex, HAL_WAIT_FOREVER);
+    I2cDeviceStats &counters = stats.device[op->device];
+    counters.transfers++;
+    counters.errors += !ok;
+    counters.timeouts += timeout;
+    counters.busy_us += end_us - begin_us;
+    stats.recoveries += stuck;
+    stats.busy_us += recovered_us - begin_us;
+    hal_mutex_give(stats_mutex);
+    return ok;
+}
+
+static void log_stats()
+{
+    I2cBusStats copy;
+    i2c_bus_get_stats(&copy);
+    ESP_LOGI(I2C_BUS_TAG, "I2C bus %.2f%% busy, %lu requests, %lu refused, %lu recoveries",
+             copy.elapsed_us > 0 ? 100.0 * copy.busy_us / copy.elapsed_us : 0.0, (unsigned long)copy.requests,
+             (unsigned long)copy.queue_full, (unsigned long)copy.recoveries);
+    for (uint8_t d = 0; d < copy.devices; d++)
+    {
+        const I2cDeviceStats &device = copy.device[d];
+        ESP_LOGI(I2C_BUS_TAG, "  %s at 0x%02x: %lu transfers, %lu errors, %lu timeouts", device.name, device.address,
+                 (unsigned long)device.transfers, (unsigned long)device.errors, (unsigned long)device.timeouts);
+    }
+}
+
+void handle_i2c_bus()
+{
+    I2cRequest request;
+    if (hal_queue_receive(request_queue, &request, I2C_BUS_STATS_MS))
+    {
+        uint8_t failed = 0;
+        for (uint8_t i = 0; i < request.count && i < I2C_BUS_MAX_OPS; i++)
+        {
+            if (request.ops[i].device >= stats.devices || !run(&request.ops[i]))
+            {
+                failed |= 1 << i;
+            }
+        }
+
+        hal_mutex_take(stats_mutex, HAL_WAIT_FOREVER);
+        stats.requests++;
+        hal_mutex_give(stats_mutex);
+        if (request.callback != NULL)
+        {
+            request.callback(request.ctx, failed);
+        }
+    }
+
+    if (hal_micros() - logged_us >= I2C_BUS_STATS_MS * 1000ULL)
+    {
+        logged_us = hal_micros();
+        log_stats();
+    }
+}
+
+void i2c_bus_get_stats(I2cBusStats *copy)
+{
+    hal_mutex_take(stats_mutex, HAL_WAIT_FOREVER);
+    *copy = stats;
+    copy->elapsed_us = hal_micros() - start_us;
+    hal_mutex_give(stats_mutex);
+}
@@ -0,0 +1,130 @@
+#pragma once
+
+/*
+ * Shared I2C bus of the node, on the HAL.
+ *
+ * The BME280 and both INA219s sit on one bus and are read from different
+ * tasks, so once the tasks run, only the bus task touches the bus: sensor
+ * modules queue requests and get the result in a callback. A request is a
+ * batch of register bursts (select a register, read its bytes with a
+ * repeated start), run back to back, so the readings of a batch are taken
+ * as close together as the bus allows. Operations of a batch are
+ * independent: a failed one does not stop the next ones.
+ *
+ * Every device has its own timeout, above its longest clock stretching. A
+ * failure with SDA held low means a device lost track of a transfer, e.g.
+ * after a reset in the middle of a read: the bus task then clocks SCL by
+ * hand until the device lets go of SDA, sends a STOP and restarts the
+ * master.
+ *
+ * During setup, before the bus task starts, drivers may use the HAL I2C
+ * functions directly to configure their chip.
+ */
+
+#include <stddef.h>
+#include <stdint.h>
+
+#define I2C_BUS_SDA_PIN 21
+#define I2C_BUS_SCL_PIN 22
+#define I2C_BUS_HZ 400000
+
+#define I2C_BUS_MAX_DEVICES 4
+#define I2C_BUS_MAX_OPS 4       // Operations per request
+#define I2C_BUS_MAX_TX 3        // Register address and a 16-bit value
+#define I2C_BUS_QUEUE_LENGTH 8  // Requests waiting for the bus
+#define I2C_BUS_STATS_MS 600000 // Statistics logged every 10 min
+#define I2C_BUS_RECOVERY_US 5   // Half period of the recovery clock, 100 kHz
+
+#define I2C_BUS_NO_DEVICE 0xFF
+
+/**
+ * @brief Called by the bus task once every operation of a request has run.
+ *
+ * @param ctx Argument given with the request.
+ * @param failed Bit mask of the operations that failed, 0 if all succeeded.
+ */
+typedef void (*i2c_bus_callback_t)(void *ctx, uint8_t failed);
+
+/// One transfer: writes tx, then reads rx_length bytes with a repeated start if rx is set.
+struct I2cOp
+{
+    uint8_t device; ///< Handle from i2c_bus_add_device().
+    uint8_t tx_length;
+    uint8_t tx[I2C_BUS_MAX_TX];
+    uint8_t rx_length;
+    uint8_t *rx; ///< Must stay valid until the callback, NULL for a write.
+};
+
+/// Batch of operations run back to back.
+struct I2cRequest
+{
+    I2cOp ops[I2C_BUS_MAX_OPS];
+    uint8_t count;
+    i2c_bus_callback_t callback; ///< NULL if the result is not needed.
+    void *ctx;
+};
+
+/// Counters of one device.
+struct I2cDeviceStats
+{
+    const char *name;
+    uint8_t address;
+    uint32_t transfers;
+    uint32_t errors;   ///< Failed transfers, timeouts included.
+    uint32_t timeouts; ///< Transfers that failed after the timeout of the device.
+    uint64_t busy_us;  ///< Time spent in transfers.
+};
+
+/// Counters of the bus since init_i2c_bus().
+struct I2cBusStats
+{
+    uint32_t requests;
+    uint32_t queue_full; ///< Requests refused by i2c_bus_submit().
+    uint32_t recoveries;
+    uint64_t busy_us;    ///< Time spent in transfers and recoveries.
+    uint64_t elapsed_us; ///< Time since init_i2c_bus(), busy_us / elapsed_us is the utilisation.
+    uint8_t devices;
+    I2cDeviceStats device[I2C_BUS_MAX_DEVICES];
+};
+
+/**
+ * @brief Starts the I2C master and creates the request queue.
+ *
+ * @return true if initialization was successful, false otherwise.
+ */
+bool init_i2c_bus();
+
+/**
+ * @brief Registers a device, during setup.
+ *
+ * @param address 7-bit address of the device.
+ * @param timeout_ms Longest time a transfer may take, clock stretching included.
+ * @param name Name in the logs, must stay valid.
+ * @return Handle of the device, I2C_BUS_NO_DEVICE if I2C_BUS_MAX_DEVICES are registered already.
+ */
+uint8_t i2c_bus_add_device(uint8_t address, uint16_t timeout_ms, const char *name);
+
+/**
+ * @brief Queues a request for the bus task, from any task.
+ *
+ * The request is copied, the rx buffers are not.
+ *
+ * @param request Request of 1 to I2C_BUS_MAX_OPS operations.
+ * @return true if the request was queued, false if the queue is full; the callback is not called then.
+ */
+bool i2c_bus_submit(const I2cRequest *request);
+
+/**
+ * @brief Runs the queued requests, body of the bus task.
+ *
+ * Blocks until a request arrives, at most I2C_BUS_STATS_MS, and logs the
+ * statistics every I2C_BUS_STATS_MS.
+ */
+void handle_i2c_bus();
+
+/**
+ * @brief Copies the counters of the bus and of every device.
+ *
+ * @param stats (Output) Counters.
+ */
+void i2c_bus_get_stats(I2cBusStats *stats);
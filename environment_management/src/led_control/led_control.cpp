@@ -44,7 +44,7 @@ void handle_led_control()
     set_led_color(5, 0, 255, 255); // Dioda 6 - turkusowy
 
     ESP_LOGI(LED_CONTROL_TAG, "Handling LED control - Set 1");
-    delay(4000);  // Odczekaj 4 sekundy
+    hal_delay_ms(4000);  // Odczekaj 4 sekundy
 
     // Drugi zestaw kolorów
     set_led_color(0, 255, 165, 0);  // Dioda 1 - pomarańczowy
@@ -55,5 +55,5 @@ void handle_led_control()
     set_led_color(5, 255, 20, 147); // Dioda 6 - róż głęboki
 
     ESP_LOGI(LED_CONTROL_TAG, "Handling LED control - Set 2");
-    delay(4000);  // Odczekaj 4 sekundy
+    hal_delay_ms(4000);  // Odczekaj 4 sekundy
 }
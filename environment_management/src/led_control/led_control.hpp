@@ -2,6 +2,7 @@
 
 #include <Arduino.h>
 #include <FastLED.h>
+#include "hal/hal.hpp"
 #include "esp_log.h"
 
 // Konfiguracja LED
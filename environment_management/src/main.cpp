@@ -1,3 +1,5 @@
+#if defined(ARDUINO)
+
 #include <Arduino.h>
 #include "scheduling/scheduling.hpp"
 
@@ -19,6 +21,12 @@ void setup()
   {
     ESP_LOGE(MAIN_TAG, "ESP32 setup failed. Halting.");
   }
+
+#ifdef BOOT_REPORT
+  // Printed with Serial so it is still visible when logs are compiled out
+  Serial.printf("Boot completed in %lu ms, free heap: %u B, min free heap: %u B\n",
+                millis(), ESP.getFreeHeap(), ESP.getMinFreeHeap());
+#endif
 }
 
 /**
@@ -33,3 +41,5 @@ void loop()
 {
   vTaskDelay(10 / portTICK_PERIOD_MS); // 10 ms delay to prevent watchdog reset
 }
+
+#endif
@@ -9,6 +9,8 @@ TaskHandle_t env_measurement_task;
 TaskHandle_t button_task;
 TaskHandle_t led_control_task;
 TaskHandle_t energy_monitor_task;
+TaskHandle_t history_task;
+TaskHandle_t i2c_bus_task;
 
 WiFiManager wifiManager;
 MqttManager mqttManager;
@@ -27,18 +29,36 @@ bool esp_setup()
     wifiManager.begin();
     mqttManager.begin();
 
+    if (!init_telemetry())
+    {
+        ESP_LOGE(SCHEDULING_TAG, "Telemetry initialization failed.");
+        return false;
+    }
+
+    if (!init_history())
+    {
+        ESP_LOGE(SCHEDULING_TAG, "History initialization failed.");
+        return false;
+    }
+
+    if (!init_i2c_bus())
+    {
+        ESP_LOGE(SCHEDULING_TAG, "I2C bus initialization failed.");
+        return false;
+    }
+
+    if (!init_env_measurement())
+    {
+        ESP_LOGE(SCHEDULING_TAG, "Environmental measurement initialization failed.");
+        return false;
+    }
+
     if (!init_fan_control())
     {
         ESP_LOGE(SCHEDULING_TAG, "Fan control initialization failed.");
         return false;
     }
 
-    // if (!init_env_measurement())
-    // {
-    //     ESP_LOGE(SCHEDULING_TAG, "Environmental measurement initialization failed.");
-    //     return false;
-    // }
-
     if (!init_led_control())
     {
         ESP_LOGE(SCHEDULING_TAG, "LED control initialization failed.");
@@ -66,6 +86,20 @@ bool init_scheduling()
 
     BaseType_t result;
 
+    result = xTaskCreatePinnedToCore(
+        i2cBusTask,
+        "i2c_bus_task",
+        I2C_BUS_TASK_STACK_SIZE,
+        NULL,
+        I2C_BUS_TASK_PRIORITY,
+        &i2c_bus_task,
+        I2C_BUS_TASK_CORE);
+    if (result != pdPASS)
+    {
+        ESP_LOGE(SCHEDULING_TAG, "Failed to create I2C bus task.");
+        return false;
+    }
+
     result = xTaskCreatePinnedToCore(
         buttonTask,
         "button_task",
@@ -123,19 +157,19 @@ bool init_scheduling()
         return false;
     }
 
-    // result = xTaskCreatePinnedToCore(
-    //     envMeasurementTask,
-    //     "env_measurement_task",
-    //     ENV_MEASUREMENT_TASK_STACK_SIZE,
-    //     NULL,
-    //     ENV_MEASUREMENT_TASK_PRIORITY,
-    //     &env_measurement_task,
-    //     ENV_MEASUREMENT_TASK_CORE);
-    // if (result != pdPASS)
-    // {
-    //     ESP_LOGE(SCHEDULING_TAG, "Failed to create environmental measurement task.");
-    //     return false;
-    // }
+    result = xTaskCreatePinnedToCore(
+        envMeasurementTask,
+        "env_measurement_task",
+        ENV_MEASUREMENT_TASK_STACK_SIZE,
+        NULL,
+        ENV_MEASUREMENT_TASK_PRIORITY,
+        &env_measurement_task,
+        ENV_MEASUREMENT_TASK_CORE);
+    if (result != pdPASS)
+    {
+        ESP_LOGE(SCHEDULING_TAG, "Failed to create environmental measurement task.");
+        return false;
+    }
 
     result = xTaskCreatePinnedToCore(
         ledControlTask,
@@ -165,6 +199,20 @@ bool init_scheduling()
         return false;
     }
 
+    result = xTaskCreatePinnedToCore(
+        historyTask,
+        "history_task",
+        HISTORY_TASK_STACK_SIZE,
+        NULL,
+        HISTORY_TASK_PRIORITY,
+        &history_task,
+        HISTORY_TASK_CORE);
+    if (result != pdPASS)
+    {
+        ESP_LOGE(SCHEDULING_TAG, "Failed to create history task.");
+        return false;
+    }
+
     return true;
 }
 
@@ -182,6 +230,10 @@ void mqttTask(void *pvParameters)
     while (true)
     {
         mqttManager.handle();
+        publish_energy_summary();
+        publish_telemetry();
+        publish_history();
+        publish_fan_control();
         vTaskDelay(MQTT_EVENT_FREQUENCY / portTICK_PERIOD_MS);
     }
 }
@@ -224,9 +276,27 @@ void ledControlTask(void *pvParameters)
 
 void energyMonitorTask(void *pvParameters)
 {
+    TickType_t last_wake = xTaskGetTickCount();
     while (true)
     {
         handle_energy_monitor();
-        vTaskDelay(ENERGY_MONITOR_EVENT_FREQUENCY / portTICK_PERIOD_MS);
+        vTaskDelayUntil(&last_wake, ENERGY_MONITOR_EVENT_FREQUENCY / portTICK_PERIOD_MS);
     }
-}
\ No newline at end of file
+}
+
+void historyTask(void *pvParameters)
+{
+    while (true)
+    {
+        handle_history();
+        vTaskDelay(HISTORY_EVENT_FREQUENCY / portTICK_PERIOD_MS);
+    }
+}
+
+void i2cBusTask(void *pvParameters)
+{
+    while (true)
+    {
+        handle_i2c_bus();
+    }
+}
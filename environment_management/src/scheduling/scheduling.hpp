@@ -5,14 +5,17 @@
 #include "freertos/task.h"
 #include "esp_log.h"
 
-#include "../network/wifi/wifi.hpp"
-#include "../network/mqtt/mqtt.hpp"
-#include "../network/button/button.hpp"
-#include "../network/access_point/access_point.hpp"
+#include "network/wifi/wifi.hpp"
+#include "network/mqtt/mqtt.hpp"
+#include "network/button/button.hpp"
+#include "network/access_point/access_point.hpp"
 #include "../fan_control/fan_control.hpp"
 #include "../env_measurement/env_measurement.hpp"
 #include "../led_control/led_control.hpp"
 #include "../energy_monitor/energy_monitor.hpp"
+#include "../telemetry/telemetry.hpp"
+#include "../history/history.hpp"
+#include "../i2c_bus/i2c_bus.hpp"
 
 /* Task priorities */
 #define WIFI_TASK_PRIORITY 3
@@ -22,6 +25,8 @@
 #define ENV_MEASUREMENT_TASK_PRIORITY 2
 #define LED_CONTROL_TASK_PRIORITY 3
 #define ENERGY_MONITOR_TASK_PRIORITY 4
+#define HISTORY_TASK_PRIORITY 1
+#define I2C_BUS_TASK_PRIORITY 5 // Above every sensor task, a transfer is short
 
 /* Core assignments */
 #define WIFI_TASK_CORE 0
@@ -31,6 +36,8 @@
 #define ENV_MEASUREMENT_TASK_CORE 1
 #define LED_CONTROL_TASK_CORE 1
 #define ENERGY_MONITOR_TASK_CORE 1
+#define HISTORY_TASK_CORE 0
+#define I2C_BUS_TASK_CORE 1
 
 /* Task stack size */
 #define WIFI_TASK_STACK_SIZE 4096
@@ -40,6 +47,8 @@
 #define ENV_MEASUREMENT_TASK_STACK_SIZE 4096
 #define LED_CONTROL_TASK_STACK_SIZE 4096
 #define ENERGY_MONITOR_TASK_STACK_SIZE 4096
+#define HISTORY_TASK_STACK_SIZE 4096
+#define I2C_BUS_TASK_STACK_SIZE 4096 // Completion callbacks run on it
 
 /* Event frequencies in ms */
 #define WIFI_EVENT_FREQUENCY 1000
@@ -48,7 +57,10 @@
 #define FAN_CONTROL_EVENT_FREQUENCY 1000
 #define ENV_MEASUREMENT_EVENT_FREQUENCY 1000
 #define LED_CONTROL_EVENT_FREQUENCY 1000
-#define ENERGY_MONITOR_EVENT_FREQUENCY 1000
+#define ENERGY_MONITOR_EVENT_FREQUENCY 100 // INA219 sampling period, kept steady
+#define HISTORY_EVENT_FREQUENCY 1000
+
+extern MqttManager mqttManager;
 
 /**
  * @brief Setup function for the ESP32.
@@ -125,8 +137,29 @@ void ledControlTask(void *pvParameters);
 /**
  * @brief Task function for handling energy monitor events.
  *
- * This function is responsible for handling energy monitor events in the background.
+ * This function samples the energy monitors every ENERGY_MONITOR_EVENT_FREQUENCY,
+ * measured from wake-up to wake-up so the sampling rate does not drift.
+ *
+ * @param pvParameters pointer to task-specific data structure
+ */
+void energyMonitorTask(void *pvParameters);
+
+/**
+ * @brief Task function for recording the sensor history.
+ *
+ * This function closes history periods and writes full blocks to flash,
+ * apart from the MQTT task so recording goes on while the broker is unreachable.
+ *
+ * @param pvParameters pointer to task-specific data structure
+ */
+void historyTask(void *pvParameters);
+
+/**
+ * @brief Task function for the shared I2C bus.
+ *
+ * This function runs the queued I2C requests and their completion callbacks,
+ * blocking on the request queue in between.
  *
  * @param pvParameters pointer to task-specific data structure
  */
-void energyMonitorTask(void *pvParameters);
\ No newline at end of file
+void i2cBusTask(void *pvParameters);
@@ -0,0 +1,182 @@
+#include <math.h>
+#include <string.h>
+#include "stream_stats.hpp"
+
+static const uint32_t window_ms[STREAM_WINDOWS] = {60000, 900000, 3600000};
+
+uint32_t stream_window_ms(StreamWindowLength window)
+{
+    return window_ms[window];
+}
+
+static void quantile_reset(StreamQuantile *quantile, float p)
+{
+    quantile->p = p;
+    for (int i = 0; i < STREAM_P2_MARKERS; i++)
+    {
+        quantile->heights[i] = 0;
+        quantile->positions[i] = i;
+    }
+    quantile->desired[0] = 0;
+    quantile->desired[1] = 2 * p;
+    quantile->desired[2] = 4 * p;
+    quantile->desired[3] = 2 + 2 * p;
+    quantile->desired[4] = 4;
+}
+
+/* Piecewise-parabolic prediction of marker i moved by d (+1 or -1) */
+static float parabolic(const StreamQuantile *quantile, int i, int d)
+{
+    const float *q = quantile->heights;
+    float n0 = (float)quantile->positions[i - 1], n1 = (float)quantile->positions[i], n2 = (float)quantile->positions[i + 1];
+    return q[i] + d / (n2 - n0) * ((n1 - n0 + d) * (q[i + 1] - q[i]) / (n2 - n1) + (n2 - n1 - d) * (q[i] - q[i - 1]) / (n1 - n0));
+}
+
+/* count is the number of samples before this one */
+static void quantile_add(StreamQuantile *quantile, uint32_t count, float value)
+{
+    float *q = quantile->heights;
+    uint32_t *n = quantile->positions;
+    if (count < STREAM_P2_MARKERS)
+    {
+        // Insertion sort of the first samples, they become the markers
+        int i = (int)count;
+        for (; i > 0 && q[i - 1] > value; i--)
+        {
+            q[i] = q[i - 1];
+        }
+        q[i] = value;
+        return;
+    }
+
+    int cell;
+    if (value < q[0])
+    {
+        q[0] = value;
+        cell = 0;
+    }
+    else if (value >= q[4])
+    {
+        q[4] = value;
+        cell = 3;
+    }
+    else
+    {
+        cell = 0;
+        while (value >= q[cell + 1])
+        {
+            cell++;
+        }
+    }
+    for (int i = cell + 1; i < STREAM_P2_MARKERS; i++)
+    {
+        n[i]++;
+    }
+    const float p = quantile->p;
+    const float increments[STREAM_P2_MARKERS] = {0, p / 2, p, (1 + p) / 2, 1};
+    for (int i = 1; i < STREAM_P2_MARKERS; i++)
+    {
+        quantile->desired[i] += increments[i];
+    }
+
+    for (int i = 1; i < STREAM_P2_MARKERS - 1; i++)
+    {
+        float offset = quantile->desired[i] - n[i];
+        if ((offset >= 1 && n[i + 1] - n[i] > 1) || (offset <= -1 && n[i] - n[i - 1] > 1))
+        {
+            int d = offset > 0 ? 1 : -1;
+            float height = parabolic(quantile, i, d);
+            if (!(q[i - 1] < height && height < q[i + 1]))
+            {
+                height = q[i] + d * (q[i + d] - q[i]) / ((float)n[i + d] - (float)n[i]); // Linear
+            }
+            q[i] = height;
+            n[i] += d;
+        }
+    }
+}
+
+static float quantile_estimate(const StreamQuantile *quantile, uint32_t count)
+{
+    if (count == 0)
+    {
+        return 0;
+    }
+    if (count < STREAM_P2_MARKERS)
+    {
+        uint32_t rank = (uint32_t)ceilf(quantile->p * count); // Nearest rank of the samples kept sorted
+        return quantile->heights[rank > 0 ? rank - 1 : 0];
+    }
+    return quantile->heights[2];
+}
+
+void stream_stats_reset(StreamStats *stats)
+{
+    stats->count = 0;
+    stats->min = 0;
+    stats->max = 0;
+    stats->mean = 0;
+    stats->m2 = 0;
+    quantile_reset(&stats->median, 0.5f);
+    quantile_reset(&stats->p95, 0.95f);
+}
+
+void stream_stats_add(StreamStats *stats, float value)
+{
+    quantile_add(&stats->median, stats->count, value);
+    quantile_add(&stats->p95, stats->count, value);
+
+    if (stats->count == 0)
+    {
+        stats->min = stats->max = value;
+    }
+    stats->min = value < stats->min ? value : stats->min;
+    stats->max = value > stats->max ? value : stats->max;
+
+    stats->count++;
+    float delta = value - stats->mean;
+    stats->mean += delta / stats->count;
+    stats->m2 += delta * (value - stats->mean);
+}
+
+void stream_stats_summary(const StreamStats *stats, StreamSummary *summary)
+{
+    summary->count = stats->count;
+    summary->min = stats->min;
+    summary->max = stats->max;
+    summary->mean = stats->mean;
+    summary->stddev = stats->count > 1 ? sqrtf(stats->m2 / (stats->count - 1)) : 0;
+    summary->median = quantile_estimate(&stats->median, stats->count);
+    summary->p95 = quantile_estimate(&stats->p95, stats->count);
+}
+
+void stream_channel_init(StreamChannel *channel, uint32_t now_ms)
+{
+    for (int w = 0; w < STREAM_WINDOWS; w++)
+    {
+        channel->windows[w].start_ms = now_ms;
+        stream_stats_reset(&channel->windows[w].stats);
+    }
+}
+
+uint8_t stream_channel_add(StreamChannel *channel, uint32_t now_ms, float value, StreamSummary closed[STREAM_WINDOWS])
+{
+    uint8_t closed_mask = 0;
+    for (int w = 0; w < STREAM_WINDOWS; w++)
+    {
+        StreamWindow *window = &channel->windows[w];
+        uint32_t elapsed_ms = now_ms - window->start_ms;
+        if (elapsed_ms >= window_ms[w])
+        {
+            if (window->stats.count > 0)
+            {
+                stream_stats_summary(&window->stats, &closed[w]);
+                closed_mask |= 1 << w;
+            }
+            stream_stats_reset(&window->stats);
+            window->start_ms += elapsed_ms - elapsed_ms % window_ms[w]; // Boundary the sample falls after
+        }
+        stream_stats_add(&window->stats, value);
+    }
+    return closed_mask;
+}
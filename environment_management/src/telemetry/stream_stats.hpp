@@ -0,0 +1,123 @@
+#pragma once
+
+/*
+ * Fixed-memory streaming statistics, independent of the hardware.
+ *
+ * Every sample updates count, min, max, mean and variance (Welford's
+ * method, stable over long windows) and two P² quantile estimators (Jain
+ * and Chlamtac), the median and the 95th percentile, each five markers
+ * adjusted in constant time. Nothing depends on the number of samples:
+ * a channel costs the same memory and time per sample over a minute or an
+ * hour.
+ *
+ * A channel keeps one set of statistics per window length. Windows
+ * tumble: when a sample arrives past the end of a window, the window is
+ * summarized and restarts at the boundary the sample falls in. A window
+ * without samples yields no summary.
+ */
+
+#include <stdint.h>
+
+#define STREAM_P2_MARKERS 5
+
+/// Window lengths of a channel.
+enum StreamWindowLength : uint8_t
+{
+    STREAM_WINDOW_1M,
+    STREAM_WINDOW_15M,
+    STREAM_WINDOW_1H,
+    STREAM_WINDOWS,
+};
+
+/// P² estimator of one quantile.
+struct StreamQuantile
+{
+    float p;                               ///< Quantile estimated, 0 to 1.
+    float heights[STREAM_P2_MARKERS];      ///< Marker heights; the first samples, sorted, until there are five.
+    float desired[STREAM_P2_MARKERS];      ///< Desired marker positions.
+    uint32_t positions[STREAM_P2_MARKERS]; ///< Marker positions, 0-based.
+};
+
+/// Statistics of a stream of samples.
+struct StreamStats
+{
+    uint32_t count;
+    float min;
+    float max;
+    float mean;
+    float m2; ///< Sum of squared differences from the mean.
+    StreamQuantile median;
+    StreamQuantile p95;
+};
+
+/// Summary of a window.
+struct StreamSummary
+{
+    uint32_t count;
+    float min;
+    float max;
+    float mean;
+    float stddev; ///< Sample standard deviation, 0 below two samples.
+    float median;
+    float p95;
+};
+
+/// One window of a channel.
+struct StreamWindow
+{
+    uint32_t start_ms;
+    StreamStats stats;
+};
+
+/// Statistics of a channel over every window length.
+struct StreamChannel
+{
+    StreamWindow windows[STREAM_WINDOWS];
+};
+
+/**
+ * @brief Returns the length of a window in milliseconds.
+ */
+uint32_t stream_window_ms(StreamWindowLength window);
+
+/**
+ * @brief Empties statistics.
+ *
+ * @param stats Statistics.
+ */
+void stream_stats_reset(StreamStats *stats);
+
+/**
+ * @brief Adds a sample, in constant time.
+ *
+ * @param stats Statistics.
+ * @param value Sample.
+ */
+void stream_stats_add(StreamStats *stats, float value);
+
+/**
+ * @brief Summarizes statistics.
+ *
+ * @param stats Statistics.
+ * @param summary (Output) Summary.
+ */
+void stream_stats_summary(const StreamStats *stats, StreamSummary *summary);
+
+/**
+ * @brief Starts every window of a channel.
+ *
+ * @param channel Channel.
+ * @param now_ms Start of the windows.
+ */
+void stream_channel_init(StreamChannel *channel, uint32_t now_ms);
+
+/**
+ * @brief Adds a sample to every window of a channel, closing the windows it falls after.
+ *
+ * @param channel Channel.
+ * @param now_ms Time of the sample.
+ * @param value Sample.
+ * @param closed (Output) Summaries of the windows closed, by window length.
+ * @return Bit mask of the windows closed (1 << StreamWindowLength).
+ */
+uint8_t stream_channel_add(StreamChannel *channel, uint32_t now_ms, float value, StreamSummary closed[STREAM_WINDOWS]);
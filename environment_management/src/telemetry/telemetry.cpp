@@ -0,0 +1,92 @@
+#include <stdio.h>
+#include "telemetry.hpp"
+#include "../uplink/uplink.hpp"
+#include "../history/history.hpp"
+
+#define TELEMETRY_TAG "app_telemetry"
+
+/// Summary waiting to be published.
+struct TelemetryMessage
+{
+    uint8_t channel;
+    uint8_t window;
+    StreamSummary summary;
+};
+
+static const char *const channel_names[TELEMETRY_CHANNELS] = {"temperature", "humidity", "pressure",
+                                                              "production_power", "consumption_power"};
+static const char *const window_names[STREAM_WINDOWS] = {"1m", "15m", "1h"};
+
+static StreamChannel channels[TELEMETRY_CHANNELS];
+static hal_mutex_t channels_mutex = NULL; // Sensor tasks add samples concurrently
+static hal_queue_t summary_queue = NULL;
+static uint32_t dropped = 0;
+
+bool init_telemetry()
+{
+    channels_mutex = hal_mutex_create();
+    summary_queue = hal_queue_create(TELEMETRY_QUEUE_LENGTH, sizeof(TelemetryMessage));
+    if (channels_mutex == NULL || summary_queue == NULL)
+    {
+        ESP_LOGE(TELEMETRY_TAG, "Failed to create the telemetry mutex or queue");
+        return false;
+    }
+
+    uint32_t now_ms = hal_millis();
+    for (uint8_t c = 0; c < TELEMETRY_CHANNELS; c++)
+    {
+        stream_channel_init(&channels[c], now_ms);
+    }
+    ESP_LOGI(TELEMETRY_TAG, "Telemetry statistics initialized, %u B per channel", (unsigned)sizeof(StreamChannel));
+    return true;
+}
+
+const char *telemetry_channel_name(TelemetryChannel channel)
+{
+    return channel_names[channel];
+}
+
+void telemetry_add(TelemetryChannel channel, float value)
+{
+    history_add(channel, value);
+
+    StreamSummary closed[STREAM_WINDOWS];
+    hal_mutex_take(channels_mutex, HAL_WAIT_FOREVER);
+    uint8_t closed_mask = stream_channel_add(&channels[channel], hal_millis(), value, closed);
+    hal_mutex_give(channels_mutex);
+
+    for (uint8_t w = 0; w < STREAM_WINDOWS; w++)
+    {
+        if (closed_mask & (1 << w))
+        {
+            TelemetryMessage message = {channel, w, closed[w]};
+            if (!hal_queue_send(summary_queue, &message, 0))
+            {
+                dropped++;
+                ESP_LOGW(TELEMETRY_TAG, "Summary queue full, %s/%s dropped (%lu so far)", channel_names[channel],
+                         window_names[w], (unsigned long)dropped);
+            }
+        }
+    }
+}
+
+void publish_telemetry()
+{
+    TelemetryMessage message;
+    while (uplink_is_connected() && hal_queue_receive(summary_queue, &message, 0))
+    {
+        const StreamSummary &summary = message.summary;
+        char topic[64];
+        char payload[160];
+        snprintf(topic, sizeof(topic), "%s/%s/%s", TOPIC_TELEMETRY_STATS, channel_names[message.channel],
+                 window_names[message.window]);
+        snprintf(payload, sizeof(payload),
+                 "{\"n\":%lu,\"min\":%.2f,\"max\":%.2f,\"mean\":%.2f,\"sd\":%.2f,\"p50\":%.2f,\"p95\":%.2f}",
+                 (unsigned long)summary.count, summary.min, summary.max, summary.mean, summary.stddev, summary.median,
+                 summary.p95);
+        if (!uplink_publish(topic, payload))
+        {
+            ESP_LOGW(TELEMETRY_TAG, "Failed to publish %s", topic);
+        }
+    }
+}
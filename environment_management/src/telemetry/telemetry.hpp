@@ -0,0 +1,52 @@
+#pragma once
+
+#include "hal/hal.hpp"
+#include "stream_stats.hpp"
+
+#define TELEMETRY_QUEUE_LENGTH 32 // Summaries waiting for the broker, newer ones are dropped once full
+#define TOPIC_TELEMETRY_STATS "smarthome/environment/stats" // Followed by /<channel>/<window>
+
+/// Measured quantities.
+enum TelemetryChannel : uint8_t
+{
+    TELEMETRY_TEMPERATURE,       ///< °C.
+    TELEMETRY_HUMIDITY,          ///< %RH.
+    TELEMETRY_PRESSURE,          ///< hPa.
+    TELEMETRY_PRODUCTION_POWER,  ///< mW.
+    TELEMETRY_CONSUMPTION_POWER, ///< mW.
+    TELEMETRY_CHANNELS,
+};
+
+/**
+ * @brief Initializes the statistics of every channel and the summary queue.
+ *
+ * @return true if initialization was successful, false otherwise.
+ */
+bool init_telemetry();
+
+/**
+ * @brief Returns the name of a channel in topics and payloads, e.g. "temperature".
+ */
+const char *telemetry_channel_name(TelemetryChannel channel);
+
+/**
+ * @brief Adds a sample to a channel, from any task.
+ *
+ * Updates the 1 min, 15 min and 1 h windows of the channel in constant
+ * time and queues the summary of every window the sample closes. The
+ * sample also goes to the history (see history_add()).
+ *
+ * @param channel Channel.
+ * @param value Sample.
+ */
+void telemetry_add(TelemetryChannel channel, float value);
+
+/**
+ * @brief Publishes the queued summaries, called from the MQTT task.
+ *
+ * One message per closed window on TOPIC_TELEMETRY_STATS/<channel>/<window>,
+ * e.g. smarthome/environment/stats/temperature/15m with
+ * {"n":9000,"min":21.02,"max":22.61,"mean":21.74,"sd":0.38,"p50":21.71,"p95":22.40}.
+ * Summaries wait in the queue while the broker is unreachable.
+ */
+void publish_telemetry();
@@ -0,0 +1,108 @@
+#include <string.h>
+#include "uplink.hpp"
+
+#define UPLINK_TAG "app_uplink"
+
+#if defined(ARDUINO)
+
+#include "../scheduling/scheduling.hpp" // mqttManager
+
+bool uplink_publish(const char *topic, const char *payload)
+{
+    return mqttManager.publishMessage(topic, payload);
+}
+
+void uplink_subscribe(const char *topic, uplink_message_cb_t callback)
+{
+    mqttManager.registerHandler(topic, [callback](const char *, const char *payload, size_t)
+                                { callback(payload); });
+}
+
+bool uplink_is_connected()
+{
+    return mqttManager.isConnected();
+}
+
+#elif defined(HAL_LINUX)
+
+/* Host fake: connected from the start until the test says otherwise */
+
+#define UPLINK_MAX_SUBSCRIPTIONS 4
+
+struct Subscription
+{
+    const char *topic;
+    uplink_message_cb_t callback;
+};
+
+static Subscription subscriptions[UPLINK_MAX_SUBSCRIPTIONS];
+static int subscription_count = 0;
+static bool connected = true;
+static uplink_fake_publish_hook_t publish_hook = NULL;
+static void *publish_hook_ctx = NULL;
+
+bool uplink_publish(const char *topic, const char *payload)
+{
+    if (!connected)
+    {
+        ESP_LOGW(UPLINK_TAG, "Not connected, cannot publish to %s", topic);
+        return false;
+    }
+    ESP_LOGD(UPLINK_TAG, "Published to %s: %s", topic, payload);
+    if (publish_hook != NULL)
+    {
+        publish_hook(topic, payload, publish_hook_ctx);
+    }
+    return true;
+}
+
+void uplink_subscribe(const char *topic, uplink_message_cb_t callback)
+{
+    for (int i = 0; i < subscription_count; i++)
+    {
+        if (subscriptions[i].callback == callback && strcmp(subscriptions[i].topic, topic) == 0)
+        {
+            return; // Module initialized again, e.g. after a modelled reboot
+        }
+    }
+    if (subscription_count < UPLINK_MAX_SUBSCRIPTIONS)
+    {
+        subscriptions[subscription_count].topic = topic;
+        subscriptions[subscription_count].callback = callback;
+        subscription_count++;
+    }
+}
+
+bool uplink_is_connected()
+{
+    return connected;
+}
+
+void uplink_fake_set_publish_hook(uplink_fake_publish_hook_t hook, void *ctx)
+{
+    publish_hook = hook;
+    publish_hook_ctx = ctx;
+}
+
+void uplink_fake_set_connected(bool state)
+{
+    connected = state;
+}
+
+void uplink_fake_deliver(const char *topic, const char *payload)
+{
+    if (!connected)
+    {
+        ESP_LOGW(UPLINK_TAG, "Not connected, message to %s lost", topic);
+        return;
+    }
+    for (int i = 0; i < subscription_count; i++)
+    {
+        if (strcmp(subscriptions[i].topic, topic) == 0)
+        {
+            subscriptions[i].callback(payload);
+        }
+    }
+}
+
+#endif
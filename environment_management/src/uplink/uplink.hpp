@@ -0,0 +1,70 @@
+#pragma once
+
+/*
+ * Broker side of the modules: publishing and subscribing without
+ * depending on MqttManager, so the modules also build on the host.
+ *
+ * On the target the calls go to the MqttManager of scheduling.cpp, which
+ * keeps the connection. On the host a fake stands in for the broker:
+ * tests observe what is published and deliver messages.
+ */
+
+#include "hal/hal.hpp"
+
+/// Called with the payload of a message received on a subscribed topic, NUL-terminated.
+typedef void (*uplink_message_cb_t)(const char *payload);
+
+/**
+ * @brief Publishes a payload as is, the modules of this node format their own JSON.
+ *
+ * @param topic MQTT topic.
+ * @param payload Payload, "" for an empty message.
+ * @return true if the message was sent, false if not connected.
+ */
+bool uplink_publish(const char *topic, const char *payload);
+
+/**
+ * @brief Subscribes to a topic, also after reconnections.
+ *
+ * @param topic MQTT topic.
+ * @param callback Function receiving the payloads, in the MQTT task.
+ */
+void uplink_subscribe(const char *topic, uplink_message_cb_t callback);
+
+/**
+ * @brief Checks if messages can be published.
+ *
+ * @return true if connected to the broker, false otherwise.
+ */
+bool uplink_is_connected();
+
+#if defined(HAL_LINUX)
+/// Called on every message published by the host fake.
+typedef void (*uplink_fake_publish_hook_t)(const char *topic, const char *payload, void *ctx);
+
+/**
+ * @brief Installs a hook observing published messages (NULL to remove it).
+ *
+ * @param hook Function called on every publish.
+ * @param ctx Argument passed to the hook.
+ */
+void uplink_fake_set_publish_hook(uplink_fake_publish_hook_t hook, void *ctx);
+
+/**
+ * @brief Connects or disconnects the fake broker, connected at start.
+ *
+ * @param connected true to connect, false to model a lost connection.
+ */
+void uplink_fake_set_connected(bool connected);
+
+/**
+ * @brief Delivers a message as if it came from the broker.
+ *
+ * Lost while not connected, like a message that is not retained by the
+ * broker.
+ *
+ * @param topic MQTT topic.
+ * @param payload Message payload.
+ */
+void uplink_fake_deliver(const char *topic, const char *payload);
+#endif
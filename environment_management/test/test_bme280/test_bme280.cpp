@@ -0,0 +1,288 @@
+/*
+ * BME280 driver: the integer compensation against the datasheet
+ * floating-point formulas over -40..85 °C, 300..1100 hPa and 0..100 %RH,
+ * its cost against the reference and against three separate reads
+ * redoing the temperature, then forced reads of a simulated sensor on the
+ * fake bus.
+ */
+
+#include <unity.h>
+#include <math.h>
+#include <stdio.h>
+#include <string.h>
+#include <chrono>
+#include "hal/hal.hpp"
+#include "hal/linux/hal_sim.hpp"
+#include "env_measurement/bme280.hpp"
+#include "env_measurement/bme280_sim.hpp"
+
+#define BME_ADDRESS 0x76    // BME280_I2C_ADDRESS of the target
+#define GRID 400            // Raw values per axis of the accuracy sweep
+#define MAX_T_ERROR 0.01    // °C, the output resolution
+#define MAX_P_ERROR 1.0     // Pa, below the 1.3 Pa RMS noise of the chip at x1
+#define MAX_H_ERROR 0.02    // %RH, below the 0.07 %RH noise of the chip
+#define BENCH_SAMPLES 1000000
+#define READS 60
+
+static uint32_t hash(uint32_t x)
+{
+    x ^= x >> 16;
+    x *= 0x7feb352d;
+    x ^= x >> 15;
+    x *= 0x846ca68b;
+    return x ^ (x >> 16);
+}
+
+/* Datasheet floating-point compensation, the reference of the integer one */
+static void reference_compensate(const Bme280Calibration *c, int32_t adc_t, int32_t adc_p, int32_t adc_h,
+                                 double *celsius, double *pascal, double *percent)
+{
+    double var1 = (adc_t / 16384.0 - c->t1 / 1024.0) * c->t2;
+    double var2 = (adc_t / 131072.0 - c->t1 / 8192.0) * (adc_t / 131072.0 - c->t1 / 8192.0) * c->t3;
+    int32_t t_fine = (int32_t)(var1 + var2);
+    *celsius = (var1 + var2) / 5120.0;
+
+    var1 = t_fine / 2.0 - 64000.0;
+    var2 = var1 * var1 * c->p6 / 32768.0;
+    var2 = var2 + var1 * c->p5 * 2.0;
+    var2 = var2 / 4.0 + c->p4 * 65536.0;
+    var1 = (c->p3 * var1 * var1 / 524288.0 + c->p2 * var1) / 524288.0;
+    var1 = (1.0 + var1 / 32768.0) * c->p1;
+    double p = 1048576.0 - adc_p;
+    p = (p - var2 / 4096.0) * 6250.0 / var1;
+    var1 = c->p9 * p * p / 2147483648.0;
+    var2 = p * c->p8 / 32768.0;
+    *pascal = p + (var1 + var2 + c->p7) / 16.0;
+
+    double h = t_fine - 76800.0;
+    h = (adc_h - (c->h4 * 64.0 + c->h5 / 16384.0 * h)) *
+        (c->h2 / 65536.0 * (1.0 + c->h6 / 67108864.0 * h * (1.0 + c->h3 / 67108864.0 * h)));
+    h = h * (1.0 - c->h1 * h / 524288.0);
+    *percent = h > 100.0 ? 100.0 : h < 0.0 ? 0.0 : h;
+}
+
+static void put_burst(uint8_t burst[BME280_BURST_LENGTH], int32_t adc_t, int32_t adc_p, int32_t adc_h)
+{
+    const int32_t adc[2] = {adc_p, adc_t};
+    for (int i = 0; i < 2; i++)
+    {
+        burst[3 * i] = (uint8_t)(adc[i] >> 12);
+        burst[3 * i + 1] = (uint8_t)(adc[i] >> 4);
+        burst[3 * i + 2] = (uint8_t)(adc[i] << 4);
+    }
+    burst[6] = (uint8_t)(adc_h >> 8);
+    burst[7] = (uint8_t)adc_h;
+}
+
+/* Raw value of a channel at the limit of the operating range, found on the reference */
+static int32_t reference_raw(const Bme280Calibration *c, int channel, int32_t adc_t, double target)
+{
+    int32_t low = 0, high = channel == 2 ? 0xFFFF : 0xFFFFF;
+    while (low < high)
+    {
+        int32_t middle = low + (high - low) / 2;
+        double values[3];
+        reference_compensate(c, channel == 0 ? middle : adc_t, channel == 1 ? middle : 0, channel == 2 ? middle : 0,
+                             &values[0], &values[1], &values[2]);
+        if (channel == 1 ? values[1] > target : values[channel] < target)
+        {
+            low = middle + 1;
+        }
+        else
+        {
+            high = middle;
+        }
+    }
+    return low;
+}
+
+static void bme_climate(void *ctx, uint64_t time_us, float *celsius, float *pascal, float *percent)
+{
+    (void)ctx;
+    float hours = time_us / 3.6e9f;
+    *celsius = 21 + 3 * sinf(2 * (float)M_PI * hours / 24);
+    *pascal = 101300 + 800 * sinf(2 * (float)M_PI * hours / 96);
+    *percent = 45 + 25 * sinf(2 * (float)M_PI * hours / 12);
+}
+
+static double elapsed_ns(std::chrono::steady_clock::time_point start)
+{
+    return std::chrono::duration<double, std::nano>(std::chrono::steady_clock::now() - start).count();
+}
+
+static Bme280 sensor;
+static int32_t t_low, t_high; // Raw temperatures of -40 and 85 °C
+
+void setUp()
+{
+}
+
+void tearDown()
+{
+}
+
+/* Worked example of the datasheet: 25.08 °C, 100653.27 Pa in double (25767237 in Q24.8) */
+static void test_datasheet_example()
+{
+    uint8_t burst[BME280_BURST_LENGTH];
+    Bme280Sample sample;
+    put_burst(burst, 519888, 415148, 0x8000);
+    TEST_ASSERT_TRUE(bme280_compensate(&sensor.calibration, burst, &sample));
+    TEST_ASSERT_EQUAL_INT32(2508, sample.temperature_centi);
+    TEST_ASSERT_UINT32_WITHIN(5, 25767237, sample.pressure_q8); // 0.02 Pa
+    TEST_ASSERT_EQUAL_UINT32(0, sample.humidity_q10);
+}
+
+static void test_against_reference()
+{
+    const Bme280Calibration *c = &sensor.calibration;
+    uint8_t burst[BME280_BURST_LENGTH];
+    Bme280Sample sample;
+    double worst[3] = {0, 0, 0};
+    for (int i = 0; i < GRID; i++)
+    {
+        int32_t adc_t = t_low + (int32_t)((int64_t)(t_high - t_low) * i / (GRID - 1));
+        int32_t p_low = reference_raw(c, 1, adc_t, 110000), p_high = reference_raw(c, 1, adc_t, 30000);
+        int32_t h_low = reference_raw(c, 2, adc_t, 0), h_high = reference_raw(c, 2, adc_t, 100);
+        for (int j = 0; j < GRID; j++)
+        {
+            int32_t adc_p = p_low + (int32_t)((int64_t)(p_high - p_low) * j / (GRID - 1));
+            int32_t adc_h = h_low + (int32_t)((int64_t)(h_high - h_low) * j / (GRID - 1));
+            adc_h += adc_h == 0x8000; // Read as a skipped measurement, like the Bosch driver does
+            double reference[3];
+            reference_compensate(c, adc_t, adc_p, adc_h, &reference[0], &reference[1], &reference[2]);
+            put_burst(burst, adc_t, adc_p, adc_h);
+            bme280_compensate(c, burst, &sample);
+            double errors[3] = {fabs(sample.temperature_centi / 100.0 - reference[0]),
+                                fabs(sample.pressure_q8 / 256.0 - reference[1]),
+                                fabs(sample.humidity_q10 / 1024.0 - reference[2])};
+            for (int k = 0; k < 3; k++)
+            {
+                worst[k] = errors[k] > worst[k] ? errors[k] : worst[k];
+            }
+        }
+    }
+
+    char message[128];
+    snprintf(message, sizeof(message), "%d x %d raw values: worst %.4f °C, %.3f Pa, %.4f %%RH", GRID, GRID, worst[0],
+             worst[1], worst[2]);
+    TEST_MESSAGE(message);
+    TEST_ASSERT_FLOAT_WITHIN(MAX_T_ERROR, 0, worst[0]);
+    TEST_ASSERT_FLOAT_WITHIN(MAX_P_ERROR, 0, worst[1]);
+    TEST_ASSERT_FLOAT_WITHIN(MAX_H_ERROR, 0, worst[2]);
+}
+
+/* Cost on the host CPU, raw values precomputed */
+static void test_compensation_cost()
+{
+    const Bme280Calibration *c = &sensor.calibration;
+    static uint8_t bursts[BENCH_SAMPLES][BME280_BURST_LENGTH];
+    for (uint32_t i = 0; i < BENCH_SAMPLES; i++)
+    {
+        put_burst(bursts[i], t_low + hash(i) % (t_high - t_low), 300000 + hash(i + 1) % 200000, 20000 + hash(i + 2) % 30000);
+    }
+    Bme280Sample sample;
+    double sum = 0;
+    auto start = std::chrono::steady_clock::now();
+    for (uint32_t i = 0; i < BENCH_SAMPLES; i++)
+    {
+        bme280_compensate(c, bursts[i], &sample);
+        sum += sample.temperature_centi + sample.pressure_q8 + sample.humidity_q10;
+    }
+    double once_ns = elapsed_ns(start) / BENCH_SAMPLES;
+
+    start = std::chrono::steady_clock::now();
+    for (uint32_t i = 0; i < BENCH_SAMPLES; i++)
+    {
+        // One read per value, each compensating the temperature again
+        Bme280Sample parts[3];
+        uint8_t skipped[BME280_BURST_LENGTH];
+        for (int k = 0; k < 3; k++)
+        {
+            memcpy(skipped, bursts[i], sizeof(skipped));
+            if (k != 1)
+            {
+                skipped[0] = 0x80, skipped[1] = skipped[2] = 0;
+            }
+            if (k != 2)
+            {
+                skipped[6] = 0x80, skipped[7] = 0;
+            }
+            bme280_compensate(c, skipped, &parts[k]);
+        }
+        sum += parts[0].temperature_centi + parts[1].pressure_q8 + parts[2].humidity_q10;
+    }
+    double separate_ns = elapsed_ns(start) / BENCH_SAMPLES;
+
+    start = std::chrono::steady_clock::now();
+    for (uint32_t i = 0; i < BENCH_SAMPLES; i++)
+    {
+        const uint8_t *b = bursts[i];
+        double reference[3];
+        reference_compensate(c, b[3] << 12 | b[4] << 4 | b[5] >> 4, b[0] << 12 | b[1] << 4 | b[2] >> 4, b[6] << 8 | b[7],
+                             &reference[0], &reference[1], &reference[2]);
+        sum += reference[0] + reference[1] + reference[2];
+    }
+    double reference_ns = elapsed_ns(start) / BENCH_SAMPLES;
+    TEST_ASSERT_TRUE(sum > 0);
+
+    char message[160];
+    snprintf(message, sizeof(message), "%.1f ns for the three values at once, %.1f ns as three reads, %.1f ns in double",
+             once_ns, separate_ns, reference_ns);
+    TEST_MESSAGE(message);
+}
+
+/* Forced reads of the simulated sensor, one a second, each a single conversion */
+static void test_forced_reads()
+{
+    double worst[3] = {0, 0, 0};
+    uint32_t conversions = bme280_sim_conversions(BME_ADDRESS);
+    uint64_t busy_us = 0;
+    for (int i = 0; i < READS; i++)
+    {
+        float climate[3];
+        bme_climate(NULL, hal_micros(), &climate[0], &climate[1], &climate[2]);
+        uint64_t begin_us = hal_micros();
+        Bme280Sample sample;
+        TEST_ASSERT_TRUE(bme280_read_forced(&sensor, &sample));
+        busy_us += hal_micros() - begin_us;
+        double errors[3] = {fabs(sample.temperature_centi / 100.0 - climate[0]),
+                            fabs(sample.pressure_q8 / 256.0 - climate[1]),
+                            fabs(sample.humidity_q10 / 1024.0 - climate[2])};
+        for (int k = 0; k < 3; k++)
+        {
+            worst[k] = errors[k] > worst[k] ? errors[k] : worst[k];
+        }
+        hal_delay_ms(1000);
+    }
+    TEST_ASSERT_EQUAL_UINT32(READS, bme280_sim_conversions(BME_ADDRESS) - conversions);
+
+    char message[160];
+    snprintf(message, sizeof(message), "%d reads, %.2f ms each (conversion %.2f ms at most), worst %.4f °C, %.3f Pa, "
+             "%.4f %%RH off the climate",
+             READS, busy_us / 1e3 / READS, bme280_measurement_us() / 1e3, worst[0], worst[1], worst[2]);
+    TEST_MESSAGE(message);
+    TEST_ASSERT_FLOAT_WITHIN(MAX_T_ERROR, 0, worst[0]);
+    TEST_ASSERT_FLOAT_WITHIN(MAX_P_ERROR, 0, worst[1]);
+    TEST_ASSERT_FLOAT_WITHIN(MAX_H_ERROR, 0, worst[2]);
+}
+
+int main()
+{
+    hal_sim_begin();
+    bme280_sim_attach(BME_ADDRESS, bme_climate, NULL);
+    hal_i2c_begin(21, 22, 400000);
+    if (!bme280_init(&sensor, BME_ADDRESS))
+    {
+        return 1;
+    }
+    t_low = reference_raw(&sensor.calibration, 0, 0, -40);
+    t_high = reference_raw(&sensor.calibration, 0, 0, 85);
+
+    UNITY_BEGIN();
+    RUN_TEST(test_datasheet_example);
+    RUN_TEST(test_against_reference);
+    RUN_TEST(test_compensation_cost);
+    RUN_TEST(test_forced_reads);
+    return UNITY_END();
+}
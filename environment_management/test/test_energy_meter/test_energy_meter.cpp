@@ -0,0 +1,234 @@
+/*
+ * Energy integration of both INA219s against simulated monitors fed with
+ * synthetic load profiles. Each profile runs for an hour of virtual time,
+ * sampled and integrated the same way as handle_energy_monitor(), and the
+ * integrated energy and charge are compared with the exact integral of
+ * the profile. The production monitor sees a solar panel throughout.
+ */
+
+#include <unity.h>
+#include <math.h>
+#include <stdio.h>
+#include "hal/hal.hpp"
+#include "hal/linux/hal_sim.hpp"
+#include "energy_monitor/energy_meter.hpp"
+#include "energy_monitor/ina219.hpp"
+#include "energy_monitor/ina219_sim.hpp"
+
+#define PRODUCTION_ADDRESS 0x45 // INA219_PRODUCTION_ADDRESS of the target
+#define CONSUMPTION_ADDRESS 0x41
+#define SAMPLE_MS 100           // ENERGY_MONITOR_EVENT_FREQUENCY of the target
+#define PROFILE_MS 3600000
+#define EXACT_STEP_US 100       // Step of the reference integral
+#define MAX_ERROR_PERCENT 1.0
+
+typedef void (*load_t)(uint64_t time_us, uint16_t *bus_mv, int32_t *current_ua);
+
+static uint32_t hash(uint32_t x)
+{
+    x ^= x >> 16;
+    x *= 0x7feb352d;
+    x ^= x >> 15;
+    x *= 0x846ca68b;
+    return x ^ (x >> 16);
+}
+
+static void constant_load(uint64_t, uint16_t *bus_mv, int32_t *current_ua)
+{
+    *bus_mv = 12000;
+    *current_ua = 850000;
+}
+
+/* Heater switched by a slow PWM: 2 A for 300 ms of every second, the supply sagging under load */
+static void heater_load(uint64_t time_us, uint16_t *bus_mv, int32_t *current_ua)
+{
+    bool on = time_us % 1000000 < 300000;
+    *bus_mv = on ? 11800 : 12100;
+    *current_ua = on ? 2000000 : 15000;
+}
+
+/* LED strip dimmed at 1 kHz, 40% duty: far faster than the sampling, averaged by the chip */
+static void dimmer_load(uint64_t time_us, uint16_t *bus_mv, int32_t *current_ua)
+{
+    bool on = time_us % 1000 < 400;
+    *bus_mv = 5000;
+    *current_ua = on ? 1500000 : 0;
+}
+
+/* Motor started at random: 40 ms inrush at 2.8 A, 900 mA for a few seconds, standby in between */
+static void motor_load(uint64_t time_us, uint16_t *bus_mv, int32_t *current_ua)
+{
+    uint32_t slot = (uint32_t)(time_us / 10000000); // A start every 10 s slot, at a random point
+    uint64_t offset_us = time_us % 10000000;
+    uint32_t h = hash(slot);
+    uint64_t start_us = h % 5000000;
+    uint64_t run_us = 1000000 + (h >> 8) % 4000000;
+    *bus_mv = 12000;
+    if (offset_us < start_us || offset_us >= start_us + run_us)
+    {
+        *current_ua = 60000;
+    }
+    else
+    {
+        *current_ua = offset_us - start_us < 40000 ? 2800000 : 900000;
+        *bus_mv = offset_us - start_us < 40000 ? 11500 : 11900;
+    }
+}
+
+/* Solar panel over a compressed day: half a sine, with clouds passing */
+static void solar_load(uint64_t time_us, uint16_t *bus_mv, int32_t *current_ua)
+{
+    double day = sin(M_PI * (double)(time_us % (PROFILE_MS * 1000ULL)) / (PROFILE_MS * 1000.0));
+    bool cloud = hash((uint32_t)(time_us / 30000000)) % 4 == 0;
+    *bus_mv = 13500;
+    *current_ua = (int32_t)(1200000 * day * (cloud ? 0.3 : 1.0));
+}
+
+static load_t volatile consumption = constant_load;
+static uint64_t profile_start_us = 0;
+
+static void production_sim(void *, uint64_t time_us, uint16_t *bus_mv, int32_t *current_ua)
+{
+    solar_load(time_us - profile_start_us, bus_mv, current_ua);
+}
+
+static void consumption_sim(void *, uint64_t time_us, uint16_t *bus_mv, int32_t *current_ua)
+{
+    consumption(time_us - profile_start_us, bus_mv, current_ua);
+}
+
+/* Reference energy (uWh) and charge (uAh) of a load over the profile, by fine rectangles */
+static void exact_integral(load_t load, double *uwh, double *uah)
+{
+    double uw_us = 0, ua_us = 0;
+    for (uint64_t t = EXACT_STEP_US / 2; t < PROFILE_MS * 1000ULL; t += EXACT_STEP_US)
+    {
+        uint16_t mv;
+        int32_t ua;
+        load(t, &mv, &ua);
+        uw_us += (double)mv * ua / 1000 * EXACT_STEP_US;
+        ua_us += (double)ua * EXACT_STEP_US;
+    }
+    *uwh = uw_us / 3.6e9;
+    *uah = ua_us / 3.6e9;
+}
+
+static double error_percent(double measured, double exact)
+{
+    return exact > 0 ? 100.0 * (measured - exact) / exact : 0;
+}
+
+static void check_channel(const char *name, EnergyMeter *meter, load_t load)
+{
+    double exact_uwh, exact_uah;
+    exact_integral(load, &exact_uwh, &exact_uah);
+    EnergySummary summary;
+    energy_meter_summary(meter, &summary);
+    double energy_error = error_percent((double)summary.totals.uwh, exact_uwh);
+    double charge_error = error_percent((double)summary.totals.uah, exact_uah);
+
+    char message[160];
+    snprintf(message, sizeof(message), "%-11s %9.3f Wh (exact %9.3f, %+.3f%%), %9.1f mAh (exact %9.1f, %+.3f%%), peak %lu mW",
+             name, summary.totals.uwh / 1e6, exact_uwh / 1e6, energy_error, summary.totals.uah / 1e3, exact_uah / 1e3,
+             charge_error, (unsigned long)summary.peak_mw);
+    TEST_MESSAGE(message);
+    TEST_ASSERT_FLOAT_WITHIN(MAX_ERROR_PERCENT, 0, energy_error);
+    TEST_ASSERT_FLOAT_WITHIN(MAX_ERROR_PERCENT, 0, charge_error);
+    TEST_ASSERT_EQUAL_UINT32(0, summary.gap_ms);
+}
+
+/* Same sampling as handle_energy_monitor(), for an hour of one consumption profile */
+static void run_profile(load_t load)
+{
+    consumption = load;
+    profile_start_us = hal_sim_now_us();
+    Ina219 monitors[2];
+    EnergyMeter meters[2];
+    for (int c = 0; c < 2; c++)
+    {
+        TEST_ASSERT_TRUE(ina219_init(&monitors[c], c == 0 ? PRODUCTION_ADDRESS : CONSUMPTION_ADDRESS));
+        energy_meter_init(&meters[c], NULL);
+    }
+
+    while (hal_sim_now_us() - profile_start_us <= PROFILE_MS * 1000ULL)
+    {
+        for (int c = 0; c < 2; c++)
+        {
+            Ina219Sample sample;
+            if (ina219_read(&monitors[c], &sample) && !sample.overflow)
+            {
+                energy_meter_add(&meters[c], hal_millis(), sample.bus_mv, sample.current_ua);
+            }
+            else
+            {
+                energy_meter_break(&meters[c]);
+            }
+        }
+        hal_delay_ms(SAMPLE_MS);
+    }
+
+    check_channel("production", &meters[0], solar_load);
+    check_channel("consumption", &meters[1], load);
+}
+
+void setUp()
+{
+}
+
+void tearDown()
+{
+}
+
+static void test_constant()
+{
+    run_profile(constant_load);
+}
+
+static void test_heater_pwm()
+{
+    run_profile(heater_load);
+}
+
+static void test_dimmer_pwm()
+{
+    run_profile(dimmer_load);
+}
+
+static void test_motor_starts()
+{
+    run_profile(motor_load);
+}
+
+/* A sample missing for longer than ENERGY_MAX_GAP_MS, or a failed read, is not integrated */
+static void test_gaps()
+{
+    EnergyMeter meter;
+    energy_meter_init(&meter, NULL);
+    energy_meter_add(&meter, 0, 10000, 1000000);
+    energy_meter_add(&meter, 1000, 10000, 1000000);
+    energy_meter_add(&meter, 1000 + ENERGY_MAX_GAP_MS + 1, 10000, 1000000);
+    energy_meter_break(&meter);
+    energy_meter_add(&meter, 2 * ENERGY_MAX_GAP_MS, 10000, 1000000);
+
+    EnergySummary summary;
+    energy_meter_summary(&meter, &summary);
+    TEST_ASSERT_EQUAL_UINT32(1000, summary.period_ms);
+    TEST_ASSERT_EQUAL_UINT32(2 * ENERGY_MAX_GAP_MS - 1000, summary.gap_ms);
+    TEST_ASSERT_EQUAL_UINT32(10000, summary.average_mw);
+}
+
+int main()
+{
+    hal_sim_begin();
+    ina219_sim_attach(PRODUCTION_ADDRESS, production_sim, NULL);
+    ina219_sim_attach(CONSUMPTION_ADDRESS, consumption_sim, NULL);
+    hal_i2c_begin(21, 22, 400000);
+
+    UNITY_BEGIN();
+    RUN_TEST(test_constant);
+    RUN_TEST(test_heater_pwm);
+    RUN_TEST(test_dimmer_pwm);
+    RUN_TEST(test_motor_starts);
+    RUN_TEST(test_gaps);
+    return UNITY_END();
+}
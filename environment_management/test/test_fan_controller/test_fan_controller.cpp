@@ -0,0 +1,168 @@
+/*
+ * Fan controllers on a day of a room model, stepped every second like
+ * handle_fan_control() and started an hour before millis() wraps. Each
+ * room runs once per mode: the relay must respect its minimum on and off
+ * times and the value must stay close to the setpoint while the fan can
+ * hold it.
+ */
+
+#include <unity.h>
+#include <math.h>
+#include <stdio.h>
+#include "fan_control/fan_control.hpp"
+
+#define DAY_S 86400
+#define START_MS (0xFFFFFFFFUL - 3600000) // millis() wraps an hour in
+
+/// Room around a fan, first order: the fan exchanges air with the outside.
+struct Room
+{
+    const char *name;
+    float outside, swing;  // Outside value and its daily amplitude
+    float rise, occupied;  // Rise inside with the fan off, more from 9 to 17 h
+    float walls_s, fan_s;  // Time constants towards outside through the walls and the fan
+    float noise;           // Sensor noise, standard deviation
+    float max_rms[2];      // Limit of the deviation from the setpoint, hysteresis and PI
+    FanControlConfig config;
+};
+
+static const Room rooms[] = {
+    {"temperature", 20, 6, 8, 4, 10800, 900, 0.02f, {0.6f, 0.7f},
+     {FAN_MODE_HYSTERESIS, FAN_1_SETPOINT, FAN_1_BAND, FAN_1_KP, FAN_1_TI_S, FAN_PI_PERIOD_MS, FAN_MIN_ON_MS,
+      FAN_MIN_OFF_MS}},
+    {"humidity", 55, 10, 15, 10, 7200, 600, 0.1f, {2.0f, 1.0f},
+     {FAN_MODE_HYSTERESIS, FAN_2_SETPOINT, FAN_2_BAND, FAN_2_KP, FAN_2_TI_S, FAN_PI_PERIOD_MS, FAN_MIN_ON_MS,
+      FAN_MIN_OFF_MS}},
+};
+
+static uint32_t hash(uint32_t x)
+{
+    x ^= x >> 16;
+    x *= 0x7feb352d;
+    x ^= x >> 15;
+    x *= 0x846ca68b;
+    return x ^ (x >> 16);
+}
+
+/* Approximately normal noise from the sum of uniforms, deterministic in the time */
+static float noise(uint32_t time_ms)
+{
+    float sum = 0;
+    for (uint32_t i = 0; i < 4; i++)
+    {
+        sum += (hash(time_ms * 4 + i) & 0xffff) / 65536.0f;
+    }
+    return (sum - 2) * 1.73f; // Unit variance
+}
+
+/*
+ * The deviation from the setpoint only counts while the fan can hold it:
+ * running all the time would bring the room below it and never running
+ * would leave it above.
+ */
+static void run_day(const Room *room, FanMode mode)
+{
+    FanControlConfig config = room->config;
+    config.mode = mode;
+    FanController controller;
+    fan_controller_init(&controller, &config, START_MS);
+
+    float value = room->outside + room->rise; // Settled with the fan off
+    uint32_t hour_switches = 0, max_hour_switches = 0, runs[2] = {0xFFFFFFFF, 0xFFFFFFFF};
+    uint32_t run_start_s = 0, on_s = 0, controlled_s = 0;
+    double square_sum = 0;
+    bool on = false, first_run = true;
+    for (uint32_t t = 0; t < DAY_S; t++)
+    {
+        float hour = t / 3600.0f;
+        float outside = room->outside - room->swing * cosf(2 * (float)M_PI * hour / 24); // Lowest at midnight
+        float inside = outside + room->rise + (hour >= 9 && hour < 17 ? room->occupied : 0);
+        value += (inside - value) / room->walls_s - (on ? (value - outside) / room->fan_s : 0);
+
+        bool next = fan_controller_update(&controller, value + room->noise * noise(t * 1000), START_MS + t * 1000);
+        if (next != on)
+        {
+            if (!first_run) // The first run started with the simulation
+            {
+                uint32_t length_s = t - run_start_s;
+                runs[on] = length_s < runs[on] ? length_s : runs[on];
+            }
+            first_run = false;
+            run_start_s = t;
+            hour_switches++;
+            on = next;
+        }
+        on_s += on;
+        if (t % 3600 == 3599)
+        {
+            max_hour_switches = hour_switches > max_hour_switches ? hour_switches : max_hour_switches;
+            hour_switches = 0;
+        }
+
+        float fan_floor = outside + (inside - outside) * room->fan_s / (room->walls_s + room->fan_s);
+        if (fan_floor < config.setpoint && inside > config.setpoint)
+        {
+            square_sum += (double)(value - config.setpoint) * (value - config.setpoint);
+            controlled_s++;
+        }
+    }
+
+    double rms = controlled_s > 0 ? sqrt(square_sum / controlled_s) : 0;
+    uint32_t max_switches = (uint32_t)(2 * 3600000ULL / (config.min_on_ms + config.min_off_ms));
+    if (mode == FAN_MODE_PI)
+    {
+        uint32_t window_switches = (uint32_t)(2 * 3600000ULL / config.period_ms);
+        max_switches = window_switches < max_switches ? window_switches : max_switches;
+    }
+
+    char message[192];
+    snprintf(message, sizeof(message), "%-11s %-10s %3lu switches a day, %2lu in the worst hour (limit %2lu), shortest run "
+             "%3lu s on %4lu s off, on %4.1f h, %.2f rms off the setpoint over %4.1f h",
+             room->name, mode == FAN_MODE_PI ? "PI" : "hysteresis", (unsigned long)controller.switches,
+             (unsigned long)max_hour_switches, (unsigned long)max_switches, (unsigned long)runs[1], (unsigned long)runs[0],
+             on_s / 3600.0, rms, controlled_s / 3600.0);
+    TEST_MESSAGE(message);
+    TEST_ASSERT_GREATER_THAN_UINT32(0, controller.switches);
+    TEST_ASSERT_LESS_OR_EQUAL_UINT32(max_switches, max_hour_switches);
+    TEST_ASSERT_GREATER_OR_EQUAL_UINT32(config.min_on_ms, runs[1] * 1000);
+    TEST_ASSERT_GREATER_OR_EQUAL_UINT32(config.min_off_ms, runs[0] * 1000);
+    TEST_ASSERT_FLOAT_WITHIN(room->max_rms[mode], 0, rms);
+}
+
+void setUp()
+{
+}
+
+void tearDown()
+{
+}
+
+static void test_temperature_hysteresis()
+{
+    run_day(&rooms[0], FAN_MODE_HYSTERESIS);
+}
+
+static void test_temperature_pi()
+{
+    run_day(&rooms[0], FAN_MODE_PI);
+}
+
+static void test_humidity_hysteresis()
+{
+    run_day(&rooms[1], FAN_MODE_HYSTERESIS);
+}
+
+static void test_humidity_pi()
+{
+    run_day(&rooms[1], FAN_MODE_PI);
+}
+
+int main()
+{
+    UNITY_BEGIN();
+    RUN_TEST(test_temperature_hysteresis);
+    RUN_TEST(test_temperature_pi);
+    RUN_TEST(test_humidity_hysteresis);
+    RUN_TEST(test_humidity_pi);
+    return UNITY_END();
+}
@@ -0,0 +1,403 @@
+/*
+ * Sensor history: a day of BME280-like readings and an hour of INA219
+ * readings are compressed raw and as the 10 s means the history records,
+ * and have to decode exactly. Then a month of every channel is recorded
+ * into a fake history partition, more than it holds, and downsampling
+ * queries are answered from it.
+ */
+
+#include <unity.h>
+#include <math.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <chrono>
+#include "hal/hal.hpp"
+#include "hal/linux/hal_fake.hpp"
+#include "hal/linux/hal_sim.hpp"
+#include "energy_monitor/ina219.hpp"
+#include "energy_monitor/ina219_sim.hpp"
+#include "history/history_ring.hpp"
+#include "history/series_codec.hpp"
+
+#define CONSUMPTION_ADDRESS 0x41           // INA219_CONSUMPTION_ADDRESS of the target
+#define SAMPLE_MS 100                      // ENERGY_MONITOR_EVENT_FREQUENCY of the target
+#define INA219_TRACE_MS 3600000
+#define HISTORY_START_MS 1718000000000ULL  // Unix time of the first history sample
+#define PERIOD_MS 10000                    // HISTORY_PERIOD_MS of the target
+#define PARTITION_SIZE 0x100000            // history partition of partitions.csv
+#define QUERY_SLOTS 1024                   // HISTORY_QUERY_SLOTS of the target
+#define DAYS 30
+#define MIN_DAYS 7                          // Of every channel in the partition
+#define MAX_BLOCKS 4096
+#define DAY_STEP_PERIODS 6                 // One minute
+#define DAY_STEPS 1440
+#define PERIODS (DAYS * 86400 / (PERIOD_MS / 1000))
+
+/// Channel of the history and the readings it is fed with.
+struct Trace
+{
+    const char *name;
+    float (*sample)(uint32_t second);
+    uint8_t channel;        // TelemetryChannel of the target
+    int8_t resolution_log2; // As in history.cpp
+};
+
+static uint32_t hash(uint32_t x)
+{
+    x ^= x >> 16;
+    x *= 0x7feb352d;
+    x ^= x >> 15;
+    x *= 0x846ca68b;
+    return x ^ (x >> 16);
+}
+
+/* Approximately normal noise from the sum of uniforms, deterministic in the time */
+static float noise(uint32_t time)
+{
+    float sum = 0;
+    for (uint32_t i = 0; i < 4; i++)
+    {
+        sum += (hash(time * 4 + i) & 0xffff) / 65536.0f;
+    }
+    return (sum - 2) * 1.73f; // Unit variance
+}
+
+/* A day of BME280 outputs every second, rounded like the compensated
+ * values of the chip (0.01 °C, 1/1024 %RH, 1/256 Pa) */
+static float bme_temperature(uint32_t second)
+{
+    float t = 21.5f + 1.5f * sinf(2 * (float)M_PI * (second % 86400) / 86400.0f) + 0.03f * noise(second);
+    return roundf(t * 100) / 100;
+}
+
+static float bme_humidity(uint32_t second)
+{
+    float h = 45 - 6 * sinf(2 * (float)M_PI * (second % 86400) / 86400.0f) + 0.2f * noise(second + 7);
+    return roundf(h * 1024) / 1024;
+}
+
+static float bme_pressure(uint32_t second)
+{
+    float pa = 101300 + 300 * sinf(2 * (float)M_PI * second / 345600.0f) + 2 * noise(second + 13);
+    return roundf(pa * 256) / 256 / 100; // hPa
+}
+
+/* Motor started at random: 40 ms inrush at 2.8 A, 900 mA for a few seconds, standby in between */
+static void motor_load(void *, uint64_t time_us, uint16_t *bus_mv, int32_t *current_ua)
+{
+    uint32_t slot = (uint32_t)(time_us / 10000000); // A start every 10 s slot, at a random point
+    uint64_t offset_us = time_us % 10000000;
+    uint32_t h = hash(slot);
+    uint64_t start_us = h % 5000000;
+    uint64_t run_us = 1000000 + (h >> 8) % 4000000;
+    *bus_mv = 12000;
+    if (offset_us < start_us || offset_us >= start_us + run_us)
+    {
+        *current_ua = 60000;
+    }
+    else
+    {
+        *current_ua = offset_us - start_us < 40000 ? 2800000 : 900000;
+        *bus_mv = offset_us - start_us < 40000 ? 11500 : 11900;
+    }
+}
+
+static float ina219_trace[INA219_TRACE_MS / SAMPLE_MS]; // mW, read through the driver
+#define INA219_SAMPLES (sizeof(ina219_trace) / sizeof(ina219_trace[0]))
+
+static float ina219_power(uint32_t second)
+{
+    return ina219_trace[(second * 10) % INA219_SAMPLES];
+}
+
+static const Trace traces[] = {
+    {"temperature", bme_temperature, 0, -7},
+    {"humidity", bme_humidity, 1, -6},
+    {"pressure", bme_pressure, 2, -6},
+    {"power", ina219_power, 4, 0},
+};
+
+/* Consumption monitor on the motor, sampled like handle_energy_monitor() */
+static bool record_ina219_trace()
+{
+    Ina219 monitor;
+    if (!ina219_init(&monitor, CONSUMPTION_ADDRESS))
+    {
+        return false;
+    }
+    for (uint32_t i = 0; i < INA219_SAMPLES; i++)
+    {
+        Ina219Sample sample;
+        ina219_read(&monitor, &sample);
+        ina219_trace[i] = (float)sample.bus_mv * sample.current_ua / 1e6f;
+        hal_delay_ms(SAMPLE_MS);
+    }
+    return true;
+}
+
+/* History sample: mean of the readings of a PERIOD_MS period, rounded */
+static float period_sample(const Trace *trace, uint32_t period)
+{
+    bool power = trace->resolution_log2 == 0;
+    uint32_t readings = power ? PERIOD_MS / SAMPLE_MS : PERIOD_MS / 1000;
+    double sum = 0;
+    for (uint32_t i = 0; i < readings; i++)
+    {
+        sum += power ? ina219_trace[(period * readings + i) % INA219_SAMPLES] : trace->sample(period * readings + i);
+    }
+    return series_quantize((float)(sum / readings), trace->resolution_log2);
+}
+
+static double elapsed_ns(std::chrono::steady_clock::time_point start)
+{
+    return std::chrono::duration<double, std::nano>(std::chrono::steady_clock::now() - start).count();
+}
+
+static HistoryBlock blocks[MAX_BLOCKS];
+
+/*
+ * Compresses a series into blocks as the history does, checks that it
+ * decodes exactly and returns the bits per sample. Timestamps of the 1 s
+ * BME280 readings jitter by up to 3 ms, like the task loop.
+ */
+static double check_codec(const char *name, const float *values, uint32_t count, uint32_t period_ms, bool jitter)
+{
+    HistoryBlock *block = blocks;
+    SeriesEncoder encoder;
+    history_block_start(block, &encoder, 0);
+    auto start = std::chrono::steady_clock::now();
+    for (uint32_t i = 0; i < count; i++)
+    {
+        uint64_t time_ms = HISTORY_START_MS + (uint64_t)i * period_ms + (jitter ? hash(i) % 4 : 0);
+        if (!history_block_add(block, &encoder, time_ms, values[i]))
+        {
+            block++;
+            TEST_ASSERT_TRUE(block < blocks + MAX_BLOCKS);
+            history_block_start(block, &encoder, 0);
+            history_block_add(block, &encoder, time_ms, values[i]);
+        }
+    }
+    double append_ns = elapsed_ns(start);
+    uint32_t block_count = block - blocks + 1;
+
+    uint64_t bits = 0;
+    uint32_t decoded = 0;
+    start = std::chrono::steady_clock::now();
+    for (uint32_t b = 0; b < block_count; b++)
+    {
+        SeriesDecoder decoder;
+        series_decoder_init(&decoder, blocks[b].data, blocks[b].bits, blocks[b].count, blocks[b].first_ms);
+        uint64_t time_ms;
+        float value;
+        while (series_decoder_next(&decoder, &time_ms, &value))
+        {
+            TEST_ASSERT_LESS_THAN_UINT32(count, decoded);
+            uint64_t expected_ms = HISTORY_START_MS + (uint64_t)decoded * period_ms + (jitter ? hash(decoded) % 4 : 0);
+            TEST_ASSERT_TRUE(time_ms == expected_ms);
+            TEST_ASSERT_EQUAL_MEMORY(&values[decoded], &value, sizeof(float));
+            decoded++;
+        }
+        bits += blocks[b].bits;
+    }
+    double decode_ns = elapsed_ns(start);
+    TEST_ASSERT_EQUAL_UINT32(count, decoded);
+
+    double bits_per_sample = (double)block_count * HISTORY_BLOCK_SIZE * 8 / count;
+    char message[192];
+    snprintf(message, sizeof(message),
+             "%-16s %6lu samples in %4lu blocks, %5.1f bits per sample (%4.1f in the series), %4.1f:1 against 12 B, "
+             "append %4.0f ns, decode %4.0f ns per sample",
+             name, (unsigned long)count, (unsigned long)block_count, bits_per_sample, (double)bits / count,
+             96 / bits_per_sample, append_ns / count, decode_ns / count);
+    TEST_MESSAGE(message);
+    return bits_per_sample;
+}
+
+/* Raw readings and 10 s history samples of a day of one trace, returns the bytes per day */
+static double check_trace(const Trace *trace)
+{
+    static float values[86400];
+    bool power = trace->resolution_log2 == 0;
+    uint32_t raw_count = power ? INA219_SAMPLES : 86400;
+    for (uint32_t i = 0; i < raw_count; i++)
+    {
+        values[i] = power ? ina219_trace[i] : trace->sample(i);
+    }
+    char name[32];
+    snprintf(name, sizeof(name), "%s raw", trace->name);
+    check_codec(name, values, raw_count, power ? SAMPLE_MS : 1000, !power);
+
+    const uint32_t day_periods = 86400 / (PERIOD_MS / 1000);
+    for (uint32_t p = 0; p < day_periods; p++)
+    {
+        values[p] = period_sample(trace, p);
+    }
+    snprintf(name, sizeof(name), "%s 10 s", trace->name);
+    return check_codec(name, values, day_periods, PERIOD_MS, false) * day_periods / 8;
+}
+
+static HistoryRing ring;
+static HistoryBlock open_blocks[4];
+static double day_bytes[4]; // Of the 10 s samples of each trace
+
+void setUp()
+{
+}
+
+void tearDown()
+{
+}
+
+static void test_codec_temperature()
+{
+    day_bytes[0] = check_trace(&traces[0]);
+}
+
+static void test_codec_humidity()
+{
+    day_bytes[1] = check_trace(&traces[1]);
+}
+
+static void test_codec_pressure()
+{
+    day_bytes[2] = check_trace(&traces[2]);
+}
+
+static void test_codec_power()
+{
+    day_bytes[3] = check_trace(&traces[3]);
+}
+
+/* A day of the 5 channels, production and consumption power alike */
+static void test_partition_days()
+{
+    double total = day_bytes[0] + day_bytes[1] + day_bytes[2] + 2 * day_bytes[3];
+    char message[96];
+    snprintf(message, sizeof(message), "%.0f B per day for the 5 channels, %.0f days in a %lu KiB partition", total,
+             PARTITION_SIZE / total, (unsigned long)(PARTITION_SIZE / 1024));
+    TEST_MESSAGE(message);
+    TEST_ASSERT_GREATER_OR_EQUAL_UINT32(MIN_DAYS, (uint32_t)(PARTITION_SIZE / total));
+}
+
+/* A month of every channel, more than the partition holds */
+static void test_record_month()
+{
+    hal_fake_flash_add_partition("history", PARTITION_SIZE, NULL);
+    TEST_ASSERT_TRUE(history_ring_open(&ring, hal_partition_find("history")));
+
+    SeriesEncoder encoders[4];
+    for (int c = 0; c < 4; c++)
+    {
+        history_block_start(&open_blocks[c], &encoders[c], traces[c].channel);
+    }
+    auto start = std::chrono::steady_clock::now();
+    for (uint32_t p = 0; p < PERIODS; p++)
+    {
+        uint64_t time_ms = HISTORY_START_MS + (uint64_t)p * PERIOD_MS;
+        for (int c = 0; c < 4; c++)
+        {
+            float value = period_sample(&traces[c], p);
+            if (!history_block_add(&open_blocks[c], &encoders[c], time_ms, value))
+            {
+                TEST_ASSERT_TRUE(history_ring_append(&ring, &open_blocks[c]));
+                history_block_start(&open_blocks[c], &encoders[c], traces[c].channel);
+                history_block_add(&open_blocks[c], &encoders[c], time_ms, value);
+            }
+        }
+    }
+    double record_ns = elapsed_ns(start);
+
+    char message[128];
+    snprintf(message, sizeof(message), "%d days of 4 channels in %.0f ns per sample (averaging included), %lu sector erases at most",
+             DAYS, record_ns / PERIODS / 4, (unsigned long)hal_fake_flash_max_erases("history"));
+    TEST_MESSAGE(message);
+}
+
+/* Last day of temperature by minute, checked against the means of the same samples */
+static void test_query_last_day()
+{
+    const uint32_t first_period = PERIODS - DAY_STEPS * DAY_STEP_PERIODS;
+    static float values[DAY_STEPS];
+    HistoryQuery query;
+    history_query_start(&ring, &query, traces[0].channel, HISTORY_START_MS + (uint64_t)first_period * PERIOD_MS,
+                        HISTORY_START_MS + (uint64_t)PERIODS * PERIOD_MS - 1, DAY_STEP_PERIODS * PERIOD_MS);
+    uint32_t calls = 0;
+    size_t answered = 0;
+    auto start = std::chrono::steady_clock::now();
+    while (!query.done && calls < 10000)
+    {
+        answered += history_query_next(&ring, &query, &open_blocks[0], values + answered, DAY_STEPS - answered, QUERY_SLOTS);
+        calls++;
+    }
+    double day_ns = elapsed_ns(start);
+    TEST_ASSERT_EQUAL_UINT(DAY_STEPS, answered);
+
+    for (uint32_t s = 0; s < DAY_STEPS; s++)
+    {
+        double sum = 0;
+        for (uint32_t i = 0; i < DAY_STEP_PERIODS; i++)
+        {
+            sum += period_sample(&traces[0], first_period + s * DAY_STEP_PERIODS + i);
+        }
+        TEST_ASSERT_EQUAL_FLOAT((float)(sum / DAY_STEP_PERIODS), values[s]);
+    }
+
+    char message[96];
+    snprintf(message, sizeof(message), "last day by minute in %lu calls, %lu blocks, %.2f ms", (unsigned long)calls,
+             (unsigned long)query.blocks_read, day_ns / 1e6);
+    TEST_MESSAGE(message);
+}
+
+/* The whole month by hour: the oldest steps were overwritten, the newest are there, and
+ * as many days are kept as the 4 recorded channels fit, less the sector being erased */
+static void test_query_month()
+{
+    static float hours[DAYS * 24];
+    HistoryQuery query;
+    history_query_start(&ring, &query, traces[0].channel, HISTORY_START_MS,
+                        HISTORY_START_MS + (uint64_t)PERIODS * PERIOD_MS - 1, 3600000);
+    size_t answered = 0;
+    auto start = std::chrono::steady_clock::now();
+    while (!query.done)
+    {
+        answered += history_query_next(&ring, &query, &open_blocks[0], hours + answered, DAYS * 24 - answered, QUERY_SLOTS);
+    }
+    double month_ns = elapsed_ns(start);
+    TEST_ASSERT_EQUAL_UINT(DAYS * 24, answered);
+    TEST_ASSERT_TRUE(isnan(hours[0]));
+    TEST_ASSERT_FALSE(isnan(hours[answered - 1]));
+
+    uint32_t kept = 0;
+    for (size_t h = 0; h < answered; h++)
+    {
+        kept += !isnan(hours[h]);
+    }
+    double fit = PARTITION_SIZE / (day_bytes[0] + day_bytes[1] + day_bytes[2] + day_bytes[3]);
+    char message[96];
+    snprintf(message, sizeof(message), "month by hour in %.2f ms, %.1f days kept, %.1f fit", month_ns / 1e6, kept / 24.0, fit);
+    TEST_MESSAGE(message);
+    TEST_ASSERT_TRUE(kept / 24.0 >= fit - 1);
+}
+
+int main()
+{
+    hal_sim_begin();
+    ina219_sim_attach(CONSUMPTION_ADDRESS, motor_load, NULL);
+    hal_i2c_begin(21, 22, 400000);
+    if (!record_ina219_trace())
+    {
+        return 1;
+    }
+
+    UNITY_BEGIN();
+    RUN_TEST(test_codec_temperature);
+    RUN_TEST(test_codec_humidity);
+    RUN_TEST(test_codec_pressure);
+    RUN_TEST(test_codec_power);
+    RUN_TEST(test_partition_days);
+    RUN_TEST(test_record_month);
+    RUN_TEST(test_query_last_day);
+    RUN_TEST(test_query_month);
+    return UNITY_END();
+}
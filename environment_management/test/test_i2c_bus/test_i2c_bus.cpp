@@ -0,0 +1,254 @@
+/*
+ * Shared I2C bus: the INA219 batch every 100 ms and a BME280 burst every
+ * second go through the bus task at its target priority for a minute of
+ * virtual time, with faults injected on the fake bus: the BME280 stretches
+ * the clock past its timeout, an absent device is addressed once and SDA
+ * is held low. Every request must be answered exactly once, the faults
+ * counted as what they are and the stuck bus recovered once.
+ */
+
+#include <unity.h>
+#include <stdio.h>
+#include <string.h>
+#include "hal/hal.hpp"
+#include "hal/linux/hal_fake.hpp"
+#include "hal/linux/hal_sim.hpp"
+#include "i2c_bus/i2c_bus.hpp"
+#include "energy_monitor/ina219.hpp"
+#include "energy_monitor/ina219_sim.hpp"
+#include "env_measurement/bme280.hpp"
+#include "env_measurement/bme280_sim.hpp"
+
+#define PRODUCTION_ADDRESS 0x45 // INA219_PRODUCTION_ADDRESS of the target
+#define CONSUMPTION_ADDRESS 0x41
+#define BME_ADDRESS 0x76        // BME280_I2C_ADDRESS of the target
+#define ABSENT_ADDRESS 0x50
+#define SAMPLE_MS 100           // ENERGY_MONITOR_EVENT_FREQUENCY of the target
+#define BUS_MS 60000
+#define BUS_TASK_PRIORITY 5  // I2C_BUS_TASK_PRIORITY of the target
+#define BME_TIMEOUT_MS 20
+#define STRETCH_MS 20500     // BME280-like device stretches past its timeout from here...
+#define STRETCH_END_MS 23500 // ...to here: 3 bursts and the conversions after them time out
+#define ABSENT_MS 30500
+#define STUCK_MS 40050       // SDA held for 5 clocks, the next transfer fails and the bus is recovered
+
+/// Sensor module on the shared bus, submitting from a timer like its task would.
+struct BusClient
+{
+    const char *name;
+    I2cRequest request;
+    uint64_t submitted_us;
+    uint32_t submitted;
+    uint32_t completed;
+    uint32_t failed_ops;
+    uint64_t total_latency_us;
+    uint64_t max_latency_us;
+    uint8_t rx[I2C_BUS_MAX_OPS][8];
+};
+
+static BusClient ina, burst, missing;
+static uint8_t production, consumption, bme, absent;
+static I2cBusStats stats;
+
+static void monitor_load(void *, uint64_t, uint16_t *bus_mv, int32_t *current_ua)
+{
+    *bus_mv = 12000;
+    *current_ua = 850000;
+}
+
+static void climate(void *, uint64_t, float *celsius, float *pascal, float *percent)
+{
+    *celsius = 21;
+    *pascal = 101300;
+    *percent = 45;
+}
+
+static void completed(void *ctx, uint8_t failed)
+{
+    BusClient *client = (BusClient *)ctx;
+    uint64_t latency_us = hal_micros() - client->submitted_us;
+    client->completed++;
+    client->total_latency_us += latency_us;
+    client->max_latency_us = latency_us > client->max_latency_us ? latency_us : client->max_latency_us;
+    for (uint8_t i = 0; i < client->request.count; i++)
+    {
+        client->failed_ops += (failed >> i) & 1;
+    }
+}
+
+static void submit(void *ctx)
+{
+    BusClient *client = (BusClient *)ctx;
+    client->submitted_us = hal_micros();
+    client->submitted += i2c_bus_submit(&client->request);
+}
+
+static void stretch(void *ctx)
+{
+    hal_fake_i2c_stretch(BME_ADDRESS, ctx != NULL ? (BME_TIMEOUT_MS + 5) * 1000 : 0);
+}
+
+static void stuck(void *ctx)
+{
+    (void)ctx;
+    hal_fake_i2c_hold_sda(5);
+}
+
+static void busTask(void *arg)
+{
+    (void)arg;
+    while (true)
+    {
+        handle_i2c_bus();
+    }
+}
+
+static void add_burst(BusClient *client, uint8_t device, uint8_t reg, uint8_t length)
+{
+    I2cOp &op = client->request.ops[client->request.count];
+    op.device = device;
+    op.tx[0] = reg;
+    op.tx_length = 1;
+    op.rx = client->rx[client->request.count];
+    op.rx_length = length;
+    client->request.count++;
+    client->request.callback = completed;
+    client->request.ctx = client;
+}
+
+/* Runs the minute of traffic, returns false if the bus could not be set up */
+static bool run_bus()
+{
+    if (!init_i2c_bus())
+    {
+        return false;
+    }
+    production = i2c_bus_add_device(PRODUCTION_ADDRESS, 10, "production INA219");
+    consumption = i2c_bus_add_device(CONSUMPTION_ADDRESS, 10, "consumption INA219");
+    bme = i2c_bus_add_device(BME_ADDRESS, BME_TIMEOUT_MS, "BME280");
+    absent = i2c_bus_add_device(ABSENT_ADDRESS, 10, "absent");
+
+    ina.name = "INA219 batch";
+    const uint8_t monitors[2] = {production, consumption};
+    for (uint8_t device : monitors)
+    {
+        add_burst(&ina, device, INA219_REG_BUS, 2);
+        add_burst(&ina, device, INA219_REG_CURRENT, 2);
+    }
+    burst.name = "BME280 burst";
+    add_burst(&burst, bme, BME280_REG_DATA, BME280_BURST_LENGTH); // As handle_env_measurement()
+    I2cOp &convert = burst.request.ops[burst.request.count++];
+    convert.device = bme;
+    convert.tx[0] = BME280_REG_CTRL_MEAS;
+    convert.tx[1] = bme280_forced_ctrl_meas();
+    convert.tx_length = 2;
+    missing.name = "absent device";
+    add_burst(&missing, absent, 0x00, 1);
+
+    if (!hal_task_create(busTask, "i2c_bus", 4096, NULL, BUS_TASK_PRIORITY, NULL, 1))
+    {
+        return false;
+    }
+    uint64_t start_us = hal_sim_now_us();
+    hal_timer_t ina_timer = hal_timer_create("ina219", submit, &ina);
+    hal_timer_t bme_timer = hal_timer_create("bme280", submit, &burst);
+    hal_timer_start_periodic(ina_timer, SAMPLE_MS * 1000ULL);
+    hal_timer_start_periodic(bme_timer, 1000000);
+    hal_sim_at(start_us + STRETCH_MS * 1000ULL, stretch, (void *)1);
+    hal_sim_at(start_us + STRETCH_END_MS * 1000ULL, stretch, NULL);
+    hal_sim_at(start_us + ABSENT_MS * 1000ULL, submit, &missing);
+    hal_sim_at(start_us + STUCK_MS * 1000ULL, stuck, NULL);
+
+    hal_sim_run_until(start_us + BUS_MS * 1000ULL);
+    hal_timer_stop(ina_timer);
+    hal_timer_stop(bme_timer);
+    hal_sim_run_for(1000000); // Requests still queued
+    i2c_bus_get_stats(&stats);
+    return true;
+}
+
+static void check_client(const BusClient *client)
+{
+    char message[128];
+    snprintf(message, sizeof(message), "%-13s %4lu requests, %4lu answered, %lu ops failed, latency mean %.0f us, max %lu us",
+             client->name, (unsigned long)client->submitted, (unsigned long)client->completed,
+             (unsigned long)client->failed_ops, (double)client->total_latency_us / client->completed,
+             (unsigned long)client->max_latency_us);
+    TEST_MESSAGE(message);
+    TEST_ASSERT_GREATER_THAN_UINT32(0, client->submitted);
+    TEST_ASSERT_EQUAL_UINT32(client->submitted, client->completed);
+}
+
+void setUp()
+{
+}
+
+void tearDown()
+{
+}
+
+/* Every request answered exactly once, none refused */
+static void test_every_request_answered()
+{
+    check_client(&ina);
+    check_client(&burst);
+    check_client(&missing);
+    TEST_ASSERT_EQUAL_UINT32(0, stats.queue_full);
+
+    char message[96];
+    snprintf(message, sizeof(message), "bus %.2f%% busy over %.0f s", 100.0 * stats.busy_us / stats.elapsed_us,
+             stats.elapsed_us / 1e6);
+    TEST_MESSAGE(message);
+}
+
+/* 3 bursts and the conversions after them */
+static void test_stretch_times_out()
+{
+    TEST_ASSERT_EQUAL_UINT32(6, stats.device[bme].timeouts);
+    TEST_ASSERT_EQUAL_UINT32(6, stats.device[bme].errors);
+    TEST_ASSERT_EQUAL_UINT32(6, burst.failed_ops);
+}
+
+static void test_absent_device_fails()
+{
+    TEST_ASSERT_EQUAL_UINT32(1, stats.device[absent].errors);
+    TEST_ASSERT_EQUAL_UINT32(0, stats.device[absent].timeouts);
+    TEST_ASSERT_EQUAL_UINT32(1, missing.failed_ops);
+}
+
+/* The transfer caught by the stuck SDA fails, the bus is recovered once */
+static void test_stuck_bus_recovered()
+{
+    TEST_ASSERT_EQUAL_UINT32(1, stats.recoveries);
+    TEST_ASSERT_EQUAL_UINT32(1, ina.failed_ops);
+    TEST_ASSERT_EQUAL_UINT32(1, stats.device[production].errors + stats.device[consumption].errors);
+
+    for (uint8_t d = 0; d < stats.devices; d++)
+    {
+        const I2cDeviceStats &device = stats.device[d];
+        char message[128];
+        snprintf(message, sizeof(message), "%-18s %5lu transfers, %lu errors, %lu timeouts, %.1f us per transfer",
+                 device.name, (unsigned long)device.transfers, (unsigned long)device.errors,
+                 (unsigned long)device.timeouts, (double)device.busy_us / device.transfers);
+        TEST_MESSAGE(message);
+    }
+}
+
+int main()
+{
+    hal_sim_begin();
+    ina219_sim_attach(PRODUCTION_ADDRESS, monitor_load, NULL);
+    ina219_sim_attach(CONSUMPTION_ADDRESS, monitor_load, NULL);
+    bme280_sim_attach(BME_ADDRESS, climate, NULL);
+    if (!run_bus())
+    {
+        return 1;
+    }
+
+    UNITY_BEGIN();
+    RUN_TEST(test_every_request_answered);
+    RUN_TEST(test_stretch_times_out);
+    RUN_TEST(test_absent_device_fails);
+    RUN_TEST(test_stuck_bus_recovered);
+    return UNITY_END();
+}
@@ -0,0 +1,237 @@
+/*
+ * The node on the host: the handle_* and publish_* functions run in tasks
+ * at the periods of scheduling.cpp, on the simulated BME280 and INA219s,
+ * against the uplink fake in virtual time. Checks what reaches the broker
+ * (summaries, history answers, fan states) and what is kept in NVS across
+ * a reboot. The tests run in order, each one continuing from the state the
+ * previous one left.
+ */
+
+#include <unity.h>
+#include <stdio.h>
+#include <string.h>
+#include "hal/hal.hpp"
+#include "hal/linux/hal_fake.hpp"
+#include "hal/linux/hal_sim.hpp"
+#include "i2c_bus/i2c_bus.hpp"
+#include "env_measurement/env_measurement.hpp"
+#include "env_measurement/bme280_sim.hpp"
+#include "energy_monitor/energy_monitor.hpp"
+#include "energy_monitor/ina219_sim.hpp"
+#include "fan_control/fan_control.hpp"
+#include "telemetry/telemetry.hpp"
+#include "history/history.hpp"
+#include "uplink/uplink.hpp"
+
+#define START_UNIX_MS 1718000000000ULL // Clock already set by NTP
+#define SAVED_PRODUCTION_UWH 1000000   // Totals of energy_monitor.cpp left in NVS before the boot
+#define PRODUCTION_MV 12000
+#define PRODUCTION_UA 500000 // 6 W
+#define CONSUMPTION_MV 12000
+#define CONSUMPTION_UA 250000 // 3 W
+
+/// Task running one handle_* or publish_* pass per period, like scheduling.cpp.
+struct NodeTask
+{
+    void (*handle)();
+    uint32_t period_ms;
+};
+
+static void publish_all()
+{
+    publish_energy_summary();
+    publish_telemetry();
+    publish_history();
+    publish_fan_control();
+}
+
+static NodeTask mqtt = {publish_all, 1000};
+static NodeTask fan = {handle_fan_control, 1000};
+static NodeTask env = {handle_env_measurement, 1000};
+static NodeTask energy = {handle_energy_monitor, 100};
+static NodeTask history = {handle_history, 1000};
+
+/* What the broker received */
+static uint32_t stats_count = 0;
+static char fan_state[128]; // Latest on TOPIC_FAN_STATE/1
+static uint32_t fan_state_count = 0;
+static char production[128]; // Latest on TOPIC_ENERGY_PRODUCTION
+static char history_result[1024];
+static uint32_t history_results = 0;
+static bool history_ended = false;
+
+static void on_publish(const char *topic, const char *payload, void *ctx)
+{
+    (void)ctx;
+    if (strncmp(topic, TOPIC_TELEMETRY_STATS "/", strlen(TOPIC_TELEMETRY_STATS) + 1) == 0)
+    {
+        stats_count++;
+    }
+    else if (strcmp(topic, TOPIC_FAN_STATE "/1") == 0)
+    {
+        snprintf(fan_state, sizeof(fan_state), "%s", payload);
+        fan_state_count++;
+    }
+    else if (strcmp(topic, TOPIC_ENERGY_PRODUCTION) == 0)
+    {
+        snprintf(production, sizeof(production), "%s", payload);
+    }
+    else if (strcmp(topic, TOPIC_HISTORY_RESULT) == 0)
+    {
+        if (payload[0] == '\0')
+        {
+            history_ended = true;
+        }
+        else
+        {
+            snprintf(history_result, sizeof(history_result), "%s", payload);
+            history_results++;
+        }
+    }
+}
+
+static void climate(void *ctx, uint64_t time_us, float *celsius, float *pascal, float *percent)
+{
+    (void)ctx;
+    (void)time_us;
+    *celsius = 25.0f;
+    *pascal = 101325.0f;
+    *percent = 50.0f;
+}
+
+static void load(void *ctx, uint64_t time_us, uint16_t *bus_mv, int32_t *current_ua)
+{
+    (void)time_us;
+    bool is_production = ctx != NULL;
+    *bus_mv = is_production ? PRODUCTION_MV : CONSUMPTION_MV;
+    *current_ua = is_production ? PRODUCTION_UA : CONSUMPTION_UA;
+}
+
+static void nodeTask(void *arg)
+{
+    const NodeTask *task = (const NodeTask *)arg;
+    while (true)
+    {
+        task->handle();
+        hal_delay_ms(task->period_ms);
+    }
+}
+
+static void busTask(void *arg)
+{
+    (void)arg;
+    while (true)
+    {
+        handle_i2c_bus();
+    }
+}
+
+void setUp()
+{
+}
+
+void tearDown()
+{
+}
+
+/* The 1 min windows close once a minute, the 15 min ones after 15 */
+static void test_telemetry_summaries()
+{
+    hal_sim_run_for(62 * 1000000ULL);
+    TEST_ASSERT_GREATER_THAN_UINT32(0, stats_count);
+    uint32_t minute = stats_count;
+
+    hal_sim_run_for(15 * 60 * 1000000ULL);
+    TEST_ASSERT_GREATER_THAN_UINT32(minute, stats_count);
+}
+
+/* Restored at boot, integrated since, saved every ENERGY_SAVE_MS */
+static void test_energy_totals_kept()
+{
+    float wh = 0;
+    TEST_ASSERT_EQUAL_INT(1, sscanf(production, "{\"wh\":%f", &wh));
+    float expected_wh = SAVED_PRODUCTION_UWH / 1e6f + 6.0f * 16 / 60;
+    TEST_ASSERT_FLOAT_WITHIN(0.1f, expected_wh, wh);
+
+    uint64_t saved_uwh = 0;
+    TEST_ASSERT_TRUE(hal_nvs_get_u64("energy", "prod_uwh", &saved_uwh));
+    TEST_ASSERT_GREATER_THAN_UINT32(SAVED_PRODUCTION_UWH + 1000000, (uint32_t)saved_uwh); // 15 min at 6 W is 1.5 Wh
+}
+
+/* The history covers the minutes since the boot at a steady 25 °C */
+static void test_history_query()
+{
+    char query[64];
+    unsigned long from = (unsigned long)(START_UNIX_MS / 1000) + 60;
+    snprintf(query, sizeof(query), "temperature %lu %lu 60", from, from + 600);
+    uplink_fake_deliver(TOPIC_HISTORY_QUERY, query);
+    hal_sim_run_for(10 * 1000000ULL);
+
+    TEST_ASSERT_TRUE(history_ended);
+    TEST_ASSERT_EQUAL_UINT32(1, history_results);
+    TEST_ASSERT_NOT_NULL(strstr(history_result, "\"channel\":\"temperature\""));
+    TEST_ASSERT_NOT_NULL(strstr(history_result, "\"values\":[25.00,25.00,"));
+    TEST_ASSERT_NULL(strstr(history_result, "null"));
+}
+
+/* A setting from the broker is applied, published and kept in NVS */
+static void test_fan_setting()
+{
+    TEST_ASSERT_NOT_NULL(strstr(fan_state, "\"mode\":\"hysteresis\"")); // Default, published at start
+
+    uplink_fake_deliver(TOPIC_FAN_CONFIG, "1 pi 24 1.5 900");
+    hal_sim_run_for(2 * 1000000ULL);
+    TEST_ASSERT_NOT_NULL(strstr(fan_state, "\"mode\":\"pi\",\"setpoint\":24.00"));
+
+    FanControlConfig saved;
+    TEST_ASSERT_TRUE(hal_nvs_get("fan", "fan1", &saved, sizeof(saved)));
+    TEST_ASSERT_EQUAL_INT(FAN_MODE_PI, saved.mode);
+    TEST_ASSERT_EQUAL_FLOAT(24.0f, saved.setpoint);
+    TEST_ASSERT_EQUAL_FLOAT(1.5f, saved.kp);
+    TEST_ASSERT_EQUAL_FLOAT(900.0f, saved.ti_s);
+}
+
+/* After a reboot the fan starts with the saved setting and publishes it */
+static void test_fan_setting_after_reboot()
+{
+    uint32_t before = fan_state_count;
+    TEST_ASSERT_TRUE(init_fan_control());
+    hal_sim_run_for(2 * 1000000ULL);
+    TEST_ASSERT_GREATER_THAN_UINT32(before, fan_state_count);
+    TEST_ASSERT_NOT_NULL(strstr(fan_state, "\"mode\":\"pi\",\"setpoint\":24.00"));
+}
+
+int main()
+{
+    hal_sim_begin();
+    hal_fake_clock_set(START_UNIX_MS);
+    hal_fake_flash_add_partition(HISTORY_PARTITION, 0x100000, NULL);
+    hal_nvs_set_u64("energy", "prod_uwh", SAVED_PRODUCTION_UWH);
+    bme280_sim_attach(BME280_I2C_ADDRESS, climate, NULL);
+    ina219_sim_attach(INA219_PRODUCTION_ADDRESS, load, (void *)1);
+    ina219_sim_attach(INA219_CONSUMPTION_ADDRESS, load, NULL);
+    uplink_fake_set_publish_hook(on_publish, NULL);
+
+    if (!init_telemetry() || !init_history() || !init_i2c_bus() || !init_env_measurement() || !init_fan_control() ||
+        !init_energy_monitor())
+    {
+        return 1;
+    }
+    if (!hal_task_create(busTask, "i2c_bus", 4096, NULL, 5, NULL, 1) ||
+        !hal_task_create(nodeTask, "energy", 4096, &energy, 4, NULL, 1) ||
+        !hal_task_create(nodeTask, "env", 4096, &env, 2, NULL, 1) ||
+        !hal_task_create(nodeTask, "fan", 4096, &fan, 1, NULL, 1) ||
+        !hal_task_create(nodeTask, "history", 4096, &history, 1, NULL, 0) ||
+        !hal_task_create(nodeTask, "mqtt", 4096, &mqtt, 1, NULL, 1))
+    {
+        return 1;
+    }
+
+    UNITY_BEGIN();
+    RUN_TEST(test_telemetry_summaries);
+    RUN_TEST(test_energy_totals_kept);
+    RUN_TEST(test_history_query);
+    RUN_TEST(test_fan_setting);
+    RUN_TEST(test_fan_setting_after_reboot);
+    return UNITY_END();
+}
@@ -0,0 +1,249 @@
+/*
+ * Streaming statistics over three hours of synthetic sensor streams:
+ * every closed window is checked against the exact statistics of its
+ * samples, then the cost of a sample is timed on the host CPU.
+ */
+
+#include <unity.h>
+#include <math.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <chrono>
+#include "telemetry/stream_stats.hpp"
+
+#define STATS_MS 10800000           // Three 1 h windows
+#define MAX_QUANTILE_ERROR 1.0      // Largest P² estimate error, in standard deviations of the window
+#define MAX_MOMENT_ERROR 1e-3       // Largest mean and deviation error, in standard deviations
+#define BENCH_SAMPLES 2000000
+
+/// Sensor stream sampled at a fixed period.
+struct Stream
+{
+    const char *name;
+    uint32_t period_ms;
+    float (*sample)(uint32_t time_ms);
+};
+
+static uint32_t hash(uint32_t x)
+{
+    x ^= x >> 16;
+    x *= 0x7feb352d;
+    x ^= x >> 15;
+    x *= 0x846ca68b;
+    return x ^ (x >> 16);
+}
+
+/* Approximately normal noise from the sum of uniforms, deterministic in the time */
+static float noise(uint32_t time_ms)
+{
+    float sum = 0;
+    for (uint32_t i = 0; i < 4; i++)
+    {
+        sum += (hash(time_ms * 4 + i) & 0xffff) / 65536.0f;
+    }
+    return (sum - 2) * 1.73f; // Unit variance
+}
+
+/* Room temperature: slow drift and sensor noise, °C */
+static float temperature_stream(uint32_t time_ms)
+{
+    return 21.7f + 0.8f * sinf(2 * (float)M_PI * time_ms / 5400000.0f) + 0.05f * noise(time_ms);
+}
+
+/* Heater switched by a slow PWM: 2 A for 300 ms of every second, the supply sagging under load */
+static void heater_load(uint64_t time_us, uint16_t *bus_mv, int32_t *current_ua)
+{
+    bool on = time_us % 1000000 < 300000;
+    *bus_mv = on ? 11800 : 12100;
+    *current_ua = on ? 2000000 : 15000;
+}
+
+/* Motor started at random: 40 ms inrush at 2.8 A, 900 mA for a few seconds, standby in between */
+static void motor_load(uint64_t time_us, uint16_t *bus_mv, int32_t *current_ua)
+{
+    uint32_t slot = (uint32_t)(time_us / 10000000); // A start every 10 s slot, at a random point
+    uint64_t offset_us = time_us % 10000000;
+    uint32_t h = hash(slot);
+    uint64_t start_us = h % 5000000;
+    uint64_t run_us = 1000000 + (h >> 8) % 4000000;
+    *bus_mv = 12000;
+    if (offset_us < start_us || offset_us >= start_us + run_us)
+    {
+        *current_ua = 60000;
+    }
+    else
+    {
+        *current_ua = offset_us - start_us < 40000 ? 2800000 : 900000;
+        *bus_mv = offset_us - start_us < 40000 ? 11500 : 11900;
+    }
+}
+
+/* Heater power: two modes, mW */
+static float heater_stream(uint32_t time_ms)
+{
+    uint16_t mv;
+    int32_t ua;
+    heater_load(time_ms * 1000ULL + 50000, &mv, &ua);
+    return (float)mv * ua / 1e6f + 20 * noise(time_ms);
+}
+
+/* Motor power: standby with rare peaks, skewed, mW */
+static float motor_stream(uint32_t time_ms)
+{
+    uint16_t mv;
+    int32_t ua;
+    motor_load(time_ms * 1000ULL, &mv, &ua);
+    return (float)mv * ua / 1e6f + 5 * noise(time_ms);
+}
+
+/* Samples of the open window of each length, for the exact statistics */
+static float window_samples[STREAM_WINDOWS][STATS_MS / 3 / 100];
+static uint32_t window_counts[STREAM_WINDOWS];
+
+static int compare_floats(const void *a, const void *b)
+{
+    float x = *(const float *)a, y = *(const float *)b;
+    return x < y ? -1 : x > y;
+}
+
+/* Quantile p of sorted samples, nearest rank */
+static float exact_quantile(const float *sorted, uint32_t count, double p)
+{
+    uint32_t rank = (uint32_t)ceil(p * count);
+    return sorted[rank > 0 ? rank - 1 : 0];
+}
+
+/* Checks the summary of a closed window against its samples, keeps the worst errors */
+static void check_window(int window, const StreamSummary *summary, double *worst_quantile, double *worst_moment)
+{
+    float *samples = window_samples[window];
+    uint32_t count = window_counts[window];
+    double sum = 0, squares = 0;
+    for (uint32_t i = 0; i < count; i++)
+    {
+        sum += samples[i];
+    }
+    double mean = sum / count;
+    for (uint32_t i = 0; i < count; i++)
+    {
+        squares += (samples[i] - mean) * (samples[i] - mean);
+    }
+    double stddev = count > 1 ? sqrt(squares / (count - 1)) : 0;
+    qsort(samples, count, sizeof(float), compare_floats);
+
+    TEST_ASSERT_EQUAL_UINT32(count, summary->count);
+    TEST_ASSERT_EQUAL_FLOAT(samples[0], summary->min);
+    TEST_ASSERT_EQUAL_FLOAT(samples[count - 1], summary->max);
+
+    double scale = stddev > 0 ? stddev : 1;
+    double quantile = fmax(fabs(summary->median - exact_quantile(samples, count, 0.5)),
+                           fabs(summary->p95 - exact_quantile(samples, count, 0.95))) / scale;
+    double moment = fmax(fabs(summary->mean - mean), fabs(summary->stddev - stddev)) / scale;
+    *worst_quantile = fmax(*worst_quantile, quantile);
+    *worst_moment = fmax(*worst_moment, moment);
+}
+
+static void run_stream(const Stream *stream)
+{
+    static const char *const window_names[STREAM_WINDOWS] = {"1m", "15m", "1h"};
+    StreamChannel channel;
+    stream_channel_init(&channel, 0);
+    for (int w = 0; w < STREAM_WINDOWS; w++)
+    {
+        window_counts[w] = 0;
+    }
+
+    double worst_quantile[STREAM_WINDOWS] = {}, worst_moment[STREAM_WINDOWS] = {};
+    uint32_t windows[STREAM_WINDOWS] = {};
+    for (uint32_t now_ms = 0; now_ms <= STATS_MS; now_ms += stream->period_ms)
+    {
+        float value = stream->sample(now_ms);
+        StreamSummary closed[STREAM_WINDOWS];
+        uint8_t closed_mask = stream_channel_add(&channel, now_ms, value, closed);
+        for (int w = 0; w < STREAM_WINDOWS; w++)
+        {
+            if (closed_mask & (1 << w))
+            {
+                check_window(w, &closed[w], &worst_quantile[w], &worst_moment[w]);
+                windows[w]++;
+                window_counts[w] = 0;
+            }
+            window_samples[w][window_counts[w]++] = value;
+        }
+    }
+
+    for (int w = 0; w < STREAM_WINDOWS; w++)
+    {
+        char message[128];
+        snprintf(message, sizeof(message), "%-12s %-3s %3lu windows, worst quantile error %.3f sd, worst moment error %.1e sd",
+                 stream->name, window_names[w], (unsigned long)windows[w], worst_quantile[w], worst_moment[w]);
+        TEST_MESSAGE(message);
+        TEST_ASSERT_EQUAL_UINT32(STATS_MS / stream_window_ms((StreamWindowLength)w), windows[w]);
+        TEST_ASSERT_FLOAT_WITHIN(MAX_QUANTILE_ERROR, 0, worst_quantile[w]);
+        TEST_ASSERT_FLOAT_WITHIN(MAX_MOMENT_ERROR, 0, worst_moment[w]);
+    }
+}
+
+void setUp()
+{
+}
+
+void tearDown()
+{
+}
+
+static void test_temperature()
+{
+    const Stream stream = {"temperature", 1000, temperature_stream};
+    run_stream(&stream);
+}
+
+static void test_heater_power()
+{
+    const Stream stream = {"heater power", 100, heater_stream};
+    run_stream(&stream);
+}
+
+static void test_motor_power()
+{
+    const Stream stream = {"motor power", 100, motor_stream};
+    run_stream(&stream);
+}
+
+/* CPU time of a sample added to a channel, every window updated */
+static void test_cost_per_sample()
+{
+    float *values = window_samples[STREAM_WINDOW_1H];
+    const uint32_t value_count = sizeof(window_samples[0]) / sizeof(float);
+    for (uint32_t i = 0; i < value_count; i++)
+    {
+        values[i] = heater_stream(i * 100);
+    }
+    StreamChannel channel;
+    stream_channel_init(&channel, 0);
+    StreamSummary closed[STREAM_WINDOWS];
+    uint32_t closing = 0;
+
+    auto start = std::chrono::steady_clock::now();
+    for (uint32_t i = 0; i < BENCH_SAMPLES; i++)
+    {
+        closing += stream_channel_add(&channel, i * 100, values[i % value_count], closed) != 0;
+    }
+    double ns = std::chrono::duration<double, std::nano>(std::chrono::steady_clock::now() - start).count();
+    TEST_ASSERT_GREATER_THAN_UINT(0, closing);
+
+    char message[128];
+    snprintf(message, sizeof(message), "%.1f ns per sample on the host, %lu samples closing windows, %u B per channel",
+             ns / BENCH_SAMPLES, (unsigned long)closing, (unsigned)sizeof(StreamChannel));
+    TEST_MESSAGE(message);
+}
+
+int main()
+{
+    UNITY_BEGIN();
+    RUN_TEST(test_temperature);
+    RUN_TEST(test_heater_power);
+    RUN_TEST(test_motor_power);
+    RUN_TEST(test_cost_per_sample);
+    return UNITY_END();
+}
@@ -0,0 +1,215 @@
+#if defined(ARDUINO)
+
+#include <Arduino.h>
+#include "driver/adc.h"
+#include "../hal_adc.hpp"
+
+#define HAL_ADC_MIN_SAMPLE_RATE 20000 // Lowest rate of the ESP32 digital controller
+#define HAL_ADC_DMA_BUFFER_SIZE 1024
+#define HAL_ADC_DMA_READ_SIZE 256
+#define HAL_ADC_TASK_STACK_SIZE 4096
+#define HAL_ADC_TASK_PRIORITY 10
+#define HAL_ADC_TASK_CORE 1
+
+struct AdcContinuous
+{
+    uint8_t pins[HAL_ADC_CONTINUOUS_MAX_PINS];
+    uint8_t channels[HAL_ADC_CONTINUOUS_MAX_PINS];
+    uint8_t pin_count;
+    uint32_t decimation; // Hardware conversions averaged into one sample
+    size_t block_frames;
+    hal_adc_block_cb_t callback;
+    void *arg;
+
+    uint16_t *block;
+    size_t frame_index[HAL_ADC_CONTINUOUS_MAX_PINS];
+    uint32_t sum[HAL_ADC_CONTINUOUS_MAX_PINS];
+    uint32_t count[HAL_ADC_CONTINUOUS_MAX_PINS];
+};
+
+static AdcContinuous s_adc;
+static volatile bool s_running = false;
+static volatile bool s_stop = false;
+static volatile uint16_t s_latest[HAL_ADC_CONTINUOUS_MAX_PINS];
+
+static int find_channel(uint8_t channel)
+{
+    for (int i = 0; i < s_adc.pin_count; i++)
+    {
+        if (s_adc.channels[i] == channel)
+        {
+            return i;
+        }
+    }
+    return -1;
+}
+
+static void add_sample(int index, uint16_t value)
+{
+    s_adc.sum[index] += value;
+    if (++s_adc.count[index] < s_adc.decimation)
+    {
+        return;
+    }
+
+    uint16_t sample = s_adc.sum[index] / s_adc.count[index];
+    s_adc.sum[index] = 0;
+    s_adc.count[index] = 0;
+    s_latest[index] = sample;
+
+    if (s_adc.frame_index[index] >= s_adc.block_frames)
+    {
+        return; // This pin is ahead, the block is waiting for the others
+    }
+    s_adc.block[s_adc.frame_index[index] * s_adc.pin_count + index] = sample;
+    s_adc.frame_index[index]++;
+
+    for (int i = 0; i < s_adc.pin_count; i++)
+    {
+        if (s_adc.frame_index[i] < s_adc.block_frames)
+        {
+            return;
+        }
+    }
+    s_adc.callback(s_adc.block, s_adc.block_frames, s_adc.arg);
+    for (int i = 0; i < s_adc.pin_count; i++)
+    {
+        s_adc.frame_index[i] = 0;
+    }
+}
+
+static void adc_task(void *arg)
+{
+    static uint8_t raw[HAL_ADC_DMA_READ_SIZE];
+
+    while (!s_stop)
+    {
+        uint32_t length = 0;
+        esp_err_t err = adc_digi_read_bytes(raw, sizeof(raw), &length, pdMS_TO_TICKS(100));
+        if (err != ESP_OK && err != ESP_ERR_INVALID_STATE) // INVALID_STATE reports an overflow, data is still valid
+        {
+            continue;
+        }
+        for (uint32_t i = 0; i + SOC_ADC_DIGI_RESULT_BYTES <= length; i += SOC_ADC_DIGI_RESULT_BYTES)
+        {
+            adc_digi_output_data_t *result = (adc_digi_output_data_t *)&raw[i];
+            int index = find_channel(result->type1.channel);
+            if (index >= 0)
+            {
+                add_sample(index, result->type1.data);
+            }
+        }
+    }
+
+    adc_digi_stop();
+    adc_digi_deinitialize();
+    free(s_adc.block);
+    s_adc.block = NULL;
+    s_running = false;
+    vTaskDelete(NULL);
+}
+
+uint16_t hal_adc_read(uint8_t pin)
+{
+    if (s_running)
+    {
+        for (int i = 0; i < s_adc.pin_count; i++)
+        {
+            if (s_adc.pins[i] == pin)
+            {
+                return s_latest[i];
+            }
+        }
+    }
+    return (uint16_t)analogRead(pin);
+}
+
+bool hal_adc_continuous_start(const uint8_t *pins, uint8_t pin_count, uint32_t sample_rate_hz, size_t block_frames, hal_adc_block_cb_t callback, void *arg)
+{
+    if (s_running || pin_count == 0 || pin_count > HAL_ADC_CONTINUOUS_MAX_PINS || sample_rate_hz == 0 || block_frames == 0 || callback == NULL)
+    {
+        return false;
+    }
+
+    memset(&s_adc, 0, sizeof(s_adc));
+    uint32_t channel_mask = 0;
+    adc_digi_pattern_config_t pattern[HAL_ADC_CONTINUOUS_MAX_PINS] = {};
+    for (int i = 0; i < pin_count; i++)
+    {
+        int8_t channel = digitalPinToAnalogChannel(pins[i]);
+        if (channel < 0 || channel >= 8) // ADC1 only, ADC2 is taken by WiFi
+        {
+            return false;
+        }
+        s_adc.pins[i] = pins[i];
+        s_adc.channels[i] = channel;
+        channel_mask |= 1 << channel;
+
+        pattern[i].atten = ADC_ATTEN_DB_11;
+        pattern[i].channel = channel;
+        pattern[i].unit = 0; // ADC1
+        pattern[i].bit_width = SOC_ADC_DIGI_MAX_BITWIDTH;
+    }
+
+    uint32_t total_rate = sample_rate_hz * pin_count;
+    s_adc.pin_count = pin_count;
+    s_adc.decimation = (HAL_ADC_MIN_SAMPLE_RATE + total_rate - 1) / total_rate;
+    if (s_adc.decimation == 0)
+    {
+        s_adc.decimation = 1;
+    }
+    s_adc.block_frames = block_frames;
+    s_adc.callback = callback;
+    s_adc.arg = arg;
+    s_adc.block = (uint16_t *)malloc(block_frames * pin_count * sizeof(uint16_t));
+    if (s_adc.block == NULL)
+    {
+        return false;
+    }
+
+    adc_digi_init_config_t init_config = {};
+    init_config.max_store_buf_size = HAL_ADC_DMA_BUFFER_SIZE;
+    init_config.conv_num_each_intr = HAL_ADC_DMA_READ_SIZE;
+    init_config.adc1_chan_mask = channel_mask;
+    init_config.adc2_chan_mask = 0;
+
+    adc_digi_configuration_t config = {};
+    config.conv_limit_en = 1;
+    config.conv_limit_num = 250;
+    config.pattern_num = pin_count;
+    config.adc_pattern = pattern;
+    config.sample_freq_hz = total_rate * s_adc.decimation;
+    config.conv_mode = ADC_CONV_SINGLE_UNIT_1;
+    config.format = ADC_DIGI_OUTPUT_FORMAT_TYPE1;
+
+    if (adc_digi_initialize(&init_config) != ESP_OK)
+    {
+        free(s_adc.block);
+        return false;
+    }
+    if (adc_digi_controller_configure(&config) != ESP_OK || adc_digi_start() != ESP_OK)
+    {
+        adc_digi_deinitialize();
+        free(s_adc.block);
+        return false;
+    }
+
+    s_stop = false;
+    s_running = true;
+    if (xTaskCreatePinnedToCore(adc_task, "hal_adc", HAL_ADC_TASK_STACK_SIZE, NULL, HAL_ADC_TASK_PRIORITY, NULL, HAL_ADC_TASK_CORE) != pdPASS)
+    {
+        adc_digi_stop();
+        adc_digi_deinitialize();
+        free(s_adc.block);
+        s_running = false;
+        return false;
+    }
+    return true;
+}
+
+void hal_adc_continuous_stop()
+{
+    s_stop = true; // The task releases the hardware and exits
+}
+
+#endif // ARDUINO
@@ -0,0 +1,31 @@
+#if defined(ARDUINO)
+
+#include "esp_partition.h"
+#include "../hal_flash.hpp"
+
+hal_partition_t hal_partition_find(const char *label)
+{
+    return (hal_partition_t)esp_partition_find_first(ESP_PARTITION_TYPE_DATA, ESP_PARTITION_SUBTYPE_ANY, label);
+}
+
+size_t hal_partition_size(hal_partition_t partition)
+{
+    return ((const esp_partition_t *)partition)->size;
+}
+
+bool hal_partition_read(hal_partition_t partition, size_t offset, void *data, size_t length)
+{
+    return esp_partition_read((const esp_partition_t *)partition, offset, data, length) == ESP_OK;
+}
+
+bool hal_partition_write(hal_partition_t partition, size_t offset, const void *data, size_t length)
+{
+    return esp_partition_write((const esp_partition_t *)partition, offset, data, length) == ESP_OK;
+}
+
+bool hal_partition_erase(hal_partition_t partition, size_t offset, size_t length)
+{
+    return esp_partition_erase_range((const esp_partition_t *)partition, offset, length) == ESP_OK;
+}
+
+#endif // ARDUINO
@@ -0,0 +1,20 @@
+#if defined(ARDUINO)
+
+#include <LittleFS.h>
+#include <stdio.h>
+#include "../hal_fs.hpp"
+
+#define FS_MOUNT_POINT "/littlefs"
+
+bool hal_fs_mount()
+{
+    return LittleFS.begin(true, FS_MOUNT_POINT); // Formats the partition on first use
+}
+
+bool hal_fs_path(const char *name, char *path, size_t size)
+{
+    int length = snprintf(path, size, FS_MOUNT_POINT "%s", name);
+    return length >= 0 && (size_t)length < size;
+}
+
+#endif // ARDUINO
@@ -0,0 +1,58 @@
+#if defined(ARDUINO)
+
+#include <Arduino.h>
+#include "../hal_gpio.hpp"
+
+void hal_gpio_mode(uint8_t pin, HalPinMode mode)
+{
+    switch (mode)
+    {
+    case HAL_INPUT:
+        pinMode(pin, INPUT);
+        break;
+    case HAL_INPUT_PULLUP:
+        pinMode(pin, INPUT_PULLUP);
+        break;
+    case HAL_INPUT_PULLDOWN:
+        pinMode(pin, INPUT_PULLDOWN);
+        break;
+    case HAL_OUTPUT:
+        pinMode(pin, OUTPUT);
+        break;
+    case HAL_OUTPUT_OPEN_DRAIN:
+        pinMode(pin, OUTPUT_OPEN_DRAIN);
+        break;
+    }
+}
+
+int hal_gpio_read(uint8_t pin)
+{
+    return digitalRead(pin) == HIGH ? HAL_HIGH : HAL_LOW;
+}
+
+void hal_gpio_write(uint8_t pin, int level)
+{
+    digitalWrite(pin, level ? HIGH : LOW);
+}
+
+bool hal_gpio_attach_interrupt(uint8_t pin, HalGpioEdge edge, hal_gpio_isr_t isr, void *arg)
+{
+    int mode = CHANGE;
+    if (edge == HAL_EDGE_RISING)
+    {
+        mode = RISING;
+    }
+    else if (edge == HAL_EDGE_FALLING)
+    {
+        mode = FALLING;
+    }
+    attachInterruptArg(pin, isr, arg, mode);
+    return true;
+}
+
+void hal_gpio_detach_interrupt(uint8_t pin)
+{
+    detachInterrupt(pin);
+}
+
+#endif // ARDUINO
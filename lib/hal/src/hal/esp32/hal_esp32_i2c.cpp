@@ -0,0 +1,48 @@
+#if defined(ARDUINO)
+
+#include <Arduino.h>
+#include <Wire.h>
+#include "../hal_i2c.hpp"
+
+bool hal_i2c_begin(uint8_t sda, uint8_t scl, uint32_t frequency)
+{
+    return Wire.begin(sda, scl, frequency);
+}
+
+void hal_i2c_end()
+{
+    Wire.end();
+}
+
+void hal_i2c_set_timeout(uint16_t timeout_ms)
+{
+    Wire.setTimeOut(timeout_ms);
+}
+
+bool hal_i2c_write(uint8_t address, const uint8_t *data, size_t length)
+{
+    Wire.beginTransmission(address);
+    Wire.write(data, length);
+    return Wire.endTransmission(true) == 0;
+}
+
+bool hal_i2c_write_read(uint8_t address, const uint8_t *tx, size_t tx_length, uint8_t *rx, size_t rx_length)
+{
+    if (tx_length > 0)
+    {
+        Wire.beginTransmission(address);
+        Wire.write(tx, tx_length);
+        if (Wire.endTransmission(false) != 0) // Repeated start
+        {
+            return false;
+        }
+    }
+
+    if (Wire.requestFrom(address, rx_length) != rx_length)
+    {
+        return false;
+    }
+    return Wire.readBytes(rx, rx_length) == rx_length;
+}
+
+#endif // ARDUINO
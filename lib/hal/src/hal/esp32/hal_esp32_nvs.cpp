@@ -0,0 +1,59 @@
+#if defined(ARDUINO)
+
+#include <Preferences.h>
+#include "../hal_nvs.hpp"
+
+bool hal_nvs_get(const char *space, const char *key, void *data, size_t length)
+{
+    Preferences preferences;
+    if (!preferences.begin(space, true)) // Fails until the namespace is first written
+    {
+        return false;
+    }
+    bool ok = preferences.getType(key) == PT_BLOB && preferences.getBytesLength(key) == length &&
+              preferences.getBytes(key, data, length) == length;
+    preferences.end();
+    return ok;
+}
+
+bool hal_nvs_set(const char *space, const char *key, const void *data, size_t length)
+{
+    Preferences preferences;
+    if (!preferences.begin(space, false))
+    {
+        return false;
+    }
+    bool ok = preferences.putBytes(key, data, length) == length;
+    preferences.end();
+    return ok;
+}
+
+bool hal_nvs_get_u64(const char *space, const char *key, uint64_t *value)
+{
+    Preferences preferences;
+    if (!preferences.begin(space, true))
+    {
+        return false;
+    }
+    bool ok = preferences.getType(key) == PT_U64;
+    if (ok)
+    {
+        *value = preferences.getULong64(key, 0);
+    }
+    preferences.end();
+    return ok;
+}
+
+bool hal_nvs_set_u64(const char *space, const char *key, uint64_t value)
+{
+    Preferences preferences;
+    if (!preferences.begin(space, false))
+    {
+        return false;
+    }
+    bool ok = preferences.putULong64(key, value) == sizeof(value);
+    preferences.end();
+    return ok;
+}
+
+#endif // ARDUINO
@@ -0,0 +1,73 @@
+#if defined(ARDUINO)
+
+#include <Arduino.h>
+#include "driver/pcnt.h"
+#include "../hal_pcnt.hpp"
+
+#define HAL_PCNT_LIMIT 32767      // Counter wraps to 0 when reaching it
+#define HAL_PCNT_APB_MHZ 80       // Filter counts APB clock cycles
+#define HAL_PCNT_FILTER_MAX 1023  // Widest filter in cycles
+
+static int16_t s_last[HAL_PCNT_UNIT_COUNT];
+
+bool hal_pcnt_attach(uint8_t unit, uint8_t pin, uint32_t filter_ns)
+{
+    if (unit >= HAL_PCNT_UNIT_COUNT)
+    {
+        return false;
+    }
+
+    pcnt_config_t config = {};
+    config.pulse_gpio_num = pin;
+    config.ctrl_gpio_num = PCNT_PIN_NOT_USED;
+    config.channel = PCNT_CHANNEL_0;
+    config.unit = (pcnt_unit_t)unit;
+    config.pos_mode = PCNT_COUNT_INC;
+    config.neg_mode = PCNT_COUNT_INC;
+    config.lctrl_mode = PCNT_MODE_KEEP;
+    config.hctrl_mode = PCNT_MODE_KEEP;
+    config.counter_h_lim = HAL_PCNT_LIMIT;
+    config.counter_l_lim = -HAL_PCNT_LIMIT;
+    if (pcnt_unit_config(&config) != ESP_OK)
+    {
+        return false;
+    }
+
+    if (filter_ns > 0)
+    {
+        uint32_t cycles = filter_ns * HAL_PCNT_APB_MHZ / 1000;
+        pcnt_set_filter_value(config.unit, cycles > HAL_PCNT_FILTER_MAX ? HAL_PCNT_FILTER_MAX : cycles);
+        pcnt_filter_enable(config.unit);
+    }
+    else
+    {
+        pcnt_filter_disable(config.unit);
+    }
+
+    pcnt_counter_pause(config.unit);
+    pcnt_counter_clear(config.unit);
+    pcnt_counter_resume(config.unit);
+    s_last[unit] = 0;
+    return true;
+}
+
+uint32_t hal_pcnt_take(uint8_t unit)
+{
+    if (unit >= HAL_PCNT_UNIT_COUNT)
+    {
+        return 0;
+    }
+
+    // Reading without clearing keeps edges that arrive between the two calls
+    int16_t value = 0;
+    pcnt_get_counter_value((pcnt_unit_t)unit, &value);
+    int32_t edges = value - s_last[unit];
+    if (edges < 0)
+    {
+        edges += HAL_PCNT_LIMIT;
+    }
+    s_last[unit] = value;
+    return (uint32_t)edges;
+}
+
+#endif // ARDUINO
@@ -0,0 +1,36 @@
+#if defined(ARDUINO)
+
+#include <Arduino.h>
+#include "../hal_pwm.hpp"
+
+#define HAL_PWM_RESOLUTION_BITS 10
+#define HAL_PWM_DEFAULT_FREQ 2000
+
+bool hal_pwm_attach(uint8_t channel, uint8_t pin)
+{
+    if (channel >= HAL_PWM_CHANNEL_COUNT)
+    {
+        return false;
+    }
+    if (ledcSetup(channel, HAL_PWM_DEFAULT_FREQ, HAL_PWM_RESOLUTION_BITS) == 0)
+    {
+        return false;
+    }
+    ledcAttachPin(pin, channel);
+    ledcWrite(channel, 0);
+    return true;
+}
+
+void hal_pwm_tone(uint8_t channel, uint32_t freq_hz)
+{
+    if (freq_hz == 0)
+    {
+        ledcWrite(channel, 0);
+    }
+    else
+    {
+        ledcWriteTone(channel, freq_hz);
+    }
+}
+
+#endif // ARDUINO
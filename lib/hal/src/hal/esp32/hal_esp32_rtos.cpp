@@ -0,0 +1,93 @@
+#if defined(ARDUINO)
+
+#include <Arduino.h>
+#include "freertos/FreeRTOS.h"
+#include "freertos/task.h"
+#include "freertos/semphr.h"
+#include "freertos/queue.h"
+#include "../hal_rtos.hpp"
+
+static TickType_t to_ticks(uint32_t timeout_ms)
+{
+    return timeout_ms == HAL_WAIT_FOREVER ? portMAX_DELAY : pdMS_TO_TICKS(timeout_ms);
+}
+
+bool hal_task_create(hal_task_fn_t fn, const char *name, uint32_t stack_size, void *arg,
+                     uint8_t priority, hal_task_t *handle, int core)
+{
+    TaskHandle_t task = NULL;
+    BaseType_t result = xTaskCreatePinnedToCore(fn, name, stack_size, arg, priority, &task, core);
+    if (handle != NULL)
+    {
+        *handle = task;
+    }
+    return result == pdPASS;
+}
+
+hal_task_t hal_task_current()
+{
+    return xTaskGetCurrentTaskHandle();
+}
+
+void hal_task_notify(hal_task_t task)
+{
+    xTaskNotifyGive((TaskHandle_t)task);
+}
+
+void IRAM_ATTR hal_task_notify_from_isr(hal_task_t task)
+{
+    BaseType_t woken = pdFALSE;
+    vTaskNotifyGiveFromISR((TaskHandle_t)task, &woken);
+    if (woken)
+    {
+        portYIELD_FROM_ISR();
+    }
+}
+
+bool hal_task_wait_notify(uint32_t timeout_ms)
+{
+    return ulTaskNotifyTake(pdTRUE, to_ticks(timeout_ms)) > 0;
+}
+
+hal_mutex_t hal_mutex_create()
+{
+    return xSemaphoreCreateMutex();
+}
+
+bool hal_mutex_take(hal_mutex_t mutex, uint32_t timeout_ms)
+{
+    return xSemaphoreTake((SemaphoreHandle_t)mutex, to_ticks(timeout_ms)) == pdTRUE;
+}
+
+void hal_mutex_give(hal_mutex_t mutex)
+{
+    xSemaphoreGive((SemaphoreHandle_t)mutex);
+}
+
+hal_queue_t hal_queue_create(size_t length, size_t item_size)
+{
+    return xQueueCreate(length, item_size);
+}
+
+bool hal_queue_send(hal_queue_t queue, const void *item, uint32_t timeout_ms)
+{
+    return xQueueSend((QueueHandle_t)queue, item, to_ticks(timeout_ms)) == pdTRUE;
+}
+
+bool IRAM_ATTR hal_queue_send_from_isr(hal_queue_t queue, const void *item)
+{
+    BaseType_t woken = pdFALSE;
+    bool result = xQueueSendFromISR((QueueHandle_t)queue, item, &woken) == pdTRUE;
+    if (woken)
+    {
+        portYIELD_FROM_ISR();
+    }
+    return result;
+}
+
+bool hal_queue_receive(hal_queue_t queue, void *item, uint32_t timeout_ms)
+{
+    return xQueueReceive((QueueHandle_t)queue, item, to_ticks(timeout_ms)) == pdTRUE;
+}
+
+#endif // ARDUINO
@@ -0,0 +1,11 @@
+#if defined(ARDUINO)
+
+#include "sha/sha_parallel_engine.h"
+#include "../hal_sha.hpp"
+
+void hal_sha256(const void *data, size_t length, uint8_t digest[HAL_SHA256_LENGTH])
+{
+    esp_sha(SHA2_256, (const unsigned char *)data, length, digest);
+}
+
+#endif // ARDUINO
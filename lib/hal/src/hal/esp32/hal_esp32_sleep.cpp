@@ -0,0 +1,177 @@
+#if defined(ARDUINO)
+
+#include <Arduino.h>
+#include "esp_log.h"
+#include "esp_sleep.h"
+#include "driver/gpio.h"
+#include "../hal_gpio.hpp"
+#include "../hal_sleep.hpp"
+
+struct WakePin
+{
+    uint8_t pin;
+    uint8_t level;
+};
+
+static WakePin s_wake_pins[HAL_SLEEP_MAX_WAKE_PINS];
+static uint8_t s_wake_pin_count = 0;
+static uint64_t s_timer_us = 0;
+
+static HalWakeCause s_cause = HAL_WAKE_NONE;
+static uint64_t s_woken_pins = 0;
+static bool s_boot_cause_read = false;
+static RTC_DATA_ATTR int8_t s_ext0_pin = -1; // ext0 reports no status, remember the pin
+
+static HalWakeCause convert_cause(esp_sleep_wakeup_cause_t cause)
+{
+    switch (cause)
+    {
+    case ESP_SLEEP_WAKEUP_EXT0:
+    case ESP_SLEEP_WAKEUP_EXT1:
+    case ESP_SLEEP_WAKEUP_GPIO:
+        return HAL_WAKE_GPIO;
+    case ESP_SLEEP_WAKEUP_TIMER:
+        return HAL_WAKE_TIMER;
+    default:
+        return HAL_WAKE_NONE;
+    }
+}
+
+/* Wake pins currently at their level, light sleep reports no per-pin status */
+static uint64_t read_wake_pins()
+{
+    uint64_t mask = 0;
+    for (int i = 0; i < s_wake_pin_count; i++)
+    {
+        if (digitalRead(s_wake_pins[i].pin) == s_wake_pins[i].level)
+        {
+            mask |= 1ULL << s_wake_pins[i].pin;
+        }
+    }
+    return mask;
+}
+
+static void read_boot_cause()
+{
+    if (s_boot_cause_read)
+    {
+        return;
+    }
+    s_boot_cause_read = true;
+
+    esp_sleep_wakeup_cause_t cause = esp_sleep_get_wakeup_cause();
+    s_cause = convert_cause(cause);
+    if (cause == ESP_SLEEP_WAKEUP_EXT1)
+    {
+        s_woken_pins = esp_sleep_get_ext1_wakeup_status();
+    }
+    else if (cause == ESP_SLEEP_WAKEUP_EXT0 && s_ext0_pin >= 0)
+    {
+        s_woken_pins = 1ULL << s_ext0_pin;
+    }
+}
+
+bool hal_sleep_add_wake_pin(uint8_t pin, int level)
+{
+    if (s_wake_pin_count >= HAL_SLEEP_MAX_WAKE_PINS)
+    {
+        return false;
+    }
+    s_wake_pins[s_wake_pin_count].pin = pin;
+    s_wake_pins[s_wake_pin_count].level = level ? HAL_HIGH : HAL_LOW;
+    s_wake_pin_count++;
+    return true;
+}
+
+void hal_sleep_clear_wake_pins()
+{
+    s_wake_pin_count = 0;
+}
+
+void hal_sleep_set_timer(uint64_t timeout_us)
+{
+    s_timer_us = timeout_us;
+}
+
+HalWakeCause hal_light_sleep()
+{
+    read_boot_cause();
+    esp_sleep_disable_wakeup_source(ESP_SLEEP_WAKEUP_ALL);
+
+    for (int i = 0; i < s_wake_pin_count; i++)
+    {
+        gpio_wakeup_enable((gpio_num_t)s_wake_pins[i].pin, s_wake_pins[i].level ? GPIO_INTR_HIGH_LEVEL : GPIO_INTR_LOW_LEVEL);
+    }
+    if (s_wake_pin_count > 0)
+    {
+        esp_sleep_enable_gpio_wakeup();
+    }
+    if (s_timer_us > 0)
+    {
+        esp_sleep_enable_timer_wakeup(s_timer_us);
+    }
+
+    esp_light_sleep_start();
+
+    s_cause = convert_cause(esp_sleep_get_wakeup_cause());
+    s_woken_pins = s_cause == HAL_WAKE_GPIO ? read_wake_pins() : 0;
+
+    for (int i = 0; i < s_wake_pin_count; i++)
+    {
+        gpio_wakeup_disable((gpio_num_t)s_wake_pins[i].pin); // Give the pins back to regular interrupts
+    }
+    return s_cause;
+}
+
+void hal_deep_sleep()
+{
+    esp_sleep_disable_wakeup_source(ESP_SLEEP_WAKEUP_ALL);
+
+    uint64_t high_mask = 0;
+    s_ext0_pin = -1;
+    for (int i = 0; i < s_wake_pin_count; i++)
+    {
+        if (s_wake_pins[i].level == HAL_HIGH)
+        {
+            high_mask |= 1ULL << s_wake_pins[i].pin;
+        }
+        else if (s_ext0_pin < 0)
+        {
+            s_ext0_pin = s_wake_pins[i].pin;
+            esp_sleep_enable_ext0_wakeup((gpio_num_t)s_ext0_pin, 0);
+        }
+        else
+        {
+            ESP_LOGW("hal_sleep", "GPIO %d cannot wake from deep sleep, only one low-level pin is supported", s_wake_pins[i].pin);
+        }
+    }
+    if (high_mask != 0)
+    {
+        esp_sleep_enable_ext1_wakeup(high_mask, ESP_EXT1_WAKEUP_ANY_HIGH);
+    }
+    if (s_timer_us > 0)
+    {
+        esp_sleep_enable_timer_wakeup(s_timer_us);
+    }
+
+    esp_deep_sleep_start();
+}
+
+HalWakeCause hal_wake_cause()
+{
+    read_boot_cause();
+    return s_cause;
+}
+
+uint64_t hal_wake_pins()
+{
+    read_boot_cause();
+    return s_woken_pins;
+}
+
+uint64_t hal_sleep_active_wake_pins()
+{
+    return read_wake_pins();
+}
+
+#endif // ARDUINO
@@ -0,0 +1,36 @@
+#if defined(ARDUINO)
+
+#include <Arduino.h>
+#include <SPI.h>
+#include "../hal_spi.hpp"
+
+bool hal_spi_begin(uint8_t sck, uint8_t miso, uint8_t mosi)
+{
+    SPI.begin(sck, miso, mosi);
+    return true;
+}
+
+void hal_spi_transfer(uint8_t cs, uint32_t clock_hz, const uint8_t *tx, uint8_t *rx, size_t length)
+{
+    SPI.beginTransaction(SPISettings(clock_hz, MSBFIRST, SPI_MODE0));
+    digitalWrite(cs, LOW);
+    if (tx != NULL)
+    {
+        SPI.transferBytes(tx, rx, length);
+    }
+    else
+    {
+        for (size_t i = 0; i < length; i++)
+        {
+            uint8_t value = SPI.transfer(0x00);
+            if (rx != NULL)
+            {
+                rx[i] = value;
+            }
+        }
+    }
+    digitalWrite(cs, HIGH);
+    SPI.endTransaction();
+}
+
+#endif // ARDUINO
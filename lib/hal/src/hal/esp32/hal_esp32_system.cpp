@@ -0,0 +1,58 @@
+#if defined(ARDUINO)
+
+#include <Arduino.h>
+#include <stdarg.h>
+#include "esp_system.h"
+#include "../hal_system.hpp"
+
+void hal_console_begin(uint32_t baud)
+{
+    Serial.begin(baud);
+    while (!Serial)
+        ;
+}
+
+void hal_console_printf(const char *format, ...)
+{
+    char buffer[256];
+    va_list args;
+    va_start(args, format);
+    vsnprintf(buffer, sizeof(buffer), format, args);
+    va_end(args);
+    Serial.print(buffer);
+}
+
+uint32_t hal_free_heap()
+{
+    return ESP.getFreeHeap();
+}
+
+uint32_t hal_min_free_heap()
+{
+    return ESP.getMinFreeHeap();
+}
+
+HalResetReason hal_reset_reason()
+{
+    switch (esp_reset_reason())
+    {
+    case ESP_RST_POWERON:
+        return HAL_RESET_POWER_ON;
+    case ESP_RST_SW:
+        return HAL_RESET_SOFTWARE;
+    case ESP_RST_PANIC:
+        return HAL_RESET_PANIC;
+    case ESP_RST_INT_WDT:
+    case ESP_RST_TASK_WDT:
+    case ESP_RST_WDT:
+        return HAL_RESET_WATCHDOG;
+    case ESP_RST_BROWNOUT:
+        return HAL_RESET_BROWNOUT;
+    case ESP_RST_DEEPSLEEP:
+        return HAL_RESET_DEEP_SLEEP;
+    default:
+        return HAL_RESET_OTHER;
+    }
+}
+
+#endif // ARDUINO
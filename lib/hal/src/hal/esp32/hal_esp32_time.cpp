@@ -0,0 +1,40 @@
+#if defined(ARDUINO)
+
+#include <Arduino.h>
+#include <sys/time.h>
+#include "esp_timer.h"
+#include "../hal_time.hpp"
+
+uint32_t hal_millis()
+{
+    return millis();
+}
+
+uint64_t hal_micros()
+{
+    return (uint64_t)esp_timer_get_time();
+}
+
+void hal_delay_ms(uint32_t ms)
+{
+    vTaskDelay(pdMS_TO_TICKS(ms));
+}
+
+void hal_delay_us(uint32_t us)
+{
+    delayMicroseconds(us);
+}
+
+void hal_clock_sync(const char *server)
+{
+    configTime(0, 0, server);
+}
+
+uint64_t hal_unix_ms()
+{
+    struct timeval now;
+    gettimeofday(&now, NULL);
+    return (uint64_t)now.tv_sec * 1000 + now.tv_usec / 1000;
+}
+
+#endif // ARDUINO
@@ -0,0 +1,52 @@
+#if defined(ARDUINO)
+
+#include <Arduino.h>
+#include "esp_timer.h"
+#include "../hal_timer.hpp"
+
+hal_timer_t hal_timer_create(const char *name, hal_timer_cb_t callback, void *arg)
+{
+    esp_timer_create_args_t args = {};
+    args.callback = callback;
+    args.arg = arg;
+    args.dispatch_method = ESP_TIMER_TASK;
+    args.name = name;
+
+    esp_timer_handle_t timer = NULL;
+    if (esp_timer_create(&args, &timer) != ESP_OK)
+    {
+        return NULL;
+    }
+    return timer;
+}
+
+bool hal_timer_start_once(hal_timer_t timer, uint64_t timeout_us)
+{
+    esp_timer_handle_t handle = (esp_timer_handle_t)timer;
+    if (esp_timer_is_active(handle))
+    {
+        esp_timer_stop(handle);
+    }
+    return esp_timer_start_once(handle, timeout_us) == ESP_OK;
+}
+
+bool hal_timer_start_periodic(hal_timer_t timer, uint64_t period_us)
+{
+    esp_timer_handle_t handle = (esp_timer_handle_t)timer;
+    if (esp_timer_is_active(handle))
+    {
+        esp_timer_stop(handle);
+    }
+    return esp_timer_start_periodic(handle, period_us) == ESP_OK;
+}
+
+void hal_timer_stop(hal_timer_t timer)
+{
+    esp_timer_handle_t handle = (esp_timer_handle_t)timer;
+    if (esp_timer_is_active(handle))
+    {
+        esp_timer_stop(handle);
+    }
+}
+
+#endif // ARDUINO
@@ -0,0 +1,31 @@
+#pragma once
+
+/*
+ * Hardware abstraction layer used by all smart home nodes.
+ *
+ * Modules talk to the hardware only through the functions declared here.
+ * The ESP32 backend (hal/esp32) is compiled for the Arduino framework,
+ * the Linux backend (hal/linux) is compiled when HAL_LINUX is defined and
+ * runs on pthreads with fake peripherals (see hal/linux/hal_fake.hpp).
+ */
+
+#if !defined(ARDUINO) && !defined(HAL_LINUX)
+#error "No HAL backend selected: build with the Arduino framework or define HAL_LINUX"
+#endif
+
+#include "hal_log.hpp"
+#include "hal_system.hpp"
+#include "hal_time.hpp"
+#include "hal_gpio.hpp"
+#include "hal_adc.hpp"
+#include "hal_pwm.hpp"
+#include "hal_pcnt.hpp"
+#include "hal_i2c.hpp"
+#include "hal_spi.hpp"
+#include "hal_rtos.hpp"
+#include "hal_timer.hpp"
+#include "hal_sleep.hpp"
+#include "hal_sha.hpp"
+#include "hal_flash.hpp"
+#include "hal_nvs.hpp"
+#include "hal_fs.hpp"
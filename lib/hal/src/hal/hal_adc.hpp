@@ -0,0 +1,52 @@
+#pragma once
+
+#include <stddef.h>
+#include <stdint.h>
+
+#define HAL_ADC_MAX 4095 // 12-bit conversions
+#define HAL_ADC_CONTINUOUS_MAX_PINS 4
+
+/**
+ * @brief Called with each block of continuous conversions.
+ *
+ * Runs in a HAL task, never in an ISR.
+ *
+ * @param samples Interleaved frames, one sample per pin in the order passed to hal_adc_continuous_start().
+ * @param frames Number of frames in the block.
+ * @param arg Argument passed to hal_adc_continuous_start().
+ */
+typedef void (*hal_adc_block_cb_t)(const uint16_t *samples, size_t frames, void *arg);
+
+/**
+ * @brief Performs a single ADC conversion.
+ *
+ * While continuous sampling runs, pins that are part of it return their
+ * latest sample instead of starting a conversion.
+ *
+ * @param pin GPIO number of the analog input.
+ * @return Raw conversion result (0 - HAL_ADC_MAX).
+ */
+uint16_t hal_adc_read(uint8_t pin);
+
+/**
+ * @brief Starts sampling pins continuously with DMA.
+ *
+ * Only one continuous conversion can run at a time. On the ESP32 the
+ * pins must belong to ADC1 (GPIO 32 - 39). The hardware sampling rate is
+ * raised to the controller minimum if needed and averaged down to
+ * sample_rate_hz.
+ *
+ * @param pins Analog inputs, at most HAL_ADC_CONTINUOUS_MAX_PINS.
+ * @param pin_count Number of pins.
+ * @param sample_rate_hz Sampling rate of each pin.
+ * @param block_frames Number of frames passed to each callback.
+ * @param callback Function receiving the blocks.
+ * @param arg Argument passed to the callback.
+ * @return true if sampling started, false otherwise.
+ */
+bool hal_adc_continuous_start(const uint8_t *pins, uint8_t pin_count, uint32_t sample_rate_hz, size_t block_frames, hal_adc_block_cb_t callback, void *arg);
+
+/**
+ * @brief Stops continuous sampling.
+ */
+void hal_adc_continuous_stop();
@@ -0,0 +1,58 @@
+#pragma once
+
+#include <stddef.h>
+#include <stdint.h>
+
+#define HAL_FLASH_SECTOR_SIZE 4096 // Smallest erasable unit
+
+typedef void *hal_partition_t; ///< Data partition handle.
+
+/**
+ * @brief Finds a data partition by its label in the partition table.
+ *
+ * @param label Partition label.
+ * @return Partition handle, NULL if there is no such partition.
+ */
+hal_partition_t hal_partition_find(const char *label);
+
+/**
+ * @brief Returns the size of a partition in bytes, a multiple of HAL_FLASH_SECTOR_SIZE.
+ *
+ * @param partition Partition handle.
+ */
+size_t hal_partition_size(hal_partition_t partition);
+
+/**
+ * @brief Reads from a partition.
+ *
+ * @param partition Partition handle.
+ * @param offset Offset in the partition.
+ * @param data (Output) Bytes read.
+ * @param length Number of bytes.
+ * @return true if the bytes were read, false otherwise.
+ */
+bool hal_partition_read(hal_partition_t partition, size_t offset, void *data, size_t length);
+
+/**
+ * @brief Writes to a partition.
+ *
+ * Like NOR flash, a write can only clear bits: the area must have been
+ * erased since it was last written.
+ *
+ * @param partition Partition handle.
+ * @param offset Offset in the partition.
+ * @param data Bytes to write.
+ * @param length Number of bytes.
+ * @return true if the bytes were written, false otherwise.
+ */
+bool hal_partition_write(hal_partition_t partition, size_t offset, const void *data, size_t length);
+
+/**
+ * @brief Erases whole sectors of a partition, setting every byte to 0xFF.
+ *
+ * @param partition Partition handle.
+ * @param offset Offset of the first sector, a multiple of HAL_FLASH_SECTOR_SIZE.
+ * @param length Number of bytes, a multiple of HAL_FLASH_SECTOR_SIZE.
+ * @return true if the sectors were erased, false otherwise.
+ */
+bool hal_partition_erase(hal_partition_t partition, size_t offset, size_t length);
@@ -0,0 +1,28 @@
+#pragma once
+
+#include <stddef.h>
+
+#define HAL_FS_PATH_MAX 64 // Longest path built by hal_fs_path()
+
+/*
+ * File system of the node, LittleFS in the spiffs partition on the
+ * ESP32. Once mounted, files are used with stdio (fopen(), rename(),
+ * remove()) under the paths built by hal_fs_path().
+ */
+
+/**
+ * @brief Mounts the file system, formatting it on first use.
+ *
+ * @return true if the file system is mounted, false otherwise.
+ */
+bool hal_fs_mount();
+
+/**
+ * @brief Builds the stdio path of a file.
+ *
+ * @param name File name from the root of the file system, e.g. "/credentials.bin".
+ * @param path (Output) Path to pass to stdio.
+ * @param size Size of path, HAL_FS_PATH_MAX is enough for names up to 31 characters.
+ * @return true if the path fits, false otherwise.
+ */
+bool hal_fs_path(const char *name, char *path, size_t size);
@@ -0,0 +1,69 @@
+#pragma once
+
+#include <stdint.h>
+
+#define HAL_LOW 0
+#define HAL_HIGH 1
+
+/// Pin configuration.
+enum HalPinMode : uint8_t
+{
+    HAL_INPUT,
+    HAL_INPUT_PULLUP,
+    HAL_INPUT_PULLDOWN,
+    HAL_OUTPUT,
+    HAL_OUTPUT_OPEN_DRAIN, ///< Drives low, floats when written high.
+};
+
+/// Edge that triggers a pin interrupt.
+enum HalGpioEdge : uint8_t
+{
+    HAL_EDGE_RISING,
+    HAL_EDGE_FALLING,
+    HAL_EDGE_BOTH,
+};
+
+/// Pin interrupt handler, runs in interrupt context on the target.
+typedef void (*hal_gpio_isr_t)(void *arg);
+
+/**
+ * @brief Configures a GPIO pin.
+ *
+ * @param pin GPIO number.
+ * @param mode Pin configuration.
+ */
+void hal_gpio_mode(uint8_t pin, HalPinMode mode);
+
+/**
+ * @brief Reads the level of a GPIO pin.
+ *
+ * @param pin GPIO number.
+ * @return HAL_HIGH or HAL_LOW.
+ */
+int hal_gpio_read(uint8_t pin);
+
+/**
+ * @brief Drives a GPIO output pin.
+ *
+ * @param pin GPIO number.
+ * @param level HAL_HIGH or HAL_LOW.
+ */
+void hal_gpio_write(uint8_t pin, int level);
+
+/**
+ * @brief Attaches an interrupt handler to a GPIO pin.
+ *
+ * @param pin GPIO number.
+ * @param edge Edge that triggers the interrupt.
+ * @param isr Handler called on the edge.
+ * @param arg Argument passed to the handler.
+ * @return true if the handler was attached, false otherwise.
+ */
+bool hal_gpio_attach_interrupt(uint8_t pin, HalGpioEdge edge, hal_gpio_isr_t isr, void *arg);
+
+/**
+ * @brief Detaches the interrupt handler of a GPIO pin.
+ *
+ * @param pin GPIO number.
+ */
+void hal_gpio_detach_interrupt(uint8_t pin);
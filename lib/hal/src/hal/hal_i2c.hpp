@@ -0,0 +1,55 @@
+#pragma once
+
+#include <stddef.h>
+#include <stdint.h>
+
+/**
+ * @brief Initializes the I2C master.
+ *
+ * @param sda GPIO used for SDA.
+ * @param scl GPIO used for SCL.
+ * @param frequency Bus clock in Hz.
+ * @return true if the bus was initialized, false otherwise.
+ */
+bool hal_i2c_begin(uint8_t sda, uint8_t scl, uint32_t frequency);
+
+/**
+ * @brief Stops the I2C master and releases its pins.
+ *
+ * Used to drive the pins as GPIOs, e.g. to recover a stuck bus, before
+ * starting the master again with hal_i2c_begin().
+ */
+void hal_i2c_end();
+
+/**
+ * @brief Sets how long the following transfers may wait for the bus.
+ *
+ * A device stretching the clock longer than this fails the transfer.
+ *
+ * @param timeout_ms Timeout in milliseconds.
+ */
+void hal_i2c_set_timeout(uint16_t timeout_ms);
+
+/**
+ * @brief Writes a buffer to an I2C device.
+ *
+ * @param address 7-bit device address.
+ * @param data Bytes to write.
+ * @param length Number of bytes to write.
+ * @return true if the device acknowledged the whole transfer, false otherwise.
+ */
+bool hal_i2c_write(uint8_t address, const uint8_t *data, size_t length);
+
+/**
+ * @brief Writes a buffer and reads the response with a repeated start.
+ *
+ * Typically used to select a register and burst-read its content.
+ *
+ * @param address 7-bit device address.
+ * @param tx Bytes to write (may be NULL when tx_length is 0).
+ * @param tx_length Number of bytes to write.
+ * @param rx Buffer for the response.
+ * @param rx_length Number of bytes to read.
+ * @return true if the transfer completed, false otherwise.
+ */
+bool hal_i2c_write_read(uint8_t address, const uint8_t *tx, size_t tx_length, uint8_t *rx, size_t rx_length);
@@ -0,0 +1,44 @@
+#pragma once
+
+/*
+ * Logging goes through the ESP_LOGx macros on every backend, so modules
+ * keep the same log calls on target and on the host.
+ */
+
+#if defined(ARDUINO)
+
+#include "esp_log.h"
+
+#else
+
+#include <stdarg.h>
+
+#ifndef HAL_LOG_LEVEL
+#define HAL_LOG_LEVEL 3 // 0: None, 1: Error, 2: Warning, 3: Info, 4: Debug, 5: Verbose
+#endif
+
+/**
+ * @brief Writes a log line on the host console.
+ *
+ * @param level Log level character ('E', 'W', 'I', 'D' or 'V').
+ * @param tag Module logging tag.
+ * @param format printf-style format string.
+ */
+void hal_log_write(char level, const char *tag, const char *format, ...) __attribute__((format(printf, 3, 4)));
+
+#define HAL_LOG_AT(lvl, ch, tag, format, ...)                 \
+    do                                                        \
+    {                                                         \
+        if (HAL_LOG_LEVEL >= (lvl))                           \
+        {                                                     \
+            hal_log_write(ch, tag, format, ##__VA_ARGS__);    \
+        }                                                     \
+    } while (0)
+
+#define ESP_LOGE(tag, format, ...) HAL_LOG_AT(1, 'E', tag, format, ##__VA_ARGS__)
+#define ESP_LOGW(tag, format, ...) HAL_LOG_AT(2, 'W', tag, format, ##__VA_ARGS__)
+#define ESP_LOGI(tag, format, ...) HAL_LOG_AT(3, 'I', tag, format, ##__VA_ARGS__)
+#define ESP_LOGD(tag, format, ...) HAL_LOG_AT(4, 'D', tag, format, ##__VA_ARGS__)
+#define ESP_LOGV(tag, format, ...) HAL_LOG_AT(5, 'V', tag, format, ##__VA_ARGS__)
+
+#endif
@@ -0,0 +1,56 @@
+#pragma once
+
+#include <stddef.h>
+#include <stdint.h>
+
+/*
+ * Small settings and counters kept across reboots, in the NVS partition
+ * on the ESP32. Keys are grouped in namespaces; names are at most 15
+ * characters. A value is written at once: after a power loss it holds
+ * either the old or the new content.
+ */
+
+/**
+ * @brief Reads a blob.
+ *
+ * @param space Namespace.
+ * @param key Key.
+ * @param data (Output) Value, left untouched if not found.
+ * @param length Expected length in bytes.
+ * @return true if a blob of exactly this length was read, false otherwise.
+ */
+bool hal_nvs_get(const char *space, const char *key, void *data, size_t length);
+
+/**
+ * @brief Writes a blob, replacing the previous value.
+ *
+ * @param space Namespace.
+ * @param key Key.
+ * @param data Value.
+ * @param length Length in bytes.
+ * @return true if the value was written, false otherwise.
+ */
+bool hal_nvs_set(const char *space, const char *key, const void *data, size_t length);
+
+/**
+ * @brief Reads a 64-bit counter.
+ *
+ * Counters and blobs are different types, as in the ESP-IDF NVS: a key
+ * written with hal_nvs_set() is not found here.
+ *
+ * @param space Namespace.
+ * @param key Key.
+ * @param value (Output) Value, left untouched if not found.
+ * @return true if the counter was read, false otherwise.
+ */
+bool hal_nvs_get_u64(const char *space, const char *key, uint64_t *value);
+
+/**
+ * @brief Writes a 64-bit counter.
+ *
+ * @param space Namespace.
+ * @param key Key.
+ * @param value Value.
+ * @return true if the value was written, false otherwise.
+ */
+bool hal_nvs_set_u64(const char *space, const char *key, uint64_t value);
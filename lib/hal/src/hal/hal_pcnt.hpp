@@ -0,0 +1,28 @@
+#pragma once
+
+#include <stdint.h>
+
+#define HAL_PCNT_UNIT_COUNT 8 // Pulse counter units of the ESP32
+
+/**
+ * @brief Routes a pin to a pulse counter unit counting both edges.
+ *
+ * Edges are counted by hardware, no CPU time is used per edge.
+ *
+ * @param unit Counter unit (0 - HAL_PCNT_UNIT_COUNT - 1).
+ * @param pin GPIO number, configured as input.
+ * @param filter_ns Pulses shorter than this are ignored (at most about 12 us), 0 to disable the filter.
+ * @return true if the unit was configured, false otherwise.
+ */
+bool hal_pcnt_attach(uint8_t unit, uint8_t pin, uint32_t filter_ns);
+
+/**
+ * @brief Returns the number of edges counted since the previous call.
+ *
+ * The counter keeps running, no edge is lost between calls as long as
+ * fewer than 32767 edges occur in between.
+ *
+ * @param unit Counter unit.
+ * @return Edges since the previous call (or since hal_pcnt_attach()).
+ */
+uint32_t hal_pcnt_take(uint8_t unit);
@@ -0,0 +1,25 @@
+#pragma once
+
+#include <stdint.h>
+
+#define HAL_PWM_CHANNEL_COUNT 16 // LEDC channels of the ESP32
+
+/**
+ * @brief Routes a PWM channel to a pin, output starts silent.
+ *
+ * @param channel PWM channel (0 - HAL_PWM_CHANNEL_COUNT - 1).
+ * @param pin GPIO number.
+ * @return true if the channel was configured, false otherwise.
+ */
+bool hal_pwm_attach(uint8_t channel, uint8_t pin);
+
+/**
+ * @brief Outputs a 50% duty square wave on a channel.
+ *
+ * The waveform is generated by hardware, no CPU time is used until the
+ * next call.
+ *
+ * @param channel PWM channel.
+ * @param freq_hz Frequency in Hz, 0 to keep the output low.
+ */
+void hal_pwm_tone(uint8_t channel, uint32_t freq_hz);
@@ -0,0 +1,116 @@
+#pragma once
+
+#include <stddef.h>
+#include <stdint.h>
+
+#define HAL_WAIT_FOREVER UINT32_MAX
+
+typedef void *hal_task_t;  ///< Task handle.
+typedef void *hal_mutex_t; ///< Mutex handle.
+typedef void *hal_queue_t; ///< Queue handle.
+
+/// Task entry point, must never return.
+typedef void (*hal_task_fn_t)(void *arg);
+
+/**
+ * @brief Creates a task pinned to a core.
+ *
+ * @param fn Task entry point.
+ * @param name Task name.
+ * @param stack_size Stack size in bytes (ignored on the host).
+ * @param arg Argument passed to the task.
+ * @param priority Task priority (ignored on the host).
+ * @param handle (Output) Task handle, may be NULL.
+ * @param core Core the task is pinned to (ignored on the host).
+ * @return true if the task was created, false otherwise.
+ */
+bool hal_task_create(hal_task_fn_t fn, const char *name, uint32_t stack_size, void *arg,
+                     uint8_t priority, hal_task_t *handle, int core);
+
+/**
+ * @brief Returns the handle of the calling task.
+ */
+hal_task_t hal_task_current();
+
+/**
+ * @brief Wakes a task waiting in hal_task_wait_notify().
+ *
+ * @param task Task to notify.
+ */
+void hal_task_notify(hal_task_t task);
+
+/**
+ * @brief Interrupt-safe variant of hal_task_notify().
+ *
+ * @param task Task to notify.
+ */
+void hal_task_notify_from_isr(hal_task_t task);
+
+/**
+ * @brief Waits for a notification sent to the calling task.
+ *
+ * @param timeout_ms Maximum wait time (HAL_WAIT_FOREVER to wait indefinitely).
+ * @return true if a notification was received, false on timeout.
+ */
+bool hal_task_wait_notify(uint32_t timeout_ms);
+
+/**
+ * @brief Creates a mutex.
+ *
+ * @return Mutex handle, NULL on failure.
+ */
+hal_mutex_t hal_mutex_create();
+
+/**
+ * @brief Takes a mutex.
+ *
+ * @param mutex Mutex handle.
+ * @param timeout_ms Maximum wait time (HAL_WAIT_FOREVER to wait indefinitely).
+ * @return true if the mutex was taken, false on timeout.
+ */
+bool hal_mutex_take(hal_mutex_t mutex, uint32_t timeout_ms);
+
+/**
+ * @brief Releases a mutex.
+ *
+ * @param mutex Mutex handle.
+ */
+void hal_mutex_give(hal_mutex_t mutex);
+
+/**
+ * @brief Creates a fixed-size queue.
+ *
+ * @param length Maximum number of items.
+ * @param item_size Size of one item in bytes.
+ * @return Queue handle, NULL on failure.
+ */
+hal_queue_t hal_queue_create(size_t length, size_t item_size);
+
+/**
+ * @brief Copies an item to the back of a queue.
+ *
+ * @param queue Queue handle.
+ * @param item Item to copy.
+ * @param timeout_ms Maximum wait for free space (0 to fail immediately when full).
+ * @return true if the item was queued, false otherwise.
+ */
+bool hal_queue_send(hal_queue_t queue, const void *item, uint32_t timeout_ms);
+
+/**
+ * @brief Interrupt-safe variant of hal_queue_send() that never blocks.
+ *
+ * @param queue Queue handle.
+ * @param item Item to copy.
+ * @return true if the item was queued, false if the queue was full.
+ */
+bool hal_queue_send_from_isr(hal_queue_t queue, const void *item);
+
+/**
+ * @brief Takes an item from the front of a queue.
+ *
+ * @param queue Queue handle.
+ * @param item (Output) Buffer receiving the item.
+ * @param timeout_ms Maximum wait for an item (HAL_WAIT_FOREVER to wait indefinitely).
+ * @return true if an item was received, false on timeout.
+ */
+bool hal_queue_receive(hal_queue_t queue, void *item, uint32_t timeout_ms);
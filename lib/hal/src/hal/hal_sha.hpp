@@ -0,0 +1,18 @@
+#pragma once
+
+#include <stddef.h>
+#include <stdint.h>
+
+#define HAL_SHA256_LENGTH 32
+
+/**
+ * @brief Computes the SHA-256 digest of a buffer.
+ *
+ * On the ESP32 the hash runs on the SHA accelerator, waiting if another
+ * task is using it; the host computes it in software.
+ *
+ * @param data Data to hash.
+ * @param length Data length in bytes.
+ * @param digest (Output) Digest.
+ */
+void hal_sha256(const void *data, size_t length, uint8_t digest[HAL_SHA256_LENGTH]);
@@ -0,0 +1,82 @@
+#pragma once
+
+#include <stdint.h>
+
+#if defined(ARDUINO)
+#include "esp_attr.h"
+#define HAL_RETAINED RTC_DATA_ATTR // Kept in RTC memory across deep sleep
+#define HAL_NOINIT RTC_NOINIT_ATTR // Kept in RTC memory across deep sleep and resets, never initialized
+#else
+#define HAL_RETAINED
+#define HAL_NOINIT
+#endif
+
+#define HAL_SLEEP_MAX_WAKE_PINS 16
+
+/// Reason of the last wake-up.
+enum HalWakeCause : uint8_t
+{
+    HAL_WAKE_NONE,  ///< Power-on or reset, not a wake from sleep.
+    HAL_WAKE_GPIO,  ///< A wake pin reached its level.
+    HAL_WAKE_TIMER, ///< The sleep timer expired.
+};
+
+/**
+ * @brief Adds a pin that wakes the chip when it reaches a level.
+ *
+ * Light sleep supports any level on any pin. Deep sleep only supports RTC
+ * pins: all HIGH pins share the ext1 "any high" source and at most one
+ * LOW pin can use ext0.
+ *
+ * @param pin GPIO number.
+ * @param level HAL_HIGH or HAL_LOW.
+ * @return true if the pin was added, false if no slot is left.
+ */
+bool hal_sleep_add_wake_pin(uint8_t pin, int level);
+
+/**
+ * @brief Removes all wake pins.
+ */
+void hal_sleep_clear_wake_pins();
+
+/**
+ * @brief Sets a wake-up timer for the next sleep.
+ *
+ * @param timeout_us Sleep duration limit in microseconds, 0 for none.
+ */
+void hal_sleep_set_timer(uint64_t timeout_us);
+
+/**
+ * @brief Enters light sleep until a wake source fires.
+ *
+ * All tasks are frozen and RAM is kept, execution resumes after the call.
+ *
+ * @return Reason of the wake-up.
+ */
+HalWakeCause hal_light_sleep();
+
+/**
+ * @brief Enters deep sleep, the chip reboots when a wake source fires.
+ *
+ * Only HAL_RETAINED variables survive. Does not return.
+ */
+void hal_deep_sleep();
+
+/**
+ * @brief Returns the reason of the last wake-up (from light sleep or at boot).
+ */
+HalWakeCause hal_wake_cause();
+
+/**
+ * @brief Returns the wake pins that were at their level when the chip woke.
+ *
+ * @return Bit mask of GPIO numbers.
+ */
+uint64_t hal_wake_pins();
+
+/**
+ * @brief Returns the wake pins currently at their level, to catch sensors while awake between sleeps.
+ *
+ * @return Bit mask of GPIO numbers.
+ */
+uint64_t hal_sleep_active_wake_pins();
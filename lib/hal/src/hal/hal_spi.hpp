@@ -0,0 +1,27 @@
+#pragma once
+
+#include <stddef.h>
+#include <stdint.h>
+
+/**
+ * @brief Initializes the SPI master.
+ *
+ * @param sck GPIO used for SCK.
+ * @param miso GPIO used for MISO.
+ * @param mosi GPIO used for MOSI.
+ * @return true if the bus was initialized, false otherwise.
+ */
+bool hal_spi_begin(uint8_t sck, uint8_t miso, uint8_t mosi);
+
+/**
+ * @brief Performs a full-duplex transfer with one device (mode 0, MSB first).
+ *
+ * The chip select pin is driven low for the duration of the transfer.
+ *
+ * @param cs GPIO used as chip select.
+ * @param clock_hz SPI clock for this device.
+ * @param tx Bytes to send (may be NULL to send zeros).
+ * @param rx Buffer for the received bytes (may be NULL).
+ * @param length Number of bytes to transfer.
+ */
+void hal_spi_transfer(uint8_t cs, uint32_t clock_hz, const uint8_t *tx, uint8_t *rx, size_t length);
@@ -0,0 +1,46 @@
+#pragma once
+
+#include <stdint.h>
+
+/// Reason of the last reset.
+enum HalResetReason : uint8_t
+{
+    HAL_RESET_POWER_ON,   ///< Power-on.
+    HAL_RESET_SOFTWARE,   ///< Restart requested by the firmware.
+    HAL_RESET_PANIC,      ///< Exception or abort.
+    HAL_RESET_WATCHDOG,   ///< Interrupt or task watchdog.
+    HAL_RESET_BROWNOUT,   ///< Supply voltage dropped too low.
+    HAL_RESET_DEEP_SLEEP, ///< Wake-up from deep sleep.
+    HAL_RESET_OTHER,      ///< Any other reason.
+};
+
+/**
+ * @brief Opens the console used for logging.
+ *
+ * On the ESP32 this starts the serial port and waits until it is ready.
+ *
+ * @param baud Serial baud rate (ignored on the host).
+ */
+void hal_console_begin(uint32_t baud);
+
+/**
+ * @brief Writes a formatted line on the console regardless of the log level.
+ *
+ * @param format printf-style format string.
+ */
+void hal_console_printf(const char *format, ...) __attribute__((format(printf, 1, 2)));
+
+/**
+ * @brief Returns the current amount of free heap in bytes.
+ */
+uint32_t hal_free_heap();
+
+/**
+ * @brief Returns the lowest amount of free heap seen since boot in bytes.
+ */
+uint32_t hal_min_free_heap();
+
+/**
+ * @brief Returns the reason of the last reset.
+ */
+HalResetReason hal_reset_reason();
@@ -0,0 +1,42 @@
+#pragma once
+
+#include <stdint.h>
+
+/**
+ * @brief Returns the number of milliseconds since boot.
+ */
+uint32_t hal_millis();
+
+/**
+ * @brief Returns the number of microseconds since boot.
+ */
+uint64_t hal_micros();
+
+/**
+ * @brief Blocks the calling task for the given time.
+ *
+ * @param ms Delay in milliseconds.
+ */
+void hal_delay_ms(uint32_t ms);
+
+/**
+ * @brief Waits for a short time without yielding, e.g. between the edges of a bit-banged signal.
+ *
+ * @param us Delay in microseconds.
+ */
+void hal_delay_us(uint32_t us);
+
+/**
+ * @brief Starts setting the wall clock from an NTP server, in the background.
+ *
+ * @param server NTP server name.
+ */
+void hal_clock_sync(const char *server);
+
+/**
+ * @brief Returns the wall clock in milliseconds since the Unix epoch.
+ *
+ * Counts from boot until the clock is set: callers compare it with a
+ * recent date to know if it is.
+ */
+uint64_t hal_unix_ms();
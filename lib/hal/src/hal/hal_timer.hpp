@@ -0,0 +1,47 @@
+#pragma once
+
+#include <stdint.h>
+
+typedef void *hal_timer_t; ///< Software timer handle.
+
+/// Timer callback, runs in the timer service task (never in an ISR).
+typedef void (*hal_timer_cb_t)(void *arg);
+
+/**
+ * @brief Creates a stopped high-resolution timer.
+ *
+ * @param name Timer name used for debugging.
+ * @param callback Function called when the timer expires.
+ * @param arg Argument passed to the callback.
+ * @return Timer handle, NULL on failure.
+ */
+hal_timer_t hal_timer_create(const char *name, hal_timer_cb_t callback, void *arg);
+
+/**
+ * @brief Starts a timer that fires once.
+ *
+ * Restarts the timer if it is already running.
+ *
+ * @param timer Timer handle.
+ * @param timeout_us Time until the callback in microseconds.
+ * @return true if the timer was started, false otherwise.
+ */
+bool hal_timer_start_once(hal_timer_t timer, uint64_t timeout_us);
+
+/**
+ * @brief Starts a timer that fires periodically.
+ *
+ * Restarts the timer if it is already running.
+ *
+ * @param timer Timer handle.
+ * @param period_us Period in microseconds.
+ * @return true if the timer was started, false otherwise.
+ */
+bool hal_timer_start_periodic(hal_timer_t timer, uint64_t period_us);
+
+/**
+ * @brief Stops a timer, does nothing if it is not running.
+ *
+ * @param timer Timer handle.
+ */
+void hal_timer_stop(hal_timer_t timer);
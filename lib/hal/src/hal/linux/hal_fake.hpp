@@ -0,0 +1,230 @@
+#pragma once
+
+/*
+ * Fake peripherals of the Linux backend.
+ *
+ * Tests, benchmarks and simulations drive the inputs and observe the
+ * outputs of a node through these functions instead of real hardware.
+ */
+
+#include <stddef.h>
+#include <stdint.h>
+#include "../hal_sleep.hpp"
+#include "../hal_system.hpp"
+
+#define HAL_FAKE_GPIO_COUNT 40 // GPIO numbers of the ESP32
+
+/// Called on every hal_gpio_write() to a pin.
+typedef void (*hal_fake_gpio_write_hook_t)(uint8_t pin, int level, uint64_t time_us, void *ctx);
+
+/// Produces the sample of an analog input at a point in time (e.g. from a recording).
+typedef uint16_t (*hal_fake_adc_stream_t)(void *ctx, uint64_t time_us);
+
+/// Called on every hal_pwm_tone() of a channel, with the pin it drives.
+typedef void (*hal_fake_pwm_hook_t)(uint8_t pin, uint32_t freq_hz, uint64_t time_us, void *ctx);
+
+/// Emulates an I2C device: handles one write/read transfer, returns false to NACK.
+typedef bool (*hal_fake_i2c_device_t)(void *ctx, const uint8_t *tx, size_t tx_length, uint8_t *rx, size_t rx_length);
+
+/// Emulates an SPI device: handles one full-duplex transfer.
+typedef void (*hal_fake_spi_device_t)(void *ctx, const uint8_t *tx, uint8_t *rx, size_t length);
+
+/**
+ * @brief Drives the level seen on an input pin.
+ *
+ * Runs the attached interrupt handler synchronously if the change matches its edge.
+ *
+ * @param pin GPIO number.
+ * @param level HAL_HIGH or HAL_LOW.
+ */
+void hal_fake_gpio_set_input(uint8_t pin, int level);
+
+/**
+ * @brief Returns the level last written to an output pin.
+ *
+ * @param pin GPIO number.
+ * @return HAL_HIGH or HAL_LOW.
+ */
+int hal_fake_gpio_get_output(uint8_t pin);
+
+/**
+ * @brief Returns the number of writes to a pin since the last reset.
+ *
+ * @param pin GPIO number.
+ */
+uint32_t hal_fake_gpio_write_count(uint8_t pin);
+
+/**
+ * @brief Installs a hook observing every GPIO write (NULL to remove it).
+ *
+ * @param hook Function called on every write.
+ * @param ctx Argument passed to the hook.
+ */
+void hal_fake_gpio_set_write_hook(hal_fake_gpio_write_hook_t hook, void *ctx);
+
+/**
+ * @brief Sets the value returned by hal_adc_read() for a pin.
+ *
+ * @param pin GPIO number.
+ * @param value Raw conversion result (0 - HAL_ADC_MAX).
+ */
+void hal_fake_adc_set(uint8_t pin, uint16_t value);
+
+/**
+ * @brief Feeds an analog input from a function of time (NULL to go back to hal_fake_adc_set()).
+ *
+ * Used by single conversions and by continuous sampling, which asks for
+ * every sample at its exact sampling time.
+ *
+ * @param pin GPIO number.
+ * @param stream Sample source.
+ * @param ctx Argument passed to the source.
+ */
+void hal_fake_adc_set_stream(uint8_t pin, hal_fake_adc_stream_t stream, void *ctx);
+
+/**
+ * @brief Returns the tone currently output on a pin by a PWM channel.
+ *
+ * @param pin GPIO number.
+ * @return Frequency in Hz, 0 if silent.
+ */
+uint32_t hal_fake_pwm_get_tone(uint8_t pin);
+
+/**
+ * @brief Installs a hook observing every PWM tone change (NULL to remove it).
+ *
+ * Together with hal_fake_gpio_set_write_hook() this records the output
+ * waveform of a node.
+ *
+ * @param hook Function called on every change.
+ * @param ctx Argument passed to the hook.
+ */
+void hal_fake_pwm_set_hook(hal_fake_pwm_hook_t hook, void *ctx);
+
+/**
+ * @brief Attaches an emulated device to the I2C bus (NULL to detach it).
+ *
+ * @param address 7-bit device address.
+ * @param device Transfer handler.
+ * @param ctx Argument passed to the handler.
+ */
+void hal_fake_i2c_attach(uint8_t address, hal_fake_i2c_device_t device, void *ctx);
+
+/**
+ * @brief Makes a device stretch the clock on every transfer (0 to stop).
+ *
+ * Under the simulator the transfer takes that much longer; a stretch
+ * reaching the timeout set with hal_i2c_set_timeout() fails the transfer
+ * after the timeout, as the master gives up.
+ *
+ * @param address 7-bit device address.
+ * @param stretch_us Clock stretching per transfer in microseconds.
+ */
+void hal_fake_i2c_stretch(uint8_t address, uint32_t stretch_us);
+
+/**
+ * @brief Models a device holding SDA low, e.g. after a reset in the middle of a read.
+ *
+ * SDA reads low and every transfer fails until SCL has been pulsed the
+ * given number of times as a GPIO (low then high), the bits the device
+ * still wants to shift out.
+ *
+ * @param pulses Clock pulses until the device releases SDA, 0 to release it now.
+ */
+void hal_fake_i2c_hold_sda(uint32_t pulses);
+
+/**
+ * @brief Attaches an emulated device to an SPI chip select (NULL to detach it).
+ *
+ * @param cs GPIO used as chip select.
+ * @param device Transfer handler.
+ * @param ctx Argument passed to the handler.
+ */
+void hal_fake_spi_attach(uint8_t cs, hal_fake_spi_device_t device, void *ctx);
+
+/**
+ * @brief Replays a recorded edge trace on a pin routed to a pulse counter.
+ *
+ * Edge times are relative to this call. Edges are consumed when the
+ * counter is read: pulses shorter than the unit filter are dropped, the
+ * others are counted and toggle the input level of the pin. Edges set
+ * with hal_fake_gpio_set_input() are counted as well.
+ *
+ * @param pin GPIO number.
+ * @param edge_times_us Edge times in microseconds, ascending. Must stay valid while the trace plays.
+ * @param count Number of edges.
+ */
+void hal_fake_pcnt_play_trace(uint8_t pin, const uint32_t *edge_times_us, size_t count);
+
+/**
+ * @brief Sets the wake cause reported by hal_wake_cause(), e.g. to model a boot from deep sleep.
+ *
+ * @param cause Wake cause.
+ * @param pins Bit mask of the pins that woke the chip.
+ */
+void hal_fake_set_wake_cause(HalWakeCause cause, uint64_t pins);
+
+/**
+ * @brief Returns the total time spent in hal_light_sleep().
+ */
+uint64_t hal_fake_slept_us();
+
+/**
+ * @brief Sets the reason reported by hal_reset_reason(), e.g. to model a watchdog reset.
+ *
+ * @param reason Reset reason.
+ */
+void hal_fake_set_reset_reason(HalResetReason reason);
+
+/**
+ * @brief Adds a data partition found by hal_partition_find().
+ *
+ * Flash content survives hal_fake_reset(); with a file it also survives
+ * the process, like the flash of a node across reboots.
+ *
+ * @param label Partition label.
+ * @param size Size in bytes, a multiple of HAL_FLASH_SECTOR_SIZE.
+ * @param path File holding the content (created erased if missing), NULL to keep it in memory.
+ * @return true if the partition was added, false otherwise.
+ */
+bool hal_fake_flash_add_partition(const char *label, size_t size, const char *path);
+
+/**
+ * @brief Returns the highest erase count of any sector of a partition, to check wear.
+ *
+ * @param label Partition label.
+ */
+uint32_t hal_fake_flash_max_erases(const char *label);
+
+/**
+ * @brief Erases every NVS key, like a new chip.
+ *
+ * NVS content survives hal_fake_reset(), like the NVS partition across reboots.
+ */
+void hal_fake_nvs_erase();
+
+/**
+ * @brief Sets the directory holding the files of hal_fs_path(), before hal_fs_mount().
+ *
+ * Without it, hal_fs_mount() creates an empty directory under /tmp. Files
+ * survive hal_fake_reset(); in a directory kept by the test they also
+ * survive the process.
+ *
+ * @param dir Existing directory, at most 31 characters.
+ * @return true if the directory was set, false if its path is too long.
+ */
+bool hal_fake_fs_set_root(const char *dir);
+
+/**
+ * @brief Sets the wall clock returned by hal_unix_ms(), as an NTP synchronization would.
+ *
+ * The clock survives hal_fake_reset(), like the RTC across a software reset.
+ *
+ * @param unix_ms Current time in milliseconds since the Unix epoch.
+ */
+void hal_fake_clock_set(uint64_t unix_ms);
+
+/**
+ * @brief Restores all fake peripherals to their power-on state.
+ */
+void hal_fake_reset();
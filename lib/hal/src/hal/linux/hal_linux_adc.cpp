@@ -0,0 +1,191 @@
+#if defined(HAL_LINUX)
+
+#include <atomic>
+#include <pthread.h>
+#include <vector>
+#include "../hal_adc.hpp"
+#include "../hal_time.hpp"
+#include "../hal_timer.hpp"
+#include "hal_fake.hpp"
+#include "hal_linux_internal.hpp"
+
+struct FakeAdcStream
+{
+    hal_fake_adc_stream_t stream;
+    void *ctx;
+};
+
+struct FakeAdcContinuous
+{
+    bool running;
+    bool paused; // The DMA stops during light sleep
+    uint8_t pins[HAL_ADC_CONTINUOUS_MAX_PINS];
+    uint8_t pin_count;
+    uint32_t sample_rate_hz;
+    size_t block_frames;
+    hal_adc_block_cb_t callback;
+    void *arg;
+    uint64_t next_frame; // Index of the next frame since the start
+    uint64_t start_us;
+    std::vector<uint16_t> block;
+};
+
+static std::atomic<uint16_t> s_adc_values[HAL_FAKE_GPIO_COUNT];
+static pthread_mutex_t s_adc_mutex = PTHREAD_MUTEX_INITIALIZER;
+static FakeAdcStream s_streams[HAL_FAKE_GPIO_COUNT];
+static FakeAdcContinuous s_continuous;
+static hal_timer_t s_block_timer = NULL;
+
+static uint16_t sample(uint8_t pin, uint64_t time_us)
+{
+    FakeAdcStream stream = s_streams[pin];
+    if (stream.stream == NULL)
+    {
+        return s_adc_values[pin].load();
+    }
+    uint16_t value = stream.stream(stream.ctx, time_us);
+    return value > HAL_ADC_MAX ? HAL_ADC_MAX : value;
+}
+
+/* Produces one block from the values or streams of the sampled pins */
+static void block_timer_callback(void *)
+{
+    pthread_mutex_lock(&s_adc_mutex);
+    if (!s_continuous.running || s_continuous.paused)
+    {
+        pthread_mutex_unlock(&s_adc_mutex);
+        return;
+    }
+    for (size_t frame = 0; frame < s_continuous.block_frames; frame++)
+    {
+        uint64_t time_us = s_continuous.start_us + s_continuous.next_frame * 1000000ULL / s_continuous.sample_rate_hz;
+        for (int i = 0; i < s_continuous.pin_count; i++)
+        {
+            s_continuous.block[frame * s_continuous.pin_count + i] = sample(s_continuous.pins[i], time_us);
+        }
+        s_continuous.next_frame++;
+    }
+    hal_adc_block_cb_t callback = s_continuous.callback;
+    void *callback_arg = s_continuous.arg;
+    std::vector<uint16_t> block = s_continuous.block;
+    size_t frames = s_continuous.block_frames;
+    pthread_mutex_unlock(&s_adc_mutex);
+
+    callback(block.data(), frames, callback_arg);
+}
+
+uint16_t hal_adc_read(uint8_t pin)
+{
+    if (pin >= HAL_FAKE_GPIO_COUNT)
+    {
+        return 0;
+    }
+    pthread_mutex_lock(&s_adc_mutex);
+    uint16_t value = sample(pin, hal_micros());
+    pthread_mutex_unlock(&s_adc_mutex);
+    return value;
+}
+
+bool hal_adc_continuous_start(const uint8_t *pins, uint8_t pin_count, uint32_t sample_rate_hz, size_t block_frames, hal_adc_block_cb_t callback, void *arg)
+{
+    if (pin_count == 0 || pin_count > HAL_ADC_CONTINUOUS_MAX_PINS || sample_rate_hz == 0 || block_frames == 0 || callback == NULL)
+    {
+        return false;
+    }
+
+    pthread_mutex_lock(&s_adc_mutex);
+    if (s_continuous.running)
+    {
+        pthread_mutex_unlock(&s_adc_mutex);
+        return false;
+    }
+    for (int i = 0; i < pin_count; i++)
+    {
+        if (pins[i] >= HAL_FAKE_GPIO_COUNT)
+        {
+            pthread_mutex_unlock(&s_adc_mutex);
+            return false;
+        }
+        s_continuous.pins[i] = pins[i];
+    }
+    s_continuous.pin_count = pin_count;
+    s_continuous.sample_rate_hz = sample_rate_hz;
+    s_continuous.block_frames = block_frames;
+    s_continuous.callback = callback;
+    s_continuous.arg = arg;
+    s_continuous.next_frame = 0;
+    s_continuous.start_us = hal_micros();
+    s_continuous.block.assign(block_frames * pin_count, 0);
+    s_continuous.paused = false;
+    s_continuous.running = true;
+    pthread_mutex_unlock(&s_adc_mutex);
+
+    if (s_block_timer == NULL)
+    {
+        s_block_timer = hal_timer_create("hal_adc", block_timer_callback, NULL);
+    }
+    return hal_timer_start_periodic(s_block_timer, block_frames * 1000000ULL / sample_rate_hz);
+}
+
+void hal_adc_continuous_stop()
+{
+    pthread_mutex_lock(&s_adc_mutex);
+    s_continuous.running = false;
+    pthread_mutex_unlock(&s_adc_mutex);
+
+    if (s_block_timer != NULL)
+    {
+        hal_timer_stop(s_block_timer);
+    }
+}
+
+void hal_fake_adc_pause(bool paused)
+{
+    pthread_mutex_lock(&s_adc_mutex);
+    if (s_continuous.paused && !paused)
+    {
+        // The frames of the pause are lost, sampling resumes at the current time
+        s_continuous.next_frame = (hal_micros() - s_continuous.start_us) * s_continuous.sample_rate_hz / 1000000ULL;
+    }
+    s_continuous.paused = paused;
+    pthread_mutex_unlock(&s_adc_mutex);
+}
+
+void hal_fake_adc_set(uint8_t pin, uint16_t value)
+{
+    if (pin >= HAL_FAKE_GPIO_COUNT)
+    {
+        return;
+    }
+    s_adc_values[pin].store(value > HAL_ADC_MAX ? HAL_ADC_MAX : value);
+}
+
+void hal_fake_adc_set_stream(uint8_t pin, hal_fake_adc_stream_t stream, void *ctx)
+{
+    if (pin >= HAL_FAKE_GPIO_COUNT)
+    {
+        return;
+    }
+    pthread_mutex_lock(&s_adc_mutex);
+    s_streams[pin].stream = stream;
+    s_streams[pin].ctx = ctx;
+    pthread_mutex_unlock(&s_adc_mutex);
+}
+
+void hal_fake_adc_reset()
+{
+    hal_adc_continuous_stop();
+    for (auto &value : s_adc_values)
+    {
+        value.store(0);
+    }
+    pthread_mutex_lock(&s_adc_mutex);
+    for (auto &stream : s_streams)
+    {
+        stream.stream = NULL;
+        stream.ctx = NULL;
+    }
+    pthread_mutex_unlock(&s_adc_mutex);
+}
+
+#endif // HAL_LINUX
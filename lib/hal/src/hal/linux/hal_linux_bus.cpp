@@ -0,0 +1,243 @@
+#if defined(HAL_LINUX)
+
+#include <pthread.h>
+#include <string.h>
+#include "../hal_gpio.hpp"
+#include "../hal_i2c.hpp"
+#include "../hal_spi.hpp"
+#include "hal_fake.hpp"
+#include "hal_linux_internal.hpp"
+#include "hal_sim.hpp"
+
+struct FakeI2cDevice
+{
+    hal_fake_i2c_device_t handler;
+    void *ctx;
+};
+
+struct FakeSpiDevice
+{
+    hal_fake_spi_device_t handler;
+    void *ctx;
+};
+
+static pthread_mutex_t s_bus_mutex = PTHREAD_MUTEX_INITIALIZER;
+static FakeI2cDevice s_i2c_devices[128];
+static FakeSpiDevice s_spi_devices[HAL_FAKE_GPIO_COUNT];
+
+/* I2C master and bus faults */
+static uint8_t s_i2c_sda = 0xFF, s_i2c_scl = 0xFF; // Pins of the last hal_i2c_begin()
+static uint32_t s_i2c_frequency = 0;             // 0 while the master is stopped
+static uint16_t s_i2c_timeout_ms = 50;           // Default of the Arduino Wire library
+static uint32_t s_i2c_stretch_us[128];
+static uint32_t s_i2c_sda_held = 0; // SCL pulses until a stuck device releases SDA
+static bool s_i2c_scl_low = false;
+
+bool hal_i2c_begin(uint8_t sda, uint8_t scl, uint32_t frequency)
+{
+    if (sda >= HAL_FAKE_GPIO_COUNT || scl >= HAL_FAKE_GPIO_COUNT || frequency == 0)
+    {
+        return false;
+    }
+    pthread_mutex_lock(&s_bus_mutex);
+    s_i2c_sda = sda;
+    s_i2c_scl = scl;
+    s_i2c_frequency = frequency;
+    bool held = s_i2c_sda_held > 0;
+    pthread_mutex_unlock(&s_bus_mutex);
+
+    // The master owns the pins, reading them gives the level of the bus
+    hal_gpio_mode(sda, HAL_INPUT);
+    hal_gpio_mode(scl, HAL_INPUT);
+    hal_fake_gpio_store_input(sda, held ? HAL_LOW : HAL_HIGH);
+    hal_fake_gpio_store_input(scl, HAL_HIGH);
+    return true;
+}
+
+void hal_i2c_end()
+{
+    pthread_mutex_lock(&s_bus_mutex);
+    s_i2c_frequency = 0;
+    pthread_mutex_unlock(&s_bus_mutex);
+}
+
+void hal_i2c_set_timeout(uint16_t timeout_ms)
+{
+    pthread_mutex_lock(&s_bus_mutex);
+    s_i2c_timeout_ms = timeout_ms;
+    pthread_mutex_unlock(&s_bus_mutex);
+}
+
+bool hal_i2c_write(uint8_t address, const uint8_t *data, size_t length)
+{
+    return hal_i2c_write_read(address, data, length, NULL, 0);
+}
+
+bool hal_i2c_write_read(uint8_t address, const uint8_t *tx, size_t tx_length, uint8_t *rx, size_t rx_length)
+{
+    if (address >= 128)
+    {
+        return false;
+    }
+    pthread_mutex_lock(&s_bus_mutex);
+    FakeI2cDevice device = s_i2c_devices[address];
+    uint32_t frequency = s_i2c_frequency;
+    uint64_t timeout_us = s_i2c_timeout_ms * 1000ULL;
+    uint64_t stretch_us = s_i2c_stretch_us[address];
+    bool held = s_i2c_sda_held > 0;
+    pthread_mutex_unlock(&s_bus_mutex);
+
+    if (frequency == 0)
+    {
+        return false;
+    }
+
+    // 9 clocks per byte with its acknowledge, plus the start and stop conditions
+    uint64_t bits = 2 + (tx_length > 0 ? 9 * (tx_length + 1) : 0) + (rx_length > 0 ? 9 * (rx_length + 1) : 0);
+    bool ok = true;
+    if (held)
+    {
+        bits = 2; // The master loses arbitration at the start
+        ok = false;
+    }
+    else if (device.handler == NULL)
+    {
+        bits = 11; // Nobody acknowledges the address
+        ok = false;
+    }
+    else if (stretch_us >= timeout_us)
+    {
+        bits = 0;
+        stretch_us = timeout_us; // The master gives up
+        ok = false;
+    }
+
+    if (hal_sim_active())
+    {
+        // Transfers take their time on the wire, so the bus load shows in simulated latencies
+        sim_sleep_us(stretch_us + (bits * 1000000ULL + frequency - 1) / frequency);
+    }
+    return ok && device.handler(device.ctx, tx, tx_length, rx, rx_length);
+}
+
+bool hal_spi_begin(uint8_t sck, uint8_t miso, uint8_t mosi)
+{
+    (void)sck;
+    (void)miso;
+    (void)mosi;
+    return true;
+}
+
+void hal_spi_transfer(uint8_t cs, uint32_t clock_hz, const uint8_t *tx, uint8_t *rx, size_t length)
+{
+    if (hal_sim_active() && clock_hz > 0)
+    {
+        // Transfers take their time on the wire, so the SPI clock shows in simulated latencies
+        sim_sleep_us(((uint64_t)length * 8 * 1000000ULL + clock_hz - 1) / clock_hz);
+    }
+
+    FakeSpiDevice device = {NULL, NULL};
+    if (cs < HAL_FAKE_GPIO_COUNT)
+    {
+        pthread_mutex_lock(&s_bus_mutex);
+        device = s_spi_devices[cs];
+        pthread_mutex_unlock(&s_bus_mutex);
+    }
+
+    if (device.handler == NULL)
+    {
+        if (rx != NULL)
+        {
+            memset(rx, 0xFF, length); // MISO floats high without a device
+        }
+        return;
+    }
+    device.handler(device.ctx, tx, rx, length);
+}
+
+void hal_fake_i2c_attach(uint8_t address, hal_fake_i2c_device_t device, void *ctx)
+{
+    if (address >= 128)
+    {
+        return;
+    }
+    pthread_mutex_lock(&s_bus_mutex);
+    s_i2c_devices[address].handler = device;
+    s_i2c_devices[address].ctx = ctx;
+    pthread_mutex_unlock(&s_bus_mutex);
+}
+
+void hal_fake_spi_attach(uint8_t cs, hal_fake_spi_device_t device, void *ctx)
+{
+    if (cs >= HAL_FAKE_GPIO_COUNT)
+    {
+        return;
+    }
+    pthread_mutex_lock(&s_bus_mutex);
+    s_spi_devices[cs].handler = device;
+    s_spi_devices[cs].ctx = ctx;
+    pthread_mutex_unlock(&s_bus_mutex);
+}
+
+void hal_fake_i2c_stretch(uint8_t address, uint32_t stretch_us)
+{
+    if (address >= 128)
+    {
+        return;
+    }
+    pthread_mutex_lock(&s_bus_mutex);
+    s_i2c_stretch_us[address] = stretch_us;
+    pthread_mutex_unlock(&s_bus_mutex);
+}
+
+void hal_fake_i2c_hold_sda(uint32_t pulses)
+{
+    pthread_mutex_lock(&s_bus_mutex);
+    s_i2c_sda_held = pulses;
+    s_i2c_scl_low = false;
+    uint8_t sda = s_i2c_sda;
+    pthread_mutex_unlock(&s_bus_mutex);
+
+    hal_fake_gpio_store_input(sda, pulses > 0 ? HAL_LOW : HAL_HIGH);
+}
+
+void hal_fake_i2c_pin_written(uint8_t pin, int level)
+{
+    pthread_mutex_lock(&s_bus_mutex);
+    bool released = false;
+    if (pin == s_i2c_scl && s_i2c_sda_held > 0)
+    {
+        if (level == HAL_LOW)
+        {
+            s_i2c_scl_low = true;
+        }
+        else if (s_i2c_scl_low)
+        {
+            s_i2c_scl_low = false;
+            released = --s_i2c_sda_held == 0; // One more bit shifted out by the stuck device
+        }
+    }
+    uint8_t sda = s_i2c_sda;
+    pthread_mutex_unlock(&s_bus_mutex);
+
+    if (released)
+    {
+        hal_fake_gpio_store_input(sda, HAL_HIGH);
+    }
+}
+
+void hal_fake_bus_reset()
+{
+    pthread_mutex_lock(&s_bus_mutex);
+    memset(s_i2c_devices, 0, sizeof(s_i2c_devices));
+    memset(s_spi_devices, 0, sizeof(s_spi_devices));
+    memset(s_i2c_stretch_us, 0, sizeof(s_i2c_stretch_us));
+    s_i2c_sda = s_i2c_scl = 0xFF;
+    s_i2c_frequency = 0;
+    s_i2c_timeout_ms = 50;
+    s_i2c_sda_held = 0;
+    s_i2c_scl_low = false;
+    pthread_mutex_unlock(&s_bus_mutex);
+}
+
+#endif // HAL_LINUX
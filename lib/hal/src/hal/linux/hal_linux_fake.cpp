@@ -0,0 +1,17 @@
+#if defined(HAL_LINUX)
+
+#include "hal_fake.hpp"
+#include "hal_linux_internal.hpp"
+
+void hal_fake_reset()
+{
+    hal_fake_gpio_reset();
+    hal_fake_adc_reset();
+    hal_fake_pwm_reset();
+    hal_fake_sleep_reset();
+    hal_fake_system_reset();
+    hal_fake_bus_reset();
+    hal_fake_pcnt_reset();
+}
+
+#endif // HAL_LINUX
@@ -0,0 +1,212 @@
+#if defined(HAL_LINUX)
+
+#include <fcntl.h>
+#include <pthread.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#include "../hal_flash.hpp"
+#include "hal_fake.hpp"
+
+#define FAKE_PARTITION_COUNT 4
+#define FAKE_LABEL_LENGTH 16 // Longest label of the ESP-IDF partition table
+
+/* Partition backed by a file, or by memory when no path is given */
+struct FakePartition
+{
+    char label[FAKE_LABEL_LENGTH + 1];
+    size_t size;
+    int fd;
+    uint8_t *memory;
+    uint32_t *erase_counts; // One per sector
+};
+
+static FakePartition s_partitions[FAKE_PARTITION_COUNT];
+static size_t s_partition_count = 0;
+static pthread_mutex_t s_flash_mutex = PTHREAD_MUTEX_INITIALIZER;
+
+static bool in_range(const FakePartition *partition, size_t offset, size_t length)
+{
+    return offset <= partition->size && length <= partition->size - offset;
+}
+
+static bool raw_read(FakePartition *partition, size_t offset, void *data, size_t length)
+{
+    if (partition->memory != NULL)
+    {
+        memcpy(data, partition->memory + offset, length);
+        return true;
+    }
+    return pread(partition->fd, data, length, offset) == (ssize_t)length;
+}
+
+static bool raw_write(FakePartition *partition, size_t offset, const void *data, size_t length)
+{
+    if (partition->memory != NULL)
+    {
+        memcpy(partition->memory + offset, data, length);
+        return true;
+    }
+    return pwrite(partition->fd, data, length, offset) == (ssize_t)length;
+}
+
+static FakePartition *find(const char *label)
+{
+    for (size_t i = 0; i < s_partition_count; i++)
+    {
+        if (strcmp(s_partitions[i].label, label) == 0)
+        {
+            return &s_partitions[i];
+        }
+    }
+    return NULL;
+}
+
+hal_partition_t hal_partition_find(const char *label)
+{
+    pthread_mutex_lock(&s_flash_mutex);
+    FakePartition *partition = find(label);
+    pthread_mutex_unlock(&s_flash_mutex);
+    return partition;
+}
+
+size_t hal_partition_size(hal_partition_t partition)
+{
+    return ((FakePartition *)partition)->size;
+}
+
+bool hal_partition_read(hal_partition_t handle, size_t offset, void *data, size_t length)
+{
+    FakePartition *partition = (FakePartition *)handle;
+    if (!in_range(partition, offset, length))
+    {
+        return false;
+    }
+    pthread_mutex_lock(&s_flash_mutex);
+    bool ok = raw_read(partition, offset, data, length);
+    pthread_mutex_unlock(&s_flash_mutex);
+    return ok;
+}
+
+bool hal_partition_write(hal_partition_t handle, size_t offset, const void *data, size_t length)
+{
+    FakePartition *partition = (FakePartition *)handle;
+    if (!in_range(partition, offset, length))
+    {
+        return false;
+    }
+
+    // Programming only clears bits, as on the NOR flash of the ESP32
+    uint8_t chunk[256];
+    const uint8_t *bytes = (const uint8_t *)data;
+    bool ok = true;
+    pthread_mutex_lock(&s_flash_mutex);
+    for (size_t done = 0; done < length && ok; done += sizeof(chunk))
+    {
+        size_t part = length - done < sizeof(chunk) ? length - done : sizeof(chunk);
+        ok = raw_read(partition, offset + done, chunk, part);
+        for (size_t i = 0; i < part; i++)
+        {
+            chunk[i] &= bytes[done + i];
+        }
+        ok = ok && raw_write(partition, offset + done, chunk, part);
+    }
+    pthread_mutex_unlock(&s_flash_mutex);
+    return ok;
+}
+
+bool hal_partition_erase(hal_partition_t handle, size_t offset, size_t length)
+{
+    FakePartition *partition = (FakePartition *)handle;
+    if (!in_range(partition, offset, length) || offset % HAL_FLASH_SECTOR_SIZE != 0 ||
+        length % HAL_FLASH_SECTOR_SIZE != 0)
+    {
+        return false;
+    }
+
+    uint8_t erased[HAL_FLASH_SECTOR_SIZE];
+    memset(erased, 0xFF, sizeof(erased));
+    bool ok = true;
+    pthread_mutex_lock(&s_flash_mutex);
+    for (size_t sector = offset; sector < offset + length && ok; sector += HAL_FLASH_SECTOR_SIZE)
+    {
+        ok = raw_write(partition, sector, erased, sizeof(erased));
+        partition->erase_counts[sector / HAL_FLASH_SECTOR_SIZE]++;
+    }
+    pthread_mutex_unlock(&s_flash_mutex);
+    return ok;
+}
+
+bool hal_fake_flash_add_partition(const char *label, size_t size, const char *path)
+{
+    if (strlen(label) > FAKE_LABEL_LENGTH || size == 0 || size % HAL_FLASH_SECTOR_SIZE != 0)
+    {
+        return false;
+    }
+
+    pthread_mutex_lock(&s_flash_mutex);
+    bool ok = s_partition_count < FAKE_PARTITION_COUNT && find(label) == NULL;
+    FakePartition partition = {};
+    if (ok)
+    {
+        strcpy(partition.label, label);
+        partition.size = size;
+        partition.fd = -1;
+        partition.erase_counts = (uint32_t *)calloc(size / HAL_FLASH_SECTOR_SIZE, sizeof(uint32_t));
+        ok = partition.erase_counts != NULL;
+    }
+    if (ok && path == NULL)
+    {
+        partition.memory = (uint8_t *)malloc(size);
+        ok = partition.memory != NULL;
+        if (ok)
+        {
+            memset(partition.memory, 0xFF, size);
+        }
+    }
+    else if (ok)
+    {
+        // A new or shorter file is extended with erased bytes, existing content is kept
+        partition.fd = open(path, O_RDWR | O_CREAT, 0644);
+        off_t length = partition.fd >= 0 ? lseek(partition.fd, 0, SEEK_END) : -1;
+        ok = length >= 0;
+        uint8_t erased[HAL_FLASH_SECTOR_SIZE];
+        memset(erased, 0xFF, sizeof(erased));
+        for (size_t at = length; ok && at < size; at += sizeof(erased))
+        {
+            size_t part = size - at < sizeof(erased) ? size - at : sizeof(erased);
+            ok = pwrite(partition.fd, erased, part, at) == (ssize_t)part;
+        }
+    }
+
+    if (ok)
+    {
+        s_partitions[s_partition_count++] = partition;
+    }
+    else
+    {
+        if (partition.fd >= 0)
+        {
+            close(partition.fd);
+        }
+        free(partition.memory);
+        free(partition.erase_counts);
+    }
+    pthread_mutex_unlock(&s_flash_mutex);
+    return ok;
+}
+
+uint32_t hal_fake_flash_max_erases(const char *label)
+{
+    pthread_mutex_lock(&s_flash_mutex);
+    FakePartition *partition = find(label);
+    uint32_t most = 0;
+    for (size_t i = 0; partition != NULL && i < partition->size / HAL_FLASH_SECTOR_SIZE; i++)
+    {
+        most = partition->erase_counts[i] > most ? partition->erase_counts[i] : most;
+    }
+    pthread_mutex_unlock(&s_flash_mutex);
+    return most;
+}
+
+#endif // HAL_LINUX
@@ -0,0 +1,45 @@
+#if defined(HAL_LINUX)
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include "../hal_fs.hpp"
+#include "hal_fake.hpp"
+
+#define FAKE_FS_ROOT_MAX 32 // Leaves room for the file names in HAL_FS_PATH_MAX
+
+static char s_root[FAKE_FS_ROOT_MAX] = ""; // Empty until mounted or set by the test
+
+bool hal_fake_fs_set_root(const char *dir)
+{
+    if (strlen(dir) >= sizeof(s_root))
+    {
+        return false;
+    }
+    strcpy(s_root, dir);
+    return true;
+}
+
+bool hal_fs_mount()
+{
+    if (s_root[0] != '\0')
+    {
+        return true;
+    }
+    // A fresh directory per process, like a blank partition formatted on first use
+    strcpy(s_root, "/tmp/hal_fs_XXXXXX");
+    if (mkdtemp(s_root) == NULL)
+    {
+        s_root[0] = '\0';
+        return false;
+    }
+    return true;
+}
+
+bool hal_fs_path(const char *name, char *path, size_t size)
+{
+    int length = snprintf(path, size, "%s%s", s_root, name);
+    return s_root[0] != '\0' && length >= 0 && (size_t)length < size;
+}
+
+#endif // HAL_LINUX
@@ -0,0 +1,185 @@
+#if defined(HAL_LINUX)
+
+#include <pthread.h>
+#include <string.h>
+#include "../hal_gpio.hpp"
+#include "../hal_time.hpp"
+#include "hal_fake.hpp"
+#include "hal_linux_internal.hpp"
+
+struct FakePin
+{
+    HalPinMode mode;
+    int input;
+    int output;
+    uint32_t writes;
+    hal_gpio_isr_t isr;
+    void *isr_arg;
+    HalGpioEdge edge;
+};
+
+static pthread_mutex_t s_gpio_mutex = PTHREAD_MUTEX_INITIALIZER;
+static FakePin s_pins[HAL_FAKE_GPIO_COUNT];
+static hal_fake_gpio_write_hook_t s_write_hook = NULL;
+static void *s_write_hook_ctx = NULL;
+
+void hal_gpio_mode(uint8_t pin, HalPinMode mode)
+{
+    if (pin >= HAL_FAKE_GPIO_COUNT)
+    {
+        return;
+    }
+    pthread_mutex_lock(&s_gpio_mutex);
+    s_pins[pin].mode = mode;
+    if (mode == HAL_INPUT_PULLUP)
+    {
+        s_pins[pin].input = HAL_HIGH; // Idle level of an unconnected pulled-up input
+    }
+    pthread_mutex_unlock(&s_gpio_mutex);
+}
+
+int hal_gpio_read(uint8_t pin)
+{
+    if (pin >= HAL_FAKE_GPIO_COUNT)
+    {
+        return HAL_LOW;
+    }
+    pthread_mutex_lock(&s_gpio_mutex);
+    bool output = s_pins[pin].mode == HAL_OUTPUT || s_pins[pin].mode == HAL_OUTPUT_OPEN_DRAIN;
+    int level = output ? s_pins[pin].output : s_pins[pin].input;
+    pthread_mutex_unlock(&s_gpio_mutex);
+    return level;
+}
+
+void hal_gpio_write(uint8_t pin, int level)
+{
+    if (pin >= HAL_FAKE_GPIO_COUNT)
+    {
+        return;
+    }
+    level = level ? HAL_HIGH : HAL_LOW;
+
+    pthread_mutex_lock(&s_gpio_mutex);
+    s_pins[pin].output = level;
+    s_pins[pin].writes++;
+    hal_fake_gpio_write_hook_t hook = s_write_hook;
+    void *ctx = s_write_hook_ctx;
+    pthread_mutex_unlock(&s_gpio_mutex);
+
+    hal_fake_i2c_pin_written(pin, level);
+    if (hook != NULL)
+    {
+        hook(pin, level, hal_micros(), ctx);
+    }
+}
+
+bool hal_gpio_attach_interrupt(uint8_t pin, HalGpioEdge edge, hal_gpio_isr_t isr, void *arg)
+{
+    if (pin >= HAL_FAKE_GPIO_COUNT)
+    {
+        return false;
+    }
+    pthread_mutex_lock(&s_gpio_mutex);
+    s_pins[pin].isr = isr;
+    s_pins[pin].isr_arg = arg;
+    s_pins[pin].edge = edge;
+    pthread_mutex_unlock(&s_gpio_mutex);
+    return true;
+}
+
+void hal_gpio_detach_interrupt(uint8_t pin)
+{
+    if (pin >= HAL_FAKE_GPIO_COUNT)
+    {
+        return;
+    }
+    pthread_mutex_lock(&s_gpio_mutex);
+    s_pins[pin].isr = NULL;
+    s_pins[pin].isr_arg = NULL;
+    pthread_mutex_unlock(&s_gpio_mutex);
+}
+
+void hal_fake_gpio_set_input(uint8_t pin, int level)
+{
+    if (pin >= HAL_FAKE_GPIO_COUNT)
+    {
+        return;
+    }
+    level = level ? HAL_HIGH : HAL_LOW;
+
+    pthread_mutex_lock(&s_gpio_mutex);
+    int previous = s_pins[pin].input;
+    s_pins[pin].input = level;
+    hal_gpio_isr_t isr = s_pins[pin].isr;
+    void *arg = s_pins[pin].isr_arg;
+    HalGpioEdge edge = s_pins[pin].edge;
+    pthread_mutex_unlock(&s_gpio_mutex);
+
+    if (previous != level)
+    {
+        hal_fake_pcnt_count_edge(pin);
+    }
+    if (isr == NULL || previous == level)
+    {
+        return;
+    }
+    bool rising = level == HAL_HIGH;
+    if (edge == HAL_EDGE_BOTH || (edge == HAL_EDGE_RISING && rising) || (edge == HAL_EDGE_FALLING && !rising))
+    {
+        isr(arg);
+    }
+}
+
+void hal_fake_gpio_store_input(uint8_t pin, int level)
+{
+    if (pin >= HAL_FAKE_GPIO_COUNT)
+    {
+        return;
+    }
+    pthread_mutex_lock(&s_gpio_mutex);
+    s_pins[pin].input = level ? HAL_HIGH : HAL_LOW;
+    pthread_mutex_unlock(&s_gpio_mutex);
+}
+
+int hal_fake_gpio_get_output(uint8_t pin)
+{
+    if (pin >= HAL_FAKE_GPIO_COUNT)
+    {
+        return HAL_LOW;
+    }
+    pthread_mutex_lock(&s_gpio_mutex);
+    int level = s_pins[pin].output;
+    pthread_mutex_unlock(&s_gpio_mutex);
+    return level;
+}
+
+uint32_t hal_fake_gpio_write_count(uint8_t pin)
+{
+    if (pin >= HAL_FAKE_GPIO_COUNT)
+    {
+        return 0;
+    }
+    pthread_mutex_lock(&s_gpio_mutex);
+    uint32_t writes = s_pins[pin].writes;
+    pthread_mutex_unlock(&s_gpio_mutex);
+    return writes;
+}
+
+void hal_fake_gpio_set_write_hook(hal_fake_gpio_write_hook_t hook, void *ctx)
+{
+    pthread_mutex_lock(&s_gpio_mutex);
+    s_write_hook = hook;
+    s_write_hook_ctx = ctx;
+    pthread_mutex_unlock(&s_gpio_mutex);
+}
+
+void hal_fake_gpio_reset()
+{
+    pthread_mutex_lock(&s_gpio_mutex);
+    memset(s_pins, 0, sizeof(s_pins));
+    s_write_hook = NULL;
+    s_write_hook_ctx = NULL;
+    pthread_mutex_unlock(&s_gpio_mutex);
+}
+
+#endif // HAL_LINUX
@@ -0,0 +1,55 @@
+#pragma once
+
+/*
+ * Functions shared between the files of the Linux backend.
+ * Not part of the HAL interface.
+ */
+
+void hal_fake_gpio_reset();
+void hal_fake_adc_reset();
+void hal_fake_pwm_reset();
+void hal_fake_sleep_reset();
+void hal_fake_system_reset();
+void hal_fake_bus_reset();
+void hal_fake_pcnt_reset();
+
+/* Sets an input level without interrupts or edge counting, for edges already counted */
+void hal_fake_gpio_store_input(uint8_t pin, int level);
+
+/* Stops and restarts the continuous ADC blocks around a light sleep, like the DMA on the chip */
+void hal_fake_adc_pause(bool paused);
+
+/* Called by the GPIO fake when an input changes level */
+void hal_fake_pcnt_count_edge(uint8_t pin);
+
+/* Called by the GPIO fake on every write, lets a stuck I2C device see the clock pulses of a recovery */
+void hal_fake_i2c_pin_written(uint8_t pin, int level);
+
+/*
+ * Simulator implementations of the blocking primitives, used by the
+ * backend files when hal_sim_active() is true.
+ */
+
+#include <stddef.h>
+#include <stdint.h>
+#include "../hal_rtos.hpp"
+#include "../hal_timer.hpp"
+
+void sim_sleep_us(uint64_t duration_us);
+
+bool sim_task_create(hal_task_fn_t fn, const char *name, void *arg, uint8_t priority, hal_task_t *handle);
+hal_task_t sim_task_current();
+void sim_task_notify(hal_task_t task);
+bool sim_task_wait_notify(uint32_t timeout_ms);
+
+hal_mutex_t sim_mutex_create();
+bool sim_mutex_take(hal_mutex_t mutex, uint32_t timeout_ms);
+void sim_mutex_give(hal_mutex_t mutex);
+
+hal_queue_t sim_queue_create(size_t length, size_t item_size);
+bool sim_queue_send(hal_queue_t queue, const void *item, uint32_t timeout_ms);
+bool sim_queue_receive(hal_queue_t queue, void *item, uint32_t timeout_ms);
+
+hal_timer_t sim_timer_create(hal_timer_cb_t callback, void *arg);
+bool sim_timer_start(hal_timer_t timer, uint64_t timeout_us, uint64_t period_us);
+void sim_timer_stop(hal_timer_t timer);
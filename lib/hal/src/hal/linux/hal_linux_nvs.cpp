@@ -0,0 +1,103 @@
+#if defined(HAL_LINUX)
+
+#include <pthread.h>
+#include <string.h>
+#include "../hal_nvs.hpp"
+#include "hal_fake.hpp"
+
+#define FAKE_NVS_ENTRIES 32
+#define FAKE_NVS_NAME_LENGTH 15 // Longest namespace or key of the ESP-IDF NVS
+#define FAKE_NVS_VALUE_SIZE 128
+
+/* Value of a key, typed like in the ESP-IDF NVS */
+struct FakeNvsEntry
+{
+    char space[FAKE_NVS_NAME_LENGTH + 1];
+    char key[FAKE_NVS_NAME_LENGTH + 1];
+    bool counter; // Written by hal_nvs_set_u64()
+    size_t length;
+    uint8_t value[FAKE_NVS_VALUE_SIZE];
+};
+
+static FakeNvsEntry s_entries[FAKE_NVS_ENTRIES];
+static size_t s_entry_count = 0;
+static pthread_mutex_t s_nvs_mutex = PTHREAD_MUTEX_INITIALIZER;
+
+static FakeNvsEntry *find(const char *space, const char *key)
+{
+    for (size_t i = 0; i < s_entry_count; i++)
+    {
+        if (strcmp(s_entries[i].space, space) == 0 && strcmp(s_entries[i].key, key) == 0)
+        {
+            return &s_entries[i];
+        }
+    }
+    return NULL;
+}
+
+static bool get(const char *space, const char *key, bool counter, void *data, size_t length)
+{
+    pthread_mutex_lock(&s_nvs_mutex);
+    FakeNvsEntry *entry = find(space, key);
+    bool ok = entry != NULL && entry->counter == counter && entry->length == length;
+    if (ok)
+    {
+        memcpy(data, entry->value, length);
+    }
+    pthread_mutex_unlock(&s_nvs_mutex);
+    return ok;
+}
+
+static bool set(const char *space, const char *key, bool counter, const void *data, size_t length)
+{
+    if (strlen(space) > FAKE_NVS_NAME_LENGTH || strlen(key) > FAKE_NVS_NAME_LENGTH || length > FAKE_NVS_VALUE_SIZE)
+    {
+        return false;
+    }
+
+    pthread_mutex_lock(&s_nvs_mutex);
+    FakeNvsEntry *entry = find(space, key);
+    if (entry == NULL && s_entry_count < FAKE_NVS_ENTRIES)
+    {
+        entry = &s_entries[s_entry_count++];
+        strcpy(entry->space, space);
+        strcpy(entry->key, key);
+    }
+    if (entry != NULL)
+    {
+        entry->counter = counter;
+        entry->length = length;
+        memcpy(entry->value, data, length);
+    }
+    pthread_mutex_unlock(&s_nvs_mutex);
+    return entry != NULL;
+}
+
+bool hal_nvs_get(const char *space, const char *key, void *data, size_t length)
+{
+    return get(space, key, false, data, length);
+}
+
+bool hal_nvs_set(const char *space, const char *key, const void *data, size_t length)
+{
+    return set(space, key, false, data, length);
+}
+
+bool hal_nvs_get_u64(const char *space, const char *key, uint64_t *value)
+{
+    return get(space, key, true, value, sizeof(*value));
+}
+
+bool hal_nvs_set_u64(const char *space, const char *key, uint64_t value)
+{
+    return set(space, key, true, &value, sizeof(value));
+}
+
+void hal_fake_nvs_erase()
+{
+    pthread_mutex_lock(&s_nvs_mutex);
+    s_entry_count = 0;
+    pthread_mutex_unlock(&s_nvs_mutex);
+}
+
+#endif // HAL_LINUX
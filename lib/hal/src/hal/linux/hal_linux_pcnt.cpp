@@ -0,0 +1,131 @@
+#if defined(HAL_LINUX)
+
+#include <pthread.h>
+#include <string.h>
+#include "../hal_gpio.hpp"
+#include "../hal_pcnt.hpp"
+#include "../hal_time.hpp"
+#include "hal_fake.hpp"
+#include "hal_linux_internal.hpp"
+
+struct FakePcntUnit
+{
+    bool attached;
+    uint8_t pin;
+    uint32_t filter_us;
+    uint32_t edges; // Counted since the last hal_pcnt_take()
+    const uint32_t *trace;
+    size_t trace_length;
+    size_t trace_pos;
+    uint64_t trace_start_us;
+};
+
+static pthread_mutex_t s_pcnt_mutex = PTHREAD_MUTEX_INITIALIZER;
+static FakePcntUnit s_units[HAL_PCNT_UNIT_COUNT];
+
+bool hal_pcnt_attach(uint8_t unit, uint8_t pin, uint32_t filter_ns)
+{
+    if (unit >= HAL_PCNT_UNIT_COUNT || pin >= HAL_FAKE_GPIO_COUNT)
+    {
+        return false;
+    }
+    hal_gpio_mode(pin, HAL_INPUT);
+
+    pthread_mutex_lock(&s_pcnt_mutex);
+    memset(&s_units[unit], 0, sizeof(s_units[unit]));
+    s_units[unit].attached = true;
+    s_units[unit].pin = pin;
+    s_units[unit].filter_us = (filter_ns + 999) / 1000;
+    pthread_mutex_unlock(&s_pcnt_mutex);
+    return true;
+}
+
+/* Consumes the trace edges that already happened, returns how many toggled the pin */
+static uint32_t play_trace(FakePcntUnit *unit, uint64_t now_us)
+{
+    uint32_t toggles = 0;
+    while (unit->trace_pos < unit->trace_length &&
+           unit->trace_start_us + unit->trace[unit->trace_pos] <= now_us)
+    {
+        size_t pos = unit->trace_pos;
+        if (pos + 1 < unit->trace_length && unit->trace[pos + 1] - unit->trace[pos] < unit->filter_us)
+        {
+            // A glitch shorter than the filter: both edges are dropped once the second one happened
+            if (unit->trace_start_us + unit->trace[pos + 1] > now_us)
+            {
+                break;
+            }
+            unit->trace_pos += 2;
+            continue;
+        }
+        unit->edges++;
+        unit->trace_pos++;
+        toggles++;
+    }
+    return toggles;
+}
+
+uint32_t hal_pcnt_take(uint8_t unit)
+{
+    if (unit >= HAL_PCNT_UNIT_COUNT)
+    {
+        return 0;
+    }
+
+    pthread_mutex_lock(&s_pcnt_mutex);
+    FakePcntUnit *state = &s_units[unit];
+    if (!state->attached)
+    {
+        pthread_mutex_unlock(&s_pcnt_mutex);
+        return 0;
+    }
+    uint32_t toggles = play_trace(state, hal_micros());
+    uint32_t edges = state->edges;
+    uint8_t pin = state->pin;
+    state->edges = 0;
+    pthread_mutex_unlock(&s_pcnt_mutex);
+
+    if (toggles & 1)
+    {
+        hal_fake_gpio_store_input(pin, !hal_gpio_read(pin));
+    }
+    return edges;
+}
+
+void hal_fake_pcnt_count_edge(uint8_t pin)
+{
+    pthread_mutex_lock(&s_pcnt_mutex);
+    for (int i = 0; i < HAL_PCNT_UNIT_COUNT; i++)
+    {
+        if (s_units[i].attached && s_units[i].pin == pin)
+        {
+            s_units[i].edges++;
+        }
+    }
+    pthread_mutex_unlock(&s_pcnt_mutex);
+}
+
+void hal_fake_pcnt_play_trace(uint8_t pin, const uint32_t *edge_times_us, size_t count)
+{
+    pthread_mutex_lock(&s_pcnt_mutex);
+    for (int i = 0; i < HAL_PCNT_UNIT_COUNT; i++)
+    {
+        if (s_units[i].attached && s_units[i].pin == pin)
+        {
+            s_units[i].trace = edge_times_us;
+            s_units[i].trace_length = count;
+            s_units[i].trace_pos = 0;
+            s_units[i].trace_start_us = hal_micros();
+        }
+    }
+    pthread_mutex_unlock(&s_pcnt_mutex);
+}
+
+void hal_fake_pcnt_reset()
+{
+    pthread_mutex_lock(&s_pcnt_mutex);
+    memset(s_units, 0, sizeof(s_units));
+    pthread_mutex_unlock(&s_pcnt_mutex);
+}
+
+#endif // HAL_LINUX
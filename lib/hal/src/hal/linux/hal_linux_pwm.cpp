@@ -0,0 +1,93 @@
+#if defined(HAL_LINUX)
+
+#include <pthread.h>
+#include <string.h>
+#include "../hal_pwm.hpp"
+#include "../hal_time.hpp"
+#include "hal_fake.hpp"
+#include "hal_linux_internal.hpp"
+
+struct FakePwmChannel
+{
+    bool attached;
+    uint8_t pin;
+    uint32_t freq_hz;
+};
+
+static pthread_mutex_t s_pwm_mutex = PTHREAD_MUTEX_INITIALIZER;
+static FakePwmChannel s_channels[HAL_PWM_CHANNEL_COUNT];
+static hal_fake_pwm_hook_t s_pwm_hook = NULL;
+static void *s_pwm_hook_ctx = NULL;
+
+bool hal_pwm_attach(uint8_t channel, uint8_t pin)
+{
+    if (channel >= HAL_PWM_CHANNEL_COUNT || pin >= HAL_FAKE_GPIO_COUNT)
+    {
+        return false;
+    }
+    pthread_mutex_lock(&s_pwm_mutex);
+    s_channels[channel].attached = true;
+    s_channels[channel].pin = pin;
+    s_channels[channel].freq_hz = 0;
+    pthread_mutex_unlock(&s_pwm_mutex);
+    return true;
+}
+
+void hal_pwm_tone(uint8_t channel, uint32_t freq_hz)
+{
+    if (channel >= HAL_PWM_CHANNEL_COUNT)
+    {
+        return;
+    }
+
+    pthread_mutex_lock(&s_pwm_mutex);
+    if (!s_channels[channel].attached)
+    {
+        pthread_mutex_unlock(&s_pwm_mutex);
+        return;
+    }
+    s_channels[channel].freq_hz = freq_hz;
+    uint8_t pin = s_channels[channel].pin;
+    hal_fake_pwm_hook_t hook = s_pwm_hook;
+    void *ctx = s_pwm_hook_ctx;
+    pthread_mutex_unlock(&s_pwm_mutex);
+
+    if (hook != NULL)
+    {
+        hook(pin, freq_hz, hal_micros(), ctx);
+    }
+}
+
+uint32_t hal_fake_pwm_get_tone(uint8_t pin)
+{
+    uint32_t freq_hz = 0;
+    pthread_mutex_lock(&s_pwm_mutex);
+    for (int i = 0; i < HAL_PWM_CHANNEL_COUNT; i++)
+    {
+        if (s_channels[i].attached && s_channels[i].pin == pin)
+        {
+            freq_hz = s_channels[i].freq_hz;
+        }
+    }
+    pthread_mutex_unlock(&s_pwm_mutex);
+    return freq_hz;
+}
+
+void hal_fake_pwm_set_hook(hal_fake_pwm_hook_t hook, void *ctx)
+{
+    pthread_mutex_lock(&s_pwm_mutex);
+    s_pwm_hook = hook;
+    s_pwm_hook_ctx = ctx;
+    pthread_mutex_unlock(&s_pwm_mutex);
+}
+
+void hal_fake_pwm_reset()
+{
+    pthread_mutex_lock(&s_pwm_mutex);
+    memset(s_channels, 0, sizeof(s_channels));
+    s_pwm_hook = NULL;
+    s_pwm_hook_ctx = NULL;
+    pthread_mutex_unlock(&s_pwm_mutex);
+}
+
+#endif // HAL_LINUX
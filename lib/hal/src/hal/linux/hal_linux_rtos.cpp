@@ -0,0 +1,310 @@
+#if defined(HAL_LINUX)
+
+#include <pthread.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include "../hal_rtos.hpp"
+#include "hal_sim.hpp"
+#include "hal_linux_internal.hpp"
+
+/*
+ * Tasks are detached pthreads, priorities and core affinity are ignored.
+ * Every task owns a notification counter mirroring FreeRTOS task notifications.
+ * Under the simulator (hal_sim.hpp) every call is forwarded to its sim_* counterpart.
+ */
+
+struct LinuxTask
+{
+    pthread_t thread;
+    hal_task_fn_t fn;
+    void *arg;
+    char name[16];
+    pthread_mutex_t mutex;
+    pthread_cond_t cond;
+    uint32_t notifications;
+};
+
+struct LinuxQueue
+{
+    pthread_mutex_t mutex;
+    pthread_cond_t not_empty;
+    pthread_cond_t not_full;
+    uint8_t *storage;
+    size_t length;
+    size_t item_size;
+    size_t head;
+    size_t count;
+};
+
+static thread_local LinuxTask *s_current_task = NULL;
+
+static void init_cond(pthread_cond_t *cond)
+{
+    pthread_condattr_t attr;
+    pthread_condattr_init(&attr);
+    pthread_condattr_setclock(&attr, CLOCK_MONOTONIC);
+    pthread_cond_init(cond, &attr);
+    pthread_condattr_destroy(&attr);
+}
+
+static LinuxTask *new_task(hal_task_fn_t fn, const char *name, void *arg)
+{
+    LinuxTask *task = (LinuxTask *)calloc(1, sizeof(LinuxTask));
+    if (task == NULL)
+    {
+        return NULL;
+    }
+    task->fn = fn;
+    task->arg = arg;
+    strncpy(task->name, name != NULL ? name : "task", sizeof(task->name) - 1);
+    pthread_mutex_init(&task->mutex, NULL);
+    init_cond(&task->cond);
+    return task;
+}
+
+static struct timespec deadline_after(uint32_t timeout_ms)
+{
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    ts.tv_sec += timeout_ms / 1000;
+    ts.tv_nsec += (long)(timeout_ms % 1000) * 1000000L;
+    if (ts.tv_nsec >= 1000000000L)
+    {
+        ts.tv_sec++;
+        ts.tv_nsec -= 1000000000L;
+    }
+    return ts;
+}
+
+/**
+ * @brief Waits on a condition variable with a HAL timeout.
+ *
+ * @return false if the timeout expired.
+ */
+static bool wait_cond(pthread_cond_t *cond, pthread_mutex_t *mutex, uint32_t timeout_ms, const struct timespec *deadline)
+{
+    if (timeout_ms == HAL_WAIT_FOREVER)
+    {
+        pthread_cond_wait(cond, mutex);
+        return true;
+    }
+    return pthread_cond_timedwait(cond, mutex, deadline) == 0;
+}
+
+static void *task_entry(void *param)
+{
+    LinuxTask *task = (LinuxTask *)param;
+    s_current_task = task;
+    pthread_setname_np(pthread_self(), task->name);
+    task->fn(task->arg);
+    return NULL;
+}
+
+bool hal_task_create(hal_task_fn_t fn, const char *name, uint32_t stack_size, void *arg,
+                     uint8_t priority, hal_task_t *handle, int core)
+{
+    (void)stack_size;
+    (void)core;
+    if (hal_sim_active())
+    {
+        return sim_task_create(fn, name, arg, priority, handle);
+    }
+
+    LinuxTask *task = new_task(fn, name, arg);
+    if (task == NULL)
+    {
+        return false;
+    }
+    if (pthread_create(&task->thread, NULL, task_entry, task) != 0)
+    {
+        free(task);
+        return false;
+    }
+    pthread_detach(task->thread);
+
+    if (handle != NULL)
+    {
+        *handle = task;
+    }
+    return true;
+}
+
+hal_task_t hal_task_current()
+{
+    if (hal_sim_active())
+    {
+        return sim_task_current();
+    }
+    if (s_current_task == NULL)
+    {
+        // Thread not created through the HAL (e.g. main), adopt it lazily
+        s_current_task = new_task(NULL, "main", NULL);
+        s_current_task->thread = pthread_self();
+    }
+    return s_current_task;
+}
+
+void hal_task_notify(hal_task_t handle)
+{
+    if (hal_sim_active())
+    {
+        sim_task_notify(handle);
+        return;
+    }
+    LinuxTask *task = (LinuxTask *)handle;
+    pthread_mutex_lock(&task->mutex);
+    task->notifications++;
+    pthread_cond_signal(&task->cond);
+    pthread_mutex_unlock(&task->mutex);
+}
+
+void hal_task_notify_from_isr(hal_task_t handle)
+{
+    hal_task_notify(handle);
+}
+
+bool hal_task_wait_notify(uint32_t timeout_ms)
+{
+    if (hal_sim_active())
+    {
+        return sim_task_wait_notify(timeout_ms);
+    }
+    LinuxTask *task = (LinuxTask *)hal_task_current();
+    struct timespec deadline = deadline_after(timeout_ms);
+
+    pthread_mutex_lock(&task->mutex);
+    while (task->notifications == 0)
+    {
+        if (!wait_cond(&task->cond, &task->mutex, timeout_ms, &deadline))
+        {
+            break;
+        }
+    }
+    bool notified = task->notifications > 0;
+    task->notifications = 0; // Clear on exit like ulTaskNotifyTake(pdTRUE, ...)
+    pthread_mutex_unlock(&task->mutex);
+    return notified;
+}
+
+hal_mutex_t hal_mutex_create()
+{
+    if (hal_sim_active())
+    {
+        return sim_mutex_create();
+    }
+    pthread_mutex_t *mutex = (pthread_mutex_t *)malloc(sizeof(pthread_mutex_t));
+    if (mutex != NULL)
+    {
+        pthread_mutex_init(mutex, NULL);
+    }
+    return mutex;
+}
+
+bool hal_mutex_take(hal_mutex_t mutex, uint32_t timeout_ms)
+{
+    if (hal_sim_active())
+    {
+        return sim_mutex_take(mutex, timeout_ms);
+    }
+    if (timeout_ms == HAL_WAIT_FOREVER)
+    {
+        return pthread_mutex_lock((pthread_mutex_t *)mutex) == 0;
+    }
+    struct timespec deadline = deadline_after(timeout_ms);
+    return pthread_mutex_clocklock((pthread_mutex_t *)mutex, CLOCK_MONOTONIC, &deadline) == 0;
+}
+
+void hal_mutex_give(hal_mutex_t mutex)
+{
+    if (hal_sim_active())
+    {
+        sim_mutex_give(mutex);
+        return;
+    }
+    pthread_mutex_unlock((pthread_mutex_t *)mutex);
+}
+
+hal_queue_t hal_queue_create(size_t length, size_t item_size)
+{
+    if (hal_sim_active())
+    {
+        return sim_queue_create(length, item_size);
+    }
+    LinuxQueue *queue = (LinuxQueue *)calloc(1, sizeof(LinuxQueue));
+    if (queue == NULL)
+    {
+        return NULL;
+    }
+    queue->storage = (uint8_t *)malloc(length * item_size);
+    if (queue->storage == NULL)
+    {
+        free(queue);
+        return NULL;
+    }
+    queue->length = length;
+    queue->item_size = item_size;
+    pthread_mutex_init(&queue->mutex, NULL);
+    init_cond(&queue->not_empty);
+    init_cond(&queue->not_full);
+    return queue;
+}
+
+bool hal_queue_send(hal_queue_t handle, const void *item, uint32_t timeout_ms)
+{
+    if (hal_sim_active())
+    {
+        return sim_queue_send(handle, item, timeout_ms);
+    }
+    LinuxQueue *queue = (LinuxQueue *)handle;
+    struct timespec deadline = deadline_after(timeout_ms);
+
+    pthread_mutex_lock(&queue->mutex);
+    while (queue->count == queue->length)
+    {
+        if (timeout_ms == 0 || !wait_cond(&queue->not_full, &queue->mutex, timeout_ms, &deadline))
+        {
+            pthread_mutex_unlock(&queue->mutex);
+            return false;
+        }
+    }
+    size_t tail = (queue->head + queue->count) % queue->length;
+    memcpy(queue->storage + tail * queue->item_size, item, queue->item_size);
+    queue->count++;
+    pthread_cond_signal(&queue->not_empty);
+    pthread_mutex_unlock(&queue->mutex);
+    return true;
+}
+
+bool hal_queue_send_from_isr(hal_queue_t queue, const void *item)
+{
+    return hal_queue_send(queue, item, 0);
+}
+
+bool hal_queue_receive(hal_queue_t handle, void *item, uint32_t timeout_ms)
+{
+    if (hal_sim_active())
+    {
+        return sim_queue_receive(handle, item, timeout_ms);
+    }
+    LinuxQueue *queue = (LinuxQueue *)handle;
+    struct timespec deadline = deadline_after(timeout_ms);
+
+    pthread_mutex_lock(&queue->mutex);
+    while (queue->count == 0)
+    {
+        if (timeout_ms == 0 || !wait_cond(&queue->not_empty, &queue->mutex, timeout_ms, &deadline))
+        {
+            pthread_mutex_unlock(&queue->mutex);
+            return false;
+        }
+    }
+    memcpy(item, queue->storage + queue->head * queue->item_size, queue->item_size);
+    queue->head = (queue->head + 1) % queue->length;
+    queue->count--;
+    pthread_cond_signal(&queue->not_full);
+    pthread_mutex_unlock(&queue->mutex);
+    return true;
+}
+
+#endif // HAL_LINUX
@@ -0,0 +1,616 @@
+#if defined(HAL_LINUX)
+
+#include <pthread.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <set>
+#include <vector>
+#include "hal_sim.hpp"
+#include "hal_fake.hpp"
+#include "hal_linux_internal.hpp"
+
+/*
+ * Every simulated task is a pthread, but only the holder of the baton
+ * (s_baton, owned by s_current) ever runs. A task gives the baton away
+ * only inside the HAL, when it blocks or is preempted, and run_scheduler()
+ * decides who gets it next. Timers and scripted events are served by a
+ * dedicated task at the esp_timer priority.
+ */
+
+#define SIM_NEVER UINT64_MAX
+#define SIM_TIMER_TASK_PRIORITY 22 // Priority of the esp_timer task on the ESP32
+
+enum SimState : uint8_t
+{
+    SIM_RUNNING,
+    SIM_READY,
+    SIM_BLOCKED,
+    SIM_DEAD,
+};
+
+struct SimThread
+{
+    pthread_t thread;
+    pthread_cond_t cond;
+    char name[16];
+    uint8_t priority;
+    SimState state;
+    uint64_t ready_seq;    // FIFO order among ready tasks of equal priority
+    uint64_t wake_at;      // Virtual time the block times out, SIM_NEVER without timeout
+    const void *wait_obj;  // Object the task is blocked on, NULL for plain delays
+    bool timed_out;        // Set when the last block ended by timeout
+    uint32_t notifications;
+    hal_task_fn_t fn;
+    void *arg;
+};
+
+struct SimTimer
+{
+    hal_timer_cb_t callback;
+    void *arg;
+    bool armed;
+    bool scripted; // Scripted event, released after it fired
+    uint64_t deadline;
+    uint64_t period_us; // 0 for one-shot timers
+    uint64_t seq;       // Orders timers expiring at the same time
+};
+
+struct SimTimerOrder
+{
+    bool operator()(const SimTimer *a, const SimTimer *b) const
+    {
+        return a->deadline != b->deadline ? a->deadline < b->deadline : a->seq < b->seq;
+    }
+};
+
+struct SimMutex
+{
+    SimThread *owner;
+};
+
+struct SimQueue
+{
+    uint8_t *storage;
+    size_t length;
+    size_t item_size;
+    size_t head;
+    size_t count;
+};
+
+static pthread_mutex_t s_baton = PTHREAD_MUTEX_INITIALIZER;
+static bool s_active = false;
+static uint64_t s_now_us = 0;
+static uint64_t s_seq = 0;
+static uint64_t s_switches = 0;
+static SimThread *s_current = NULL;
+static SimThread *s_timer_task = NULL;
+static std::vector<SimThread *> s_threads;
+static std::set<SimTimer *, SimTimerOrder> s_armed_timers;
+static thread_local SimThread *s_self = NULL;
+
+static SimThread *self_thread()
+{
+    if (s_self == NULL)
+    {
+        fprintf(stderr, "hal_sim: blocking HAL call from a thread unknown to the simulator\n");
+        abort();
+    }
+    return s_self;
+}
+
+static SimThread *new_thread(const char *name, uint8_t priority, hal_task_fn_t fn, void *arg)
+{
+    SimThread *thread = (SimThread *)calloc(1, sizeof(SimThread));
+    if (thread == NULL)
+    {
+        return NULL;
+    }
+    pthread_cond_init(&thread->cond, NULL);
+    strncpy(thread->name, name != NULL ? name : "task", sizeof(thread->name) - 1);
+    thread->priority = priority;
+    thread->wake_at = SIM_NEVER;
+    thread->fn = fn;
+    thread->arg = arg;
+    s_threads.push_back(thread);
+    return thread;
+}
+
+static void make_ready(SimThread *thread)
+{
+    thread->state = SIM_READY;
+    thread->ready_seq = ++s_seq;
+    thread->wait_obj = NULL;
+    thread->wake_at = SIM_NEVER;
+}
+
+static SimThread *highest_ready()
+{
+    SimThread *best = NULL;
+    for (SimThread *thread : s_threads)
+    {
+        if (thread->state != SIM_READY)
+        {
+            continue;
+        }
+        if (best == NULL || thread->priority > best->priority ||
+            (thread->priority == best->priority && thread->ready_seq < best->ready_seq))
+        {
+            best = thread;
+        }
+    }
+    return best;
+}
+
+/**
+ * @brief Picks the next task to run, advancing virtual time while nothing is ready.
+ */
+static SimThread *pick_next()
+{
+    while (true)
+    {
+        SimThread *best = highest_ready();
+        if (best != NULL)
+        {
+            return best;
+        }
+
+        uint64_t next = SIM_NEVER;
+        for (SimThread *thread : s_threads)
+        {
+            if (thread->state == SIM_BLOCKED && thread->wake_at < next)
+            {
+                next = thread->wake_at;
+            }
+        }
+        if (next == SIM_NEVER)
+        {
+            fprintf(stderr, "hal_sim: deadlock, every task is blocked without timeout\n");
+            abort();
+        }
+
+        if (next > s_now_us)
+        {
+            s_now_us = next;
+        }
+        for (SimThread *thread : s_threads)
+        {
+            if (thread->state == SIM_BLOCKED && thread->wake_at <= s_now_us)
+            {
+                make_ready(thread);
+                thread->timed_out = true;
+            }
+        }
+    }
+}
+
+/**
+ * @brief Hands the baton to the next task and returns once the caller runs again.
+ *
+ * The caller must already have set its own state (ready, blocked or dead).
+ */
+static void run_scheduler(SimThread *self)
+{
+    SimThread *next = pick_next();
+    if (next != s_current)
+    {
+        s_switches++;
+    }
+    s_current = next;
+    next->state = SIM_RUNNING;
+    if (next == self)
+    {
+        return;
+    }
+
+    pthread_cond_signal(&next->cond);
+    while (s_current != self)
+    {
+        pthread_cond_wait(&self->cond, &s_baton);
+    }
+}
+
+/**
+ * @brief Blocks the calling task on an object until it is woken or the deadline passes.
+ *
+ * @return true if woken by wake_one(), false on timeout.
+ */
+static bool block_until(const void *obj, uint64_t deadline)
+{
+    SimThread *self = self_thread();
+    self->state = SIM_BLOCKED;
+    self->wait_obj = obj;
+    self->wake_at = deadline;
+    self->timed_out = false;
+    run_scheduler(self);
+    return !self->timed_out;
+}
+
+static uint64_t deadline_after_ms(uint32_t timeout_ms)
+{
+    return timeout_ms == HAL_WAIT_FOREVER ? SIM_NEVER : s_now_us + (uint64_t)timeout_ms * 1000ULL;
+}
+
+/**
+ * @brief Makes the highest-priority task blocked on an object ready.
+ *
+ * @return The woken task, NULL if nobody was waiting.
+ */
+static SimThread *wake_one(const void *obj)
+{
+    SimThread *best = NULL;
+    for (SimThread *thread : s_threads)
+    {
+        if (thread->state == SIM_BLOCKED && thread->wait_obj == obj &&
+            (best == NULL || thread->priority > best->priority))
+        {
+            best = thread;
+        }
+    }
+    if (best != NULL)
+    {
+        make_ready(best);
+        best->timed_out = false;
+    }
+    return best;
+}
+
+/**
+ * @brief Preempts the caller if it just woke a task of higher priority.
+ */
+static void preempt_if_higher(SimThread *woken)
+{
+    SimThread *self = self_thread();
+    if (woken != NULL && woken->priority > self->priority)
+    {
+        make_ready(self);
+        run_scheduler(self);
+    }
+}
+
+static void *sim_thread_entry(void *param)
+{
+    SimThread *self = (SimThread *)param;
+    s_self = self;
+    pthread_setname_np(pthread_self(), self->name);
+
+    pthread_mutex_lock(&s_baton);
+    while (s_current != self)
+    {
+        pthread_cond_wait(&self->cond, &s_baton);
+    }
+    self->fn(self->arg);
+
+    // Task function returned: park the thread, it is never scheduled again
+    self->state = SIM_DEAD;
+    run_scheduler(self);
+    pthread_mutex_unlock(&s_baton);
+    return NULL;
+}
+
+static bool start_thread(SimThread *thread)
+{
+    if (pthread_create(&thread->thread, NULL, sim_thread_entry, thread) != 0)
+    {
+        thread->state = SIM_DEAD;
+        return false;
+    }
+    pthread_detach(thread->thread);
+    return true;
+}
+
+static void update_timer_task_deadline()
+{
+    if (s_timer_task->state == SIM_BLOCKED)
+    {
+        s_timer_task->wake_at = s_armed_timers.empty() ? SIM_NEVER : (*s_armed_timers.begin())->deadline;
+    }
+}
+
+static void timer_service(void *arg)
+{
+    (void)arg;
+    SimThread *self = self_thread();
+    while (true)
+    {
+        while (!s_armed_timers.empty() && (*s_armed_timers.begin())->deadline <= s_now_us)
+        {
+            SimTimer *timer = *s_armed_timers.begin();
+            s_armed_timers.erase(s_armed_timers.begin());
+            if (timer->period_us > 0)
+            {
+                timer->deadline += timer->period_us;
+                timer->seq = ++s_seq;
+                s_armed_timers.insert(timer);
+            }
+            else
+            {
+                timer->armed = false;
+            }
+
+            timer->callback(timer->arg);
+            if (timer->scripted)
+            {
+                free(timer);
+            }
+        }
+
+        self->state = SIM_BLOCKED;
+        self->wait_obj = &s_armed_timers;
+        self->timed_out = false;
+        self->wake_at = SIM_NEVER;
+        update_timer_task_deadline();
+        run_scheduler(self);
+    }
+}
+
+void hal_sim_begin(uint8_t main_priority)
+{
+    if (s_active)
+    {
+        return;
+    }
+    pthread_mutex_lock(&s_baton); // Held by the running task from now on
+
+    SimThread *main_thread = new_thread("main", main_priority, NULL, NULL);
+    main_thread->thread = pthread_self();
+    main_thread->state = SIM_RUNNING;
+    s_self = main_thread;
+    s_current = main_thread;
+
+    s_timer_task = new_thread("esp_timer", SIM_TIMER_TASK_PRIORITY, timer_service, NULL);
+    s_timer_task->state = SIM_BLOCKED;
+    s_timer_task->wait_obj = &s_armed_timers;
+    start_thread(s_timer_task);
+
+    s_active = true;
+}
+
+bool hal_sim_active()
+{
+    return s_active;
+}
+
+uint64_t hal_sim_now_us()
+{
+    return s_now_us;
+}
+
+void hal_sim_run_until(uint64_t time_us)
+{
+    block_until(NULL, time_us > s_now_us ? time_us : s_now_us);
+}
+
+void hal_sim_run_for(uint64_t duration_us)
+{
+    hal_sim_run_until(s_now_us + duration_us);
+}
+
+bool hal_sim_at(uint64_t time_us, hal_sim_event_t event, void *ctx)
+{
+    SimTimer *timer = (SimTimer *)calloc(1, sizeof(SimTimer));
+    if (timer == NULL)
+    {
+        return false;
+    }
+    timer->callback = event;
+    timer->arg = ctx;
+    timer->scripted = true;
+    timer->armed = true;
+    timer->deadline = time_us > s_now_us ? time_us : s_now_us;
+    timer->seq = ++s_seq;
+    s_armed_timers.insert(timer);
+    update_timer_task_deadline();
+    return true;
+}
+
+static void apply_edge(void *ctx)
+{
+    const HalSimEdge *edge = (const HalSimEdge *)ctx;
+    hal_fake_gpio_set_input(edge->pin, edge->level);
+}
+
+bool hal_sim_play_waveform(const HalSimEdge *edges, size_t count)
+{
+    for (size_t i = 0; i < count; i++)
+    {
+        if (!hal_sim_at(edges[i].time_us, apply_edge, (void *)&edges[i]))
+        {
+            return false;
+        }
+    }
+    return true;
+}
+
+uint64_t hal_sim_context_switches()
+{
+    return s_switches;
+}
+
+void sim_sleep_us(uint64_t duration_us)
+{
+    SimThread *self = self_thread();
+    if (duration_us == 0)
+    {
+        make_ready(self); // Yield to tasks of equal priority
+        run_scheduler(self);
+        return;
+    }
+    block_until(NULL, s_now_us + duration_us);
+}
+
+bool sim_task_create(hal_task_fn_t fn, const char *name, void *arg, uint8_t priority, hal_task_t *handle)
+{
+    SimThread *thread = new_thread(name, priority, fn, arg);
+    if (thread == NULL)
+    {
+        return false;
+    }
+    make_ready(thread);
+    if (!start_thread(thread))
+    {
+        return false;
+    }
+    if (handle != NULL)
+    {
+        *handle = thread;
+    }
+    preempt_if_higher(thread);
+    return true;
+}
+
+hal_task_t sim_task_current()
+{
+    return self_thread();
+}
+
+void sim_task_notify(hal_task_t task)
+{
+    SimThread *thread = (SimThread *)task;
+    thread->notifications++;
+    preempt_if_higher(wake_one(&thread->notifications));
+}
+
+bool sim_task_wait_notify(uint32_t timeout_ms)
+{
+    SimThread *self = self_thread();
+    if (self->notifications == 0 && timeout_ms > 0)
+    {
+        block_until(&self->notifications, deadline_after_ms(timeout_ms));
+    }
+    bool notified = self->notifications > 0;
+    self->notifications = 0;
+    return notified;
+}
+
+hal_mutex_t sim_mutex_create()
+{
+    return calloc(1, sizeof(SimMutex));
+}
+
+bool sim_mutex_take(hal_mutex_t handle, uint32_t timeout_ms)
+{
+    SimMutex *mutex = (SimMutex *)handle;
+    uint64_t deadline = deadline_after_ms(timeout_ms);
+    while (mutex->owner != NULL)
+    {
+        if (timeout_ms == 0 || !block_until(mutex, deadline))
+        {
+            return false;
+        }
+    }
+    mutex->owner = self_thread();
+    return true;
+}
+
+void sim_mutex_give(hal_mutex_t handle)
+{
+    SimMutex *mutex = (SimMutex *)handle;
+    mutex->owner = NULL;
+    preempt_if_higher(wake_one(mutex));
+}
+
+// Distinct wait objects for the two conditions of a queue
+static const void *not_empty(SimQueue *queue)
+{
+    return queue;
+}
+
+static const void *not_full(SimQueue *queue)
+{
+    return (const uint8_t *)queue + 1;
+}
+
+hal_queue_t sim_queue_create(size_t length, size_t item_size)
+{
+    SimQueue *queue = (SimQueue *)calloc(1, sizeof(SimQueue));
+    if (queue == NULL)
+    {
+        return NULL;
+    }
+    queue->storage = (uint8_t *)malloc(length * item_size);
+    if (queue->storage == NULL)
+    {
+        free(queue);
+        return NULL;
+    }
+    queue->length = length;
+    queue->item_size = item_size;
+    return queue;
+}
+
+bool sim_queue_send(hal_queue_t handle, const void *item, uint32_t timeout_ms)
+{
+    SimQueue *queue = (SimQueue *)handle;
+    uint64_t deadline = deadline_after_ms(timeout_ms);
+    while (queue->count == queue->length)
+    {
+        if (timeout_ms == 0 || !block_until(not_full(queue), deadline))
+        {
+            return false;
+        }
+    }
+    size_t tail = (queue->head + queue->count) % queue->length;
+    memcpy(queue->storage + tail * queue->item_size, item, queue->item_size);
+    queue->count++;
+    preempt_if_higher(wake_one(not_empty(queue)));
+    return true;
+}
+
+bool sim_queue_receive(hal_queue_t handle, void *item, uint32_t timeout_ms)
+{
+    SimQueue *queue = (SimQueue *)handle;
+    uint64_t deadline = deadline_after_ms(timeout_ms);
+    while (queue->count == 0)
+    {
+        if (timeout_ms == 0 || !block_until(not_empty(queue), deadline))
+        {
+            return false;
+        }
+    }
+    memcpy(item, queue->storage + queue->head * queue->item_size, queue->item_size);
+    queue->head = (queue->head + 1) % queue->length;
+    queue->count--;
+    preempt_if_higher(wake_one(not_full(queue)));
+    return true;
+}
+
+hal_timer_t sim_timer_create(hal_timer_cb_t callback, void *arg)
+{
+    SimTimer *timer = (SimTimer *)calloc(1, sizeof(SimTimer));
+    if (timer != NULL)
+    {
+        timer->callback = callback;
+        timer->arg = arg;
+    }
+    return timer;
+}
+
+bool sim_timer_start(hal_timer_t handle, uint64_t timeout_us, uint64_t period_us)
+{
+    SimTimer *timer = (SimTimer *)handle;
+    if (timer->armed)
+    {
+        s_armed_timers.erase(timer);
+    }
+    timer->armed = true;
+    timer->deadline = s_now_us + timeout_us;
+    timer->period_us = period_us;
+    timer->seq = ++s_seq;
+    s_armed_timers.insert(timer);
+    update_timer_task_deadline();
+    return true;
+}
+
+void sim_timer_stop(hal_timer_t handle)
+{
+    SimTimer *timer = (SimTimer *)handle;
+    if (timer->armed)
+    {
+        s_armed_timers.erase(timer);
+        timer->armed = false;
+        update_timer_task_deadline();
+    }
+}
+
+#endif // HAL_LINUX
@@ -0,0 +1,135 @@
+#if defined(HAL_LINUX)
+
+#include <stdlib.h>
+#include "../hal_gpio.hpp"
+#include "../hal_log.hpp"
+#include "../hal_sleep.hpp"
+#include "../hal_time.hpp"
+#include "hal_fake.hpp"
+#include "hal_linux_internal.hpp"
+
+#define HAL_LINUX_SLEEP_POLL_MS 10
+
+struct WakePin
+{
+    uint8_t pin;
+    uint8_t level;
+};
+
+static WakePin s_wake_pins[HAL_SLEEP_MAX_WAKE_PINS];
+static uint8_t s_wake_pin_count = 0;
+static uint64_t s_timer_us = 0;
+static HalWakeCause s_cause = HAL_WAKE_NONE;
+static uint64_t s_woken_pins = 0;
+static uint64_t s_slept_us = 0;
+
+static uint64_t read_wake_pins()
+{
+    uint64_t mask = 0;
+    for (int i = 0; i < s_wake_pin_count; i++)
+    {
+        if (hal_gpio_read(s_wake_pins[i].pin) == s_wake_pins[i].level)
+        {
+            mask |= 1ULL << s_wake_pins[i].pin;
+        }
+    }
+    return mask;
+}
+
+bool hal_sleep_add_wake_pin(uint8_t pin, int level)
+{
+    if (s_wake_pin_count >= HAL_SLEEP_MAX_WAKE_PINS || pin >= HAL_FAKE_GPIO_COUNT)
+    {
+        return false;
+    }
+    s_wake_pins[s_wake_pin_count].pin = pin;
+    s_wake_pins[s_wake_pin_count].level = level ? HAL_HIGH : HAL_LOW;
+    s_wake_pin_count++;
+    return true;
+}
+
+void hal_sleep_clear_wake_pins()
+{
+    s_wake_pin_count = 0;
+}
+
+void hal_sleep_set_timer(uint64_t timeout_us)
+{
+    s_timer_us = timeout_us;
+}
+
+/*
+ * Only the calling task sleeps here, the others keep running. The wake
+ * pins are polled, which is enough to model the wake-up logic. The
+ * continuous ADC stops like its DMA does on the chip.
+ */
+HalWakeCause hal_light_sleep()
+{
+    uint64_t start_us = hal_micros();
+    hal_fake_adc_pause(true);
+    while (true)
+    {
+        uint64_t pins = read_wake_pins();
+        if (pins != 0)
+        {
+            s_cause = HAL_WAKE_GPIO;
+            s_woken_pins = pins;
+            break;
+        }
+        if (s_timer_us > 0 && hal_micros() - start_us >= s_timer_us)
+        {
+            s_cause = HAL_WAKE_TIMER;
+            s_woken_pins = 0;
+            break;
+        }
+        hal_delay_ms(HAL_LINUX_SLEEP_POLL_MS);
+    }
+    hal_fake_adc_pause(false);
+    s_slept_us += hal_micros() - start_us;
+    return s_cause;
+}
+
+void hal_deep_sleep()
+{
+    // The process ends like the chip powering down; restart it with
+    // hal_fake_set_wake_cause() to model the following boot
+    ESP_LOGI("hal_sleep", "Entering deep sleep, exiting");
+    exit(0);
+}
+
+HalWakeCause hal_wake_cause()
+{
+    return s_cause;
+}
+
+uint64_t hal_wake_pins()
+{
+    return s_woken_pins;
+}
+
+uint64_t hal_sleep_active_wake_pins()
+{
+    return read_wake_pins();
+}
+
+void hal_fake_set_wake_cause(HalWakeCause cause, uint64_t pins)
+{
+    s_cause = cause;
+    s_woken_pins = pins;
+}
+
+uint64_t hal_fake_slept_us()
+{
+    return s_slept_us;
+}
+
+void hal_fake_sleep_reset()
+{
+    s_wake_pin_count = 0;
+    s_timer_us = 0;
+    s_cause = HAL_WAKE_NONE;
+    s_woken_pins = 0;
+    s_slept_us = 0;
+}
+
+#endif // HAL_LINUX
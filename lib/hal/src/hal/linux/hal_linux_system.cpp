@@ -0,0 +1,69 @@
+#if defined(HAL_LINUX)
+
+#include <stdarg.h>
+#include <stdio.h>
+#include <pthread.h>
+#include "../hal_log.hpp"
+#include "../hal_system.hpp"
+#include "../hal_time.hpp"
+#include "hal_fake.hpp"
+#include "hal_linux_internal.hpp"
+
+static pthread_mutex_t s_console_mutex = PTHREAD_MUTEX_INITIALIZER;
+static HalResetReason s_reset_reason = HAL_RESET_POWER_ON;
+
+void hal_log_write(char level, const char *tag, const char *format, ...)
+{
+    va_list args;
+    va_start(args, format);
+    pthread_mutex_lock(&s_console_mutex);
+    fprintf(stdout, "[%8u][%c][%s] ", (unsigned)hal_millis(), level, tag);
+    vfprintf(stdout, format, args);
+    fputc('\n', stdout);
+    pthread_mutex_unlock(&s_console_mutex);
+    va_end(args);
+}
+
+void hal_console_begin(uint32_t baud)
+{
+    (void)baud;
+    setvbuf(stdout, NULL, _IOLBF, 0);
+}
+
+void hal_console_printf(const char *format, ...)
+{
+    va_list args;
+    va_start(args, format);
+    pthread_mutex_lock(&s_console_mutex);
+    vfprintf(stdout, format, args);
+    pthread_mutex_unlock(&s_console_mutex);
+    va_end(args);
+}
+
+// Heap usage is not tracked on the host
+uint32_t hal_free_heap()
+{
+    return 0;
+}
+
+uint32_t hal_min_free_heap()
+{
+    return 0;
+}
+
+HalResetReason hal_reset_reason()
+{
+    return s_reset_reason;
+}
+
+void hal_fake_set_reset_reason(HalResetReason reason)
+{
+    s_reset_reason = reason;
+}
+
+void hal_fake_system_reset()
+{
+    s_reset_reason = HAL_RESET_POWER_ON;
+}
+
+#endif // HAL_LINUX
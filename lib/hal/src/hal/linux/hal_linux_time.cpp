@@ -0,0 +1,79 @@
+#if defined(HAL_LINUX)
+
+#include <time.h>
+#include <errno.h>
+#include "../hal_time.hpp"
+#include "hal_fake.hpp"
+#include "hal_sim.hpp"
+#include "hal_linux_internal.hpp"
+
+static uint64_t monotonic_us()
+{
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (uint64_t)ts.tv_sec * 1000000ULL + (uint64_t)ts.tv_nsec / 1000ULL;
+}
+
+static const uint64_t s_boot_us = monotonic_us();
+static uint64_t s_clock_offset_ms = 0; // Unix time at boot once set by hal_fake_clock_set()
+
+uint32_t hal_millis()
+{
+    return (uint32_t)(hal_micros() / 1000ULL);
+}
+
+uint64_t hal_micros()
+{
+    if (hal_sim_active())
+    {
+        return hal_sim_now_us();
+    }
+    return monotonic_us() - s_boot_us;
+}
+
+void hal_delay_ms(uint32_t ms)
+{
+    if (hal_sim_active())
+    {
+        sim_sleep_us((uint64_t)ms * 1000ULL);
+        return;
+    }
+
+    struct timespec ts;
+    ts.tv_sec = ms / 1000;
+    ts.tv_nsec = (long)(ms % 1000) * 1000000L;
+    while (nanosleep(&ts, &ts) != 0 && errno == EINTR)
+        ;
+}
+
+void hal_delay_us(uint32_t us)
+{
+    if (hal_sim_active())
+    {
+        sim_sleep_us(us);
+        return;
+    }
+
+    struct timespec ts;
+    ts.tv_sec = us / 1000000;
+    ts.tv_nsec = (long)(us % 1000000) * 1000L;
+    while (nanosleep(&ts, &ts) != 0 && errno == EINTR)
+        ;
+}
+
+void hal_clock_sync(const char *server)
+{
+    (void)server; // Set by the test with hal_fake_clock_set()
+}
+
+uint64_t hal_unix_ms()
+{
+    return s_clock_offset_ms + hal_micros() / 1000ULL;
+}
+
+void hal_fake_clock_set(uint64_t unix_ms)
+{
+    s_clock_offset_ms = unix_ms - hal_micros() / 1000ULL;
+}
+
+#endif // HAL_LINUX
@@ -0,0 +1,156 @@
+#if defined(HAL_LINUX)
+
+#include <pthread.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <time.h>
+#include "../hal_timer.hpp"
+#include "hal_sim.hpp"
+#include "hal_linux_internal.hpp"
+
+/*
+ * Each timer is served by its own thread, which mirrors the ESP_TIMER_TASK
+ * dispatch of esp_timer: callbacks never run concurrently with each other
+ * for the same timer and never in interrupt context. Under the simulator
+ * timers are served by its virtual-time timer task instead.
+ */
+
+struct LinuxTimer
+{
+    pthread_t thread;
+    pthread_mutex_t mutex;
+    pthread_cond_t cond;
+    hal_timer_cb_t callback;
+    void *arg;
+    bool armed;
+    uint64_t period_us; // 0 for one-shot timers
+    struct timespec deadline;
+};
+
+static struct timespec deadline_after_us(uint64_t timeout_us)
+{
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    ts.tv_sec += (time_t)(timeout_us / 1000000ULL);
+    ts.tv_nsec += (long)(timeout_us % 1000000ULL) * 1000L;
+    if (ts.tv_nsec >= 1000000000L)
+    {
+        ts.tv_sec++;
+        ts.tv_nsec -= 1000000000L;
+    }
+    return ts;
+}
+
+static void *timer_thread(void *param)
+{
+    LinuxTimer *timer = (LinuxTimer *)param;
+    pthread_mutex_lock(&timer->mutex);
+    while (true)
+    {
+        if (!timer->armed)
+        {
+            pthread_cond_wait(&timer->cond, &timer->mutex);
+            continue;
+        }
+
+        int result = pthread_cond_timedwait(&timer->cond, &timer->mutex, &timer->deadline);
+        if (result == 0 || !timer->armed)
+        {
+            continue; // Restarted or stopped, re-evaluate the deadline
+        }
+
+        if (timer->period_us > 0)
+        {
+            timer->deadline = deadline_after_us(timer->period_us);
+        }
+        else
+        {
+            timer->armed = false;
+        }
+        hal_timer_cb_t callback = timer->callback;
+        void *arg = timer->arg;
+        pthread_mutex_unlock(&timer->mutex);
+        callback(arg);
+        pthread_mutex_lock(&timer->mutex);
+    }
+    return NULL;
+}
+
+hal_timer_t hal_timer_create(const char *name, hal_timer_cb_t callback, void *arg)
+{
+    if (hal_sim_active())
+    {
+        return sim_timer_create(callback, arg);
+    }
+
+    LinuxTimer *timer = (LinuxTimer *)calloc(1, sizeof(LinuxTimer));
+    if (timer == NULL)
+    {
+        return NULL;
+    }
+    timer->callback = callback;
+    timer->arg = arg;
+    pthread_mutex_init(&timer->mutex, NULL);
+
+    pthread_condattr_t attr;
+    pthread_condattr_init(&attr);
+    pthread_condattr_setclock(&attr, CLOCK_MONOTONIC);
+    pthread_cond_init(&timer->cond, &attr);
+    pthread_condattr_destroy(&attr);
+
+    if (pthread_create(&timer->thread, NULL, timer_thread, timer) != 0)
+    {
+        free(timer);
+        return NULL;
+    }
+    pthread_detach(timer->thread);
+    if (name != NULL)
+    {
+        char thread_name[16] = {0};
+        snprintf(thread_name, sizeof(thread_name), "%s", name);
+        pthread_setname_np(timer->thread, thread_name);
+    }
+    return timer;
+}
+
+static bool start_timer(hal_timer_t handle, uint64_t timeout_us, uint64_t period_us)
+{
+    if (hal_sim_active())
+    {
+        return sim_timer_start(handle, timeout_us, period_us);
+    }
+    LinuxTimer *timer = (LinuxTimer *)handle;
+    pthread_mutex_lock(&timer->mutex);
+    timer->armed = true;
+    timer->period_us = period_us;
+    timer->deadline = deadline_after_us(timeout_us);
+    pthread_cond_signal(&timer->cond);
+    pthread_mutex_unlock(&timer->mutex);
+    return true;
+}
+
+bool hal_timer_start_once(hal_timer_t timer, uint64_t timeout_us)
+{
+    return start_timer(timer, timeout_us, 0);
+}
+
+bool hal_timer_start_periodic(hal_timer_t timer, uint64_t period_us)
+{
+    return start_timer(timer, period_us, period_us);
+}
+
+void hal_timer_stop(hal_timer_t handle)
+{
+    if (hal_sim_active())
+    {
+        sim_timer_stop(handle);
+        return;
+    }
+    LinuxTimer *timer = (LinuxTimer *)handle;
+    pthread_mutex_lock(&timer->mutex);
+    timer->armed = false;
+    pthread_cond_signal(&timer->cond);
+    pthread_mutex_unlock(&timer->mutex);
+}
+
+#endif // HAL_LINUX
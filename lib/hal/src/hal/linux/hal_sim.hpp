@@ -0,0 +1,98 @@
+#pragma once
+
+/*
+ * Deterministic virtual-time simulator of the Linux backend.
+ *
+ * Once hal_sim_begin() is called, hal_millis()/hal_micros() return virtual
+ * time and tasks, timers, queues, mutexes and notifications are driven by a
+ * FreeRTOS-like scheduler model: exactly one task runs at a time, the
+ * highest-priority ready task is always picked (FIFO among equal
+ * priorities), waking a higher-priority task preempts the running one, and
+ * virtual time jumps straight to the next wake-up when every task is blocked.
+ * Code executes in zero virtual time, so a whole node runs many times
+ * faster than real time and every run of the same script is identical.
+ * SPI and I2C transfers are the exception: they take their time on the
+ * wire at the bus clock.
+ *
+ * Busy-waiting on hal_millis() never terminates under the simulator;
+ * modules have to block through the HAL (hal_delay_ms(), queues, ...).
+ */
+
+#include <stddef.h>
+#include <stdint.h>
+
+/// Scripted event, runs in the timer service task at its virtual time.
+typedef void (*hal_sim_event_t)(void *ctx);
+
+/// One edge of a scripted input waveform.
+struct HalSimEdge
+{
+    uint64_t time_us; ///< Virtual time of the edge.
+    uint8_t pin;      ///< GPIO number.
+    uint8_t level;    ///< HAL_HIGH or HAL_LOW after the edge.
+};
+
+/**
+ * @brief Switches the HAL to virtual time.
+ *
+ * Must be called from the main thread before any other HAL call. The
+ * calling thread becomes a simulated task (the equivalent of the Arduino
+ * loop task) and keeps running until it blocks.
+ *
+ * @param main_priority Priority of the calling thread in the scheduler model.
+ */
+void hal_sim_begin(uint8_t main_priority = 1);
+
+/**
+ * @brief Returns true once hal_sim_begin() has been called.
+ */
+bool hal_sim_active();
+
+/**
+ * @brief Returns the current virtual time in microseconds.
+ */
+uint64_t hal_sim_now_us();
+
+/**
+ * @brief Lets the simulated node run until the given virtual time.
+ *
+ * @param time_us Absolute virtual time to stop at.
+ */
+void hal_sim_run_until(uint64_t time_us);
+
+/**
+ * @brief Lets the simulated node run for the given amount of virtual time.
+ *
+ * @param duration_us Virtual time to advance.
+ */
+void hal_sim_run_for(uint64_t duration_us);
+
+/**
+ * @brief Schedules a scripted event at an absolute virtual time.
+ *
+ * Events at the same time run in the order they were scheduled.
+ *
+ * @param time_us Absolute virtual time of the event.
+ * @param event Function to call.
+ * @param ctx Argument passed to the function.
+ * @return true if the event was scheduled, false otherwise.
+ */
+bool hal_sim_at(uint64_t time_us, hal_sim_event_t event, void *ctx);
+
+/**
+ * @brief Schedules the edges of an input waveform.
+ *
+ * Each edge is applied with hal_fake_gpio_set_input(), so attached
+ * interrupt handlers run at the edge time. The array must stay valid until
+ * the last edge has been played.
+ *
+ * @param edges Edges sorted by time.
+ * @param count Number of edges.
+ * @return true if every edge was scheduled, false otherwise.
+ */
+bool hal_sim_play_waveform(const HalSimEdge *edges, size_t count);
+
+/**
+ * @brief Returns the number of context switches performed so far.
+ */
+uint64_t hal_sim_context_switches();
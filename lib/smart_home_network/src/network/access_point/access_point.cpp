@@ -1,4 +1,9 @@
+#if defined(ARDUINO)
+
 #include "access_point.hpp"
+
+#if NETWORK_ENABLE_PORTAL
+
 #include "freertos/semphr.h"
 
 // Global mutex to protect Preferences access
@@ -216,3 +221,7 @@ void AccessPoint::startAPTask(const char *apSSID, const char *apPassword)
         }
     }
 }
+
+#endif // NETWORK_ENABLE_PORTAL
+
+#endif // ARDUINO
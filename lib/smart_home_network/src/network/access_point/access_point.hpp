@@ -1,5 +1,9 @@
 #pragma once
 
+#include "../network_config.hpp"
+
+#if NETWORK_ENABLE_PORTAL
+
 #include <Arduino.h>
 #include <WiFi.h>
 #include <WebServer.h>
@@ -135,3 +139,5 @@ private:
     static volatile bool _apExitRequested; ///< Indicates if exit from AP mode has been requested.
     static TaskHandle_t _apTaskHandle;     ///< Handle for the AP task.
 };
+
+#endif // NETWORK_ENABLE_PORTAL
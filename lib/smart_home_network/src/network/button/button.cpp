@@ -1,3 +1,5 @@
+#if defined(ARDUINO)
+
 #include "button.hpp"
 
 // Define the static logging tag.
@@ -13,6 +15,7 @@ Button::Button(uint8_t pin, uint32_t holdTime, uint32_t debounceDelay)
       _pressStartTime(0),
       _longPressTriggered(false)
 {
+#if NETWORK_ENABLE_PORTAL
     // Default long-press callback:
     // If the AP mode is inactive, start AP mode;
     // if AP mode is active, request exit from AP mode.
@@ -29,6 +32,7 @@ Button::Button(uint8_t pin, uint32_t holdTime, uint32_t debounceDelay)
             AccessPoint::startAPTask("ESP32_Config", "config123");
         }
     };
+#endif
 }
 
 bool Button::begin()
@@ -90,3 +94,5 @@ void Button::handle()
         }
     }
 }
+
+#endif // ARDUINO
@@ -2,6 +2,7 @@
 
 #include <Arduino.h>
 #include <functional>
+#include "../network_config.hpp"
 #include "../access_point/access_point.hpp"
 #include "esp_log.h"
 
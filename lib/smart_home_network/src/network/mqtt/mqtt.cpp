@@ -1,3 +1,5 @@
+#if defined(ARDUINO)
+
 #include "mqtt.hpp"
 
 #define MQTT_TAG_LOG "app_mqtt"
@@ -81,6 +83,7 @@ bool MqttManager::begin()
 
     mqttClient.setServer(credentials.broker.c_str(), credentials.port);
     mqttClient.setCallback(MqttManager::mqttCallback);
+    mqttClient.setBufferSize(NETWORK_MQTT_BUFFER_SIZE);
 
     ESP_LOGI(MQTT_TAG, "Connecting to MQTT broker %s:%d with client ID %s...",
              credentials.broker.c_str(), credentials.port, credentials.clientId.c_str());
@@ -91,6 +94,7 @@ bool MqttManager::begin()
     {
         ESP_LOGI(MQTT_TAG, "Connected to MQTT broker.");
         mqttConnected = true;
+        resubscribe();
     }
     else
     {
@@ -115,6 +119,7 @@ void MqttManager::handle()
             {
                 ESP_LOGI(MQTT_TAG, "Reconnected to MQTT broker.");
                 mqttConnected = true;
+                resubscribe();
             }
             else
             {
@@ -128,11 +133,31 @@ void MqttManager::handle()
 }
 
 bool MqttManager::publishMessage(const String &topic, const String &message)
+{
+    return publishMessage(topic.c_str(), message.c_str());
+}
+
+bool MqttManager::publishMessage(const char *topic, const char *message)
+{
+    if (mqttClient.connected())
+    {
+        bool result = mqttClient.publish(topic, message);
+        ESP_LOGI(MQTT_TAG, "Published message to topic %s: %s", topic, message);
+        return result;
+    }
+    else
+    {
+        ESP_LOGW(MQTT_TAG, "MQTT is not connected. Cannot publish message.");
+        return false;
+    }
+}
+
+bool MqttManager::publishBinary(const char *topic, const uint8_t *payload, size_t length)
 {
     if (mqttClient.connected())
     {
-        bool result = mqttClient.publish(topic.c_str(), message.c_str());
-        ESP_LOGI(MQTT_TAG, "Published message to topic %s: %s", topic.c_str(), message.c_str());
+        bool result = mqttClient.publish(topic, payload, length);
+        ESP_LOGI(MQTT_TAG, "Published %u bytes to topic %s", (unsigned)length, topic);
         return result;
     }
     else
@@ -142,23 +167,46 @@ bool MqttManager::publishMessage(const String &topic, const String &message)
     }
 }
 
-bool MqttManager::publishRfidEvent(const String &uid)
+String MqttManager::encodeValue(const String &value)
 {
-    String payload = "{\"value\": \"" + uid + "\"}";
-    return publishMessage(RFID_TOPIC, payload);
+#if NETWORK_MQTT_ENCODING == NETWORK_ENCODING_JSON
+    return "{\"value\": \"" + value + "\"}";
+#else
+    return value;
+#endif
 }
 
-bool MqttManager::publishPinpadEvent(const String &pinCode)
+size_t MqttManager::encodeValue(const char *value, char *buffer, size_t size)
 {
-    String payload = "{\"value\": \"" + pinCode + "\"}";
+    return mqtt_encode_value(value, buffer, size);
+}
+
+#if NETWORK_ENABLE_ACCESS_EVENTS
+bool MqttManager::publishRfidEvent(const char *uid)
+{
+    char payload[48]; // Longest UID in JSON
+    return encodeValue(uid, payload, sizeof(payload)) < sizeof(payload) && publishMessage(RFID_TOPIC, payload);
+}
+
+bool MqttManager::publishPinpadEvent(bool granted)
+{
+    char payload[32];
+    encodeValue(granted ? "granted" : "denied", payload, sizeof(payload));
     return publishMessage(PINPAD_TOPIC, payload);
 }
+#endif
 
 void MqttManager::registerCallback(const String &topic, std::function<void(const String &topic, const String &payload)> callback)
 {
     // Add new topic callback and subscribe to the topic.
-    struct TopicCallback tc = {topic, callback};
-    callbacks.push_back(tc);
+    topics.add(topic.c_str(), [callback](const char *topic, const char *payload, size_t length)
+               { callback(String(topic), String(payload)); });
+    subscribeTopic(topic);
+}
+
+void MqttManager::registerHandler(const char *topic, MqttMessageHandler handler)
+{
+    topics.add(topic, handler);
     subscribeTopic(topic);
 }
 
@@ -166,7 +214,7 @@ bool MqttManager::subscribeTopic(const String &topic)
 {
     if (mqttClient.connected())
     {
-        bool result = mqttClient.subscribe(topic.c_str());
+        bool result = mqttClient.subscribe(topic.c_str(), NETWORK_MQTT_QOS);
         if (result)
         {
             ESP_LOGI(MQTT_TAG, "Subscribed to topic: %s", topic.c_str());
@@ -189,23 +237,26 @@ bool MqttManager::isConnected()
     return mqttClient.connected();
 }
 
+void MqttManager::disconnect()
+{
+    mqttClient.disconnect();
+    mqttConnected = false;
+}
+
+void MqttManager::resubscribe()
+{
+    topics.forEachTopic([this](const char *topic)
+                        { return subscribeTopic(topic); });
+}
+
 void MqttManager::mqttCallback(char *topic, byte *payload, unsigned int length)
 {
-    String message;
-    for (unsigned int i = 0; i < length; i++)
-    {
-        message += (char)payload[i];
-    }
-    ESP_LOGI(MQTT_TAG, "Received message on topic %s: %s", topic, message.c_str());
+    ESP_LOGI(MQTT_TAG, "Received %u bytes on topic %s", length, topic);
 
     if (instance != nullptr)
     {
-        for (const auto &tc : instance->callbacks)
-        {
-            if (tc.topic.equals(topic))
-            {
-                tc.callback(String(topic), message);
-            }
-        }
+        instance->topics.dispatch(topic, payload, length);
     }
 }
+
+#endif // ARDUINO
@@ -4,9 +4,10 @@
 #include <WiFiClient.h>
 #include <PubSubClient.h>
 #include <Preferences.h>
-#include <vector>
 #include <functional>
 #include "esp_log.h"
+#include "../network_config.hpp"
+#include "mqtt_topics.hpp"
 
 /**
  * @brief Class for managing the MQTT connection.
@@ -74,21 +75,62 @@ public:
      */
     bool publishMessage(const String &topic, const String &message);
 
+    /**
+     * @brief Publishes a message to the specified topic without copying it into Strings.
+     *
+     * @param topic The MQTT topic.
+     * @param message The message payload.
+     * @return true if the publish was successful, false otherwise.
+     */
+    bool publishMessage(const char *topic, const char *message);
+
+    /**
+     * @brief Publishes a binary payload, sent as is whatever NETWORK_MQTT_ENCODING is.
+     *
+     * @param topic The MQTT topic.
+     * @param payload The payload bytes.
+     * @param length The payload length, may be 0.
+     * @return true if the publish was successful, false otherwise.
+     */
+    bool publishBinary(const char *topic, const uint8_t *payload, size_t length);
+
+    /**
+     * @brief Builds an event payload in the configured encoding.
+     *
+     * @param value The event value.
+     * @return The value wrapped according to NETWORK_MQTT_ENCODING.
+     */
+    static String encodeValue(const String &value);
+
+    /**
+     * @brief Builds an event payload in the configured encoding into a buffer.
+     *
+     * @param value The event value.
+     * @param buffer Destination of the payload.
+     * @param size Size of the buffer.
+     * @return Length of the payload, size or more if it was truncated.
+     */
+    static size_t encodeValue(const char *value, char *buffer, size_t size);
+
+#if NETWORK_ENABLE_ACCESS_EVENTS
     /**
      * @brief Publishes an RFID event.
      *
      * @param uid The RFID card UID.
      * @return true if the publish was successful, false otherwise.
      */
-    bool publishRfidEvent(const String &uid);
+    bool publishRfidEvent(const char *uid);
 
     /**
      * @brief Publishes a pinpad event.
      *
-     * @param pinCode The entered pin code.
+     * Only the decision is sent ("granted" or "denied"), never the PIN.
+     *
+     * @param granted true if the entered PIN was accepted.
      * @return true if the publish was successful, false otherwise.
      */
-    bool publishPinpadEvent(const String &pinCode);
+    bool publishPinpadEvent(bool granted);
+#endif
 
     /**
      * @brief Registers a callback for a specific topic.
@@ -100,6 +142,16 @@ public:
      */
     void registerCallback(const String &topic, std::function<void(const String &topic, const String &payload)> callback);
 
+    /**
+     * @brief Registers a handler receiving the topic and payload as C strings.
+     *
+     * Same as registerCallback() without building a String per message.
+     *
+     * @param topic The MQTT topic.
+     * @param handler The handler.
+     */
+    void registerHandler(const char *topic, MqttMessageHandler handler);
+
     /**
      * @brief Subscribes to the specified topic.
      *
@@ -115,6 +167,13 @@ public:
      */
     bool isConnected();
 
+    /**
+     * @brief Disconnects from the broker, e.g. before sleeping.
+     *
+     * Call begin() to connect again.
+     */
+    void disconnect();
+
 private:
     /// Structure for holding MQTT credentials.
     struct MqttCredentials
@@ -151,23 +210,25 @@ private:
      */
     static void mqttCallback(char *topic, byte *payload, unsigned int length);
 
+    /**
+     * @brief Subscribes again to the topics of all registered callbacks.
+     *
+     * Subscriptions do not survive a new broker session.
+     */
+    void resubscribe();
+
     WiFiClient wifiClient;       ///< WiFi client instance.
     PubSubClient mqttClient;     ///< PubSubClient instance.
     MqttCredentials credentials; ///< MQTT credentials.
     bool mqttConnected;          ///< Connection status flag.
 
-    /// Structure for mapping a topic to a callback.
-    struct TopicCallback
-    {
-        String topic;
-        std::function<void(const String &topic, const String &payload)> callback;
-    };
-
-    std::vector<TopicCallback> callbacks; ///< Registered callbacks.
+    MqttTopicTable topics; ///< Registered callbacks.
 
+#if NETWORK_ENABLE_ACCESS_EVENTS
     // Example topics (can be extended later)
     static constexpr const char *RFID_TOPIC = "smarthome/security/RFID/data";
     static constexpr const char *PINPAD_TOPIC = "smarthome/security/pinpad/data";
+#endif
 
     static const int MAX_RETRY_COUNT = 10;      ///< Maximum retry count (unused in current implementation).
     static const int RECONNECT_DELAY_MS = 5000; ///< Delay (ms) between reconnection attempts.
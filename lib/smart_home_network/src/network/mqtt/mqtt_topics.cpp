@@ -0,0 +1,81 @@
+#include <stdio.h>
+#include <string.h>
+#include "mqtt_topics.hpp"
+
+/* FNV-1a */
+static uint32_t topic_hash(const char *topic)
+{
+    uint32_t hash = 2166136261U;
+    for (; *topic != '\0'; topic++)
+    {
+        hash = (hash ^ (uint8_t)*topic) * 16777619U;
+    }
+    return hash;
+}
+
+size_t mqtt_encode_value(const char *value, char *buffer, size_t size)
+{
+#if NETWORK_MQTT_ENCODING == NETWORK_ENCODING_JSON
+    int length = snprintf(buffer, size, "{\"value\": \"%s\"}", value);
+#else
+    int length = snprintf(buffer, size, "%s", value);
+#endif
+    return length < 0 ? size : (size_t)length;
+}
+
+void MqttTopicTable::add(const char *topic, MqttMessageHandler handler)
+{
+    Entry entry;
+    entry.topic = topic;
+    entry.hash = topic_hash(topic);
+    entry.handler = handler;
+    entries.push_back(entry);
+}
+
+size_t MqttTopicTable::dispatch(const char *topic, const uint8_t *payload, size_t length)
+{
+    if (payloadBuffer.size() < length + 1)
+    {
+        payloadBuffer.resize(length + 1);
+    }
+    if (length > 0)
+    {
+        memcpy(payloadBuffer.data(), payload, length);
+    }
+    payloadBuffer[length] = '\0';
+
+    uint32_t hash = topic_hash(topic);
+    size_t called = 0;
+    for (const Entry &entry : entries)
+    {
+        if (entry.hash == hash && entry.topic == topic)
+        {
+            entry.handler(topic, payloadBuffer.data(), length);
+            called++;
+        }
+    }
+    return called;
+}
+
+size_t MqttTopicTable::forEachTopic(const std::function<bool(const char *topic)> &visit) const
+{
+    size_t visited = 0;
+    for (size_t i = 0; i < entries.size(); i++)
+    {
+        bool seen = false;
+        for (size_t j = 0; j < i && !seen; j++)
+        {
+            seen = entries[j].hash == entries[i].hash && entries[j].topic == entries[i].topic;
+        }
+        if (!seen && visit(entries[i].topic.c_str()))
+        {
+            visited++;
+        }
+    }
+    return visited;
+}
+
+size_t MqttTopicTable::size() const
+{
+    return entries.size();
+}
@@ -0,0 +1,85 @@
+#pragma once
+
+/*
+ * Transport-independent part of the MQTT client: payload encoding and the
+ * table routing received messages to the handlers of their topic.
+ *
+ * No Arduino dependency, so it is built and tested on the host
+ * (`pio test -e native` in lib/smart_home_network).
+ */
+
+#include <stddef.h>
+#include <stdint.h>
+#include <functional>
+#include <string>
+#include <vector>
+#include "../network_config.hpp"
+
+/// Receives the messages of a topic, payload NUL-terminated.
+typedef std::function<void(const char *topic, const char *payload, size_t length)> MqttMessageHandler;
+
+/**
+ * @brief Builds an event payload in the configured encoding into a buffer.
+ *
+ * @param value The event value.
+ * @param buffer Destination of the payload.
+ * @param size Size of the buffer.
+ * @return Length of the payload, size or more if it was truncated.
+ */
+size_t mqtt_encode_value(const char *value, char *buffer, size_t size);
+
+/**
+ * @brief Handlers registered per topic, in registration order.
+ *
+ * Topics are matched exactly (no wildcards). Each entry keeps a hash of
+ * its topic, so a message only costs a string comparison on the entries
+ * that can match.
+ */
+class MqttTopicTable
+{
+public:
+    /**
+     * @brief Registers a handler, several handlers may share a topic.
+     *
+     * @param topic The MQTT topic, copied.
+     * @param handler The handler.
+     */
+    void add(const char *topic, MqttMessageHandler handler);
+
+    /**
+     * @brief Calls the handlers of a received message.
+     *
+     * The payload is copied into a reused buffer and NUL-terminated first.
+     *
+     * @param topic The topic the message was received on.
+     * @param payload The payload bytes.
+     * @param length The payload length.
+     * @return Number of handlers called.
+     */
+    size_t dispatch(const char *topic, const uint8_t *payload, size_t length);
+
+    /**
+     * @brief Visits every registered topic once, e.g. to subscribe again after reconnecting.
+     *
+     * @param visit Called with each distinct topic, in registration order.
+     * @return Number of topics for which visit returned true.
+     */
+    size_t forEachTopic(const std::function<bool(const char *topic)> &visit) const;
+
+    /**
+     * @brief Returns the number of registered handlers.
+     */
+    size_t size() const;
+
+private:
+    /// Handler of one topic.
+    struct Entry
+    {
+        std::string topic;
+        uint32_t hash;
+        MqttMessageHandler handler;
+    };
+
+    std::vector<Entry> entries;
+    std::vector<char> payloadBuffer; ///< Last payload, NUL-terminated.
+};
@@ -0,0 +1,42 @@
+#pragma once
+
+/*
+ * Compile-time feature switches for the network library.
+ *
+ * Every node sets the switches it needs through build_flags in its
+ * platformio.ini, e.g. -DNETWORK_ENABLE_PORTAL=0. Disabled features are
+ * not compiled at all, so they cost no flash in that node's image.
+ */
+
+/* Payload encodings */
+#define NETWORK_ENCODING_RAW 0  // Payload is the bare value
+#define NETWORK_ENCODING_JSON 1 // Payload is {"value": "<value>"}
+
+/* Configuration portal (Access Point + HTTP server) started by a long button press */
+#ifndef NETWORK_ENABLE_PORTAL
+#define NETWORK_ENABLE_PORTAL 1
+#endif
+
+/* RFID/pinpad publish helpers, only needed on the access control node */
+#ifndef NETWORK_ENABLE_ACCESS_EVENTS
+#define NETWORK_ENABLE_ACCESS_EVENTS 0
+#endif
+
+/* QoS used for subscriptions (PubSubClient publishes with QoS 0 only) */
+#ifndef NETWORK_MQTT_QOS
+#define NETWORK_MQTT_QOS 0
+#endif
+
+/* Encoding of the event payloads built by MqttManager */
+#ifndef NETWORK_MQTT_ENCODING
+#define NETWORK_MQTT_ENCODING NETWORK_ENCODING_JSON
+#endif
+
+/* Largest MQTT packet sent or received, topic included (PubSubClient default is 256) */
+#ifndef NETWORK_MQTT_BUFFER_SIZE
+#define NETWORK_MQTT_BUFFER_SIZE 256
+#endif
+
+#if NETWORK_MQTT_QOS != 0 && NETWORK_MQTT_QOS != 1
+#error "NETWORK_MQTT_QOS must be 0 or 1"
+#endif
@@ -1,3 +1,5 @@
+#if defined(ARDUINO)
+
 #include "wifi.hpp"
 #include "esp_log.h"
 #include "../access_point/access_point.hpp"
@@ -118,11 +120,13 @@ bool WiFiManager::reconnect()
 
 void WiFiManager::handle()
 {
+#if NETWORK_ENABLE_PORTAL
     // If AP mode is active, skip connection attempts.
     if (AccessPoint::isAPActive())
     {
         return;
     }
+#endif
 
     if (WiFi.status() != WL_CONNECTED)
     {
@@ -143,6 +147,20 @@ void WiFiManager::handle()
     }
 }
 
+void WiFiManager::stop()
+{
+    WiFi.disconnect(true);
+    WiFi.mode(WIFI_OFF);
+    _wasConnected = false;
+    ESP_LOGI(WIFI_TAG, "WiFi stopped.");
+}
+
+bool WiFiManager::resume()
+{
+    WiFi.mode(WIFI_STA);
+    return connect();
+}
+
 void WiFiManager::wifiEventHandler(WiFiEvent_t event)
 {
     if (instance == nullptr)
@@ -169,3 +187,5 @@ void WiFiManager::wifiEventHandler(WiFiEvent_t event)
         break;
     }
 }
+
+#endif // ARDUINO
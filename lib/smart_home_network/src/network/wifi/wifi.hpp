@@ -45,7 +45,8 @@ public:
      *
      * This method sets the WiFi mode to STA, clears previous connections,
      * registers the event handler, and performs a one-time connection attempt.
-     * Execution continues regardless of the result.
+     * Execution continues regardless of the result. Call it once, use resume()
+     * to connect again after stop().
      *
      * @return true if the one-time connection attempt succeeded, false otherwise.
      */
@@ -73,6 +74,22 @@ public:
      */
     void handle();
 
+    /**
+     * @brief Disconnects and turns the radio off, e.g. before sleeping.
+     *
+     * Call resume() to connect again.
+     */
+    void stop();
+
+    /**
+     * @brief Turns the radio back on after stop() and starts connecting.
+     *
+     * The event handler registered by begin() stays in place.
+     *
+     * @return true if the connection attempt succeeded, false otherwise.
+     */
+    bool resume();
+
 private:
     /// Structure to store WiFi credentials.
     struct WifiCredentials
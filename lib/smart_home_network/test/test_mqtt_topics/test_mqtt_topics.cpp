@@ -0,0 +1,186 @@
+#include <unity.h>
+#include <stdio.h>
+#include <string.h>
+#include <chrono>
+#include <string>
+#include <vector>
+#include "network/mqtt/mqtt_topics.hpp"
+
+/* Topics subscribed by the nodes, the benchmark dispatches over all of them */
+static const char *const node_topics[] = {
+    "smarthome/security/arm",
+    "smarthome/security/alarm/ack",
+    "smarthome/environment/fan/config",
+    "smarthome/environment/history/query",
+    "smarthome/access/credentials",
+    "smarthome/access/log/query",
+    "smarthome/access/door/open",
+    "smarthome/ota",
+};
+#define NODE_TOPICS (sizeof(node_topics) / sizeof(node_topics[0]))
+
+struct Received
+{
+    std::string topic;
+    std::string payload;
+    size_t length;
+};
+
+static std::vector<Received> received;
+
+static void record(const char *topic, const char *payload, size_t length)
+{
+    received.push_back({topic, payload, length});
+}
+
+static uint64_t now_ns()
+{
+    return std::chrono::duration_cast<std::chrono::nanoseconds>(
+               std::chrono::steady_clock::now().time_since_epoch())
+        .count();
+}
+
+void setUp()
+{
+    received.clear();
+}
+
+void tearDown()
+{
+}
+
+static void test_encode_json()
+{
+    char buffer[32];
+    size_t length = mqtt_encode_value("1", buffer, sizeof(buffer));
+    TEST_ASSERT_EQUAL_STRING("{\"value\": \"1\"}", buffer);
+    TEST_ASSERT_EQUAL_UINT(strlen(buffer), length);
+}
+
+static void test_encode_truncated()
+{
+    char buffer[8];
+    size_t length = mqtt_encode_value("granted", buffer, sizeof(buffer));
+    TEST_ASSERT_GREATER_OR_EQUAL_UINT(sizeof(buffer), length);
+    TEST_ASSERT_EQUAL_UINT(sizeof(buffer) - 1, strlen(buffer));
+}
+
+static void test_dispatch_exact_topic()
+{
+    MqttTopicTable table;
+    table.add("a/b", record);
+    table.add("a/c", record);
+
+    const uint8_t payload[] = {'o', 'n'};
+    TEST_ASSERT_EQUAL_UINT(1, table.dispatch("a/c", payload, sizeof(payload)));
+    TEST_ASSERT_EQUAL_UINT(0, table.dispatch("a/b/c", payload, sizeof(payload)));
+    TEST_ASSERT_EQUAL_UINT(0, table.dispatch("a", payload, sizeof(payload)));
+    TEST_ASSERT_EQUAL_UINT(1, received.size());
+    TEST_ASSERT_EQUAL_STRING("a/c", received[0].topic.c_str());
+    TEST_ASSERT_EQUAL_STRING("on", received[0].payload.c_str());
+    TEST_ASSERT_EQUAL_UINT(2, received[0].length);
+}
+
+static void test_dispatch_shared_topic()
+{
+    MqttTopicTable table;
+    int order = 0, first = 0, second = 0;
+    table.add("t", [&](const char *, const char *, size_t)
+              { first = ++order; });
+    table.add("t", [&](const char *, const char *, size_t)
+              { second = ++order; });
+
+    const uint8_t payload[] = {'x'};
+    TEST_ASSERT_EQUAL_UINT(2, table.dispatch("t", payload, sizeof(payload)));
+    TEST_ASSERT_EQUAL_INT(1, first);
+    TEST_ASSERT_EQUAL_INT(2, second);
+}
+
+static void test_dispatch_terminates_payload()
+{
+    MqttTopicTable table;
+    table.add("t", record);
+
+    /* A long payload then a shorter one reusing the buffer */
+    const uint8_t longer[] = {'1', '2', '3', '4', '5', '6'};
+    const uint8_t shorter[] = {'7', '8', '9', 'X'};
+    table.dispatch("t", longer, sizeof(longer));
+    table.dispatch("t", shorter, 3);
+    table.dispatch("t", nullptr, 0);
+    TEST_ASSERT_EQUAL_UINT(3, received.size());
+    TEST_ASSERT_EQUAL_STRING("123456", received[0].payload.c_str());
+    TEST_ASSERT_EQUAL_STRING("789", received[1].payload.c_str());
+    TEST_ASSERT_EQUAL_STRING("", received[2].payload.c_str());
+    TEST_ASSERT_EQUAL_UINT(0, received[2].length);
+}
+
+static void test_resubscribe_distinct_topics()
+{
+    MqttTopicTable table;
+    table.add("a", record);
+    table.add("b", record);
+    table.add("a", record);
+    table.add("c", record);
+
+    std::vector<std::string> visited;
+    size_t subscribed = table.forEachTopic([&](const char *topic)
+                                           {
+                                               visited.push_back(topic);
+                                               return visited.size() != 2; // Subscribing "b" fails
+                                           });
+    TEST_ASSERT_EQUAL_UINT(3, visited.size());
+    TEST_ASSERT_EQUAL_STRING("a", visited[0].c_str());
+    TEST_ASSERT_EQUAL_STRING("b", visited[1].c_str());
+    TEST_ASSERT_EQUAL_STRING("c", visited[2].c_str());
+    TEST_ASSERT_EQUAL_UINT(2, subscribed);
+    TEST_ASSERT_EQUAL_UINT(4, table.size());
+}
+
+static void test_benchmark()
+{
+    MqttTopicTable table;
+    size_t calls = 0;
+    for (size_t t = 0; t < NODE_TOPICS; t++)
+    {
+        table.add(node_topics[t], [&calls](const char *, const char *, size_t)
+                  { calls++; });
+    }
+
+    const uint8_t payload[] = "{\"value\": \"1\"}";
+    const int rounds = 100000;
+    uint64_t start = now_ns();
+    for (int i = 0; i < rounds; i++)
+    {
+        table.dispatch(node_topics[i % NODE_TOPICS], payload, sizeof(payload) - 1);
+    }
+    uint64_t dispatch_ns = now_ns() - start;
+    TEST_ASSERT_EQUAL_UINT(rounds, calls);
+
+    char buffer[64];
+    size_t total = 0;
+    start = now_ns();
+    for (int i = 0; i < rounds; i++)
+    {
+        total += mqtt_encode_value(i & 1 ? "granted" : "denied", buffer, sizeof(buffer));
+    }
+    uint64_t encode_ns = now_ns() - start;
+    TEST_ASSERT_GREATER_THAN_UINT(0, total);
+
+    char message[96];
+    snprintf(message, sizeof(message), "dispatch over %u topics %.1f ns, encode %.1f ns",
+             (unsigned)NODE_TOPICS, (double)dispatch_ns / rounds, (double)encode_ns / rounds);
+    TEST_MESSAGE(message);
+}
+
+int main()
+{
+    UNITY_BEGIN();
+    RUN_TEST(test_encode_json);
+    RUN_TEST(test_encode_truncated);
+    RUN_TEST(test_dispatch_exact_topic);
+    RUN_TEST(test_dispatch_shared_topic);
+    RUN_TEST(test_dispatch_terminates_payload);
+    RUN_TEST(test_resubscribe_distinct_topics);
+    RUN_TEST(test_benchmark);
+    return UNITY_END();
+}
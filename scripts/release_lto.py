@@ -0,0 +1,5 @@
+Import("env")
+
+# build_flags only reach the compiler, so link-time optimisation has to be
+# requested on the link line as well for the LTO objects to be merged.
+env.Append(LINKFLAGS=["-flto", "-Os"])
@@ -0,0 +1,71 @@
+#!/usr/bin/env python3
+"""Flash and static RAM of the debug and release images, side by side.
+
+Builds the esp32dev and release environments of each firmware project
+with `pio run -t size` and prints one Markdown table per project:
+
+    python scripts/size_report.py [project ...]
+
+Flash is the image (code, read-only data and initialised data), static
+RAM the .data and .bss sections, as reported by PlatformIO. Heap and
+boot time only show at run time: flash both images and read the
+BOOT_REPORT line printed on the serial monitor once setup() returns.
+"""
+
+import os
+import re
+import subprocess
+import sys
+
+ROOT = os.path.dirname(os.path.dirname(os.path.abspath(__file__)))
+PROJECTS = ["access_control", "environment_management", "security_management"]
+ENVS = ["esp32dev", "release"]
+
+USAGE = re.compile(r"^(RAM|Flash):.*\(used (\d+) bytes from (\d+) bytes\)", re.MULTILINE)
+BERKELEY = re.compile(r"^\s*(\d+)\s+(\d+)\s+(\d+)\s+\d+\s+[0-9a-f]+\s+\S*firmware\.elf", re.MULTILINE)
+
+
+def measure(project, env):
+    """Returns {"flash", "ram", "text", "data", "bss"} in bytes, None where not reported."""
+    result = subprocess.run(["pio", "run", "-d", os.path.join(ROOT, project), "-e", env, "-t", "size"],
+                            stdout=subprocess.PIPE, stderr=subprocess.STDOUT, universal_newlines=True)
+    if result.returncode != 0:
+        sys.stderr.write(result.stdout)
+        raise SystemExit("%s: building %s failed" % (project, env))
+
+    sizes = dict.fromkeys(["flash", "ram", "text", "data", "bss"])
+    for kind, used, _ in USAGE.findall(result.stdout):
+        sizes[kind.lower()] = int(used)
+    berkeley = BERKELEY.search(result.stdout)
+    if berkeley:
+        sizes["text"], sizes["data"], sizes["bss"] = (int(value) for value in berkeley.groups())
+    return sizes
+
+
+def cell(value):
+    return "-" if value is None else str(value)
+
+
+def change(before, after):
+    if before is None or after is None:
+        return "-"
+    return "%+d (%+.1f%%)" % (after - before, 100.0 * (after - before) / before if before else 0.0)
+
+
+def main():
+    projects = sys.argv[1:] or PROJECTS
+    for project in projects:
+        debug, release = (measure(project, env) for env in ENVS)
+        print("### %s\n" % project)
+        print("| Bytes | %s | %s | Change |" % tuple(ENVS))
+        print("|---|---|---|---|")
+        for key, name in [("flash", "Flash"), ("ram", "Static RAM"), ("text", ".text"), ("data", ".data"),
+                          ("bss", ".bss")]:
+            print("| %s | %s | %s | %s |" % (name, cell(debug[key]), cell(release[key]),
+                                             change(debug[key], release[key])))
+        print("| Free heap after setup() | board | board | |")
+        print("| Boot time | board | board | |\n")
+
+
+if __name__ == "__main__":
+    main()
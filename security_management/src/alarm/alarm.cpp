@@ -0,0 +1,351 @@
+#include "alarm.hpp"
+#include "event_queue.hpp"
+#include "../buzzer/buzzer.hpp"
+#include "../journal/journal.hpp"
+
+#define ALARM_TAG "app_alarm"
+
+#define ALARM_QUEUE_LENGTH 32 // Must be a power of two
+
+enum AlarmEventType : uint8_t
+{
+    ALARM_EVENT_RAISE,
+    ALARM_EVENT_CLEAR,
+    ALARM_EVENT_PULSE,
+    ALARM_EVENT_ACK,
+};
+
+struct AlarmEvent
+{
+    uint64_t timestamp_us; // hal_micros() when the event was posted
+    uint32_t sequence;     // Raise, pulse or acknowledge number, see below
+    uint8_t source;
+    uint8_t type;
+};
+
+/// Per-source behaviour
+struct AlarmPolicy
+{
+    const char *name;
+    bool latching;                 // Stays active after clearing until acknowledged
+    const BuzzerPattern *pattern; // Played while the source drives the buzzer
+};
+
+static const AlarmPolicy ALARM_POLICIES[ALARM_SOURCE_COUNT] = {
+    {"chime", false, &BUZZER_PATTERN_CHIRP},
+    {"tamper", true, &BUZZER_PATTERN_DOUBLE_CHIRP},
+    {"intrusion", true, &BUZZER_PATTERN_SIREN},
+    {"fire", true, &BUZZER_PATTERN_TEMPORAL3},
+};
+
+static EventQueue<AlarmEvent, ALARM_QUEUE_LENGTH> event_queue;
+static hal_task_t alarm_task = NULL;
+
+/*
+ * Producer state, updated before an event is posted. The queue keeps the
+ * events in order and timestamps them; when it is full the alarm task
+ * still finds every change here, so no raise, clear or acknowledge is lost.
+ */
+static std::atomic<uint16_t> levels[ALARM_SOURCE_COUNT];  // Producers currently raising each source
+static std::atomic<uint32_t> raises[ALARM_SOURCE_COUNT];  // Raises posted per source
+static std::atomic<uint32_t> pulses(0);
+static std::atomic<uint32_t> acks(0);
+
+// Only touched by the alarm task
+static uint32_t raises_applied[ALARM_SOURCE_COUNT] = {0};
+static uint32_t pulses_applied = 0;
+static uint32_t acks_applied = 0;
+static bool latched[ALARM_SOURCE_COUNT] = {false};
+static AlarmSource output_source = ALARM_SOURCE_NONE;
+
+static std::atomic<uint32_t> dropped_events(0);
+static AlarmStats stats = {};
+
+static bool post_event(AlarmSource source, AlarmEventType type, uint32_t sequence)
+{
+    AlarmEvent event;
+    event.timestamp_us = hal_micros();
+    event.sequence = sequence;
+    event.source = source;
+    event.type = type;
+
+    bool queued = event_queue.push(event);
+    if (!queued)
+    {
+        dropped_events.fetch_add(1, std::memory_order_relaxed);
+    }
+
+    hal_task_t task = alarm_task;
+    if (task != NULL)
+    {
+        hal_task_notify(task);
+    }
+    return queued;
+}
+
+/* True if sequence number a comes after b, wrap-around safe */
+static bool is_newer(uint32_t a, uint32_t b)
+{
+    return (int32_t)(a - b) > 0;
+}
+
+bool init_alarm()
+{
+    for (int i = 0; i < ALARM_SOURCE_COUNT; i++)
+    {
+        levels[i].store(0);
+        raises[i].store(0);
+        raises_applied[i] = 0;
+        latched[i] = false;
+    }
+    pulses.store(0);
+    acks.store(0);
+    pulses_applied = 0;
+    acks_applied = 0;
+    output_source = ALARM_SOURCE_NONE;
+    stats = AlarmStats();
+    ESP_LOGI(ALARM_TAG, "Alarm manager initialized");
+    return true;
+}
+
+void alarm_attach_task(hal_task_t task)
+{
+    alarm_task = task;
+}
+
+bool alarm_raise(AlarmSource source)
+{
+    if (source >= ALARM_SOURCE_COUNT)
+    {
+        return false;
+    }
+    uint16_t level = levels[source].load();
+    while (level < UINT16_MAX && !levels[source].compare_exchange_weak(level, level + 1))
+    {
+    }
+    return post_event(source, ALARM_EVENT_RAISE, raises[source].fetch_add(1) + 1);
+}
+
+bool alarm_clear(AlarmSource source)
+{
+    if (source >= ALARM_SOURCE_COUNT)
+    {
+        return false;
+    }
+    uint16_t level = levels[source].load();
+    do
+    {
+        if (level == 0)
+        {
+            ESP_LOGW(ALARM_TAG, "Unbalanced clear from %s", ALARM_POLICIES[source].name);
+            return true;
+        }
+    } while (!levels[source].compare_exchange_weak(level, level - 1));
+    return post_event(source, ALARM_EVENT_CLEAR, 0);
+}
+
+bool alarm_pulse(AlarmSource source)
+{
+    return post_event(source, ALARM_EVENT_PULSE, pulses.fetch_add(1) + 1);
+}
+
+bool alarm_acknowledge()
+{
+    return post_event(ALARM_SOURCE_NONE, ALARM_EVENT_ACK, acks.fetch_add(1) + 1);
+}
+
+static bool is_active(int source)
+{
+    return levels[source].load() > 0 || latched[source];
+}
+
+static AlarmSource evaluate()
+{
+    for (int i = ALARM_SOURCE_COUNT - 1; i >= 0; i--)
+    {
+        if (is_active(i))
+        {
+            return (AlarmSource)i;
+        }
+    }
+    return ALARM_SOURCE_NONE;
+}
+
+static void acknowledge(uint32_t sequence)
+{
+    acks_applied = sequence;
+    for (int i = 0; i < ALARM_SOURCE_COUNT; i++)
+    {
+        latched[i] = false;
+    }
+    journal_record(JOURNAL_EVENT_ALARM_ACK, 0);
+    ESP_LOGI(ALARM_TAG, "Alarms acknowledged");
+}
+
+static void latch(uint8_t source, uint32_t sequence)
+{
+    raises_applied[source] = sequence;
+    if (ALARM_POLICIES[source].latching)
+    {
+        latched[source] = true;
+    }
+}
+
+/* Applies a queued event unless the state already covers it, returns true if a chime should be played */
+static bool apply_event(const AlarmEvent &event)
+{
+    if (event.type == ALARM_EVENT_ACK)
+    {
+        if (is_newer(event.sequence, acks_applied))
+        {
+            acknowledge(event.sequence);
+        }
+        return false;
+    }
+
+    if (event.source >= ALARM_SOURCE_COUNT)
+    {
+        ESP_LOGW(ALARM_TAG, "Event from unknown source %d ignored", event.source);
+        return false;
+    }
+
+    switch (event.type)
+    {
+    case ALARM_EVENT_RAISE:
+        if (is_newer(event.sequence, raises_applied[event.source]))
+        {
+            latch(event.source, event.sequence);
+        }
+        return false;
+
+    case ALARM_EVENT_PULSE:
+        if (is_newer(event.sequence, pulses_applied))
+        {
+            pulses_applied = event.sequence;
+            return true;
+        }
+        return false;
+
+    default: // Clears only wake the task, the level is already updated
+        return false;
+    }
+}
+
+/*
+ * Applies the changes whose events did not fit in the queue (or are still
+ * being posted). An acknowledge goes first, so a raise lost in the same
+ * burst keeps its alarm on rather than being acknowledged unseen.
+ */
+static bool reconcile()
+{
+    uint32_t ack_count = acks.load();
+    if (ack_count != acks_applied)
+    {
+        acknowledge(ack_count);
+    }
+    for (uint8_t i = 0; i < ALARM_SOURCE_COUNT; i++)
+    {
+        uint32_t raise_count = raises[i].load();
+        if (raise_count != raises_applied[i])
+        {
+            latch(i, raise_count);
+        }
+    }
+    uint32_t pulse_count = pulses.load();
+    bool chime = pulse_count != pulses_applied;
+    pulses_applied = pulse_count;
+    return chime;
+}
+
+/* Buzzer priority of a source, above plain beep sequences */
+static uint8_t pattern_priority(AlarmSource source)
+{
+    return source + 2;
+}
+
+static void actuate(AlarmSource previous, AlarmSource source)
+{
+    if (previous != ALARM_SOURCE_NONE)
+    {
+        buzzer_stop(ALARM_POLICIES[previous].pattern);
+    }
+    if (source != ALARM_SOURCE_NONE)
+    {
+        buzzer_play(ALARM_POLICIES[source].pattern, pattern_priority(source));
+    }
+}
+
+void handle_alarm()
+{
+    AlarmEvent event;
+    uint64_t first_event_us = 0;
+    bool have_event = false;
+    bool chime = false;
+
+    while (event_queue.pop(event))
+    {
+        if (!have_event)
+        {
+            first_event_us = event.timestamp_us;
+            have_event = true;
+        }
+        chime |= apply_event(event);
+        stats.events++;
+    }
+    chime |= reconcile();
+
+    AlarmSource source = evaluate();
+    bool changed = source != output_source;
+
+    if (changed)
+    {
+        actuate(output_source, source);
+        if (source == ALARM_SOURCE_NONE)
+        {
+            journal_record(JOURNAL_EVENT_ALARM_OFF, output_source);
+            ESP_LOGI(ALARM_TAG, "Alarm cleared");
+        }
+        else
+        {
+            journal_record(JOURNAL_EVENT_ALARM_ON, source);
+            ESP_LOGI(ALARM_TAG, "Alarm state: %s", ALARM_POLICIES[source].name);
+        }
+        output_source = source;
+    }
+
+    if (chime && output_source == ALARM_SOURCE_NONE)
+    {
+        buzzer_play(ALARM_POLICIES[ALARM_SOURCE_CHIME].pattern, pattern_priority(ALARM_SOURCE_CHIME));
+        changed = true;
+    }
+
+    if (changed)
+    {
+        stats.actuations++;
+    }
+    if (changed && have_event) // Latency is unknown when every event was dropped
+    {
+        uint32_t latency_us = (uint32_t)(hal_micros() - first_event_us);
+        stats.last_latency_us = latency_us;
+        if (latency_us > stats.max_latency_us)
+        {
+            stats.max_latency_us = latency_us;
+        }
+        if (latency_us > ALARM_LATENCY_BUDGET_US)
+        {
+            stats.over_budget++;
+            ESP_LOGW(ALARM_TAG, "Actuation took %lu us, budget is %d us", (unsigned long)latency_us, ALARM_LATENCY_BUDGET_US);
+        }
+    }
+}
+
+AlarmSource alarm_active_source()
+{
+    return output_source;
+}
+
+void alarm_get_stats(AlarmStats *out)
+{
+    *out = stats;
+    out->dropped = dropped_events.load(std::memory_order_relaxed);
+}
@@ -0,0 +1,113 @@
+#pragma once
+
+#include "hal/hal.hpp"
+
+/**
+ * @brief Alarm sources, ordered by increasing severity.
+ *
+ * When several sources are active the most severe one drives the buzzer.
+ */
+enum AlarmSource : uint8_t
+{
+    ALARM_SOURCE_CHIME,     ///< Informational chime (e.g. window opened), momentary.
+    ALARM_SOURCE_TAMPER,    ///< Tamper detection (tilt sensor).
+    ALARM_SOURCE_INTRUSION, ///< Intrusion detection (PIR sensors).
+    ALARM_SOURCE_FIRE,      ///< Fire detection.
+    ALARM_SOURCE_COUNT,
+};
+
+#define ALARM_SOURCE_NONE ALARM_SOURCE_COUNT // No source active
+
+/* Maximum time between an event being posted and the buzzer reacting */
+#define ALARM_LATENCY_BUDGET_US 10000
+
+/// Counters describing the behaviour of the alarm manager.
+struct AlarmStats
+{
+    uint32_t events;          ///< Events processed.
+    uint32_t dropped;         ///< Events that did not fit in the queue, applied from the producer state.
+    uint32_t actuations;      ///< Buzzer state changes.
+    uint32_t last_latency_us; ///< Event-to-buzzer latency of the last actuation.
+    uint32_t max_latency_us;  ///< Worst event-to-buzzer latency seen.
+    uint32_t over_budget;     ///< Actuations slower than ALARM_LATENCY_BUDGET_US.
+};
+
+/**
+ * @brief Initializes the alarm manager.
+ *
+ * @return true if initialization was successful, false otherwise.
+ */
+bool init_alarm();
+
+/**
+ * @brief Sets the task consuming alarm events.
+ *
+ * Producers notify this task after posting an event so it reacts immediately.
+ *
+ * @param task Handle of the task calling handle_alarm().
+ */
+void alarm_attach_task(hal_task_t task);
+
+/**
+ * @brief Processes pending alarm events and drives the buzzer.
+ *
+ * Called by the alarm task whenever it is notified by a producer. The
+ * buzzer is only actuated when the resulting alarm state changes.
+ */
+void handle_alarm();
+
+/**
+ * @brief Reports that a producer sees an alarm condition.
+ *
+ * Each source keeps a reference count, so several producers of the same
+ * source (e.g. four PIR sensors) can raise and clear independently.
+ * Never blocks: the count is updated atomically and the event is posted
+ * through a lock-free queue. A full queue only costs the latency figure,
+ * the alarm task picks the change up from the count.
+ *
+ * @param source Alarm source.
+ * @return true if the event was queued, false if the queue is full.
+ */
+bool alarm_raise(AlarmSource source);
+
+/**
+ * @brief Reports that a producer no longer sees its alarm condition.
+ *
+ * Latching sources stay active until acknowledged even after every
+ * producer cleared them. Like alarm_raise(), never lost.
+ *
+ * @param source Alarm source.
+ * @return true if the event was queued, false if the queue is full.
+ */
+bool alarm_clear(AlarmSource source);
+
+/**
+ * @brief Signals a momentary event such as a chime.
+ *
+ * @param source Alarm source.
+ * @return true if the event was queued, false if the queue is full.
+ */
+bool alarm_pulse(AlarmSource source);
+
+/**
+ * @brief Acknowledges latched alarms.
+ *
+ * Sources whose producers have all cleared become inactive.
+ *
+ * @return true if the event was queued, false if the queue is full.
+ */
+bool alarm_acknowledge();
+
+/**
+ * @brief Returns the most severe active alarm source.
+ *
+ * @return Active source, ALARM_SOURCE_NONE if no alarm is active.
+ */
+AlarmSource alarm_active_source();
+
+/**
+ * @brief Copies the alarm manager counters.
+ *
+ * @param stats (Output) Current counters.
+ */
+void alarm_get_stats(AlarmStats *stats);
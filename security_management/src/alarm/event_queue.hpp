@@ -0,0 +1,113 @@
+#pragma once
+
+#include <stddef.h>
+#include <stdint.h>
+#include <atomic>
+
+/**
+ * @brief Bounded lock-free multi-producer queue.
+ *
+ * Sequence-numbered ring buffer (D. Vyukov's bounded MPMC queue): producers
+ * and the consumer only use atomic loads, stores and compare-and-swap, so
+ * push() is safe from any task or interrupt on either core and never blocks.
+ *
+ * @tparam T Trivially copyable item type.
+ * @tparam N Capacity, must be a power of two.
+ */
+template <typename T, size_t N>
+class EventQueue
+{
+    static_assert(N >= 2 && (N & (N - 1)) == 0, "EventQueue capacity must be a power of two");
+
+public:
+    EventQueue() : _enqueuePos(0), _dequeuePos(0)
+    {
+        for (size_t i = 0; i < N; i++)
+        {
+            _cells[i].sequence.store(i, std::memory_order_relaxed);
+        }
+    }
+
+    /**
+     * @brief Appends an item.
+     *
+     * @param item Item to copy into the queue.
+     * @return true if the item was queued, false if the queue is full.
+     */
+    bool push(const T &item)
+    {
+        size_t pos = _enqueuePos.load(std::memory_order_relaxed);
+        Cell *cell;
+        while (true)
+        {
+            cell = &_cells[pos & (N - 1)];
+            size_t sequence = cell->sequence.load(std::memory_order_acquire);
+            intptr_t diff = (intptr_t)sequence - (intptr_t)pos;
+            if (diff == 0)
+            {
+                if (_enqueuePos.compare_exchange_weak(pos, pos + 1, std::memory_order_relaxed))
+                {
+                    break;
+                }
+            }
+            else if (diff < 0)
+            {
+                return false; // Full
+            }
+            else
+            {
+                pos = _enqueuePos.load(std::memory_order_relaxed);
+            }
+        }
+        cell->data = item;
+        cell->sequence.store(pos + 1, std::memory_order_release);
+        return true;
+    }
+
+    /**
+     * @brief Removes the oldest item.
+     *
+     * @param item (Output) Removed item.
+     * @return true if an item was removed, false if the queue is empty.
+     */
+    bool pop(T &item)
+    {
+        size_t pos = _dequeuePos.load(std::memory_order_relaxed);
+        Cell *cell;
+        while (true)
+        {
+            cell = &_cells[pos & (N - 1)];
+            size_t sequence = cell->sequence.load(std::memory_order_acquire);
+            intptr_t diff = (intptr_t)sequence - (intptr_t)(pos + 1);
+            if (diff == 0)
+            {
+                if (_dequeuePos.compare_exchange_weak(pos, pos + 1, std::memory_order_relaxed))
+                {
+                    break;
+                }
+            }
+            else if (diff < 0)
+            {
+                return false; // Empty
+            }
+            else
+            {
+                pos = _dequeuePos.load(std::memory_order_relaxed);
+            }
+        }
+        item = cell->data;
+        cell->sequence.store(pos + N, std::memory_order_release);
+        return true;
+    }
+
+private:
+    struct Cell
+    {
+        std::atomic<size_t> sequence;
+        T data;
+    };
+
+    Cell _cells[N];
+    std::atomic<size_t> _enqueuePos;
+    std::atomic<size_t> _dequeuePos;
+};
@@ -0,0 +1,107 @@
+#include "analog.hpp"
+
+#define ANALOG_TAG "app_analog"
+
+struct AnalogInput
+{
+    uint8_t pin;
+    bool stream; // Full-rate stream or low-rate channel
+    analog_stream_cb_t stream_callback;
+    analog_channel_cb_t channel_callback;
+    void *arg;
+    uint32_t period_blocks;
+    uint32_t blocks_left;
+    uint16_t oversample;
+};
+
+static AnalogInput inputs[HAL_ADC_CONTINUOUS_MAX_PINS];
+static uint8_t input_count = 0;
+
+static bool add_input(const AnalogInput &input)
+{
+    if (input_count >= HAL_ADC_CONTINUOUS_MAX_PINS)
+    {
+        ESP_LOGE(ANALOG_TAG, "No analog slot left for GPIO %d", input.pin);
+        return false;
+    }
+    inputs[input_count++] = input;
+    return true;
+}
+
+bool analog_add_stream(uint8_t pin, analog_stream_cb_t callback, void *arg)
+{
+    AnalogInput input = {};
+    input.pin = pin;
+    input.stream = true;
+    input.stream_callback = callback;
+    input.arg = arg;
+    return add_input(input);
+}
+
+bool analog_add_channel(uint8_t pin, uint32_t period_ms, uint16_t oversample, analog_channel_cb_t callback, void *arg)
+{
+    const uint32_t block_ms = ANALOG_BLOCK_FRAMES * 1000 / ANALOG_SAMPLE_RATE;
+
+    AnalogInput input = {};
+    input.pin = pin;
+    input.stream = false;
+    input.channel_callback = callback;
+    input.arg = arg;
+    input.period_blocks = (period_ms + block_ms - 1) / block_ms;
+    if (input.period_blocks == 0)
+    {
+        input.period_blocks = 1;
+    }
+    input.blocks_left = input.period_blocks;
+    input.oversample = oversample == 0 ? 1 : (oversample > ANALOG_BLOCK_FRAMES ? ANALOG_BLOCK_FRAMES : oversample);
+    return add_input(input);
+}
+
+static void process_block(const uint16_t *samples, size_t frames, void *arg)
+{
+    for (int i = 0; i < input_count; i++)
+    {
+        AnalogInput &input = inputs[i];
+        if (input.stream)
+        {
+            input.stream_callback(samples + i, frames, input_count, input.arg);
+            continue;
+        }
+
+        if (--input.blocks_left > 0)
+        {
+            continue;
+        }
+        input.blocks_left = input.period_blocks;
+
+        // Average the most recent conversions of the block
+        uint32_t sum = 0;
+        for (size_t frame = frames - input.oversample; frame < frames; frame++)
+        {
+            sum += samples[frame * input_count + i];
+        }
+        input.channel_callback((sum << 4) / input.oversample, input.arg);
+    }
+}
+
+bool init_analog()
+{
+    if (input_count == 0)
+    {
+        return true;
+    }
+
+    uint8_t pins[HAL_ADC_CONTINUOUS_MAX_PINS];
+    for (int i = 0; i < input_count; i++)
+    {
+        pins[i] = inputs[i].pin;
+    }
+
+    if (!hal_adc_continuous_start(pins, input_count, ANALOG_SAMPLE_RATE, ANALOG_BLOCK_FRAMES, process_block, NULL))
+    {
+        ESP_LOGE(ANALOG_TAG, "Failed to start analog sampling");
+        return false;
+    }
+    ESP_LOGI(ANALOG_TAG, "Sampling %d analog inputs at %d Hz", input_count, ANALOG_SAMPLE_RATE);
+    return true;
+}
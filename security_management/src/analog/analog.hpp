@@ -0,0 +1,60 @@
+#pragma once
+
+#include "hal/hal.hpp"
+
+#define ANALOG_SAMPLE_RATE 2000 // Hz, per pin
+#define ANALOG_BLOCK_FRAMES 200 // 100 ms blocks, also the scheduling granularity
+
+/**
+ * @brief Receives every block of a full-rate stream.
+ *
+ * @param samples First sample of the pin in the block.
+ * @param count Number of samples.
+ * @param stride Distance between consecutive samples of the pin.
+ * @param arg Argument passed at registration.
+ */
+typedef void (*analog_stream_cb_t)(const uint16_t *samples, size_t count, size_t stride, void *arg);
+
+/**
+ * @brief Receives one oversampled reading of a low-rate channel.
+ *
+ * @param value_q4 Average of the oversampled conversions, in 1/16 ADC counts.
+ * @param arg Argument passed at registration.
+ */
+typedef void (*analog_channel_cb_t)(uint32_t value_q4, void *arg);
+
+/**
+ * @brief Registers a pin whose every sample is needed (e.g. the flame sensor).
+ *
+ * Must be called before init_analog().
+ *
+ * @param pin GPIO number (ADC1).
+ * @param callback Function receiving the blocks.
+ * @param arg Argument passed to the callback.
+ * @return true if the stream was registered, false if no slot is left.
+ */
+bool analog_add_stream(uint8_t pin, analog_stream_cb_t callback, void *arg);
+
+/**
+ * @brief Registers a slowly changing input read periodically (e.g. the smoke sensor).
+ *
+ * Must be called before init_analog().
+ *
+ * @param pin GPIO number (ADC1).
+ * @param period_ms Reading period, rounded up to whole blocks.
+ * @param oversample Number of consecutive conversions averaged per reading (at most ANALOG_BLOCK_FRAMES).
+ * @param callback Function receiving the readings.
+ * @param arg Argument passed to the callback.
+ * @return true if the channel was registered, false if no slot is left.
+ */
+bool analog_add_channel(uint8_t pin, uint32_t period_ms, uint16_t oversample, analog_channel_cb_t callback, void *arg);
+
+/**
+ * @brief Starts sampling all registered pins.
+ *
+ * All analog inputs share one continuous DMA conversion. Callbacks run in
+ * the HAL sampling task when a block completes; no task polls the inputs.
+ *
+ * @return true if initialization was successful, false otherwise.
+ */
+bool init_analog();
@@ -1,99 +1,337 @@
 #include "buzzer.hpp"
-#include "esp_log.h"
 
 #define BUZZER_PIN 15 // GPIO pin where the buzzer is connected
 #define BUZZER_TAG "app_buzzer"
 
-static bool alarm_active = false; // Zmienna, która przechowuje stan alarm
+#ifndef BUZZER_PASSIVE
+#define BUZZER_PASSIVE 0 // 1 for a passive piezo driven with LEDC tones, 0 for an active buzzer switched on and off
+#endif
+#define BUZZER_PWM_CHANNEL 0
 
-// Variables to manage beep sequences
-static int beep_duration_ms = 500;
-static int beep_count = 0;
-static unsigned long last_beep_time = 0;
-static bool is_beeping = false;
+#define BUZZER_QUEUE_LENGTH 4
+#define BUZZER_SWEEP_SLICE_MS 10 // Tone update interval during sweeps
+#define BUZZER_BEEP_GAP_MS 100   // Silence between beeps of a sequence
+#define BUZZER_BEEP_PRIORITY 1
 
-bool init_buzzer()
+static const BuzzerStep CHIRP_STEPS[] = {
+    {2700, 0, 60},
+};
+const BuzzerPattern BUZZER_PATTERN_CHIRP = {CHIRP_STEPS, 1, 1};
+
+static const BuzzerStep DOUBLE_CHIRP_STEPS[] = {
+    {2700, 0, 60},
+    {0, 0, 80},
+    {2700, 0, 60},
+    {0, 0, 1800},
+};
+const BuzzerPattern BUZZER_PATTERN_DOUBLE_CHIRP = {DOUBLE_CHIRP_STEPS, 4, 0};
+
+static const BuzzerStep SIREN_STEPS[] = {
+    {600, 1400, 500},
+    {1400, 600, 500},
+};
+const BuzzerPattern BUZZER_PATTERN_SIREN = {SIREN_STEPS, 2, 0};
+
+static const BuzzerStep TEMPORAL3_STEPS[] = {
+    {3100, 0, 500},
+    {0, 0, 500},
+    {3100, 0, 500},
+    {0, 0, 500},
+    {3100, 0, 500},
+    {0, 0, 1500},
+};
+const BuzzerPattern BUZZER_PATTERN_TEMPORAL3 = {TEMPORAL3_STEPS, 6, 0};
+
+// Beep sequences are built at runtime
+static BuzzerStep beep_steps[2];
+static BuzzerPattern beep_pattern = {beep_steps, 2, 1};
+
+struct Playback
 {
-    pinMode(BUZZER_PIN, OUTPUT);   // Configure the buzzer pin as an output
-    digitalWrite(BUZZER_PIN, LOW); // Ensure the buzzer is off initially
-    ESP_LOGI(BUZZER_TAG, "Buzzer initialized on GPIO %d", BUZZER_PIN);
-    return true;
+    const BuzzerPattern *pattern;
+    uint8_t priority;
+};
+
+static hal_mutex_t buzzer_mutex = NULL;
+static hal_timer_t step_timer = NULL;
+
+static Playback current = {NULL, 0};
+static Playback queued[BUZZER_QUEUE_LENGTH];
+static int queued_count = 0;
+
+static uint8_t step_index = 0;
+static uint8_t repeats_left = 0;
+static uint16_t step_elapsed_ms = 0; // Progress through a sweep
+static uint64_t step_deadline_us = 0;
+static uint32_t output_freq = 0;
+
+static void output(uint32_t freq_hz)
+{
+    if (freq_hz == output_freq)
+    {
+        return;
+    }
+    output_freq = freq_hz;
+#if BUZZER_PASSIVE
+    hal_pwm_tone(BUZZER_PWM_CHANNEL, freq_hz);
+#else
+    hal_gpio_write(BUZZER_PIN, freq_hz ? HAL_HIGH : HAL_LOW);
+#endif
 }
-    
-void handle_buzzer()
+
+/* Outputs the current step (or sweep slice) and arms the timer for the next transition */
+static void start_step()
 {
-    unsigned long current_time = millis();
+    const BuzzerStep &step = current.pattern->steps[step_index];
+    uint16_t slice_ms = step.duration_ms - step_elapsed_ms;
+    uint32_t freq_hz = step.freq_hz;
 
-    if (is_beeping && beep_count > 0)
+    if (step.freq_end_hz != 0 && step.freq_end_hz != step.freq_hz)
     {
-        if (current_time - last_beep_time >= beep_duration_ms)
+        int32_t span = (int32_t)step.freq_end_hz - (int32_t)step.freq_hz;
+        freq_hz = step.freq_hz + span * step_elapsed_ms / step.duration_ms;
+        if (slice_ms > BUZZER_SWEEP_SLICE_MS)
         {
-            digitalWrite(BUZZER_PIN, LOW); // Turn off the buzzer
-            last_beep_time = current_time;
-            beep_count--; // Decrease the number of remaining beeps
-            delay(100);   // Small delay between beeps
-            if (beep_count > 0)
-            {
-                digitalWrite(BUZZER_PIN, HIGH); // Turn on the buzzer for the next beep
-            }
-            else
-            {
-                is_beeping = false; // Stop beeping
-            }
+            slice_ms = BUZZER_SWEEP_SLICE_MS;
         }
     }
 
-    if (alarm_active)
+    output(freq_hz);
+    step_deadline_us = hal_micros() + (uint64_t)slice_ms * 1000;
+    hal_timer_start_once(step_timer, (uint64_t)slice_ms * 1000);
+    step_elapsed_ms += slice_ms;
+}
+
+static void start_pattern(const Playback &playback)
+{
+    current = playback;
+    step_index = 0;
+    step_elapsed_ms = 0;
+    repeats_left = playback.pattern->repeat;
+    start_step();
+}
+
+/* Removes and returns the highest priority queued pattern */
+static bool take_queued(Playback *playback)
+{
+    if (queued_count == 0)
     {
-        digitalWrite(BUZZER_PIN, HIGH); // If alarm is active, keep the buzzer on
+        return false;
     }
-    else
+    int best = 0;
+    for (int i = 1; i < queued_count; i++)
     {
-        digitalWrite(BUZZER_PIN, LOW); // Turn off the buzzer if alarm is not active
+        if (queued[i].priority > queued[best].priority)
+        {
+            best = i;
+        }
     }
+    *playback = queued[best];
+    for (int i = best; i < queued_count - 1; i++)
+    {
+        queued[i] = queued[i + 1];
+    }
+    queued_count--;
+    return true;
 }
 
-void set_alarm_active(bool active){
-    alarm_active = active;
+static void start_next()
+{
+    Playback next;
+    if (take_queued(&next))
+    {
+        start_pattern(next);
+    }
+    else
+    {
+        current.pattern = NULL;
+        hal_timer_stop(step_timer);
+        output(0);
+    }
 }
 
-void buzzer_short_beep(int duration_ms)
+static bool enqueue(const Playback &playback)
 {
-    digitalWrite(BUZZER_PIN, HIGH); // Turn the buzzer on
-    delay(duration_ms);             // Wait for the specified duration
-    digitalWrite(BUZZER_PIN, LOW);  // Turn the buzzer off
+    if (queued_count < BUZZER_QUEUE_LENGTH)
+    {
+        queued[queued_count++] = playback;
+        return true;
+    }
+
+    // Full: replace the lowest priority entry if the new one is more important
+    int lowest = 0;
+    for (int i = 1; i < queued_count; i++)
+    {
+        if (queued[i].priority < queued[lowest].priority)
+        {
+            lowest = i;
+        }
+    }
+    if (queued[lowest].priority >= playback.priority)
+    {
+        return false;
+    }
+    ESP_LOGW(BUZZER_TAG, "Queue full, dropping a pattern with priority %d", queued[lowest].priority);
+    queued[lowest] = playback;
+    return true;
 }
 
-void buzzer_long_beep(int duration_ms)
+static void step_timer_callback(void *arg)
 {
-    digitalWrite(BUZZER_PIN, HIGH); // Turn the buzzer on
-    delay(duration_ms);             // Wait for the specified duration
-    digitalWrite(BUZZER_PIN, LOW);  // Turn the buzzer off
+    hal_mutex_take(buzzer_mutex, HAL_WAIT_FOREVER);
+
+    // Ignore an expiry that raced with buzzer_play() or buzzer_stop()
+    if (current.pattern == NULL || hal_micros() < step_deadline_us)
+    {
+        hal_mutex_give(buzzer_mutex);
+        return;
+    }
+
+    if (step_elapsed_ms < current.pattern->steps[step_index].duration_ms)
+    {
+        start_step(); // Next slice of a sweep
+        hal_mutex_give(buzzer_mutex);
+        return;
+    }
+
+    step_elapsed_ms = 0;
+    step_index++;
+    if (step_index >= current.pattern->count)
+    {
+        step_index = 0;
+        if (repeats_left != 0 && --repeats_left == 0)
+        {
+            start_next();
+            hal_mutex_give(buzzer_mutex);
+            return;
+        }
+    }
+    start_step();
+
+    hal_mutex_give(buzzer_mutex);
 }
 
-void buzzer_beep_sequence(int duration_ms, int count)
+bool init_buzzer()
 {
-    beep_duration_ms = duration_ms;
-    beep_count = count;
-    is_beeping = true;
-    last_beep_time = millis();
-    digitalWrite(BUZZER_PIN, HIGH); // Start the first beep
+#if BUZZER_PASSIVE
+    if (!hal_pwm_attach(BUZZER_PWM_CHANNEL, BUZZER_PIN))
+    {
+        ESP_LOGE(BUZZER_TAG, "Failed to attach PWM channel %d", BUZZER_PWM_CHANNEL);
+        return false;
+    }
+#else
+    hal_gpio_mode(BUZZER_PIN, HAL_OUTPUT);   // Configure the buzzer pin as an output
+    hal_gpio_write(BUZZER_PIN, HAL_LOW); // Ensure the buzzer is off initially
+#endif
+    output_freq = 0;
+
+    buzzer_mutex = hal_mutex_create();
+    step_timer = hal_timer_create("buzzer", step_timer_callback, NULL);
+    if (buzzer_mutex == NULL || step_timer == NULL)
+    {
+        ESP_LOGE(BUZZER_TAG, "Failed to create buzzer timer");
+        return false;
+    }
+
+    ESP_LOGI(BUZZER_TAG, "Buzzer initialized on GPIO %d", BUZZER_PIN);
+    return true;
 }
 
-/*
-    CURRENTLY ONLY THIS FUNCTION IS USED TO ACTIVATE THE ALARM
-*/
-void set_buzzer_alarm(bool alarm_on)
+bool buzzer_play(const BuzzerPattern *pattern, uint8_t priority)
 {
-    alarm_active = alarm_on; // Set the alarm state based on MQTT message
-    if (alarm_on)
+    if (pattern == NULL || pattern->count == 0)
+    {
+        return false;
+    }
+
+    Playback playback = {pattern, priority};
+    bool result = true;
+
+    hal_mutex_take(buzzer_mutex, HAL_WAIT_FOREVER);
+    if (current.pattern == NULL)
     {
-        digitalWrite(BUZZER_PIN, HIGH); // Turn on the buzzer
-        ESP_LOGI(BUZZER_TAG, "Alarm activated");
+        start_pattern(playback);
+    }
+    else if (priority > current.priority)
+    {
+        enqueue(current); // Preempted, restarts once the new pattern ends
+        start_pattern(playback);
     }
     else
     {
-        digitalWrite(BUZZER_PIN, LOW); // Turn off the buzzer
-        ESP_LOGI(BUZZER_TAG, "Alarm deactivated");
+        result = enqueue(playback);
+    }
+    hal_mutex_give(buzzer_mutex);
+
+    return result;
+}
+
+void buzzer_stop(const BuzzerPattern *pattern)
+{
+    hal_mutex_take(buzzer_mutex, HAL_WAIT_FOREVER);
+
+    int kept = 0;
+    for (int i = 0; i < queued_count; i++)
+    {
+        if (queued[i].pattern != pattern)
+        {
+            queued[kept++] = queued[i];
+        }
     }
+    queued_count = kept;
+
+    if (current.pattern == pattern)
+    {
+        start_next();
+    }
+
+    hal_mutex_give(buzzer_mutex);
+}
+
+void buzzer_stop_all()
+{
+    hal_mutex_take(buzzer_mutex, HAL_WAIT_FOREVER);
+    queued_count = 0;
+    start_next();
+    hal_mutex_give(buzzer_mutex);
+}
+
+bool buzzer_is_playing()
+{
+    hal_mutex_take(buzzer_mutex, HAL_WAIT_FOREVER);
+    bool playing = current.pattern != NULL;
+    hal_mutex_give(buzzer_mutex);
+    return playing;
+}
+
+void buzzer_short_beep(int duration_ms)
+{
+    buzzer_beep_sequence(duration_ms, 1);
+}
+
+void buzzer_long_beep(int duration_ms)
+{
+    buzzer_beep_sequence(duration_ms, 1);
+}
+
+void buzzer_beep_sequence(int duration_ms, int count)
+{
+    if (duration_ms <= 0 || count <= 0)
+    {
+        return;
+    }
+
+    buzzer_stop(&beep_pattern); // The steps below are shared with a running sequence
+
+    hal_mutex_take(buzzer_mutex, HAL_WAIT_FOREVER);
+    beep_steps[0].freq_hz = 2700;
+    beep_steps[0].freq_end_hz = 0;
+    beep_steps[0].duration_ms = duration_ms > UINT16_MAX ? UINT16_MAX : duration_ms;
+    beep_steps[1].freq_hz = 0;
+    beep_steps[1].freq_end_hz = 0;
+    beep_steps[1].duration_ms = BUZZER_BEEP_GAP_MS;
+    beep_pattern.repeat = count > UINT8_MAX ? UINT8_MAX : count;
+    hal_mutex_give(buzzer_mutex);
+
+    buzzer_play(&beep_pattern, BUZZER_BEEP_PRIORITY);
 }
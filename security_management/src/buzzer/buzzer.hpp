@@ -1,21 +1,75 @@
 #pragma once
 
-#include <Arduino.h>
+#include "hal/hal.hpp"
+
+/**
+ * @brief One step of a buzzer pattern.
+ *
+ * A step with freq_end_hz different from 0 and freq_hz sweeps the tone
+ * linearly across its duration.
+ */
+struct BuzzerStep
+{
+    uint16_t freq_hz;     ///< Tone frequency, 0 for silence.
+    uint16_t freq_end_hz; ///< Final frequency of a sweep, 0 for a constant tone.
+    uint16_t duration_ms; ///< Step duration, at least 1 ms.
+};
+
+/**
+ * @brief Declarative buzzer pattern.
+ */
+struct BuzzerPattern
+{
+    const BuzzerStep *steps; ///< Steps played in order.
+    uint8_t count;           ///< Number of steps.
+    uint8_t repeat;          ///< Number of times the steps are played, 0 to repeat until stopped.
+};
+
+extern const BuzzerPattern BUZZER_PATTERN_CHIRP;        ///< Single short chirp.
+extern const BuzzerPattern BUZZER_PATTERN_DOUBLE_CHIRP; ///< Double chirp every 2 s, until stopped.
+extern const BuzzerPattern BUZZER_PATTERN_SIREN;        ///< Rising and falling sweep, until stopped.
+extern const BuzzerPattern BUZZER_PATTERN_TEMPORAL3;    ///< Three long beeps and a pause (fire alarm), until stopped.
 
 /**
  * @brief Initializes the buzzer.
  *
- * Configures the GPIO pin used for controlling the buzzer.
+ * Configures the GPIO pin (or PWM channel) and the timer driving patterns.
  * @return true if initialization was successful, false otherwise.
  */
 bool init_buzzer();
 
 /**
- * @brief Handles the buzzer.
+ * @brief Plays a pattern.
  *
- * This function should be called periodically to manage the buzzer's state.
+ * Patterns are driven by a timer, the output only changes at step
+ * transitions and no task is blocked. A pattern with a higher priority
+ * than the one playing preempts it (the preempted pattern is queued again
+ * and restarts later), otherwise it waits in the queue.
+ *
+ * @param pattern Pattern to play, must stay valid while queued.
+ * @param priority Pattern priority, higher values win.
+ * @return true if the pattern is playing or queued, false if the queue is full.
  */
-void handle_buzzer();
+bool buzzer_play(const BuzzerPattern *pattern, uint8_t priority);
+
+/**
+ * @brief Stops a pattern and removes it from the queue.
+ *
+ * @param pattern Pattern to stop.
+ */
+void buzzer_stop(const BuzzerPattern *pattern);
+
+/**
+ * @brief Stops the buzzer and empties the queue.
+ */
+void buzzer_stop_all();
+
+/**
+ * @brief Checks whether a pattern is playing.
+ *
+ * @return true if the buzzer is playing, false if it is idle.
+ */
+bool buzzer_is_playing();
 
 /**
  * @brief Plays a short beep with the buzzer.
@@ -39,26 +93,9 @@ void buzzer_long_beep(int duration_ms);
  * @brief Schedules a sequence of beeps.
  *
  * Generates a sequence of beeps, useful for specific events or alerts.
- * The sequence will be handled asynchronously in the FreeRTOS task.
+ * Replaces a sequence scheduled earlier.
  *
  * @param duration_ms The duration of each beep in milliseconds.
  * @param count The number of beeps to play in the sequence.
  */
 void buzzer_beep_sequence(int duration_ms, int count);
-
-/**
- * @brief Activates or deactivates the alarm via MQTT.
- *
- * This function is triggered by an MQTT message to activate or deactivate
- * the buzzer for an alarm.
- *
- * @param alarm_on Boolean to indicate if the alarm should be activated.
- */
-void set_buzzer_alarm(bool alarm_on);
-
-/**
- * @brief Sets alarm status 
- *
- * @param alarm_on Boolean to indicate if the alarm should be activated or deactivated.
- */
-void set_alarm_active(bool active);
\ No newline at end of file
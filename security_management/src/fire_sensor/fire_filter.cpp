@@ -0,0 +1,110 @@
+#include "fire_filter.hpp"
+
+#define FAST_SHIFT 1     // EMA alpha 1/2 at 100 Hz
+#define SLOW_SHIFT 4     // EMA alpha 1/16 at 100 Hz
+#define BASELINE_SHIFT 7 // Per block, about 13 s time constant
+
+#define CONFIDENCE_STEP_UP 10 // Flickering flame: full confidence in 1 s
+#define CONFIDENCE_STEP_STEADY 5
+#define CONFIDENCE_STEP_DOWN 10
+
+void fire_filter_init(FireFilter *filter)
+{
+    filter->acc = 0;
+    filter->acc_count = 0;
+    filter->primed = false;
+    filter->fast = 0;
+    filter->slow = 0;
+    filter->baseline = 0;
+    filter->band_sign = 0;
+    filter->crossings = 0;
+    filter->confidence = 0;
+}
+
+void fire_filter_process(FireFilter *filter, const uint16_t *samples, size_t count, size_t stride, FireFilterOutput *output)
+{
+    uint32_t energy_sum = 0;
+    uint32_t energy_count = 0;
+    uint8_t crossings = 0;
+
+    for (size_t i = 0; i < count; i++)
+    {
+        filter->acc += samples[i * stride];
+        if (++filter->acc_count < FIRE_FILTER_DECIMATION)
+        {
+            continue;
+        }
+
+        int32_t x = (int32_t)((filter->acc << 4) / FIRE_FILTER_DECIMATION); // Q4
+        filter->acc = 0;
+        filter->acc_count = 0;
+
+        if (!filter->primed)
+        {
+            filter->fast = x;
+            filter->slow = x;
+            filter->baseline = x;
+            filter->primed = true;
+        }
+
+        filter->fast += (x - filter->fast) >> FAST_SHIFT;
+        filter->slow += (x - filter->slow) >> SLOW_SHIFT;
+
+        int32_t band = (filter->fast - filter->slow) >> 2; // Q2, squares fit in 32 bits
+        energy_sum += (uint32_t)(band * band) >> 4;        // Q0
+        energy_count++;
+
+        int8_t sign = band >= FIRE_FLICKER_SWING_MIN * 4 ? 1 : (band <= -FIRE_FLICKER_SWING_MIN * 4 ? -1 : 0);
+        if (sign != 0 && sign != filter->band_sign)
+        {
+            if (filter->band_sign != 0 && crossings < UINT8_MAX)
+            {
+                crossings++;
+            }
+            filter->band_sign = sign;
+        }
+    }
+
+    int32_t intensity = (filter->baseline - filter->slow) >> 4;
+    if (intensity < 0)
+    {
+        intensity = 0;
+    }
+    uint32_t band_energy = energy_count > 0 ? energy_sum / energy_count : 0;
+
+    if (energy_count > 0)
+    {
+        uint16_t decayed = (filter->crossings >> 1) + crossings;
+        filter->crossings = decayed > UINT8_MAX ? UINT8_MAX : decayed;
+
+        bool bright = intensity >= FIRE_INTENSITY_MIN;
+        bool flicker = band_energy >= FIRE_FLICKER_ENERGY_MIN && filter->crossings >= FIRE_FLICKER_CROSSINGS_MIN;
+        int confidence = filter->confidence;
+
+        if (bright && flicker)
+        {
+            confidence += CONFIDENCE_STEP_UP;
+        }
+        else if (bright)
+        {
+            confidence -= CONFIDENCE_STEP_STEADY;
+        }
+        else
+        {
+            confidence -= CONFIDENCE_STEP_DOWN;
+        }
+        filter->confidence = confidence < 0 ? 0 : (confidence > 100 ? 100 : confidence);
+
+        // Follow the ambient level only while nothing is burning
+        if (filter->confidence == 0 && !bright)
+        {
+            filter->baseline += (filter->slow - filter->baseline) >> BASELINE_SHIFT;
+        }
+    }
+
+    output->level = filter->slow >> 4;
+    output->intensity = intensity;
+    output->band_energy = band_energy;
+    output->crossings = filter->crossings;
+    output->confidence = filter->confidence;
+}
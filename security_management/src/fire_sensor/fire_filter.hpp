@@ -0,0 +1,67 @@
+#pragma once
+
+/*
+ * Fixed-point signal processing of the flame sensor.
+ *
+ * Independent of the HAL so the kernels can be run on the host against
+ * recorded sample files.
+ */
+
+#include <stddef.h>
+#include <stdint.h>
+
+#define FIRE_FILTER_DECIMATION 20 // Moving average length, 2 kHz -> 100 Hz
+
+/* Evidence thresholds, in raw ADC counts */
+#define FIRE_INTENSITY_MIN 200   // Drop below the ambient baseline caused by a flame
+#define FIRE_FLICKER_ENERGY_MIN 25 // Mean square of the 1 - 11 Hz band (RMS of 5 counts)
+#define FIRE_FLICKER_SWING_MIN 3   // Band excursion counted as a zero crossing
+#define FIRE_FLICKER_CROSSINGS_MIN 2 // Decaying crossing count, about 3 Hz and up
+
+/// State of the filter pipeline, all values in Q4 unless noted.
+struct FireFilter
+{
+    uint32_t acc;         ///< Moving average accumulator (raw counts).
+    uint16_t acc_count;   ///< Samples in the accumulator.
+    bool primed;          ///< Filters hold a valid state.
+    int32_t fast;         ///< Low-pass at about 11 Hz.
+    int32_t slow;         ///< Low-pass at about 1 Hz, the flame level.
+    int32_t baseline;     ///< Ambient level without a flame.
+    int8_t band_sign;     ///< Sign of the last significant band excursion.
+    uint8_t crossings;    ///< Zero crossings of the band, halved every block.
+    uint8_t confidence;   ///< Fire confidence in percent.
+};
+
+/// Result of one processed block.
+struct FireFilterOutput
+{
+    uint16_t level;       ///< Filtered sensor level (raw counts).
+    uint16_t intensity;   ///< Drop of the level below the ambient baseline (raw counts).
+    uint32_t band_energy; ///< Mean square of the flicker band over the block (raw counts squared).
+    uint8_t crossings;    ///< Decaying zero crossing count of the flicker band.
+    uint8_t confidence;   ///< Fire confidence in percent.
+};
+
+/**
+ * @brief Resets the filter state.
+ *
+ * @param filter Filter to reset.
+ */
+void fire_filter_init(FireFilter *filter);
+
+/**
+ * @brief Runs the filter pipeline over a block of samples.
+ *
+ * The samples are averaged down by FIRE_FILTER_DECIMATION, split into a
+ * level and a flicker band, and the confidence is updated once per block.
+ * A flame raises the confidence only if it both lowers the level and
+ * flickers, i.e. the band has energy and keeps crossing zero. Steady
+ * infrared sources (sunlight, heaters) and their switch-on transients do not.
+ *
+ * @param filter Filter state.
+ * @param samples Raw samples.
+ * @param count Number of samples to process.
+ * @param stride Distance between consecutive samples (pins in an interleaved block).
+ * @param output (Output) Result of the block.
+ */
+void fire_filter_process(FireFilter *filter, const uint16_t *samples, size_t count, size_t stride, FireFilterOutput *output);
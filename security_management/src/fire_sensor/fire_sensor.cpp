@@ -1,34 +1,58 @@
 #include "fire_sensor.hpp"
-#include "esp_log.h"
-#include "./buzzer/buzzer.hpp" // Include the buzzer module
+#include "fire_filter.hpp"
+#include "../alarm/alarm.hpp"
+#include "../analog/analog.hpp"
 
-#define SENSOR_PIN 4 // GPIO pin where the fire sensor is connected
+#define SENSOR_PIN 34 // GPIO pin (ADC1) where the analog output of the fire sensor is connected
 #define SENSOR_TAG "fire_sensor"
- 
-static bool sensor_active = false; // variable for sensor state (not sure if needed) 
 
-bool init_fire_sensor()
-{
-    pinMode(SENSOR_PIN, INPUT);   // Configure the buzzer pin as an input
-    ESP_LOGI(SENSOR_TAG, "Fire sensor initialized on GPIO %d", SENSOR_PIN);
+static FireFilter filter;
+static FireSensorStats stats = {};
+static bool sensor_active = false; // Last reported sensor state
 
-    return true;
-}
-    
-void handle_fire_sensor()
+static void process_block(const uint16_t *samples, size_t frames, size_t stride, void *arg)
 {
-    if (digitalRead(SENSOR_PIN) == LOW) // Check if the sensor senses fire
+    uint64_t start_us = hal_micros();
+    FireFilterOutput output;
+    fire_filter_process(&filter, samples, frames, stride, &output);
+    uint32_t elapsed_us = (uint32_t)(hal_micros() - start_us);
+
+    stats.blocks++;
+    stats.last_block_us = elapsed_us;
+    if (elapsed_us > stats.max_block_us)
     {
-        set_buzzer_alarm(true); // activate the alarm
-        ESP_LOGI(SENSOR_TAG, "Fire detected!"); // Print a message to the serial monitor (i want it to be printed only once)
+        stats.max_block_us = elapsed_us;
+    }
+    stats.confidence = output.confidence;
 
+    if (!sensor_active && output.confidence >= FIRE_RAISE_CONFIDENCE)
+    {
+        sensor_active = true;
+        alarm_raise(ALARM_SOURCE_FIRE);
+        ESP_LOGI(SENSOR_TAG, "Fire detected! (confidence %d%%, intensity %d, flicker %lu)", output.confidence, output.intensity, (unsigned long)output.band_energy);
     }
-    else
+    else if (sensor_active && output.confidence <= FIRE_CLEAR_CONFIDENCE)
     {
-        set_buzzer_alarm(false); //deactivate the alarm
-
-        ESP_LOGI(SENSOR_TAG, "Fire is not detected, yay!"); // Print a message to the serial monitor (i want it to be printed only once)
+        sensor_active = false;
+        alarm_clear(ALARM_SOURCE_FIRE);
+        ESP_LOGI(SENSOR_TAG, "Fire is not detected, yay!");
     }
 }
 
+bool init_fire_sensor()
+{
+    fire_filter_init(&filter);
+
+    if (!analog_add_stream(SENSOR_PIN, process_block, NULL))
+    {
+        return false;
+    }
+    ESP_LOGI(SENSOR_TAG, "Fire sensor initialized on GPIO %d", SENSOR_PIN);
+
+    return true;
+}
 
+void fire_sensor_get_stats(FireSensorStats *out)
+{
+    *out = stats;
+}
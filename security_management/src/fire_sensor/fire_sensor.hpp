@@ -1,18 +1,33 @@
 #pragma once 
 
-#include <Arduino.h>
+#include "hal/hal.hpp"
+
+#define FIRE_RAISE_CONFIDENCE 60 // Filter confidence raising the fire alarm
+#define FIRE_CLEAR_CONFIDENCE 20 // Filter confidence clearing it again
+
+/// Processing statistics of the fire sensor.
+struct FireSensorStats
+{
+    uint32_t blocks;        ///< Blocks processed.
+    uint32_t last_block_us; ///< Filter time of the last block.
+    uint32_t max_block_us;  ///< Worst filter time of a block.
+    uint8_t confidence;     ///< Current fire confidence in percent.
+};
 
 /**
  * @brief Initializes the sensor.
  *
- * Configures the GPIO pin used for controlling the buzzer.
+ * Registers the analog output of the flame sensor as a full-rate stream
+ * of the analog scheduler. Every block is filtered as soon as it is complete and raises or clears
+ * the fire alarm, no periodic handler is needed.
+ *
  * @return true if initialization was successful, false otherwise.
  */
 bool init_fire_sensor();
 
 /**
- * @brief Handles the sensor. - specyfy what does the system do when the sensor detects a fire
+ * @brief Copies the processing statistics.
  *
- * This function should be called periodically to manage the buzzer's state.
+ * @param stats (Output) Current statistics.
  */
-void handle_fire_sensor();
\ No newline at end of file
+void fire_sensor_get_stats(FireSensorStats *stats);
@@ -0,0 +1,67 @@
+#include "intrusion.hpp"
+#include "../alarm/alarm.hpp"
+#include "../journal/journal.hpp"
+#include "../power/power.hpp"
+
+#define INTRUSION_TAG "app_intrusion"
+
+static IntrusionEngine engine;
+static hal_mutex_t engine_mutex = NULL;
+
+bool init_intrusion()
+{
+    intrusion_engine_init(&engine);
+    engine_mutex = hal_mutex_create();
+    if (engine_mutex == NULL)
+    {
+        ESP_LOGE(INTRUSION_TAG, "Failed to create mutex");
+        return false;
+    }
+    ESP_LOGI(INTRUSION_TAG, "Intrusion detector initialized");
+    return true;
+}
+
+void intrusion_report(IntrusionEventType type, uint8_t zone)
+{
+    IntrusionEvent event;
+    event.type = type;
+    event.zone = zone;
+
+    IntrusionIncident incident;
+    hal_mutex_take(engine_mutex, HAL_WAIT_FOREVER);
+    event.time_ms = hal_millis(); // Taken under the lock so events stay in time order
+    bool raised = intrusion_engine_push(&engine, event, &incident);
+    hal_mutex_give(engine_mutex);
+
+    if (!raised)
+    {
+        return;
+    }
+    if (!power_is_armed()) // Someone at home walking through the rooms
+    {
+        ESP_LOGD(INTRUSION_TAG, "Incident while disarmed, score %d, no alarm", incident.score);
+        return;
+    }
+
+    // Intrusion latches in the alarm manager until acknowledged
+    alarm_raise(ALARM_SOURCE_INTRUSION);
+    alarm_clear(ALARM_SOURCE_INTRUSION);
+    journal_record(JOURNAL_EVENT_INCIDENT, incident.score / 16);
+
+    ESP_LOGI(INTRUSION_TAG, "Intrusion incident, score %d", incident.score);
+    for (uint8_t i = 0; i < 8; i++)
+    {
+        if (incident.rules & (1 << i))
+        {
+            ESP_LOGI(INTRUSION_TAG, "  rule: %s", intrusion_rule_name(i));
+        }
+    }
+}
+
+void intrusion_get_stats(uint32_t *events, uint32_t *incidents)
+{
+    hal_mutex_take(engine_mutex, HAL_WAIT_FOREVER);
+    *events = engine.events_total;
+    *incidents = engine.incidents_total;
+    hal_mutex_give(engine_mutex);
+}
@@ -0,0 +1,31 @@
+#pragma once
+
+#include "hal/hal.hpp"
+#include "intrusion_engine.hpp"
+
+/**
+ * @brief Initializes the intrusion detector.
+ *
+ * @return true if initialization was successful, false otherwise.
+ */
+bool init_intrusion();
+
+/**
+ * @brief Reports a security event from a sensor.
+ *
+ * The event is correlated with recent events from the other sensors; an
+ * incident scoring INTRUSION_SCORE_ALARM or more raises the intrusion alarm
+ * while the node is armed (see power_is_armed()).
+ *
+ * @param type Kind of event.
+ * @param zone Index of the sensor within its kind.
+ */
+void intrusion_report(IntrusionEventType type, uint8_t zone);
+
+/**
+ * @brief Returns the number of events and incidents processed.
+ *
+ * @param events (Output) Events reported since boot.
+ * @param incidents (Output) Incidents raised since boot.
+ */
+void intrusion_get_stats(uint32_t *events, uint32_t *incidents);
@@ -0,0 +1,120 @@
+#include <stddef.h>
+#include "intrusion_engine.hpp"
+
+/// Raises the score of an event of type `then` that follows an event of type `first`.
+struct IntrusionRule
+{
+    const char *name;
+    uint8_t first;
+    uint8_t then;
+    uint32_t window_ms;
+    uint8_t score;
+};
+
+static const IntrusionRule RULES[] = {
+    {"open then motion", INTRUSION_EVENT_OPEN, INTRUSION_EVENT_MOTION, 10000, 40},
+    {"repeated motion", INTRUSION_EVENT_MOTION, INTRUSION_EVENT_MOTION, 30000, 30},
+    {"tilt and open", INTRUSION_EVENT_TILT, INTRUSION_EVENT_OPEN, 5000, 50},
+    {"open and tilt", INTRUSION_EVENT_OPEN, INTRUSION_EVENT_TILT, 5000, 50},
+};
+#define RULE_COUNT (sizeof(RULES) / sizeof(RULES[0]))
+
+/* Score of an event on its own */
+static const uint8_t BASE_SCORES[INTRUSION_EVENT_TYPE_COUNT] = {
+    40, // Motion
+    20, // Open
+    30, // Tilt
+};
+
+static void expire(IntrusionEngine *engine, uint32_t now_ms)
+{
+    while (engine->count > 0)
+    {
+        const IntrusionEvent &oldest = engine->events[engine->head];
+        if (now_ms - oldest.time_ms <= INTRUSION_WINDOW_MS)
+        {
+            return;
+        }
+        engine->type_count[oldest.type]--;
+        engine->head = (engine->head + 1) % INTRUSION_BUFFER_SIZE;
+        engine->count--;
+    }
+}
+
+static void store(IntrusionEngine *engine, const IntrusionEvent &event)
+{
+    if (engine->count == INTRUSION_BUFFER_SIZE) // Full, drop the oldest
+    {
+        engine->type_count[engine->events[engine->head].type]--;
+        engine->head = (engine->head + 1) % INTRUSION_BUFFER_SIZE;
+        engine->count--;
+    }
+    engine->events[(engine->head + engine->count) % INTRUSION_BUFFER_SIZE] = event;
+    engine->count++;
+    engine->type_count[event.type]++;
+    engine->last_time[event.type] = event.time_ms;
+}
+
+void intrusion_engine_init(IntrusionEngine *engine)
+{
+    engine->head = 0;
+    engine->count = 0;
+    for (int i = 0; i < INTRUSION_EVENT_TYPE_COUNT; i++)
+    {
+        engine->type_count[i] = 0;
+        engine->last_time[i] = 0;
+    }
+    engine->incident_seen = false;
+    engine->last_incident_ms = 0;
+    engine->events_total = 0;
+    engine->incidents_total = 0;
+}
+
+bool intrusion_engine_push(IntrusionEngine *engine, const IntrusionEvent &event, IntrusionIncident *incident)
+{
+    if (event.type >= INTRUSION_EVENT_TYPE_COUNT)
+    {
+        return false;
+    }
+    engine->events_total++;
+    expire(engine, event.time_ms);
+
+    uint16_t score = BASE_SCORES[event.type];
+    uint8_t rules = 0;
+    for (size_t i = 0; i < RULE_COUNT; i++)
+    {
+        const IntrusionRule &rule = RULES[i];
+        if (rule.then == event.type && engine->type_count[rule.first] > 0 &&
+            event.time_ms - engine->last_time[rule.first] <= rule.window_ms)
+        {
+            score += rule.score;
+            rules |= 1 << i;
+        }
+    }
+
+    store(engine, event);
+
+    if (score < INTRUSION_SCORE_ALARM)
+    {
+        return false;
+    }
+    if (engine->incident_seen && event.time_ms - engine->last_incident_ms < INTRUSION_HOLDOFF_MS)
+    {
+        return false;
+    }
+
+    engine->incident_seen = true;
+    engine->last_incident_ms = event.time_ms;
+    engine->incidents_total++;
+
+    incident->time_ms = event.time_ms;
+    incident->score = score > UINT8_MAX ? UINT8_MAX : score;
+    incident->rules = rules;
+    incident->trigger = event;
+    return true;
+}
+
+const char *intrusion_rule_name(uint8_t rule)
+{
+    return rule < RULE_COUNT ? RULES[rule].name : NULL;
+}
@@ -0,0 +1,83 @@
+#pragma once
+
+/*
+ * Correlation of security events into scored intrusion incidents.
+ *
+ * Independent of the HAL: timestamps are passed in, so recorded event
+ * traces can be replayed on the host.
+ */
+
+#include <stdint.h>
+
+#define INTRUSION_BUFFER_SIZE 32  // Events remembered, oldest are dropped first
+#define INTRUSION_WINDOW_MS 30000 // Longest correlation window
+#define INTRUSION_SCORE_ALARM 60  // Score that makes an incident
+#define INTRUSION_HOLDOFF_MS 10000 // Minimum time between incidents
+
+/// Kinds of events fed to the engine.
+enum IntrusionEventType : uint8_t
+{
+    INTRUSION_EVENT_MOTION, ///< PIR sensor detected motion.
+    INTRUSION_EVENT_OPEN,   ///< Window or door opened (reed relay).
+    INTRUSION_EVENT_TILT,   ///< Tilt sensor moved.
+    INTRUSION_EVENT_TYPE_COUNT,
+};
+
+/// Timestamped event.
+struct IntrusionEvent
+{
+    uint32_t time_ms; ///< Event time.
+    uint8_t type;     ///< IntrusionEventType.
+    uint8_t zone;     ///< Index of the sensor within its kind.
+};
+
+/// Scored incident produced by the engine.
+struct IntrusionIncident
+{
+    uint32_t time_ms; ///< Time of the triggering event.
+    uint8_t score;    ///< Base score of the event plus matched rules.
+    uint8_t rules;    ///< Bit mask of matched rules (see intrusion_rule_name()).
+    IntrusionEvent trigger;
+};
+
+/// Engine state, events kept in a circular buffer.
+struct IntrusionEngine
+{
+    IntrusionEvent events[INTRUSION_BUFFER_SIZE];
+    uint8_t head;  ///< Index of the oldest event.
+    uint8_t count; ///< Events within the window.
+    uint8_t type_count[INTRUSION_EVENT_TYPE_COUNT]; ///< Events of each type within the window.
+    uint32_t last_time[INTRUSION_EVENT_TYPE_COUNT]; ///< Time of the newest event of each type.
+    bool incident_seen;
+    uint32_t last_incident_ms;
+    uint32_t events_total;
+    uint32_t incidents_total;
+};
+
+/**
+ * @brief Resets the engine.
+ *
+ * @param engine Engine to reset.
+ */
+void intrusion_engine_init(IntrusionEngine *engine);
+
+/**
+ * @brief Feeds one event, in time order.
+ *
+ * Expires events that left the window, scores the event against the
+ * rules and stores it. Runs in constant time.
+ *
+ * @param engine Engine state.
+ * @param event Event to process.
+ * @param incident (Output) Incident raised by the event.
+ * @return true if the event raised an incident, false otherwise.
+ */
+bool intrusion_engine_push(IntrusionEngine *engine, const IntrusionEvent &event, IntrusionIncident *incident);
+
+/**
+ * @brief Returns the name of a rule.
+ *
+ * @param rule Bit index in IntrusionIncident::rules.
+ * @return Rule name, NULL for an unknown rule.
+ */
+const char *intrusion_rule_name(uint8_t rule);
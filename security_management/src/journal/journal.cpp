@@ -0,0 +1,96 @@
+#include <stdio.h>
+#include "journal.hpp"
+#include "../uplink/uplink.hpp"
+
+#define JOURNAL_TAG "app_journal"
+
+#define JOURNAL_PUBLISH_BATCH 5     // Entries per message, the payload stays within the default MQTT packet size
+#define JOURNAL_ENTRY_MAX_LENGTH 36 // Longest formatted entry
+
+static HAL_NOINIT JournalRing ring; // Not cleared by resets, validated by journal_ring_open()
+static hal_mutex_t ring_mutex = NULL;
+
+bool init_journal()
+{
+    ring_mutex = hal_mutex_create();
+    if (ring_mutex == NULL)
+    {
+        ESP_LOGE(JOURNAL_TAG, "Failed to create mutex");
+        return false;
+    }
+
+    if (journal_ring_open(&ring))
+    {
+        ESP_LOGI(JOURNAL_TAG, "Journal recovered %u records, %u unsent, %u lost unsent",
+                 ring.state.count, ring.state.unsent, ring.state.dropped);
+    }
+    else
+    {
+        ESP_LOGI(JOURNAL_TAG, "Journal formatted, %u bytes", (unsigned)sizeof(ring));
+    }
+
+    HalResetReason reason = hal_reset_reason();
+    journal_ring_boot(&ring, reason);
+    ESP_LOGI(JOURNAL_TAG, "Boot %u, reset reason %d", ring.state.boot, reason);
+    return true;
+}
+
+void journal_record(JournalEventType type, uint8_t arg)
+{
+    hal_mutex_take(ring_mutex, HAL_WAIT_FOREVER);
+    journal_ring_append(&ring, hal_millis(), type, arg); // Time taken under the lock so deltas never go back
+    hal_mutex_give(ring_mutex);
+}
+
+void handle_journal()
+{
+    if (!uplink_is_connected())
+    {
+        return;
+    }
+
+    JournalEntry entries[JOURNAL_PUBLISH_BATCH];
+    uint16_t consumed;
+    size_t count;
+    uint16_t dropped;
+
+    hal_mutex_take(ring_mutex, HAL_WAIT_FOREVER);
+    count = journal_ring_read(&ring, ring.state.count - ring.state.unsent, entries, JOURNAL_PUBLISH_BATCH, &consumed);
+    dropped = ring.state.dropped;
+    hal_mutex_give(ring_mutex);
+
+    if (count == 0)
+    {
+        return;
+    }
+
+    // "boot,time_ms,event,arg;" per entry
+    char payload[JOURNAL_PUBLISH_BATCH * JOURNAL_ENTRY_MAX_LENGTH + 1];
+    size_t length = 0;
+    for (size_t i = 0; i < count; i++)
+    {
+        length += snprintf(payload + length, sizeof(payload) - length, "%u,%lu,%s,%u;",
+                           entries[i].boot, (unsigned long)entries[i].time_ms,
+                           journal_event_name(entries[i].type), entries[i].arg);
+    }
+
+    if (!uplink_publish(TOPIC_JOURNAL, payload))
+    {
+        return;
+    }
+
+    hal_mutex_take(ring_mutex, HAL_WAIT_FOREVER);
+    if (ring.state.dropped == dropped) // Otherwise unsent records were overwritten meanwhile, resend rather than skip
+    {
+        journal_ring_mark_sent(&ring, consumed);
+    }
+    hal_mutex_give(ring_mutex);
+}
+
+void journal_get_stats(uint16_t *stored, uint16_t *unsent)
+{
+    hal_mutex_take(ring_mutex, HAL_WAIT_FOREVER);
+    *stored = ring.state.count;
+    *unsent = ring.state.unsent;
+    hal_mutex_give(ring_mutex);
+}
@@ -0,0 +1,38 @@
+#pragma once
+
+#include "hal/hal.hpp"
+#include "journal_ring.hpp"
+
+/**
+ * @brief Recovers the journal kept across resets and records the boot.
+ *
+ * Called before the other modules so their events are journaled.
+ *
+ * @return true if initialization was successful, false otherwise.
+ */
+bool init_journal();
+
+/**
+ * @brief Records a security event.
+ *
+ * Safe to call from any task, takes a few microseconds.
+ *
+ * @param type Kind of event.
+ * @param arg Event argument, 0 to 15.
+ */
+void journal_record(JournalEventType type, uint8_t arg);
+
+/**
+ * @brief Publishes unsent records while the uplink is connected, called periodically.
+ *
+ * Records from before a reset are published first, oldest to newest.
+ */
+void handle_journal();
+
+/**
+ * @brief Returns the number of stored and unpublished records.
+ *
+ * @param stored (Output) Records in the journal.
+ * @param unsent (Output) Records not published yet.
+ */
+void journal_get_stats(uint16_t *stored, uint16_t *unsent);
@@ -0,0 +1,230 @@
+#include <string.h>
+#include "journal_ring.hpp"
+
+static const char *const EVENT_NAMES[JOURNAL_EVENT_TYPE_COUNT] = {
+    "time",
+    "boot",
+    "armed",
+    "disarmed",
+    "alarm_on",
+    "alarm_off",
+    "alarm_ack",
+    "motion_start",
+    "motion_end",
+    "open",
+    "close",
+    "tilt_on",
+    "tilt_off",
+    "incident",
+};
+
+static_assert(sizeof(JournalRecord) == 4, "journal records must stay packed");
+static_assert(JOURNAL_EVENT_TYPE_COUNT <= 16, "event type must fit in 4 bits");
+
+/* CRC-32 (IEEE), bitwise: the header is only a few bytes */
+static uint32_t crc32(const uint8_t *data, size_t length)
+{
+    uint32_t crc = 0xFFFFFFFFU;
+    for (size_t i = 0; i < length; i++)
+    {
+        crc ^= data[i];
+        for (int bit = 0; bit < 8; bit++)
+        {
+            crc = (crc >> 1) ^ (0xEDB88320U & (0U - (crc & 1)));
+        }
+    }
+    return ~crc;
+}
+
+static uint32_t header_crc(const JournalHeader &header)
+{
+    return crc32((const uint8_t *)&header, offsetof(JournalHeader, crc));
+}
+
+static bool header_valid(const JournalHeader &header)
+{
+    return header.magic == JOURNAL_MAGIC &&
+           header.crc == header_crc(header) &&
+           header.head < JOURNAL_CAPACITY &&
+           header.count <= JOURNAL_CAPACITY &&
+           header.unsent <= header.count;
+}
+
+/* Writes the working state into the older copy, the newer one stays valid until this completes */
+static void commit(JournalRing *ring)
+{
+    ring->state.sequence++;
+    ring->state.crc = header_crc(ring->state);
+    ring->copies[ring->state.sequence & 1] = ring->state;
+}
+
+/* Moves a decoding position over one record */
+static void apply(uint16_t *boot, uint32_t *time_ms, const JournalRecord &record)
+{
+    if (record.type == JOURNAL_EVENT_BOOT)
+    {
+        (*boot)++;
+        *time_ms = 0;
+    }
+    else if (record.type == JOURNAL_EVENT_TIME)
+    {
+        *time_ms += record.delta * 1000U;
+    }
+    else
+    {
+        *time_ms += record.delta;
+    }
+}
+
+static uint16_t tail_index(const JournalHeader &header)
+{
+    return (header.head + JOURNAL_CAPACITY - header.count) % JOURNAL_CAPACITY;
+}
+
+static void push(JournalRing *ring, JournalRecord record, uint32_t time_ms)
+{
+    JournalHeader &state = ring->state;
+
+    if (state.count == JOURNAL_CAPACITY) // Drop the oldest record
+    {
+        uint16_t next = (tail_index(state) + 1) % JOURNAL_CAPACITY;
+        apply(&state.tail_boot, &state.tail_ms, ring->records[next]);
+        state.count--;
+        if (state.unsent > state.count)
+        {
+            state.unsent = state.count;
+            if (state.dropped < UINT16_MAX)
+            {
+                state.dropped++;
+            }
+        }
+    }
+
+    if (state.count == 0)
+    {
+        state.tail_boot = state.boot;
+        state.tail_ms = time_ms;
+    }
+
+    ring->records[state.head] = record;
+    state.head = (state.head + 1) % JOURNAL_CAPACITY;
+    state.count++;
+    state.unsent++;
+}
+
+bool journal_ring_open(JournalRing *ring)
+{
+    bool valid0 = header_valid(ring->copies[0]);
+    bool valid1 = header_valid(ring->copies[1]);
+
+    if (valid0 || valid1)
+    {
+        // Sequence numbers are compared by difference so wrapping is harmless
+        bool use1 = valid1 && (!valid0 || (int32_t)(ring->copies[1].sequence - ring->copies[0].sequence) > 0);
+        ring->state = ring->copies[use1 ? 1 : 0];
+
+        bool records_valid = true;
+        for (uint16_t i = 0; i < ring->state.count; i++)
+        {
+            if (ring->records[(tail_index(ring->state) + i) % JOURNAL_CAPACITY].type >= JOURNAL_EVENT_TYPE_COUNT)
+            {
+                records_valid = false;
+                break;
+            }
+        }
+        if (records_valid)
+        {
+            return ring->state.count > 0;
+        }
+    }
+
+    memset(&ring->state, 0, sizeof(ring->state));
+    ring->state.magic = JOURNAL_MAGIC;
+    commit(ring);
+    commit(ring); // Both copies valid
+    return false;
+}
+
+void journal_ring_append(JournalRing *ring, uint32_t now_ms, JournalEventType type, uint8_t arg)
+{
+    JournalHeader &state = ring->state;
+    uint32_t delta = now_ms >= state.last_ms ? now_ms - state.last_ms : 0;
+
+    if (delta > JOURNAL_DELTA_MAX)
+    {
+        uint32_t seconds = delta / 1000;
+        JournalRecord skip;
+        skip.delta = seconds;
+        skip.type = JOURNAL_EVENT_TIME;
+        skip.arg = 0;
+        push(ring, skip, state.last_ms + seconds * 1000);
+        delta -= seconds * 1000;
+    }
+
+    JournalRecord record;
+    record.delta = delta;
+    record.type = type;
+    record.arg = arg & 0x0F;
+    push(ring, record, now_ms);
+    state.last_ms = now_ms;
+    commit(ring);
+}
+
+void journal_ring_boot(JournalRing *ring, uint8_t reason)
+{
+    JournalRecord record;
+    record.delta = 0;
+    record.type = JOURNAL_EVENT_BOOT;
+    record.arg = reason & 0x0F;
+
+    ring->state.boot++;
+    push(ring, record, 0);
+    ring->state.last_ms = 0;
+    commit(ring);
+}
+
+size_t journal_ring_read(const JournalRing *ring, uint16_t first, JournalEntry *entries, size_t max,
+                         uint16_t *consumed)
+{
+    const JournalHeader &state = ring->state;
+    uint16_t tail = tail_index(state);
+    uint16_t boot = state.tail_boot;
+    uint32_t time_ms = state.tail_ms;
+    size_t count = 0;
+
+    *consumed = 0;
+    for (uint16_t i = 0; i < state.count; i++)
+    {
+        const JournalRecord &record = ring->records[(tail + i) % JOURNAL_CAPACITY];
+        if (i > 0) // The tail state already includes the oldest record
+        {
+            apply(&boot, &time_ms, record);
+        }
+        if (i < first || record.type == JOURNAL_EVENT_TIME)
+        {
+            continue;
+        }
+        if (count == max)
+        {
+            break;
+        }
+        entries[count].boot = boot;
+        entries[count].time_ms = time_ms;
+        entries[count].type = record.type;
+        entries[count].arg = record.arg;
+        count++;
+        *consumed = i + 1 - first;
+    }
+    return count;
+}
+
+void journal_ring_mark_sent(JournalRing *ring, uint16_t records)
+{
+    ring->state.unsent -= records < ring->state.unsent ? records : ring->state.unsent;
+    commit(ring);
+}
+
+const char *journal_event_name(uint8_t type)
+{
+    return type < JOURNAL_EVENT_TYPE_COUNT ? EVENT_NAMES[type] : "unknown";
+}
@@ -0,0 +1,138 @@
+#pragma once
+
+/*
+ * Packed ring of security events meant to live in memory that survives
+ * resets (RTC slow memory on the ESP32).
+ *
+ * Independent of the HAL: timestamps are passed in, so the layout can be
+ * checked on the host. Each record takes 4 bytes and stores the time
+ * since the previous record; a boot record restarts the time base.
+ * The header is written in two copies protected by a CRC, so a reset in
+ * the middle of an update leaves the previous copy valid.
+ */
+
+#include <stddef.h>
+#include <stdint.h>
+
+#define JOURNAL_CAPACITY 512      // Records kept, oldest are overwritten first
+#define JOURNAL_MAGIC 0x314E524AU // "JRN1"
+#define JOURNAL_DELTA_MAX 0xFFFFFFU // Largest delta of a single record
+
+/// Kinds of journaled events, at most 16.
+enum JournalEventType : uint8_t
+{
+    JOURNAL_EVENT_TIME,         ///< Time skip, the delta counts seconds instead of milliseconds.
+    JOURNAL_EVENT_BOOT,         ///< Node started, arg is the reset reason.
+    JOURNAL_EVENT_ARMED,        ///< Node armed.
+    JOURNAL_EVENT_DISARMED,     ///< Node disarmed.
+    JOURNAL_EVENT_ALARM_ON,     ///< Alarm started or escalated, arg is the alarm source.
+    JOURNAL_EVENT_ALARM_OFF,    ///< Alarm stopped, arg is the previous source.
+    JOURNAL_EVENT_ALARM_ACK,    ///< Latched alarms acknowledged.
+    JOURNAL_EVENT_MOTION_START, ///< PIR motion started, arg is the sensor index.
+    JOURNAL_EVENT_MOTION_END,   ///< PIR motion ended, arg is the sensor index.
+    JOURNAL_EVENT_OPEN,         ///< Window opened, arg is the reed relay index.
+    JOURNAL_EVENT_CLOSE,        ///< Window closed, arg is the reed relay index.
+    JOURNAL_EVENT_TILT_ON,      ///< Tilt sensor moved.
+    JOURNAL_EVENT_TILT_OFF,     ///< Tilt sensor back at rest.
+    JOURNAL_EVENT_INCIDENT,     ///< Intrusion incident, arg is the score divided by 16.
+    JOURNAL_EVENT_TYPE_COUNT,
+};
+
+/// Stored record, 4 bytes.
+struct JournalRecord
+{
+    uint32_t delta : 24; ///< Milliseconds since the previous record (seconds for JOURNAL_EVENT_TIME).
+    uint32_t type : 4;   ///< JournalEventType.
+    uint32_t arg : 4;    ///< Event argument.
+};
+
+/// Ring state, one of the two stored copies.
+struct JournalHeader
+{
+    uint32_t magic;
+    uint32_t sequence;  ///< Incremented on every update, the newer valid copy wins.
+    uint16_t head;      ///< Slot of the next record.
+    uint16_t count;     ///< Records stored.
+    uint16_t unsent;    ///< Newest records not published yet.
+    uint16_t dropped;   ///< Records overwritten before being published.
+    uint16_t boot;      ///< Boot number of the newest record.
+    uint16_t tail_boot; ///< Boot number of the oldest record.
+    uint32_t tail_ms;   ///< Time of the oldest record since its boot.
+    uint32_t last_ms;   ///< Time of the newest record since its boot.
+    uint32_t crc;       ///< CRC-32 of the fields above.
+};
+
+/// Whole journal as laid out in retained memory.
+struct JournalRing
+{
+    JournalHeader copies[2];
+    JournalRecord records[JOURNAL_CAPACITY];
+    JournalHeader state; ///< Working copy, rebuilt by journal_ring_open().
+};
+
+/// Decoded record.
+struct JournalEntry
+{
+    uint16_t boot;    ///< Boot number, counted since the journal was created.
+    uint32_t time_ms; ///< Time since that boot.
+    uint8_t type;     ///< JournalEventType.
+    uint8_t arg;      ///< Event argument.
+};
+
+/**
+ * @brief Validates the retained content, or formats the ring if none is valid.
+ *
+ * @param ring Ring in retained memory.
+ * @return true if records from before the reset were recovered, false if the ring was formatted.
+ */
+bool journal_ring_open(JournalRing *ring);
+
+/**
+ * @brief Appends an event.
+ *
+ * Writes one record, or two when the time since the previous record does
+ * not fit in the delta field.
+ *
+ * @param ring Opened ring.
+ * @param now_ms Time since boot.
+ * @param type Kind of event.
+ * @param arg Event argument, 0 to 15.
+ */
+void journal_ring_append(JournalRing *ring, uint32_t now_ms, JournalEventType type, uint8_t arg);
+
+/**
+ * @brief Appends a boot record, timestamps of later records count from it.
+ *
+ * @param ring Opened ring.
+ * @param reason Reset reason.
+ */
+void journal_ring_boot(JournalRing *ring, uint8_t reason);
+
+/**
+ * @brief Decodes stored records, time skips are folded into the following records.
+ *
+ * @param ring Opened ring.
+ * @param first Index of the first record to decode, 0 is the oldest.
+ * @param entries (Output) Decoded records.
+ * @param max Maximum number of entries.
+ * @param consumed (Output) Records covered by the decoded entries, including time skips.
+ * @return Number of entries decoded.
+ */
+size_t journal_ring_read(const JournalRing *ring, uint16_t first, JournalEntry *entries, size_t max,
+                         uint16_t *consumed);
+
+/**
+ * @brief Marks the oldest unsent records as published.
+ *
+ * @param ring Opened ring.
+ * @param records Number of records published (as counted in JournalHeader::unsent).
+ */
+void journal_ring_mark_sent(JournalRing *ring, uint16_t records);
+
+/**
+ * @brief Returns the name of an event type.
+ *
+ * @param type JournalEventType.
+ * @return Event name, "unknown" for an invalid type.
+ */
+const char *journal_event_name(uint8_t type);
@@ -1,4 +1,3 @@
-#include <Arduino.h>
 #include "scheduling/scheduling.hpp"
 
 #define MAIN_TAG "app_main"
@@ -11,9 +10,7 @@
  */
 void setup()
 {
-  Serial.begin(115200);
-  while (!Serial) 
-    ;
+  hal_console_begin(115200);
 
   if (!security_setup())
   {
@@ -22,6 +19,13 @@ void setup()
   }
 
   // init_scheduling();
+
+#ifdef BOOT_REPORT
+  // Printed on the console so it is still visible when logs are compiled out
+  hal_console_printf("Boot completed in %lu ms, free heap: %lu B, min free heap: %lu B\n",
+                     (unsigned long)hal_millis(), (unsigned long)hal_free_heap(),
+                     (unsigned long)hal_min_free_heap());
+#endif
 }
 
 /**
@@ -34,5 +38,19 @@ void setup()
  */
 void loop()
 {
-  vTaskDelay(10 / portTICK_PERIOD_MS); // 10 ms delay to prevent watchdog reset
+  hal_delay_ms(10); // 10 ms delay to prevent watchdog reset
+}
+
+#if defined(HAL_LINUX) && !defined(PIO_UNIT_TESTING)
+/**
+ * @brief Host entry point mirroring the Arduino core: setup() once, then loop() forever.
+ */
+int main()
+{
+  setup();
+  while (true)
+  {
+    loop();
+  }
 }
+#endif
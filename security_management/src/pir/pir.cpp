@@ -1,7 +1,6 @@
 #include "pir.hpp"
-#include "esp_log.h"
-#include "../mqtt/mqtt.hpp"
-#include "../buzzer/buzzer.hpp"
+#include "../intrusion/intrusion.hpp"
+#include "../journal/journal.hpp"
 
 #define PIR_TAG "app_pir"
 
@@ -11,10 +10,8 @@
 
 #define MOTION_END_DELAY 4000  // debounce time for PIR sensor in milliseconds
 
-char printBuffer[128];         // buffer for printing messages with variables
-
 const int PIR_PINS[4] = {13, 12, 14, 27}; // PIR sensors pins
-bool lastPirVal[4] = {LOW, LOW, LOW, LOW};  // Last state of PIR sensor
+bool lastPirVal[4] = {HAL_LOW, HAL_LOW, HAL_LOW, HAL_LOW};  // Last state of PIR sensor
 unsigned long endTime[4] = {0}; // time left to end the alarm
 unsigned long timeAlarmON[4] = {0};  // Time of starting the alarm
 unsigned long timeAlarmOFF[4] = {0};  // Time of ending the alarm
@@ -23,9 +20,9 @@ bool init_pir()
 {
     ESP_LOGI(PIR_TAG, "Initializing PIR sensors...");
     for (int i = 0; i < 4; i++) {
-        pinMode(PIR_PINS[i], INPUT);
+        hal_gpio_mode(PIR_PINS[i], HAL_INPUT);
     }
-    vTaskDelay (1000 / portTICK_PERIOD_MS); // 1 sec delay for PIR sensor to initialize
+    hal_delay_ms(1000); // 1 sec delay for PIR sensor to initialize
     for (int i = 0; i < 4; i++) {
       ESP_LOGI(PIR_TAG, "PIR sensor no. %d initialized on GPIO:  %d", i+1,  PIR_PINS[i]);
     }
@@ -42,30 +39,29 @@ bool init_pir()
 // My solution is to make a debouncing mechanism for alarm disabling, becaude of its precision.
 
 void pir_logic(int sensorIndex){
-  int pirVal = digitalRead(PIR_PINS[sensorIndex]);
+  int pirVal = hal_gpio_read(PIR_PINS[sensorIndex]);
 
-  if (pirVal == HIGH) {
-      if (lastPirVal[sensorIndex] == LOW) {
-          timeAlarmON[sensorIndex] = millis();  // Time of starting the alarm
-          sprintf(printBuffer, "Motion detected by sensor %d!", sensorIndex + 1);
-          set_buzzer_alarm(true); // Turn on the alarm
-          Serial.println(printBuffer);
-          lastPirVal[sensorIndex] = HIGH;
+  if (pirVal == HAL_HIGH) {
+      if (lastPirVal[sensorIndex] == HAL_LOW) {
+          timeAlarmON[sensorIndex] = hal_millis();  // Time of starting the alarm
+          journal_record(JOURNAL_EVENT_MOTION_START, sensorIndex);
+          intrusion_report(INTRUSION_EVENT_MOTION, sensorIndex); // Scored together with the other sensors
+          ESP_LOGI(PIR_TAG, "Motion detected by sensor %d!", sensorIndex + 1);
+          lastPirVal[sensorIndex] = HAL_HIGH;
           endTime[sensorIndex] = 0; // Reset time to end the alarm
       }
   }
 
-  if (pirVal == LOW) {
-      if (lastPirVal[sensorIndex] == HIGH && endTime[sensorIndex] == 0) { // If the sensor isn't detecting anymore, start the timer
-          endTime[sensorIndex] = millis();
+  if (pirVal == HAL_LOW) {
+      if (lastPirVal[sensorIndex] == HAL_HIGH && endTime[sensorIndex] == 0) { // If the sensor isn't detecting anymore, start the timer
+          endTime[sensorIndex] = hal_millis();
       }
 
-      if (endTime[sensorIndex] > 0 && millis() - endTime[sensorIndex] >= MOTION_END_DELAY) { // If the sensor isn't detecting anymore for a while, end the alarm
-          timeAlarmOFF[sensorIndex] = millis();
-          set_buzzer_alarm(false);  // Turn off the alarm
-          sprintf(printBuffer, "Alarm from sensor %d stopped. It lasted %lu s", sensorIndex + 1, (timeAlarmOFF[sensorIndex] - timeAlarmON[sensorIndex]) / 1000);
-          Serial.println(printBuffer);
-          lastPirVal[sensorIndex] = LOW;
+      if (endTime[sensorIndex] > 0 && hal_millis() - endTime[sensorIndex] >= MOTION_END_DELAY) { // If the sensor isn't detecting anymore for a while, end the alarm
+          timeAlarmOFF[sensorIndex] = hal_millis();
+          journal_record(JOURNAL_EVENT_MOTION_END, sensorIndex);
+          ESP_LOGI(PIR_TAG, "Motion at sensor %d ended. It lasted %lu s", sensorIndex + 1, (timeAlarmOFF[sensorIndex] - timeAlarmON[sensorIndex]) / 1000);
+          lastPirVal[sensorIndex] = HAL_LOW;
           endTime[sensorIndex] = 0; // reset debouncing timer
       }
   } else {
@@ -79,3 +75,12 @@ void handle_pir()
     pir_logic(i);
 }
 }
+
+void pir_add_wake_pins()
+{
+  for (int i = 0; i < 4; i++) {
+    if (hal_gpio_read(PIR_PINS[i]) == HAL_LOW) {
+      hal_sleep_add_wake_pin(PIR_PINS[i], HAL_HIGH);
+    }
+  }
+}
@@ -1,6 +1,6 @@
 #pragma once
 
-#include <Arduino.h>
+#include "hal/hal.hpp"
 
 /**
  * @brief Initializes the PIR sensors.
@@ -16,3 +16,10 @@ bool init_pir();
  * This function should be called periodically to manage the PIR sensor inputs.
  */
 void handle_pir();
+
+/**
+ * @brief Registers the idle PIR sensors as sleep wake-up sources.
+ *
+ * Sensors still reporting motion are skipped, they would wake the node at once.
+ */
+void pir_add_wake_pins();
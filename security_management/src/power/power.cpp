@@ -0,0 +1,185 @@
+#include <stdio.h>
+#include "power.hpp"
+#include "../alarm/alarm.hpp"
+#include "../buzzer/buzzer.hpp"
+#include "../intrusion/intrusion.hpp"
+#include "../journal/journal.hpp"
+#include "../pir/pir.hpp"
+#include "../reed_relay/reed_relay.hpp"
+#include "../uplink/uplink.hpp"
+
+#define POWER_TAG "app_power"
+
+#define POWER_POLL_MS 1000
+#define POWER_PUBLISH_POLL_MS 50 // While a wake event waits for the network
+#define POWER_FIRE_CHECK_MS 10000       // Asleep, the timer wakes the node this often to sample fire and smoke
+#define POWER_FIRE_CHECK_WINDOW_MS 1000 // Analog blocks processed per check, one smoke reading
+#define POWER_CHECK_POLL_MS 10          // Wake pins polled during a check, like light sleep would see them
+
+#if POWER_SLEEP_MODE == POWER_SLEEP_DEEP
+#error "Deep sleep stops the fire and smoke sampling, it needs the ULP to sample the analog inputs first"
+#endif
+
+static PowerFsm fsm;
+static HAL_RETAINED bool armed = false; // Survives deep sleep
+static volatile bool requested_armed = false;
+static uint64_t pending_wake_pins = 0;
+static uint32_t last_event_count = 0;
+
+static void on_arm_message(const char *payload)
+{
+    bool value;
+    if (!uplink_parse_flag(payload, &value))
+    {
+        ESP_LOGW(POWER_TAG, "Arm request ignored, payload: %s", payload);
+        return;
+    }
+    power_set_armed(value);
+}
+
+static void publish_wake_event()
+{
+    char value[64] = "";
+    size_t length = 0;
+    for (int pin = 0; pin < 64 && length < sizeof(value) - 4; pin++)
+    {
+        if (pending_wake_pins & (1ULL << pin))
+        {
+            length += snprintf(value + length, sizeof(value) - length, length ? ",%d" : "%d", pin);
+        }
+    }
+
+    if (!uplink_publish(TOPIC_WAKE_EVENT, value))
+    {
+        return;
+    }
+    pending_wake_pins = 0;
+    power_fsm_published(&fsm, hal_millis());
+    ESP_LOGI(POWER_TAG, "Wake event published %lu ms after waking (max %lu ms), average current %lu uA",
+             (unsigned long)fsm.last_latency_ms, (unsigned long)fsm.max_latency_ms,
+             (unsigned long)power_fsm_average_current_ua(&fsm, hal_millis()));
+}
+
+/* An alarm, the siren, or sensor events since the last call keep the node awake */
+static bool node_busy()
+{
+    uint32_t events, incidents;
+    intrusion_get_stats(&events, &incidents);
+    bool busy = alarm_active_source() != ALARM_SOURCE_NONE || buzzer_is_playing() || events != last_event_count;
+    last_event_count = events;
+    return busy;
+}
+
+static void woke(HalWakeCause cause)
+{
+    PowerAction action = power_fsm_woke(&fsm, hal_millis(), cause == HAL_WAKE_GPIO);
+    uint64_t pins = hal_wake_pins();
+    if (action == POWER_ACTION_CHECK)
+    {
+        // The analog task processes the blocks meanwhile, the fire sensor and smoke detector raise the alarm
+        pins = 0;
+        for (uint32_t waited = 0; waited < POWER_FIRE_CHECK_WINDOW_MS; waited += POWER_CHECK_POLL_MS)
+        {
+            hal_delay_ms(POWER_CHECK_POLL_MS);
+            pins |= hal_sleep_active_wake_pins();
+        }
+        action = power_fsm_checked(&fsm, hal_millis(), pins != 0, node_busy());
+        if (action == POWER_ACTION_CONNECT && pins == 0)
+        {
+            ESP_LOGI(POWER_TAG, "Alarm or sensor event during a fire check, staying awake");
+        }
+    }
+
+    if (action == POWER_ACTION_CONNECT && pins != 0)
+    {
+        pending_wake_pins = pins;
+        ESP_LOGI(POWER_TAG, "Woken by GPIO mask 0x%llx", (unsigned long long)pending_wake_pins);
+    }
+
+    if (action == POWER_ACTION_CONNECT)
+    {
+        uplink_resume();
+    }
+}
+
+static void enter_sleep()
+{
+    ESP_LOGI(POWER_TAG, "Armed and idle, sleeping (average current %lu uA)",
+             (unsigned long)power_fsm_average_current_ua(&fsm, hal_millis()));
+    uplink_suspend();
+
+    do
+    {
+        hal_sleep_clear_wake_pins();
+        pir_add_wake_pins();
+        reed_relay_add_wake_pins();
+        hal_sleep_set_timer(POWER_FIRE_CHECK_MS * 1000ULL);
+
+#if POWER_SLEEP_MODE == POWER_SLEEP_DEEP
+        hal_deep_sleep();
+#else
+        woke(hal_light_sleep());
+#endif
+    } while (fsm.state == POWER_SLEEPING);
+}
+
+bool init_power()
+{
+    power_fsm_init(&fsm, hal_millis(), POWER_SLEEP_MODE == POWER_SLEEP_DEEP);
+    requested_armed = armed;
+    if (armed)
+    {
+        power_fsm_arm(&fsm, hal_millis(), true);
+        if (hal_wake_cause() != HAL_WAKE_NONE) // Booted from deep sleep
+        {
+            woke(hal_wake_cause());
+        }
+    }
+
+    uplink_subscribe(TOPIC_ARM, on_arm_message);
+    ESP_LOGI(POWER_TAG, "Power management initialized, %s", armed ? "armed" : "disarmed");
+    return true;
+}
+
+void handle_power()
+{
+    uint32_t now = hal_millis();
+
+    if (requested_armed != armed)
+    {
+        armed = requested_armed;
+        power_fsm_arm(&fsm, now, armed);
+        journal_record(armed ? JOURNAL_EVENT_ARMED : JOURNAL_EVENT_DISARMED, 0);
+        ESP_LOGI(POWER_TAG, "Node %s", armed ? "armed" : "disarmed");
+    }
+
+    if (fsm.state == POWER_WAKE_PUBLISH && uplink_is_connected())
+    {
+        publish_wake_event();
+    }
+
+    if (power_fsm_tick(&fsm, now, node_busy()) == POWER_ACTION_SLEEP)
+    {
+        enter_sleep();
+    }
+}
+
+uint32_t power_poll_period_ms()
+{
+    return fsm.state == POWER_WAKE_PUBLISH ? POWER_PUBLISH_POLL_MS : POWER_POLL_MS;
+}
+
+void power_set_armed(bool value)
+{
+    requested_armed = value;
+}
+
+bool power_is_armed()
+{
+    return armed;
+}
+
+void power_get_fsm(PowerFsm *out)
+{
+    *out = fsm;
+}
@@ -0,0 +1,65 @@
+#pragma once
+
+#include "hal/hal.hpp"
+#include "power_fsm.hpp"
+
+#define POWER_SLEEP_LIGHT 0 // RAM and tasks are kept, every PIR and reed pin can wake the node
+#define POWER_SLEEP_DEEP 1  // Lowest current, the node reboots on wake and only PIR pins (plus one reed) can wake it.
+                            // Not supported until the ULP samples fire and smoke.
+
+#ifndef POWER_SLEEP_MODE
+#define POWER_SLEEP_MODE POWER_SLEEP_LIGHT
+#endif
+
+/**
+ * @brief Initializes power management.
+ *
+ * The node starts disarmed and stays awake. Once armed (MQTT topic
+ * TOPIC_ARM) it sleeps after POWER_QUIET_MS without activity and wakes
+ * when a PIR detects motion or a window opens. After a wake-up it
+ * reconnects, publishes the pins that woke it and goes back to sleep once
+ * quiet again. While asleep a timer wakes the node every few seconds to
+ * sample the flame sensor and the MQ-2 with the radio off; a fire alarm
+ * keeps it awake.
+ *
+ * @return true if initialization was successful, false otherwise.
+ */
+bool init_power();
+
+/**
+ * @brief Runs the sleep/wake state machine, called periodically.
+ *
+ * Enters sleep from the calling task when the node is armed and idle.
+ */
+void handle_power();
+
+/**
+ * @brief Returns how long the power task should wait before the next handle_power().
+ *
+ * Short while a wake event waits for the network, so it is published as
+ * soon as the connection is up.
+ *
+ * @return Delay in milliseconds.
+ */
+uint32_t power_poll_period_ms();
+
+/**
+ * @brief Requests arming or disarming, applied by the next handle_power().
+ *
+ * @param armed Requested mode.
+ */
+void power_set_armed(bool armed);
+
+/**
+ * @brief Returns whether the node is armed, as applied by the last handle_power().
+ *
+ * Intrusion incidents only raise the alarm while armed.
+ */
+bool power_is_armed();
+
+/**
+ * @brief Copies the state machine, including residency and latency figures.
+ *
+ * @param fsm (Output) Current state machine.
+ */
+void power_get_fsm(PowerFsm *fsm);
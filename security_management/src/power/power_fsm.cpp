@@ -0,0 +1,163 @@
+#include "power_fsm.hpp"
+
+static const char *STATE_NAMES[POWER_STATE_COUNT] = {
+    "disarmed",
+    "armed",
+    "sleeping",
+    "checking",
+    "wake publish",
+};
+
+static void enter(PowerFsm *fsm, PowerState state, uint32_t now_ms)
+{
+    fsm->residency_ms[fsm->state] += now_ms - fsm->state_since_ms;
+    fsm->state = state;
+    fsm->state_since_ms = now_ms;
+}
+
+void power_fsm_init(PowerFsm *fsm, uint32_t now_ms, bool deep_sleep)
+{
+    fsm->state = POWER_DISARMED;
+    fsm->deep_sleep = deep_sleep;
+    fsm->state_since_ms = now_ms;
+    fsm->last_activity_ms = now_ms;
+    fsm->wake_ms = 0;
+    fsm->wakes = 0;
+    fsm->checks = 0;
+    fsm->publishes = 0;
+    fsm->last_latency_ms = 0;
+    fsm->max_latency_ms = 0;
+    for (int i = 0; i < POWER_STATE_COUNT; i++)
+    {
+        fsm->residency_ms[i] = 0;
+    }
+}
+
+void power_fsm_arm(PowerFsm *fsm, uint32_t now_ms, bool armed)
+{
+    if (!armed)
+    {
+        enter(fsm, POWER_DISARMED, now_ms);
+    }
+    else if (fsm->state == POWER_DISARMED)
+    {
+        fsm->last_activity_ms = now_ms;
+        enter(fsm, POWER_ARMED_ACTIVE, now_ms);
+    }
+}
+
+PowerAction power_fsm_tick(PowerFsm *fsm, uint32_t now_ms, bool busy)
+{
+    if (busy)
+    {
+        fsm->last_activity_ms = now_ms;
+    }
+
+    switch (fsm->state)
+    {
+    case POWER_ARMED_ACTIVE:
+        if (now_ms - fsm->last_activity_ms >= POWER_QUIET_MS)
+        {
+            enter(fsm, POWER_SLEEPING, now_ms);
+            return POWER_ACTION_SLEEP;
+        }
+        return POWER_ACTION_NONE;
+
+    case POWER_WAKE_PUBLISH:
+        if (now_ms - fsm->wake_ms >= POWER_PUBLISH_TIMEOUT_MS)
+        {
+            // Keep the node awake for the quiet period, the event stays in the journal
+            fsm->last_activity_ms = now_ms;
+            enter(fsm, POWER_ARMED_ACTIVE, now_ms);
+        }
+        return POWER_ACTION_NONE;
+
+    default:
+        return POWER_ACTION_NONE;
+    }
+}
+
+PowerAction power_fsm_woke(PowerFsm *fsm, uint32_t now_ms, bool by_sensor)
+{
+    if (!by_sensor)
+    {
+        fsm->checks++;
+        enter(fsm, POWER_CHECKING, now_ms);
+        return POWER_ACTION_CHECK;
+    }
+
+    fsm->wakes++;
+    fsm->wake_ms = now_ms;
+    fsm->last_activity_ms = now_ms;
+    enter(fsm, POWER_WAKE_PUBLISH, now_ms);
+    return POWER_ACTION_CONNECT;
+}
+
+PowerAction power_fsm_checked(PowerFsm *fsm, uint32_t now_ms, bool by_sensor, bool busy)
+{
+    if (fsm->state != POWER_CHECKING)
+    {
+        return POWER_ACTION_NONE;
+    }
+    if (by_sensor)
+    {
+        return power_fsm_woke(fsm, now_ms, true);
+    }
+    if (!busy)
+    {
+        enter(fsm, POWER_SLEEPING, now_ms);
+        return POWER_ACTION_SLEEP;
+    }
+    // Awake until quiet again, like after a published wake event
+    fsm->last_activity_ms = now_ms;
+    enter(fsm, POWER_ARMED_ACTIVE, now_ms);
+    return POWER_ACTION_CONNECT;
+}
+
+void power_fsm_published(PowerFsm *fsm, uint32_t now_ms)
+{
+    if (fsm->state != POWER_WAKE_PUBLISH)
+    {
+        return;
+    }
+    uint32_t latency_ms = now_ms - fsm->wake_ms;
+    fsm->publishes++;
+    fsm->last_latency_ms = latency_ms;
+    if (latency_ms > fsm->max_latency_ms)
+    {
+        fsm->max_latency_ms = latency_ms;
+    }
+    fsm->last_activity_ms = now_ms;
+    enter(fsm, POWER_ARMED_ACTIVE, now_ms);
+}
+
+uint32_t power_fsm_average_current_ua(const PowerFsm *fsm, uint32_t now_ms)
+{
+    uint64_t total_ms = 0;
+    uint64_t charge = 0; // uA * ms
+    for (int i = 0; i < POWER_STATE_COUNT; i++)
+    {
+        uint64_t ms = fsm->residency_ms[i];
+        if (i == fsm->state)
+        {
+            ms += now_ms - fsm->state_since_ms;
+        }
+        uint32_t current_ua = POWER_ACTIVE_UA;
+        if (i == POWER_SLEEPING)
+        {
+            current_ua = fsm->deep_sleep ? POWER_DEEP_SLEEP_UA : POWER_LIGHT_SLEEP_UA;
+        }
+        else if (i == POWER_CHECKING)
+        {
+            current_ua = POWER_CHECK_UA;
+        }
+        total_ms += ms;
+        charge += ms * (current_ua + POWER_SENSORS_UA);
+    }
+    return total_ms > 0 ? (uint32_t)(charge / total_ms) : 0;
+}
+
+const char *power_fsm_state_name(PowerState state)
+{
+    return state < POWER_STATE_COUNT ? STATE_NAMES[state] : "unknown";
+}
@@ -0,0 +1,127 @@
+#pragma once
+
+/*
+ * Sleep/wake state machine of the security node.
+ *
+ * Independent of the HAL: time is passed in and the machine only returns
+ * actions, so it doubles as a host model for latency and battery life.
+ */
+
+#include <stdint.h>
+
+#define POWER_QUIET_MS 30000          // Armed and idle this long before sleeping
+#define POWER_PUBLISH_TIMEOUT_MS 15000 // Give up publishing a wake event after this
+
+/* Supply current model in microamps, ESP32 datasheet figures plus four PIR sensors */
+#define POWER_SENSORS_UA 260
+#define POWER_ACTIVE_UA 110000 // CPU running, WiFi connected
+#define POWER_LIGHT_SLEEP_UA 800
+#define POWER_CHECK_UA 40000   // CPU and ADC running, radio off
+#define POWER_DEEP_SLEEP_UA 10
+
+/// States of the node.
+enum PowerState : uint8_t
+{
+    POWER_DISARMED,     ///< Always awake.
+    POWER_ARMED_ACTIVE, ///< Awake, sleeps after POWER_QUIET_MS without activity.
+    POWER_SLEEPING,     ///< Asleep until a wake pin or the fire check timer fires.
+    POWER_CHECKING,     ///< Woken by the timer, sampling fire and smoke with the radio off.
+    POWER_WAKE_PUBLISH, ///< Woken by a sensor, reconnecting to publish the event.
+    POWER_STATE_COUNT,
+};
+
+/// What the caller has to do after feeding an input.
+enum PowerAction : uint8_t
+{
+    POWER_ACTION_NONE,
+    POWER_ACTION_SLEEP,   ///< Enter sleep now.
+    POWER_ACTION_CONNECT, ///< Resume the network and publish the wake event.
+    POWER_ACTION_CHECK,   ///< Sample fire and smoke, then report with power_fsm_checked().
+};
+
+/// State machine with residency and latency accounting.
+struct PowerFsm
+{
+    PowerState state;
+    bool deep_sleep;           ///< Sleep current uses the deep sleep figure.
+    uint32_t state_since_ms;   ///< Entry time of the current state.
+    uint32_t last_activity_ms; ///< Last sensor event or busy tick.
+    uint32_t wake_ms;          ///< Time of the last wake-up.
+    uint32_t wakes;            ///< Wake-ups from sleep by a sensor.
+    uint32_t checks;           ///< Wake-ups by the timer to sample fire and smoke.
+    uint32_t publishes;        ///< Wake events published.
+    uint32_t last_latency_ms;  ///< Wake-to-publish latency of the last event.
+    uint32_t max_latency_ms;   ///< Worst wake-to-publish latency.
+    uint64_t residency_ms[POWER_STATE_COUNT]; ///< Time spent in each state.
+};
+
+/**
+ * @brief Resets the state machine.
+ *
+ * @param fsm State machine.
+ * @param now_ms Current time.
+ * @param deep_sleep Whether sleeping means deep sleep (for the current model).
+ */
+void power_fsm_init(PowerFsm *fsm, uint32_t now_ms, bool deep_sleep);
+
+/**
+ * @brief Arms or disarms the node.
+ *
+ * @param fsm State machine.
+ * @param now_ms Current time.
+ * @param armed Requested mode.
+ */
+void power_fsm_arm(PowerFsm *fsm, uint32_t now_ms, bool armed);
+
+/**
+ * @brief Periodic update while awake.
+ *
+ * @param fsm State machine.
+ * @param now_ms Current time.
+ * @param busy Something needs the node awake (alarm, sensor activity, pending uplink work).
+ * @return POWER_ACTION_SLEEP when the node should go to sleep.
+ */
+PowerAction power_fsm_tick(PowerFsm *fsm, uint32_t now_ms, bool busy);
+
+/**
+ * @brief Reports that the node woke up.
+ *
+ * @param fsm State machine.
+ * @param now_ms Time of the wake-up.
+ * @param by_sensor Woken by a wake pin rather than the timer.
+ * @return POWER_ACTION_CONNECT if the wake event must be published, POWER_ACTION_CHECK after the timer.
+ */
+PowerAction power_fsm_woke(PowerFsm *fsm, uint32_t now_ms, bool by_sensor);
+
+/**
+ * @brief Reports the end of a fire check.
+ *
+ * @param fsm State machine.
+ * @param now_ms Current time.
+ * @param by_sensor A wake pin reached its level during the check, handled like a wake-up.
+ * @param busy An alarm was raised or a sensor reported an event during the check.
+ * @return POWER_ACTION_CONNECT to stay awake (publishing the wake event if by_sensor), POWER_ACTION_SLEEP otherwise.
+ */
+PowerAction power_fsm_checked(PowerFsm *fsm, uint32_t now_ms, bool by_sensor, bool busy);
+
+/**
+ * @brief Reports that the wake event was published.
+ *
+ * @param fsm State machine.
+ * @param now_ms Current time.
+ */
+void power_fsm_published(PowerFsm *fsm, uint32_t now_ms);
+
+/**
+ * @brief Average supply current over the accounted time.
+ *
+ * @param fsm State machine.
+ * @param now_ms Current time, the current state is accounted up to it.
+ * @return Modelled average current in microamps.
+ */
+uint32_t power_fsm_average_current_ua(const PowerFsm *fsm, uint32_t now_ms);
+
+/**
+ * @brief Returns the name of a state.
+ */
+const char *power_fsm_state_name(PowerState state);
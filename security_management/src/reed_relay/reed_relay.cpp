@@ -1,18 +1,19 @@
 #include "reed_relay.hpp"
-#include "esp_log.h"
+#include "../alarm/alarm.hpp"
+#include "../intrusion/intrusion.hpp"
+#include "../journal/journal.hpp"
 
 #define NUM_SENSORS 3 // GPIO pin where the reed relay is connected
 #define SENSOR_TAG "reed_relay"
 
 const int reedPins[NUM_SENSORS] = {26, 25, 33};
-int lastStates[NUM_SENSORS] = {LOW, LOW, LOW};
-char printBuffer[50]; // Buffer for printing messages
+int lastStates[NUM_SENSORS] = {HAL_LOW, HAL_LOW, HAL_LOW};
 
 bool init_reed_relay()
 {
     for (int i = 0; i < NUM_SENSORS; i++) // Configure the reed relay pin as an input
     {
-        pinMode(reedPins[i], INPUT);
+        hal_gpio_mode(reedPins[i], HAL_INPUT);
         ESP_LOGI(SENSOR_TAG, "Reed relay no. %d initialized on GPIO %d", i+1 , reedPins[i]);
 
     }
@@ -20,37 +21,37 @@ bool init_reed_relay()
     // initial information about the state of reed relays 
     for (int i = 0; i < NUM_SENSORS; i++)
     {
-        if (digitalRead(reedPins[i]) == HIGH)
+        if (hal_gpio_read(reedPins[i]) == HAL_HIGH)
         {
-            sprintf(printBuffer, "Window no. %d is closed", i+1);
-            Serial.println(printBuffer);
-            lastStates[i] = HIGH;
+            ESP_LOGI(SENSOR_TAG, "Window no. %d is closed", i+1);
+            lastStates[i] = HAL_HIGH;
         }
         else
         {
-            sprintf(printBuffer, "Window no. %d is opened", i+1);
-            Serial.println(printBuffer);
-            lastStates[i] = LOW;
+            ESP_LOGI(SENSOR_TAG, "Window no. %d is opened", i+1);
+            lastStates[i] = HAL_LOW;
         }
     }
     return true;
 }
 
 void reed_relay_logic(int sensorIndex){
-    if (digitalRead(reedPins[sensorIndex]) == HIGH) // Check if the reed relay is closed
+    if (hal_gpio_read(reedPins[sensorIndex]) == HAL_HIGH) // Check if the reed relay is closed
     {
-        if (lastStates[sensorIndex] == LOW){ // If it was open before
-            sprintf(printBuffer, "Window no. %d is closed", sensorIndex+1);
-            Serial.println(printBuffer);
-            lastStates[sensorIndex] = HIGH;
+        if (lastStates[sensorIndex] == HAL_LOW){ // If it was open before
+            ESP_LOGI(SENSOR_TAG, "Window no. %d is closed", sensorIndex+1);
+            journal_record(JOURNAL_EVENT_CLOSE, sensorIndex);
+            lastStates[sensorIndex] = HAL_HIGH;
         }
     }
     else
     {
-        if (lastStates[sensorIndex] == HIGH){ // If it was closed before
-            sprintf(printBuffer, "Window no. %d is open", sensorIndex+1);
-            Serial.println(printBuffer);
-            lastStates[sensorIndex] = LOW;
+        if (lastStates[sensorIndex] == HAL_HIGH){ // If it was closed before
+            ESP_LOGI(SENSOR_TAG, "Window no. %d is open", sensorIndex+1);
+            alarm_pulse(ALARM_SOURCE_CHIME);
+            journal_record(JOURNAL_EVENT_OPEN, sensorIndex);
+            intrusion_report(INTRUSION_EVENT_OPEN, sensorIndex);
+            lastStates[sensorIndex] = HAL_LOW;
         }
     }
 }
@@ -62,4 +63,15 @@ void handle_reed_relay()
         reed_relay_logic(i);
     }
 
-}
\ No newline at end of file
+}
+
+void reed_relay_add_wake_pins()
+{
+    for (int i = 0; i < NUM_SENSORS; i++)
+    {
+        if (hal_gpio_read(reedPins[i]) == HAL_HIGH) // Closed, opening pulls the pin low
+        {
+            hal_sleep_add_wake_pin(reedPins[i], HAL_LOW);
+        }
+    }
+}
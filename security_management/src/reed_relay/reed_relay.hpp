@@ -1,6 +1,6 @@
 #pragma once 
 
-#include <Arduino.h>
+#include "hal/hal.hpp"
 
 /**
  * @brief Initializes the sensor.
@@ -15,4 +15,11 @@ bool init_reed_relay();
  *
  * This function should be called periodically to manage the buzzer's state.
  */
-void handle_reed_relay();
\ No newline at end of file
+void handle_reed_relay();
+
+/**
+ * @brief Registers the closed windows as sleep wake-up sources.
+ *
+ * A window that is already open is skipped, it would wake the node at once.
+ */
+void reed_relay_add_wake_pins();
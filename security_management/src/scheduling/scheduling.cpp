@@ -2,30 +2,52 @@
 
 #define SCHEDULING_TAG "app_scheduling"
 
-TaskHandle_t wifiTaskHandle = NULL;
-TaskHandle_t mqttTaskHandle = NULL;
-TaskHandle_t pirTaskHandle = NULL;
-TaskHandle_t buzzerTaskHandle = NULL;
-TaskHandle_t fireSensorTaskHandle = NULL;
-TaskHandle_t smokeDetectorTaskHandle = NULL;
-TaskHandle_t reedRelayTaskHandle = NULL;
-TaskHandle_t tiltSensorTaskHandle = NULL;
+hal_task_t wifiTaskHandle = NULL;
+hal_task_t mqttTaskHandle = NULL;
+hal_task_t pirTaskHandle = NULL;
+hal_task_t reedRelayTaskHandle = NULL;
+hal_task_t tiltSensorTaskHandle = NULL;
+hal_task_t alarmTaskHandle = NULL;
+hal_task_t powerTaskHandle = NULL;
+
+static void on_alarm_ack(const char *payload)
+{
+    bool ack;
+    if (!uplink_parse_flag(payload, &ack) || !ack)
+    {
+        ESP_LOGW(SCHEDULING_TAG, "Alarm acknowledge ignored, payload: %s", payload);
+        return;
+    }
+    alarm_acknowledge();
+}
 
 bool security_setup()
 {
     ESP_LOGI(SCHEDULING_TAG, "Setting up security management...");
 
-    // if (!init_wifi())
-    // {
-    //     ESP_LOGE(SCHEDULING_TAG, "Failed to initialize WiFi");
-    //     return false;
-    // }
+    if (!init_journal()) // First, so the other modules can journal their events
+    {
+        ESP_LOGE(SCHEDULING_TAG, "Failed to initialize Journal");
+        return false;
+    }
+
+    if (!init_uplink())
+    {
+        ESP_LOGE(SCHEDULING_TAG, "Failed to initialize WiFi and MQTT");
+        return false;
+    }
 
-    // if (!init_mqtt())
-    // {
-    //     ESP_LOGE(SCHEDULING_TAG, "Failed to initialize MQTT");
-    //     return false;
-    // }
+    if (!init_alarm())
+    {
+        ESP_LOGE(SCHEDULING_TAG, "Failed to initialize Alarm");
+        return false;
+    }
+
+    if (!init_intrusion())
+    {
+        ESP_LOGE(SCHEDULING_TAG, "Failed to initialize Intrusion Detector");
+        return false;
+    }
 
     if (!init_pir())
     {
@@ -45,11 +67,17 @@ bool security_setup()
         return false;
     }
 
-    // if (!init_smoke_detector())
-    // {
-    //     ESP_LOGE(SCHEDULING_TAG, "Failed to initialize Smoke Detector");
-    //     return false;
-    // }
+    if (!init_smoke_detector())
+    {
+        ESP_LOGE(SCHEDULING_TAG, "Failed to initialize Smoke Detector");
+        return false;
+    }
+
+    if (!init_analog()) // After every analog input is registered
+    {
+        ESP_LOGE(SCHEDULING_TAG, "Failed to initialize Analog Sampling");
+        return false;
+    }
     
     if(!init_reed_relay())
     {
@@ -63,6 +91,14 @@ bool security_setup()
         return false;
     }
 
+    uplink_subscribe(TOPIC_ALARM_ACK, on_alarm_ack);
+
+    if (!init_power())
+    {
+        ESP_LOGE(SCHEDULING_TAG, "Failed to initialize Power Management");
+        return false;
+    }
+
     if (!init_scheduling())
     {
         ESP_LOGE(SCHEDULING_TAG, "Failed to initialize scheduling");
@@ -75,99 +111,85 @@ bool init_scheduling()
 {
     ESP_LOGI(SCHEDULING_TAG, "Initializing scheduling...");
 
-    BaseType_t result;
-
-    // result = xTaskCreatePinnedToCore(
-    //     wifiTask,
-    //     "Wifi Task",
-    //     WIFI_TASK_STACK_SIZE,
-    //     NULL,
-    //     WIFI_TASK_PRIORITY,
-    //     &wifiTaskHandle,
-    //     WIFI_CORE);
-
-    // if (result != pdPASS)
-    // {
-    //     ESP_LOGE(SCHEDULING_TAG, "Failed to create Network Task");
-    //     return false;
-    // }
-
-    // result = xTaskCreatePinnedToCore(
-    //     mqttTask,
-    //     "MQTT Task",
-    //     MQTT_TASK_STACK_SIZE,
-    //     NULL,
-    //     MQTT_TASK_PRIORITY,
-    //     &mqttTaskHandle,
-    //     MQTT_CORE);
-
-    // if (result != pdPASS)
-    // {
-    //     ESP_LOGE(SCHEDULING_TAG, "Failed to create MQTT Task");
-    //     return false;
-    // }
-
-    result = xTaskCreatePinnedToCore(
-        pirTask,
-        "PIR Task",
-        PIR_TASK_STACK_SIZE,
+    bool result;
+
+    result = hal_task_create(
+        wifiTask,
+        "Wifi Task",
+        WIFI_TASK_STACK_SIZE,
         NULL,
-        PIR_TASK_PRIORITY,
-        &pirTaskHandle,
-        PIR_CORE);
+        WIFI_TASK_PRIORITY,
+        &wifiTaskHandle,
+        WIFI_CORE);
 
-    if (result != pdPASS)
+    if (!result)
     {
-        ESP_LOGE(SCHEDULING_TAG, "Failed to create PIR Task");
+        ESP_LOGE(SCHEDULING_TAG, "Failed to create Network Task");
         return false;
     }
 
-    result = xTaskCreatePinnedToCore(
-        buzzerTask,
-        "Buzzer Task",
-        BUZZER_TASK_STACK_SIZE,
+    result = hal_task_create(
+        mqttTask,
+        "MQTT Task",
+        MQTT_TASK_STACK_SIZE,
         NULL,
-        BUZZER_TASK_PRIORITY,
-        &buzzerTaskHandle,
-        BUZZER_CORE);
+        MQTT_TASK_PRIORITY,
+        &mqttTaskHandle,
+        MQTT_CORE);
 
-    if (result != pdPASS)
+    if (!result)
     {
-        ESP_LOGE(SCHEDULING_TAG, "Failed to create Buzzer Task");
+        ESP_LOGE(SCHEDULING_TAG, "Failed to create MQTT Task");
         return false;
     }
 
-    result = xTaskCreatePinnedToCore(
-        fireSensorTask,
-        "Fire Sensor Task",
-        FIRE_SENSOR_TASK_STACK_SIZE,
+    result = hal_task_create(
+        powerTask,
+        "Power Task",
+        POWER_TASK_STACK_SIZE,
         NULL,
-        FIRE_SENSOR_TASK_PRIORITY,
-        &fireSensorTaskHandle,
-        FIRE_SENSOR_CORE);
+        POWER_TASK_PRIORITY,
+        &powerTaskHandle,
+        POWER_CORE);
 
-    if (result != pdPASS)
+    if (!result)
     {
-        ESP_LOGE(SCHEDULING_TAG, "Failed to create Fire Sensor Task");
+        ESP_LOGE(SCHEDULING_TAG, "Failed to create Power Task");
         return false;
     }
 
-    result = xTaskCreatePinnedToCore(
-        smokeDetectorTask,
-        "Smoke Detector Task",
-        SMOKE_DETECTOR_TASK_STACK_SIZE,
+    result = hal_task_create(
+        alarmTask,
+        "Alarm Task",
+        ALARM_TASK_STACK_SIZE,
+        NULL,
+        ALARM_TASK_PRIORITY,
+        &alarmTaskHandle,
+        ALARM_CORE);
+
+    if (!result)
+    {
+        ESP_LOGE(SCHEDULING_TAG, "Failed to create Alarm Task");
+        return false;
+    }
+    alarm_attach_task(alarmTaskHandle);
+
+    result = hal_task_create(
+        pirTask,
+        "PIR Task",
+        PIR_TASK_STACK_SIZE,
         NULL,
-        SMOKE_DETECTOR_TASK_PRIORITY,
-        &smokeDetectorTaskHandle,
-        SMOKE_DETECTOR_CORE);
+        PIR_TASK_PRIORITY,
+        &pirTaskHandle,
+        PIR_CORE);
 
-    if (result != pdPASS)
+    if (!result)
     {
-        ESP_LOGE(SCHEDULING_TAG, "Failed to create Smoke Detector Task");
+        ESP_LOGE(SCHEDULING_TAG, "Failed to create PIR Task");
         return false;
     }
 
-    result = xTaskCreatePinnedToCore(
+    result = hal_task_create(
         reedRelayTask,
         "Reed Relay Task",
         REED_RELAY_TASK_STACK_SIZE,
@@ -176,13 +198,13 @@ bool init_scheduling()
         &reedRelayTaskHandle,
         REED_RELAY_CORE);
         
-  if (result != pdPASS)
+  if (!result)
     {
-        ESP_LOGE(SCHEDULING_TAG, "Failed to create Smoke Detector Task");
+        ESP_LOGE(SCHEDULING_TAG, "Failed to create Reed Relay Task");
         return false;
     }
   
-  result = xTaskCreatePinnedToCore(           
+  result = hal_task_create(           
             tiltSensorTask,
             "Tilt Sensor Task",
             TILT_SENSOR_TASK_STACK_SIZE,
@@ -191,7 +213,7 @@ bool init_scheduling()
             &tiltSensorTaskHandle,
             TILT_SENSOR_CORE);
 
-        if (result != pdPASS)
+        if (!result)
         {
             ESP_LOGE(SCHEDULING_TAG, "Failed to create Tilt Sensor Task");
             return false;
@@ -207,8 +229,8 @@ void wifiTask(void *pvParameters)
 {
     while (1)
     {
-        // handle_wifi();
-        vTaskDelay(WIFI_RECONNECT_FREQ / portTICK_PERIOD_MS);
+        handle_wifi();
+        hal_delay_ms(WIFI_RECONNECT_FREQ);
     }
 }
 
@@ -216,44 +238,36 @@ void mqttTask(void *pvParameters)
 {
     while (1)
     {
-        // handle_mqtt();
-        vTaskDelay(MQTT_READ_FREQ / portTICK_PERIOD_MS);
+        handle_mqtt();
+        handle_journal();
+        hal_delay_ms(MQTT_READ_FREQ);
     }
 }
 
-void pirTask(void *pvParameters)
+void powerTask(void *pvParameters)
 {
     while (1)
     {
-        handle_pir();
-        vTaskDelay(PIR_READ_FREQ / portTICK_PERIOD_MS);
+        handle_power();
+        hal_delay_ms(power_poll_period_ms());
     }
 }
 
-void buzzerTask(void *pvParameters)
+void alarmTask(void *pvParameters)
 {
     while (1)
     {
-        handle_buzzer();
-        vTaskDelay(BUZZER_READ_FREQ / portTICK_PERIOD_MS);
+        hal_task_wait_notify(ALARM_IDLE_TIMEOUT);
+        handle_alarm();
     }
 }
 
-void fireSensorTask(void *pvParameters)
-{
-    while (1)
-    {
-        handle_fire_sensor();
-        vTaskDelay(FIRE_SENSOR_READ_FREQ / portTICK_PERIOD_MS);
-    }
-}
-
-void smokeDetectorTask(void *pvParameters)
+void pirTask(void *pvParameters)
 {
     while (1)
     {
-        // handle_smoke_detector();
-        vTaskDelay(SMOKE_DETECTOR_READ_FREQ / portTICK_PERIOD_MS);
+        handle_pir();
+        hal_delay_ms(PIR_READ_FREQ);
     }
 }
 
@@ -263,7 +277,7 @@ void reedRelayTask(void *pvParameters)
     while (1)
     {
         handle_reed_relay();
-        vTaskDelay(REED_RELAY_READ_FREQ / portTICK_PERIOD_MS);
+        hal_delay_ms(REED_RELAY_READ_FREQ);
     }
 }
 
@@ -272,6 +286,6 @@ void tiltSensorTask(void *pvParameters)
     while (1)
     {
         handle_tilt_sensor();
-        vTaskDelay(SMOKE_DETECTOR_READ_FREQ / portTICK_PERIOD_MS);
+        hal_delay_ms(TILT_SENSOR_READ_FREQ);
     }
 }
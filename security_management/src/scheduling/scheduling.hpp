@@ -1,55 +1,54 @@
 #pragma once
 
-#include <Arduino.h>
-#include "freertos/FreeRTOS.h"
-#include "freertos/task.h"
+#include "hal/hal.hpp"
 
+#include "../alarm/alarm.hpp"
+#include "../journal/journal.hpp"
+#include "../analog/analog.hpp"
+#include "../intrusion/intrusion.hpp"
 #include "../pir/pir.hpp"
 #include "../buzzer/buzzer.hpp"
 #include "../fire_sensor/fire_sensor.hpp"
 #include "../smoke_detector/smoke_detector.hpp"
 #include "../reed_relay/reed_relay.hpp"
 #include "../tilt_sensor/tilt_sensor.hpp"
+#include "../uplink/uplink.hpp"
+#include "../power/power.hpp"
 
 /* Task priorities */
 #define WIFI_TASK_PRIORITY 0
 #define MQTT_TASK_PRIORITY 1
 #define PIR_TASK_PRIORITY 2
-#define BUZZER_TASK_PRIORITY 3
-#define FIRE_SENSOR_TASK_PRIORITY 4
-#define SMOKE_DETECTOR_TASK_PRIORITY 5
 #define REED_RELAY_TASK_PRIORITY 6 // to be improved later (also core assignment)
 #define TILT_SENSOR_TASK_PRIORITY 6 // not sure if this is right priority
+#define POWER_TASK_PRIORITY 1
+#define ALARM_TASK_PRIORITY 7 // Highest, actuation latency is budgeted
 
 /* Core assignments */
 #define WIFI_CORE 0
 #define MQTT_CORE 0
 #define PIR_CORE 1
-#define BUZZER_CORE 0
-#define FIRE_SENSOR_CORE 1
-#define SMOKE_DETECTOR_CORE 1
 #define REED_RELAY_CORE 1 // to be improved later
 #define TILT_SENSOR_CORE 1 // not sure if this is right
+#define ALARM_CORE 0
+#define POWER_CORE 0
 
 /* Task stack size */
 #define WIFI_TASK_STACK_SIZE 4096
 #define MQTT_TASK_STACK_SIZE 4096
 #define PIR_TASK_STACK_SIZE 4096
-#define BUZZER_TASK_STACK_SIZE 2048
-#define FIRE_SENSOR_TASK_STACK_SIZE 2048
-#define SMOKE_DETECTOR_TASK_STACK_SIZE 2048
 #define REED_RELAY_TASK_STACK_SIZE 2048 // to be improved later
 #define TILT_SENSOR_TASK_STACK_SIZE 2048 
+#define ALARM_TASK_STACK_SIZE 2048
+#define POWER_TASK_STACK_SIZE 4096
 
 /* Event frequencies in ms */
 #define WIFI_RECONNECT_FREQ 1000
 #define MQTT_READ_FREQ 100
 #define PIR_READ_FREQ 100
-#define BUZZER_READ_FREQ 100
-#define FIRE_SENSOR_READ_FREQ 100
-#define SMOKE_DETECTOR_READ_FREQ 100
 #define REED_RELAY_READ_FREQ 100 // to be improved later
-#define TILT_SENSOR_READ_FREQ 100
+#define TILT_SENSOR_READ_FREQ 10 // Debounce slot of the tilt sensor, ten make a counting window
+#define ALARM_IDLE_TIMEOUT 1000 // Alarm task normally wakes on producer notifications
 
 /**
  * @brief Sets up the security system, initializes components, and starts scheduling.
@@ -100,47 +99,38 @@ void mqttTask(void *pvParameters);
 void pirTask(void *pvParameters);
 
 /**
- * @brief Task that handles buzzer.
- *
- * This task is responsible for handling the buzzer.
- *
- * @param pvParameters Task parameters
- */
-void buzzerTask(void *pvParameters);
-
-/**
- * @brief Task that handles fire sensor.
+ * @brief Task that handles reed relay.
  *
- * This task is responsible for handling the fire sensor.
+ * This task is responsible for handling the reed relay.
  *
  * @param pvParameters Task parameters
  */
-void fireSensorTask(void *pvParameters);
+void reedRelayTask(void *pvParameters);
 
 /**
- * @brief Task that handles smoke detector.
+ * @brief Task that handles tilt snesor.
  *
- * This task is responsible for handling the smoke detector.
+ * This task is responsible for handling the tilt sensor.
  *
  * @param pvParameters Task parameters
  */
-void smokeDetectorTask(void *pvParameters);
+void tiltSensorTask(void *pvParameters);
 
 /**
- * @brief Task that handles reed relay.
+ * @brief Task that handles the alarm manager.
  *
- * This task is responsible for handling the reed relay.
+ * This task sleeps until a producer posts an alarm event and then
+ * updates the buzzer.
  *
  * @param pvParameters Task parameters
  */
-void reedRelayTask(void *pvParameters);
+void alarmTask(void *pvParameters);
 
 /**
- * @brief Task that handles tilt snesor.
+ * @brief Task that handles power management.
  *
- * This task is responsible for handling the tilt sensor.
+ * This task puts the node to sleep when it is armed and idle.
  *
  * @param pvParameters Task parameters
  */
-void tiltSensorTask(void *pvParameters);
-
+void powerTask(void *pvParameters);
@@ -0,0 +1,133 @@
+#include "smoke_detector.hpp"
+#include "../analog/analog.hpp"
+#include "../alarm/alarm.hpp"
+
+#define SMOKE_PIN 35 // GPIO pin (ADC1) where the analog output of the MQ-2 sensor is connected
+#define SMOKE_TAG "smoke_detector"
+
+#define SMOKE_READ_PERIOD_MS 1000
+#define SMOKE_OVERSAMPLE 128   // Conversions averaged per reading
+#define SMOKE_WARMUP_MS 60000  // Heater warm-up, readings are unstable before
+
+#define SMOKE_RISE_WINDOW 10 // Readings, rate of rise is measured over 10 s
+
+/* Thresholds in raw ADC counts above the baseline */
+#define SMOKE_DELTA_ALARM 400 // Alarm regardless of the rate of rise
+#define SMOKE_DELTA_MIN 100   // Alarm if the level also rises quickly
+#define SMOKE_RISE_ALARM 150  // Rise over the window that counts as quick
+#define SMOKE_DELTA_CLEAR 80
+#define SMOKE_DRIFT_MAX 150 // Highest the baseline may drift above the clean air seen since warm-up
+
+#define SMOKE_LEVEL_SHIFT 2         // EWMA of the readings
+#define SMOKE_WARMUP_SHIFT 3        // Baseline follows quickly while warming up
+#define SMOKE_BASELINE_UP_SHIFT 8   // Slow upward drift, about 4 min
+#define SMOKE_BASELINE_DOWN_SHIFT 4 // Cleaner air is followed faster
+
+// Values in 1/16 ADC counts (Q4)
+static int32_t level = 0;
+static int32_t baseline = 0;
+static int32_t clean_air = 0; // Lowest baseline since the warm-up
+static int32_t history[SMOKE_RISE_WINDOW];
+static uint8_t history_index = 0;
+static bool primed = false;
+
+static uint32_t start_time = 0;
+static bool warmed_up = false;
+static bool alarm_raised = false;
+static int32_t last_rise = 0;
+
+static void process_reading(uint32_t value_q4, void *arg)
+{
+    int32_t value = (int32_t)value_q4;
+
+    if (!primed)
+    {
+        level = value;
+        baseline = value;
+        for (int i = 0; i < SMOKE_RISE_WINDOW; i++)
+        {
+            history[i] = value;
+        }
+        primed = true;
+    }
+
+    level += (value - level) >> SMOKE_LEVEL_SHIFT;
+    int32_t rise = level - history[history_index]; // Oldest entry of the window
+    history[history_index] = level;
+    history_index = (history_index + 1) % SMOKE_RISE_WINDOW;
+    last_rise = rise;
+
+    if (!warmed_up)
+    {
+        baseline += (level - baseline) >> SMOKE_WARMUP_SHIFT;
+        if (hal_millis() - start_time >= SMOKE_WARMUP_MS)
+        {
+            warmed_up = true;
+            clean_air = baseline;
+            ESP_LOGI(SMOKE_TAG, "Warm-up finished, baseline %ld", (long)(baseline >> 4));
+        }
+        return;
+    }
+
+    int32_t delta = (level - baseline) >> 4;
+    rise >>= 4;
+
+    if (!alarm_raised)
+    {
+        if (delta >= SMOKE_DELTA_ALARM || (delta >= SMOKE_DELTA_MIN && rise >= SMOKE_RISE_ALARM))
+        {
+            alarm_raised = true;
+            alarm_raise(ALARM_SOURCE_FIRE);
+            ESP_LOGI(SMOKE_TAG, "Smoke detected! (%ld above baseline, rising %ld)", (long)delta, (long)rise);
+            return;
+        }
+
+        // Drift compensation, frozen while the level moves away from the baseline
+        if (level < baseline)
+        {
+            baseline += (level - baseline) >> SMOKE_BASELINE_DOWN_SHIFT;
+            if (baseline < clean_air)
+            {
+                clean_air = baseline;
+            }
+        }
+        else if (delta < SMOKE_DELTA_MIN && rise < SMOKE_RISE_ALARM / 2)
+        {
+            // A smoulder rising slower than the drift compensation is not absorbed past the cap
+            baseline += (level - baseline) >> SMOKE_BASELINE_UP_SHIFT;
+            if (baseline > clean_air + (SMOKE_DRIFT_MAX << 4))
+            {
+                baseline = clean_air + (SMOKE_DRIFT_MAX << 4);
+            }
+        }
+    }
+    else if (delta < SMOKE_DELTA_CLEAR)
+    {
+        alarm_raised = false;
+        alarm_clear(ALARM_SOURCE_FIRE);
+        ESP_LOGI(SMOKE_TAG, "Smoke cleared");
+    }
+}
+
+bool init_smoke_detector()
+{
+    start_time = hal_millis();
+    warmed_up = false;
+    primed = false;
+
+    if (!analog_add_channel(SMOKE_PIN, SMOKE_READ_PERIOD_MS, SMOKE_OVERSAMPLE, process_reading, NULL))
+    {
+        return false;
+    }
+    ESP_LOGI(SMOKE_TAG, "Smoke detector initialized on GPIO %d, warming up", SMOKE_PIN);
+    return true;
+}
+
+void smoke_detector_get_status(SmokeStatus *status)
+{
+    status->warmed_up = warmed_up;
+    status->alarm = alarm_raised;
+    status->level = level >> 4;
+    status->baseline = baseline >> 4;
+    status->rise = last_rise >> 4;
+}
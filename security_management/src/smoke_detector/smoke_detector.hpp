@@ -0,0 +1,31 @@
+#pragma once
+
+#include "hal/hal.hpp"
+
+/// Current state of the smoke channel, levels in raw ADC counts.
+struct SmokeStatus
+{
+    bool warmed_up;    ///< Heater warm-up finished, alarms enabled.
+    bool alarm;        ///< Smoke alarm raised.
+    uint16_t level;    ///< Filtered sensor level.
+    uint16_t baseline; ///< Clean-air level, follows slow drift up to a cap above the cleanest air since warm-up.
+    int16_t rise;      ///< Level change over the rate-of-rise window.
+};
+
+/**
+ * @brief Initializes the smoke detector.
+ *
+ * Registers the MQ-2 output with the analog scheduler. The heater warm-up
+ * runs in the background: readings only train the baseline until it ends,
+ * boot is not delayed.
+ *
+ * @return true if initialization was successful, false otherwise.
+ */
+bool init_smoke_detector();
+
+/**
+ * @brief Copies the current state of the smoke channel.
+ *
+ * @param status (Output) Current state.
+ */
+void smoke_detector_get_status(SmokeStatus *status);
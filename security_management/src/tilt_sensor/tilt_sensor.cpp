@@ -1,26 +1,116 @@
 #include "tilt_sensor.hpp"
-#include "esp_log.h"
-#include "./buzzer/buzzer.hpp" // Include the buzzer module for further use
+#include "../alarm/alarm.hpp"
+#include "../intrusion/intrusion.hpp"
+#include "../journal/journal.hpp"
 
-#define LED_PIN 4            // Pin diody LED (może to być GPIO13, zależnie od płytki)
+#define TILT_TAG "app_tilt"
+
+#define LED_PIN 2            // Pin diody LED (wbudowana dioda na płytce)
 #define TILT_SENSOR_PIN 5        // Pin czujnika przechyłu (może być np. GPIO2)
+#define TILT_PCNT_UNIT 0
+#define TILT_FILTER_NS 10000 // Electrical glitches shorter than this are not counted (the filter stops at about 12 us)
+#define TILT_WINDOW_SLOTS 10 // Debounce slots (TILT_SENSOR_READ_FREQ) per counting window
+
+/*
+ * Contact bounce lasts milliseconds, far beyond the counter filter. A
+ * level change only counts once a whole slot passed without any edge,
+ * so the contact held it for 10 to 20 ms.
+ */
+
+/* Shaking thresholds on debounced edges, evaluated once per window */
+#define TILT_RATE_WINDOWS 10       // Windows summed for the edge rate, one second
+#define TILT_BURST_EDGES 4         // Edges within one window, two swings
+#define TILT_RATE_EDGES 8          // Edges within TILT_RATE_WINDOWS windows
+#define TILT_SHAKE_HOLDOFF_MS 2000 // Quiet time ending a shaking episode
+
+static int lastTiltState = HAL_LOW; // Last stable state reported to the alarm manager
+static int debounced_level = HAL_LOW;
+static uint8_t slot_index = 0;
+static uint32_t debounced_edges = 0; // In the current window
+static uint16_t window_edges[TILT_RATE_WINDOWS] = {0};
+static uint8_t window_index = 0;
+static uint32_t rate_edges = 0; // Sum of window_edges
+static bool shaking = false;
+static uint32_t last_shake_ms = 0;
+static uint32_t edges_total = 0;
+static uint32_t shakes_total = 0;
 
 bool init_tilt_sensor() {
-  pinMode(LED_PIN, OUTPUT);       // Ustawienie pinu diody jako wyjście
-  pinMode(TILT_SENSOR_PIN, INPUT);   // Ustawienie pinu czujnika przechyłu jako wejście
+  hal_gpio_mode(LED_PIN, HAL_OUTPUT);      // Ustawienie pinu diody jako wyjście
+  if (!hal_pcnt_attach(TILT_PCNT_UNIT, TILT_SENSOR_PIN, TILT_FILTER_NS)) { // Edges counted by hardware
+    ESP_LOGE(TILT_TAG, "Failed to attach pulse counter");
+    return false;
+  }
+  ESP_LOGI(TILT_TAG, "Tilt sensor initialized on GPIO %d", TILT_SENSOR_PIN);
   return true;
 }
 
-void handle_tilt_sensor() {
-    int titlState = digitalRead(TILT_SENSOR_PIN); 
-    delay(50); // Debounce - short delay  
-    int newState = digitalRead(TILT_SENSOR_PIN); 
-  
-    if (titlState == newState) { // only stabile states are considered
-        if (titlState == HIGH) {
-            digitalWrite(LED_PIN, HIGH);
-        } else {
-    digitalWrite(LED_PIN, LOW);
+static void handle_level(int level) {
+    if (level == lastTiltState) {
+        return;
+    }
+    lastTiltState = level;
+    if (level == HAL_HIGH) {
+        hal_gpio_write(LED_PIN, HAL_HIGH);
+        alarm_raise(ALARM_SOURCE_TAMPER);
+        journal_record(JOURNAL_EVENT_TILT_ON, 0);
+        intrusion_report(INTRUSION_EVENT_TILT, 0);
+    } else {
+        hal_gpio_write(LED_PIN, HAL_LOW);
+        alarm_clear(ALARM_SOURCE_TAMPER);
+        journal_record(JOURNAL_EVENT_TILT_OFF, 0);
+    }
+}
+
+static void handle_shaking(uint32_t edges) {
+    uint32_t now = hal_millis();
+    if (edges >= TILT_BURST_EDGES || rate_edges >= TILT_RATE_EDGES) {
+        last_shake_ms = now;
+        if (!shaking) {
+            shaking = true;
+            shakes_total++;
+            ESP_LOGI(TILT_TAG, "Shaking detected, %lu edges in the last window, %lu in the last %d windows",
+                     (unsigned long)edges, (unsigned long)rate_edges, TILT_RATE_WINDOWS);
+            // Momentary, the tamper alarm latches until acknowledged
+            alarm_raise(ALARM_SOURCE_TAMPER);
+            alarm_clear(ALARM_SOURCE_TAMPER);
+            journal_record(JOURNAL_EVENT_TILT_ON, 1);
+            intrusion_report(INTRUSION_EVENT_TILT, 0);
         }
+    } else if (shaking && now - last_shake_ms >= TILT_SHAKE_HOLDOFF_MS) {
+        shaking = false;
+        ESP_LOGI(TILT_TAG, "Shaking ended");
     }
-} 
\ No newline at end of file
+}
+
+void handle_tilt_sensor() {
+    uint32_t raw_edges = hal_pcnt_take(TILT_PCNT_UNIT);
+    int level = hal_gpio_read(TILT_SENSOR_PIN);
+    edges_total += raw_edges;
+
+    if (raw_edges == 0 && level != debounced_level) { // Held for a whole slot, the bounce is over
+        debounced_level = level;
+        debounced_edges++;
+    }
+    if (++slot_index < TILT_WINDOW_SLOTS) {
+        return;
+    }
+    slot_index = 0;
+    uint32_t edges = debounced_edges;
+    debounced_edges = 0;
+
+    rate_edges -= window_edges[window_index];
+    window_edges[window_index] = edges > UINT16_MAX ? UINT16_MAX : edges;
+    rate_edges += window_edges[window_index];
+    window_index = (window_index + 1) % TILT_RATE_WINDOWS;
+
+    if (edges == 0) { // Only levels stable for a whole window are considered
+        handle_level(debounced_level);
+    }
+    handle_shaking(edges);
+}
+
+void tilt_sensor_get_stats(uint32_t *edges, uint32_t *shakes) {
+    *edges = edges_total;
+    *shakes = shakes_total;
+}
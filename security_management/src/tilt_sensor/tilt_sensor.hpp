@@ -1,15 +1,32 @@
 #pragma once 
 
-#include <Arduino.h>
+#include "hal/hal.hpp"
 
 /**
  * @brief Initializes the sensor.
+ *
+ * Edges of the tilt switch are counted by the pulse counter, so vibration
+ * is seen without any CPU time per edge.
+ *
  * @return true if initialization was successful, false otherwise.
  */
 bool init_tilt_sensor();
 
 /**
- * @brief Handles the sensor. - specyfy what does the system do when the sensor detects a tilt
- * This function should be called periodically to manage the buzzer's state.
+ * @brief Handles the sensor, called once per debounce slot (TILT_SENSOR_READ_FREQ).
+ *
+ * Edges count once the contact held its level for a whole slot, contact
+ * bounce does not. Every ten slots (a counting window), a level stable
+ * for the whole window raises or clears the tamper alarm, and bursts of
+ * edges, within one window or over the last second, are reported as
+ * shaking. Never blocks.
  */
-void handle_tilt_sensor();
\ No newline at end of file
+void handle_tilt_sensor();
+
+/**
+ * @brief Returns the number of edges counted and shaking episodes detected.
+ *
+ * @param edges (Output) Edges seen by the counter since boot, contact bounce included.
+ * @param shakes (Output) Shaking episodes since boot.
+ */
+void tilt_sensor_get_stats(uint32_t *edges, uint32_t *shakes);
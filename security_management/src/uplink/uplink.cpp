@@ -0,0 +1,271 @@
+#include <string.h>
+#include "uplink.hpp"
+
+#define UPLINK_TAG "app_uplink"
+
+#if defined(ARDUINO)
+
+#include "network/wifi/wifi.hpp"
+#include "network/mqtt/mqtt.hpp"
+#include "network/access_point/access_point.hpp"
+
+#define UPLINK_AP_SSID "ESP32_Config"
+#define UPLINK_AP_PASSWORD "config123"
+
+static WiFiManager wifiManager;
+static MqttManager mqttManager;
+static volatile bool resume_pending = false;
+static volatile bool provisioning = false; // Portal running until WiFi and MQTT settings are saved
+
+bool init_uplink()
+{
+    // No button on this node: the portal starts at boot while nothing is configured
+    if (!WiFiCredentialsStore().isConfigured())
+    {
+        ESP_LOGW(UPLINK_TAG, "Not configured, starting the configuration portal %s", UPLINK_AP_SSID);
+        AccessPoint::startAPTask(UPLINK_AP_SSID, UPLINK_AP_PASSWORD);
+        provisioning = true;
+        return true;
+    }
+    wifiManager.begin();
+    mqttManager.begin();
+    return true;
+}
+
+void handle_wifi()
+{
+    if (provisioning)
+    {
+        if (!WiFiCredentialsStore().isConfigured())
+        {
+            return;
+        }
+        if (AccessPoint::isAPActive())
+        {
+            AccessPoint::requestAPExit(); // Settings saved from the portal
+            return;
+        }
+        ESP_LOGI(UPLINK_TAG, "Configured, leaving the configuration portal");
+        provisioning = false;
+        resume_pending = true;
+        wifiManager.begin(); // First start, init_uplink() skipped it
+    }
+    wifiManager.handle();
+}
+
+void handle_mqtt()
+{
+    if (provisioning)
+    {
+        return; // No broker yet
+    }
+    // After a wake-up or the portal connect as soon as WiFi is back instead of waiting for the retry delay
+    if (resume_pending && WiFi.status() == WL_CONNECTED)
+    {
+        resume_pending = false;
+        mqttManager.begin();
+    }
+    mqttManager.handle();
+}
+
+bool uplink_publish(const char *topic, const char *value)
+{
+    return mqttManager.publishMessage(topic, MqttManager::encodeValue(value));
+}
+
+void uplink_subscribe(const char *topic, uplink_message_cb_t callback)
+{
+    mqttManager.registerHandler(topic, [callback](const char *, const char *payload, size_t)
+                                { callback(payload); });
+}
+
+bool uplink_is_connected()
+{
+    return mqttManager.isConnected();
+}
+
+void uplink_suspend()
+{
+    mqttManager.disconnect();
+    wifiManager.stop();
+}
+
+void uplink_resume()
+{
+    resume_pending = true;
+    wifiManager.resume(); // Event handler stays registered from begin()
+}
+
+#elif defined(HAL_LINUX)
+
+/*
+ * Host fake: always configured, reconnecting after a wake-up takes
+ * UPLINK_FAKE_CONNECT_MS so wake-to-publish latency can be modelled.
+ */
+
+#define UPLINK_MAX_SUBSCRIPTIONS 4
+
+struct Subscription
+{
+    const char *topic;
+    uplink_message_cb_t callback;
+};
+
+static Subscription subscriptions[UPLINK_MAX_SUBSCRIPTIONS];
+static int subscription_count = 0;
+static bool connected = false;
+static uint32_t connect_time = 0;
+static uplink_fake_publish_hook_t publish_hook = NULL;
+static void *publish_hook_ctx = NULL;
+
+bool init_uplink()
+{
+    connected = true;
+    return true;
+}
+
+void handle_wifi()
+{
+}
+
+void handle_mqtt()
+{
+}
+
+bool uplink_publish(const char *topic, const char *value)
+{
+    if (!uplink_is_connected())
+    {
+        ESP_LOGW(UPLINK_TAG, "Not connected, cannot publish to %s", topic);
+        return false;
+    }
+    ESP_LOGI(UPLINK_TAG, "Published to %s: %s", topic, value);
+    if (publish_hook != NULL)
+    {
+        publish_hook(topic, value, publish_hook_ctx);
+    }
+    return true;
+}
+
+void uplink_subscribe(const char *topic, uplink_message_cb_t callback)
+{
+    if (subscription_count < UPLINK_MAX_SUBSCRIPTIONS)
+    {
+        subscriptions[subscription_count].topic = topic;
+        subscriptions[subscription_count].callback = callback;
+        subscription_count++;
+    }
+}
+
+bool uplink_is_connected()
+{
+    return connected && hal_millis() >= connect_time;
+}
+
+void uplink_suspend()
+{
+    connected = false;
+}
+
+void uplink_resume()
+{
+    connected = true;
+    connect_time = hal_millis() + UPLINK_FAKE_CONNECT_MS;
+}
+
+void uplink_fake_set_publish_hook(uplink_fake_publish_hook_t hook, void *ctx)
+{
+    publish_hook = hook;
+    publish_hook_ctx = ctx;
+}
+
+void uplink_fake_deliver(const char *topic, const char *payload)
+{
+    if (!uplink_is_connected())
+    {
+        ESP_LOGW(UPLINK_TAG, "Not connected, message to %s lost", topic);
+        return;
+    }
+    for (int i = 0; i < subscription_count; i++)
+    {
+        if (strcmp(subscriptions[i].topic, topic) == 0)
+        {
+            subscriptions[i].callback(payload);
+        }
+    }
+}
+
+#endif
+
+/* Copies the value of a payload, raw or the "value" field of {"value": "1"}, without quotes and blanks */
+static bool decode_value(const char *payload, char *value, size_t size)
+{
+    const char *start = payload + strspn(payload, " \t\r\n");
+    const char *end = NULL;
+    if (*start == '{')
+    {
+        start = strstr(start, "\"value\"");
+        if (start == NULL)
+        {
+            return false;
+        }
+        start += strlen("\"value\"");
+        start += strspn(start, " \t\r\n");
+        if (*start != ':')
+        {
+            return false;
+        }
+        start++;
+        start += strspn(start, " \t\r\n");
+        if (*start == '"')
+        {
+            start++;
+            end = strchr(start, '"');
+        }
+        else
+        {
+            end = start + strcspn(start, " \t\r\n,}");
+        }
+        if (end == NULL)
+        {
+            return false;
+        }
+    }
+    else
+    {
+        end = start + strlen(start);
+        while (end > start && strchr(" \t\r\n", end[-1]) != NULL)
+        {
+            end--;
+        }
+    }
+
+    size_t length = end - start;
+    if (length >= size)
+    {
+        return false;
+    }
+    memcpy(value, start, length);
+    value[length] = '\0';
+    return true;
+}
+
+bool uplink_parse_flag(const char *payload, bool *flag)
+{
+    char value[8];
+    if (!decode_value(payload, value, sizeof(value)))
+    {
+        return false;
+    }
+    if (strcmp(value, "1") == 0 || strcmp(value, "true") == 0)
+    {
+        *flag = true;
+        return true;
+    }
+    if (strcmp(value, "0") == 0 || strcmp(value, "false") == 0)
+    {
+        *flag = false;
+        return true;
+    }
+    return false;
+}
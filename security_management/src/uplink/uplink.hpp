@@ -0,0 +1,104 @@
+#pragma once
+
+#include "hal/hal.hpp"
+
+/* MQTT topics of the security node */
+#define TOPIC_ARM "smarthome/security/arm"                 // "1" arms, "0" disarms
+#define TOPIC_ALARM_ACK "smarthome/security/alarm/ack"     // "1" acknowledges latched alarms
+#define TOPIC_WAKE_EVENT "smarthome/security/wake/data"    // GPIO that woke the node from sleep
+#define TOPIC_JOURNAL "smarthome/security/journal/data"    // Journaled events, "boot,time_ms,event,arg;" each
+
+/// Called with the payload of a message received on a subscribed topic.
+typedef void (*uplink_message_cb_t)(const char *payload);
+
+/**
+ * @brief Initializes the WiFi and MQTT connection.
+ *
+ * A missing connection is not an error, handle_wifi() and handle_mqtt()
+ * keep retrying.
+ *
+ * @return true if initialization was successful, false otherwise.
+ */
+bool init_uplink();
+
+/**
+ * @brief Maintains the WiFi connection, called periodically.
+ */
+void handle_wifi();
+
+/**
+ * @brief Maintains the MQTT connection and dispatches messages, called periodically.
+ */
+void handle_mqtt();
+
+/**
+ * @brief Publishes a value on a topic in the configured encoding.
+ *
+ * @param topic MQTT topic.
+ * @param value Value to publish.
+ * @return true if the message was sent, false if not connected.
+ */
+bool uplink_publish(const char *topic, const char *value);
+
+/**
+ * @brief Subscribes to a topic, also after reconnections.
+ *
+ * @param topic MQTT topic.
+ * @param callback Function receiving the payloads.
+ */
+void uplink_subscribe(const char *topic, uplink_message_cb_t callback);
+
+/**
+ * @brief Checks if messages can be published.
+ *
+ * @return true if connected to the broker, false otherwise.
+ */
+bool uplink_is_connected();
+
+/**
+ * @brief Disconnects and turns the radio off before sleeping.
+ */
+void uplink_suspend();
+
+/**
+ * @brief Starts connecting again after a wake-up.
+ */
+void uplink_resume();
+
+/**
+ * @brief Decodes a flag received on a topic, raw or in the JSON encoding {"value": "1"}.
+ *
+ * The whole value has to match: "1" and "true" are set, "0" and "false"
+ * cleared, anything else ("10", "0.1", ...) is rejected.
+ *
+ * @param payload Message payload.
+ * @param flag (Output) Decoded flag.
+ * @return true if the payload is a flag, false otherwise.
+ */
+bool uplink_parse_flag(const char *payload, bool *flag);
+
+#if defined(HAL_LINUX)
+#define UPLINK_FAKE_CONNECT_MS 1500 // Reconnecting after a wake-up on the host
+
+/// Called on every message published by the host fake.
+typedef void (*uplink_fake_publish_hook_t)(const char *topic, const char *value, void *ctx);
+
+/**
+ * @brief Installs a hook observing published messages (NULL to remove it).
+ *
+ * @param hook Function called on every publish.
+ * @param ctx Argument passed to the hook.
+ */
+void uplink_fake_set_publish_hook(uplink_fake_publish_hook_t hook, void *ctx);
+
+/**
+ * @brief Delivers a message as if it came from the broker.
+ *
+ * Lost while the node is not connected (asleep or still reconnecting),
+ * like a message that is not retained by the broker.
+ *
+ * @param topic MQTT topic.
+ * @param payload Message payload.
+ */
+void uplink_fake_deliver(const char *topic, const char *payload);
+#endif
@@ -0,0 +1,148 @@
+/*
+ * Alarm manager with the queue overflowing: no alarm task is attached,
+ * events pile up until handle_alarm() is called from the test.
+ */
+
+#include <unity.h>
+#include "hal/hal.hpp"
+#include "alarm/alarm.hpp"
+#include "buzzer/buzzer.hpp"
+#include "journal/journal.hpp"
+
+#define QUEUE_OVERFLOW 40 // More events than the 32-entry queue holds
+#define PRODUCERS 4
+#define PRODUCER_PAIRS 2000
+
+static volatile int producers_done = 0;
+
+static void fill_queue()
+{
+    for (int i = 0; i < QUEUE_OVERFLOW; i++)
+    {
+        alarm_pulse(ALARM_SOURCE_CHIME);
+    }
+}
+
+static void fire_producer(void *)
+{
+    for (int i = 0; i < PRODUCER_PAIRS; i++)
+    {
+        alarm_raise(ALARM_SOURCE_FIRE);
+        alarm_clear(ALARM_SOURCE_FIRE);
+    }
+    __atomic_add_fetch(&producers_done, 1, __ATOMIC_SEQ_CST);
+}
+
+void setUp()
+{
+    handle_alarm(); // Drain what the previous test left
+    buzzer_stop_all();
+    init_alarm();
+}
+
+void tearDown()
+{
+}
+
+static void test_raise_survives_full_queue()
+{
+    fill_queue();
+    TEST_ASSERT_FALSE(alarm_raise(ALARM_SOURCE_FIRE));
+    handle_alarm();
+    TEST_ASSERT_EQUAL_INT(ALARM_SOURCE_FIRE, alarm_active_source());
+
+    AlarmStats stats;
+    alarm_get_stats(&stats);
+    TEST_ASSERT_GREATER_OR_EQUAL_UINT32(QUEUE_OVERFLOW - 32 + 1, stats.dropped);
+}
+
+static void test_lost_clear_and_ack_do_not_stick()
+{
+    alarm_raise(ALARM_SOURCE_INTRUSION);
+    handle_alarm();
+    TEST_ASSERT_EQUAL_INT(ALARM_SOURCE_INTRUSION, alarm_active_source());
+
+    fill_queue();
+    TEST_ASSERT_FALSE(alarm_clear(ALARM_SOURCE_INTRUSION));
+    TEST_ASSERT_FALSE(alarm_acknowledge());
+    handle_alarm();
+    TEST_ASSERT_EQUAL_INT(ALARM_SOURCE_NONE, alarm_active_source());
+}
+
+static void test_latch_survives_full_queue()
+{
+    // Momentary raise of a latching source, both events lost
+    fill_queue();
+    alarm_raise(ALARM_SOURCE_TAMPER);
+    alarm_clear(ALARM_SOURCE_TAMPER);
+    handle_alarm();
+    TEST_ASSERT_EQUAL_INT(ALARM_SOURCE_TAMPER, alarm_active_source());
+
+    alarm_acknowledge();
+    handle_alarm();
+    TEST_ASSERT_EQUAL_INT(ALARM_SOURCE_NONE, alarm_active_source());
+}
+
+static void test_events_apply_in_order()
+{
+    // Raised after the acknowledge: stays latched
+    alarm_acknowledge();
+    alarm_raise(ALARM_SOURCE_INTRUSION);
+    alarm_clear(ALARM_SOURCE_INTRUSION);
+    handle_alarm();
+    TEST_ASSERT_EQUAL_INT(ALARM_SOURCE_INTRUSION, alarm_active_source());
+
+    // Raised before the acknowledge: acknowledged
+    alarm_raise(ALARM_SOURCE_TAMPER);
+    alarm_clear(ALARM_SOURCE_TAMPER);
+    alarm_acknowledge();
+    handle_alarm();
+    TEST_ASSERT_EQUAL_INT(ALARM_SOURCE_NONE, alarm_active_source());
+}
+
+static void test_unbalanced_clear_ignored()
+{
+    TEST_ASSERT_TRUE(alarm_clear(ALARM_SOURCE_FIRE));
+    alarm_raise(ALARM_SOURCE_FIRE);
+    handle_alarm();
+    TEST_ASSERT_EQUAL_INT(ALARM_SOURCE_FIRE, alarm_active_source());
+
+    alarm_clear(ALARM_SOURCE_FIRE);
+    alarm_acknowledge();
+    handle_alarm();
+    TEST_ASSERT_EQUAL_INT(ALARM_SOURCE_NONE, alarm_active_source());
+}
+
+static void test_concurrent_producers()
+{
+    producers_done = 0;
+    for (int i = 0; i < PRODUCERS; i++)
+    {
+        TEST_ASSERT_TRUE(hal_task_create(fire_producer, "producer", 2048, NULL, 1, NULL, i % 2));
+    }
+    while (__atomic_load_n(&producers_done, __ATOMIC_SEQ_CST) < PRODUCERS)
+    {
+        handle_alarm(); // Consumes while the producers overflow the queue
+    }
+    handle_alarm();
+    TEST_ASSERT_EQUAL_INT(ALARM_SOURCE_FIRE, alarm_active_source()); // Latched, every producer cleared
+
+    alarm_acknowledge();
+    handle_alarm();
+    TEST_ASSERT_EQUAL_INT(ALARM_SOURCE_NONE, alarm_active_source());
+}
+
+int main()
+{
+    init_journal();
+    init_buzzer();
+
+    UNITY_BEGIN();
+    RUN_TEST(test_raise_survives_full_queue);
+    RUN_TEST(test_lost_clear_and_ack_do_not_stick);
+    RUN_TEST(test_latch_survives_full_queue);
+    RUN_TEST(test_events_apply_in_order);
+    RUN_TEST(test_unbalanced_clear_ignored);
+    RUN_TEST(test_concurrent_producers);
+    return UNITY_END();
+}
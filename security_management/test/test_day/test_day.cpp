@@ -0,0 +1,352 @@
+/*
+ * A day of the security node in virtual time: the whole node runs on the
+ * simulated HAL while scripted sensor edges, analog levels and MQTT
+ * messages replay a day at home. The alarm state is sampled at fixed
+ * times and every message the node publishes is recorded with its time.
+ */
+
+#include <unity.h>
+#include <string.h>
+#include <string>
+#include <vector>
+#include "hal/hal.hpp"
+#include "hal/linux/hal_fake.hpp"
+#include "hal/linux/hal_sim.hpp"
+#include "scheduling/scheduling.hpp"
+
+#define AT(h, m, s) ((((uint64_t)(h) * 60 + (m)) * 60 + (s)) * 1000000ULL)
+#define MS(time_us) ((uint32_t)((time_us) / 1000))
+
+/* Inputs, see pir.cpp, reed_relay.cpp, fire_sensor.cpp and smoke_detector.cpp */
+#define PIR_LIVING 13
+#define PIR_HALL 14
+#define REED_KITCHEN 26
+#define REED_BEDROOM 25
+#define REED_HALL 33
+#define FIRE_PIN 34
+#define SMOKE_PIN 35
+
+#define FIRE_AMBIENT 300   // Flame sensor in daylight, no flicker
+#define SMOKE_CLEAN 900    // MQ-2 in clean air
+#define SMOKE_PEAK 1700    // Kitchen smoke at its worst
+
+#define WAKE_PUBLISH_MS 2500 // Reconnecting takes UPLINK_FAKE_CONNECT_MS on the host
+
+/* Smoke in the kitchen in the evening: rises over a minute, held, falls over five */
+#define SMOKE_START AT(19, 30, 0)
+#define SMOKE_HELD AT(19, 31, 0)
+#define SMOKE_FALLING AT(19, 40, 0)
+#define SMOKE_END AT(19, 45, 0)
+
+static const HalSimEdge day_edges[] = {
+    // Morning, disarmed: kitchen window aired for ten minutes, then breakfast
+    {AT(7, 0, 0), REED_KITCHEN, HAL_LOW},
+    {AT(7, 10, 0), REED_KITCHEN, HAL_HIGH},
+    {AT(7, 20, 0), PIR_LIVING, HAL_HIGH},
+    {AT(7, 20, 3), PIR_LIVING, HAL_LOW},
+    // Armed and away: the cat crosses the hall once
+    {AT(11, 0, 0), PIR_HALL, HAL_HIGH},
+    {AT(11, 0, 2), PIR_HALL, HAL_LOW},
+    // Break-in through the bedroom window, then moving through the hall
+    {AT(14, 0, 0), REED_BEDROOM, HAL_LOW},
+    {AT(14, 0, 6), PIR_HALL, HAL_HIGH},
+    {AT(14, 0, 9), PIR_HALL, HAL_LOW},
+    {AT(14, 10, 0), REED_BEDROOM, HAL_HIGH},
+    // Back home: the hall door wakes the node, which is then disarmed
+    {AT(17, 59, 0), REED_HALL, HAL_LOW},
+    {AT(17, 59, 5), REED_HALL, HAL_HIGH},
+    // Disarmed, walking from the living room to the hall: an incident, but no alarm
+    {AT(18, 30, 0), PIR_LIVING, HAL_HIGH},
+    {AT(18, 30, 3), PIR_LIVING, HAL_LOW},
+    {AT(18, 30, 11), PIR_HALL, HAL_HIGH},
+    {AT(18, 30, 14), PIR_HALL, HAL_LOW},
+};
+
+struct Message
+{
+    uint64_t time_us;
+    const char *topic;
+    const char *payload;
+};
+
+static const Message messages[] = {
+    {AT(8, 0, 0), TOPIC_ARM, "{\"value\": \"1\"}"},
+    {AT(12, 0, 0), TOPIC_ARM, "{\"value\": \"0\"}"}, // Asleep with the radio off, lost
+    {AT(14, 15, 0), TOPIC_ALARM_ACK, "{\"value\": \"0\"}"}, // Not an acknowledge
+    {AT(14, 15, 1), TOPIC_ALARM_ACK, "10"},                   // Neither are these
+    {AT(14, 15, 2), TOPIC_ALARM_ACK, "-1"},
+    {AT(14, 15, 3), TOPIC_ALARM_ACK, "0.1"},
+    {AT(14, 15, 4), TOPIC_ALARM_ACK, "{\"value\":\"0\",\"id\":1}"},
+    {AT(14, 30, 0), TOPIC_ALARM_ACK, "{\"value\": \"1\"}"},
+    {AT(17, 59, 10), TOPIC_ARM, "{\"value\": \"0\"}"},
+    {AT(18, 45, 0), TOPIC_ARM, "10"}, // Malformed, the node stays disarmed
+    {AT(18, 45, 1), TOPIC_ARM, "-1"},
+    {AT(18, 45, 2), TOPIC_ARM, "{\"value\": \"0.1\"}"},
+    {AT(20, 0, 0), TOPIC_ALARM_ACK, "{\"value\": \"1\"}"},
+};
+
+/// Expected most severe alarm source at a time.
+struct Checkpoint
+{
+    uint64_t time_us;
+    AlarmSource expected;
+    AlarmSource seen;
+};
+
+static Checkpoint checkpoints[] = {
+    {AT(6, 0, 0), ALARM_SOURCE_NONE, ALARM_SOURCE_NONE},
+    {AT(7, 30, 0), ALARM_SOURCE_NONE, ALARM_SOURCE_NONE},
+    {AT(11, 5, 0), ALARM_SOURCE_NONE, ALARM_SOURCE_NONE},
+    {AT(14, 0, 7), ALARM_SOURCE_INTRUSION, ALARM_SOURCE_NONE},
+    {AT(14, 20, 0), ALARM_SOURCE_INTRUSION, ALARM_SOURCE_NONE}, // Latched after the window closed
+    {AT(14, 31, 0), ALARM_SOURCE_NONE, ALARM_SOURCE_NONE},
+    {AT(18, 30, 12), ALARM_SOURCE_NONE, ALARM_SOURCE_NONE}, // Walk-through while disarmed
+    {AT(18, 31, 0), ALARM_SOURCE_NONE, ALARM_SOURCE_NONE},
+    {AT(19, 35, 0), ALARM_SOURCE_FIRE, ALARM_SOURCE_NONE},
+    {AT(19, 50, 0), ALARM_SOURCE_FIRE, ALARM_SOURCE_NONE}, // Latched after the smoke cleared
+    {AT(20, 1, 0), ALARM_SOURCE_NONE, ALARM_SOURCE_NONE},
+    {AT(23, 59, 0), ALARM_SOURCE_NONE, ALARM_SOURCE_NONE},
+};
+#define CHECKPOINTS (sizeof(checkpoints) / sizeof(checkpoints[0]))
+
+struct Published
+{
+    uint32_t time_ms;
+    std::string topic;
+    std::string value;
+};
+
+static std::vector<Published> published;
+
+/// Journal entry as published on TOPIC_JOURNAL.
+struct JournalLine
+{
+    uint32_t published_ms;
+    uint32_t time_ms;
+    std::string event;
+    unsigned arg;
+};
+
+static void on_publish(const char *topic, const char *value, void *)
+{
+    published.push_back({MS(hal_sim_now_us()), topic, value});
+}
+
+static void deliver(void *ctx)
+{
+    const Message *message = (const Message *)ctx;
+    uplink_fake_deliver(message->topic, message->payload);
+}
+
+static void sample_alarm(void *ctx)
+{
+    Checkpoint *checkpoint = (Checkpoint *)ctx;
+    checkpoint->seen = alarm_active_source();
+}
+
+static uint16_t smoke_stream(void *, uint64_t time_us)
+{
+    if (time_us < SMOKE_START || time_us >= SMOKE_END)
+    {
+        return SMOKE_CLEAN;
+    }
+    if (time_us < SMOKE_HELD)
+    {
+        return SMOKE_CLEAN + (SMOKE_PEAK - SMOKE_CLEAN) * (time_us - SMOKE_START) / (SMOKE_HELD - SMOKE_START);
+    }
+    if (time_us < SMOKE_FALLING)
+    {
+        return SMOKE_PEAK;
+    }
+    return SMOKE_PEAK - (SMOKE_PEAK - SMOKE_CLEAN) * (time_us - SMOKE_FALLING) / (SMOKE_END - SMOKE_FALLING);
+}
+
+/* Entries published on TOPIC_JOURNAL, in publishing order */
+static std::vector<JournalLine> journal_lines()
+{
+    std::vector<JournalLine> lines;
+    for (const Published &message : published)
+    {
+        if (message.topic != TOPIC_JOURNAL)
+        {
+            continue;
+        }
+        const char *entry = message.value.c_str();
+        unsigned boot, arg;
+        unsigned long time_ms;
+        char event[16];
+        int length;
+        while (sscanf(entry, "%u,%lu,%15[^,],%u;%n", &boot, &time_ms, event, &arg, &length) == 4)
+        {
+            lines.push_back({message.time_ms, (uint32_t)time_ms, event, arg});
+            entry += length;
+        }
+    }
+    return lines;
+}
+
+static const JournalLine *find_entry(const std::vector<JournalLine> &lines, const char *event, uint64_t after_us)
+{
+    for (const JournalLine &line : lines)
+    {
+        if (line.event == event && line.time_ms >= MS(after_us))
+        {
+            return &line;
+        }
+    }
+    return NULL;
+}
+
+void setUp()
+{
+}
+
+void tearDown()
+{
+}
+
+static void test_alarm_timeline()
+{
+    for (size_t i = 0; i < CHECKPOINTS; i++)
+    {
+        char message[48];
+        snprintf(message, sizeof(message), "checkpoint at %lu s", (unsigned long)(checkpoints[i].time_us / 1000000));
+        TEST_ASSERT_EQUAL_INT_MESSAGE(checkpoints[i].expected, checkpoints[i].seen, message);
+    }
+}
+
+static void test_journal_timeline()
+{
+    std::vector<JournalLine> lines = journal_lines();
+
+    // Expected events in order, each no earlier than the scripted cause
+    struct Expected
+    {
+        const char *event;
+        uint64_t after_us;
+        unsigned arg;
+    };
+    static const Expected expected[] = {
+        {"boot", 0, 0},
+        {"open", AT(7, 0, 0), 0},
+        {"close", AT(7, 10, 0), 0},
+        {"motion_start", AT(7, 20, 0), 0},
+        {"armed", AT(8, 0, 0), 0},
+        {"motion_start", AT(11, 0, 0), 2},
+        {"open", AT(14, 0, 0), 1},
+        {"motion_start", AT(14, 0, 6), 2},
+        {"alarm_on", AT(14, 0, 6), ALARM_SOURCE_INTRUSION}, // The alarm task preempts the PIR task
+        {"incident", AT(14, 0, 6), 5},
+        {"alarm_ack", AT(14, 30, 0), 0},
+        {"alarm_off", AT(14, 30, 0), ALARM_SOURCE_INTRUSION},
+        {"open", AT(17, 59, 0), 2},
+        {"disarmed", AT(17, 59, 10), 0},
+        {"motion_start", AT(18, 30, 11), 2},
+        {"alarm_on", SMOKE_START, ALARM_SOURCE_FIRE},
+        {"alarm_ack", AT(20, 0, 0), 0},
+        {"alarm_off", AT(20, 0, 0), ALARM_SOURCE_FIRE},
+    };
+
+    size_t next = 0;
+    for (const JournalLine &line : lines)
+    {
+        if (next < sizeof(expected) / sizeof(expected[0]) && line.event == expected[next].event &&
+            line.time_ms >= MS(expected[next].after_us) && line.arg == expected[next].arg)
+        {
+            next++;
+        }
+    }
+    char message[64];
+    snprintf(message, sizeof(message), "missing %s", next < sizeof(expected) / sizeof(expected[0]) ? expected[next].event : "-");
+    TEST_ASSERT_EQUAL_UINT_MESSAGE(sizeof(expected) / sizeof(expected[0]), next, message);
+
+    // One incident, the cat, the walk-through while disarmed and the kitchen smoke do not make one
+    TEST_ASSERT_NULL(find_entry(lines, "incident", AT(15, 0, 0)));
+    const JournalLine *evening_alarm = find_entry(lines, "alarm_on", AT(15, 0, 0));
+    TEST_ASSERT_NOT_NULL(evening_alarm);
+    TEST_ASSERT_EQUAL_UINT(ALARM_SOURCE_FIRE, evening_alarm->arg);
+    const JournalLine *incident = find_entry(lines, "incident", 0);
+    TEST_ASSERT_NOT_NULL(incident);
+    TEST_ASSERT_UINT32_WITHIN(PIR_READ_FREQ, MS(AT(14, 0, 6)), incident->time_ms);
+}
+
+static void test_publish_timeline()
+{
+    // Every journal entry is published, the ones recorded while asleep after the wake-up
+    std::vector<JournalLine> lines = journal_lines();
+    for (const JournalLine &line : lines)
+    {
+        TEST_ASSERT_GREATER_OR_EQUAL_UINT32(line.time_ms, line.published_ms);
+    }
+    const JournalLine *morning = find_entry(lines, "open", AT(7, 0, 0));
+    TEST_ASSERT_NOT_NULL(morning);
+    TEST_ASSERT_LESS_THAN_UINT32(MS(AT(7, 0, 1)), morning->published_ms); // Awake and connected
+
+    // Armed, each wake-up publishes the pins that woke the node once connected
+    std::vector<Published> wakes;
+    for (const Published &message : published)
+    {
+        if (message.topic == TOPIC_WAKE_EVENT)
+        {
+            wakes.push_back(message);
+        }
+    }
+    TEST_ASSERT_EQUAL_UINT(3, wakes.size());
+    TEST_ASSERT_EQUAL_STRING("14", wakes[0].value.c_str());
+    TEST_ASSERT_UINT32_WITHIN(WAKE_PUBLISH_MS, MS(AT(11, 0, 0)) + WAKE_PUBLISH_MS, wakes[0].time_ms);
+    TEST_ASSERT_EQUAL_STRING("25", wakes[1].value.c_str());
+    TEST_ASSERT_UINT32_WITHIN(WAKE_PUBLISH_MS, MS(AT(14, 0, 0)) + WAKE_PUBLISH_MS, wakes[1].time_ms);
+    TEST_ASSERT_EQUAL_STRING("33", wakes[2].value.c_str());
+    TEST_ASSERT_UINT32_WITHIN(WAKE_PUBLISH_MS, MS(AT(17, 59, 0)) + WAKE_PUBLISH_MS, wakes[2].time_ms);
+}
+
+static void test_sleeps_while_armed_and_quiet()
+{
+    PowerFsm fsm;
+    power_get_fsm(&fsm);
+    TEST_ASSERT_EQUAL_UINT32(3, fsm.wakes);
+    TEST_ASSERT_EQUAL_UINT32(3, fsm.publishes);
+    TEST_ASSERT_EQUAL_INT(POWER_DISARMED, fsm.state);
+    // Armed from 8:00 to 18:00 and quiet apart from the cat and the break-in, the fire checks included
+    TEST_ASSERT_GREATER_THAN_UINT32(MS(AT(9, 0, 0)), (uint32_t)(fsm.residency_ms[POWER_SLEEPING] + fsm.residency_ms[POWER_CHECKING]));
+
+    AlarmStats stats;
+    alarm_get_stats(&stats);
+    TEST_ASSERT_EQUAL_UINT32(0, stats.dropped);
+    TEST_ASSERT_EQUAL_UINT32(0, stats.over_budget);
+}
+
+int main()
+{
+    hal_sim_begin();
+    for (int pin : {REED_KITCHEN, REED_BEDROOM, REED_HALL})
+    {
+        hal_fake_gpio_set_input(pin, HAL_HIGH); // Windows closed
+    }
+    hal_fake_adc_set(FIRE_PIN, FIRE_AMBIENT);
+    hal_fake_adc_set_stream(SMOKE_PIN, smoke_stream, NULL);
+    uplink_fake_set_publish_hook(on_publish, NULL);
+
+    hal_sim_play_waveform(day_edges, sizeof(day_edges) / sizeof(day_edges[0]));
+    for (const Message &message : messages)
+    {
+        hal_sim_at(message.time_us, deliver, (void *)&message);
+    }
+    for (Checkpoint &checkpoint : checkpoints)
+    {
+        hal_sim_at(checkpoint.time_us, sample_alarm, &checkpoint);
+    }
+
+    if (!security_setup())
+    {
+        return 1;
+    }
+    hal_sim_run_until(AT(24, 0, 0));
+
+    UNITY_BEGIN();
+    RUN_TEST(test_alarm_timeline);
+    RUN_TEST(test_journal_timeline);
+    RUN_TEST(test_publish_timeline);
+    RUN_TEST(test_sleeps_while_armed_and_quiet);
+    return UNITY_END();
+}
@@ -0,0 +1,81 @@
+#!/usr/bin/env python3
+"""Writes the flame sensor sample files replayed by test_fire_filter.
+
+Raw 12-bit readings of the flame sensor at 2 kHz, one per line. The
+sensor output drops as infrared reaches it; a flame flickers at 1 - 11 Hz
+while sunlight and lamps give a steady level:
+
+    python make_samples.py
+
+flame.csv        lighter flame, 600 counts deep with a strong flicker
+flame_far.csv    candle across the room, 260 counts with a weak flicker
+sunlight.csv     sun coming out from behind a cloud, 700 counts, steady
+lamp_on.csv      halogen lamp striking (three flashes), then steady
+                 with 100 Hz mains ripple
+
+Each file starts with 2 s of ambient level so the baseline settles.
+"""
+
+import math
+import os
+import random
+
+RATE = 2000
+AMBIENT = 3000
+SECONDS = 8
+ONSET = 2.0
+
+HERE = os.path.dirname(os.path.abspath(__file__))
+
+
+def flicker(t, phases, amplitude):
+    """Flame flicker: a few tones in the 1 - 11 Hz band with a wandering envelope."""
+    tones = (2.3, 4.1, 6.7, 9.2)
+    value = sum(math.sin(2 * math.pi * f * t + p) for f, p in zip(tones, phases)) / 2
+    return amplitude * value * (0.7 + 0.3 * math.sin(2 * math.pi * 0.4 * t))
+
+
+def flame(depth, amplitude, seed):
+    rng = random.Random(seed)
+    phases = [rng.uniform(0, 2 * math.pi) for _ in range(4)]
+
+    def level(t):
+        if t < ONSET:
+            return 0
+        grow = min(1.0, (t - ONSET) / 0.3)  # Lighter catching
+        return -grow * (depth + flicker(t, phases, amplitude))
+    return level
+
+
+def sunlight(t):
+    if t < ONSET:
+        return 0
+    rise = min(1.0, (t - ONSET) / 1.5)
+    return -rise * 700 + 15 * math.sin(2 * math.pi * 0.05 * t)
+
+
+def lamp_on(t):
+    if t < ONSET:
+        return 0
+    on = -900 - 30 * math.sin(2 * math.pi * 100 * t)
+    strike = t - ONSET
+    if strike < 0.45:
+        # Three 75 ms flashes before the filament stays lit
+        return on if (strike % 0.15) < 0.075 else 0
+    return on * (1 + 0.15 * math.exp(-(strike - 0.45) / 0.3))
+
+
+def write(name, level, seed):
+    rng = random.Random(seed)
+    with open(os.path.join(HERE, name), "w") as out:
+        for n in range(RATE * SECONDS):
+            t = n / RATE
+            value = AMBIENT + level(t) + rng.gauss(0, 6)
+            out.write("%d\n" % max(0, min(4095, round(value))))
+
+
+if __name__ == "__main__":
+    write("flame.csv", flame(600, 60, 1), 11)
+    write("flame_far.csv", flame(260, 30, 2), 12)
+    write("sunlight.csv", sunlight, 13)
+    write("lamp_on.csv", lamp_on, 14)
@@ -0,0 +1,237 @@
+/*
+ * Flame sensor filter against recorded sample files (see samples/): a
+ * flickering flame has to raise the confidence, sunlight and a lamp
+ * switching on must not. The files are replayed block by block through
+ * fire_filter_process(), then once more through the analog scheduler and
+ * the fire sensor on the simulated HAL.
+ */
+
+#include <unity.h>
+#include <stdio.h>
+#include <chrono>
+#include <string>
+#include <vector>
+#include "hal/hal.hpp"
+#include "hal/linux/hal_fake.hpp"
+#include "hal/linux/hal_sim.hpp"
+#include "alarm/alarm.hpp"
+#include "analog/analog.hpp"
+#include "buzzer/buzzer.hpp"
+#include "fire_sensor/fire_filter.hpp"
+#include "fire_sensor/fire_sensor.hpp"
+#include "journal/journal.hpp"
+
+#define FIRE_PIN 34 // See fire_sensor.cpp
+
+#define ONSET_BLOCK 20 // Every file starts with 2 s of ambient level
+#define FLAME_RAISE_MS 2000 // Alarm at most this long after the flame is lit
+#define FAR_FLAME_RAISE_MS 3000 // A candle across the room barely clears FIRE_INTENSITY_MIN
+#define BENCH_ROUNDS 50
+#define GAP_US 30000000ULL // Ambient level between replays on the simulated HAL
+
+#define BLOCK_MS (ANALOG_BLOCK_FRAMES * 1000 / ANALOG_SAMPLE_RATE)
+
+struct Replay
+{
+    std::vector<uint8_t> confidence; // Per block
+    int raise_block;                 // First block at FIRE_RAISE_CONFIDENCE, -1 if none
+    uint8_t max_confidence;
+};
+
+struct StreamReplay
+{
+    const std::vector<uint16_t> *samples;
+    uint64_t start_us;
+};
+
+static std::vector<uint16_t> flame, flame_far, sunlight, lamp_on;
+
+static std::vector<uint16_t> load(const char *name)
+{
+    std::string path = __FILE__;
+    path = path.substr(0, path.find_last_of('/') + 1) + "samples/" + name;
+
+    std::vector<uint16_t> samples;
+    FILE *file = fopen(path.c_str(), "r");
+    if (file == NULL)
+    {
+        return samples;
+    }
+    unsigned value;
+    while (fscanf(file, "%u", &value) == 1)
+    {
+        samples.push_back(value);
+    }
+    fclose(file);
+    return samples;
+}
+
+static Replay replay(const std::vector<uint16_t> &samples)
+{
+    FireFilter filter;
+    fire_filter_init(&filter);
+
+    Replay result = {{}, -1, 0};
+    for (size_t offset = 0; offset + ANALOG_BLOCK_FRAMES <= samples.size(); offset += ANALOG_BLOCK_FRAMES)
+    {
+        FireFilterOutput output;
+        fire_filter_process(&filter, &samples[offset], ANALOG_BLOCK_FRAMES, 1, &output);
+        if (result.raise_block < 0 && output.confidence >= FIRE_RAISE_CONFIDENCE)
+        {
+            result.raise_block = result.confidence.size();
+        }
+        if (output.confidence > result.max_confidence)
+        {
+            result.max_confidence = output.confidence;
+        }
+        result.confidence.push_back(output.confidence);
+    }
+    return result;
+}
+
+/* Plays a sample file from start_us on, its first sample before and its last after */
+static uint16_t replay_stream(void *ctx, uint64_t time_us)
+{
+    const StreamReplay *stream = (const StreamReplay *)ctx;
+    if (time_us < stream->start_us)
+    {
+        return stream->samples->front();
+    }
+    uint64_t index = (time_us - stream->start_us) * ANALOG_SAMPLE_RATE / 1000000;
+    return index < stream->samples->size() ? (*stream->samples)[index] : stream->samples->back();
+}
+
+static uint64_t now_ns()
+{
+    return std::chrono::duration_cast<std::chrono::nanoseconds>(
+               std::chrono::steady_clock::now().time_since_epoch())
+        .count();
+}
+
+void setUp()
+{
+}
+
+void tearDown()
+{
+}
+
+static void test_samples_loaded()
+{
+    for (const std::vector<uint16_t> *samples : {&flame, &flame_far, &sunlight, &lamp_on})
+    {
+        TEST_ASSERT_EQUAL_UINT(16000, samples->size());
+    }
+}
+
+static void test_flame_detected()
+{
+    Replay result = replay(flame);
+    TEST_ASSERT_GREATER_OR_EQUAL_INT(ONSET_BLOCK, result.raise_block);
+    TEST_ASSERT_LESS_OR_EQUAL_UINT32(FLAME_RAISE_MS, (uint32_t)(result.raise_block - ONSET_BLOCK) * BLOCK_MS);
+    TEST_ASSERT_GREATER_THAN_UINT(FIRE_CLEAR_CONFIDENCE, result.confidence.back()); // Still burning
+}
+
+static void test_far_flame_detected()
+{
+    Replay result = replay(flame_far);
+    TEST_ASSERT_GREATER_OR_EQUAL_INT(ONSET_BLOCK, result.raise_block);
+    TEST_ASSERT_LESS_OR_EQUAL_UINT32(FAR_FLAME_RAISE_MS, (uint32_t)(result.raise_block - ONSET_BLOCK) * BLOCK_MS);
+    TEST_ASSERT_GREATER_THAN_UINT(FIRE_CLEAR_CONFIDENCE, result.confidence.back());
+}
+
+static void test_sunlight_rejected()
+{
+    Replay result = replay(sunlight);
+    TEST_ASSERT_EQUAL_INT(-1, result.raise_block);
+    TEST_ASSERT_LESS_THAN_UINT(FIRE_RAISE_CONFIDENCE, result.max_confidence);
+    TEST_ASSERT_EQUAL_UINT(0, result.confidence.back());
+}
+
+static void test_lamp_switch_on_rejected()
+{
+    Replay result = replay(lamp_on);
+    TEST_ASSERT_EQUAL_INT(-1, result.raise_block);
+    TEST_ASSERT_LESS_THAN_UINT(FIRE_RAISE_CONFIDENCE, result.max_confidence);
+    TEST_ASSERT_EQUAL_UINT(0, result.confidence.back());
+}
+
+static void test_block_time()
+{
+    FireFilter filter;
+    fire_filter_init(&filter);
+    FireFilterOutput output;
+    uint32_t blocks = 0;
+
+    uint64_t start = now_ns();
+    for (int round = 0; round < BENCH_ROUNDS; round++)
+    {
+        for (const std::vector<uint16_t> *samples : {&flame, &flame_far, &sunlight, &lamp_on})
+        {
+            for (size_t offset = 0; offset + ANALOG_BLOCK_FRAMES <= samples->size(); offset += ANALOG_BLOCK_FRAMES)
+            {
+                fire_filter_process(&filter, &(*samples)[offset], ANALOG_BLOCK_FRAMES, 1, &output);
+                blocks++;
+            }
+        }
+    }
+    uint64_t elapsed_ns = now_ns() - start;
+
+    char message[96];
+    snprintf(message, sizeof(message), "%u blocks of %d samples, %.1f ns per block",
+             (unsigned)blocks, ANALOG_BLOCK_FRAMES, (double)elapsed_ns / blocks);
+    TEST_MESSAGE(message);
+    TEST_ASSERT_LESS_THAN_UINT32(BLOCK_MS * 1000000U / 100, (uint32_t)(elapsed_ns / blocks)); // Under 1% of a block period
+}
+
+/* The files once more through the ADC, the analog scheduler and the fire sensor */
+static void test_sensor_raises_alarm()
+{
+    StreamReplay stream = {&sunlight, GAP_US};
+    hal_fake_adc_set_stream(FIRE_PIN, replay_stream, &stream);
+    TEST_ASSERT_TRUE(init_fire_sensor());
+    TEST_ASSERT_TRUE(init_analog());
+
+    for (const std::vector<uint16_t> *samples : {&sunlight, &lamp_on})
+    {
+        stream.samples = samples;
+        stream.start_us = hal_sim_now_us() + GAP_US;
+        hal_sim_run_for(GAP_US + samples->size() * 1000000ULL / ANALOG_SAMPLE_RATE);
+        handle_alarm();
+        TEST_ASSERT_EQUAL_INT(ALARM_SOURCE_NONE, alarm_active_source());
+    }
+
+    stream.samples = &flame;
+    stream.start_us = hal_sim_now_us() + GAP_US;
+    hal_sim_run_for(GAP_US + flame.size() * 1000000ULL / ANALOG_SAMPLE_RATE);
+    handle_alarm();
+    TEST_ASSERT_EQUAL_INT(ALARM_SOURCE_FIRE, alarm_active_source());
+
+    FireSensorStats stats;
+    fire_sensor_get_stats(&stats);
+    TEST_ASSERT_GREATER_OR_EQUAL_UINT32(hal_sim_now_us() / (BLOCK_MS * 1000) - 1, stats.blocks);
+    TEST_ASSERT_GREATER_OR_EQUAL_UINT(FIRE_RAISE_CONFIDENCE, stats.confidence);
+}
+
+int main()
+{
+    hal_sim_begin();
+    init_journal();
+    init_buzzer();
+    init_alarm();
+
+    flame = load("flame.csv");
+    flame_far = load("flame_far.csv");
+    sunlight = load("sunlight.csv");
+    lamp_on = load("lamp_on.csv");
+
+    UNITY_BEGIN();
+    RUN_TEST(test_samples_loaded);
+    RUN_TEST(test_flame_detected);
+    RUN_TEST(test_far_flame_detected);
+    RUN_TEST(test_sunlight_rejected);
+    RUN_TEST(test_lamp_switch_on_rejected);
+    RUN_TEST(test_block_time);
+    RUN_TEST(test_sensor_raises_alarm);
+    return UNITY_END();
+}
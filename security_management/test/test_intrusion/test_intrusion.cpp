@@ -0,0 +1,197 @@
+/*
+ * Intrusion engine against recorded event traces (see traces/): break-ins
+ * have to raise an incident through the expected rule, near misses and a
+ * week of nuisance events while away must not. The traces are replayed
+ * straight through intrusion_engine_push(), timestamps included.
+ */
+
+#include <unity.h>
+#include <stdio.h>
+#include <string.h>
+#include <chrono>
+#include <string>
+#include <vector>
+#include "intrusion/intrusion_engine.hpp"
+
+/* Bits of IntrusionIncident::rules, in the order of the rule table */
+#define RULE_OPEN_THEN_MOTION (1 << 0)
+#define RULE_REPEATED_MOTION (1 << 1)
+#define RULE_TILT_AND_OPEN (1 << 2)
+
+#define FALSE_ALARMS_PER_WEEK_MAX 2
+#define BENCH_ROUNDS 2000
+
+/* Event names as in the journal */
+static const char *const EVENT_NAMES[INTRUSION_EVENT_TYPE_COUNT] = {"motion", "open", "tilt"};
+
+static uint8_t parse_type(const char *name)
+{
+    uint8_t type = 0;
+    while (type < INTRUSION_EVENT_TYPE_COUNT && strcmp(name, EVENT_NAMES[type]) != 0)
+    {
+        type++;
+    }
+    return type;
+}
+
+static std::vector<IntrusionEvent> load(const char *name)
+{
+    std::string path = __FILE__;
+    path = path.substr(0, path.find_last_of('/') + 1) + "traces/" + name;
+
+    std::vector<IntrusionEvent> events;
+    FILE *file = fopen(path.c_str(), "r");
+    if (file == NULL)
+    {
+        return events;
+    }
+    char line[64];
+    while (fgets(line, sizeof(line), file) != NULL)
+    {
+        unsigned long time_ms;
+        char type[16];
+        unsigned zone;
+        if (line[0] == '#' || sscanf(line, "%lu,%15[a-z],%u", &time_ms, type, &zone) != 3)
+        {
+            continue;
+        }
+        IntrusionEvent event;
+        event.time_ms = time_ms;
+        event.type = parse_type(type);
+        event.zone = zone;
+        events.push_back(event);
+    }
+    fclose(file);
+    return events;
+}
+
+static std::vector<IntrusionIncident> replay(const std::vector<IntrusionEvent> &events)
+{
+    IntrusionEngine engine;
+    intrusion_engine_init(&engine);
+
+    std::vector<IntrusionIncident> incidents;
+    for (const IntrusionEvent &event : events)
+    {
+        IntrusionIncident incident;
+        if (intrusion_engine_push(&engine, event, &incident))
+        {
+            incidents.push_back(incident);
+        }
+    }
+    return incidents;
+}
+
+static uint64_t now_ns()
+{
+    return std::chrono::duration_cast<std::chrono::nanoseconds>(
+               std::chrono::steady_clock::now().time_since_epoch())
+        .count();
+}
+
+void setUp()
+{
+}
+
+void tearDown()
+{
+}
+
+static void test_open_then_motion()
+{
+    std::vector<IntrusionEvent> events = load("break_in_window.csv");
+    TEST_ASSERT_EQUAL_UINT(4, events.size());
+
+    std::vector<IntrusionIncident> incidents = replay(events);
+    TEST_ASSERT_EQUAL_UINT(2, incidents.size());
+    TEST_ASSERT_EQUAL_UINT32(66500, incidents[0].time_ms);
+    TEST_ASSERT_EQUAL_HEX8(RULE_OPEN_THEN_MOTION, incidents[0].rules);
+    TEST_ASSERT_EQUAL_UINT8(80, incidents[0].score);
+
+    // The motion at 71 s is within the hold-off, the one at 95 s repeats it
+    TEST_ASSERT_EQUAL_UINT32(95000, incidents[1].time_ms);
+    TEST_ASSERT_EQUAL_HEX8(RULE_REPEATED_MOTION, incidents[1].rules);
+}
+
+static void test_tilt_and_open()
+{
+    std::vector<IntrusionEvent> events = load("break_in_tilt.csv");
+    TEST_ASSERT_EQUAL_UINT(3, events.size());
+
+    std::vector<IntrusionIncident> incidents = replay(events);
+    TEST_ASSERT_EQUAL_UINT(1, incidents.size());
+    TEST_ASSERT_EQUAL_UINT32(33800, incidents[0].time_ms);
+    TEST_ASSERT_EQUAL_HEX8(RULE_TILT_AND_OPEN, incidents[0].rules);
+    TEST_ASSERT_EQUAL_UINT8(70, incidents[0].score);
+    TEST_ASSERT_EQUAL_INT(INTRUSION_EVENT_OPEN, incidents[0].trigger.type);
+    TEST_ASSERT_EQUAL_INT(1, incidents[0].trigger.zone);
+}
+
+static void test_near_misses()
+{
+    std::vector<IntrusionEvent> events = load("near_misses.csv");
+    TEST_ASSERT_EQUAL_UINT(6, events.size());
+    TEST_ASSERT_EQUAL_UINT(0, replay(events).size());
+}
+
+static void test_false_alarm_rate()
+{
+    std::vector<IntrusionEvent> events = load("away_week.csv");
+    TEST_ASSERT_GREATER_THAN_UINT(200, events.size());
+
+    std::vector<IntrusionIncident> incidents = replay(events);
+    char message[96];
+    snprintf(message, sizeof(message), "%u events in a week away, %u false alarms",
+             (unsigned)events.size(), (unsigned)incidents.size());
+    TEST_MESSAGE(message);
+    for (const IntrusionIncident &incident : incidents)
+    {
+        TEST_ASSERT_EQUAL_HEX8(RULE_REPEATED_MOTION, incident.rules); // Wind alone never scores
+    }
+    TEST_ASSERT_LESS_OR_EQUAL_UINT32(FALSE_ALARMS_PER_WEEK_MAX, incidents.size());
+}
+
+static void test_cost_per_event()
+{
+    std::vector<std::vector<IntrusionEvent>> traces;
+    size_t events = 0;
+    for (const char *name : {"break_in_window.csv", "break_in_tilt.csv", "near_misses.csv", "away_week.csv"})
+    {
+        traces.push_back(load(name));
+        events += traces.back().size();
+    }
+
+    IntrusionEngine engine;
+    IntrusionIncident incident;
+    uint32_t incidents = 0;
+    uint64_t start = now_ns();
+    for (int round = 0; round < BENCH_ROUNDS; round++)
+    {
+        for (const std::vector<IntrusionEvent> &trace : traces)
+        {
+            intrusion_engine_init(&engine); // Every trace starts at time 0
+            for (const IntrusionEvent &event : trace)
+            {
+                incidents += intrusion_engine_push(&engine, event, &incident);
+            }
+        }
+    }
+    uint64_t elapsed_ns = now_ns() - start;
+    TEST_ASSERT_GREATER_THAN_UINT(0, incidents);
+
+    char message[96];
+    snprintf(message, sizeof(message), "%u events, %.1f ns per event",
+             (unsigned)(events * BENCH_ROUNDS), (double)elapsed_ns / (events * BENCH_ROUNDS));
+    TEST_MESSAGE(message);
+}
+
+int main()
+{
+    UNITY_BEGIN();
+    RUN_TEST(test_open_then_motion);
+    RUN_TEST(test_tilt_and_open);
+    RUN_TEST(test_near_misses);
+    RUN_TEST(test_false_alarm_rate);
+    RUN_TEST(test_cost_per_event);
+    return UNITY_END();
+}
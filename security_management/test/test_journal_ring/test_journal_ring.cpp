@@ -0,0 +1,223 @@
+/*
+ * Journal ring layout on the host: the ring lives in a plain struct that
+ * is kept across simulated resets, the way RTC slow memory survives on the
+ * target, and is reopened with journal_ring_open().
+ */
+
+#include <unity.h>
+#include <string.h>
+#include "journal/journal_ring.hpp"
+
+#define HOUR_MS 3600000U
+
+static JournalRing ring;
+static JournalEntry entries[JOURNAL_CAPACITY];
+
+/* Zeroed memory, as after power-on */
+static void power_on()
+{
+    memset(&ring, 0, sizeof(ring));
+    TEST_ASSERT_FALSE(journal_ring_open(&ring));
+    journal_ring_boot(&ring, 1);
+}
+
+/* Reset keeping the retained memory, the working copy is lost */
+static bool reset()
+{
+    memset(&ring.state, 0xA5, sizeof(ring.state));
+    return journal_ring_open(&ring);
+}
+
+static size_t read_all(uint16_t *consumed)
+{
+    return journal_ring_read(&ring, 0, entries, JOURNAL_CAPACITY, consumed);
+}
+
+void setUp()
+{
+    power_on();
+}
+
+void tearDown()
+{
+}
+
+static void test_append_and_read()
+{
+    journal_ring_append(&ring, 1000, JOURNAL_EVENT_ARMED, 0);
+    journal_ring_append(&ring, 2500, JOURNAL_EVENT_OPEN, 2);
+    journal_ring_append(&ring, 2500, JOURNAL_EVENT_ALARM_ON, 4);
+
+    uint16_t consumed;
+    TEST_ASSERT_EQUAL_UINT(4, read_all(&consumed));
+    TEST_ASSERT_EQUAL_UINT(4, consumed);
+    TEST_ASSERT_EQUAL_UINT8(JOURNAL_EVENT_BOOT, entries[0].type);
+    TEST_ASSERT_EQUAL_UINT16(1, entries[0].boot);
+    TEST_ASSERT_EQUAL_UINT32(0, entries[0].time_ms);
+    TEST_ASSERT_EQUAL_UINT8(JOURNAL_EVENT_ARMED, entries[1].type);
+    TEST_ASSERT_EQUAL_UINT32(1000, entries[1].time_ms);
+    TEST_ASSERT_EQUAL_UINT8(JOURNAL_EVENT_OPEN, entries[2].type);
+    TEST_ASSERT_EQUAL_UINT8(2, entries[2].arg);
+    TEST_ASSERT_EQUAL_UINT32(2500, entries[2].time_ms);
+    TEST_ASSERT_EQUAL_UINT32(2500, entries[3].time_ms);
+    TEST_ASSERT_EQUAL_UINT16(4, ring.state.unsent);
+}
+
+static void test_time_skip()
+{
+    // 5 h does not fit the 24-bit millisecond delta (about 4.6 h)
+    uint32_t later_ms = 1000 + 5 * HOUR_MS + 123;
+    journal_ring_append(&ring, 1000, JOURNAL_EVENT_ARMED, 0);
+    journal_ring_append(&ring, later_ms, JOURNAL_EVENT_MOTION_START, 1);
+    journal_ring_append(&ring, later_ms + 10, JOURNAL_EVENT_MOTION_END, 1);
+    TEST_ASSERT_EQUAL_UINT16(5, ring.state.count); // Boot, armed, skip, two motions
+
+    uint16_t consumed;
+    TEST_ASSERT_EQUAL_UINT(4, read_all(&consumed));
+    TEST_ASSERT_EQUAL_UINT(5, consumed);
+    TEST_ASSERT_EQUAL_UINT8(JOURNAL_EVENT_MOTION_START, entries[2].type);
+    TEST_ASSERT_EQUAL_UINT32(later_ms, entries[2].time_ms);
+    TEST_ASSERT_EQUAL_UINT32(later_ms + 10, entries[3].time_ms);
+
+    // Reading from the record after the skip
+    TEST_ASSERT_EQUAL_UINT(2, journal_ring_read(&ring, 3, entries, JOURNAL_CAPACITY, &consumed));
+    TEST_ASSERT_EQUAL_UINT32(later_ms, entries[0].time_ms);
+}
+
+static void test_wrap_around()
+{
+    const uint16_t extra = 100;
+    for (uint32_t i = 0; i < JOURNAL_CAPACITY + extra; i++)
+    {
+        journal_ring_append(&ring, 1000 + i * 250, JOURNAL_EVENT_MOTION_START, i & 0x0F);
+    }
+    TEST_ASSERT_EQUAL_UINT16(JOURNAL_CAPACITY, ring.state.count);
+    TEST_ASSERT_EQUAL_UINT16(JOURNAL_CAPACITY, ring.state.unsent);
+    TEST_ASSERT_EQUAL_UINT16(extra + 1, ring.state.dropped); // The boot record too
+
+    // Boot and the first extra appends are gone
+    uint16_t consumed;
+    TEST_ASSERT_EQUAL_UINT(JOURNAL_CAPACITY, read_all(&consumed));
+    TEST_ASSERT_EQUAL_UINT32(1000 + extra * 250, entries[0].time_ms);
+    TEST_ASSERT_EQUAL_UINT8(extra & 0x0F, entries[0].arg);
+    TEST_ASSERT_EQUAL_UINT16(1, entries[0].boot);
+    TEST_ASSERT_EQUAL_UINT32(1000 + (JOURNAL_CAPACITY + extra - 1) * 250, entries[JOURNAL_CAPACITY - 1].time_ms);
+}
+
+static void test_wrap_over_time_skip()
+{
+    // Boot, skip and armed, then fill the ring so the boot record is the next to go
+    const uint32_t armed_ms = 5 * HOUR_MS + 250;
+    journal_ring_append(&ring, armed_ms, JOURNAL_EVENT_ARMED, 0);
+    uint32_t time_ms = armed_ms;
+    for (int i = 0; i < JOURNAL_CAPACITY - 3; i++)
+    {
+        time_ms += 1000;
+        journal_ring_append(&ring, time_ms, JOURNAL_EVENT_OPEN, 0);
+    }
+    TEST_ASSERT_EQUAL_UINT16(JOURNAL_CAPACITY, ring.state.count);
+
+    // The skip becomes the oldest record, is dropped, then the armed record
+    const uint32_t oldest_ms[] = {armed_ms, armed_ms, armed_ms + 1000};
+    uint16_t consumed;
+    for (uint32_t expected_ms : oldest_ms)
+    {
+        time_ms += 1000;
+        journal_ring_append(&ring, time_ms, JOURNAL_EVENT_CLOSE, 0);
+        size_t count = read_all(&consumed);
+        TEST_ASSERT_EQUAL_UINT(JOURNAL_CAPACITY, consumed);
+        TEST_ASSERT_EQUAL_UINT32(expected_ms, entries[0].time_ms);
+        TEST_ASSERT_EQUAL_UINT32(time_ms, entries[count - 1].time_ms);
+    }
+}
+
+static void test_torn_header()
+{
+    journal_ring_append(&ring, 1000, JOURNAL_EVENT_ARMED, 0);
+    JournalRing before = ring;
+    journal_ring_append(&ring, 2000, JOURNAL_EVENT_OPEN, 0);
+
+    // Reset while the newer copy was half written
+    JournalHeader &written = ring.copies[ring.state.sequence & 1];
+    memcpy(&written, &before.copies[ring.state.sequence & 1], sizeof(written) / 2);
+    TEST_ASSERT_TRUE(reset());
+    TEST_ASSERT_EQUAL_UINT16(2, ring.state.count);
+    TEST_ASSERT_EQUAL_UINT32(before.state.sequence, ring.state.sequence);
+
+    // Appending continues from the recovered copy
+    journal_ring_append(&ring, 3000, JOURNAL_EVENT_CLOSE, 0);
+    uint16_t consumed;
+    TEST_ASSERT_EQUAL_UINT(3, read_all(&consumed));
+    TEST_ASSERT_EQUAL_UINT8(JOURNAL_EVENT_CLOSE, entries[2].type);
+    TEST_ASSERT_EQUAL_UINT32(3000, entries[2].time_ms);
+    TEST_ASSERT_TRUE(reset());
+    TEST_ASSERT_EQUAL_UINT16(3, ring.state.count);
+}
+
+static void test_both_copies_lost()
+{
+    journal_ring_append(&ring, 1000, JOURNAL_EVENT_ARMED, 0);
+    ring.copies[0].crc ^= 1;
+    ring.copies[1].count = JOURNAL_CAPACITY + 1;
+    TEST_ASSERT_FALSE(reset());
+    TEST_ASSERT_EQUAL_UINT16(0, ring.state.count);
+
+    // A record with an invalid type also formats the ring
+    journal_ring_boot(&ring, 1);
+    ring.records[0].type = 15;
+    TEST_ASSERT_FALSE(reset());
+    TEST_ASSERT_EQUAL_UINT16(0, ring.state.count);
+}
+
+static void test_unsent_across_boots()
+{
+    journal_ring_append(&ring, 1000, JOURNAL_EVENT_ARMED, 0);
+    journal_ring_append(&ring, 2000, JOURNAL_EVENT_OPEN, 1);
+    uint16_t consumed;
+    TEST_ASSERT_EQUAL_UINT(2, journal_ring_read(&ring, 0, entries, 2, &consumed));
+    journal_ring_mark_sent(&ring, consumed); // Boot and armed published
+    journal_ring_append(&ring, 3000, JOURNAL_EVENT_CLOSE, 1);
+
+    TEST_ASSERT_TRUE(reset());
+    journal_ring_boot(&ring, 4);
+    journal_ring_append(&ring, 500, JOURNAL_EVENT_ARMED, 0);
+    TEST_ASSERT_EQUAL_UINT16(4, ring.state.unsent);
+
+    // Unsent records of the previous boot come first, with their own time base
+    uint16_t first = ring.state.count - ring.state.unsent;
+    TEST_ASSERT_EQUAL_UINT(4, journal_ring_read(&ring, first, entries, JOURNAL_CAPACITY, &consumed));
+    TEST_ASSERT_EQUAL_UINT(4, consumed);
+    TEST_ASSERT_EQUAL_UINT16(1, entries[0].boot);
+    TEST_ASSERT_EQUAL_UINT32(2000, entries[0].time_ms);
+    TEST_ASSERT_EQUAL_UINT16(1, entries[1].boot);
+    TEST_ASSERT_EQUAL_UINT32(3000, entries[1].time_ms);
+    TEST_ASSERT_EQUAL_UINT8(JOURNAL_EVENT_BOOT, entries[2].type);
+    TEST_ASSERT_EQUAL_UINT8(4, entries[2].arg);
+    TEST_ASSERT_EQUAL_UINT16(2, entries[2].boot);
+    TEST_ASSERT_EQUAL_UINT16(2, entries[3].boot);
+    TEST_ASSERT_EQUAL_UINT32(500, entries[3].time_ms);
+
+    // Published in two batches, the second after another reset
+    journal_ring_mark_sent(&ring, 2);
+    TEST_ASSERT_TRUE(reset());
+    TEST_ASSERT_EQUAL_UINT16(2, ring.state.unsent);
+    first = ring.state.count - ring.state.unsent;
+    TEST_ASSERT_EQUAL_UINT(2, journal_ring_read(&ring, first, entries, JOURNAL_CAPACITY, &consumed));
+    TEST_ASSERT_EQUAL_UINT8(JOURNAL_EVENT_BOOT, entries[0].type);
+    journal_ring_mark_sent(&ring, consumed + 5); // More than unsent is clamped
+    TEST_ASSERT_EQUAL_UINT16(0, ring.state.unsent);
+    TEST_ASSERT_EQUAL_UINT16(0, ring.state.dropped);
+}
+
+int main()
+{
+    UNITY_BEGIN();
+    RUN_TEST(test_append_and_read);
+    RUN_TEST(test_time_skip);
+    RUN_TEST(test_wrap_around);
+    RUN_TEST(test_wrap_over_time_skip);
+    RUN_TEST(test_torn_header);
+    RUN_TEST(test_both_copies_lost);
+    RUN_TEST(test_unsent_across_boots);
+    return UNITY_END();
+}
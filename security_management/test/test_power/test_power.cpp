@@ -0,0 +1,252 @@
+/*
+ * Sleep and wake of the armed node in virtual time: armed over MQTT, it
+ * has to fall asleep once quiet, wake on a PIR and on a reed relay,
+ * publish the waking pin on TOPIC_WAKE_EVENT once reconnected and go back
+ * to sleep. Smoke rising while it sleeps must still raise the fire alarm
+ * and keep it awake.
+ */
+
+#include <unity.h>
+#include <stdio.h>
+#include <string>
+#include <vector>
+#include "hal/hal.hpp"
+#include "hal/linux/hal_fake.hpp"
+#include "hal/linux/hal_sim.hpp"
+#include "alarm/alarm.hpp"
+#include "power/power.hpp"
+#include "scheduling/scheduling.hpp"
+#include "uplink/uplink.hpp"
+
+#define SECONDS(s) ((uint64_t)(s) * 1000000ULL)
+#define MS(time_us) ((uint32_t)((time_us) / 1000))
+
+/* Inputs, see pir.cpp and reed_relay.cpp */
+#define PIR_LIVING 13
+#define REED_KITCHEN 26
+#define FIRE_PIN 34
+#define SMOKE_PIN 35
+
+#define ARM_AT SECONDS(10)
+#define PIR_WAKE_AT SECONDS(100)
+#define REED_WAKE_AT SECONDS(200)
+#define SMOKE_RISE_AT SECONDS(250)
+#define END_AT SECONDS(330)
+
+/* MQ-2 readings, clean air then a smouldering fire in the empty house */
+#define SMOKE_CLEAN 900
+#define SMOKE_PEAK 1700
+#define SMOKE_RAMP SECONDS(30)
+#define FIRE_DETECT_MS 40000 // Fire checks run every POWER_FIRE_CHECK_MS while asleep
+
+#define SLEEP_SLACK_MS 3000 // Power task poll plus the chime of an opened window
+#define WAKE_SLACK_MS 100   // Light sleep polls the wake pins every 10 ms, then POWER_PUBLISH_POLL_MS
+
+/* Latest time the node is asleep again after activity at time_us */
+#define ASLEEP_AFTER(time_us) ((time_us) + (POWER_QUIET_MS + SLEEP_SLACK_MS) * 1000ULL)
+
+static const HalSimEdge edges[] = {
+    {PIR_WAKE_AT, PIR_LIVING, HAL_HIGH},
+    {PIR_WAKE_AT + SECONDS(2), PIR_LIVING, HAL_LOW},
+    {REED_WAKE_AT, REED_KITCHEN, HAL_LOW},
+    {REED_WAKE_AT + SECONDS(5), REED_KITCHEN, HAL_HIGH},
+};
+
+/// State of the node sampled at a time.
+struct Sample
+{
+    uint64_t time_us;
+    PowerState state;
+    bool connected;
+    AlarmSource alarm;
+};
+
+static Sample samples[] = {
+    {ARM_AT + SECONDS(5), POWER_ARMED_ACTIVE, true, ALARM_SOURCE_NONE},
+    {ASLEEP_AFTER(ARM_AT), POWER_SLEEPING, false, ALARM_SOURCE_NONE},
+    {PIR_WAKE_AT + SECONDS(1), POWER_WAKE_PUBLISH, false, ALARM_SOURCE_NONE}, // Reconnecting
+    {PIR_WAKE_AT + SECONDS(10), POWER_ARMED_ACTIVE, true, ALARM_SOURCE_NONE},
+    {ASLEEP_AFTER(PIR_WAKE_AT), POWER_SLEEPING, false, ALARM_SOURCE_NONE},
+    {REED_WAKE_AT + SECONDS(1), POWER_WAKE_PUBLISH, false, ALARM_SOURCE_NONE},
+    {REED_WAKE_AT + SECONDS(10), POWER_ARMED_ACTIVE, true, ALARM_SOURCE_NONE},
+    {ASLEEP_AFTER(REED_WAKE_AT), POWER_SLEEPING, false, ALARM_SOURCE_NONE},
+    {SMOKE_RISE_AT + SMOKE_RAMP + FIRE_DETECT_MS * 1000ULL, POWER_ARMED_ACTIVE, true, ALARM_SOURCE_FIRE},
+};
+#define SAMPLES (sizeof(samples) / sizeof(samples[0]))
+
+static Sample seen[SAMPLES];
+
+struct Published
+{
+    uint32_t time_ms;
+    std::string topic;
+    std::string value;
+};
+
+static std::vector<Published> published;
+static uint32_t fire_alarm_ms = 0;
+
+static uint16_t smoke_stream(void *, uint64_t time_us)
+{
+    if (time_us < SMOKE_RISE_AT)
+    {
+        return SMOKE_CLEAN;
+    }
+    if (time_us < SMOKE_RISE_AT + SMOKE_RAMP)
+    {
+        return SMOKE_CLEAN + (SMOKE_PEAK - SMOKE_CLEAN) * (time_us - SMOKE_RISE_AT) / SMOKE_RAMP;
+    }
+    return SMOKE_PEAK;
+}
+
+static void on_publish(const char *topic, const char *value, void *)
+{
+    published.push_back({MS(hal_sim_now_us()), topic, value});
+}
+
+static void arm(void *)
+{
+    uplink_fake_deliver(TOPIC_ARM, "{\"value\": \"1\"}");
+}
+
+static void sample_state(void *ctx)
+{
+    Sample *sample = (Sample *)ctx;
+    PowerFsm fsm;
+    power_get_fsm(&fsm);
+    seen[sample - samples] = {sample->time_us, fsm.state, uplink_is_connected(), alarm_active_source()};
+}
+
+static void watch_alarm(void *)
+{
+    if (fire_alarm_ms == 0 && alarm_active_source() == ALARM_SOURCE_FIRE)
+    {
+        fire_alarm_ms = MS(hal_sim_now_us());
+    }
+    hal_sim_at(hal_sim_now_us() + SECONDS(1), watch_alarm, NULL);
+}
+
+static std::vector<Published> wake_events()
+{
+    std::vector<Published> wakes;
+    for (const Published &message : published)
+    {
+        if (message.topic == TOPIC_WAKE_EVENT)
+        {
+            wakes.push_back(message);
+        }
+    }
+    return wakes;
+}
+
+void setUp()
+{
+}
+
+void tearDown()
+{
+}
+
+static void test_state_timeline()
+{
+    for (size_t i = 0; i < SAMPLES; i++)
+    {
+        char message[48];
+        snprintf(message, sizeof(message), "state at %lu s", (unsigned long)(samples[i].time_us / 1000000));
+        TEST_ASSERT_EQUAL_INT_MESSAGE(samples[i].state, seen[i].state, message);
+        snprintf(message, sizeof(message), "connected at %lu s", (unsigned long)(samples[i].time_us / 1000000));
+        TEST_ASSERT_EQUAL_INT_MESSAGE(samples[i].connected, seen[i].connected, message);
+        snprintf(message, sizeof(message), "alarm at %lu s", (unsigned long)(samples[i].time_us / 1000000));
+        TEST_ASSERT_EQUAL_INT_MESSAGE(samples[i].alarm, seen[i].alarm, message);
+    }
+}
+
+static void test_wake_on_pir()
+{
+    std::vector<Published> wakes = wake_events();
+    TEST_ASSERT_EQUAL_UINT(2, wakes.size());
+    TEST_ASSERT_EQUAL_STRING("13", wakes[0].value.c_str());
+
+    uint32_t latency_ms = wakes[0].time_ms - MS(PIR_WAKE_AT);
+    TEST_ASSERT_GREATER_OR_EQUAL_UINT32(UPLINK_FAKE_CONNECT_MS, latency_ms);
+    TEST_ASSERT_LESS_OR_EQUAL_UINT32(UPLINK_FAKE_CONNECT_MS + WAKE_SLACK_MS, latency_ms);
+}
+
+static void test_wake_on_reed()
+{
+    std::vector<Published> wakes = wake_events();
+    TEST_ASSERT_EQUAL_UINT(2, wakes.size());
+    TEST_ASSERT_EQUAL_STRING("26", wakes[1].value.c_str());
+
+    uint32_t latency_ms = wakes[1].time_ms - MS(REED_WAKE_AT);
+    TEST_ASSERT_GREATER_OR_EQUAL_UINT32(UPLINK_FAKE_CONNECT_MS, latency_ms);
+    TEST_ASSERT_LESS_OR_EQUAL_UINT32(UPLINK_FAKE_CONNECT_MS + WAKE_SLACK_MS, latency_ms);
+}
+
+static void test_fire_while_asleep()
+{
+    PowerFsm fsm;
+    power_get_fsm(&fsm);
+    TEST_ASSERT_GREATER_THAN_UINT32(0, fsm.checks);
+
+    // Only the fire checks sample the MQ-2, the rest of the sleep it is off
+    TEST_ASSERT_GREATER_THAN_UINT32(MS(SMOKE_RISE_AT), fire_alarm_ms);
+    TEST_ASSERT_LESS_OR_EQUAL_UINT32(MS(SMOKE_RISE_AT + SMOKE_RAMP) + FIRE_DETECT_MS, fire_alarm_ms);
+
+    char message[96];
+    snprintf(message, sizeof(message), "fire alarm %lu ms after the smoke started, %lu fire checks",
+             (unsigned long)(fire_alarm_ms - MS(SMOKE_RISE_AT)), (unsigned long)fsm.checks);
+    TEST_MESSAGE(message);
+}
+
+static void test_fsm_accounting()
+{
+    PowerFsm fsm;
+    power_get_fsm(&fsm);
+    TEST_ASSERT_EQUAL_UINT32(2, fsm.wakes);
+    TEST_ASSERT_EQUAL_UINT32(2, fsm.publishes);
+    TEST_ASSERT_GREATER_OR_EQUAL_UINT32(UPLINK_FAKE_CONNECT_MS, fsm.max_latency_ms);
+    TEST_ASSERT_LESS_OR_EQUAL_UINT32(UPLINK_FAKE_CONNECT_MS + WAKE_SLACK_MS, fsm.max_latency_ms);
+
+    char message[96];
+    snprintf(message, sizeof(message), "wake to publish %lu ms (reconnect %d ms), average current %lu uA",
+             (unsigned long)fsm.max_latency_ms, UPLINK_FAKE_CONNECT_MS,
+             (unsigned long)power_fsm_average_current_ua(&fsm, MS(END_AT)));
+    TEST_MESSAGE(message);
+
+    // Asleep from the quiet timeout to each wake-up, less a fire check window every POWER_FIRE_CHECK_MS
+    uint32_t asleep_ms = MS(PIR_WAKE_AT - ASLEEP_AFTER(ARM_AT)) + MS(REED_WAKE_AT - ASLEEP_AFTER(PIR_WAKE_AT));
+    TEST_ASSERT_GREATER_OR_EQUAL_UINT32(asleep_ms * 10 / 11, (uint32_t)fsm.residency_ms[POWER_SLEEPING]);
+    TEST_ASSERT_UINT32_WITHIN(SLEEP_SLACK_MS, (uint32_t)fsm.residency_ms[POWER_SLEEPING], MS(hal_fake_slept_us()));
+}
+
+int main()
+{
+    hal_sim_begin();
+    hal_fake_gpio_set_input(REED_KITCHEN, HAL_HIGH); // Window closed
+    hal_fake_adc_set(FIRE_PIN, 300);
+    hal_fake_adc_set_stream(SMOKE_PIN, smoke_stream, NULL);
+    uplink_fake_set_publish_hook(on_publish, NULL);
+
+    hal_sim_play_waveform(edges, sizeof(edges) / sizeof(edges[0]));
+    hal_sim_at(ARM_AT, arm, NULL);
+    hal_sim_at(ARM_AT, watch_alarm, NULL);
+    for (Sample &sample : samples)
+    {
+        hal_sim_at(sample.time_us, sample_state, &sample);
+    }
+
+    if (!security_setup())
+    {
+        return 1;
+    }
+    hal_sim_run_until(END_AT);
+
+    UNITY_BEGIN();
+    RUN_TEST(test_state_timeline);
+    RUN_TEST(test_wake_on_pir);
+    RUN_TEST(test_wake_on_reed);
+    RUN_TEST(test_fire_while_asleep);
+    RUN_TEST(test_fsm_accounting);
+    return UNITY_END();
+}
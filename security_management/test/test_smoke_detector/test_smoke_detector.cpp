@@ -0,0 +1,170 @@
+/*
+ * Smoke detector on the simulated HAL: the MQ-2 level is scripted as a
+ * chain of ramps fed through the analog scheduler, one timeline for the
+ * whole suite (warm-up, drift, a slow smoulder, a quick rise).
+ */
+
+#include <unity.h>
+#include "hal/hal.hpp"
+#include "hal/linux/hal_fake.hpp"
+#include "hal/linux/hal_sim.hpp"
+#include "alarm/alarm.hpp"
+#include "analog/analog.hpp"
+#include "buzzer/buzzer.hpp"
+#include "journal/journal.hpp"
+#include "smoke_detector/smoke_detector.hpp"
+
+#define SMOKE_PIN 35 // See smoke_detector.cpp
+
+#define SECONDS(s) ((uint64_t)(s) * 1000000ULL)
+#define MINUTES(m) SECONDS((m) * 60)
+
+#define HEATER_COLD 1400 // First readings of a cold heater
+#define CLEAN_AIR 900
+#define NOISE 4 // Peak noise in ADC counts
+
+/* Level ramping from `from` to `to` at `per_minute`, starting at start_us */
+struct Ramp
+{
+    uint64_t start_us;
+    int32_t from;
+    int32_t to;
+    int32_t per_minute;
+};
+
+static Ramp ramp = {0, HEATER_COLD, HEATER_COLD, 0};
+
+static int32_t ramp_level(uint64_t time_us)
+{
+    int32_t moved = (int32_t)((time_us - ramp.start_us) * ramp.per_minute / MINUTES(1));
+    if (ramp.to >= ramp.from)
+    {
+        return ramp.from + moved < ramp.to ? ramp.from + moved : ramp.to;
+    }
+    return ramp.from - moved > ramp.to ? ramp.from - moved : ramp.to;
+}
+
+static uint16_t smoke_stream(void *, uint64_t time_us)
+{
+    uint32_t hash = (uint32_t)(time_us / 500) * 2654435761u; // Reproducible noise
+    return ramp_level(time_us) + (int32_t)(hash >> 29) - NOISE;
+}
+
+/* Starts a ramp from the current level */
+static void ramp_to(int32_t to, int32_t per_minute)
+{
+    uint64_t now_us = hal_sim_now_us();
+    ramp = {now_us, ramp_level(now_us), to, per_minute};
+}
+
+static SmokeStatus status()
+{
+    SmokeStatus current;
+    smoke_detector_get_status(&current);
+    return current;
+}
+
+/* Runs until the alarm reaches `alarm` or the timeout, returns the time taken */
+static uint64_t run_until_alarm(bool alarm, uint64_t timeout_us)
+{
+    uint64_t start_us = hal_sim_now_us();
+    while (status().alarm != alarm && hal_sim_now_us() - start_us < timeout_us)
+    {
+        hal_sim_run_for(SECONDS(1));
+    }
+    return hal_sim_now_us() - start_us;
+}
+
+void setUp()
+{
+}
+
+void tearDown()
+{
+}
+
+static void test_warm_up()
+{
+    // The heater settles from well above the alarm level within 30 s
+    ramp_to(CLEAN_AIR, 1000);
+    hal_sim_run_for(SECONDS(50));
+    TEST_ASSERT_FALSE(status().warmed_up);
+    TEST_ASSERT_FALSE(status().alarm);
+
+    hal_sim_run_for(SECONDS(15));
+    SmokeStatus current = status();
+    TEST_ASSERT_TRUE(current.warmed_up);
+    TEST_ASSERT_FALSE(current.alarm);
+    TEST_ASSERT_INT_WITHIN(20, CLEAN_AIR, current.baseline);
+}
+
+static void test_drift_followed()
+{
+    // Humidity moving the level by 80 counts over an hour
+    ramp_to(CLEAN_AIR + 80, 2);
+    hal_sim_run_for(MINUTES(60));
+    SmokeStatus current = status();
+    TEST_ASSERT_FALSE(current.alarm);
+    TEST_ASSERT_INT_WITHIN(20, CLEAN_AIR + 80, current.baseline);
+
+    ramp_to(CLEAN_AIR, 20);
+    hal_sim_run_for(MINUTES(10));
+    TEST_ASSERT_INT_WITHIN(20, CLEAN_AIR, status().baseline);
+}
+
+static void test_slow_smoulder_alarms()
+{
+    // Slower than the upward drift compensation follows
+    ramp_to(CLEAN_AIR + 1000, 15);
+    uint64_t elapsed_us = run_until_alarm(true, MINUTES(60));
+    TEST_ASSERT_TRUE(status().alarm);
+    TEST_ASSERT_LESS_OR_EQUAL_UINT32(45, (uint32_t)(elapsed_us / MINUTES(1)));
+
+    ramp_to(CLEAN_AIR, 200);
+    run_until_alarm(false, MINUTES(10));
+    TEST_ASSERT_FALSE(status().alarm);
+    hal_sim_run_for(MINUTES(5));
+    TEST_ASSERT_INT_WITHIN(20, CLEAN_AIR, status().baseline);
+}
+
+static void test_rate_of_rise()
+{
+    // 250 counts in 10 s: below the absolute threshold, caught by the rate of rise
+    ramp_to(CLEAN_AIR + 250, 1500);
+    uint64_t elapsed_us = run_until_alarm(true, MINUTES(1));
+    TEST_ASSERT_TRUE(status().alarm);
+    TEST_ASSERT_LESS_OR_EQUAL_UINT32(20, (uint32_t)(elapsed_us / SECONDS(1)));
+
+    ramp_to(CLEAN_AIR, 1500);
+    run_until_alarm(false, MINUTES(1));
+    TEST_ASSERT_FALSE(status().alarm);
+}
+
+static void test_slow_rise_below_threshold_ignored()
+{
+    // The same 250 counts over ten minutes is drift, not smoke
+    hal_sim_run_for(MINUTES(5));
+    ramp_to(CLEAN_AIR + 250, 25);
+    hal_sim_run_for(MINUTES(15));
+    TEST_ASSERT_FALSE(status().alarm);
+}
+
+int main()
+{
+    hal_sim_begin();
+    init_journal();
+    init_buzzer();
+    init_alarm();
+
+    hal_fake_adc_set_stream(SMOKE_PIN, smoke_stream, NULL);
+    init_smoke_detector();
+    init_analog();
+
+    UNITY_BEGIN();
+    RUN_TEST(test_warm_up);
+    RUN_TEST(test_drift_followed);
+    RUN_TEST(test_slow_smoulder_alarms);
+    RUN_TEST(test_rate_of_rise);
+    RUN_TEST(test_slow_rise_below_threshold_ignored);
+    return UNITY_END();
+}
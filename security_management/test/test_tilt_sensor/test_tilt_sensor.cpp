@@ -0,0 +1,286 @@
+/*
+ * Tilt sensor against edge traces played into the pulse counter on the
+ * simulated HAL: glitches, millisecond contact bounce, a steady tilt and
+ * shaking, checked on the tamper alarm and on the published journal. The
+ * test calls the tilt handler itself once per debounce slot and the
+ * others once per counting window.
+ */
+
+#include <unity.h>
+#include <stdio.h>
+#include <string>
+#include <vector>
+#include "hal/hal.hpp"
+#include "hal/linux/hal_fake.hpp"
+#include "hal/linux/hal_sim.hpp"
+#include "alarm/alarm.hpp"
+#include "buzzer/buzzer.hpp"
+#include "intrusion/intrusion.hpp"
+#include "journal/journal.hpp"
+#include "scheduling/scheduling.hpp"
+#include "tilt_sensor/tilt_sensor.hpp"
+#include "uplink/uplink.hpp"
+
+#define TILT_PIN 5 // See tilt_sensor.cpp
+
+/* Thresholds of tilt_sensor.cpp, in debounced edges */
+#define BURST_EDGES 4
+#define RATE_EDGES 8
+#define SHAKE_HOLDOFF_WINDOWS 20
+
+#define SLOT_US (TILT_SENSOR_READ_FREQ * 1000U)
+#define WINDOW_SLOTS 10
+#define WINDOW_US (SLOT_US * WINDOW_SLOTS)
+
+/* Glitches of 2 to 5 us, shorter than the 10 us counter filter */
+static const uint32_t glitch_trace[] = {
+    1000, 1002, 30000, 30004, 30010, 30015, 61000, 61003, 90000, 90005, 250000, 250003,
+};
+
+/*
+ * Knocks on the housing: three bursts of contact bounce, 3.5 to 5.5 ms
+ * long, the second across a slot boundary. Eighteen edges in one window,
+ * each burst back to the resting level.
+ */
+static const uint32_t knock_trace[] = {
+    1000, 1700, 2300, 3000, 3600, 4200,
+    28000, 28800, 29500, 30100, 31000, 33500,
+    60000, 60600, 61400, 62000, 62900, 65500,
+};
+
+/* Settling into the tilted position: five edges over 4.6 ms, ends high */
+static const uint32_t tilt_on_trace[] = {1000, 2500, 3200, 5000, 5600};
+static const uint32_t tilt_off_trace[] = {1000};
+
+/* Ball swinging between the contacts, one level held 20 ms: three swings in one window and the fourth in the next */
+static const uint32_t below_burst_swings[] = {1000, 21000, 41000, WINDOW_US + 1000};
+static const uint32_t burst_swings[] = {1000, 21000, 41000, 61000};
+#define SWINGS(swings) (sizeof(swings) / sizeof(swings[0]))
+
+#define SWING_BOUNCES 3 // Edges per swing, the contact bounces once
+
+struct JournalLine
+{
+    std::string event;
+    unsigned arg;
+};
+
+static std::vector<JournalLine> journal;
+
+static void on_publish(const char *topic, const char *value, void *)
+{
+    if (std::string(topic) != TOPIC_JOURNAL)
+    {
+        return;
+    }
+    unsigned boot, arg;
+    unsigned long time_ms;
+    char event[16];
+    int length;
+    while (sscanf(value, "%u,%lu,%15[^,],%u;%n", &boot, &time_ms, event, &arg, &length) == 4)
+    {
+        journal.push_back({event, arg});
+        value += length;
+    }
+}
+
+/* Counting windows as the tilt task runs them, slot by slot */
+static void run_windows(int windows)
+{
+    for (int i = 0; i < windows; i++)
+    {
+        for (int slot = 0; slot < WINDOW_SLOTS; slot++)
+        {
+            hal_sim_run_for(SLOT_US);
+            handle_tilt_sensor();
+        }
+        handle_alarm();
+        handle_journal();
+    }
+}
+
+/* Plays a trace at the start of the next window */
+static void play(const uint32_t *trace, size_t count, int windows)
+{
+    hal_fake_pcnt_play_trace(TILT_PIN, trace, count);
+    run_windows(windows);
+}
+
+/* Plays swings of the ball, each with its contact bounce */
+static void play_swings(const uint32_t *swings, size_t count, int windows)
+{
+    static uint32_t trace[SWING_BOUNCES * 2 * RATE_EDGES];
+    for (size_t i = 0; i < count; i++)
+    {
+        trace[SWING_BOUNCES * i] = swings[i];
+        trace[SWING_BOUNCES * i + 1] = swings[i] + 600;
+        trace[SWING_BOUNCES * i + 2] = swings[i] + 1300;
+    }
+    play(trace, SWING_BOUNCES * count, windows);
+}
+
+/* A 30 ms tilt in each of the next windows */
+static void play_pulses(int windows)
+{
+    static uint32_t swings[2 * RATE_EDGES];
+    size_t count = 0;
+    for (int window = 0; window < windows; window++)
+    {
+        swings[count++] = window * WINDOW_US + 1000;
+        swings[count++] = window * WINDOW_US + 31000;
+    }
+    play_swings(swings, count, windows + 1);
+}
+
+static uint32_t shakes()
+{
+    uint32_t edges, shakes;
+    tilt_sensor_get_stats(&edges, &shakes);
+    return shakes;
+}
+
+static uint32_t edges()
+{
+    uint32_t edges, shakes;
+    tilt_sensor_get_stats(&edges, &shakes);
+    return edges;
+}
+
+static size_t count_entries(const char *event, unsigned arg)
+{
+    size_t count = 0;
+    for (const JournalLine &line : journal)
+    {
+        count += line.event == event && line.arg == arg;
+    }
+    return count;
+}
+
+static void acknowledge()
+{
+    alarm_acknowledge();
+    handle_alarm();
+    TEST_ASSERT_EQUAL_INT(ALARM_SOURCE_NONE, alarm_active_source());
+}
+
+void setUp()
+{
+    journal.clear();
+    run_windows(SHAKE_HOLDOFF_WINDOWS + 10); // Rate window empty, shaking over
+}
+
+void tearDown()
+{
+}
+
+static void test_glitches_rejected()
+{
+    uint32_t before = edges();
+    play(glitch_trace, sizeof(glitch_trace) / sizeof(glitch_trace[0]), 5);
+    TEST_ASSERT_EQUAL_UINT32(before, edges());
+    TEST_ASSERT_EQUAL_INT(HAL_LOW, hal_gpio_read(TILT_PIN));
+    TEST_ASSERT_EQUAL_INT(ALARM_SOURCE_NONE, alarm_active_source());
+    TEST_ASSERT_EQUAL_UINT(0, count_entries("tilt_on", 0) + count_entries("tilt_on", 1));
+}
+
+static void test_bounce_rejected()
+{
+    // Too long for the counter filter, every edge is counted, but the level never holds
+    uint32_t before = edges();
+    uint32_t shakes_before = shakes();
+    play(knock_trace, sizeof(knock_trace) / sizeof(knock_trace[0]), 5);
+    TEST_ASSERT_EQUAL_UINT32(before + sizeof(knock_trace) / sizeof(knock_trace[0]), edges());
+    TEST_ASSERT_EQUAL_UINT32(shakes_before, shakes());
+    TEST_ASSERT_EQUAL_INT(ALARM_SOURCE_NONE, alarm_active_source());
+    TEST_ASSERT_EQUAL_UINT(0, count_entries("tilt_on", 0) + count_entries("tilt_on", 1));
+}
+
+static void test_steady_tilt()
+{
+    uint32_t before = edges();
+    play(tilt_on_trace, sizeof(tilt_on_trace) / sizeof(tilt_on_trace[0]), 1);
+    TEST_ASSERT_EQUAL_UINT32(before + 5, edges());
+    TEST_ASSERT_EQUAL_INT(ALARM_SOURCE_NONE, alarm_active_source()); // Edges in the window, not stable yet
+
+    run_windows(1);
+    TEST_ASSERT_EQUAL_INT(ALARM_SOURCE_TAMPER, alarm_active_source());
+    TEST_ASSERT_EQUAL_UINT(1, count_entries("tilt_on", 0));
+
+    // Held for a minute: one entry, no shaking
+    run_windows(600);
+    TEST_ASSERT_EQUAL_UINT(1, count_entries("tilt_on", 0));
+    TEST_ASSERT_EQUAL_UINT32(0, shakes());
+
+    play(tilt_off_trace, 1, 2);
+    TEST_ASSERT_EQUAL_UINT(1, count_entries("tilt_off", 0));
+    TEST_ASSERT_EQUAL_INT(ALARM_SOURCE_TAMPER, alarm_active_source()); // Latched
+    acknowledge();
+}
+
+static void test_burst_threshold()
+{
+    play_swings(below_burst_swings, SWINGS(below_burst_swings), 3);
+    TEST_ASSERT_EQUAL_UINT32(0, shakes());
+    TEST_ASSERT_EQUAL_INT(ALARM_SOURCE_NONE, alarm_active_source());
+
+    run_windows(SHAKE_HOLDOFF_WINDOWS);
+    play_swings(burst_swings, BURST_EDGES, 2);
+    TEST_ASSERT_EQUAL_UINT32(1, shakes());
+    TEST_ASSERT_EQUAL_INT(ALARM_SOURCE_TAMPER, alarm_active_source());
+    TEST_ASSERT_EQUAL_UINT(1, count_entries("tilt_on", 1));
+    TEST_ASSERT_EQUAL_UINT(0, count_entries("tilt_on", 0)); // Never a stable tilt
+    acknowledge();
+}
+
+static void test_shake_episode()
+{
+    // Bursts less than the hold-off apart are one episode
+    uint32_t before = shakes();
+    for (int i = 0; i < 5; i++)
+    {
+        play_swings(burst_swings, SWINGS(burst_swings), SHAKE_HOLDOFF_WINDOWS / 2);
+    }
+    TEST_ASSERT_EQUAL_UINT32(before + 1, shakes());
+
+    run_windows(SHAKE_HOLDOFF_WINDOWS + 1);
+    play_swings(burst_swings, SWINGS(burst_swings), 2);
+    TEST_ASSERT_EQUAL_UINT32(before + 2, shakes());
+    TEST_ASSERT_EQUAL_UINT(2, count_entries("tilt_on", 1));
+    acknowledge();
+}
+
+static void test_rate_threshold()
+{
+    // Two edges a window never reach the burst threshold, three windows stay below the rate
+    uint32_t before = shakes();
+    play_pulses(RATE_EDGES / 2 - 1);
+    TEST_ASSERT_EQUAL_UINT32(before, shakes());
+    TEST_ASSERT_EQUAL_INT(ALARM_SOURCE_NONE, alarm_active_source());
+
+    run_windows(SHAKE_HOLDOFF_WINDOWS);
+    play_pulses(RATE_EDGES / 2);
+    TEST_ASSERT_EQUAL_UINT32(before + 1, shakes());
+    TEST_ASSERT_EQUAL_INT(ALARM_SOURCE_TAMPER, alarm_active_source());
+    acknowledge();
+}
+
+int main()
+{
+    hal_sim_begin();
+    uplink_fake_set_publish_hook(on_publish, NULL);
+    init_uplink();
+    init_journal();
+    init_buzzer();
+    init_alarm();
+    init_intrusion();
+    init_tilt_sensor();
+
+    UNITY_BEGIN();
+    RUN_TEST(test_glitches_rejected);
+    RUN_TEST(test_bounce_rejected);
+    RUN_TEST(test_steady_tilt);
+    RUN_TEST(test_burst_threshold);
+    RUN_TEST(test_shake_episode);
+    RUN_TEST(test_rate_threshold);
+    return UNITY_END();
+}